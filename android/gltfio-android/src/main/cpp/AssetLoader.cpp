@@ -247,6 +247,29 @@ Java_com_google_android_filament_gltfio_AssetLoader_nCreateInstance(JNIEnv* env,
     return (jlong) loader->createInstance(primary);
 }
 
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_google_android_filament_gltfio_AssetLoader_nAsyncBeginCreate(JNIEnv* env, jclass,
+        jlong nativeLoader, jobject javaBuffer, jint remaining) {
+    AssetLoader* loader = (AssetLoader*) nativeLoader;
+    AutoBuffer buffer(env, javaBuffer, remaining);
+    return (jlong) loader->asyncBeginCreate((const uint8_t *) buffer.getData(),
+            buffer.getSize());
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_google_android_filament_gltfio_AssetLoader_nAsyncUpdateCreate(JNIEnv*, jclass,
+        jlong nativeLoader, jfloat budgetMs) {
+    AssetLoader* loader = (AssetLoader*) nativeLoader;
+    return (jboolean) loader->asyncUpdateCreate(budgetMs);
+}
+
+extern "C" JNIEXPORT jfloat JNICALL
+Java_com_google_android_filament_gltfio_AssetLoader_nAsyncGetCreateProgress(JNIEnv*, jclass,
+        jlong nativeLoader) {
+    AssetLoader* loader = (AssetLoader*) nativeLoader;
+    return loader->asyncGetCreateProgress();
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_google_android_filament_gltfio_AssetLoader_nEnableDiagnostics(JNIEnv*, jclass,
         jlong nativeLoader, jboolean enable) {
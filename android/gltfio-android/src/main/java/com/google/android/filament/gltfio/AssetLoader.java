@@ -181,6 +181,42 @@ public class AssetLoader {
         return new FilamentInstance(asset, nativeInstance);
     }
 
+    /**
+     * Starts an incremental creation of an asset from the contents of a glTF file (JSON or GLB).
+     *
+     * Only the root entity is created here, the other entities are created by periodic calls to
+     * {@link #asyncUpdateCreate}. The root entity can be used immediately, but
+     * {@link ResourceLoader} must not be used until {@link #asyncGetCreateProgress} returns 1, and
+     * {@link FilamentAsset#releaseSourceData} does nothing until then.
+     * Only one asset can be created at a time. Destroying the asset cancels its creation.
+     */
+    @Nullable
+    @SuppressWarnings("unused")
+    public FilamentAsset asyncBeginCreate(@NonNull Buffer buffer) {
+        long nativeAsset = nAsyncBeginCreate(mNativeObject, buffer, buffer.remaining());
+        return nativeAsset != 0 ? new FilamentAsset(mEngine, nativeAsset) : null;
+    }
+
+    /**
+     * Creates more entities of the asset started with {@link #asyncBeginCreate}, until the given
+     * time budget is spent or the asset is complete.
+     *
+     * @param budgetMs time budget of this call, in milliseconds
+     * @return false if the creation failed, in which case the asset should be destroyed
+     */
+    @SuppressWarnings("unused")
+    public boolean asyncUpdateCreate(float budgetMs) {
+        return nAsyncUpdateCreate(mNativeObject, budgetMs);
+    }
+
+    /**
+     * Gets the status of an incremental asset creation as a percentage in [0,1].
+     */
+    @SuppressWarnings("unused")
+    public float asyncGetCreateProgress() {
+        return nAsyncGetCreateProgress(mNativeObject);
+    }
+
     /**
      * Allows clients to enable diagnostic shading on newly-loaded assets.
      */
@@ -205,6 +241,9 @@ public class AssetLoader {
     private static native long nCreateInstancedAsset(long nativeLoader, Buffer buffer, int remaining,
             long[] nativeInstances);
     private static native long nCreateInstance(long nativeLoader, long nativeAsset);
+    private static native long nAsyncBeginCreate(long nativeLoader, Buffer buffer, int remaining);
+    private static native boolean nAsyncUpdateCreate(long nativeLoader, float budgetMs);
+    private static native float nAsyncGetCreateProgress(long nativeLoader);
     private static native void nEnableDiagnostics(long nativeLoader, boolean enable);
     private static native void nDestroyAsset(long nativeLoader, long nativeAsset);
 }
@@ -239,6 +239,8 @@ public class FilamentAsset {
      * This should only be called after ResourceLoader#loadResources().
      * If using Animator, this should be called after getAnimator().
      * If this is an instanced asset, this prevents creation of new instances.
+     * If this asset is being created by AssetLoader#asyncUpdateCreate(), this does nothing until
+     * all of its entities have been created.
      */
     public void releaseSourceData() {
         nReleaseSourceData(mNativeObject);
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DataReshaper.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+using namespace filament::backend;
+
+// All benchmarks convert a 2048 x 2048 image, throughput is reported in source bytes.
+static constexpr size_t SIZE = 2048;
+static constexpr size_t PIXELS = SIZE * SIZE;
+
+template<typename T>
+static std::vector<T> createData(size_t count) {
+    std::vector<T> data(count);
+    for (size_t i = 0; i < count; i++) {
+        data[i] = T(i % 251);
+    }
+    return data;
+}
+
+static void BM_RgbToRgba8(benchmark::State& state) {
+    auto src = createData<uint8_t>(PIXELS * 3);
+    std::vector<uint8_t> dst(PIXELS * 4);
+    for (auto _ : state) {
+        DataReshaper::reshape<uint8_t, 3, 4>(dst.data(), src.data(), src.size());
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+static void BM_SwizzleRgba8(benchmark::State& state) {
+    auto src = createData<uint8_t>(PIXELS * 4);
+    std::vector<uint8_t> dst(PIXELS * 4);
+    for (auto _ : state) {
+        DataReshaper::swizzleRgba8(dst.data(), src.data(), PIXELS);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+static void BM_FloatToHalf(benchmark::State& state) {
+    auto src = createData<float>(PIXELS * 4);
+    std::vector<uint16_t> dst(PIXELS * 4);
+    for (auto _ : state) {
+        DataReshaper::floatToHalf(dst.data(), src.data(), src.size());
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size() * sizeof(float)));
+}
+
+static void BM_HalfToFloat(benchmark::State& state) {
+    auto src = createData<uint16_t>(PIXELS * 4);
+    std::vector<float> dst(PIXELS * 4);
+    for (auto _ : state) {
+        DataReshaper::halfToFloat(dst.data(), src.data(), src.size());
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size() * sizeof(uint16_t)));
+}
+
+// A read-back as done by the Vulkan backend: RGBA8 with an optional swizzle and a vertical flip.
+// The argument is 1 to swizzle.
+static void BM_ReshapeImageFlip(benchmark::State& state) {
+    auto src = createData<uint8_t>(PIXELS * 4);
+    std::vector<uint8_t> dst(PIXELS * 4);
+    const bool swizzle = state.range(0) != 0;
+    for (auto _ : state) {
+        PixelBufferDescriptor pbd(dst.data(), dst.size(),
+                PixelDataFormat::RGBA, PixelDataType::UBYTE);
+        DataReshaper::reshapeImage(&pbd, PixelDataType::UBYTE, src.data(), SIZE * 4,
+                SIZE, SIZE, swizzle, true);
+        benchmark::DoNotOptimize(dst.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+BENCHMARK(BM_RgbToRgba8);
+BENCHMARK(BM_SwizzleRgba8);
+BENCHMARK(BM_FloatToHalf);
+BENCHMARK(BM_HalfToFloat);
+BENCHMARK(BM_ReshapeImageFlip)->ArgName("swizzle")->Arg(0)->Arg(1);
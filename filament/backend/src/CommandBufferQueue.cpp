@@ -83,17 +83,17 @@ void CommandBufferQueue::flush() noexcept {
     // circular buffer is too small, we corrupted the stream
     ASSERT_POSTCONDITION(used <= mFreeSpace,
             "Backend CommandStream overflow. Commands are corrupted and unrecoverable.\n"
-            "Please increase FILAMENT_MIN_COMMAND_BUFFERS_SIZE_IN_MB (currently %u MiB).\n"
+            "Please increase Engine::Config::minCommandBufferSizeMB (currently %u MiB).\n"
             "Space used at this time: %u bytes",
-            (unsigned)FILAMENT_MIN_COMMAND_BUFFERS_SIZE_IN_MB, (unsigned)used);
+            (unsigned)(mRequiredSize / (1024 * 1024)), (unsigned)used);
 
     // wait until there is enough space in the buffer
     mFreeSpace -= used;
     const size_t requiredSize = mRequiredSize;
 
-#ifndef NDEBUG
     size_t totalUsed = circularBuffer.size() - mFreeSpace;
     mHighWatermark = std::max(mHighWatermark, totalUsed);
+#ifndef NDEBUG
     if (UTILS_UNLIKELY(totalUsed > requiredSize)) {
         slog.d << "CommandStream used too much space: " << totalUsed
             << ", out of " << requiredSize << " (will block)" << io::endl;
@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "DataReshaper.h"
+
+#include <math/half.h>
+
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#   include <arm_neon.h>
+#endif
+
+// The x86 kernels are compiled for SSSE3 and F16C with target attributes, regardless of the
+// compiler flags, and selected at runtime based on CPUID.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   define DATARESHAPER_X86 1
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define DATARESHAPER_TARGET(features)
+#   else
+#       include <cpuid.h>
+#       define DATARESHAPER_TARGET(features) __attribute__((target(features)))
+#   endif
+#   include <immintrin.h>
+#endif
+
+namespace filament {
+namespace backend {
+
+using namespace math;
+
+#if defined(DATARESHAPER_X86)
+
+namespace {
+
+struct CpuFeatures {
+    bool ssse3 = false;
+    bool f16c = false;
+};
+
+CpuFeatures detectCpuFeatures() noexcept {
+    CpuFeatures features;
+    uint32_t ecx;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    ecx = uint32_t(info[2]);
+#else
+    uint32_t eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+#endif
+    features.ssse3 = ecx & (1u << 9u);
+    // F16C instructions are VEX encoded, they also need the OS to save the AVX state
+    const bool osxsave = ecx & (1u << 27u);
+    if (osxsave && (ecx & (1u << 29u))) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        const uint64_t xcr0 = _xgetbv(0);
+#else
+        uint32_t lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        const uint64_t xcr0 = (uint64_t(hi) << 32u) | lo;
+#endif
+        features.f16c = (xcr0 & 0x6u) == 0x6u;
+    }
+    return features;
+}
+
+const CpuFeatures gCpuFeatures = detectCpuFeatures();
+
+// Each kernel processes as many elements as it can and returns their count, the caller converts
+// the remaining ones.
+
+DATARESHAPER_TARGET("ssse3")
+size_t rgbToRgba8Ssse3(uint8_t* UTILS_RESTRICT dst, const uint8_t* UTILS_RESTRICT src,
+        size_t pixelCount) noexcept {
+    // 16 pixels are loaded as three registers, each output register gathers 4 pixels
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i expandLast = _mm_setr_epi8(4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1);
+    size_t i = 0;
+    for (; i + 16 <= pixelCount; i += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i*) (src + i * 3));
+        const __m128i b = _mm_loadu_si128((const __m128i*) (src + i * 3 + 16));
+        const __m128i c = _mm_loadu_si128((const __m128i*) (src + i * 3 + 32));
+        __m128i* out = (__m128i*) (dst + i * 4);
+        _mm_storeu_si128(out + 0, _mm_or_si128(_mm_shuffle_epi8(a, expand), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), expand), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), expand), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(c, expandLast), alpha));
+    }
+    return i;
+}
+
+DATARESHAPER_TARGET("ssse3")
+size_t swizzleRgba8Ssse3(uint8_t* dst, const uint8_t* src, size_t pixelCount) noexcept {
+    const __m128i swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    size_t i = 0;
+    for (; i + 4 <= pixelCount; i += 4) {
+        const __m128i rgba = _mm_loadu_si128((const __m128i*) (src + i * 4));
+        _mm_storeu_si128((__m128i*) (dst + i * 4), _mm_shuffle_epi8(rgba, swap));
+    }
+    return i;
+}
+
+DATARESHAPER_TARGET("f16c")
+size_t halfToFloatF16c(float* UTILS_RESTRICT dst, const uint16_t* UTILS_RESTRICT src,
+        size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i h = _mm_loadu_si128((const __m128i*) (src + i));
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(h));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtph_ps(_mm_srli_si128(h, 8)));
+    }
+    return i;
+}
+
+DATARESHAPER_TARGET("f16c")
+size_t floatToHalfF16c(uint16_t* UTILS_RESTRICT dst, const float* UTILS_RESTRICT src,
+        size_t count) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+        const __m128i hi = _mm_cvtps_ph(_mm_loadu_ps(src + i + 4), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*) (dst + i), _mm_unpacklo_epi64(lo, hi));
+    }
+    return i;
+}
+
+} // anonymous namespace
+
+#endif // DATARESHAPER_X86
+
+void DataReshaper::rgbToRgba8(uint8_t* UTILS_RESTRICT dst, const uint8_t* UTILS_RESTRICT src,
+        size_t pixelCount) noexcept {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= pixelCount; i += 16) {
+        const uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+        const uint8x16x4_t rgba = {{ rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(0xff) }};
+        vst4q_u8(dst + i * 4, rgba);
+    }
+#elif defined(DATARESHAPER_X86)
+    if (gCpuFeatures.ssse3) {
+        i = rgbToRgba8Ssse3(dst, src, pixelCount);
+    }
+#endif
+    for (; i < pixelCount; ++i) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 0xff;
+    }
+}
+
+void DataReshaper::swizzleRgba8(uint8_t* dst, const uint8_t* src, size_t pixelCount) noexcept {
+    size_t i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= pixelCount; i += 16) {
+        uint8x16x4_t rgba = vld4q_u8(src + i * 4);
+        std::swap(rgba.val[0], rgba.val[2]);
+        vst4q_u8(dst + i * 4, rgba);
+    }
+#elif defined(DATARESHAPER_X86)
+    if (gCpuFeatures.ssse3) {
+        i = swizzleRgba8Ssse3(dst, src, pixelCount);
+    }
+#endif
+    // the compiler vectorizes this with plain SSE2
+    for (; i < pixelCount; ++i) {
+        uint32_t p;
+        memcpy(&p, src + i * 4, 4);
+        p = (p & 0xff00ff00u) | ((p >> 16u) & 0xffu) | ((p & 0xffu) << 16u);
+        memcpy(dst + i * 4, &p, 4);
+    }
+}
+
+void DataReshaper::halfToFloat(float* UTILS_RESTRICT dst, const uint16_t* UTILS_RESTRICT src,
+        size_t count) noexcept {
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+#elif defined(DATARESHAPER_X86)
+    if (gCpuFeatures.f16c) {
+        i = halfToFloatF16c(dst, src, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = float(makeHalf(src[i]));
+    }
+}
+
+void DataReshaper::floatToHalf(uint16_t* UTILS_RESTRICT dst, const float* UTILS_RESTRICT src,
+        size_t count) noexcept {
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#elif defined(DATARESHAPER_X86)
+    if (gCpuFeatures.f16c) {
+        i = floatToHalfF16c(dst, src, count);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = getBits(half(src[i]));
+    }
+}
+
+void DataReshaper::reshapeImageThroughFloat(uint8_t* dest, PixelDataType dstType,
+        const uint8_t* src, PixelDataType srcType, size_t srcBytesPerRow,
+        size_t dstBytesPerRow, size_t dstChannelCount, size_t height, bool swizzle, bool flip) {
+    constexpr size_t CHUNK = 64;
+    float rgba[CHUNK * 4];
+    float converted[CHUNK * 4];
+
+    const size_t srcComponentSize = srcType == PixelDataType::UBYTE ? 1 :
+            srcType == PixelDataType::HALF ? 2 : 4;
+    const size_t dstComponentSize = dstType == PixelDataType::UBYTE ? 1 :
+            dstType == PixelDataType::HALF ? 2 : 4;
+    const size_t width = srcBytesPerRow / (srcComponentSize * 4);
+
+    for (size_t row = 0; row < height; ++row) {
+        const uint8_t* in = src + srcBytesPerRow * (flip ? height - 1 - row : row);
+        uint8_t* out = dest + dstBytesPerRow * row;
+        for (size_t x = 0; x < width; x += CHUNK) {
+            const size_t count = std::min(CHUNK, width - x);
+            const uint8_t* chunkIn = in + x * 4 * srcComponentSize;
+            uint8_t* chunkOut = out + x * dstChannelCount * dstComponentSize;
+
+            // first to normalized RGBA floats...
+            switch (srcType) {
+                case PixelDataType::HALF:
+                    halfToFloat(rgba, (const uint16_t*) chunkIn, count * 4);
+                    break;
+                case PixelDataType::UBYTE:
+                    reshapeImage<float, uint8_t>((uint8_t*) rgba, chunkIn, count * 4, 0, 4, 1,
+                            false, false);
+                    break;
+                default:
+                    memcpy(rgba, chunkIn, count * 4 * sizeof(float));
+                    break;
+            }
+
+            // ...then to the destination type and channels
+            switch (dstType) {
+                case PixelDataType::HALF:
+                    reshapeImage<float, float>((uint8_t*) converted, (const uint8_t*) rgba,
+                            count * 4 * sizeof(float), 0, dstChannelCount, 1, swizzle, false);
+                    floatToHalf((uint16_t*) chunkOut, converted, count * dstChannelCount);
+                    break;
+                case PixelDataType::UBYTE:
+                    reshapeImage<uint8_t, float>(chunkOut, (const uint8_t*) rgba,
+                            count * 4 * sizeof(float), 0, dstChannelCount, 1, swizzle, false);
+                    break;
+                default:
+                    reshapeImage<float, float>(chunkOut, (const uint8_t*) rgba,
+                            count * 4 * sizeof(float), 0, dstChannelCount, 1, swizzle, false);
+                    break;
+            }
+        }
+    }
+}
+
+bool DataReshaper::reshapeImage(PixelBufferDescriptor* dst, PixelDataType srcType,
+        const uint8_t* srcBytes, int srcBytesPerRow, int width, int height, bool swizzle,
+        bool flip) {
+    size_t dstChannelCount;
+    switch (dst->format) {
+        case PixelDataFormat::R_INTEGER: dstChannelCount = 1; break;
+        case PixelDataFormat::RG_INTEGER: dstChannelCount = 2; break;
+        case PixelDataFormat::RGB_INTEGER: dstChannelCount = 3; break;
+        case PixelDataFormat::RGBA_INTEGER: dstChannelCount = 4; break;
+        case PixelDataFormat::R: dstChannelCount = 1; break;
+        case PixelDataFormat::RG: dstChannelCount = 2; break;
+        case PixelDataFormat::RGB: dstChannelCount = 3; break;
+        case PixelDataFormat::RGBA: dstChannelCount = 4; break;
+        default: return false;
+    }
+    uint8_t* dstBytes = (uint8_t*) dst->buffer;
+    const int dstBytesPerRow = PixelBufferDescriptor::computeDataSize(dst->format, dst->type,
+            dst->stride ? dst->stride : width, 1, dst->alignment);
+
+    constexpr auto UBYTE = PixelDataType::UBYTE, FLOAT = PixelDataType::FLOAT,
+            UINT = PixelDataType::UINT, INT = PixelDataType::INT, HALF = PixelDataType::HALF;
+
+    // HALF is only supported together with UBYTE, HALF and FLOAT.
+    if (srcType == HALF || dst->type == HALF) {
+        const auto supported = [=](PixelDataType type) {
+            return type == UBYTE || type == HALF || type == FLOAT;
+        };
+        if (!supported(srcType) || !supported(dst->type)) {
+            return false;
+        }
+        if (srcType == HALF && dst->type == HALF) {
+            reshapeImage<uint16_t, uint16_t>(dstBytes, srcBytes, srcBytesPerRow, dstBytesPerRow,
+                    dstChannelCount, height, swizzle, flip);
+            return true;
+        }
+        reshapeImageThroughFloat(dstBytes, dst->type, srcBytes, srcType, srcBytesPerRow,
+                dstBytesPerRow, dstChannelCount, height, swizzle, flip);
+        return true;
+    }
+
+    void (*reshaper)(uint8_t*, const uint8_t*, size_t, size_t, size_t, size_t, bool, bool)
+            = nullptr;
+    switch (dst->type) {
+        case UBYTE:
+            switch (srcType) {
+                case UBYTE: reshaper = reshapeImage<uint8_t, uint8_t>; break;
+                case FLOAT: reshaper = reshapeImage<uint8_t, float>; break;
+                case INT: reshaper = reshapeImage<uint8_t, int32_t>; break;
+                case UINT: reshaper = reshapeImage<uint8_t, uint32_t>; break;
+                default: return false;
+            }
+            break;
+        case FLOAT:
+            switch (srcType) {
+                case UBYTE: reshaper = reshapeImage<float, uint8_t>; break;
+                case FLOAT: reshaper = reshapeImage<float, float>; break;
+                case INT: reshaper = reshapeImage<float, int32_t>; break;
+                case UINT: reshaper = reshapeImage<float, uint32_t>; break;
+                default: return false;
+            }
+            break;
+        case INT:
+            switch (srcType) {
+                case UBYTE: reshaper = reshapeImage<int32_t, uint8_t>; break;
+                case FLOAT: reshaper = reshapeImage<int32_t, float>; break;
+                case INT: reshaper = reshapeImage<int32_t, int32_t>; break;
+                case UINT: reshaper = reshapeImage<int32_t, uint32_t>; break;
+                default: return false;
+            }
+            break;
+        case UINT:
+            switch (srcType) {
+                case UBYTE: reshaper = reshapeImage<uint32_t, uint8_t>; break;
+                case FLOAT: reshaper = reshapeImage<uint32_t, float>; break;
+                case INT: reshaper = reshapeImage<uint32_t, int32_t>; break;
+                case UINT: reshaper = reshapeImage<uint32_t, uint32_t>; break;
+                default: return false;
+            }
+            break;
+        default:
+            return false;
+    }
+    reshaper(dstBytes, srcBytes, srcBytesPerRow, dstBytesPerRow, dstChannelCount, height,
+            swizzle, flip);
+    return true;
+}
+
+} // namespace backend
+} // namespace filament
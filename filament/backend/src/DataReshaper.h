@@ -21,11 +21,15 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <math/scalar.h>
 
+#include <utils/compiler.h>
 #include <utils/debug.h>
 
+#include <type_traits>
+
 namespace filament {
 namespace backend {
 
@@ -36,6 +40,23 @@ template<typename componentType> inline componentType getMaxValue();
 class DataReshaper {
 public:
 
+    // Kernels for the most common conversions, with NEON implementations when the target
+    // supports them, and SSSE3 or F16C implementations selected at runtime on x86. Counts are in
+    // pixels for the RGBA kernels, and in components for the half float kernels.
+
+    // RGB8 to RGBA8, with an opaque alpha.
+    static void rgbToRgba8(uint8_t* UTILS_RESTRICT dst, const uint8_t* UTILS_RESTRICT src,
+            size_t pixelCount) noexcept;
+
+    // Swaps the red and blue channels of RGBA8 pixels. dst and src can be the same buffer.
+    static void swizzleRgba8(uint8_t* dst, const uint8_t* src, size_t pixelCount) noexcept;
+
+    static void halfToFloat(float* UTILS_RESTRICT dst, const uint16_t* UTILS_RESTRICT src,
+            size_t count) noexcept;
+
+    static void floatToHalf(uint16_t* UTILS_RESTRICT dst, const float* UTILS_RESTRICT src,
+            size_t count) noexcept;
+
     // Adds padding to multi-channel interleaved data by inserting dummy values, or discards
     // trailing channels. This is useful for platforms that only accept 4-component data, since
     // users often wish to submit (or receive) 3-component data.
@@ -78,9 +99,27 @@ public:
             srcStride = srcBytesPerRow;
         }
 
+        // Rows that keep their type and all four channels are copied or swizzled as a whole.
+        constexpr bool sameType = std::is_same_v<dstComponentType, srcComponentType>;
+        const bool copyRows = sameType && dstChannelCount == 4 && !swizzle;
+        const bool swizzleRows = sameType && sizeof(srcComponentType) == 1 &&
+                dstChannelCount == 4 && swizzle;
+
         for (size_t row = 0; row < height; ++row) {
             const srcComponentType* in = (const srcComponentType*) src;
             dstComponentType* out = (dstComponentType*) dest;
+            if (copyRows) {
+                memcpy(out, in, width * 4 * sizeof(srcComponentType));
+                src += srcStride;
+                dest += dstBytesPerRow;
+                continue;
+            }
+            if (swizzleRows) {
+                swizzleRgba8((uint8_t*) out, (const uint8_t*) in, width);
+                src += srcStride;
+                dest += dstBytesPerRow;
+                continue;
+            }
             for (size_t column = 0; column < width; ++column) {
                 for (size_t channel = 0; channel < minChannelCount; ++channel) {
                     if constexpr (std::is_same_v<dstComponentType, srcComponentType>) {
@@ -102,74 +141,16 @@ public:
         }
     }
 
-    // Converts a 4-channel image of UBYTE, INT, UINT, or FLOAT to a different type.
+    // Converts a 4-channel image of UBYTE, INT, UINT, HALF or FLOAT to a different type.
     static bool reshapeImage(PixelBufferDescriptor* dst, PixelDataType srcType,
             const uint8_t* srcBytes, int srcBytesPerRow, int width, int height, bool swizzle,
-            bool flip) {
-        size_t dstChannelCount;
-        switch (dst->format) {
-            case PixelDataFormat::R_INTEGER: dstChannelCount = 1; break;
-            case PixelDataFormat::RG_INTEGER: dstChannelCount = 2; break;
-            case PixelDataFormat::RGB_INTEGER: dstChannelCount = 3; break;
-            case PixelDataFormat::RGBA_INTEGER: dstChannelCount = 4; break;
-            case PixelDataFormat::R: dstChannelCount = 1; break;
-            case PixelDataFormat::RG: dstChannelCount = 2; break;
-            case PixelDataFormat::RGB: dstChannelCount = 3; break;
-            case PixelDataFormat::RGBA: dstChannelCount = 4; break;
-            default: return false;
-        }
-        void (*reshaper)(uint8_t*, const uint8_t*, size_t, size_t, size_t, size_t, bool, bool)
-                = nullptr;
-        constexpr auto UBYTE = PixelDataType::UBYTE, FLOAT = PixelDataType::FLOAT,
-                UINT = PixelDataType::UINT, INT = PixelDataType::INT;
-        switch (dst->type) {
-            case UBYTE:
-                switch (srcType) {
-                    case UBYTE: reshaper = reshapeImage<uint8_t, uint8_t>; break;
-                    case FLOAT: reshaper = reshapeImage<uint8_t, float>; break;
-                    case INT: reshaper = reshapeImage<uint8_t, int32_t>; break;
-                    case UINT: reshaper = reshapeImage<uint8_t, uint32_t>; break;
-                    default: return false;
-                }
-                break;
-            case FLOAT:
-                switch (srcType) {
-                    case UBYTE: reshaper = reshapeImage<float, uint8_t>; break;
-                    case FLOAT: reshaper = reshapeImage<float, float>; break;
-                    case INT: reshaper = reshapeImage<float, int32_t>; break;
-                    case UINT: reshaper = reshapeImage<float, uint32_t>; break;
-                    default: return false;
-                }
-                break;
-            case INT:
-                switch (srcType) {
-                    case UBYTE: reshaper = reshapeImage<int32_t, uint8_t>; break;
-                    case FLOAT: reshaper = reshapeImage<int32_t, float>; break;
-                    case INT: reshaper = reshapeImage<int32_t, int32_t>; break;
-                    case UINT: reshaper = reshapeImage<int32_t, uint32_t>; break;
-                    default: return false;
-                }
-                break;
-            case UINT:
-                switch (srcType) {
-                    case UBYTE: reshaper = reshapeImage<uint32_t, uint8_t>; break;
-                    case FLOAT: reshaper = reshapeImage<uint32_t, float>; break;
-                    case INT: reshaper = reshapeImage<uint32_t, int32_t>; break;
-                    case UINT: reshaper = reshapeImage<uint32_t, uint32_t>; break;
-                    default: return false;
-                }
-                break;
-            default:
-                return false;
-        }
-        uint8_t* dstBytes = (uint8_t*) dst->buffer;
-        const int dstBytesPerRow = PixelBufferDescriptor::computeDataSize(dst->format, dst->type,
-                dst->stride ? dst->stride : width, 1, dst->alignment);
-        reshaper(dstBytes, srcBytes, srcBytesPerRow, dstBytesPerRow, dstChannelCount, height,
-                swizzle, flip);
-        return true;
-    }
+            bool flip);
 
+private:
+    // Conversions from or to HALF go through a small float buffer on the stack.
+    static void reshapeImageThroughFloat(uint8_t* dest, PixelDataType dstType,
+            const uint8_t* src, PixelDataType srcType, size_t srcBytesPerRow,
+            size_t dstBytesPerRow, size_t dstChannelCount, size_t height, bool swizzle, bool flip);
 };
 
 template<> inline float getMaxValue() { return 1.0f; }
@@ -178,6 +159,11 @@ template<> inline uint32_t getMaxValue() { return 0xffffffff; }
 template<> inline uint16_t getMaxValue() { return 0x3c00; } // 0x3c00 is 1.0 in half-float.
 template<> inline uint8_t getMaxValue() { return 0xff; }
 
+template<>
+inline void DataReshaper::reshape<uint8_t, 3, 4>(void* dest, const void* src, size_t numSrcBytes) {
+    rgbToRgba8((uint8_t*) dest, (const uint8_t*) src, numSrcBytes / 3);
+}
+
 } // namespace backend
 } // namespace filament
 
@@ -29,6 +29,9 @@
 
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <iterator>
+
 using namespace utils;
 
 namespace filament {
@@ -127,6 +130,35 @@ void DriverBase::scheduleDestroySlow(BufferDescriptor&& buffer) noexcept {
     });
 }
 
+void DriverBase::execute(std::function<void(void)> fn) noexcept {
+    fn();
+    flushDestroyBatch();
+}
+
+void DriverBase::flushDestroyBatch() noexcept {
+    if (mDestroyBatch.empty()) {
+        return;
+    }
+    std::vector<BufferDescriptor> batch;
+    std::swap(batch, mDestroyBatch);
+
+    // All buffers typically share the same handler, in which case this loop runs once.
+    auto first = batch.begin();
+    while (first != batch.end()) {
+        CallbackHandler* const handler = first->getHandler();
+        auto last = std::stable_partition(first, batch.end(),
+                [handler](BufferDescriptor const& buffer) {
+                    return buffer.getHandler() == handler;
+                });
+        std::vector<BufferDescriptor> group(
+                std::make_move_iterator(first), std::make_move_iterator(last));
+        scheduleCallback(handler, [group = std::move(group)]() {
+            // user callbacks are called when the BufferDescriptors get destroyed
+        });
+        first = last;
+    }
+}
+
 // This is called from an async driver method so it's in the GL thread, but purge is called
 // on the user thread. This is typically called 0 or 1 times per frame.
 void DriverBase::scheduleRelease(AcquiredImage const& image) noexcept {
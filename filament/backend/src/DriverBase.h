@@ -31,6 +31,7 @@
 
 #include <array>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
@@ -179,6 +180,9 @@ public:
 
     Dispatcher& getDispatcher() noexcept final { return *mDispatcher; }
 
+    // Executes a command buffer, then releases the buffers batched by its commands.
+    void execute(std::function<void(void)> fn) noexcept override;
+
     // --------------------------------------------------------------------------------------------
     // Privates
     // --------------------------------------------------------------------------------------------
@@ -226,12 +230,25 @@ protected:
 
     void scheduleDestroySlow(BufferDescriptor&& buffer) noexcept;
 
+    // Same as scheduleDestroy(), but the buffer is only released by the next flushDestroyBatch(),
+    // together with all the others, using a single callback per handler. This happens at the
+    // latest at the end of the command buffer being executed, see execute().
+    inline void scheduleDestroyBatched(BufferDescriptor&& buffer) noexcept {
+        if (buffer.hasCallback()) {
+            mDestroyBatch.push_back(std::move(buffer));
+        }
+    }
+
+    void flushDestroyBatch() noexcept;
+
     void scheduleRelease(AcquiredImage const& image) noexcept;
 
     void debugCommandBegin(CommandStream* cmds, bool synchronous, const char* methodName) noexcept override;
     void debugCommandEnd(CommandStream* cmds, bool synchronous, const char* methodName) noexcept override;
 
 private:
+    std::vector<BufferDescriptor> mDestroyBatch;
+
     std::mutex mPurgeLock;
     std::vector<std::pair<void*, CallbackHandler::Callback>> mCallbacks;
 
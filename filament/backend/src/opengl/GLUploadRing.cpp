@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLUploadRing.h"
+
+#include "GLUtils.h"
+#include "OpenGLContext.h"
+
+#include <utils/compiler.h>
+#include <utils/Log.h>
+#include <utils/debug.h>
+
+#include <string.h>
+
+#if defined(GL_VERSION_4_4) || defined(GL_EXT_buffer_storage)
+#define HAS_BUFFER_STORAGE 1
+#else
+#define HAS_BUFFER_STORAGE 0
+#endif
+
+using namespace utils;
+
+namespace filament {
+
+// offsets in the ring are kept 4-bytes aligned
+static constexpr uint32_t ALIGNMENT = 4;
+
+GLUploadRing::GLUploadRing(OpenGLContext& context) noexcept
+        : mContext(context) {
+#if HAS_BUFFER_STORAGE
+    if (context.ext.EXT_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &mBuffer);
+        context.bindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+        glBufferStorage(GL_COPY_READ_BUFFER, CAPACITY, nullptr, flags);
+        mMapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, CAPACITY, flags));
+        if (UTILS_UNLIKELY(!mMapped)) {
+            // not fatal, we'll just use glBufferSubData()
+            context.deleteBuffers(1, &mBuffer, GL_COPY_READ_BUFFER);
+            mBuffer = 0;
+        }
+        CHECK_GL_ERROR(slog.e)
+    }
+#endif
+}
+
+GLUploadRing::~GLUploadRing() noexcept {
+    assert_invariant(!mBuffer);
+}
+
+void GLUploadRing::terminate() noexcept {
+    if (mBuffer) {
+        mPendingCopies.clear();
+        for (Fence const& fence : mFences) {
+            glDeleteSync(fence.sync);
+        }
+        mFences.clear();
+        mContext.bindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        mContext.deleteBuffers(1, &mBuffer, GL_COPY_READ_BUFFER);
+        mBuffer = 0;
+        mMapped = nullptr;
+    }
+}
+
+bool GLUploadRing::retireOldestFence() noexcept {
+    if (mFences.empty()) {
+        return false;
+    }
+    Fence const& fence = mFences.front();
+    // we never wait, the caller falls back to glBufferSubData() instead
+    const GLenum status = glClientWaitSync(fence.sync, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+    glDeleteSync(fence.sync);
+    mUsed -= fence.size;
+    mFences.pop_front();
+    return true;
+}
+
+bool GLUploadRing::allocate(uint32_t size, uint32_t* offset) noexcept {
+    size = (size + (ALIGNMENT - 1u)) & ~(ALIGNMENT - 1u);
+
+    // the end of the ring is wasted if the allocation doesn't fit there
+    const uint32_t wasted = (mHead + size > CAPACITY) ? CAPACITY - mHead : 0;
+    const uint32_t needed = size + wasted;
+    while (CAPACITY - mUsed < needed) {
+        if (!retireOldestFence()) {
+            return false;
+        }
+    }
+
+    if (wasted) {
+        mHead = 0;
+    }
+    *offset = mHead;
+    mHead += size;
+    mUsed += needed;
+    mFrameUsed += needed;
+    return true;
+}
+
+bool GLUploadRing::upload(GLuint buffer, uint32_t byteOffset,
+        void const* data, uint32_t size) noexcept {
+    assert_invariant(isSupported());
+    if (UTILS_UNLIKELY(size > MAX_UPLOAD_SIZE)) {
+        return false;
+    }
+
+    uint32_t srcOffset;
+    if (UTILS_UNLIKELY(!allocate(size, &srcOffset))) {
+        return false;
+    }
+
+    // the ring is mapped coherent, this is all we need to do
+    memcpy(mMapped + srcOffset, data, size);
+
+    // merge with the previous copy if both sides are contiguous, this is typically the case
+    // when a buffer is updated in several consecutive chunks.
+    if (!mPendingCopies.empty()) {
+        Copy& last = mPendingCopies.back();
+        if (last.buffer == buffer &&
+                last.srcOffset + last.size == srcOffset &&
+                last.dstOffset + last.size == byteOffset) {
+            last.size += size;
+            return true;
+        }
+    }
+    mPendingCopies.push_back({ buffer, srcOffset, byteOffset, size });
+    return true;
+}
+
+void GLUploadRing::flush() noexcept {
+    if (mPendingCopies.empty()) {
+        return;
+    }
+    auto& gl = mContext;
+    gl.bindBuffer(GL_COPY_READ_BUFFER, mBuffer);
+    for (Copy const& copy : mPendingCopies) {
+        gl.bindBuffer(GL_COPY_WRITE_BUFFER, copy.buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                copy.srcOffset, copy.dstOffset, copy.size);
+    }
+    // Don't leave the destination bound: OpenGLContext doesn't track the deletion of buffers
+    // bound to GL_COPY_WRITE_BUFFER, and their name could be reused.
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    mPendingCopies.clear();
+    CHECK_GL_ERROR(slog.e)
+}
+
+void GLUploadRing::endFrame() noexcept {
+    if (!isSupported()) {
+        return;
+    }
+    flush();
+    if (mFrameUsed) {
+        mFences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), mFrameUsed });
+        mFrameUsed = 0;
+    }
+    // opportunistically reclaim the frames that already completed
+    while (retireOldestFence()) {
+    }
+}
+
+} // namespace filament
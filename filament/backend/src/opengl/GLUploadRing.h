@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DRIVER_GLUPLOADRING_H
+#define TNT_FILAMENT_DRIVER_GLUPLOADRING_H
+
+#include "gl_headers.h"
+
+#include <utils/compiler.h>
+
+#include <deque>
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+
+class OpenGLContext;
+
+/*
+ * A persistently mapped staging buffer used for small buffer updates.
+ *
+ * Each update is copied into the ring and a copy to its destination buffer is queued. Queued
+ * copies are issued in a batch by flush(), copies that are contiguous both in the ring and in the
+ * destination buffer are merged into a single glCopyBufferSubData().
+ *
+ * The space used during a frame is reclaimed once the fence inserted by endFrame() signals. We
+ * never wait on these fences, if the ring is full, upload() fails and the caller is expected to
+ * fall back to a regular glBufferSubData().
+ *
+ * This requires GL 4.4 or GL_EXT_buffer_storage, isSupported() returns false otherwise.
+ */
+class GLUploadRing {
+public:
+    // size of the ring
+    static constexpr uint32_t CAPACITY = 4u * 1024u * 1024u;
+
+    // larger updates are not worth staging
+    static constexpr uint32_t MAX_UPLOAD_SIZE = 64u * 1024u;
+
+    explicit GLUploadRing(OpenGLContext& context) noexcept;
+    ~GLUploadRing() noexcept;
+
+    GLUploadRing(GLUploadRing const&) = delete;
+    GLUploadRing& operator=(GLUploadRing const&) = delete;
+
+    void terminate() noexcept;
+
+    bool isSupported() const noexcept { return mMapped != nullptr; }
+
+    // Copies size bytes into the ring and queues a copy into buffer at byteOffset.
+    // Returns false if the data couldn't be staged, in which case nothing is queued.
+    bool upload(GLuint buffer, uint32_t byteOffset, void const* data, uint32_t size) noexcept;
+
+    bool hasPendingCopies() const noexcept { return !mPendingCopies.empty(); }
+
+    // Issues all the queued copies.
+    void flush() noexcept;
+
+    // Flushes and fences the part of the ring used during this frame.
+    void endFrame() noexcept;
+
+private:
+    struct Copy {
+        GLuint buffer;
+        uint32_t srcOffset;
+        uint32_t dstOffset;
+        uint32_t size;
+    };
+
+    struct Fence {
+        GLsync sync;
+        uint32_t size;  // bytes of the ring released when this fence signals
+    };
+
+    bool allocate(uint32_t size, uint32_t* offset) noexcept;
+    bool retireOldestFence() noexcept;
+
+    OpenGLContext& mContext;
+    GLuint mBuffer = 0;
+    uint8_t* mMapped = nullptr;
+
+    uint32_t mHead = 0;         // next write offset in the ring
+    uint32_t mUsed = 0;         // bytes in use, including the ones used during this frame
+    uint32_t mFrameUsed = 0;    // bytes used during this frame, not fenced yet
+
+    std::deque<Fence> mFences;
+    std::vector<Copy> mPendingCopies;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DRIVER_GLUPLOADRING_H
@@ -276,6 +276,7 @@ bool OpenGLContext::hasExtension(ExtentionSet const& map, utils::StaticString ex
 void OpenGLContext::initExtensionsGLES(GLint major, GLint minor, ExtentionSet const& exts) {
     // figure out and initialize the extensions we need
     ext.APPLE_color_buffer_packed_float = hasExtension(exts, "GL_APPLE_color_buffer_packed_float");
+    ext.EXT_buffer_storage = hasExtension(exts, "GL_EXT_buffer_storage");
     ext.EXT_clip_control = hasExtension(exts, "GL_EXT_clip_control");
     ext.EXT_color_buffer_float = hasExtension(exts, "GL_EXT_color_buffer_float");
     ext.EXT_color_buffer_half_float = hasExtension(exts, "GL_EXT_color_buffer_half_float");
@@ -304,6 +305,7 @@ void OpenGLContext::initExtensionsGLES(GLint major, GLint minor, ExtentionSet co
 void OpenGLContext::initExtensionsGL(GLint major, GLint minor, ExtentionSet const& exts) {
     ext.APPLE_color_buffer_packed_float = true;  // Assumes core profile.
     ext.ARB_shading_language_packing = hasExtension(exts, "GL_ARB_shading_language_packing") || (major == 4 && minor >= 2);
+    ext.EXT_buffer_storage = hasExtension(exts, "GL_ARB_buffer_storage") || (major == 4 && minor >= 4);
     ext.EXT_clip_control = hasExtension(exts, "GL_ARB_clip_control") || (major == 4 && minor >= 5);
     ext.EXT_color_buffer_float = true;  // Assumes core profile.
     ext.EXT_color_buffer_half_float = true;  // Assumes core profile.
@@ -133,6 +133,7 @@ public:
     struct {
         bool APPLE_color_buffer_packed_float = false;
         bool ARB_shading_language_packing = false;
+        bool EXT_buffer_storage = false;
         bool EXT_clip_control = false;
         bool EXT_color_buffer_float = false;
         bool EXT_color_buffer_half_float = false;
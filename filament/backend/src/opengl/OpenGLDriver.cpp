@@ -166,7 +166,8 @@ OpenGLDriver::OpenGLDriver(OpenGLPlatform* platform) noexcept
         : DriverBase(new ConcreteDispatcher<OpenGLDriver>()),
           mHandleAllocator("Handles", FILAMENT_OPENGL_HANDLE_ARENA_SIZE_IN_MB * 1024U * 1024U), // TODO: set the amount in configuration
           mSamplerMap(32),
-          mPlatform(*platform) {
+          mPlatform(*platform),
+          mUploadRing(mContext) {
   
     std::fill(mSamplerBindings.begin(), mSamplerBindings.end(), nullptr);
 
@@ -213,6 +214,9 @@ OpenGLDriver::~OpenGLDriver() noexcept {
 // ------------------------------------------------------------------------------------------------
 
 void OpenGLDriver::terminate() {
+    // release the buffers of the last updates
+    flushDestroyBatch();
+
     // wait for the GPU to finish executing all commands
     glFinish();
 
@@ -231,6 +235,13 @@ void OpenGLDriver::terminate() {
         mOpenGLBlitter->terminate();
     }
 
+    mUploadRing.terminate();
+
+    for (ReadbackBuffer& pbo : mReadbackBuffers) {
+        mContext.deleteBuffers(1, &pbo.id, GL_PIXEL_PACK_BUFFER);
+    }
+    mReadbackBuffers.clear();
+
     delete mTimerQueryImpl;
 
     mPlatform.terminate();
@@ -1186,6 +1197,8 @@ void OpenGLDriver::destroyIndexBuffer(Handle<HwIndexBuffer> ibh) {
     if (ibh) {
         auto& gl = mContext;
         GLIndexBuffer const* ib = handle_cast<const GLIndexBuffer*>(ibh);
+        // copies to this buffer might still be queued
+        mUploadRing.flush();
         gl.deleteBuffers(1, &ib->gl.buffer, GL_ELEMENT_ARRAY_BUFFER);
         destruct(ibh, ib);
     }
@@ -1196,6 +1209,8 @@ void OpenGLDriver::destroyBufferObject(Handle<HwBufferObject> boh) {
     if (boh) {
         auto& gl = mContext;
         GLBufferObject const* bo = handle_cast<const GLBufferObject*>(boh);
+        // copies to this buffer might still be queued
+        mUploadRing.flush();
         gl.deleteBuffers(1, &bo->gl.id, bo->gl.binding);
         destruct(boh, bo);
     }
@@ -1636,11 +1651,15 @@ void OpenGLDriver::updateIndexBuffer(
     GLIndexBuffer* ib = handle_cast<GLIndexBuffer *>(ibh);
     assert_invariant(ib->elementSize == 2 || ib->elementSize == 4);
 
-    gl.bindVertexArray(nullptr);
-    gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, byteOffset, p.size, p.buffer);
+    if (!uploadToRing(ib->gl.buffer, p, byteOffset)) {
+        // queued copies to this buffer must land before this update
+        mUploadRing.flush();
+        gl.bindVertexArray(nullptr);
+        gl.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ib->gl.buffer);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, byteOffset, p.size, p.buffer);
+    }
 
-    scheduleDestroy(std::move(p));
+    scheduleDestroyBatched(std::move(p));
 
     CHECK_GL_ERROR(utils::slog.e)
 }
@@ -1657,7 +1676,9 @@ void OpenGLDriver::updateBufferObject(
     if (bo->gl.binding == GL_UNIFORM_BUFFER) {
         // TODO: use updateBuffer() for all types of buffer? Make sure GL supports that.
         updateBuffer(bo, bd, byteOffset, (uint32_t)gl.gets.uniform_buffer_offset_alignment);
-    } else {
+    } else if (bd.size == bo->byteCount || !uploadToRing(bo->gl.id, bd, byteOffset)) {
+        // queued copies to this buffer must land before this update
+        mUploadRing.flush();
         if (bo->gl.binding == GL_ARRAY_BUFFER) {
             gl.bindVertexArray(nullptr);
         }
@@ -1672,7 +1693,7 @@ void OpenGLDriver::updateBufferObject(
         }
     }
 
-    scheduleDestroy(std::move(bd));
+    scheduleDestroyBatched(std::move(bd));
 
     CHECK_GL_ERROR(utils::slog.e)
 }
@@ -1729,7 +1750,9 @@ void OpenGLDriver::updateBuffer(GLBufferObject* buffer, backend::BufferDescripto
             // In stream mode we're allowed to allocate a whole new buffer
             glBufferData(buffer->gl.binding, p.size, p.buffer, getBufferUsage(buffer->usage));
         }
-    } else {
+    } else if (p.size == buffer->byteCount || !uploadToRing(buffer->gl.id, p, byteOffset)) {
+        // queued copies to this buffer must land before this update
+        mUploadRing.flush();
         if (byteOffset == 0 && p.size == buffer->byteCount) {
             // it looks like it's generally faster (or not worse) to use glBufferData()
             glBufferData(buffer->gl.binding, buffer->byteCount, p.buffer,
@@ -1744,6 +1767,13 @@ void OpenGLDriver::updateBuffer(GLBufferObject* buffer, backend::BufferDescripto
     CHECK_GL_ERROR(utils::slog.e)
 }
 
+bool OpenGLDriver::uploadToRing(GLuint buffer, backend::BufferDescriptor const& p,
+        uint32_t byteOffset) noexcept {
+    // small updates are staged and their copies batched, this is a lot cheaper than a
+    // glBufferSubData() each when many buffers are updated every frame.
+    return mUploadRing.isSupported() &&
+            mUploadRing.upload(buffer, byteOffset, p.buffer, (uint32_t)p.size);
+}
 
 void OpenGLDriver::updateSamplerGroup(Handle<HwSamplerGroup> sbh,
         SamplerGroup&& samplerGroup) {
@@ -2223,6 +2253,9 @@ void OpenGLDriver::beginRenderPass(Handle<HwRenderTarget> rth,
 
     GLRenderTarget* rt = handle_cast<GLRenderTarget*>(rth);
 
+    // issue the copies of the buffer updates done since the last pass, before rendering starts
+    mUploadRing.flush();
+
     const TargetBufferFlags clearFlags = params.flags.clear & rt->targets;
     TargetBufferFlags discardFlags = params.flags.discardStart & rt->targets;
 
@@ -2839,10 +2872,10 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     GLRenderTarget const* s = handle_cast<GLRenderTarget const*>(src);
     gl.bindFramebuffer(GL_READ_FRAMEBUFFER, s->gl.fbo);
 
-    GLuint pbo;
-    glGenBuffers(1, &pbo);
-    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
-    glBufferData(GL_PIXEL_PACK_BUFFER, p.size, nullptr, GL_STATIC_DRAW);
+    // pack buffers are recycled, so that back-to-back read-backs (e.g. one per frame) don't
+    // allocate a new buffer each time, which can stall on some drivers.
+    const ReadbackBuffer pbo = acquireReadbackBuffer(p.size);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
     glReadPixels(GLint(x), GLint(y), GLint(width), GLint(height), glFormat, glType, nullptr);
     gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     CHECK_GL_ERROR(utils::slog.e)
@@ -2853,7 +2886,7 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
     whenGpuCommandsComplete([this, width, height, pbo, pUserBuffer]() mutable {
         PixelBufferDescriptor& p = *pUserBuffer;
         auto& gl = mContext;
-        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
         void* vaddr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,  p.size, GL_MAP_READ_BIT);
         if (vaddr) {
             // now we need to flip the buffer vertically to match our API
@@ -2872,13 +2905,46 @@ void OpenGLDriver::readPixels(Handle<HwRenderTarget> src,
             glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         }
         gl.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-        glDeleteBuffers(1, &pbo);
+        releaseReadbackBuffer(pbo);
         scheduleDestroy(std::move(p));
         delete pUserBuffer;
         CHECK_GL_ERROR(utils::slog.e)
     });
 }
 
+OpenGLDriver::ReadbackBuffer OpenGLDriver::acquireReadbackBuffer(size_t size) noexcept {
+    auto& gl = mContext;
+    auto& v = mReadbackBuffers;
+    // use the smallest free buffer large enough
+    auto best = v.end();
+    for (auto it = v.begin(); it != v.end(); ++it) {
+        if (it->size >= size && (best == v.end() || it->size < best->size)) {
+            best = it;
+        }
+    }
+    if (best != v.end()) {
+        ReadbackBuffer const pbo = *best;
+        v.erase(best);
+        return pbo;
+    }
+    ReadbackBuffer pbo{ 0, size };
+    glGenBuffers(1, &pbo.id);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER, pbo.id);
+    glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr, GL_STREAM_READ);
+    CHECK_GL_ERROR(utils::slog.e)
+    return pbo;
+}
+
+void OpenGLDriver::releaseReadbackBuffer(ReadbackBuffer pbo) noexcept {
+    auto& v = mReadbackBuffers;
+    if (v.size() == MAX_FREE_READBACK_BUFFERS) {
+        // evict the oldest buffer, it's the least likely to be reused
+        mContext.deleteBuffers(1, &v.front().id, GL_PIXEL_PACK_BUFFER);
+        v.erase(v.begin());
+    }
+    v.push_back(pbo);
+}
+
 void OpenGLDriver::whenGpuCommandsComplete(std::function<void()> fn) noexcept {
     GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
     mGpuCommandCompleteOps.emplace_back(sync, std::move(fn));
@@ -2966,11 +3032,13 @@ void OpenGLDriver::endFrame(uint32_t frameId) {
     //SYSTRACE_NAME("glFinish");
     //glFinish();
     insertEventMarker("endFrame");
+    mUploadRing.endFrame();
 }
 
 void OpenGLDriver::flush(int) {
     DEBUG_MARKER()
     auto& gl = mContext;
+    mUploadRing.flush();
     if (!gl.bugs.disable_glFlush) {
         glFlush();
     }
@@ -2979,6 +3047,7 @@ void OpenGLDriver::flush(int) {
 
 void OpenGLDriver::finish(int) {
     DEBUG_MARKER()
+    mUploadRing.flush();
     glFinish();
     mTimerQueryImpl->flush();
     executeGpuCommandsCompleteOps();
@@ -3158,6 +3227,11 @@ void OpenGLDriver::draw(PipelineState state, Handle<HwRenderPrimitive> rph) {
         return;
     }
 
+    // buffers could have been updated in the middle of the render pass
+    if (UTILS_UNLIKELY(mUploadRing.hasPendingCopies())) {
+        mUploadRing.flush();
+    }
+
     gl.bindVertexArray(&rp->gl);
 
     // If necessary, mutate the bindings in the VAO.
@@ -19,6 +19,7 @@
 
 #include "private/backend/Driver.h"
 #include "DriverBase.h"
+#include "GLUploadRing.h"
 #include "GLUtils.h"
 #include "OpenGLContext.h"
 
@@ -375,6 +376,11 @@ private:
     backend::OpenGLPlatform& mPlatform;
 
     OpenGLBlitter* mOpenGLBlitter = nullptr;
+
+    // staging area for small buffer updates, copies are batched until the next draw
+    GLUploadRing mUploadRing;
+    bool uploadToRing(GLuint buffer, backend::BufferDescriptor const& p,
+            uint32_t byteOffset) noexcept;
     void updateStreamTexId(GLTexture* t, backend::DriverApi* driver) noexcept;
     void updateStreamAcquired(GLTexture* t, backend::DriverApi* driver) noexcept;
     void updateBuffer(GLBufferObject* buffer, backend::BufferDescriptor const& p,
@@ -383,6 +389,16 @@ private:
 
     void setExternalTexture(GLTexture* t, void* image);
 
+    // pixel pack buffers of completed read-backs, kept for reuse
+    struct ReadbackBuffer {
+        GLuint id;
+        size_t size;
+    };
+    static constexpr size_t MAX_FREE_READBACK_BUFFERS = 8;
+    ReadbackBuffer acquireReadbackBuffer(size_t size) noexcept;
+    void releaseReadbackBuffer(ReadbackBuffer pbo) noexcept;
+    std::vector<ReadbackBuffer> mReadbackBuffers;
+
     // tasks executed on the main thread after the fence signaled
     void whenGpuCommandsComplete(std::function<void()> fn) noexcept;
     void executeGpuCommandsCompleteOps() noexcept;
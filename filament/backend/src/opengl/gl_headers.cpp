@@ -45,6 +45,9 @@ PFNGLGETDEBUGMESSAGELOGKHRPROC glGetDebugMessageLogKHR;
 #ifdef GL_EXT_disjoint_timer_query
 PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v;
 #endif
+#ifdef GL_EXT_buffer_storage
+PFNGLBUFFERSTORAGEEXTPROC glBufferStorage;
+#endif
 #ifdef GL_EXT_clip_control
 PFNGLCLIPCONTROLEXTPROC glClipControl;
 #endif
@@ -102,6 +105,11 @@ void importGLESExtensionsEntryPoints() {
         glGetQueryObjectui64v =
                 (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress(
                         "glGetQueryObjectui64vEXT");
+#endif
+#ifdef GL_EXT_buffer_storage
+        glBufferStorage =
+                (PFNGLBUFFERSTORAGEEXTPROC)eglGetProcAddress(
+                        "glBufferStorageEXT");
 #endif
     });
 #ifdef GL_EXT_clip_control
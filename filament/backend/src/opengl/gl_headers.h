@@ -52,6 +52,15 @@
         extern PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64v;
         #define GL_TIME_ELAPSED               0x88BF
 #endif
+#ifdef GL_EXT_buffer_storage
+        extern PFNGLBUFFERSTORAGEEXTPROC glBufferStorage;
+        #ifndef GL_MAP_PERSISTENT_BIT
+        #define GL_MAP_PERSISTENT_BIT GL_MAP_PERSISTENT_BIT_EXT
+        #endif
+        #ifndef GL_MAP_COHERENT_BIT
+        #define GL_MAP_COHERENT_BIT GL_MAP_COHERENT_BIT_EXT
+        #endif
+#endif
 #ifdef GL_EXT_clip_control
         extern PFNGLCLIPCONTROLEXTPROC glClipControl;
         #ifndef GL_LOWER_LEFT
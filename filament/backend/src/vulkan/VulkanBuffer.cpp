@@ -53,20 +53,78 @@ void VulkanBuffer::terminate(VulkanContext& context) {
     mGpuBuffer = VK_NULL_HANDLE;
 }
 
+void VulkanUploadBatch::add(VkBufferUsageFlags usage) {
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)) {
+        mDstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        mDstAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT |
+                VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    }
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+        // see the note about Mali in VulkanBuffer::loadFromCpu()
+        mDstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+        mDstAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_UNIFORM_READ_BIT;
+    }
+}
+
+void VulkanUploadBatch::flush(VkCommandBuffer cmdbuffer) {
+    if (empty()) {
+        return;
+    }
+
+    // A global memory barrier covers all the buffers uploaded in this batch, including the ones
+    // recorded in command buffers that were already submitted.
+    VkMemoryBarrier barrier{
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = mDstAccessMask
+    };
+
+    vkCmdPipelineBarrier(cmdbuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, mDstStageMask,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    mDstStageMask = 0;
+    mDstAccessMask = 0;
+    mId++;
+}
+
 void VulkanBuffer::loadFromCpu(VulkanContext& context, VulkanStagePool& stagePool,
-        const void* cpuData, uint32_t byteOffset, uint32_t numBytes) const {
-    assert_invariant(byteOffset == 0);
-    VulkanStage const* stage = stagePool.acquireStage(numBytes);
-    void* mapped;
-    vmaMapMemory(context.allocator, stage->memory, &mapped);
-    memcpy(mapped, cpuData, numBytes);
-    vmaUnmapMemory(context.allocator, stage->memory);
-    vmaFlushAllocation(context.allocator, stage->memory, byteOffset, numBytes);
+        const void* cpuData, uint32_t byteOffset, uint32_t numBytes,
+        VulkanUploadBatch* batch) const {
+    VkBuffer srcBuffer;
+    VkDeviceSize srcOffset = 0;
+    if (numBytes <= VulkanStagePool::MAX_STAGE_REGION_SIZE) {
+        // small uploads share a persistently mapped stage
+        VulkanStageRegion const region = stagePool.acquireStageRegion(numBytes);
+        memcpy(region.mapped, cpuData, numBytes);
+        vmaFlushAllocation(context.allocator, region.stage->memory, region.offset, numBytes);
+        srcBuffer = region.stage->buffer;
+        srcOffset = region.offset;
+    } else {
+        VulkanStage const* stage = stagePool.acquireStage(numBytes);
+        void* mapped;
+        vmaMapMemory(context.allocator, stage->memory, &mapped);
+        memcpy(mapped, cpuData, numBytes);
+        vmaUnmapMemory(context.allocator, stage->memory);
+        vmaFlushAllocation(context.allocator, stage->memory, 0, numBytes);
+        srcBuffer = stage->buffer;
+    }
 
     const VkCommandBuffer cmdbuffer = context.commands->get().cmdbuffer;
 
-    VkBufferCopy region{ .size = numBytes };
-    vkCmdCopyBuffer(cmdbuffer, stage->buffer, mGpuBuffer, 1, &region);
+    if (batch && mUploadBatchId == batch->getId()) {
+        // this buffer was already uploaded in this batch, the previous copy must complete first
+        batch->flush(cmdbuffer);
+    }
+
+    VkBufferCopy region{ .srcOffset = srcOffset, .dstOffset = byteOffset, .size = numBytes };
+    vkCmdCopyBuffer(cmdbuffer, srcBuffer, mGpuBuffer, 1, &region);
+
+    if (batch) {
+        batch->add(mUsage);
+        mUploadBatchId = batch->getId();
+        return;
+    }
 
     // Firstly, ensure that the copy finishes before the next draw call.
     // Secondly, in case the user decides to upload another chunk (without ever using the first one)
@@ -23,6 +23,21 @@
 namespace filament {
 namespace backend {
 
+// Accumulates the memory barriers needed by a batch of buffer uploads, so that they can be issued
+// with a single vkCmdPipelineBarrier() before the next render pass.
+class VulkanUploadBatch {
+public:
+    bool empty() const { return !mDstStageMask; }
+    uint32_t getId() const { return mId; }
+    void add(VkBufferUsageFlags usage);
+    // Records the barrier covering all the uploads of the batch, and starts a new batch.
+    void flush(VkCommandBuffer cmdbuffer);
+private:
+    VkPipelineStageFlags mDstStageMask = 0;
+    VkAccessFlags mDstAccessMask = 0;
+    uint32_t mId = 1;
+};
+
 // Encapsulates a Vulkan buffer, its attached DeviceMemory and a staging area.
 class VulkanBuffer {
 public:
@@ -30,13 +45,17 @@ public:
             uint32_t numBytes);
     ~VulkanBuffer();
     void terminate(VulkanContext& context);
+    // If a batch is given, the barrier protecting the upload is deferred to the batch's flush().
     void loadFromCpu(VulkanContext& context, VulkanStagePool& stagePool,
-            const void* cpuData, uint32_t byteOffset, uint32_t numBytes) const;
+            const void* cpuData, uint32_t byteOffset, uint32_t numBytes,
+            VulkanUploadBatch* batch = nullptr) const;
     VkBuffer getGpuBuffer() const { return mGpuBuffer; }
 private:
     VmaAllocation mGpuMemory = VK_NULL_HANDLE;
     VkBuffer mGpuBuffer = VK_NULL_HANDLE;
     VkBufferUsageFlags mUsage = {};
+    // id of the last batch this buffer was uploaded in
+    mutable uint32_t mUploadBatchId = 0;
 };
 
 } // namespace filament
@@ -53,7 +53,7 @@ struct VulkanAttachment {
 
 struct VulkanTimestamps {
     VkQueryPool pool;
-    utils::bitset32 used;
+    utils::bitset256 used;
     utils::Mutex mutex;
 };
 
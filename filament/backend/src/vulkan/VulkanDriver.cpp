@@ -319,6 +319,9 @@ void VulkanDriver::terminate() {
         return;
     }
 
+    // release the buffers of the last updates
+    flushDestroyBatch();
+
     delete mContext.commands;
     delete mContext.emptyTexture;
 
@@ -849,17 +852,17 @@ void VulkanDriver::setVertexBufferObject(Handle<HwVertexBuffer> vbh, uint32_t in
 void VulkanDriver::updateIndexBuffer(Handle<HwIndexBuffer> ibh, BufferDescriptor&& p,
         uint32_t byteOffset) {
     auto ib = handle_cast<VulkanIndexBuffer*>(ibh);
-    ib->buffer.loadFromCpu(mContext, mStagePool, p.buffer, byteOffset, p.size);
+    ib->buffer.loadFromCpu(mContext, mStagePool, p.buffer, byteOffset, p.size, &mUploadBatch);
     mDisposer.acquire(ib);
-    scheduleDestroy(std::move(p));
+    scheduleDestroyBatched(std::move(p));
 }
 
 void VulkanDriver::updateBufferObject(Handle<HwBufferObject> boh, BufferDescriptor&& bd,
         uint32_t byteOffset) {
     auto bo = handle_cast<VulkanBufferObject*>(boh);
-    bo->buffer.loadFromCpu(mContext, mStagePool, bd.buffer, byteOffset, bd.size);
+    bo->buffer.loadFromCpu(mContext, mStagePool, bd.buffer, byteOffset, bd.size, &mUploadBatch);
     mDisposer.acquire(bo);
-    scheduleDestroy(std::move(bd));
+    scheduleDestroyBatched(std::move(bd));
 }
 
 void VulkanDriver::update2DImage(Handle<HwTexture> th,
@@ -1139,6 +1142,9 @@ void VulkanDriver::beginRenderPass(Handle<HwRenderTarget> rth, const RenderPassP
     }
     renderPassInfo.pClearValues = &clearValues[0];
 
+    // Make the buffer uploads done since the last pass visible, with a single barrier.
+    mUploadBatch.flush(cmdbuffer);
+
     vkCmdBeginRenderPass(cmdbuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport viewport = mContext.viewport = {
@@ -19,6 +19,7 @@
 
 #include "VulkanPipelineCache.h"
 #include "VulkanBlitter.h"
+#include "VulkanBuffer.h"
 #include "VulkanDisposer.h"
 #include "VulkanConstants.h"
 #include "VulkanContext.h"
@@ -140,6 +141,7 @@ private:
     VulkanPipelineCache mPipelineCache;
     VulkanDisposer mDisposer;
     VulkanStagePool mStagePool;
+    VulkanUploadBatch mUploadBatch;
     VulkanFboCache mFramebufferCache;
     VulkanSamplerCache mSamplerCache;
     VulkanBlitter mBlitter;
@@ -303,7 +303,7 @@ void VulkanRenderPrimitive::setBuffers(VulkanVertexBuffer* vertexBuffer,
 
 VulkanTimerQuery::VulkanTimerQuery(VulkanContext& context) : mContext(context) {
     std::unique_lock<utils::Mutex> lock(context.timestamps.mutex);
-    utils::bitset32& bitset = context.timestamps.used;
+    utils::bitset256& bitset = context.timestamps.used;
     const size_t maxTimers = bitset.size();
     assert_invariant(bitset.count() < maxTimers);
     for (size_t timerIndex = 0; timerIndex < maxTimers; ++timerIndex) {
@@ -34,6 +34,8 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
         auto stage = iter->second;
         mFreeStages.erase(iter);
         mUsedStages.insert(stage);
+        // the stage must not be reclaimed before the frame using it completes
+        stage->lastAccessed = mCurrentFrame;
         return stage;
     }
     // We were not able to find a sufficiently large stage, so create a new one.
@@ -58,6 +60,34 @@ VulkanStage const* VulkanStagePool::acquireStage(uint32_t numBytes) {
     return stage;
 }
 
+VulkanStageRegion VulkanStagePool::acquireStageRegion(uint32_t numBytes) {
+    assert_invariant(numBytes <= MAX_STAGE_REGION_SIZE);
+
+    // keep regions 16-bytes aligned, so copies into them are fast
+    uint32_t offset = (mStageBlockOffset + 15u) & ~15u;
+    if (!mStageBlock || offset + numBytes > mStageBlock->capacity) {
+        retireStageBlock();
+        mStageBlock = acquireStage(STAGE_BLOCK_SIZE);
+        vmaMapMemory(mContext.allocator, mStageBlock->memory, &mStageBlockMapped);
+        offset = 0;
+    }
+    mStageBlockOffset = offset + numBytes;
+    return {
+        .stage = mStageBlock,
+        .offset = offset,
+        .mapped = static_cast<uint8_t*>(mStageBlockMapped) + offset
+    };
+}
+
+void VulkanStagePool::retireStageBlock() noexcept {
+    if (mStageBlock) {
+        vmaUnmapMemory(mContext.allocator, mStageBlock->memory);
+        mStageBlock = nullptr;
+        mStageBlockMapped = nullptr;
+        mStageBlockOffset = 0;
+    }
+}
+
 VulkanStageImage const* VulkanStagePool::acquireImage(PixelDataFormat format, PixelDataType type,
         uint32_t width, uint32_t height) {
     const VkFormat vkformat = getVkFormat(format, type);
@@ -122,6 +152,10 @@ VulkanStageImage const* VulkanStagePool::acquireImage(PixelDataFormat format, Pi
 }
 
 void VulkanStagePool::gc() noexcept {
+    // Each frame starts a new shared stage, the current one is reclaimed with the others below,
+    // once the frame that used it completed.
+    retireStageBlock();
+
     // If this is one of the first few frames, return early to avoid wrapping unsigned integers.
     if (++mCurrentFrame <= TIME_BEFORE_EVICTION) {
         return;
@@ -178,6 +212,8 @@ void VulkanStagePool::gc() noexcept {
 }
 
 void VulkanStagePool::reset() noexcept {
+    retireStageBlock();
+
     for (auto stage : mUsedStages) {
         vmaDestroyBuffer(mContext.allocator, stage->buffer, stage->memory);
         delete stage;
@@ -33,6 +33,13 @@ struct VulkanStage {
     mutable uint64_t lastAccessed;
 };
 
+// A range of a stage that is shared by several small uploads, see acquireStageRegion().
+struct VulkanStageRegion {
+    VulkanStage const* stage;
+    uint32_t offset;
+    void* mapped;   // host address of the region
+};
+
 struct VulkanStageImage {
     VkFormat format;
     uint32_t width;
@@ -52,6 +59,17 @@ public:
     // The stage is automatically released back to the pool after TIME_BEFORE_EVICTION frames.
     VulkanStage const* acquireStage(uint32_t numBytes);
 
+    // Size of the stages that are shared by small uploads.
+    static constexpr uint32_t STAGE_BLOCK_SIZE = 1024 * 1024;
+
+    // Larger uploads should use their own stage.
+    static constexpr uint32_t MAX_STAGE_REGION_SIZE = 64 * 1024;
+
+    // Sub-allocates a region from a persistently mapped stage shared with other small uploads of
+    // the current frame. This is a lot cheaper than acquireStage() followed by a map/unmap.
+    // numBytes must be smaller or equal to MAX_STAGE_REGION_SIZE.
+    VulkanStageRegion acquireStageRegion(uint32_t numBytes);
+
     // Images have VK_IMAGE_LAYOUT_GENERAL and must not be transitioned to any other layout
     VulkanStageImage const* acquireImage(PixelDataFormat format, PixelDataType type,
             uint32_t width, uint32_t height);
@@ -64,8 +82,16 @@ public:
     void reset() noexcept;
 
 private:
+    // Unmaps the current shared stage, it'll be reclaimed like any other stage.
+    void retireStageBlock() noexcept;
+
     VulkanContext& mContext;
 
+    // Current shared stage used by acquireStageRegion(), it's mapped until retired.
+    VulkanStage const* mStageBlock = nullptr;
+    void* mStageBlockMapped = nullptr;
+    uint32_t mStageBlockOffset = 0;
+
     // Use an ordered multimap for quick (capacity => stage) lookups using lower_bound().
     std::multimap<uint32_t, VulkanStage const*> mFreeStages;
 
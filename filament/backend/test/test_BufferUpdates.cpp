@@ -19,6 +19,12 @@
 #include "ShaderGenerator.h"
 #include "TrianglePrimitive.h"
 
+#include <atomic>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
 namespace {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -217,4 +223,149 @@ TEST_F(BackendTest, BufferObjectUpdateWithOffset) {
     getDriver().purge();
 }
 
+// Uploads size bytes from a new allocation, whose release increments *released.
+static void uploadCounted(DriverApi& dapi, Handle<HwBufferObject> bo, void const* data,
+        uint32_t size, uint32_t byteOffset, std::atomic<uint32_t>* released) {
+    void* tmp = malloc(size);
+    memcpy(tmp, data, size);
+    BufferDescriptor bd(tmp, size, [](void* buffer, size_t, void* user) {
+        free(buffer);
+        static_cast<std::atomic<uint32_t>*>(user)->fetch_add(1, std::memory_order_relaxed);
+    }, released);
+    dapi.updateBufferObject(bo, std::move(bd), byteOffset);
+}
+
+TEST_F(BackendTest, BufferObjectUpdateRingWrap) {
+    // Small updates are staged in a ring (GLUploadRing on OpenGL, a shared stage on Vulkan).
+    // Upload more than the ring's capacity over a few frames so that it wraps around, then check
+    // that later updates still land in the right place: the triangle drawn in the last frame gets
+    // its indices through the wrapped ring.
+    // The updates only cover part of the buffer, at non-zero offsets, and are smaller than
+    // GLUploadRing::MAX_UPLOAD_SIZE, otherwise OpenGL replaces the whole buffer without staging.
+    constexpr uint32_t CHUNK_SIZE = 48u * 1024u;
+    constexpr uint32_t CHUNKS_IN_FILLER = 4;
+    constexpr uint32_t CHUNKS_PER_FRAME = 40;
+    constexpr uint32_t FRAME_COUNT = 4;
+    static_assert(CHUNK_SIZE * CHUNKS_PER_FRAME * FRAME_COUNT > 4u * 1024u * 1024u,
+            "the updates must not fit in the ring");
+
+    std::atomic<uint32_t> released{ 0 };
+    uint32_t uploaded = 0;
+
+    {
+        auto swapChain = createSwapChain();
+        getDriverApi().makeCurrent(swapChain, swapChain);
+
+        ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+        Program p = shaderGen.getProgram();
+        p.setUniformBlock(1, utils::CString("params"));
+        auto program = getDriverApi().createProgram(std::move(p));
+
+        auto ubuffer = getDriverApi().createBufferObject(sizeof(MaterialParams) + 64,
+                BufferObjectBinding::UNIFORM, BufferUsage::STATIC);
+        getDriverApi().bindUniformBuffer(0, ubuffer);
+
+        auto filler = getDriverApi().createBufferObject(CHUNK_SIZE * CHUNKS_IN_FILLER,
+                BufferObjectBinding::VERTEX, BufferUsage::STATIC);
+
+        auto defaultRenderTarget = getDriverApi().createDefaultRenderTarget(0);
+
+        std::vector<uint8_t> chunk(CHUNK_SIZE, 0x5A);
+        for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+            getDriverApi().makeCurrent(swapChain, swapChain);
+            getDriverApi().beginFrame(0, frame);
+            for (uint32_t i = 0; i < CHUNKS_PER_FRAME; i++) {
+                // skips the first chunk, so that no update starts at 0
+                const uint32_t byteOffset = (1 + i % (CHUNKS_IN_FILLER - 1)) * CHUNK_SIZE;
+                uploadCounted(getDriverApi(), filler, chunk.data(), CHUNK_SIZE, byteOffset,
+                        &released);
+                uploaded++;
+            }
+
+            // only the color uploaded in the last frame must be visible
+            const bool last = frame == FRAME_COUNT - 1;
+            const MaterialParams params{
+                    .red = 1.0f,
+                    .green = last ? 0.0f : 1.0f,
+                    .blue = 0.5f
+            };
+            uploadCounted(getDriverApi(), ubuffer, &params, sizeof(params), 64, &released);
+            uploaded++;
+
+            renderTriangle(defaultRenderTarget, swapChain, program);
+            if (last) {
+                static const uint32_t expectedHash = 2000773999;
+                readPixelsAndAssertHash("BufferObjectUpdateRingWrap", 512, 512,
+                        defaultRenderTarget, expectedHash);
+            }
+
+            getDriverApi().commit(swapChain);
+            getDriverApi().endFrame(frame);
+        }
+
+        getDriverApi().destroyProgram(program);
+        getDriverApi().destroyBufferObject(filler);
+        getDriverApi().destroyBufferObject(ubuffer);
+        getDriverApi().destroySwapChain(swapChain);
+        getDriverApi().destroyRenderTarget(defaultRenderTarget);
+    }
+
+    // The release callbacks of staged updates are batched, but they must all have been called
+    // once the frames ended and the driver is idle.
+    flushAndWait();
+    getDriver().purge();
+    EXPECT_EQ(released.load(), uploaded);
+}
+
+TEST_F(BackendTest, BufferObjectUpdateSameBufferTwice) {
+    // Several updates of the same buffer between two render passes: they're batched (a single
+    // barrier on Vulkan, merged copies on OpenGL) but must still be applied in order.
+    std::atomic<uint32_t> released{ 0 };
+
+    auto swapChain = createSwapChain();
+    getDriverApi().makeCurrent(swapChain, swapChain);
+
+    ShaderGenerator shaderGen(vertex, fragment, sBackend, sIsMobilePlatform);
+    Program p = shaderGen.getProgram();
+    p.setUniformBlock(1, utils::CString("params"));
+    auto program = getDriverApi().createProgram(std::move(p));
+
+    auto ubuffer = getDriverApi().createBufferObject(sizeof(MaterialParams) + 64,
+            BufferObjectBinding::UNIFORM, BufferUsage::STATIC);
+    getDriverApi().bindUniformBuffer(0, ubuffer);
+
+    getDriverApi().beginFrame(0, 0);
+
+    // overwritten below
+    const MaterialParams wrong{ .red = 0.0f, .green = 1.0f, .blue = 1.0f };
+    uploadCounted(getDriverApi(), ubuffer, &wrong, sizeof(wrong), 64, &released);
+
+    // contiguous updates, which can be merged into a single copy
+    const float red = 1.0f, green = 0.0f, blue = 0.5f;
+    uploadCounted(getDriverApi(), ubuffer, &red, sizeof(float), 64, &released);
+    uploadCounted(getDriverApi(), ubuffer, &green, sizeof(float), 68, &released);
+    uploadCounted(getDriverApi(), ubuffer, &blue, sizeof(float), 72, &released);
+
+    auto defaultRenderTarget = getDriverApi().createDefaultRenderTarget(0);
+
+    renderTriangle(defaultRenderTarget, swapChain, program);
+
+    static const uint32_t expectedHash = 2000773999;
+    readPixelsAndAssertHash("BufferObjectUpdateSameBufferTwice", 512, 512,
+            defaultRenderTarget, expectedHash);
+
+    getDriverApi().flush();
+    getDriverApi().commit(swapChain);
+    getDriverApi().endFrame(0);
+
+    getDriverApi().destroyProgram(program);
+    getDriverApi().destroyBufferObject(ubuffer);
+    getDriverApi().destroySwapChain(swapChain);
+    getDriverApi().destroyRenderTarget(defaultRenderTarget);
+
+    flushAndWait();
+    getDriver().purge();
+    EXPECT_EQ(released.load(), 4u);
+}
+
 } // namespace test
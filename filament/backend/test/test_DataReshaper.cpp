@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "DataReshaper.h"
+
+#include <math/half.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <string.h>
+
+using namespace filament::backend;
+using namespace filament::math;
+
+// The SIMD kernels process blocks of pixels and leave the rest to scalar code, so every test runs
+// over sizes that are not multiples of the block sizes.
+
+TEST(DataReshaperTest, RgbToRgba) {
+    for (size_t count = 0; count <= 67; count++) {
+        std::vector<uint8_t> rgb(count * 3);
+        for (size_t i = 0; i < rgb.size(); i++) {
+            rgb[i] = uint8_t(i * 7 + 3);
+        }
+        // the canary after the last pixel must not be written
+        std::vector<uint8_t> rgba(count * 4 + 1, 0x5a);
+        DataReshaper::rgbToRgba8(rgba.data(), rgb.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            EXPECT_EQ(rgba[i * 4 + 0], rgb[i * 3 + 0]) << "pixel " << i << " of " << count;
+            EXPECT_EQ(rgba[i * 4 + 1], rgb[i * 3 + 1]) << "pixel " << i << " of " << count;
+            EXPECT_EQ(rgba[i * 4 + 2], rgb[i * 3 + 2]) << "pixel " << i << " of " << count;
+            EXPECT_EQ(rgba[i * 4 + 3], 0xff) << "pixel " << i << " of " << count;
+        }
+        EXPECT_EQ(rgba.back(), 0x5a);
+    }
+}
+
+TEST(DataReshaperTest, Swizzle) {
+    for (size_t count = 0; count <= 37; count++) {
+        std::vector<uint8_t> src(count * 4);
+        for (size_t i = 0; i < src.size(); i++) {
+            src[i] = uint8_t(i * 13 + 1);
+        }
+        std::vector<uint8_t> expected(src);
+        for (size_t i = 0; i < count; i++) {
+            std::swap(expected[i * 4 + 0], expected[i * 4 + 2]);
+        }
+
+        std::vector<uint8_t> dst(count * 4);
+        DataReshaper::swizzleRgba8(dst.data(), src.data(), count);
+        EXPECT_EQ(dst, expected) << count << " pixels";
+
+        // in place
+        DataReshaper::swizzleRgba8(src.data(), src.data(), count);
+        EXPECT_EQ(src, expected) << count << " pixels, in place";
+    }
+}
+
+TEST(DataReshaperTest, HalfToFloat) {
+    // every half, converted in one call so that most go through the SIMD kernel
+    std::vector<uint16_t> halves(65536 + 3);
+    for (size_t i = 0; i < halves.size(); i++) {
+        halves[i] = uint16_t(i);
+    }
+    std::vector<float> floats(halves.size());
+    DataReshaper::halfToFloat(floats.data(), halves.data(), halves.size());
+    for (size_t i = 0; i < halves.size(); i++) {
+        const float expected = float(makeHalf(halves[i]));
+        if (std::isnan(expected)) {
+            EXPECT_TRUE(std::isnan(floats[i])) << std::hex << halves[i];
+        } else {
+            EXPECT_EQ(floats[i], expected) << std::hex << halves[i];
+        }
+    }
+}
+
+TEST(DataReshaperTest, FloatToHalf) {
+    std::vector<float> floats;
+    // exact values, limits, values that overflow and signed zeros
+    for (float f : { 0.0f, -0.0f, 1.0f, -1.0f, 0.5f, 2048.0f, 65504.0f, -65504.0f, 65519.0f,
+                     65520.0f, 1e6f, -1e6f, 6.103515625e-05f, 5.9604645e-08f, 1e-10f,
+                     INFINITY, -INFINITY }) {
+        floats.push_back(f);
+    }
+    // ties between two halves, in the normal and subnormal ranges
+    for (float f : { 1.0f, 3.0f, 1000.0f, 6.103515625e-05f, 1e-5f }) {
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        bits = (bits & ~0x1fffu) | 0x1000u;
+        memcpy(&f, &bits, 4);
+        floats.push_back(f);
+        floats.push_back(-f);
+    }
+    // and a range of arbitrary values
+    srand(1);
+    for (size_t i = 0; i < 4096; i++) {
+        const float mantissa = float(rand()) / float(RAND_MAX) * 2.0f - 1.0f;
+        floats.push_back(std::ldexp(mantissa, rand() % 48 - 28));
+    }
+
+    std::vector<uint16_t> halves(floats.size());
+    DataReshaper::floatToHalf(halves.data(), floats.data(), floats.size());
+
+    for (size_t i = 0; i < floats.size(); i++) {
+        const float f = floats[i];
+        const uint16_t expected = getBits(half(f));
+
+        // The result must have the same sign, and be at most one ulp away from math::half's.
+        // F16C rounds ties to even, while math::half rounds them away from zero and rounds
+        // twice in the subnormal range, so only normal values that are not ties must match.
+        EXPECT_EQ(halves[i] & 0x8000u, expected & 0x8000u) << f;
+        EXPECT_LE(std::abs(int(halves[i] & 0x7fffu) - int(expected & 0x7fffu)), 1) << f;
+
+        uint32_t bits;
+        memcpy(&bits, &f, 4);
+        const bool tie = (bits & 0x1fffu) == 0x1000u;
+        const bool normal = std::abs(f) >= 6.103515625e-05f;
+        if (normal && !tie) {
+            EXPECT_EQ(halves[i], expected) << f;
+        }
+    }
+}
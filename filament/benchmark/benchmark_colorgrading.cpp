@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "PerformanceCounters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filament/ColorGrading.h>
+#include <filament/Engine.h>
+#include <filament/ToneMapper.h>
+
+using namespace filament;
+
+class ColorGradingFixture : public benchmark::Fixture {
+protected:
+    Engine* engine = nullptr;
+    ACESToneMapper aces;
+    FilmicToneMapper filmic;
+
+public:
+    void SetUp(const benchmark::State&) override {
+        engine = Engine::create(Engine::Backend::NOOP);
+    }
+
+    void TearDown(const benchmark::State&) override {
+        Engine::destroy(&engine);
+    }
+};
+
+// Every iteration changes the exposure, which forces all the stages of the LUT to be generated
+BENCHMARK_DEFINE_F(ColorGradingFixture, fullBuild)(benchmark::State& state) {
+    const uint8_t dimension = uint8_t(state.range(0));
+    float exposure = 0.0f;
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            exposure += 1e-3f;
+            ColorGrading* colorGrading = ColorGrading::Builder()
+                    .dimensions(dimension)
+                    .toneMapper(&aces)
+                    .exposure(exposure)
+                    .saturation(1.1f)
+                    .build(*engine);
+            engine->destroy(colorGrading);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * dimension * dimension * dimension);
+    }
+}
+
+// Every iteration only changes the tone mapper, the output of the earlier stages is reused
+BENCHMARK_DEFINE_F(ColorGradingFixture, toneMapperChange)(benchmark::State& state) {
+    const uint8_t dimension = uint8_t(state.range(0));
+    bool useAces = false;
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            useAces = !useAces;
+            ColorGrading* colorGrading = ColorGrading::Builder()
+                    .dimensions(dimension)
+                    .toneMapper(useAces ? (ToneMapper const*)&aces : &filmic)
+                    .saturation(1.1f)
+                    .build(*engine);
+            engine->destroy(colorGrading);
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * dimension * dimension * dimension);
+    }
+}
+
+// The configuration never changes and the LUT is shared with an existing ColorGrading
+BENCHMARK_DEFINE_F(ColorGradingFixture, cachedBuild)(benchmark::State& state) {
+    const uint8_t dimension = uint8_t(state.range(0));
+    auto builder = ColorGrading::Builder()
+            .dimensions(dimension)
+            .toneMapper(&aces)
+            .saturation(1.1f);
+    ColorGrading* reference = builder.build(*engine);
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            engine->destroy(builder.build(*engine));
+        }
+        pc.stop();
+        state.SetItemsProcessed(state.iterations() * dimension * dimension * dimension);
+    }
+    engine->destroy(reference);
+}
+
+BENCHMARK_REGISTER_F(ColorGradingFixture, fullBuild)->Arg(16)->Arg(32)->Arg(64);
+BENCHMARK_REGISTER_F(ColorGradingFixture, toneMapperChange)->Arg(16)->Arg(32)->Arg(64);
+BENCHMARK_REGISTER_F(ColorGradingFixture, cachedBuild)->Arg(16)->Arg(32)->Arg(64);
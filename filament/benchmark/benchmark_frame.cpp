@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerformanceCounters.h"
+
+#include <benchmark/benchmark.h>
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/TransformManager.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+
+#include "details/Renderer.h"
+
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/scalar.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <stddef.h>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+/*
+ * Measures the CPU cost of a whole frame (beginFrame/render/endFrame) on the NOOP backend,
+ * i.e. without any GPU or driver overhead. Besides the total time per frame, the time spent in
+ * each stage of the frame is reported as a per-iteration average counter.
+ *
+ * Arguments are: renderables, point lights, shadow casting spot lights, skinned renderables.
+ */
+class FrameFixture : public benchmark::Fixture {
+protected:
+    static constexpr uint32_t WIDTH = 1280;
+    static constexpr uint32_t HEIGHT = 720;
+    static constexpr size_t BONE_COUNT = 32;
+
+    Engine* engine = nullptr;
+    SwapChain* swapChain = nullptr;
+    Renderer* renderer = nullptr;
+    View* view = nullptr;
+    Scene* scene = nullptr;
+    Camera* camera = nullptr;
+    VertexBuffer* vertexBuffer = nullptr;
+    VertexBuffer* skinnedVertexBuffer = nullptr;
+    IndexBuffer* indexBuffer = nullptr;
+    Entity cameraEntity;
+    Entity sun;
+    std::vector<Entity> renderables;
+    std::vector<Entity> skinned;
+    std::vector<Entity> lights;
+    std::array<mat4f, BONE_COUNT> bones;
+
+    struct Vertex {
+        float3 position;
+    };
+
+    struct SkinnedVertex {
+        float3 position;
+        ushort4 indices;
+        float4 weights;
+    };
+
+public:
+    void SetUp(const benchmark::State& state) override {
+        const size_t renderableCount = size_t(state.range(0));
+        const size_t lightCount = size_t(state.range(1));
+        const size_t shadowCasterCount = size_t(state.range(2));
+        const size_t skinnedCount = size_t(state.range(3));
+
+        engine = Engine::create(Engine::Backend::NOOP);
+        swapChain = engine->createSwapChain(WIDTH, HEIGHT);
+        renderer = engine->createRenderer();
+        scene = engine->createScene();
+        view = engine->createView();
+
+        EntityManager& em = EntityManager::get();
+        cameraEntity = em.create();
+        camera = engine->createCamera(cameraEntity);
+        camera->setProjection(45.0, double(WIDTH) / HEIGHT, 0.1, 100.0);
+        camera->lookAt({ 0, 0, 0 }, { 0, 0, -1 });
+
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setViewport({ 0, 0, WIDTH, HEIGHT });
+
+        static const Vertex vertices[3] = {
+                {{ -1, -1, 0 }}, {{ 1, -1, 0 }}, {{ 0, 1, 0 }} };
+        static const SkinnedVertex skinnedVertices[3] = {
+                {{ -1, -1, 0 }, { 0, 1, 0, 0 }, { 0.5f, 0.5f, 0, 0 }},
+                {{  1, -1, 0 }, { 1, 2, 0, 0 }, { 0.5f, 0.5f, 0, 0 }},
+                {{  0,  1, 0 }, { 2, 3, 0, 0 }, { 0.5f, 0.5f, 0, 0 }}};
+        static const uint16_t indices[3] = { 0, 1, 2 };
+
+        vertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0,
+                        VertexBuffer::AttributeType::FLOAT3, 0, sizeof(Vertex))
+                .build(*engine);
+        vertexBuffer->setBufferAt(*engine, 0, { vertices, sizeof(vertices) });
+
+        skinnedVertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3,
+                        offsetof(SkinnedVertex, position), sizeof(SkinnedVertex))
+                .attribute(VertexAttribute::BONE_INDICES, 0, VertexBuffer::AttributeType::USHORT4,
+                        offsetof(SkinnedVertex, indices), sizeof(SkinnedVertex))
+                .attribute(VertexAttribute::BONE_WEIGHTS, 0, VertexBuffer::AttributeType::FLOAT4,
+                        offsetof(SkinnedVertex, weights), sizeof(SkinnedVertex))
+                .build(*engine);
+        skinnedVertexBuffer->setBufferAt(*engine, 0, { skinnedVertices, sizeof(skinnedVertices) });
+
+        indexBuffer = IndexBuffer::Builder()
+                .indexCount(3)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(*engine);
+        indexBuffer->setBuffer(*engine, { indices, sizeof(indices) });
+
+        MaterialInstance const* mi = engine->getDefaultMaterial()->getDefaultInstance();
+        auto& tcm = engine->getTransformManager();
+
+        // all objects are spread in front of the camera, so that most of them are visible
+        std::default_random_engine gen; // NOLINT
+        std::uniform_real_distribution<float> rand(-20.0f, 20.0f);
+        auto randomPosition = [&]() {
+            return float3{ rand(gen), rand(gen), -30.0f + rand(gen) };
+        };
+
+        renderables.resize(renderableCount);
+        em.create(renderables.size(), renderables.data());
+        for (Entity e : renderables) {
+            RenderableManager::Builder(1)
+                    .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            vertexBuffer, indexBuffer)
+                    .material(0, mi)
+                    .castShadows(true)
+                    .receiveShadows(true)
+                    .build(*engine, e);
+            tcm.setTransform(tcm.getInstance(e), mat4f::translation(randomPosition()));
+            scene->addEntity(e);
+        }
+
+        bones.fill(mat4f{});
+        skinned.resize(skinnedCount);
+        em.create(skinned.size(), skinned.data());
+        for (Entity e : skinned) {
+            RenderableManager::Builder(1)
+                    .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            skinnedVertexBuffer, indexBuffer)
+                    .material(0, mi)
+                    .skinning(BONE_COUNT, bones.data())
+                    .castShadows(true)
+                    .receiveShadows(true)
+                    .build(*engine, e);
+            tcm.setTransform(tcm.getInstance(e), mat4f::translation(randomPosition()));
+            scene->addEntity(e);
+        }
+
+        sun = em.create();
+        LightManager::Builder(LightManager::Type::SUN)
+                .direction({ 0, -1, -0.5f })
+                .castShadows(true)
+                .build(*engine, sun);
+        scene->addEntity(sun);
+
+        lights.resize(lightCount + shadowCasterCount);
+        em.create(lights.size(), lights.data());
+        for (size_t i = 0; i < lights.size(); i++) {
+            const bool castShadows = i >= lightCount;
+            LightManager::Builder(castShadows ?
+                            LightManager::Type::FOCUSED_SPOT : LightManager::Type::POINT)
+                    .position(randomPosition())
+                    .direction({ 0, 0, -1 })
+                    .spotLightCone(0.5f, 0.7f)
+                    .falloff(10.0f)
+                    .castShadows(castShadows)
+                    .build(*engine, lights[i]);
+            scene->addEntity(lights[i]);
+        }
+    }
+
+    void TearDown(const benchmark::State&) override {
+        EntityManager& em = EntityManager::get();
+        for (Entity e : renderables) engine->destroy(e);
+        for (Entity e : skinned) engine->destroy(e);
+        for (Entity e : lights) engine->destroy(e);
+        engine->destroy(sun);
+        em.destroy(renderables.size(), renderables.data());
+        em.destroy(skinned.size(), skinned.data());
+        em.destroy(lights.size(), lights.data());
+        em.destroy(sun);
+        engine->destroy(vertexBuffer);
+        engine->destroy(skinnedVertexBuffer);
+        engine->destroy(indexBuffer);
+        engine->destroyCameraComponent(cameraEntity);
+        em.destroy(cameraEntity);
+        engine->destroy(view);
+        engine->destroy(scene);
+        engine->destroy(renderer);
+        engine->destroy(swapChain);
+        Engine::destroy(&engine);
+        renderables.clear();
+        skinned.clear();
+        lights.clear();
+    }
+
+    void animate(float t) noexcept {
+        auto& rcm = engine->getRenderableManager();
+        for (size_t i = 0; i < BONE_COUNT; i++) {
+            bones[i] = mat4f::rotation(t + float(i) * 0.1f, float3{ 0, 0, 1 });
+        }
+        for (Entity e : skinned) {
+            rcm.setBones(rcm.getInstance(e), bones.data(), BONE_COUNT);
+        }
+    }
+};
+
+BENCHMARK_DEFINE_F(FrameFixture, frame)(benchmark::State& state) {
+    using Stage = CpuStageTimings::Stage;
+    std::array<std::chrono::duration<double>, CpuStageTimings::STAGE_COUNT> totals{};
+    CpuStageTimings const& timings = upcast(renderer)->getCpuStageTimings();
+    float t = 0.0f;
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            animate(t += 1.0f / 60.0f);
+            if (renderer->beginFrame(swapChain)) {
+                renderer->render(view);
+                renderer->endFrame();
+            }
+            for (size_t i = 0; i < CpuStageTimings::STAGE_COUNT; i++) {
+                totals[i] += timings.get(Stage(i));
+            }
+        }
+        pc.stop();
+    }
+
+    // this drains the command stream, so it's not counted in the timing above
+    engine->flushAndWait();
+
+    for (size_t i = 0; i < CpuStageTimings::STAGE_COUNT; i++) {
+        state.counters[CpuStageTimings::getName(Stage(i))] =
+                benchmark::Counter(totals[i].count(), benchmark::Counter::kAvgIterations);
+    }
+    state.SetItemsProcessed(state.iterations() * (renderables.size() + skinned.size()));
+}
+
+BENCHMARK_REGISTER_F(FrameFixture, frame)
+        ->ArgNames({ "renderables", "lights", "shadows", "skinned" })
+        ->Args({   100,   0, 0,   0 })
+        ->Args({  1000,   0, 0,   0 })
+        ->Args({ 10000,   0, 0,   0 })
+        ->Args({  1000, 256, 0,   0 })
+        ->Args({  1000,  64, 8,   0 })
+        ->Args({  1000,   0, 0, 100 })
+        ->Args({  5000, 256, 8, 500 })
+        ->Unit(benchmark::kMicrosecond);
+
+/*
+ * Renders thumbnails of the same scene from many cameras in a single frame, either with one
+ * render() per view, or with a single renderViews() call.
+ *
+ * Arguments are: renderables, point lights, shadow casting spot lights, skinned renderables,
+ * views, whether renderViews() is used.
+ */
+BENCHMARK_DEFINE_F(FrameFixture, views)(benchmark::State& state) {
+    const size_t viewCount = size_t(state.range(4));
+    const bool batched = state.range(5) != 0;
+
+    EntityManager& em = EntityManager::get();
+    std::vector<View*> views(viewCount);
+    std::vector<Entity> cameras(viewCount);
+    em.create(cameras.size(), cameras.data());
+    for (size_t i = 0; i < viewCount; i++) {
+        const float angle = float(i) * 2.0f * float(F_PI) / float(viewCount);
+        Camera* c = engine->createCamera(cameras[i]);
+        c->setProjection(45.0, 1.0, 0.1, 100.0);
+        c->lookAt({ 40.0f * std::sin(angle), 0, -30.0f + 40.0f * std::cos(angle) },
+                { 0, 0, -30.0f });
+        views[i] = engine->createView();
+        views[i]->setScene(scene);
+        views[i]->setCamera(c);
+        views[i]->setViewport({ 0, 0, 256, 256 });
+    }
+
+    {
+        PerformanceCounters pc(state);
+        for (auto _ : state) {
+            if (renderer->beginFrame(swapChain)) {
+                if (batched) {
+                    renderer->renderViews(views.data(), views.size());
+                } else {
+                    for (View const* v : views) {
+                        renderer->render(v);
+                    }
+                }
+                renderer->endFrame();
+            }
+        }
+        pc.stop();
+    }
+
+    engine->flushAndWait();
+
+    for (size_t i = 0; i < viewCount; i++) {
+        engine->destroy(views[i]);
+        engine->destroyCameraComponent(cameras[i]);
+    }
+    em.destroy(cameras.size(), cameras.data());
+
+    state.SetItemsProcessed(state.iterations() * viewCount);
+}
+
+BENCHMARK_REGISTER_F(FrameFixture, views)
+        ->ArgNames({ "renderables", "lights", "shadows", "skinned", "views", "batched" })
+        ->Args({  1000,   0, 0, 0, 64, 0 })
+        ->Args({  1000,   0, 0, 0, 64, 1 })
+        ->Args({ 10000,   0, 0, 0, 64, 0 })
+        ->Args({ 10000,   0, 0, 0, 64, 1 })
+        ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/PixelReadbackRing.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+#include <filament/Viewport.h>
+
+#include <backend/PixelBufferDescriptor.h>
+
+#include <utils/EntityManager.h>
+
+#include <math/vec3.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+/*
+ * Measures the frame rate achieved when every frame rendered to a headless SwapChain is read
+ * back, as done for offscreen video capture. This uses the OpenGL backend, on a machine without
+ * a GPU it runs on llvmpipe. The frame rate is reported as items_per_second.
+ *
+ * - readPixels/blocking waits for each read-back before rendering the next frame.
+ * - readPixels/ring uses a PixelReadbackRing of the given depth.
+ */
+class ReadbackFixture : public benchmark::Fixture {
+protected:
+    static constexpr uint32_t WIDTH = 1280;
+    static constexpr uint32_t HEIGHT = 720;
+
+    Engine* engine = nullptr;
+    SwapChain* swapChain = nullptr;
+    Renderer* renderer = nullptr;
+    View* view = nullptr;
+    Scene* scene = nullptr;
+    Camera* camera = nullptr;
+    VertexBuffer* vertexBuffer = nullptr;
+    IndexBuffer* indexBuffer = nullptr;
+    Entity cameraEntity;
+    Entity triangle;
+
+public:
+    void SetUp(const benchmark::State&) override {
+        engine = Engine::create(Engine::Backend::OPENGL);
+        if (!engine) {
+            return;
+        }
+        swapChain = engine->createSwapChain(WIDTH, HEIGHT);
+        renderer = engine->createRenderer();
+        renderer->setClearOptions({ .clearColor = { 0.1f, 0.2f, 0.3f, 1.0f }, .clear = true });
+        scene = engine->createScene();
+        view = engine->createView();
+
+        EntityManager& em = EntityManager::get();
+        cameraEntity = em.create();
+        camera = engine->createCamera(cameraEntity);
+        camera->setProjection(45.0, double(WIDTH) / HEIGHT, 0.1, 100.0);
+        camera->lookAt({ 0, 0, 0 }, { 0, 0, -1 });
+
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setViewport({ 0, 0, WIDTH, HEIGHT });
+        view->setPostProcessingEnabled(false);
+
+        static const float3 vertices[3] = {{ -2, -2, -3 }, { 2, -2, -3 }, { 0, 2, -3 }};
+        static const uint16_t indices[3] = { 0, 1, 2 };
+
+        vertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                .build(*engine);
+        vertexBuffer->setBufferAt(*engine, 0, { vertices, sizeof(vertices) });
+
+        indexBuffer = IndexBuffer::Builder()
+                .indexCount(3)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(*engine);
+        indexBuffer->setBuffer(*engine, { indices, sizeof(indices) });
+
+        triangle = em.create();
+        RenderableManager::Builder(1)
+                .boundingBox({{ -2, -2, -3 }, { 2, 2, -3 }})
+                .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                        vertexBuffer, indexBuffer)
+                .material(0, engine->getDefaultMaterial()->getDefaultInstance())
+                .culling(false)
+                .build(*engine, triangle);
+        scene->addEntity(triangle);
+    }
+
+    void TearDown(const benchmark::State&) override {
+        if (!engine) {
+            return;
+        }
+        EntityManager& em = EntityManager::get();
+        engine->destroy(triangle);
+        em.destroy(triangle);
+        engine->destroy(vertexBuffer);
+        engine->destroy(indexBuffer);
+        engine->destroyCameraComponent(cameraEntity);
+        em.destroy(cameraEntity);
+        engine->destroy(view);
+        engine->destroy(scene);
+        engine->destroy(renderer);
+        engine->destroy(swapChain);
+        Engine::destroy(&engine);
+    }
+};
+
+BENCHMARK_DEFINE_F(ReadbackFixture, blocking)(benchmark::State& state) {
+    if (!engine) {
+        state.SkipWithError("OpenGL backend not available");
+        return;
+    }
+    std::vector<uint8_t> buffer(PixelReadbackRing::getBufferSize(WIDTH, HEIGHT));
+    for (auto _ : state) {
+        if (renderer->beginFrame(swapChain)) {
+            renderer->render(view);
+            renderer->readPixels(0, 0, WIDTH, HEIGHT, {
+                    buffer.data(), buffer.size(),
+                    backend::PixelDataFormat::RGBA, backend::PixelDataType::UBYTE });
+            renderer->endFrame();
+        }
+        engine->flushAndWait();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_DEFINE_F(ReadbackFixture, ring)(benchmark::State& state) {
+    if (!engine) {
+        state.SkipWithError("OpenGL backend not available");
+        return;
+    }
+    PixelReadbackRing ring(WIDTH, HEIGHT, uint8_t(state.range(0)));
+    int64_t frames = 0;
+    auto drain = [&]() {
+        PixelReadbackRing::Frame frame;
+        while (ring.acquire(&frame)) {
+            benchmark::DoNotOptimize(*static_cast<uint8_t const*>(frame.buffer));
+            ring.release();
+            frames++;
+        }
+    };
+    for (auto _ : state) {
+        if (ring.isFull()) {
+            ring.waitForOldest(*engine);
+            drain();
+        }
+        if (renderer->beginFrame(swapChain)) {
+            renderer->render(view);
+            ring.capture(renderer);
+            renderer->endFrame();
+        }
+        drain();
+    }
+    // the images still in flight are part of the work
+    ring.flush(*engine);
+    drain();
+    state.SetItemsProcessed(frames);
+}
+
+BENCHMARK_REGISTER_F(ReadbackFixture, blocking)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(ReadbackFixture, ring)
+        ->ArgName("depth")
+        ->Arg(1)->Arg(2)->Arg(3)->Arg(4)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
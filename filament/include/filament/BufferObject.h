@@ -102,6 +102,11 @@ public:
      * @param engine Reference to the filament::Engine associated with this BufferObject.
      * @param buffer A BufferDescriptor representing the data used to initialize the BufferObject.
      * @param byteOffset Offset in bytes into the BufferObject
+     *
+     * The callback of the BufferDescriptor is not called as soon as the data is copied: small
+     * updates are staged and their callbacks are batched, so it's only scheduled once the backend
+     * has executed all the commands flushed with this update, e.g. by Renderer::endFrame() or
+     * Engine::flush().
      */
     void setBuffer(Engine& engine, BufferDescriptor&& buffer, uint32_t byteOffset = 0);
 
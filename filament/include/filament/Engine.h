@@ -21,6 +21,9 @@
 
 #include <utils/compiler.h>
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace utils {
 class Entity;
 class EntityManager;
@@ -47,6 +50,7 @@ class Skybox;
 class Stream;
 class SwapChain;
 class Texture;
+class TextureStreamer;
 class VertexBuffer;
 class View;
 
@@ -152,6 +156,65 @@ public:
     using Platform = backend::Platform;
     using Backend = backend::Backend;
 
+    /**
+     * Sizes of the Engine's memory pools and configuration of its worker threads. These can't be
+     * changed once the Engine is created. Fields left to 0 use the defaults this library was
+     * built with (see FILAMENT_PER_RENDER_PASS_ARENA_SIZE_IN_MB and friends in CMakeLists.txt).
+     *
+     * Use Engine::getMemoryStatistics() to find out how much of each pool is actually used.
+     */
+    struct Config {
+        /**
+         * Size in MiB of the command-stream buffer guaranteed to be available after each flush.
+         * Must be large enough to hold the commands of a frame.
+         */
+        uint32_t minCommandBufferSizeMB = 0;
+
+        /**
+         * Total size in MiB of the circular command-stream buffer, 0 defaults to 3 times
+         * minCommandBufferSizeMB. Must be larger than minCommandBufferSizeMB.
+         */
+        uint32_t commandBufferSizeMB = 0;
+
+        /**
+         * Size in MiB of the arena used for the per render pass allocations, which includes the
+         * high-level draw commands (see perFrameCommandsSizeMB) and the froxelization data.
+         */
+        uint32_t perRenderPassArenaSizeMB = 0;
+
+        /**
+         * Size in MiB of the high-level draw commands buffer of a frame, taken from the per render
+         * pass arena. Must be smaller than perRenderPassArenaSizeMB, as a rule of thumb 1 MiB
+         * smaller.
+         */
+        uint32_t perFrameCommandsSizeMB = 0;
+
+        /**
+         * Number of worker threads of the JobSystem, 0 picks a number based on the number of CPUs.
+         * The JobSystem uses at most 32 worker threads.
+         */
+        uint32_t jobSystemThreadCount = 0;
+
+        /**
+         * Bitmask of the CPUs the JobSystem worker threads may run on (only the first 64 CPUs can
+         * be selected). By default each worker is pinned to a different CPU.
+         */
+        uint64_t jobSystemThreadAffinityMask = 0;
+    };
+
+    /**
+     * High watermarks of the Engine's memory pools, in bytes, since the Engine was created.
+     * They are updated as frames are rendered, and are meant to help sizing Engine::Config.
+     */
+    struct MemoryStatistics {
+        size_t commandBufferSize;           //!< size of the command-stream buffer
+        size_t commandBufferHighWatermark;  //!< largest amount of commands pending execution
+        size_t perRenderPassArenaSize;      //!< size of the per render pass arena
+        size_t perRenderPassArenaHighWatermark;  //!< largest amount allocated from that arena
+        size_t perFrameCommandsSize;        //!< size of the draw commands buffer of a frame
+        size_t perFrameCommandsHighWatermark;    //!< largest draw commands buffer usage
+    };
+
     /**
      * Creates an instance of Engine
      *
@@ -175,6 +238,8 @@ public:
      *                          Setting this parameter will force filament to use the OpenGL
      *                          implementation (instead of Vulkan for instance).
      *
+     * @param config            An optional configuration of the Engine's memory pools and worker
+     *                          threads. If nullptr, the default configuration is used.
      *
      * @return A pointer to the newly created Engine, or nullptr if the Engine couldn't be created.
      *
@@ -185,11 +250,15 @@ public:
      * allocate the command buffer. If exceptions are disabled, this condition if fatal and
      * this function will abort.
      *
+     * @exception utils::PreConditionPanic is thrown if the sizes in config are inconsistent.
+     * If exceptions are disabled, this condition is fatal and this function will abort.
+     *
      * \remark
      * This method is thread-safe.
      */
     static Engine* create(Backend backend = Backend::DEFAULT,
-            Platform* platform = nullptr, void* sharedGLContext = nullptr);
+            Platform* platform = nullptr, void* sharedGLContext = nullptr,
+            const Config* config = nullptr);
 
 #if UTILS_HAS_THREADING
     /**
@@ -231,10 +300,14 @@ public:
      *                          when creating filament's internal context.
      *                          Setting this parameter will force filament to use the OpenGL
      *                          implementation (instead of Vulkan for instance).
+     *
+     * @param config            An optional configuration of the Engine's memory pools and worker
+     *                          threads. If nullptr, the default configuration is used.
      */
     static void createAsync(CreateCallback callback, void* user,
             Backend backend = Backend::DEFAULT,
-            Platform* platform = nullptr, void* sharedGLContext = nullptr);
+            Platform* platform = nullptr, void* sharedGLContext = nullptr,
+            const Config* config = nullptr);
 
     /**
      * Retrieve an Engine* from createAsync(). This must be called from the same thread than
@@ -326,6 +399,12 @@ public:
      */
     TransformManager& getTransformManager() noexcept;
 
+    /**
+     * @return TextureStreamer reference
+     * @see TextureStreamer
+     */
+    TextureStreamer& getTextureStreamer() noexcept;
+
     /**
      * Helper to enable accurate translations.
      * If you need this Engine to handle a very large world space, one way to achieve this
@@ -544,6 +623,19 @@ public:
       */
     utils::JobSystem& getJobSystem() noexcept;
 
+    /**
+     * Returns the configuration the Engine was created with, where the fields left to 0 are
+     * replaced by the actual values used.
+     */
+    Config const& getConfig() const noexcept;
+
+    /**
+     * Returns the sizes and high watermarks of the Engine's memory pools.
+     *
+     * This must be called from the same thread the Engine was created on.
+     */
+    MemoryStatistics getMemoryStatistics() const noexcept;
+
     DebugRegistry& getDebugRegistry() noexcept;
 
 protected:
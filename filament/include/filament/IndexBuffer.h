@@ -110,6 +110,11 @@ public:
      *               BufferDescriptor points to raw, untyped data that will be interpreted as
      *               either 16-bit or 32-bits indices based on the Type of this IndexBuffer.
      * @param byteOffset Offset in *bytes* into the IndexBuffer
+     *
+     * The callback of the BufferDescriptor is not called as soon as the data is copied: small
+     * updates are staged and their callbacks are batched, so it's only scheduled once the backend
+     * has executed all the commands flushed with this update, e.g. by Renderer::endFrame() or
+     * Engine::flush().
      */
     void setBuffer(Engine& engine, BufferDescriptor&& buffer, uint32_t byteOffset = 0);
 
@@ -340,6 +340,25 @@ public:
          * enabled. (2cm by default).
          */
         float shadowBulbRadius = 0.02f;
+
+        /**
+         * Whether the cascades of a directional light are fitted to the shadow receivers that
+         * are visible from the camera, rather than to all the shadow receivers of the scene.
+         *
+         * The depth range of the visible receivers replaces the camera's near and far planes
+         * when placing the cascade splits (cascadeSplitPositions become relative to that range),
+         * and the light-space bounds of each cascade only enclose the visible receivers. This is
+         * similar to sample distribution shadow maps (SDSM) and can significantly improve the
+         * shadow resolution when the visible geometry covers only part of the camera's depth
+         * range, or when large receivers are outside of the view.
+         *
+         * The depth range is computed from the bounding boxes of the visible receivers, so the
+         * cascades move with the content of the view, which can make shadows less stable when
+         * the camera moves.
+         *
+         * This is ignored for spot and point lights. (off by default)
+         */
+        bool fitCascadesToVisibleReceivers = false;
     };
 
     struct ShadowCascades {
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_PIXELREADBACKRING_H
+#define TNT_FILAMENT_PIXELREADBACKRING_H
+
+#include <backend/DriverEnums.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class Engine;
+class Renderer;
+class RenderTarget;
+
+/**
+ * PixelReadbackRing reads back one image per frame without stalling the GPU pipeline.
+ *
+ * The ring holds `depth` client buffers. Each call to capture() issues an asynchronous
+ * Renderer::readPixels() into the next free buffer; captured images are then returned by
+ * acquire() in the order they were captured, once their read-back has completed. With a depth
+ * of N, the image captured during frame F is typically available N frames later, which gives
+ * the GPU enough time to finish it without the CPU ever waiting.
+ *
+ * The buffers are either allocated by the ring, or provided by the client, for instance memory
+ * mapped from a video encoder or from shared memory. In the latter case images are written
+ * directly in the client's memory and acquire() never copies them.
+ *
+ * Typical use for offscreen capture:
+ *
+ * ~~~~~~~~~~~{.cpp}
+ *  PixelReadbackRing ring(width, height, 3);
+ *  while (rendering) {
+ *      if (ring.isFull()) {
+ *          ring.waitForOldest(*engine);    // only stalls if the GPU can't keep up
+ *      }
+ *      renderer->beginFrame(swapChain);
+ *      renderer->render(view);
+ *      ring.capture(renderer);
+ *      renderer->endFrame();
+ *
+ *      PixelReadbackRing::Frame frame;
+ *      while (ring.acquire(&frame)) {
+ *          encode(frame.buffer, frame.size);
+ *          ring.release();
+ *      }
+ *  }
+ *  ring.flush(*engine);                    // the last images are still in flight
+ *  // ... acquire() the remaining images
+ * ~~~~~~~~~~~
+ *
+ * Read-back completion is signaled on the main thread when the engine processes its callbacks,
+ * i.e. during Renderer::beginFrame() or Engine::pumpMessageQueues(). All methods must be called
+ * from the main thread.
+ *
+ * A PixelReadbackRing can be destroyed while images are still in flight, however buffers
+ * provided by the client must stay valid until these read-backs have completed, e.g. after
+ * Engine::flushAndWait().
+ */
+class UTILS_PUBLIC PixelReadbackRing {
+public:
+    using PixelDataFormat = backend::PixelDataFormat;
+    using PixelDataType = backend::PixelDataType;
+
+    //! Maximum number of buffers in the ring
+    static constexpr uint8_t MAX_DEPTH = 16;
+
+    struct Frame {
+        void* buffer = nullptr;     //!< image data, rows are ordered from top to bottom
+        size_t size = 0;            //!< size of the image data in bytes
+        uint64_t sequence = 0;      //!< 0-based index of the capture() call that produced it
+    };
+
+    /**
+     * Creates a ring of images of the given size and format.
+     *
+     * @param width     Width of the captured region, in pixels.
+     * @param height    Height of the captured region, in pixels.
+     * @param depth     Number of images in flight, between 1 and MAX_DEPTH.
+     * @param format    Pixel format of the captured images.
+     * @param type      Pixel type of the captured images.
+     * @param buffers   Optional array of `depth` client buffers of at least
+     *                  getBufferSize() bytes each, nullptr to let the ring allocate them.
+     */
+    PixelReadbackRing(uint32_t width, uint32_t height, uint8_t depth,
+            PixelDataFormat format = PixelDataFormat::RGBA,
+            PixelDataType type = PixelDataType::UBYTE,
+            void* const* buffers = nullptr);
+
+    ~PixelReadbackRing() noexcept;
+
+    PixelReadbackRing(PixelReadbackRing const&) = delete;
+    PixelReadbackRing& operator=(PixelReadbackRing const&) = delete;
+
+    /**
+     * Returns the size in bytes of an image of the given size and format.
+     */
+    static size_t getBufferSize(uint32_t width, uint32_t height,
+            PixelDataFormat format = PixelDataFormat::RGBA,
+            PixelDataType type = PixelDataType::UBYTE) noexcept;
+
+    size_t getBufferSize() const noexcept;
+
+    uint8_t getDepth() const noexcept;
+
+    /**
+     * Reads back the region of the swap chain, or of the given render target, starting at
+     * (xoffset, yoffset) into the next free buffer of the ring. Like Renderer::readPixels(), this
+     * must be called within a frame.
+     *
+     * @return false if all buffers are in flight or acquired, in which case nothing is captured.
+     */
+    bool capture(Renderer* renderer, RenderTarget* renderTarget = nullptr,
+            uint32_t xoffset = 0, uint32_t yoffset = 0);
+
+    /**
+     * Returns the oldest captured image if its read-back has completed. Images are always
+     * returned in capture order. The image stays valid until release() is called, and must be
+     * released before the next image can be acquired.
+     *
+     * @return false if no image is ready.
+     */
+    bool acquire(Frame* frame) noexcept;
+
+    /**
+     * Releases the image returned by the last acquire(), its buffer is reused by capture().
+     */
+    void release() noexcept;
+
+    /**
+     * Returns the number of images captured and not released yet.
+     */
+    uint8_t getPendingCount() const noexcept;
+
+    /**
+     * Returns true when capture() would fail.
+     */
+    bool isFull() const noexcept { return getPendingCount() == getDepth(); }
+
+    /**
+     * Blocks until the oldest captured image can be acquired. This is only needed when the
+     * GPU falls behind by more than the depth of the ring. Must be called outside of a frame.
+     */
+    void waitForOldest(Engine& engine);
+
+    /**
+     * Blocks until all captured images can be acquired, typically used after the last frame.
+     * Must be called outside of a frame.
+     */
+    void flush(Engine& engine);
+
+private:
+    struct State;
+    State* mState;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_PIXELREADBACKRING_H
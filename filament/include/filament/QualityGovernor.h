@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_QUALITYGOVERNOR_H
+#define TNT_FILAMENT_QUALITYGOVERNOR_H
+
+#include <filament/Renderer.h>
+
+#include <utils/compiler.h>
+#include <utils/Entity.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+class Engine;
+class View;
+
+/**
+ * QualityGovernor trades rendering quality for frame time, stepping along a ladder of
+ * degradations when frames are over budget, and back up when they are comfortably under.
+ *
+ * Each rung of the ladder degrades one Lever by one step, relative to the quality settings of
+ * the View and of the shadow casting lights when the governor was created or last reset().
+ * For instance, a ladder { SHADOW_MAP_SIZE, AMBIENT_OCCLUSION, SHADOW_MAP_SIZE } first halves
+ * the shadow map sizes, then lowers the SSAO quality, then halves the shadow map sizes again.
+ *
+ * When per-pass timings are available (see Renderer::FrameTimingOptions), stepping down
+ * degrades the lever expected to save the most, e.g. shadows on a device where the shadow
+ * passes dominate; otherwise rungs are taken in ladder order. The saving is a rough estimate,
+ * the cost of the passes a lever affects scaled by the fraction of it one more step is expected
+ * to save (e.g. half the shadow passes for a smaller shadow map, a quarter of the color pass for
+ * fewer MSAA samples). Only the GPU or the CPU times are used, whichever bounds the frame.
+ * Stepping up always undoes the most recent degradation.
+ *
+ * To avoid oscillating, the governor
+ * - only steps down after `downFrameCount` consecutive frames over the target frame time,
+ * - only steps up after `upFrameCount` consecutive frames under `upThreshold` times the target,
+ *   frames in between don't count toward either,
+ * - ignores `settleFrameCount` frames after each change, while timings catch up,
+ * - doubles the number of frames needed to step up each time a step up is quickly followed
+ *   by a step down, up to `maxUpFrameCount`.
+ *
+ * QualityGovernor can be used alongside dynamic resolution, which keeps reacting to the GPU
+ * frame time on its own.
+ *
+ * Typical use:
+ *
+ * ~~~~~~~~~~~{.cpp}
+ *  renderer->setFrameTimingOptions({ .enabled = true, .gpuPassTimings = true });
+ *  QualityGovernor governor(*engine, view);
+ *  governor.setShadowCasters(&sun, 1);
+ *  while (rendering) {
+ *      if (renderer->beginFrame(swapChain)) {
+ *          renderer->render(view);
+ *          renderer->endFrame();
+ *      }
+ *      governor.update(renderer);
+ *  }
+ * ~~~~~~~~~~~
+ *
+ * The governor doesn't own the View or the lights, and doesn't touch them when destroyed;
+ * call restore() first to return to full quality.
+ */
+class UTILS_PUBLIC QualityGovernor {
+public:
+    /**
+     * Settings the governor can degrade, one step per rung of the ladder.
+     */
+    enum class Lever : uint8_t {
+        AMBIENT_OCCLUSION,  //!< lowers the SSAO quality by one level, then disables SSAO
+        SHADOW_MAP_SIZE,    //!< halves the shadow map sizes, down to 256
+        SHADOW_CASCADES,    //!< removes one shadow cascade, down to one
+        BLOOM,              //!< removes one bloom level, down to 3
+        MSAA,               //!< halves the MSAA sample count, then disables MSAA
+        VSM_BLUR,           //!< halves the VSM blur width twice, then disables the blur
+        FROXEL_DENSITY,     //!< halves the froxel density, down to 1/16
+    };
+
+    static constexpr size_t LEVER_COUNT = size_t(Lever::FROXEL_DENSITY) + 1;
+
+    //! Maximum number of rungs in a ladder
+    static constexpr size_t MAX_LADDER_SIZE = 32;
+
+    struct Options {
+        /** frame time to maintain, in milliseconds */
+        float targetFrameTimeMilli = 1000.0f / 60.0f;
+        /** step down when the frame time is above this ratio of the target */
+        float downThreshold = 1.0f;
+        /** step up when the frame time is below this ratio of the target */
+        float upThreshold = 0.8f;
+        /** consecutive frames over budget needed to step down */
+        uint16_t downFrameCount = 4;
+        /** consecutive frames under budget needed to step up */
+        uint16_t upFrameCount = 60;
+        /** frames ignored after each change */
+        uint16_t settleFrameCount = 8;
+        /** maximum of upFrameCount after backing off */
+        uint16_t maxUpFrameCount = 960;
+    };
+
+    /**
+     * Creates a governor for the given View, and captures its current settings as the full
+     * quality settings.
+     *
+     * @param engine        Engine that created the View.
+     * @param view          View whose settings are degraded.
+     * @param options       Control options.
+     * @param ladder        Optional array of `ladderSize` levers, nullptr for the default
+     *                      ladder, which degrades the least noticeable settings first.
+     * @param ladderSize    Number of rungs in `ladder`, at most MAX_LADDER_SIZE.
+     */
+    QualityGovernor(Engine& engine, View* view, Options const& options,
+            Lever const* ladder = nullptr, size_t ladderSize = 0);
+
+    /**
+     * Creates a governor for the given View, with the default options and ladder.
+     */
+    QualityGovernor(Engine& engine, View* view);
+
+    ~QualityGovernor() noexcept;
+
+    QualityGovernor(QualityGovernor const&) = delete;
+    QualityGovernor& operator=(QualityGovernor const&) = delete;
+
+    /**
+     * Sets the lights whose ShadowOptions the SHADOW_MAP_SIZE, SHADOW_CASCADES and VSM_BLUR
+     * levers degrade, and captures their current shadow options. This restores the previous
+     * lights to full quality.
+     */
+    void setShadowCasters(utils::Entity const* lights, size_t count);
+
+    /**
+     * Restores the full quality settings and captures the current settings of the View and
+     * of the shadow casters as the new full quality settings. Call this after changing them.
+     */
+    void reset();
+
+    /**
+     * Restores the full quality settings, the governor then keeps working from there.
+     */
+    void restore();
+
+    /**
+     * Feeds the timings of one frame to the governor, usually the most recent frame returned
+     * by Renderer::getFrameTimings(). The GPU frame time is only used if it is valid.
+     *
+     * @return true if the settings changed
+     */
+    bool update(Renderer::FrameTimings const& timings);
+
+    /**
+     * Feeds the timings of the most recent frame of the given renderer that wasn't seen yet,
+     * preferring frames whose GPU timings are available. Frame timings must be enabled on the
+     * renderer, see Renderer::setFrameTimingOptions().
+     *
+     * @return true if the settings changed
+     */
+    bool update(Renderer const* renderer);
+
+    /**
+     * Returns the number of degradations currently applied, 0 at full quality.
+     */
+    size_t getLevel() const noexcept;
+
+    /**
+     * Returns the number of degradations currently applied to the given lever.
+     */
+    size_t getDegradation(Lever lever) const noexcept;
+
+private:
+    struct State;
+    State* mState;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_QUALITYGOVERNOR_H
@@ -251,6 +251,24 @@ public:
          */
         Builder& screenSpaceContactShadows(bool enable) noexcept;
 
+        /**
+         * Declares that the vertex positions of this renderable are quantized relative to a box,
+         * i.e. that the POSITION attribute is signed normalized and maps to model space as
+         * `bounds.center + position * bounds.halfExtent`. This allows compact position formats
+         * such as normalized SHORT4, see geometry::Transcoder::encodePositions().
+         *
+         * The dequantization is folded into the model matrix given to the shaders, so it has no
+         * runtime cost. Only positions are affected: tangents, the bounding box and the
+         * renderable's transform are still in model space.
+         *
+         * This can't be used with skinning or morphing, which operate on model-space positions,
+         * nor with materials whose vertex domain isn't object, build() fails otherwise. An empty
+         * box, the default, means positions aren't quantized.
+         *
+         * @param bounds Model-space box the positions are quantized in.
+         */
+        Builder& quantizedPositions(const Box& bounds) noexcept;
+
         /**
          * Allows bones to be swapped out and shared using SkinningBuffer.
          *
@@ -438,6 +456,18 @@ public:
      */
     void setScreenSpaceContactShadows(Instance instance, bool enable) noexcept;
 
+    /**
+     * Changes the box the vertex positions are quantized in, this must match the vertex data of
+     * all the primitives. An empty box means positions aren't quantized.
+     *
+     * Nothing changes, and a warning is logged, if the renderable is skinned or morphed, or if
+     * one of its materials isn't in the object vertex domain. Likewise, setMaterialInstanceAt()
+     * ignores such materials when positions are quantized.
+     *
+     * \see Builder::quantizedPositions()
+     */
+    void setQuantizedPositions(Instance instance, const Box& bounds) noexcept;
+
     /**
      * Checks if the renderable can cast shadows.
      *
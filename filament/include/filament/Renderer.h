@@ -28,6 +28,7 @@
 
 #include <math/vec4.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
 namespace filament {
@@ -135,6 +136,151 @@ public:
         bool discard = true;
     };
 
+    /**
+     * Controls how many frames the GPU can run behind the CPU, see LatencyOptions.
+     */
+    enum class LatencyMode : uint8_t {
+        /**
+         * The GPU can run one frame behind the CPU. beginFrame() returns false, to skip the
+         * frame, when the GPU is further behind.
+         */
+        DEFAULT,
+        /**
+         * beginFrame() waits until the GPU has finished the previous frame. Input sampled after
+         * beginFrame() returns is as recent as possible when the frame is displayed, at the cost
+         * of throughput since the CPU and GPU don't overlap.
+         */
+        LOW_LATENCY,
+        /**
+         * Up to LatencyOptions::maxFramesInFlight frames can be in flight, i.e. the GPU can run
+         * up to maxFramesInFlight - 1 frames behind the CPU. beginFrame() waits on a fence when
+         * the GPU is further behind instead of skipping the frame, so every frame is rendered,
+         * e.g. for offscreen batch rendering.
+         */
+        THROUGHPUT,
+    };
+
+    /**
+     * LatencyOptions trade input-to-display latency for throughput.
+     *
+     * In the LOW_LATENCY and THROUGHPUT modes beginFrame() never returns false, it may block
+     * instead. The time spent waiting and the measured input-to-present latency are reported
+     * in FrameTimings.
+     *
+     * @see setLatencyOptions(), FrameTimings
+     */
+    struct LatencyOptions {
+        LatencyMode mode = LatencyMode::DEFAULT;
+        /**
+         * THROUGHPUT mode only: maximum number of frames in flight, counting the frame being
+         * rendered, between 1 and 4. DEFAULT is the same as 2, LOW_LATENCY as 1.
+         */
+        uint8_t maxFramesInFlight = 3;
+    };
+
+    /**
+     * Use FrameTimingOptions to enable the collection of per-frame timings and statistics,
+     * which can be retrieved with getFrameTimings().
+     *
+     * enabled:        collects the CPU time of each stage of the frame and of each FrameGraph
+     *                 pass, as well as the frame statistics (draws, triangles, ...).
+     * gpuPassTimings: additionally measures the GPU time of each FrameGraph pass using timer
+     *                 queries. When enabled, the GPU frame time used for dynamic resolution is
+     *                 the sum of the passes GPU times, because timer queries can't be nested
+     *                 on all backends. Only the first 32 passes of a frame are timed on the GPU,
+     *                 a frame with more passes isn't used for dynamic resolution.
+     *
+     * @see getFrameTimings()
+     */
+    struct FrameTimingOptions {
+        bool enabled = false;           //!< collect CPU timings and statistics
+        bool gpuPassTimings = false;    //!< collect the GPU time of each FrameGraph pass
+    };
+
+    /**
+     * Stages of a frame for which the CPU time is measured, see FrameTimings.
+     */
+    enum class FrameStage : uint8_t {
+        SCENE_PREPARE,          //!< gathering of the scene's renderables and lights
+        CULLING,                //!< renderables, lights and shadow casters culling
+        UBO_UPDATE,             //!< per-renderable uniform buffer update
+        FROXELIZATION,          //!< lights froxelization (runs concurrently with other stages)
+        COMMAND_GENERATION,     //!< color pass commands generation
+        COMMAND_SORT,           //!< color pass commands sort
+        FRAME_GRAPH_COMPILE,    //!< FrameGraph compilation
+        FRAME_GRAPH_EXECUTE,    //!< FrameGraph execution, i.e. all the passes below
+    };
+
+    static constexpr size_t FRAME_STAGE_COUNT = size_t(FrameStage::FRAME_GRAPH_EXECUTE) + 1;
+
+    /**
+     * Timings of a single FrameGraph pass.
+     */
+    struct PassTiming {
+        /** name of the pass, this is a static string owned by filament */
+        const char* name = nullptr;
+        /** CPU time spent recording this pass, in nanoseconds */
+        uint64_t cpuTimeNanos = 0;
+        /** GPU time of this pass in nanoseconds, 0 if not available */
+        uint64_t gpuTimeNanos = 0;
+    };
+
+    /**
+     * Timings and statistics of a frame, see getFrameTimings().
+     *
+     * All values are summed over all the render() calls of the frame. GPU timings are only
+     * available a few frames later, gpuTimingsValid is false until then.
+     */
+    struct FrameTimings {
+        static constexpr size_t MAX_PASS_COUNT = 64;
+
+        /** identifier of this frame, increases by one every frame */
+        uint32_t frameId = 0;
+        /** whether the gpu times of the passes and the frame are available */
+        bool gpuTimingsValid = false;
+        /** CPU time between beginFrame() and endFrame(), in nanoseconds */
+        uint64_t cpuFrameTimeNanos = 0;
+        /** GPU time of the frame (sum of the passes' GPU time), in nanoseconds */
+        uint64_t gpuFrameTimeNanos = 0;
+        /** CPU time of each FrameStage, in nanoseconds */
+        uint64_t stageCpuTimeNanos[FRAME_STAGE_COUNT] = {};
+
+        /** number of valid entries in passes */
+        uint32_t passCount = 0;
+        /** timings of each executed FrameGraph pass, in execution order */
+        PassTiming passes[MAX_PASS_COUNT];
+
+        /** draw calls issued by the renderable passes (color, depth, shadows, ...) */
+        uint32_t drawCount = 0;
+        /** triangles drawn by the renderable passes */
+        uint32_t triangleCount = 0;
+        /** program or material instance changes between draw calls */
+        uint32_t stateChangeCount = 0;
+        /** bytes uploaded to buffer objects and textures since the previous frame */
+        uint64_t uploadedBytes = 0;
+
+        /** time beginFrame() waited for the GPU, in nanoseconds, see LatencyMode */
+        uint64_t gpuWaitNanos = 0;
+        /** whether inputToPresentNanos is available, this happens a few frames later */
+        bool latencyValid = false;
+        /**
+         * Time from the end of beginFrame(), i.e. when input for this frame is typically
+         * sampled, to when the renderer first saw that the GPU finished executing the frame's
+         * commands, in nanoseconds.
+         *
+         * The time the frame then waits to be displayed (swap chain queue, compositor, vsync)
+         * isn't included, it can't be observed by the renderer. The GPU completion is checked
+         * at each beginFrame() and while it waits for the GPU, so the value is rounded up to
+         * the next of these checks.
+         */
+        uint64_t inputToPresentNanos = 0;
+    };
+
+    /**
+     * Maximum number of frames returned by getFrameTimings()
+     */
+    static constexpr size_t FRAME_TIMINGS_HISTORY_SIZE = 8;
+
     /**
      * Information about the display this Renderer is associated to. This information is needed
      * to accurately compute dynamic-resolution scaling and for frame-pacing.
@@ -152,6 +298,36 @@ public:
      */
     void setClearOptions(const ClearOptions& options);
 
+    /**
+     * Set options controlling the latency between the CPU and the GPU.
+     *
+     * @see LatencyOptions
+     */
+    void setLatencyOptions(LatencyOptions const& options) noexcept;
+
+    /**
+     * Returns the options set with setLatencyOptions().
+     */
+    LatencyOptions const& getLatencyOptions() const noexcept;
+
+    /**
+     * Set options controlling the collection of frame timings.
+     *
+     * @see getFrameTimings()
+     */
+    void setFrameTimingOptions(FrameTimingOptions const& options) noexcept;
+
+    /**
+     * Retrieves the timings of the most recent frames, most recent first. Frame timings must
+     * be enabled with setFrameTimingOptions(). A frame's timings become available after its
+     * endFrame() call, its GPU timings a few frames later.
+     *
+     * @param out   array of at least `count` FrameTimings to receive the timings
+     * @param count maximum number of frames to retrieve
+     * @return number of frames written in `out`, at most FRAME_TIMINGS_HISTORY_SIZE
+     */
+    size_t getFrameTimings(FrameTimings* out, size_t count) const noexcept;
+
     /**
      * Get the Engine that created this Renderer.
      *
@@ -299,6 +475,26 @@ public:
      */
     void render(View const* view);
 
+    /**
+     * Renders several Views, this is equivalent to calling render() on each of them in order,
+     * but it is more efficient when rendering many Views, e.g. thumbnails or the faces of a
+     * cube map, typically each with its own RenderTarget.
+     *
+     * Only renderable culling runs concurrently across Views: the renderables of all the Views
+     * are culled ahead of time, one job per View. The rest of the work, including the
+     * preparation of the Scene, froxelization and the generation of the rendering commands, is
+     * still done one View at a time in the order of the array, each using the JobSystem
+     * internally like render() does. Views sharing a Scene, like several cameras looking at the
+     * same Scene, benefit the most.
+     *
+     * @param views Array of `count` Views to render, null entries are ignored.
+     * @param count Number of Views in the array.
+     *
+     * @see
+     * render()
+     */
+    void renderViews(View const* const* views, size_t count);
+
     /**
      * Copy the currently rendered view to the indicated swap chain, using the
      * indicated source and destination rectangle.
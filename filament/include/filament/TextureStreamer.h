@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//! \file
+
+#ifndef TNT_FILAMENT_TEXTURESTREAMER_H
+#define TNT_FILAMENT_TEXTURESTREAMER_H
+
+#include <filament/FilamentAPI.h>
+#include <filament/Texture.h>
+
+#include <utils/compiler.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/**
+ * TextureStreamer keeps only the mip levels that are needed in GPU memory, for textures whose
+ * full mip chains don't fit, e.g. when a scene has more texture data than the device has memory.
+ *
+ * A streamed texture is created from a TextureStreamer::Source, which reads mip levels on demand.
+ * Its smallest levels, up to Config::residentSize, are loaded when the texture is created and
+ * always stay resident. Larger levels are loaded in the background, on the streamer's own
+ * thread, when the renderables using the texture cover enough pixels on screen to need them.
+ * When streamed textures exceed Config::budget, the levels of the textures that haven't been
+ * seen for the longest time, then of the most oversampled textures, are evicted first.
+ *
+ * The screen footprint of a texture is estimated from the world-space bounding boxes of the
+ * visible renderables whose MaterialInstance samples it, assuming the texture covers each
+ * renderable once. Textures that are tiled, or that cover a small part of a renderable, can be
+ * made sharper with Config::lodBias.
+ *
+ * The levels each texture needs are picked once per frame, in Renderer::beginFrame(), from the
+ * footprints of the views rendered since the previous frame, including standalone views.
+ *
+ * Streamed textures are regular 2D textures: they're destroyed with Engine::destroy(), and they
+ * can be set on any MaterialInstance. Texture::setImage() can't be used on them, and because
+ * their GPU storage is reallocated as their resident levels change, they must be set on material
+ * instances with MaterialInstance::setParameter() rather than through their backend handle.
+ *
+ * ~~~~~~~~~~~{.cpp}
+ *  TextureStreamer& streamer = engine->getTextureStreamer();
+ *  streamer.setConfig({ .budget = 1024u * 1024u * 1024u });
+ *  Texture* texture = streamer.createTexture(new image::ktx::KtxTextureSource("bricks.ktx"));
+ *  materialInstance->setParameter("baseColor", texture, sampler);
+ * ~~~~~~~~~~~
+ *
+ * @see image::ktx::KtxTextureSource
+ */
+class UTILS_PUBLIC TextureStreamer : public FilamentAPI {
+public:
+    /**
+     * Provides the content of a streamed texture, one mip level at a time.
+     */
+    class Source {
+    public:
+        struct Info {
+            uint32_t width = 1;         //!< width of level 0, in texels
+            uint32_t height = 1;        //!< height of level 0, in texels
+            uint8_t levels = 1;         //!< number of mip levels the source can load
+            Texture::InternalFormat format = Texture::InternalFormat::RGBA8;
+        };
+
+        virtual ~Source() noexcept = default;
+
+        /**
+         * Returns the description of the texture, called once when the texture is created.
+         */
+        virtual Info getInfo() const noexcept = 0;
+
+        /**
+         * Loads a whole mip level. This is called from the streamer's loading thread, except
+         * for the always resident levels, which are loaded by TextureStreamer::createTexture().
+         * It's never called concurrently for the same source, and blocking I/O is expected.
+         *
+         * Each time the resident levels of a texture change, evictions included, all the levels
+         * of the new GPU allocation are loaded again, including the ones that were already
+         * resident: the backends can't copy mip levels between textures of any format. Sources
+         * that read from slow storage may want to keep the smaller levels in memory.
+         *
+         * @param level     Mip level to load.
+         * @param buffer    Receives the content of the level, its callback is called once the
+         *                  data has been uploaded.
+         * @return false if the level couldn't be loaded, the texture then stays at lower levels.
+         */
+        virtual bool load(size_t level, Texture::PixelBufferDescriptor* buffer) noexcept = 0;
+    };
+
+    struct Config {
+        /** GPU memory the streamed mip levels may use, in bytes */
+        size_t budget = 512u * 1024u * 1024u;
+        /** mip levels of this size and smaller are loaded up front and never evicted */
+        uint32_t residentSize = 64;
+        /** added to the mip level picked from the screen footprint, negative is sharper */
+        float lodBias = 0.0f;
+        /** maximum number of textures being loaded at once, each holds two GPU allocations */
+        uint8_t maxPendingTextures = 4;
+    };
+
+    /**
+     * Sets the streaming configuration, it takes effect on the next frame.
+     */
+    void setConfig(Config const& config) noexcept;
+
+    /**
+     * Returns the streaming configuration.
+     */
+    Config const& getConfig() const noexcept;
+
+    /**
+     * Creates a streamed 2D texture, and loads its always resident levels.
+     *
+     * @param source    Source of the mip levels. The streamer takes ownership of the source and
+     *                  destroys it after the texture is destroyed, from its loading thread.
+     * @return the new texture, or nullptr if the source's Info is invalid or its resident levels
+     *         couldn't be loaded, the source is then destroyed.
+     */
+    Texture* createTexture(Source* source);
+
+    /**
+     * Returns the most detailed mip level of a streamed texture currently in GPU memory, or 0 if
+     * the texture isn't streamed.
+     */
+    size_t getResidentLevel(Texture const* texture) const noexcept;
+
+    /**
+     * Returns the GPU memory used by the resident levels of all streamed textures, in bytes.
+     * This doesn't include the levels being loaded.
+     */
+    size_t getResidentSize() const noexcept;
+
+    /**
+     * Returns the number of textures whose levels are being loaded.
+     */
+    size_t getPendingCount() const noexcept;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_TEXTURESTREAMER_H
@@ -179,6 +179,11 @@ public:
      *               be copied as-is into the buffer.
      * @param byteOffset Offset in *bytes* into the buffer at index \p bufferIndex of this vertex
      *                   buffer set.
+     *
+     * The callback of the BufferDescriptor is not called as soon as the data is copied: small
+     * updates are staged and their callbacks are batched, so it's only scheduled once the backend
+     * has executed all the commands flushed with this update, e.g. by Renderer::endFrame() or
+     * Engine::flush().
      */
     void setBufferAt(Engine& engine, uint8_t bufferIndex, BufferDescriptor&& buffer,
             uint32_t byteOffset = 0);
@@ -516,6 +516,22 @@ public:
      */
     void setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept;
 
+    /**
+     * Scales the number of froxels used to cull dynamic lights. Fewer froxels reduce the CPU
+     * cost of froxelization and the size of the froxel data uploaded each frame, at the expense
+     * of more lights being evaluated per fragment.
+     *
+     * @param density Between 1/16 and 1, the number of froxels relative to the default. (Default 1)
+     *
+     * @see QualityGovernor
+     */
+    void setFroxelDensity(float density) noexcept;
+
+    /**
+     * Returns the froxel density set by setFroxelDensity().
+     */
+    float getFroxelDensity() const noexcept;
+
     /*
      * Set the shadow mapping technique this View uses.
      *
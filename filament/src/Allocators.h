@@ -31,6 +31,8 @@
 
 namespace filament {
 
+// Defaults of the Engine::Config pool sizes.
+
 // per render pass allocations
 // Froxelization needs about 1 MiB. Command buffer needs about 1 MiB.
 static constexpr size_t CONFIG_PER_RENDER_PASS_ARENA_SIZE  = FILAMENT_PER_RENDER_PASS_ARENA_SIZE_IN_MB * 1024 * 1024;
@@ -64,9 +66,11 @@ using HeapAllocatorArena = utils::Arena<
         utils::HeapAllocator,
         utils::LockingPolicy::NoLock>;
 
+// the high watermark is cheap to track and is reported by Engine::getMemoryStatistics()
 using LinearAllocatorArena = utils::Arena<
         utils::LinearAllocator,
-        utils::LockingPolicy::NoLock>;
+        utils::LockingPolicy::NoLock,
+        utils::TrackingPolicy::HighWatermark>;
 
 #endif
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AtlasAllocator.h"
+
+#include <utils/debug.h>
+
+#include <algorithm>
+
+namespace filament {
+
+AtlasAllocator::AtlasAllocator(size_t maxLayerCount)
+        : mNodes(maxLayerCount * NODE_COUNT, Node::FREE),
+          mMaxLayerCount(maxLayerCount) {
+}
+
+void AtlasAllocator::clear() noexcept {
+    std::fill(mNodes.begin(), mNodes.end(), Node::FREE);
+    mLayerCount = 0;
+}
+
+bool AtlasAllocator::allocate(uint8_t level, Allocation* allocation) noexcept {
+    assert_invariant(level <= MAX_LEVEL);
+    for (size_t layer = 0; layer < mMaxLayerCount; layer++) {
+        size_t index;
+        if (allocate(mNodes.data() + layer * NODE_COUNT, 0, 0, level, &index)) {
+            // the index of a node interleaves the position of its ancestors, from the root
+            // (highest bits) to the node itself (lowest bits)
+            uint16_t x = 0;
+            uint16_t y = 0;
+            for (size_t l = 0; l < level; l++) {
+                const size_t child = (index >> (2u * l)) & 0x3u;
+                x |= uint16_t((child & 0x1u) << l);
+                y |= uint16_t((child >> 1u) << l);
+            }
+            allocation->layer = uint8_t(layer);
+            allocation->level = level;
+            allocation->position = { x, y };
+            mLayerCount = std::max(mLayerCount, layer + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AtlasAllocator::free(Allocation const& allocation) noexcept {
+    assert_invariant(allocation.layer < mMaxLayerCount);
+    assert_invariant(allocation.level <= MAX_LEVEL);
+    Node* const nodes = mNodes.data() + allocation.layer * NODE_COUNT;
+
+    // the reverse of the mapping in allocate()
+    size_t index = 0;
+    for (size_t l = 0; l < allocation.level; l++) {
+        const size_t x = (allocation.position.x >> l) & 0x1u;
+        const size_t y = (allocation.position.y >> l) & 0x1u;
+        index |= (x | (y << 1u)) << (2u * l);
+    }
+
+    size_t level = allocation.level;
+    assert_invariant(nodes[offset(level) + index] == Node::ALLOCATED);
+    nodes[offset(level) + index] = Node::FREE;
+
+    // a node whose children are all free is free again
+    while (level > 0) {
+        const size_t first = offset(level) + (index & ~size_t(0x3u));
+        if (nodes[first] != Node::FREE || nodes[first + 1] != Node::FREE ||
+            nodes[first + 2] != Node::FREE || nodes[first + 3] != Node::FREE) {
+            break;
+        }
+        level--;
+        index >>= 2u;
+        nodes[offset(level) + index] = Node::FREE;
+    }
+
+    while (mLayerCount > 0 && mNodes[(mLayerCount - 1) * NODE_COUNT] == Node::FREE) {
+        mLayerCount--;
+    }
+}
+
+bool AtlasAllocator::allocate(Node* nodes, size_t level, size_t index, size_t target,
+        size_t* result) noexcept {
+    Node& node = nodes[offset(level) + index];
+    if (node == Node::ALLOCATED) {
+        return false;
+    }
+    if (level == target) {
+        if (node != Node::FREE) {
+            return false;
+        }
+        node = Node::ALLOCATED;
+        *result = index;
+        return true;
+    }
+    // children of a free node are all free, so this always succeeds in the first child
+    node = Node::SPLIT;
+    for (size_t child = 0; child < 4; child++) {
+        if (allocate(nodes, level + 1, index * 4 + child, target, result)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace filament
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_ATLASALLOCATOR_H
+#define TNT_FILAMENT_ATLASALLOCATOR_H
+
+#include <utils/FixedCapacityVector.h>
+
+#include <math/vec2.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * AtlasAllocator packs square tiles into the layers of an array texture.
+ *
+ * Each layer is a quadtree: a tile of level L is 1/2^L the size of the layer in each dimension,
+ * and is placed at a multiple of its size. Tiles are allocated first-fit, in the first layer
+ * that has room; allocating tiles from the largest to the smallest leaves no holes.
+ * Tiles can be freed individually, which lets an atlas be updated from one frame to the next.
+ */
+class AtlasAllocator {
+public:
+    // Smallest tiles are 1/2^MAX_LEVEL the size of a layer
+    static constexpr size_t MAX_LEVEL = 4;
+
+    struct Allocation {
+        uint8_t layer = 0;
+        uint8_t level = 0;
+        math::ushort2 position{};   // in units of the tile size, i.e. of 1/2^level of the layer
+    };
+
+    explicit AtlasAllocator(size_t maxLayerCount);
+
+    // Allocates a tile of the given level, returns false if no layer has room for it.
+    bool allocate(uint8_t level, Allocation* allocation) noexcept;
+
+    // Frees a tile, which can then be allocated again, in full or in smaller tiles.
+    void free(Allocation const& allocation) noexcept;
+
+    // Frees all the tiles.
+    void clear() noexcept;
+
+    // Number of layers that have at least one tile
+    size_t getLayerCount() const noexcept { return mLayerCount; }
+
+    size_t getMaxLayerCount() const noexcept { return mMaxLayerCount; }
+
+private:
+    enum class Node : uint8_t {
+        FREE,       // neither this node nor its children are allocated
+        SPLIT,      // some of the children are allocated
+        ALLOCATED   // this node is allocated
+    };
+
+    // index of the first node of a level, in a layer
+    static constexpr size_t offset(size_t level) noexcept {
+        return ((size_t(1) << (2u * level)) - 1u) / 3u;
+    }
+
+    // nodes in a layer, i.e. offset(MAX_LEVEL + 1)
+    static constexpr size_t NODE_COUNT = ((size_t(1) << (2u * (MAX_LEVEL + 1u))) - 1u) / 3u;
+
+    static bool allocate(Node* nodes, size_t level, size_t index, size_t target,
+            size_t* result) noexcept;
+
+    utils::FixedCapacityVector<Node> mNodes;
+    size_t mMaxLayerCount;
+    size_t mLayerCount = 0;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_ATLASALLOCATOR_H
@@ -64,6 +64,7 @@ void FBufferObject::terminate(FEngine& engine) {
 }
 
 void FBufferObject::setBuffer(FEngine& engine, BufferDescriptor&& buffer, uint32_t byteOffset) {
+    engine.getFrameStatistics().uploadedBytes += buffer.size;
     engine.getDriverApi().updateBufferObject(mHandle, std::move(buffer), byteOffset);
 }
 
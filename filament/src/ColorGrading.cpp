@@ -21,6 +21,7 @@
 
 #include "FilamentAPI-impl.h"
 
+#include "ColorGradingLutCache.h"
 #include "ColorSpace.h"
 
 #include <math/vec2.h>
@@ -31,6 +32,9 @@
 #include <utils/SpinLock.h>
 #include <utils/Systrace.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include <math.h>
 #include <stdlib.h>
 
@@ -53,6 +57,8 @@ struct ColorGrading::BuilderDetails {
 #pragma clang diagnostic pop
 
     bool hasAdjustments = false;
+    // whether toneMapper was created from toneMapping
+    bool defaultToneMapper = false;
 
     // Everything below must be part of the == comparison operator
     LutFormat format = LutFormat::INTEGER;
@@ -284,11 +290,13 @@ ColorGrading* ColorGrading::Builder::build(Engine& engine) {
         }
     }
 
+    mImpl->defaultToneMapper = needToneMapper;
     FColorGrading* colorGrading = upcast(engine).createColorGrading(*this);
 
     if (needToneMapper) {
         delete mImpl->toneMapper;
         mImpl->toneMapper = nullptr;
+        mImpl->defaultToneMapper = false;
     }
 
     return colorGrading;
@@ -615,217 +623,410 @@ struct Config {
     mat3f  colorGradingIn;
     mat3f  colorGradingOut;
     float3 colorGradingLuminance;
+
+    // Parameters copied from the builder
+    bool   hasAdjustments;
+    bool   luminanceScaling;
+    bool   gamutMapping;
+    float  exposure;
+    float  nightAdaptation;
+    float3 outRed;
+    float3 outGreen;
+    float3 outBlue;
+    float3 shadows;
+    float3 midtones;
+    float3 highlights;
+    float4 tonalRanges;
+    float3 slope;
+    float3 offset;
+    float3 power;
+    float  contrast;
+    float  vibrance;
+    float  saturation;
+    float3 shadowGamma;
+    float3 midPoint;
+    float3 highlightScale;
+    const ToneMapper* toneMapper;
+
+    // First stage that needs to be computed, the previous ones are retained by the cache
+    size_t firstStage;
+    float3* inputStage;         // output of the INPUT stage, dimension^3 texels
+    float3* gradingStage;       // output of the GRADING stage, dimension^3 texels
+    void* lut;                  // half4 or packed UINT_2_10_10_10_REV texels
+    bool packed;
 };
 
-// Inside the FColorGrading constructor, TSAN sporadically detects a data race on the config struct;
-// the Filament thread writes and the Job thread reads. In practice there should be no data race, so
-// we force TSAN off to silence the warning.
-UTILS_NO_SANITIZE_THREAD
-FColorGrading::FColorGrading(FEngine& engine, const Builder& builder) {
-    SYSTRACE_CALL();
+// The LUT is generated one row at a time and each stage below processes a whole row before the
+// next stage starts. This keeps the configuration tests out of the inner loops.
 
-    DriverApi& driver = engine.getDriverApi();
+// Maximum value accepted by ColorGrading::Builder::dimensions()
+static constexpr size_t MAX_LUT_DIMENSION = 64;
 
-    Config c;
-    // This lock protects the data inside Config, which is written to by the Filament thread,
-    // and read from multiple Job threads.
-    utils::SpinLock configLock;
-    {
-        std::lock_guard<utils::SpinLock> lock(configLock);
-        c.lutDimension          = builder->dimension;
-        c.adaptationTransform   = adaptationTransform(builder->whiteBalance);
-        c.colorGradingIn        = selectColorGradingTransformIn(builder->toneMapping);
-        c.colorGradingOut       = selectColorGradingTransformOut(builder->toneMapping);
-        c.colorGradingLuminance = selectColorGradingLuminance(builder->toneMapping);
-    }
+// LogC decoding, exposure, night adaptation and white balance
+static void inputStage(float3* UTILS_RESTRICT v, size_t g, size_t b, Config const& c) noexcept {
+    const size_t dim = c.lutDimension;
+    const float scale = 1.0f / float(dim - 1u);
 
-    mDimension = c.lutDimension;
+    for (size_t r = 0; r < dim; r++) {
+        // LogC encoding
+        float3 t = LogC_to_linear(float3{ r, g, b } * scale);
+        // Kill negative values near 0.0f due to imprecision in the log conversion
+        v[r] = max(t, 0.0f);
+    }
 
-    size_t lutElementCount = c.lutDimension * c.lutDimension * c.lutDimension;
-    size_t elementSize = sizeof(half4);
-    void* data = malloc(lutElementCount * elementSize);
+    if (c.hasAdjustments) {
+        const float exposure = c.exposure;
+        const float nightAdaptation = c.nightAdaptation;
+        for (size_t r = 0; r < dim; r++) {
+            // Exposure
+            float3 t = adjustExposure(v[r], exposure);
+            // Purkinje shift ("low-light" vision)
+            v[r] = scotopicAdaptation(t, nightAdaptation);
+        }
+    }
 
-    TextureFormat textureFormat;
-    PixelDataFormat format;
-    PixelDataType type;
-    selectLutTextureParams(builder->format, textureFormat, format, type);
-    assert_invariant(FTexture::validatePixelFormatAndType(textureFormat, format, type));
+    // Move to color grading color space
+    const mat3f colorGradingIn = c.colorGradingIn;
+    for (size_t r = 0; r < dim; r++) {
+        v[r] = colorGradingIn * v[r];
+    }
 
-    void* converted = nullptr;
-    if (type == PixelDataType::UINT_2_10_10_10_REV) {
-        // convert input to UINT_2_10_10_10_REV if needed
-        converted = malloc(lutElementCount * sizeof(uint32_t));
+    if (c.hasAdjustments) {
+        const mat3f adaptation = c.adaptationTransform;
+        for (size_t r = 0; r < dim; r++) {
+            // White balance
+            float3 t = chromaticAdaptation(v[r], adaptation);
+            // Kill negative values before the next transforms
+            v[r] = max(t, 0.0f);
+        }
     }
+}
 
-    //auto now = std::chrono::steady_clock::now();
+// Channel mixer, tonal ranges, ASC CDL, contrast, vibrance, saturation and curves
+static void gradingStage(float3* UTILS_RESTRICT v, size_t count, Config const& c) noexcept {
+    const float3 luminance = c.colorGradingLuminance;
 
-    // Multithreadedly generate the tone mapping 3D look-up table using 32 jobs
-    // Slices are 8 KiB (128 cache lines) apart.
-    // This takes about 3-6ms on Android in Release
-    JobSystem& js = engine.getJobSystem();
-    auto *slices = js.createJob();
-    for (size_t b = 0; b < c.lutDimension; b++) {
-        auto *job = js.createJob(slices,
-                [data, converted, b, &c, &configLock, builder](JobSystem&, JobSystem::Job*) {
-            Config config;
-            {
-                std::lock_guard<utils::SpinLock> lock(configLock);
-                config = c;
-            }
-            half4* UTILS_RESTRICT p = (half4*) data + b * config.lutDimension * config.lutDimension;
-            for (size_t g = 0; g < config.lutDimension; g++) {
-                for (size_t r = 0; r < config.lutDimension; r++) {
-                    float3 v = float3{r, g, b} * (1.0f / float(config.lutDimension - 1u));
+    for (size_t i = 0; i < count; i++) {
+        // Channel mixer
+        float3 t = channelMixer(v[i], c.outRed, c.outGreen, c.outBlue);
 
-                    // LogC encoding
-                    v = LogC_to_linear(v);
+        // Shadows/mid-tones/highlights
+        t = tonalRanges(t, luminance, c.shadows, c.midtones, c.highlights, c.tonalRanges);
 
-                    // Kill negative values near 0.0f due to imprecision in the log conversion
-                    v = max(v, 0.0f);
+        // The adjustments below behave better in log space
+        t = linear_to_LogC(t);
 
-                    if (builder->hasAdjustments) {
-                        // Exposure
-                        v = adjustExposure(v, builder->exposure);
+        // ASC CDL
+        t = colorDecisionList(t, c.slope, c.offset, c.power);
 
-                        // Purkinje shift ("low-light" vision)
-                        v = scotopicAdaptation(v, builder->nightAdaptation);
-                    }
+        // Contrast in log space
+        t = contrast(t, c.contrast);
 
-                    // Move to color grading color space
-                    v = c.colorGradingIn * v;
+        // Back to linear space
+        v[i] = LogC_to_linear(t);
+    }
 
-                    if (builder->hasAdjustments) {
-                        // White balance
-                        v = chromaticAdaptation(v, config.adaptationTransform);
+    for (size_t i = 0; i < count; i++) {
+        // Vibrance in linear space
+        float3 t = vibrance(v[i], luminance, c.vibrance);
 
-                        // Kill negative values before the next transforms
-                        v = max(v, 0.0f);
+        // Saturation in linear space
+        t = saturation(t, luminance, c.saturation);
 
-                        // Channel mixer
-                        v = channelMixer(v, builder->outRed, builder->outGreen, builder->outBlue);
+        // Kill negative values before curves
+        t = max(t, 0.0f);
 
-                        // Shadows/mid-tones/highlights
-                        v = tonalRanges(v, c.colorGradingLuminance,
-                                builder->shadows, builder->midtones, builder->highlights,
-                                builder->tonalRanges);
+        // RGB curves
+        v[i] = curves(t, c.shadowGamma, c.midPoint, c.highlightScale);
+    }
+}
 
-                        // The adjustments below behave better in log space
-                        v = linear_to_LogC(v);
+// Tone mapping, gamut mapping and OETF
+static void outputStage(float3* UTILS_RESTRICT v, size_t count, Config const& c) noexcept {
+    // Tone mapping, this is a virtual call
+    const ToneMapper& toneMapper = *c.toneMapper;
+    if (c.luminanceScaling) {
+        for (size_t i = 0; i < count; i++) {
+            v[i] = luminanceScaling(v[i], toneMapper, c.colorGradingLuminance);
+        }
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            v[i] = toneMapper(v[i]);
+        }
+    }
 
-                        // ASC CDL
-                        v = colorDecisionList(v, builder->slope, builder->offset, builder->power);
+    // Go back to display color space
+    const mat3f colorGradingOut = c.colorGradingOut;
+    for (size_t i = 0; i < count; i++) {
+        v[i] = colorGradingOut * v[i];
+    }
 
-                        // Contrast in log space
-                        v = contrast(v, builder->contrast);
+    // Apply gamut mapping
+    if (c.gamutMapping) {
+        for (size_t i = 0; i < count; i++) {
+            // TODO: This should depend on the output color space
+            v[i] = gamutMapping_sRGB(v[i]);
+        }
+    }
 
-                        // Back to linear space
-                        v = LogC_to_linear(v);
+    // TODO: We should convert to the output color space if we use a working
+    //       color space that's not sRGB
+    // TODO: Allow the user to customize the output color space
 
-                        // Vibrance in linear space
-                        v = vibrance(v, c.colorGradingLuminance, builder->vibrance);
+    for (size_t i = 0; i < count; i++) {
+        // We need to clamp for the output transfer function, then apply the OETF
+        v[i] = OETF_sRGB(saturate(v[i]));
+    }
+}
 
-                        // Saturation in linear space
-                        v = saturation(v, c.colorGradingLuminance, builder->saturation);
+static void storeRow(half4* UTILS_RESTRICT dst, float3 const* UTILS_RESTRICT v,
+        size_t count) noexcept {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = half4{ v[i], 0.0f };
+    }
+}
 
-                        // Kill negative values before curves
-                        v = max(v, 0.0f);
+static void storeRow(uint32_t* UTILS_RESTRICT dst, float3 const* UTILS_RESTRICT v,
+        size_t count) noexcept {
+    // we use a vectorize width of 8 because, on ARMv8 it allows the compiler to write eight
+    // 32-bits results in one go.
+    #pragma clang loop vectorize_width(8)
+    for (size_t i = 0; i < count; i++) {
+        uint32_t pr = uint32_t(std::floor(v[i].x * 1023.0f + 0.5f));
+        uint32_t pg = uint32_t(std::floor(v[i].y * 1023.0f + 0.5f));
+        uint32_t pb = uint32_t(std::floor(v[i].z * 1023.0f + 0.5f));
+        dst[i] = (pb << 20u) | (pg << 10u) | pr;
+    }
+}
 
-                        // RGB curves
-                        v = curves(v,
-                                builder->shadowGamma, builder->midPoint, builder->highlightScale);
-                    }
+static void generateSlice(size_t b, Config const& c) noexcept {
+    const size_t dim = c.lutDimension;
+    float3 row[MAX_LUT_DIMENSION];
+    for (size_t g = 0; g < dim; g++) {
+        const size_t offset = (b * dim + g) * dim;
 
-                    // Tone mapping
-                    if (builder->luminanceScaling) {
-                        v = luminanceScaling(v, *builder->toneMapper, c.colorGradingLuminance);
-                    } else {
-                        v = (*builder->toneMapper)(v);
-                    }
+        float3* UTILS_RESTRICT input = c.inputStage + offset;
+        if (c.firstStage <= size_t(ColorGradingLutCache::Stage::INPUT)) {
+            inputStage(input, g, b, c);
+        }
 
-                    // Go back to display color space
-                    v = c.colorGradingOut * v;
+        float3 const* last = input;
+        if (c.hasAdjustments) {
+            float3* UTILS_RESTRICT grading = c.gradingStage + offset;
+            if (c.firstStage <= size_t(ColorGradingLutCache::Stage::GRADING)) {
+                std::copy_n(input, dim, grading);
+                gradingStage(grading, dim, c);
+            }
+            last = grading;
+        }
 
-                    // Apply gamut mapping
-                    if (builder->gamutMapping) {
-                        // TODO: This should depend on the output color space
-                        v = gamutMapping_sRGB(v);
-                    }
+        std::copy_n(last, dim, row);
+        outputStage(row, dim, c);
 
-                    // TODO: We should convert to the output color space if we use a working
-                    //       color space that's not sRGB
-                    // TODO: Allow the user to customize the output color space
+        if (c.packed) {
+            storeRow(static_cast<uint32_t*>(c.lut) + offset, row, dim);
+        } else {
+            storeRow(static_cast<half4*>(c.lut) + offset, row, dim);
+        }
+    }
+}
 
-                    // We need to clamp for the output transfer function
-                    v = saturate(v);
+// The parameters that don't affect the LUT are left to 0, so that such LUTs are shared.
+ColorGradingLutCache::Key FColorGrading::makeLutKey(const Builder& builder) noexcept {
+    ColorGradingLutCache::Key key;
+    key.input.dimension = builder->dimension;
+    key.input.hasAdjustments = builder->hasAdjustments;
+    key.input.toneMapping = uint32_t(builder->toneMapping);
+    if (builder->hasAdjustments) {
+        key.input.exposure = builder->exposure;
+        key.input.nightAdaptation = builder->nightAdaptation;
+        key.input.whiteBalance = builder->whiteBalance;
+
+        key.grading.outRed = builder->outRed;
+        key.grading.outGreen = builder->outGreen;
+        key.grading.outBlue = builder->outBlue;
+        key.grading.shadows = builder->shadows;
+        key.grading.midtones = builder->midtones;
+        key.grading.highlights = builder->highlights;
+        key.grading.tonalRanges = builder->tonalRanges;
+        key.grading.slope = builder->slope;
+        key.grading.offset = builder->offset;
+        key.grading.power = builder->power;
+        key.grading.contrast = builder->contrast;
+        key.grading.vibrance = builder->vibrance;
+        key.grading.saturation = builder->saturation;
+        key.grading.shadowGamma = builder->shadowGamma;
+        key.grading.midPoint = builder->midPoint;
+        key.grading.highlightScale = builder->highlightScale;
+    }
 
-                    // Apply OETF
-                    v = OETF_sRGB(v);
+    // A ToneMapper is opaque, it can be user-defined or modified after the ColorGrading is built.
+    // Only the ones selected with the deprecated ToneMapping API, which key.input.toneMapping
+    // identifies, are shared. Any other tone mapper gets a unique id, so its LUT is never shared.
+    static std::atomic<uint32_t> sToneMapperId{ 0 };
+    if (!builder->defaultToneMapper) {
+        do {
+            key.output.toneMapper = ++sToneMapperId;
+        } while (key.output.toneMapper == 0);
+    }
+    key.output.luminanceScaling = builder->luminanceScaling;
+    key.output.gamutMapping = builder->gamutMapping;
+    key.output.format = uint32_t(builder->format);
+    return key;
+}
 
-                    *p++ = half4{v, 0.0f};
-                }
-            }
+FColorGrading::FColorGrading(FEngine& engine, const Builder& builder)
+        : mLutKey(makeLutKey(builder)), mDimension(builder->dimension) {
+    SYSTRACE_CALL();
 
-            if (converted) {
-                uint32_t* const UTILS_RESTRICT dst = (uint32_t*) converted +
-                        b * config.lutDimension * config.lutDimension;
-                half4* UTILS_RESTRICT src = (half4*) data +
-                        b * config.lutDimension * config.lutDimension;
-                // we use a vectorize width of 8 because, on ARMv8 it allows the compiler to write eight
-                // 32-bits results in one go.
-                const size_t count = (config.lutDimension * config.lutDimension) & ~0x7u; // tell the compiler that we're a multiple of 8
-                #pragma clang loop vectorize_width(8)
-                for (size_t i = 0; i < count; ++i) {
-                    float4 v{src[i]};
-                    uint32_t pr = uint32_t(std::floor(v.x * 1023.0f + 0.5f));
-                    uint32_t pg = uint32_t(std::floor(v.y * 1023.0f + 0.5f));
-                    uint32_t pb = uint32_t(std::floor(v.z * 1023.0f + 0.5f));
-                    dst[i] = (pb << 20u) | (pg << 10u) | pr;
-                }
-            }
+    DriverApi& driver = engine.getDriverApi();
+    ColorGradingLutCache& cache = engine.getColorGradingLutCache();
 
-        });
-        js.run(job);
+    // An identical LUT is already in use, share it.
+    mLutHandle = cache.acquire(mLutKey);
+    if (mLutHandle) {
+        return;
     }
 
-    // TODO: Should we do a runAndRetain() and defer the wait() + texture creation until
-    //       getHwHandle() is invoked?
-    js.runAndWait(slices);
+    TextureFormat textureFormat;
+    PixelDataFormat format;
+    PixelDataType type;
+    selectLutTextureParams(builder->format, textureFormat, format, type);
+    assert_invariant(FTexture::validatePixelFormatAndType(textureFormat, format, type));
 
-    //std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - now;
-    //slog.d << "LUT generation time: " << duration.count() << " ms" << io::endl;
+    size_t size;
+    void* lut = generateLut(engine.getJobSystem(), cache, builder, mLutKey, &size);
 
     mLutHandle = driver.createTexture(
             SamplerType::SAMPLER_3D,
             1,
             textureFormat,
             1,
-            c.lutDimension,
-            c.lutDimension,
-            c.lutDimension,
+            mDimension,
+            mDimension,
+            mDimension,
             TextureUsage::DEFAULT
     );
 
-    if (converted) {
-        free(data);
-        data = converted;
-        elementSize = sizeof(uint32_t);
-    }
-
     driver.update3DImage(mLutHandle, 0,
             0, 0, 0,
-            c.lutDimension, c.lutDimension, c.lutDimension,
+            mDimension, mDimension, mDimension,
             PixelBufferDescriptor{
-                    data, lutElementCount * elementSize,format, type,
+                    lut, size, format, type,
                     [](void* buffer, size_t, void*) { free(buffer); }
             }
     );
+
+    cache.insert(mLutKey, mLutHandle);
+}
+
+void* FColorGrading::generateLut(JobSystem& js, ColorGradingLutCache& cache,
+        const Builder& builder, size_t* size) noexcept {
+    return generateLut(js, cache, builder, makeLutKey(builder), size);
+}
+
+// Inside generateLut, TSAN sporadically detects a data race on the config struct; the Filament
+// thread writes and the Job thread reads. In practice there should be no data race, so we force
+// TSAN off to silence the warning.
+UTILS_NO_SANITIZE_THREAD
+void* FColorGrading::generateLut(JobSystem& js, ColorGradingLutCache& cache,
+        const Builder& builder, ColorGradingLutCache::Key const& key, size_t* size) noexcept {
+    TextureFormat textureFormat;
+    PixelDataFormat format;
+    PixelDataType type;
+    selectLutTextureParams(builder->format, textureFormat, format, type);
+
+    const size_t dimension = builder->dimension;
+    const size_t lutElementCount = dimension * dimension * dimension;
+    const bool packed = type == PixelDataType::UINT_2_10_10_10_REV;
+    const size_t elementSize = packed ? sizeof(uint32_t) : sizeof(half4);
+
+    Config c;
+    // This lock protects the data inside Config, which is written to by the Filament thread,
+    // and read from multiple Job threads.
+    utils::SpinLock configLock;
+    {
+        std::lock_guard<utils::SpinLock> lock(configLock);
+        c.lutDimension          = dimension;
+        c.adaptationTransform   = adaptationTransform(builder->whiteBalance);
+        c.colorGradingIn        = selectColorGradingTransformIn(builder->toneMapping);
+        c.colorGradingOut       = selectColorGradingTransformOut(builder->toneMapping);
+        c.colorGradingLuminance = selectColorGradingLuminance(builder->toneMapping);
+
+        c.hasAdjustments        = builder->hasAdjustments;
+        c.luminanceScaling      = builder->luminanceScaling;
+        c.gamutMapping          = builder->gamutMapping;
+        c.exposure              = builder->exposure;
+        c.nightAdaptation       = builder->nightAdaptation;
+        c.outRed                = builder->outRed;
+        c.outGreen              = builder->outGreen;
+        c.outBlue               = builder->outBlue;
+        c.shadows               = builder->shadows;
+        c.midtones              = builder->midtones;
+        c.highlights            = builder->highlights;
+        c.tonalRanges           = builder->tonalRanges;
+        c.slope                 = builder->slope;
+        c.offset                = builder->offset;
+        c.power                 = builder->power;
+        c.contrast              = builder->contrast;
+        c.vibrance              = builder->vibrance;
+        c.saturation            = builder->saturation;
+        c.shadowGamma           = builder->shadowGamma;
+        c.midPoint              = builder->midPoint;
+        c.highlightScale        = builder->highlightScale;
+        c.toneMapper            = builder->toneMapper;
+
+        // Find out which stages can be skipped because their output was retained by the cache.
+        using Stage = ColorGradingLutCache::Stage;
+        float3 const* input = cache.getStageOutput(Stage::INPUT, key, lutElementCount);
+        float3 const* grading = cache.getStageOutput(Stage::GRADING, key, lutElementCount);
+        if (input && (grading || !c.hasAdjustments)) {
+            c.firstStage = size_t(Stage::GRADING) + 1;
+        } else if (input) {
+            c.firstStage = size_t(Stage::GRADING);
+        } else {
+            c.firstStage = size_t(Stage::INPUT);
+        }
+
+        c.inputStage = c.firstStage <= size_t(Stage::INPUT) ?
+                cache.prepareStageOutput(Stage::INPUT, key, lutElementCount) :
+                const_cast<float3*>(input);
+        c.gradingStage = nullptr;
+        if (c.hasAdjustments) {
+            c.gradingStage = c.firstStage <= size_t(Stage::GRADING) ?
+                    cache.prepareStageOutput(Stage::GRADING, key, lutElementCount) :
+                    const_cast<float3*>(grading);
+        }
+
+        c.lut = malloc(lutElementCount * elementSize);
+        c.packed = packed;
+    }
+
+    // Multithreadedly generate the tone mapping 3D look-up table using one job per slice
+    auto *slices = js.createJob();
+    for (size_t b = 0; b < dimension; b++) {
+        auto *job = js.createJob(slices,
+                [b, &c, &configLock](JobSystem&, JobSystem::Job*) {
+            Config config;
+            {
+                std::lock_guard<utils::SpinLock> lock(configLock);
+                config = c;
+            }
+            generateSlice(b, config);
+        });
+        js.run(job);
+    }
+    js.runAndWait(slices);
+
+    *size = lutElementCount * elementSize;
+    return c.lut;
 }
 
 FColorGrading::~FColorGrading() noexcept = default;
 
 void FColorGrading::terminate(FEngine& engine) {
-    DriverApi& driver = engine.getDriverApi();
-    driver.destroyTexture(mLutHandle);
+    // the LUT might be shared with other ColorGrading instances
+    engine.getColorGradingLutCache().release(engine.getDriverApi(), mLutKey);
 }
 
 } //namespace filament
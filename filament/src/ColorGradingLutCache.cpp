@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ColorGradingLutCache.h"
+
+#include <utils/Hash.h>
+#include <utils/debug.h>
+
+#include <string.h>
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+using Key = ColorGradingLutCache::Key;
+
+static_assert(sizeof(Key) == sizeof(Key::Input) + sizeof(Key::Grading) + sizeof(Key::Output) &&
+        sizeof(Key) % sizeof(uint32_t) == 0, "ColorGradingLutCache::Key must not have padding");
+
+bool Key::operator==(Key const& rhs) const noexcept {
+    return !memcmp(this, &rhs, sizeof(Key));
+}
+
+size_t Key::Hasher::operator()(Key const& key) const noexcept {
+    return utils::hash::murmur3((uint32_t const*)&key, sizeof(Key) / sizeof(uint32_t), 0);
+}
+
+ColorGradingLutCache::ColorGradingLutCache() noexcept = default;
+
+ColorGradingLutCache::~ColorGradingLutCache() noexcept {
+    // all ColorGrading objects must have been destroyed at this point
+    assert_invariant(mLuts.empty());
+}
+
+TextureHandle ColorGradingLutCache::acquire(Key const& key) noexcept {
+    auto pos = mLuts.find(key);
+    if (pos == mLuts.end()) {
+        return {};
+    }
+    pos.value().refCount++;
+    return pos->second.handle;
+}
+
+void ColorGradingLutCache::insert(Key const& key, TextureHandle handle) noexcept {
+    assert_invariant(mLuts.find(key) == mLuts.end());
+    mLuts[key] = { handle, 1 };
+}
+
+void ColorGradingLutCache::release(DriverApi& driver, Key const& key) noexcept {
+    auto pos = mLuts.find(key);
+    assert_invariant(pos != mLuts.end());
+    if (--pos.value().refCount == 0) {
+        driver.destroyTexture(pos->second.handle);
+        mLuts.erase(pos);
+        if (mLuts.empty()) {
+            // color grading isn't in use anymore, don't hold on to several MiB of intermediates
+            mStageOutputs = {};
+        }
+    }
+}
+
+bool ColorGradingLutCache::isSameUpTo(Stage stage, Key const& lhs, Key const& rhs) noexcept {
+    bool same = !memcmp(&lhs.input, &rhs.input, sizeof(Key::Input));
+    if (stage >= Stage::GRADING) {
+        same = same && !memcmp(&lhs.grading, &rhs.grading, sizeof(Key::Grading));
+    }
+    return same;
+}
+
+float3 const* ColorGradingLutCache::getStageOutput(Stage stage, Key const& key,
+        size_t count) const noexcept {
+    StageOutput const& output = mStageOutputs[size_t(stage)];
+    if (output.data && output.count == count && isSameUpTo(stage, output.key, key)) {
+        return output.data.get();
+    }
+    return nullptr;
+}
+
+float3* ColorGradingLutCache::prepareStageOutput(Stage stage, Key const& key,
+        size_t count) noexcept {
+    StageOutput& output = mStageOutputs[size_t(stage)];
+    if (output.count != count) {
+        output.data = std::make_unique<float3[]>(count);
+        output.count = count;
+    }
+    output.key = key;
+    return output.data.get();
+}
+
+} // namespace filament
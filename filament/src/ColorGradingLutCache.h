@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TNT_FILAMENT_COLORGRADINGLUTCACHE_H
+#define TNT_FILAMENT_COLORGRADINGLUTCACHE_H
+
+#include <backend/Handle.h>
+#include <private/backend/DriverApi.h>
+
+#include <math/vec2.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <tsl/robin_map.h>
+
+#include <array>
+#include <memory>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Keeps track of the color grading LUTs in use, so that ColorGrading objects built with the
+ * same configuration share a single texture.
+ *
+ * It also retains the intermediate results of the most recently generated LUT, so that a LUT
+ * that only differs in its last stages (e.g. when only the tone mapper changes) doesn't need to
+ * be regenerated from scratch.
+ */
+class ColorGradingLutCache {
+public:
+    // Stages of the LUT generation whose output is retained.
+    enum class Stage : uint8_t {
+        INPUT,      // LogC decoding, exposure, night adaptation and white balance
+        GRADING,    // channel mixer, tonal ranges, ASC CDL, contrast, vibrance, saturation, curves
+    };
+
+    // Everything the content of a LUT depends on, grouped by the stage that uses it. Keys are
+    // compared in full so that two configurations whose hashes collide never share a LUT. All the
+    // fields are 32 bits wide, so a key has no padding and can be hashed and compared as memory.
+    struct Key {
+        struct Input {
+            uint32_t dimension;
+            uint32_t hasAdjustments;
+            uint32_t toneMapping;       // selects the color grading space
+            float exposure;
+            float nightAdaptation;
+            math::float2 whiteBalance;
+        } input{};
+
+        struct Grading {
+            math::float3 outRed;
+            math::float3 outGreen;
+            math::float3 outBlue;
+            math::float3 shadows;
+            math::float3 midtones;
+            math::float3 highlights;
+            math::float4 tonalRanges;
+            math::float3 slope;
+            math::float3 offset;
+            math::float3 power;
+            float contrast;
+            float vibrance;
+            float saturation;
+            math::float3 shadowGamma;
+            math::float3 midPoint;
+            math::float3 highlightScale;
+        } grading{};
+
+        struct Output {
+            // 0 when the tone mapper is selected by input.toneMapping, a unique id otherwise
+            uint32_t toneMapper;
+            uint32_t luminanceScaling;
+            uint32_t gamutMapping;
+            uint32_t format;
+        } output{};
+
+        bool operator==(Key const& rhs) const noexcept;
+
+        struct Hasher {
+            size_t operator()(Key const& key) const noexcept;
+        };
+    };
+
+    ColorGradingLutCache() noexcept;
+    ~ColorGradingLutCache() noexcept;
+
+    ColorGradingLutCache(ColorGradingLutCache const& rhs) = delete;
+    ColorGradingLutCache& operator=(ColorGradingLutCache const& rhs) = delete;
+
+    // Returns the LUT associated to key and takes a reference on it, or a null handle.
+    backend::TextureHandle acquire(Key const& key) noexcept;
+
+    // Adds a LUT with a single reference, key must not be in the cache already.
+    void insert(Key const& key, backend::TextureHandle handle) noexcept;
+
+    // Drops a reference on the LUT associated to key, destroys the LUT when it was the last one.
+    // The retained stage outputs are freed with the last LUT.
+    void release(backend::DriverApi& driver, Key const& key) noexcept;
+
+    // Returns the retained output of the given stage if it was generated with the same parameters
+    // for this stage and the ones before it, nullptr otherwise.
+    math::float3 const* getStageOutput(Stage stage, Key const& key, size_t count) const noexcept;
+
+    // Returns storage for the output of the given stage, which is associated to the given key.
+    // The previous content is lost.
+    math::float3* prepareStageOutput(Stage stage, Key const& key, size_t count) noexcept;
+
+private:
+    // Whether the parameters of the given stage and of the ones before it are the same
+    static bool isSameUpTo(Stage stage, Key const& lhs, Key const& rhs) noexcept;
+
+    struct Lut {
+        backend::TextureHandle handle;
+        uint32_t refCount;
+    };
+    tsl::robin_map<Key, Lut, Key::Hasher> mLuts;
+
+    struct StageOutput {
+        Key key;
+        size_t count = 0;
+        std::unique_ptr<math::float3[]> data;
+    };
+    std::array<StageOutput, 2> mStageOutputs;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_COLORGRADINGLUTCACHE_H
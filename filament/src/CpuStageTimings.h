@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_CPUSTAGETIMINGS_H
+#define TNT_FILAMENT_DETAILS_CPUSTAGETIMINGS_H
+
+#include <filament/Renderer.h>
+
+#include <array>
+#include <chrono>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Accumulates the CPU time spent in each stage of the frame. The timings are reset by
+ * Renderer::beginFrame() and accumulated over all the render() calls of that frame.
+ * Each stage is only ever recorded from the thread calling render(), so no synchronization
+ * is needed.
+ */
+class CpuStageTimings {
+public:
+    using clock = std::chrono::steady_clock;
+    using duration = clock::duration;
+
+    using Stage = Renderer::FrameStage;
+
+    static constexpr size_t STAGE_COUNT = Renderer::FRAME_STAGE_COUNT;
+
+    // Adds the time elapsed between its construction and destruction to the given stage
+    class Scope {
+    public:
+        Scope(CpuStageTimings& timings, Stage stage) noexcept
+                : mTimings(timings), mStage(stage), mStart(clock::now()) {
+        }
+        ~Scope() noexcept {
+            mTimings.add(mStage, clock::now() - mStart);
+        }
+        Scope(Scope const&) = delete;
+        Scope& operator=(Scope const&) = delete;
+    private:
+        CpuStageTimings& mTimings;
+        Stage const mStage;
+        clock::time_point const mStart;
+    };
+
+    void reset() noexcept {
+        mDurations.fill(duration::zero());
+    }
+
+    void add(Stage stage, duration d) noexcept {
+        mDurations[size_t(stage)] += d;
+    }
+
+    duration get(Stage stage) const noexcept {
+        return mDurations[size_t(stage)];
+    }
+
+    static const char* getName(Stage stage) noexcept {
+        switch (stage) {
+            case Stage::SCENE_PREPARE:          return "scene_prepare";
+            case Stage::CULLING:                return "culling";
+            case Stage::UBO_UPDATE:             return "ubo_update";
+            case Stage::FROXELIZATION:          return "froxelization";
+            case Stage::COMMAND_GENERATION:     return "command_generation";
+            case Stage::COMMAND_SORT:           return "command_sort";
+            case Stage::FRAME_GRAPH_COMPILE:    return "fg_compile";
+            case Stage::FRAME_GRAPH_EXECUTE:    return "fg_execute";
+        }
+        return "";
+    }
+
+private:
+    std::array<duration, STAGE_COUNT> mDurations{};
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_CPUSTAGETIMINGS_H
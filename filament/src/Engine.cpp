@@ -62,11 +62,12 @@ namespace filament {
 using namespace backend;
 using namespace filaflat;
 
-FEngine* FEngine::create(Backend backend, Platform* platform, void* sharedGLContext) {
+FEngine* FEngine::create(Backend backend, Platform* platform, void* sharedGLContext,
+        const Config* config) {
     SYSTRACE_ENABLE();
     SYSTRACE_CALL();
 
-    FEngine* instance = new FEngine(backend, platform, sharedGLContext);
+    FEngine* instance = new FEngine(backend, platform, sharedGLContext, validateConfig(config));
 
     // initialize all fields that need an instance of FEngine
     // (this cannot be done safely in the ctor)
@@ -111,10 +112,10 @@ FEngine* FEngine::create(Backend backend, Platform* platform, void* sharedGLCont
 #if UTILS_HAS_THREADING
 
 void FEngine::createAsync(CreateCallback callback, void* user,
-        Backend backend, Platform* platform, void* sharedGLContext) {
+        Backend backend, Platform* platform, void* sharedGLContext, const Config* config) {
     SYSTRACE_ENABLE();
     SYSTRACE_CALL();
-    FEngine* instance = new FEngine(backend, platform, sharedGLContext);
+    FEngine* instance = new FEngine(backend, platform, sharedGLContext, validateConfig(config));
 
     // start the driver thread
     instance->mDriverThread = std::thread(&FEngine::loop, instance);
@@ -165,19 +166,24 @@ static constexpr float4 sFullScreenTriangleVertices[3] = {
 // these must be static because only a pointer is copied to the render stream
 static const uint16_t sFullScreenTriangleIndices[3] = { 0, 1, 2 };
 
-FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext) :
+FEngine::FEngine(Backend backend, Platform* platform, void* sharedGLContext,
+        Config const& config) :
         mBackend(backend),
         mPlatform(platform),
         mSharedGLContext(sharedGLContext),
+        mConfig(config),
         mPostProcessManager(*this),
         mEntityManager(EntityManager::get()),
         mRenderableManager(*this),
         mTransformManager(),
         mLightManager(*this),
         mCameraManager(*this),
-        mCommandBufferQueue(CONFIG_MIN_COMMAND_BUFFERS_SIZE, CONFIG_COMMAND_BUFFERS_SIZE),
-        mPerRenderPassAllocator("per-renderpass allocator", CONFIG_PER_RENDER_PASS_ARENA_SIZE),
-        mJobSystem(getJobSystemThreadPoolSize()),
+        mTextureStreamer(*this),
+        mCommandBufferQueue(size_t(config.minCommandBufferSizeMB) * 1024 * 1024,
+                size_t(config.commandBufferSizeMB) * 1024 * 1024),
+        mPerRenderPassAllocator("per-renderpass allocator",
+                size_t(config.perRenderPassArenaSizeMB) * 1024 * 1024),
+        mJobSystem(config.jobSystemThreadCount, 1, config.jobSystemThreadAffinityMask),
         mEngineEpoch(std::chrono::steady_clock::now()),
         mDriverBarrier(1),
         mMainThreadId(std::this_thread::get_id())
@@ -198,6 +204,48 @@ uint32_t FEngine::getJobSystemThreadPoolSize() noexcept {
     return threadCount;
 }
 
+FEngine::Config FEngine::validateConfig(const Config* config) {
+    constexpr size_t MiB = 1024 * 1024;
+    Config result = config ? *config : Config{};
+    if (!result.minCommandBufferSizeMB) {
+        result.minCommandBufferSizeMB = uint32_t(CONFIG_MIN_COMMAND_BUFFERS_SIZE / MiB);
+    }
+    if (!result.commandBufferSizeMB) {
+        result.commandBufferSizeMB = 3 * result.minCommandBufferSizeMB;
+    }
+    if (!result.perRenderPassArenaSizeMB) {
+        result.perRenderPassArenaSizeMB = uint32_t(CONFIG_PER_RENDER_PASS_ARENA_SIZE / MiB);
+    }
+    if (!result.perFrameCommandsSizeMB) {
+        result.perFrameCommandsSizeMB = uint32_t(CONFIG_PER_FRAME_COMMANDS_SIZE / MiB);
+    }
+    if (!result.jobSystemThreadCount) {
+        result.jobSystemThreadCount = getJobSystemThreadPoolSize();
+    }
+
+    ASSERT_PRECONDITION(result.commandBufferSizeMB > result.minCommandBufferSizeMB,
+            "Config::commandBufferSizeMB (%u) must be larger than "
+            "Config::minCommandBufferSizeMB (%u)",
+            result.commandBufferSizeMB, result.minCommandBufferSizeMB);
+    ASSERT_PRECONDITION(result.perRenderPassArenaSizeMB > result.perFrameCommandsSizeMB,
+            "Config::perRenderPassArenaSizeMB (%u) must be larger than "
+            "Config::perFrameCommandsSizeMB (%u)",
+            result.perRenderPassArenaSizeMB, result.perFrameCommandsSizeMB);
+    return result;
+}
+
+Engine::MemoryStatistics FEngine::getMemoryStatistics() const noexcept {
+    return {
+            .commandBufferSize = size_t(mConfig.commandBufferSizeMB) * 1024 * 1024,
+            .commandBufferHighWatermark = mCommandBufferQueue.getHighWatermark(),
+            .perRenderPassArenaSize = mPerRenderPassAllocator.getArea().size(),
+            .perRenderPassArenaHighWatermark =
+                    mPerRenderPassAllocator.getListener().getHighWatermark(),
+            .perFrameCommandsSize = getPerFrameCommandsSize(),
+            .perFrameCommandsHighWatermark = mPerFrameCommandsHighWatermark,
+    };
+}
+
 /*
  * init() is called just after the driver thread is initialized. Driver commands are therefore
  * possible.
@@ -300,7 +348,7 @@ void FEngine::shutdown() {
 #ifndef NDEBUG
     // print out some statistics about this run
     size_t wm = mCommandBufferQueue.getHighWatermark();
-    size_t wmpct = wm / (CONFIG_COMMAND_BUFFERS_SIZE / 100);
+    size_t wmpct = wm / (mConfig.commandBufferSizeMB * 1024 * 1024 / 100);
     slog.d << "CircularBuffer: High watermark "
            << wm / 1024 << " KiB (" << wmpct << "%)" << io::endl;
 #endif
@@ -317,6 +365,7 @@ void FEngine::shutdown() {
     mRenderableManager.terminate();         // free-up all renderables
     mLightManager.terminate();              // free-up all lights
     mCameraManager.terminate();             // free-up all cameras
+    mTextureStreamer.terminate(*this);      // stop streaming textures
 
     driver.destroyRenderPrimitive(mFullScreenTriangleRph);
     destroy(mFullScreenTriangleIb);
@@ -402,15 +451,26 @@ void FEngine::prepare() {
     // UBOs that are visible only. It's not such a big issue because the actual upload() is
     // skipped is the UBO hasn't changed. Still we could have a lot of these.
     FEngine::DriverApi& driver = getDriverApi();
+
+    // streamed textures may have been given a new handle, which material instances must follow
+    const bool streamedTexturesChanged = mTextureStreamer.takeHandleChanges();
+
     for (auto& materialInstanceList : mMaterialInstances) {
         for (const auto& item : materialInstanceList.second) {
+            if (UTILS_UNLIKELY(streamedTexturesChanged)) {
+                item->updateStreamedSamplers(mTextureStreamer);
+            }
             item->commit(driver);
         }
     }
 
     // Commit default material instances.
     for (const auto& material : mMaterials) {
-        material->getDefaultInstance()->commit(driver);
+        FMaterialInstance* const defaultInstance = material->getDefaultInstance();
+        if (UTILS_UNLIKELY(streamedTexturesChanged)) {
+            defaultInstance->updateStreamedSamplers(mTextureStreamer);
+        }
+        defaultInstance->commit(driver);
     }
 }
 
@@ -423,6 +483,13 @@ void FEngine::gc() {
     mCameraManager.gc(em);
 }
 
+void FEngine::onRenderableRemoved(FRenderableManager::Instance instance,
+        FRenderableManager::Instance last) noexcept {
+    for (FView* view : mViews) {
+        view->onRenderableRemoved(instance, last);
+    }
+}
+
 void FEngine::flush() {
     // flush the command buffer
     flushCommandBuffer(mCommandBufferQueue);
@@ -595,6 +662,13 @@ FTexture* FEngine::createTexture(const Texture::Builder& builder) noexcept {
     return create(mTextures, builder);
 }
 
+FTexture* FEngine::createStreamedTexture(const Texture::Builder& builder,
+        uint32_t streamingId, uint8_t baseLevel) noexcept {
+    FTexture* p = mHeapAllocator.make<FTexture>(*this, builder, streamingId, baseLevel);
+    mTextures.insert(p);
+    return p;
+}
+
 FIndirectLight* FEngine::createIndirectLight(const IndirectLight::Builder& builder) noexcept {
     return create(mIndirectLights, builder);
 }
@@ -899,8 +973,9 @@ void FEngine::destroy(FEngine* engine) {
 // Trampoline calling into private implementation
 // ------------------------------------------------------------------------------------------------
 
-Engine* Engine::create(Backend backend, Platform* platform, void* sharedGLContext) {
-    return FEngine::create(backend, platform, sharedGLContext);
+Engine* Engine::create(Backend backend, Platform* platform, void* sharedGLContext,
+        const Config* config) {
+    return FEngine::create(backend, platform, sharedGLContext, config);
 }
 
 void Engine::destroy(Engine* engine) {
@@ -909,8 +984,8 @@ void Engine::destroy(Engine* engine) {
 
 #if UTILS_HAS_THREADING
 void Engine::createAsync(Engine::CreateCallback callback, void* user, Backend backend,
-        Platform* platform, void* sharedGLContext) {
-    FEngine::createAsync(callback, user, backend, platform, sharedGLContext);
+        Platform* platform, void* sharedGLContext, const Config* config) {
+    FEngine::createAsync(callback, user, backend, platform, sharedGLContext, config);
 }
 
 Engine* Engine::getEngine(void* token) {
@@ -1078,6 +1153,10 @@ TransformManager& Engine::getTransformManager() noexcept {
     return upcast(this)->getTransformManager();
 }
 
+TextureStreamer& Engine::getTextureStreamer() noexcept {
+    return upcast(this)->getTextureStreamer();
+}
+
 void Engine::enableAccurateTranslations() noexcept  {
     getTransformManager().setAccurateTranslationsEnabled(true);
 }
@@ -1098,6 +1177,14 @@ utils::JobSystem& Engine::getJobSystem() noexcept {
     return upcast(this)->getJobSystem();
 }
 
+Engine::Config const& Engine::getConfig() const noexcept {
+    return upcast(this)->getConfig();
+}
+
+Engine::MemoryStatistics Engine::getMemoryStatistics() const noexcept {
+    return upcast(this)->getMemoryStatistics();
+}
+
 DebugRegistry& Engine::getDebugRegistry() noexcept {
     return upcast(this)->getDebugRegistry();
 }
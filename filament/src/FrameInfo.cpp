@@ -52,22 +52,35 @@ void FrameInfoManager::terminate(DriverApi& driver) noexcept {
 }
 
 void FrameInfoManager::beginFrame(DriverApi& driver,Config const& config, uint32_t frameId) noexcept {
-    driver.beginTimerQuery(mQueries[mIndex]);
-    uint64_t elapsed = 0;
-    if (driver.getTimerQueryValue(mQueries[mLast], &elapsed)) {
-        mLast = (mLast + 1) % POOL_COUNT;
-        // conversion to our duration happens here
-        mFrameTime = std::chrono::duration<uint64_t, std::nano>(elapsed);
+    if (mTimerQueryActive != config.timerQuery) {
+        // The queries still in flight when the mode changes belong to frames we don't track
+        // anymore; restart from the beginning of the pool so that mLast never refers to a query
+        // older than mIndex. The first query is issued again below, which resets its result.
+        mTimerQueryActive = config.timerQuery;
+        mIndex = 0;
+        mLast = 0;
     }
-    update(config, mFrameTime);
+    if (mTimerQueryActive) {
+        driver.beginTimerQuery(mQueries[mIndex]);
+        uint64_t elapsed = 0;
+        if (driver.getTimerQueryValue(mQueries[mLast], &elapsed)) {
+            mLast = (mLast + 1) % POOL_COUNT;
+            // conversion to our duration happens here
+            mFrameTime = std::chrono::duration<uint64_t, std::nano>(elapsed);
+        }
+    }
+    update(config, mFrameTime, mTimerQueryActive || mFrameTimeValid);
 }
 
 void FrameInfoManager::endFrame(DriverApi& driver) noexcept {
-    driver.endTimerQuery(mQueries[mIndex]);
-    mIndex = (mIndex + 1) % POOL_COUNT;
+    if (mTimerQueryActive) {
+        driver.endTimerQuery(mQueries[mIndex]);
+        mIndex = (mIndex + 1) % POOL_COUNT;
+    }
 }
 
-void FrameInfoManager::update(Config const& config, FrameInfoManager::duration lastFrameTime) noexcept {
+void FrameInfoManager::update(Config const& config, FrameInfoManager::duration lastFrameTime,
+        bool lastFrameTimeValid) noexcept {
     // keep an history of frame times
     auto& history = mFrameTimeHistory;
 
@@ -82,6 +95,12 @@ void FrameInfoManager::update(Config const& config, FrameInfoManager::duration l
         return;
     }
 
+    if (UTILS_UNLIKELY(!lastFrameTimeValid)) {
+        // the last frame time is only partial, it would make the frame look cheaper than it is
+        history[0].valid = false;
+        return;
+    }
+
     // apply a median filter to get a good representation of the frame time of the last
     // N frames.
     std::array<duration, MAX_FRAMETIME_HISTORY> median; // NOLINT -- it's initialized below
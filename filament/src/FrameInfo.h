@@ -44,6 +44,9 @@ public:
 
     struct Config {
         uint32_t historySize;
+        // when false, no timer query is issued and the GPU frame time must be provided
+        // with setGpuFrameTime()
+        bool timerQuery = true;
     };
 
     explicit FrameInfoManager(backend::DriverApi& driver) noexcept;
@@ -65,12 +68,25 @@ public:
         return getLastFrameInfo().frameTime;
     }
 
+    // sets the GPU time of the last completed frame, when timer queries are not used
+    void setGpuFrameTime(duration frameTime) noexcept {
+        mFrameTime = frameTime;
+        mFrameTimeValid = true;
+    }
+
+    // the GPU time of the last completed frame is not known, when timer queries are not used
+    void invalidateGpuFrameTime() noexcept {
+        mFrameTimeValid = false;
+    }
+
 private:
-    void update(Config const& config, duration lastFrameTime) noexcept;
+    void update(Config const& config, duration lastFrameTime, bool lastFrameTimeValid) noexcept;
     backend::Handle<backend::HwTimerQuery> mQueries[POOL_COUNT];
     duration mFrameTime{};
     uint32_t mIndex = 0;
     uint32_t mLast = 0;
+    bool mTimerQueryActive = false;
+    bool mFrameTimeValid = true;
 
     std::array<FrameInfo, MAX_FRAMETIME_HISTORY> mFrameTimeHistory;
     uint32_t mFrameTimeHistorySize = 0;
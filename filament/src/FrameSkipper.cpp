@@ -21,52 +21,96 @@
 #include <utils/Log.h>
 #include <utils/debug.h>
 
+#include <algorithm>
+
 namespace filament {
 
 using namespace utils;
 using namespace backend;
 
 FrameSkipper::FrameSkipper(size_t latency) noexcept
-        : mLast(latency) {
-    assert_invariant(latency <= MAX_FRAME_LATENCY);
+        : mLatency(latency), mLast(latency) {
+    assert_invariant(latency < MAX_FRAME_LATENCY);
 }
 
 FrameSkipper::~FrameSkipper() noexcept = default;
 
 void FrameSkipper::terminate(DriverApi& driver) noexcept {
-    for (auto sync : mDelayedSyncs) {
-        if (sync) {
-            driver.destroySync(sync);
-        }
+    for (auto& entry : mDelayedSyncs) {
+        destroy(driver, entry);
+    }
+}
+
+void FrameSkipper::destroy(DriverApi& driver, Entry& entry) noexcept {
+    if (entry.sync) {
+        driver.destroySync(entry.sync);
+    }
+    if (entry.fence) {
+        driver.destroyFence(entry.fence);
     }
+    entry = {};
+}
+
+void FrameSkipper::setLatency(size_t latency) noexcept {
+    assert_invariant(latency < MAX_FRAME_LATENCY);
+    // The fences already in flight stay where they are. When the latency is reduced, the frames
+    // are still added after them, see beginFrame().
+    mLatency = latency;
+    mLast = std::max(mLast, latency);
+}
+
+bool FrameSkipper::isReady(DriverApi& driver) const noexcept {
+    Entry const& entry = mDelayedSyncs.front();
+    return !entry.sync || entry.completed || entry.fenceSignaled ||
+           driver.getSyncStatus(entry.sync) != SyncStatus::NOT_SIGNALED;
+}
+
+bool FrameSkipper::wait(DriverApi& driver) noexcept {
+    Entry& entry = mDelayedSyncs.front();
+    if (isReady(driver)) {
+        return true;
+    }
+    if (!entry.fence) {
+        return false;
+    }
+    entry.fenceSignaled =
+            driver.wait(entry.fence, FENCE_WAIT_FOR_EVER) == FenceStatus::CONDITION_SATISFIED;
+    return entry.fenceSignaled;
 }
 
 bool FrameSkipper::beginFrame(DriverApi& driver) noexcept {
     auto& syncs = mDelayedSyncs;
-    auto sync = syncs.front();
-    if (sync) {
-        auto status = driver.getSyncStatus(sync);
-        if (status == SyncStatus::NOT_SIGNALED) {
-            // Sync not ready, skip frame
-            return false;
+    auto& front = syncs.front();
+    if (front.sync && !isReady(driver)) {
+        // Sync not ready, skip frame
+        return false;
+    }
+    while (true) {
+        destroy(driver, front);
+        // shift all fences down by 1
+        std::move(syncs.begin() + 1, syncs.end(), syncs.begin());
+        syncs.back() = {};
+        // When the latency was reduced, the frames in flight beyond the new latency are retired
+        // as soon as they're finished, so the new latency takes effect after a few frames.
+        if (mLast == mLatency || !isReady(driver)) {
+            break;
         }
-        driver.destroySync(sync);
+        mLast--;
     }
-    // shift all fences down by 1
-    std::move(syncs.begin() + 1, syncs.end(), syncs.begin());
-    syncs.back() = {};
     return true;
 }
 
-void FrameSkipper::endFrame(DriverApi& driver) noexcept {
+void FrameSkipper::endFrame(DriverApi& driver, uint32_t frameId, bool withFence) noexcept {
     // if the user produced a new frame despite the fact that the previous one wasn't finished
     // (i.e. FrameSkipper::beginFrame() returned false), we need to make sure to replace
     // a fence that might be here already)
-    auto& sync = mDelayedSyncs[mLast];
-    if (sync) {
-        driver.destroySync(sync);
+    auto& entry = mDelayedSyncs[mLast];
+    destroy(driver, entry);
+    entry.sync = driver.createSync();
+    if (withFence) {
+        entry.fence = driver.createFence();
     }
-    sync = driver.createSync();
+    entry.frameId = frameId;
 }
 
 } // namespace filament
@@ -25,23 +25,64 @@
 namespace filament {
 
 class FrameSkipper {
-    static constexpr size_t MAX_FRAME_LATENCY = 4;
 public:
+    static constexpr size_t MAX_FRAME_LATENCY = 4;
+
     explicit FrameSkipper(size_t latency = 2) noexcept;
     ~FrameSkipper() noexcept;
 
     void terminate(backend::DriverApi& driver) noexcept;
 
+    // Sets how many frames the gpu can run behind the cpu, less than MAX_FRAME_LATENCY, i.e.
+    // up to latency + 1 frames are in flight. With a latency of 0, a frame can only start once
+    // the previous one is finished.
+    void setLatency(size_t latency) noexcept;
+    size_t getLatency() const noexcept { return mLatency; }
+
+    // Checks the fences of the frames in flight and calls onFrameCompleted(frameId) once for
+    // each frame that finished since the last call.
+    template<typename F>
+    void poll(backend::DriverApi& driver, F&& onFrameCompleted) noexcept {
+        for (Entry& entry : mDelayedSyncs) {
+            if (entry.sync && !entry.completed && (entry.fenceSignaled ||
+                    driver.getSyncStatus(entry.sync) != backend::SyncStatus::NOT_SIGNALED)) {
+                entry.completed = true;
+                onFrameCompleted(entry.frameId);
+            }
+        }
+    }
+
+    // returns true if beginFrame() would succeed.
+    bool isReady(backend::DriverApi& driver) const noexcept;
+
+    // Blocks until beginFrame() would succeed. Only frames ended with a fence can be waited on,
+    // returns false if that's not the case or the backend can't wait on fences.
+    bool wait(backend::DriverApi& driver) noexcept;
+
     // returns false if we need to skip this frame, because the gpu is running behind the cpu.
     // in that case, don't call endFrame().
     // returns true if rendering can proceed. Always call endFrame() when done.
     bool beginFrame(backend::DriverApi& driver) noexcept;
 
-    void endFrame(backend::DriverApi& driver) noexcept;
+    // withFence adds a fence to the frame, so that wait() can block on it.
+    void endFrame(backend::DriverApi& driver, uint32_t frameId = 0,
+            bool withFence = false) noexcept;
 
 private:
-    using Container = std::array<backend::Handle<backend::HwSync>, MAX_FRAME_LATENCY>;
+    struct Entry {
+        backend::Handle<backend::HwSync> sync;
+        backend::Handle<backend::HwFence> fence;
+        uint32_t frameId = 0;
+        bool completed = false;     // the frame was seen finished and reported by poll()
+        bool fenceSignaled = false; // wait() saw the fence signal
+    };
+
+    static void destroy(backend::DriverApi& driver, Entry& entry) noexcept;
+
+    using Container = std::array<Entry, MAX_FRAME_LATENCY>;
     mutable Container mDelayedSyncs{};
+    size_t mLatency;
+    // where endFrame() adds the frame, more than mLatency while the latency is being reduced
     size_t mLast;
 };
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_FRAMESTATISTICS_H
+#define TNT_FILAMENT_DETAILS_FRAMESTATISTICS_H
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Monotonic counters owned by the engine. They can be updated concurrently, e.g. by renderViews()
+ * jobs or RenderPass executors, so they're atomic. Renderers compute per-frame values by taking
+ * the difference between two snapshots.
+ */
+struct FrameStatistics {
+    struct Snapshot {
+        uint64_t drawCount = 0;
+        uint64_t triangleCount = 0;
+        uint64_t stateChangeCount = 0;
+        uint64_t uploadedBytes = 0;
+
+        Snapshot operator-(Snapshot const& rhs) const noexcept {
+            return {
+                    drawCount - rhs.drawCount,
+                    triangleCount - rhs.triangleCount,
+                    stateChangeCount - rhs.stateChangeCount,
+                    uploadedBytes - rhs.uploadedBytes
+            };
+        }
+    };
+
+    std::atomic<uint64_t> drawCount{};
+    std::atomic<uint64_t> triangleCount{};
+    std::atomic<uint64_t> stateChangeCount{};
+    std::atomic<uint64_t> uploadedBytes{};
+
+    // Each counter is read atomically, but the snapshot as a whole isn't; a counter updated
+    // concurrently is accounted for in this frame or the next one.
+    Snapshot snapshot() const noexcept {
+        return {
+                drawCount.load(std::memory_order_relaxed),
+                triangleCount.load(std::memory_order_relaxed),
+                stateChangeCount.load(std::memory_order_relaxed),
+                uploadedBytes.load(std::memory_order_relaxed)
+        };
+    }
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_FRAMESTATISTICS_H
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FrameTimingsRecorder.h"
+
+#include <utils/compiler.h>
+
+#include <algorithm>
+
+namespace filament {
+
+using namespace backend;
+using namespace std::chrono;
+
+FrameTimingsRecorder::FrameTimingsRecorder() noexcept = default;
+
+FrameTimingsRecorder::~FrameTimingsRecorder() noexcept = default;
+
+void FrameTimingsRecorder::terminate(DriverApi& driver) noexcept {
+    destroyQueries(driver);
+}
+
+void FrameTimingsRecorder::setOptions(DriverApi& driver, FrameTimingOptions const& options,
+        FrameStatistics::Snapshot const& statistics) noexcept {
+    if (options.enabled && !mOptions.enabled) {
+        // statistics are reported from the moment we're enabled
+        mLastStatistics = statistics;
+    }
+    const bool needsQueries = options.enabled && options.gpuPassTimings;
+    if (needsQueries && !mQueriesCreated) {
+        createQueries(driver);
+    } else if (!needsQueries && mQueriesCreated) {
+        destroyQueries(driver);
+    }
+    mOptions = options;
+}
+
+void FrameTimingsRecorder::createQueries(DriverApi& driver) noexcept {
+    for (auto& querySet : mQueries) {
+        for (auto& query : querySet) {
+            query = driver.createTimerQuery();
+        }
+    }
+    mPendingGpuFrames = {};
+    mQueriesCreated = true;
+}
+
+void FrameTimingsRecorder::destroyQueries(DriverApi& driver) noexcept {
+    if (mQueriesCreated) {
+        for (auto& querySet : mQueries) {
+            for (auto& query : querySet) {
+                driver.destroyTimerQuery(query);
+                query.clear();
+            }
+        }
+        mPendingGpuFrames = {};
+        mQueriesCreated = false;
+    }
+}
+
+bool FrameTimingsRecorder::beginFrame(DriverApi& driver, uint32_t frameId,
+        nanoseconds* gpuFrameTime, bool* gpuFrameTimeComplete) noexcept {
+    mRecording = mOptions.enabled;
+    if (!mRecording) {
+        return false;
+    }
+
+    bool gpuFrameTimeAvailable = false;
+    if (mQueriesCreated) {
+        // poll the frames in flight, oldest first
+        for (size_t i = 1; i <= GPU_LATENCY; i++) {
+            const size_t slot = (mGpuSlot + i) % GPU_LATENCY;
+            if (mPendingGpuFrames[slot].pending) {
+                gpuFrameTimeAvailable |= pollGpuTimings(driver, slot,
+                        gpuFrameTime, gpuFrameTimeComplete);
+            }
+        }
+        // this frame reuses the oldest set of queries, if its results are still not available
+        // they're lost.
+        mGpuSlot = (mGpuSlot + 1) % GPU_LATENCY;
+        mPendingGpuFrames[mGpuSlot] = {};
+    }
+    mGpuQueryCount = 0;
+    mGpuPassActive = false;
+    mGpuPassesTruncated = false;
+
+    FrameTimings& frame = mHistory[mCurrent];
+    frame = {};
+    frame.frameId = frameId;
+    mInputTimes[mCurrent] = {};
+    mFrameStart = clock::now();
+    return gpuFrameTimeAvailable;
+}
+
+void FrameTimingsRecorder::endFrame(CpuStageTimings const& stages,
+        FrameStatistics::Snapshot const& statistics) noexcept {
+    if (!mRecording) {
+        return;
+    }
+    mRecording = false;
+
+    FrameTimings& frame = mHistory[mCurrent];
+    frame.cpuFrameTimeNanos = duration_cast<nanoseconds>(clock::now() - mFrameStart).count();
+    for (size_t i = 0; i < CpuStageTimings::STAGE_COUNT; i++) {
+        frame.stageCpuTimeNanos[i] = duration_cast<nanoseconds>(
+                stages.get(CpuStageTimings::Stage(i))).count();
+    }
+
+    const FrameStatistics::Snapshot delta = statistics - mLastStatistics;
+    mLastStatistics = statistics;
+    frame.drawCount = uint32_t(delta.drawCount);
+    frame.triangleCount = uint32_t(delta.triangleCount);
+    frame.stateChangeCount = uint32_t(delta.stateChangeCount);
+    frame.uploadedBytes = delta.uploadedBytes;
+
+    if (mGpuQueryCount) {
+        mPendingGpuFrames[mGpuSlot] = { frame.frameId, mGpuQueryCount, true,
+                !mGpuPassesTruncated };
+    }
+
+    mCurrent = (mCurrent + 1) % HISTORY_SIZE;
+    mCompletedCount = std::min(mCompletedCount + 1, uint32_t(HISTORY_SIZE - 1));
+}
+
+void FrameTimingsRecorder::beginPass(DriverApi& driver, const char* name) noexcept {
+    FrameTimings& frame = mHistory[mCurrent];
+    if (UTILS_UNLIKELY(!mRecording)) {
+        return;
+    }
+    // the passes past the limits are not timed, so the GPU frame time would be too short
+    if (UTILS_UNLIKELY(frame.passCount >= std::min(MAX_GPU_PASS_COUNT,
+            FrameTimings::MAX_PASS_COUNT))) {
+        mGpuPassesTruncated = true;
+    }
+    if (UTILS_UNLIKELY(frame.passCount >= FrameTimings::MAX_PASS_COUNT)) {
+        return;
+    }
+    frame.passes[frame.passCount].name = name;
+    if (mQueriesCreated && frame.passCount < MAX_GPU_PASS_COUNT) {
+        driver.beginTimerQuery(mQueries[mGpuSlot][frame.passCount]);
+        mGpuPassActive = true;
+    }
+    mPassStart = clock::now();
+}
+
+void FrameTimingsRecorder::endPass(DriverApi& driver) noexcept {
+    FrameTimings& frame = mHistory[mCurrent];
+    if (UTILS_UNLIKELY(!mRecording || frame.passCount >= FrameTimings::MAX_PASS_COUNT)) {
+        return;
+    }
+    const uint32_t index = frame.passCount++;
+    frame.passes[index].cpuTimeNanos =
+            duration_cast<nanoseconds>(clock::now() - mPassStart).count();
+    if (mGpuPassActive) {
+        driver.endTimerQuery(mQueries[mGpuSlot][index]);
+        mGpuQueryCount = index + 1;
+        mGpuPassActive = false;
+    }
+}
+
+bool FrameTimingsRecorder::pollGpuTimings(DriverApi& driver, size_t slot,
+        nanoseconds* gpuFrameTime, bool* gpuFrameTimeComplete) noexcept {
+    PendingGpuFrame& pending = mPendingGpuFrames[slot];
+    std::array<uint64_t, MAX_GPU_PASS_COUNT> elapsed; // NOLINT -- initialized below
+    for (size_t i = 0; i < pending.queryCount; i++) {
+        if (!driver.getTimerQueryValue(mQueries[slot][i], &elapsed[i])) {
+            // not ready yet, try again next frame
+            return false;
+        }
+    }
+    pending.pending = false;
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < pending.queryCount; i++) {
+        total += elapsed[i];
+    }
+
+    // the frame might not be in the history anymore
+    FrameTimings* const frame = findFrame(pending.frameId);
+    if (frame) {
+        for (size_t i = 0; i < pending.queryCount; i++) {
+            frame->passes[i].gpuTimeNanos = elapsed[i];
+        }
+        frame->gpuFrameTimeNanos = total;
+        frame->gpuTimingsValid = true;
+    }
+
+    *gpuFrameTime = nanoseconds(total);
+    *gpuFrameTimeComplete = pending.complete;
+    return true;
+}
+
+void FrameTimingsRecorder::setLatencyMarkers(clock::duration gpuWait,
+        clock::time_point inputTime) noexcept {
+    if (!mRecording) {
+        return;
+    }
+    mHistory[mCurrent].gpuWaitNanos = duration_cast<nanoseconds>(gpuWait).count();
+    mInputTimes[mCurrent] = inputTime;
+}
+
+void FrameTimingsRecorder::frameCompleted(uint32_t frameId, clock::time_point when) noexcept {
+    // the frame might not be in the history anymore
+    FrameTimings* const frame = findFrame(frameId);
+    if (frame) {
+        clock::time_point const inputTime = mInputTimes[frame - mHistory.data()];
+        if (inputTime != clock::time_point{}) {
+            frame->inputToPresentNanos = duration_cast<nanoseconds>(when - inputTime).count();
+            frame->latencyValid = true;
+        }
+    }
+}
+
+FrameTimingsRecorder::FrameTimings* FrameTimingsRecorder::findFrame(uint32_t frameId) noexcept {
+    for (size_t i = 1; i <= mCompletedCount; i++) {
+        FrameTimings& frame = mHistory[(mCurrent + HISTORY_SIZE - i) % HISTORY_SIZE];
+        if (frame.frameId == frameId) {
+            return &frame;
+        }
+    }
+    return nullptr;
+}
+
+size_t FrameTimingsRecorder::getFrameTimings(FrameTimings* out, size_t count) const noexcept {
+    count = std::min(count, size_t(mCompletedCount));
+    for (size_t i = 0; i < count; i++) {
+        out[i] = mHistory[(mCurrent + HISTORY_SIZE - 1 - i) % HISTORY_SIZE];
+    }
+    return count;
+}
+
+} // namespace filament
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_FRAMETIMINGSRECORDER_H
+#define TNT_FILAMENT_DETAILS_FRAMETIMINGSRECORDER_H
+
+#include "CpuStageTimings.h"
+#include "FrameStatistics.h"
+
+#include "fg2/FrameGraph.h"
+
+#include <filament/Renderer.h>
+
+#include <backend/Handle.h>
+
+#include <private/backend/DriverApi.h>
+
+#include <array>
+#include <chrono>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+/*
+ * Records the timings and statistics of the last few frames, see Renderer::getFrameTimings().
+ *
+ * CPU timings are taken directly. GPU timings of FrameGraph passes use a pool of timer queries,
+ * one set per frame in flight, which are polled at the beginning of each frame.
+ */
+class FrameTimingsRecorder final : public FrameGraph::PassObserver {
+public:
+    using FrameTimings = Renderer::FrameTimings;
+    using FrameTimingOptions = Renderer::FrameTimingOptions;
+    using clock = std::chrono::steady_clock;
+
+    FrameTimingsRecorder() noexcept;
+    ~FrameTimingsRecorder() noexcept;
+
+    void terminate(backend::DriverApi& driver) noexcept;
+
+    // statistics is the current value of the engine's counters, used as a baseline
+    void setOptions(backend::DriverApi& driver, FrameTimingOptions const& options,
+            FrameStatistics::Snapshot const& statistics) noexcept;
+
+    bool isEnabled() const noexcept { return mOptions.enabled; }
+
+    bool hasGpuPassTimings() const noexcept {
+        return mOptions.enabled && mOptions.gpuPassTimings;
+    }
+
+    // Starts recording a new frame. Returns true if the GPU timings of a previous frame became
+    // available, in which case gpuFrameTime is set to its duration. gpuFrameTimeComplete is set
+    // to false if some of the passes of that frame were not timed, gpuFrameTime is then too short.
+    bool beginFrame(backend::DriverApi& driver, uint32_t frameId,
+            std::chrono::nanoseconds* gpuFrameTime, bool* gpuFrameTimeComplete) noexcept;
+
+    // Finishes recording the current frame, which becomes visible in getFrameTimings().
+    // statistics is the current value of the engine's counters.
+    void endFrame(CpuStageTimings const& stages, FrameStatistics::Snapshot const& statistics) noexcept;
+
+    // Records the time beginFrame() waited for the GPU and the time input was sampled, for the
+    // frame being recorded.
+    void setLatencyMarkers(clock::duration gpuWait, clock::time_point inputTime) noexcept;
+
+    // Records that the GPU finished the given frame.
+    void frameCompleted(uint32_t frameId, clock::time_point when) noexcept;
+
+    size_t getFrameTimings(FrameTimings* out, size_t count) const noexcept;
+
+    // FrameGraph::PassObserver
+    void beginPass(backend::DriverApi& driver, const char* name) noexcept override;
+    void endPass(backend::DriverApi& driver) noexcept override;
+
+private:
+    // maximum number of frames in flight for which GPU timings can be pending
+    static constexpr size_t GPU_LATENCY = 3;
+    // maximum number of passes per frame that are timed on the GPU
+    static constexpr size_t MAX_GPU_PASS_COUNT = 32;
+    // one more entry than what we report, for the frame being recorded
+    static constexpr size_t HISTORY_SIZE = Renderer::FRAME_TIMINGS_HISTORY_SIZE + 1;
+
+    struct PendingGpuFrame {
+        uint32_t frameId = 0;
+        uint32_t queryCount = 0;
+        bool pending = false;
+        bool complete = false;      // whether all the passes were timed
+    };
+
+    bool pollGpuTimings(backend::DriverApi& driver, size_t slot,
+            std::chrono::nanoseconds* gpuFrameTime, bool* gpuFrameTimeComplete) noexcept;
+    FrameTimings* findFrame(uint32_t frameId) noexcept;
+    void createQueries(backend::DriverApi& driver) noexcept;
+    void destroyQueries(backend::DriverApi& driver) noexcept;
+
+    FrameTimingOptions mOptions;
+
+    // ring buffer of frame timings, mHistory[mCurrent] is the frame being recorded
+    std::array<FrameTimings, HISTORY_SIZE> mHistory;
+    // time input was sampled for each frame of mHistory, if known
+    std::array<clock::time_point, HISTORY_SIZE> mInputTimes;
+    uint32_t mCurrent = 0;
+    uint32_t mCompletedCount = 0;
+    bool mRecording = false;
+
+    clock::time_point mFrameStart;
+    clock::time_point mPassStart;
+    FrameStatistics::Snapshot mLastStatistics;
+
+    // GPU pass timer queries, one set per frame in flight
+    using QuerySet = std::array<backend::Handle<backend::HwTimerQuery>, MAX_GPU_PASS_COUNT>;
+    std::array<QuerySet, GPU_LATENCY> mQueries;
+    std::array<PendingGpuFrame, GPU_LATENCY> mPendingGpuFrames;
+    uint32_t mGpuSlot = 0;
+    uint32_t mGpuQueryCount = 0;
+    bool mQueriesCreated = false;
+    bool mGpuPassActive = false;
+    bool mGpuPassesTruncated = false;
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_FRAMETIMINGSRECORDER_H
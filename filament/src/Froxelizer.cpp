@@ -122,6 +122,13 @@ void Froxelizer::setOptions(float zLightNear, float zLightFar) noexcept {
 }
 
 
+void Froxelizer::setDensity(float density) noexcept {
+    if (UTILS_UNLIKELY(mDensity != density)) {
+        mDensity = density;
+        mDirtyFlags |= VIEWPORT_CHANGED;
+    }
+}
+
 void Froxelizer::setViewport(filament::Viewport const& viewport) noexcept {
     if (UTILS_UNLIKELY(mViewport != viewport)) {
         mViewport = viewport;
@@ -191,7 +198,7 @@ bool Froxelizer::prepare(
 
 void Froxelizer::computeFroxelLayout(
         uint2* dim, uint16_t* countX, uint16_t* countY, uint16_t* countZ,
-        filament::Viewport const& viewport) noexcept {
+        filament::Viewport const& viewport, float density) noexcept {
 
     auto roundTo8 = [](uint32_t v) { return (v + 7u) & ~7u; };
 
@@ -201,12 +208,14 @@ void Froxelizer::computeFroxelLayout(
     // calculate froxel dimension from FROXEL_BUFFER_ENTRY_COUNT_MAX and viewport
     // - Start from the maximum number of froxels we can use in the x-y plane
     size_t froxelSliceCount = FEngine::CONFIG_FROXEL_SLICE_COUNT;
-    size_t froxelPlaneCount = FROXEL_BUFFER_ENTRY_COUNT_MAX / froxelSliceCount;
+    // - scaled by the requested density
+    size_t froxelPlaneCount = size_t(
+            float(FROXEL_BUFFER_ENTRY_COUNT_MAX / froxelSliceCount) * density);
     // - compute the number of square froxels we need in width and height, rounded down
     //   solving: |  froxelCountX * froxelCountY == froxelPlaneCount
     //            |  froxelCountX / froxelCountY == width / height
-    size_t froxelCountX = size_t(std::sqrt(froxelPlaneCount * width  / height));
-    size_t froxelCountY = size_t(std::sqrt(froxelPlaneCount * height / width));
+    size_t froxelCountX = std::max(size_t(std::sqrt(froxelPlaneCount * width  / height)), size_t(1));
+    size_t froxelCountY = std::max(size_t(std::sqrt(froxelPlaneCount * height / width)), size_t(1));
     // - compute the froxels dimensions, rounded up
     size_t froxelSizeX = (width  + froxelCountX - 1) / froxelCountX;
     size_t froxelSizeY = (height + froxelCountY - 1) / froxelCountY;
@@ -238,7 +247,8 @@ bool Froxelizer::update() noexcept {
 
         uint2 froxelDimension;
         uint16_t froxelCountX, froxelCountY, froxelCountZ;
-        computeFroxelLayout(&froxelDimension, &froxelCountX, &froxelCountY, &froxelCountZ, viewport);
+        computeFroxelLayout(&froxelDimension, &froxelCountX, &froxelCountY, &froxelCountZ,
+                viewport, mDensity);
 
         mFroxelDimension = froxelDimension;
         mClipToFroxelX = (0.5f * viewport.width)  / froxelDimension.x;
@@ -96,6 +96,10 @@ public:
 
     void setOptions(float zLightNear, float zLightFar) noexcept;
 
+    // scales the number of froxels in the x-y plane, between 1/16 and 1
+    void setDensity(float density) noexcept;
+    float getDensity() const noexcept { return mDensity; }
+
     /*
      * Allocate per-frame data structures for froxelization.
      *
@@ -215,7 +219,7 @@ private:
 
     static void computeFroxelLayout(
             math::uint2* dim, uint16_t* countX, uint16_t* countY, uint16_t* countZ,
-            Viewport const& viewport) noexcept;
+            Viewport const& viewport, float density) noexcept;
 
     // internal state dependant on the viewport and needed for froxelizing
     LinearAllocatorArena mArena;                    // ~256 KiB
@@ -253,6 +257,7 @@ private:
     float mNear = 0.0f;        // camera near
     float mZLightFar = FEngine::CONFIG_Z_LIGHT_FAR;
     float mZLightNear = FEngine::CONFIG_Z_LIGHT_NEAR;  // light near (first slice)
+    float mDensity = 1.0f;
 
     // track if we need to update our internal state before froxelizing
     uint8_t mDirtyFlags = 0;
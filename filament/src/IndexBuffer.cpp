@@ -66,6 +66,7 @@ void FIndexBuffer::terminate(FEngine& engine) {
 }
 
 void FIndexBuffer::setBuffer(FEngine& engine, BufferDescriptor&& buffer, uint32_t byteOffset) {
+    engine.getFrameStatistics().uploadedBytes += buffer.size;
     engine.getDriverApi().updateIndexBuffer(mHandle, std::move(buffer), byteOffset);
 }
 
@@ -28,6 +28,8 @@
 
 #include <utils/Log.h>
 
+#include <algorithm>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -199,6 +201,7 @@ FMaterialInstance::FMaterialInstance(FEngine& engine,
 
     if (!material->getSamplerInterfaceBlock().isEmpty()) {
         mSamplers.setSamplers(other->getSamplerGroup());
+        mStreamedSamplers = other->mStreamedSamplers;
         mSbHandle = driver.createSamplerGroup(mSamplers.getSize());
     }
 
@@ -305,7 +308,30 @@ void FMaterialInstance::setParameter(const char* name,
 
 void FMaterialInstance::setParameterImpl(const char* name,
         Texture const* texture, TextureSampler const& sampler) noexcept {
-    setParameter(name, upcast(texture)->getHwHandle(), sampler.getSamplerParams());
+    FTexture const* const t = upcast(texture);
+    size_t index = mMaterial->getSamplerInterfaceBlock().getSamplerInfo(name)->offset;
+    mSamplers.setSampler(index, { t->getHwHandle(), sampler.getSamplerParams() });
+
+    // keep track of streamed textures, so we can follow their handle
+    auto pos = std::find_if(mStreamedSamplers.begin(), mStreamedSamplers.end(),
+            [index](StreamedSampler const& s) { return s.index == index; });
+    if (pos != mStreamedSamplers.end()) {
+        mStreamedSamplers.erase(pos);
+    }
+    if (t->getStreamingId()) {
+        mStreamedSamplers.push_back({ t->getStreamingId(), uint32_t(index) });
+    }
+}
+
+void FMaterialInstance::updateStreamedSamplers(FTextureStreamer const& streamer) noexcept {
+    for (StreamedSampler const& s : mStreamedSamplers) {
+        backend::Handle<backend::HwTexture> const handle = streamer.getHandle(s.streamingId);
+        backend::SamplerGroup::Sampler const& sampler = mSamplers.getSamplers()[s.index];
+        // a null handle means the texture was destroyed, the sampler is left untouched
+        if (handle && handle != sampler.t) {
+            mSamplers.setSampler(s.index, { handle, sampler.s });
+        }
+    }
 }
 
 void FMaterialInstance::setMaskThreshold(float threshold) noexcept {
@@ -144,6 +144,7 @@ void FMorphTargetBuffer::setPositionsAt(FEngine& engine, size_t targetIndex, mat
     Texture::PixelBufferDescriptor buffer(out, size, Texture::Format::RGBA, Texture::Type::FLOAT,
             FREE_CALLBACK);
 
+    engine.getFrameStatistics().uploadedBytes += size;
     FEngine::DriverApi& driver = engine.getDriverApi();
     driver.update3DImage(mTbHandle, 0, 0, 0, getPositionIndex(targetIndex),
             getWidth(mVertexCount), getHeight(mVertexCount), 1,
@@ -166,6 +167,7 @@ void FMorphTargetBuffer::setPositionsAt(FEngine& engine, size_t targetIndex, mat
     Texture::PixelBufferDescriptor buffer(out, size, Texture::Format::RGBA, Texture::Type::FLOAT,
             FREE_CALLBACK);
 
+    engine.getFrameStatistics().uploadedBytes += size;
     FEngine::DriverApi& driver = engine.getDriverApi();
     driver.update3DImage(mTbHandle, 0, 0, 0, getPositionIndex(targetIndex),
             getWidth(mVertexCount), getHeight(mVertexCount), 1,
@@ -189,6 +191,7 @@ void FMorphTargetBuffer::setTangentsAt(FEngine& engine, size_t targetIndex, math
     Texture::PixelBufferDescriptor buffer(out, size, Texture::Format::RGBA, Texture::Type::FLOAT,
             FREE_CALLBACK);
 
+    engine.getFrameStatistics().uploadedBytes += size;
     FEngine::DriverApi& driver = engine.getDriverApi();
     driver.update3DImage(mTbHandle, 0, 0, 0, getTangentIndex(targetIndex),
             getWidth(mVertexCount), getHeight(mVertexCount), 1,
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerRenderableUniforms.h"
+
+#include "UniformBuffer.h"
+
+#include "components/RenderableManager.h"
+
+#include "details/Engine.h"
+
+#include <utils/compiler.h>
+#include <utils/Systrace.h>
+
+#include <math/mat3.h>
+#include <math/mat4.h>
+
+#include <algorithm>
+#include <functional>
+
+#include <string.h>
+
+using namespace utils;
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+PerRenderableUniforms::PerRenderableUniforms() noexcept = default;
+
+PerRenderableUniforms::~PerRenderableUniforms() noexcept = default;
+
+void PerRenderableUniforms::terminate(DriverApi& driver) {
+    driver.destroyBufferObject(mUbh);
+    mUbh.clear();
+}
+
+void PerRenderableUniforms::onInstanceRemoved(FRenderableManager::Instance instance,
+        FRenderableManager::Instance last) noexcept {
+    const uint32_t removed = instance.asValue();
+    const uint32_t moved = last.asValue();
+    if (removed < mRowOfInstance.size()) {
+        if (const uint32_t row = mRowOfInstance[removed]) {
+            // Clear the CPU copy so that the next renderable using this row never matches it
+            // and always gets its row computed and uploaded.
+            mRows[row - 1u] = {};
+            mFreeRows.push_back(row - 1u);
+            mFreeRowsSorted = false;
+        }
+        mRowOfInstance[removed] = 0;
+        if (moved != removed && moved < mRowOfInstance.size()) {
+            mRowOfInstance[removed] = mRowOfInstance[moved];
+            mRowOfInstance[moved] = 0;
+        }
+    }
+}
+
+bool PerRenderableUniforms::update(FEngine& engine, JobSystem& js,
+        FScene::RenderableSoa const& soa, Range<uint32_t> visibleRenderables) noexcept {
+    SYSTRACE_CALL();
+
+    auto const* const UTILS_RESTRICT instances = soa.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* const UTILS_RESTRICT visibility = soa.data<FScene::VISIBILITY_STATE>();
+
+    if (mRowOfRenderable.size() < soa.size()) {
+        mRowOfRenderable.resize(soa.size());
+    }
+    uint32_t* const UTILS_RESTRICT uboRows = mRowOfRenderable.data();
+
+    // Keep the free rows sorted from last to first, so that the lowest ones are reused first and
+    // the ones at the end of the buffer can be dropped, which lets the buffer shrink.
+    if (UTILS_UNLIKELY(!mFreeRowsSorted)) {
+        std::sort(mFreeRows.begin(), mFreeRows.end(), std::greater<>());
+        auto last = mFreeRows.begin();
+        while (last != mFreeRows.end() && *last + 1u == mRows.size()) {
+            mRows.pop_back();
+            ++last;
+        }
+        mFreeRows.erase(mFreeRows.begin(), last);
+        mFreeRowsSorted = true;
+    }
+
+    // Assign the rows first, this is serial but cheap.
+    bool hasContactShadows = false;
+    uint32_t rowCount = uint32_t(mRows.size());
+    for (uint32_t i : visibleRenderables) {
+        const uint32_t instance = instances[i].asValue();
+        if (UTILS_UNLIKELY(instance >= mRowOfInstance.size())) {
+            mRowOfInstance.resize(instance + 1u, 0u);
+        }
+        uint32_t& row = mRowOfInstance[instance];
+        if (UTILS_UNLIKELY(!row)) {
+            if (!mFreeRows.empty()) {
+                row = mFreeRows.back() + 1u;
+                mFreeRows.pop_back();
+            } else {
+                row = ++rowCount;
+            }
+        }
+        uboRows[i] = row - 1u;
+        hasContactShadows = hasContactShadows || visibility[i].screenSpaceContactShadows;
+    }
+
+    // New rows are zero-initialized, their objectId never matches a renderable's entity,
+    // so they're always computed below.
+    mRows.resize(rowCount);
+    mDirtyRows.resize(rowCount, 0);
+
+    bool uploadAll = false;
+    // allocate 1/3 extra, with a minimum of 16 objects, and shrink when less than half of that
+    // is needed
+    const uint32_t capacity = std::max(16u, (4u * rowCount + 2u) / 3u);
+    if (mUboCapacity < rowCount || mUboCapacity > 2u * capacity) {
+        DriverApi& driver = engine.getDriverApi();
+        mUboCapacity = capacity;
+        driver.destroyBufferObject(mUbh);
+        mUbh = driver.createBufferObject(mUboCapacity * sizeof(PerRenderableUib),
+                BufferObjectBinding::UNIFORM, BufferUsage::DYNAMIC);
+        // the content of the new buffer is undefined
+        uploadAll = true;
+    }
+
+    FRenderableManager const& rcm = engine.getRenderableManager();
+    auto work = [this, &rcm, &soa](uint32_t startIndex, uint32_t indexCount) {
+        updateRows(rcm, soa, startIndex, indexCount);
+    };
+
+    if (visibleRenderables.size() <= JOBS_PARALLEL_FOR_COUNT) {
+        work(visibleRenderables.first, visibleRenderables.size());
+    } else {
+        auto* job = jobs::parallel_for(js, nullptr,
+                visibleRenderables.first, (uint32_t)visibleRenderables.size(),
+                std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_COUNT, 4>());
+        js.runAndWait(job);
+    }
+
+    upload(engine, uploadAll);
+
+    return hasContactShadows;
+}
+
+void PerRenderableUniforms::updateRows(FRenderableManager const& rcm,
+        FScene::RenderableSoa const& soa, uint32_t start, uint32_t count) noexcept {
+    auto const* const UTILS_RESTRICT instances      = soa.data<FScene::RENDERABLE_INSTANCE>();
+    auto const* const UTILS_RESTRICT transforms     = soa.data<FScene::WORLD_TRANSFORM>();
+    auto const* const UTILS_RESTRICT visibilities   = soa.data<FScene::VISIBILITY_STATE>();
+    auto const* const UTILS_RESTRICT morphing       = soa.data<FScene::MORPHING_BUFFER>();
+    auto const* const UTILS_RESTRICT channels       = soa.data<FScene::CHANNELS>();
+    auto const* const UTILS_RESTRICT userData       = soa.data<FScene::USER_DATA>();
+    auto const* const UTILS_RESTRICT uboRows        = mRowOfRenderable.data();
+
+    for (uint32_t i = start, e = start + count; i < e; i++) {
+        const uint32_t index = uboRows[i];
+        PerRenderableUib& row = mRows[index];
+
+        mat4f const& world = transforms[i];
+        FRenderableManager::Visibility const visibility = visibilities[i];
+
+        // Quantized positions are dequantized by the model matrix, but tangents aren't quantized
+        // so the normal matrix below only uses the world transform.
+        mat4f model = world;
+        if (UTILS_UNLIKELY(visibility.quantizedPositions)) {
+            Box const& bounds = rcm.getQuantizedPositions(instances[i]);
+            // A flat box quantizes its flat axis to 0, any scale works there. We use 1 so the
+            // model matrix still depends on all of the world transform.
+            const float3 e = bounds.halfExtent;
+            const float3 scale{ e.x != 0.0f ? e.x : 1.0f,
+                                e.y != 0.0f ? e.y : 1.0f,
+                                e.z != 0.0f ? e.z : 1.0f };
+            model = world * mat4f::translation(bounds.center) * mat4f::scaling(scale);
+        }
+
+        // Note that we cast bool to uint32_t. Booleans are byte-sized in C++, but we need to
+        // initialize all 32 bits in the UBO field.
+        const uint32_t flags = PerRenderableUib::packFlags(
+                visibility.skinning,
+                visibility.morphing,
+                visibility.screenSpaceContactShadows);
+        const uint32_t morphTargetCount = morphing[i].count;
+        const uint32_t channel = channels[i];
+        const uint32_t objectId = rcm.getEntity(instances[i]).getId();
+
+        // The normal matrix only depends on the world transform (reversedWindingOrder is derived
+        // from it), which the model matrix is derived from, so comparing the model matrix is
+        // enough to know it didn't change.
+        if (!memcmp(&row.worldFromModelMatrix, &model, sizeof(mat4f)) &&
+                row.flags == flags &&
+                row.morphTargetCount == morphTargetCount &&
+                row.channels == channel &&
+                row.objectId == objectId &&
+                !memcmp(&row.userData, &userData[i], sizeof(float))) {
+            continue;
+        }
+
+        void* const buffer = &row;
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, worldFromModelMatrix), model);
+
+        // Using mat3f::getTransformForNormals handles non-uniform scaling, but DOESN'T guarantee that
+        // the transformed normals will have unit-length, therefore they need to be normalized
+        // in the shader (that's already the case anyways, since normalization is needed after
+        // interpolation).
+        //
+        // We pre-scale normals by the inverse of the largest scale factor to avoid
+        // large post-transform magnitudes in the shader, especially in the fragment shader, where
+        // we use medium precision.
+        //
+        // Note: if the model matrix is known to be a rigid-transform, we could just use it directly.
+
+        mat3f m = mat3f::getTransformForNormals(world.upperLeft());
+        m *= mat3f(1.0f / std::sqrt(max(float3{length2(m[0]), length2(m[1]), length2(m[2])})));
+
+        // The shading normal must be flipped for mirror transformations.
+        // Basically we're shading the other side of the polygon and therefore need to negate the
+        // normal, similar to what we already do to support double-sided lighting.
+        if (visibility.reversedWindingOrder) {
+            m = -m;
+        }
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, worldFromModelNormalMatrix), m);
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, flags), flags);
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, morphTargetCount), morphTargetCount);
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, channels), channel);
+
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, objectId), objectId);
+
+        // TODO: We need to find a better way to provide the scale information per object
+        UniformBuffer::setUniform(buffer,
+                offsetof(PerRenderableUib, userData), userData[i]);
+
+        // each visible renderable has its own row, so there is no race here
+        mDirtyRows[index] = 1;
+    }
+}
+
+void PerRenderableUniforms::upload(FEngine& engine, bool all) noexcept {
+    DriverApi& driver = engine.getDriverApi();
+    uint8_t* const UTILS_RESTRICT dirty = mDirtyRows.data();
+    const uint32_t rowCount = uint32_t(mRows.size());
+
+    if (all) {
+        std::fill_n(dirty, rowCount, 1);
+    }
+
+    // Upload the dirty rows, coalesced into ranges. Small gaps of clean rows are uploaded
+    // with their neighbours, which is cheaper than an extra update.
+    size_t uploadedBytes = 0;
+    uint32_t i = 0;
+    while (i < rowCount) {
+        if (!dirty[i]) {
+            i++;
+            continue;
+        }
+        const uint32_t first = i;
+        uint32_t last = i + 1;  // one past the last dirty row of the range
+        for (uint32_t j = last; j < rowCount && j - last <= MAX_CLEAN_ROWS_IN_RANGE; j++) {
+            if (dirty[j]) {
+                last = j + 1;
+            }
+        }
+        std::fill(dirty + first, dirty + last, 0);
+
+        const size_t size = (last - first) * sizeof(PerRenderableUib);
+        void* const buffer = driver.allocate(size);
+        memcpy(buffer, mRows.data() + first, size);
+        driver.updateBufferObject(mUbh, { buffer, size }, first * sizeof(PerRenderableUib));
+        uploadedBytes += size;
+        i = last;
+    }
+
+    engine.getFrameStatistics().uploadedBytes += uploadedBytes;
+}
+
+} // namespace filament
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_PERRENDERABLEUNIFORMS_H
+#define TNT_FILAMENT_PERRENDERABLEUNIFORMS_H
+
+#include "details/Scene.h"
+
+#include "components/RenderableManager.h"
+
+#include <private/filament/UibStructs.h>
+
+#include <backend/Handle.h>
+
+#include <utils/JobSystem.h>
+#include <utils/Range.h>
+
+#include <vector>
+
+#include <stdint.h>
+
+namespace filament {
+
+class FEngine;
+
+/*
+ * The per-renderable uniform buffer of a View.
+ *
+ * Each renderable is given a row of the buffer the first time it's visible, and keeps it for as
+ * long as the renderable instance exists. Rows stay resident on the GPU, so that every frame only
+ * the rows of the renderables whose data changed are recomputed and uploaded.
+ * A CPU copy of the buffer is used to detect these changes.
+ *
+ * The rows belong to the View, a Scene shared by several Views doesn't share their rows.
+ */
+class PerRenderableUniforms {
+public:
+    PerRenderableUniforms() noexcept;
+    ~PerRenderableUniforms() noexcept;
+
+    PerRenderableUniforms(PerRenderableUniforms const&) = delete;
+    PerRenderableUniforms& operator=(PerRenderableUniforms const&) = delete;
+
+    void terminate(backend::DriverApi& driver);
+
+    // Assigns a row to the visible renderables, and updates their rows.
+    // Returns whether one of the visible renderables uses screen-space contact shadows.
+    bool update(FEngine& engine, utils::JobSystem& js,
+            FScene::RenderableSoa const& soa, utils::Range<uint32_t> visibleRenderables) noexcept;
+
+    // Frees the row of a renderable instance that is being removed. `last` is the instance moved
+    // in its place by the RenderableManager, it keeps its row.
+    void onInstanceRemoved(FRenderableManager::Instance instance,
+            FRenderableManager::Instance last) noexcept;
+
+    backend::Handle<backend::HwBufferObject> getUboHandle() const noexcept { return mUbh; }
+
+    // Row of each renderable of the SoA passed to the last update(), only valid for the
+    // renderables that were visible.
+    uint32_t const* getRows() const noexcept { return mRowOfRenderable.data(); }
+
+    // number of rows in use, for testing
+    size_t getUsedRowCount() const noexcept { return mRows.size() - mFreeRows.size(); }
+
+    // size of the UBO in rows, for testing
+    uint32_t getUboCapacity() const noexcept { return mUboCapacity; }
+
+    // CPU copy of a row, for testing
+    PerRenderableUib const& getRowData(uint32_t row) const noexcept { return mRows[row]; }
+
+private:
+    // visible renderables processed per job
+    static constexpr uint32_t JOBS_PARALLEL_FOR_COUNT = 256;
+
+    // dirty rows separated by at most this many clean rows are uploaded together
+    static constexpr uint32_t MAX_CLEAN_ROWS_IN_RANGE = 4;
+
+    void updateRows(FRenderableManager const& rcm, FScene::RenderableSoa const& soa,
+            uint32_t start, uint32_t count) noexcept;
+
+    void upload(FEngine& engine, bool all) noexcept;
+
+    // row + 1 of each renderable instance, or 0 if it doesn't have a row yet
+    std::vector<uint32_t> mRowOfInstance;
+
+    // rows of removed instances, reused before the buffer grows
+    std::vector<uint32_t> mFreeRows;
+    bool mFreeRowsSorted = true;
+
+    // row of each renderable of the SoA, indexed like the SoA
+    std::vector<uint32_t> mRowOfRenderable;
+
+    // CPU copy of the UBO, and rows that changed this frame
+    std::vector<PerRenderableUib> mRows;
+    std::vector<uint8_t> mDirtyRows;
+
+    backend::Handle<backend::HwBufferObject> mUbh;
+    uint32_t mUboCapacity = 0;  // in rows
+};
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_PERRENDERABLEUNIFORMS_H
@@ -275,6 +275,7 @@ void PerViewUniforms::prepareShadowMapping(ShadowMappingUniforms const& shadowMa
     s.vsmLightBleedReduction = options.lightBleedReduction;
 
     s.lightFromWorldMatrix = shadowMappingUniforms.lightFromWorldMatrix;
+    s.cascadeTileRects = shadowMappingUniforms.cascadeTileRects;
     s.cascadeSplits = shadowMappingUniforms.cascadeSplits;
     s.shadowBulbRadiusLs = shadowMappingUniforms.shadowBulbRadiusLs;
     s.shadowBias = shadowMappingUniforms.shadowBias;
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filament/PixelReadbackRing.h>
+
+#include <filament/Engine.h>
+#include <filament/Renderer.h>
+
+#include <backend/PixelBufferDescriptor.h>
+
+#include <utils/Panic.h>
+#include <utils/debug.h>
+
+#include <array>
+
+#include <stdlib.h>
+
+using namespace filament::backend;
+
+namespace filament {
+
+// The state is shared with the read-backs in flight, so that the ring can be destroyed before
+// they complete. All of it is only accessed from the main thread, where the callbacks run.
+struct PixelReadbackRing::State {
+    enum class Status : uint8_t {
+        FREE, IN_FLIGHT, READY, ACQUIRED
+    };
+
+    struct Slot {
+        State* state = nullptr;
+        void* buffer = nullptr;
+        uint64_t sequence = 0;
+        Status status = Status::FREE;
+    };
+
+    uint32_t width;
+    uint32_t height;
+    PixelDataFormat format;
+    PixelDataType type;
+    size_t bufferSize;
+    uint8_t depth;
+    bool ownsBuffers;
+
+    uint8_t head = 0;       // next slot to capture into
+    uint8_t tail = 0;       // oldest captured slot
+    uint8_t pending = 0;    // slots captured and not released
+    uint64_t sequence = 0;  // sequence number of the next capture
+
+    // one reference for the ring, plus one per read-back in flight
+    uint32_t refCount = 1;
+
+    std::array<Slot, MAX_DEPTH> slots;
+
+    void release() noexcept {
+        if (--refCount == 0) {
+            if (ownsBuffers) {
+                for (uint8_t i = 0; i < depth; i++) {
+                    free(slots[i].buffer);
+                }
+            }
+            delete this;
+        }
+    }
+
+    static void onReadbackComplete(void*, size_t, void* user) {
+        Slot* const slot = static_cast<Slot*>(user);
+        assert_invariant(slot->status == Status::IN_FLIGHT);
+        slot->status = Status::READY;
+        slot->state->release();
+    }
+};
+
+PixelReadbackRing::PixelReadbackRing(uint32_t width, uint32_t height, uint8_t depth,
+        PixelDataFormat format, PixelDataType type, void* const* buffers)
+        : mState(new State{ width, height, format, type,
+                            getBufferSize(width, height, format, type), depth, !buffers }) {
+    ASSERT_PRECONDITION(depth > 0 && depth <= MAX_DEPTH,
+            "PixelReadbackRing depth must be between 1 and %u", MAX_DEPTH);
+    ASSERT_PRECONDITION(width > 0 && height > 0, "PixelReadbackRing size must not be empty");
+    State& state = *mState;
+    for (uint8_t i = 0; i < depth; i++) {
+        State::Slot& slot = state.slots[i];
+        slot.state = mState;
+        slot.buffer = buffers ? buffers[i] : malloc(state.bufferSize);
+    }
+}
+
+PixelReadbackRing::~PixelReadbackRing() noexcept {
+    mState->release();
+}
+
+size_t PixelReadbackRing::getBufferSize(uint32_t width, uint32_t height,
+        PixelDataFormat format, PixelDataType type) noexcept {
+    return PixelBufferDescriptor::computeDataSize(format, type, width, height, 1);
+}
+
+size_t PixelReadbackRing::getBufferSize() const noexcept {
+    return mState->bufferSize;
+}
+
+uint8_t PixelReadbackRing::getDepth() const noexcept {
+    return mState->depth;
+}
+
+uint8_t PixelReadbackRing::getPendingCount() const noexcept {
+    return mState->pending;
+}
+
+bool PixelReadbackRing::capture(Renderer* renderer, RenderTarget* renderTarget,
+        uint32_t xoffset, uint32_t yoffset) {
+    State& state = *mState;
+    if (state.pending == state.depth) {
+        return false;
+    }
+
+    State::Slot& slot = state.slots[state.head];
+    assert_invariant(slot.status == State::Status::FREE);
+    slot.status = State::Status::IN_FLIGHT;
+    slot.sequence = state.sequence++;
+    state.head = uint8_t((state.head + 1u) % state.depth);
+    state.pending++;
+    state.refCount++;
+
+    PixelBufferDescriptor pbd(slot.buffer, state.bufferSize, state.format, state.type,
+            &State::onReadbackComplete, &slot);
+    if (renderTarget) {
+        renderer->readPixels(renderTarget, xoffset, yoffset, state.width, state.height,
+                std::move(pbd));
+    } else {
+        renderer->readPixels(xoffset, yoffset, state.width, state.height, std::move(pbd));
+    }
+    return true;
+}
+
+bool PixelReadbackRing::acquire(Frame* frame) noexcept {
+    State& state = *mState;
+    if (!state.pending) {
+        return false;
+    }
+    State::Slot& slot = state.slots[state.tail];
+    assert_invariant(slot.status != State::Status::ACQUIRED);
+    if (slot.status != State::Status::READY) {
+        return false;
+    }
+    slot.status = State::Status::ACQUIRED;
+    *frame = { slot.buffer, state.bufferSize, slot.sequence };
+    return true;
+}
+
+void PixelReadbackRing::release() noexcept {
+    State& state = *mState;
+    State::Slot& slot = state.slots[state.tail];
+    assert_invariant(state.pending && slot.status == State::Status::ACQUIRED);
+    slot.status = State::Status::FREE;
+    state.tail = uint8_t((state.tail + 1u) % state.depth);
+    state.pending--;
+}
+
+void PixelReadbackRing::waitForOldest(Engine& engine) {
+    State const& state = *mState;
+    if (state.pending && state.slots[state.tail].status == State::Status::IN_FLIGHT) {
+        // This waits for all the read-backs in flight, not just the oldest, but we only get
+        // here if the GPU is already late.
+        engine.flushAndWait();
+    }
+}
+
+void PixelReadbackRing::flush(Engine& engine) {
+    State const& state = *mState;
+    for (uint8_t i = 0; i < state.depth; i++) {
+        if (state.slots[i].status == State::Status::IN_FLIGHT) {
+            engine.flushAndWait();
+            break;
+        }
+    }
+}
+
+} // namespace filament
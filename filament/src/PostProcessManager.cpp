@@ -782,7 +782,7 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::generateGaussianMipmap(Frame
 FrameGraphId<FrameGraphTexture> PostProcessManager::gaussianBlurPass(FrameGraph& fg,
         FrameGraphId<FrameGraphTexture> input, uint8_t srcLevel,
         FrameGraphId<FrameGraphTexture> output, uint8_t dstLevel, uint8_t layer,
-        bool reinhard, size_t kernelWidth, float sigmaRatio) noexcept {
+        bool reinhard, size_t kernelWidth, float sigmaRatio, const char* name) noexcept {
 
     const float sigma = (kernelWidth + 1.0f) / sigmaRatio;
 
@@ -835,7 +835,7 @@ FrameGraphId<FrameGraphTexture> PostProcessManager::gaussianBlurPass(FrameGraph&
     // and because it's a separable filter, the effective 2D filter kernel size is 17*17
     // The total number of samples needed over the two passes is 18.
 
-    fg.addPass<BlurPassData>("Gaussian Blur Passes",
+    fg.addPass<BlurPassData>(name,
             [&](FrameGraph::Builder& builder, auto& data) {
                 auto desc = builder.getDescriptor(input);
 
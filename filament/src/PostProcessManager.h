@@ -151,10 +151,12 @@ public:
             FrameGraphId<FrameGraphTexture> input, uint8_t layer, size_t level,
             math::float4 clearColor, bool finalize) noexcept;
 
+    // name is the name of the FrameGraph pass, which must outlive the FrameGraph
     FrameGraphId<FrameGraphTexture> gaussianBlurPass(FrameGraph& fg,
             FrameGraphId<FrameGraphTexture> input, uint8_t srcLevel,
             FrameGraphId<FrameGraphTexture> output, uint8_t dstLevel, uint8_t layer,
-            bool reinhard, size_t kernelWidth, float sigma = 6.0f) noexcept;
+            bool reinhard, size_t kernelWidth, float sigma = 6.0f,
+            const char* name = "Gaussian Blur Passes") noexcept;
 
     backend::Handle<backend::HwTexture> getOneTexture() const;
     backend::Handle<backend::HwTexture> getZeroTexture() const;
@@ -0,0 +1,486 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <filament/QualityGovernor.h>
+
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/Options.h>
+#include <filament/View.h>
+
+#include <utils/Panic.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <string.h>
+
+using namespace utils;
+
+namespace filament {
+
+using Lever = QualityGovernor::Lever;
+
+static constexpr uint32_t MIN_SHADOW_MAP_SIZE = 256;
+static constexpr uint8_t MIN_BLOOM_LEVELS = 3;
+static constexpr size_t VSM_BLUR_STEPS = 3;
+static constexpr float MIN_FROXEL_DENSITY = 1.0f / 16.0f;
+
+// The least noticeable degradations come first. Shadows and SSAO are degraded before they're
+// degraded again, so that no single effect falls apart while others are still at full quality.
+static constexpr Lever DEFAULT_LADDER[] = {
+        Lever::VSM_BLUR,
+        Lever::AMBIENT_OCCLUSION,
+        Lever::BLOOM,
+        Lever::SHADOW_MAP_SIZE,
+        Lever::SHADOW_CASCADES,
+        Lever::MSAA,
+        Lever::FROXEL_DENSITY,
+        Lever::AMBIENT_OCCLUSION,
+        Lever::SHADOW_MAP_SIZE,
+        Lever::BLOOM,
+        Lever::VSM_BLUR,
+        Lever::SHADOW_CASCADES,
+        Lever::MSAA,
+        Lever::FROXEL_DENSITY,
+        Lever::AMBIENT_OCCLUSION,
+        Lever::SHADOW_MAP_SIZE,
+        Lever::VSM_BLUR,
+        Lever::SHADOW_CASCADES,
+        Lever::AMBIENT_OCCLUSION,
+};
+
+// Returns whether degrading the lever makes the given FrameGraph pass cheaper
+static bool isPassAffectedBy(Lever lever, const char* name) noexcept {
+    auto startsWith = [name](const char* prefix) {
+        return strncmp(name, prefix, strlen(prefix)) == 0;
+    };
+    switch (lever) {
+        case Lever::AMBIENT_OCCLUSION:
+            return startsWith("SSAO") || startsWith("Separable Blur Pass");
+        case Lever::SHADOW_MAP_SIZE:
+        case Lever::SHADOW_CASCADES:
+            return startsWith("Shadow Pass") || startsWith("VSM Generate Mipmap Pass");
+        case Lever::BLOOM:
+            return startsWith("Bloom");
+        case Lever::MSAA:
+            return startsWith("Color Pass");
+        case Lever::VSM_BLUR:
+            // not "Gaussian Blur Passes", which blurs bloom's flare and the SSR mipmaps
+            return startsWith("VSM Gaussian Blur Passes");
+        case Lever::FROXEL_DENSITY:
+            // froxelization is accounted for by its frame stage
+            return false;
+    }
+    return false;
+}
+
+struct QualityGovernor::State {
+    Engine& engine;
+    View* const view;
+    Options const options;
+    std::vector<Lever> ladder;
+
+    // full quality settings
+    AmbientOcclusionOptions ambientOcclusion;
+    BloomOptions bloom;
+    MultiSampleAntiAliasingOptions msaa;
+    float froxelDensity = 1.0f;
+    std::vector<Entity> lights;
+    std::vector<LightManager::ShadowOptions> shadowOptions;
+
+    // rungs of the ladder currently applied, in the order they were applied
+    std::vector<uint8_t> applied;
+    std::vector<bool> isApplied;
+    std::array<uint8_t, LEVER_COUNT> degradations{};
+
+    // controller
+    uint32_t overBudgetCount = 0;
+    uint32_t underBudgetCount = 0;
+    uint32_t settleCount = 0;
+    uint32_t upFrameCount = 0;
+    uint32_t framesSinceChange = 0;
+    bool lastChangeWasUp = false;
+    bool hasLastFrameId = false;
+    uint32_t lastFrameId = 0;
+    std::vector<Renderer::FrameTimings> history;
+
+    State(Engine& engine, View* view, Options const& options) noexcept
+            : engine(engine), view(view), options(options), upFrameCount(options.upFrameCount) {
+    }
+
+    void capture() noexcept;
+    bool canDegrade(Lever lever, size_t degradation) const noexcept;
+    float estimateSaving(Lever lever, size_t degradation) const noexcept;
+    void apply(Lever lever) noexcept;
+    void applyAll() noexcept;
+    bool stepDown(Renderer::FrameTimings const& timings) noexcept;
+    bool stepUp() noexcept;
+    void changed(bool up) noexcept;
+};
+
+void QualityGovernor::State::capture() noexcept {
+    ambientOcclusion = view->getAmbientOcclusionOptions();
+    bloom = view->getBloomOptions();
+    msaa = view->getMultiSampleAntiAliasingOptions();
+    froxelDensity = view->getFroxelDensity();
+    LightManager& lm = engine.getLightManager();
+    shadowOptions.resize(lights.size());
+    for (size_t i = 0, c = lights.size(); i < c; i++) {
+        LightManager::Instance const li = lm.getInstance(lights[i]);
+        shadowOptions[i] = li ? lm.getShadowOptions(li) : LightManager::ShadowOptions{};
+    }
+}
+
+bool QualityGovernor::State::canDegrade(Lever lever, size_t degradation) const noexcept {
+    switch (lever) {
+        case Lever::AMBIENT_OCCLUSION:
+            // one step per quality level, then disable
+            return ambientOcclusion.enabled && degradation <= size_t(ambientOcclusion.quality);
+        case Lever::SHADOW_MAP_SIZE:
+            return std::any_of(shadowOptions.begin(), shadowOptions.end(),
+                    [degradation](auto const& options) {
+                        return (options.mapSize >> (degradation + 1)) >= MIN_SHADOW_MAP_SIZE;
+                    });
+        case Lever::SHADOW_CASCADES:
+            return std::any_of(shadowOptions.begin(), shadowOptions.end(),
+                    [degradation](auto const& options) {
+                        return options.shadowCascades > degradation + 1;
+                    });
+        case Lever::BLOOM:
+            return bloom.enabled && bloom.levels > degradation + MIN_BLOOM_LEVELS;
+        case Lever::MSAA:
+            return msaa.enabled && (msaa.sampleCount >> degradation) > 1;
+        case Lever::VSM_BLUR:
+            return degradation < VSM_BLUR_STEPS &&
+                    std::any_of(shadowOptions.begin(), shadowOptions.end(),
+                            [](auto const& options) { return options.vsm.blurWidth > 0.0f; });
+        case Lever::FROXEL_DENSITY:
+            return froxelDensity / float(1u << (degradation + 1)) >= MIN_FROXEL_DENSITY;
+    }
+    return false;
+}
+
+// Estimates the fraction of the cost of the lever's passes that degrading it once more saves.
+// These are rough heuristics: what matters is that a lever isn't charged for the parts of a pass
+// it doesn't make cheaper, e.g. MSAA for the shading of the color pass.
+float QualityGovernor::State::estimateSaving(Lever lever, size_t degradation) const noexcept {
+    switch (lever) {
+        case Lever::AMBIENT_OCCLUSION:
+            // each quality level takes about half the samples, the last step disables it
+            return degradation < size_t(ambientOcclusion.quality) ? 0.5f : 1.0f;
+        case Lever::SHADOW_MAP_SIZE:
+            // a quarter of the texels, but the geometry is still processed
+            return 0.5f;
+        case Lever::SHADOW_CASCADES: {
+            // one cascade less
+            uint8_t cascades = 1;
+            for (auto const& options : shadowOptions) {
+                cascades = std::max(cascades, options.shadowCascades);
+            }
+            return 1.0f / float(std::max(size_t(cascades) - degradation, size_t(1)));
+        }
+        case Lever::BLOOM:
+            // one level less
+            return 1.0f / float(std::max(size_t(bloom.levels) - degradation, size_t(1)));
+        case Lever::MSAA:
+            // half the samples, only the rasterization and the resolve get cheaper
+            return 0.25f;
+        case Lever::VSM_BLUR:
+            // half the kernel width, the last step disables it
+            return degradation + 1 < VSM_BLUR_STEPS ? 0.5f : 1.0f;
+        case Lever::FROXEL_DENSITY:
+            // half the froxels
+            return 0.5f;
+    }
+    return 0.0f;
+}
+
+void QualityGovernor::State::apply(Lever lever) noexcept {
+    const size_t degradation = degradations[size_t(lever)];
+    switch (lever) {
+        case Lever::AMBIENT_OCCLUSION: {
+            AmbientOcclusionOptions options = ambientOcclusion;
+            if (degradation > size_t(options.quality)) {
+                options.enabled = false;
+            } else {
+                options.quality = QualityLevel(size_t(options.quality) - degradation);
+            }
+            view->setAmbientOcclusionOptions(options);
+            break;
+        }
+        case Lever::BLOOM: {
+            BloomOptions options = bloom;
+            options.levels = uint8_t(std::max(size_t(MIN_BLOOM_LEVELS),
+                    size_t(options.levels) - std::min(size_t(options.levels), degradation)));
+            view->setBloomOptions(options);
+            break;
+        }
+        case Lever::MSAA: {
+            MultiSampleAntiAliasingOptions options = msaa;
+            options.sampleCount = uint8_t(std::max(options.sampleCount >> degradation, 1));
+            options.enabled = options.enabled && options.sampleCount > 1;
+            view->setMultiSampleAntiAliasingOptions(options);
+            break;
+        }
+        case Lever::FROXEL_DENSITY:
+            view->setFroxelDensity(froxelDensity / float(1u << degradation));
+            break;
+        case Lever::SHADOW_MAP_SIZE:
+        case Lever::SHADOW_CASCADES:
+        case Lever::VSM_BLUR: {
+            // these levers share the lights' ShadowOptions
+            const size_t mapSizeDegradation = degradations[size_t(Lever::SHADOW_MAP_SIZE)];
+            const size_t cascadesDegradation = degradations[size_t(Lever::SHADOW_CASCADES)];
+            const size_t blurDegradation = degradations[size_t(Lever::VSM_BLUR)];
+            LightManager& lm = engine.getLightManager();
+            for (size_t i = 0, c = lights.size(); i < c; i++) {
+                LightManager::Instance const li = lm.getInstance(lights[i]);
+                if (!li) {
+                    continue;
+                }
+                LightManager::ShadowOptions options = shadowOptions[i];
+                options.mapSize = std::max(options.mapSize >> mapSizeDegradation,
+                        std::min(options.mapSize, MIN_SHADOW_MAP_SIZE));
+                options.shadowCascades = uint8_t(std::max(
+                        int(options.shadowCascades) - int(cascadesDegradation), 1));
+                options.vsm.blurWidth = blurDegradation >= VSM_BLUR_STEPS ? 0.0f :
+                        options.vsm.blurWidth / float(1u << blurDegradation);
+                lm.setShadowOptions(li, options);
+            }
+            break;
+        }
+    }
+}
+
+void QualityGovernor::State::applyAll() noexcept {
+    for (size_t i = 0; i < LEVER_COUNT; i++) {
+        apply(Lever(i));
+    }
+}
+
+bool QualityGovernor::State::stepDown(Renderer::FrameTimings const& timings) noexcept {
+    // Cost of the passes each lever affects. Only the time of the side that bounds the frame is
+    // counted, making the other side cheaper wouldn't help: the GPU times when GPU bound, and the
+    // CPU times, including froxelization, otherwise.
+    const bool gpuBound = timings.gpuTimingsValid &&
+            timings.gpuFrameTimeNanos >= timings.cpuFrameTimeNanos;
+    std::array<uint64_t, LEVER_COUNT> costs{};
+    const size_t passCount = std::min(size_t(timings.passCount),
+            Renderer::FrameTimings::MAX_PASS_COUNT);
+    for (size_t i = 0; i < passCount; i++) {
+        Renderer::PassTiming const& pass = timings.passes[i];
+        const uint64_t cost = gpuBound ? pass.gpuTimeNanos : pass.cpuTimeNanos;
+        for (size_t l = 0; l < LEVER_COUNT; l++) {
+            if (pass.name && isPassAffectedBy(Lever(l), pass.name)) {
+                costs[l] += cost;
+            }
+        }
+    }
+    if (!gpuBound) {
+        costs[size_t(Lever::FROXEL_DENSITY)] +=
+                timings.stageCpuTimeNanos[size_t(Renderer::FrameStage::FROXELIZATION)];
+    }
+
+    // pick the lever expected to save the most that can still be degraded, or the first one in
+    // ladder order
+    std::array<float, LEVER_COUNT> savings{};
+    for (size_t l = 0; l < LEVER_COUNT; l++) {
+        savings[l] = float(costs[l]) * estimateSaving(Lever(l), degradations[l]);
+    }
+    size_t best = ladder.size();
+    for (size_t i = 0, c = ladder.size(); i < c; i++) {
+        const Lever lever = ladder[i];
+        if (isApplied[i] || !canDegrade(lever, degradations[size_t(lever)])) {
+            continue;
+        }
+        if (best == ladder.size() || savings[size_t(lever)] > savings[size_t(ladder[best])]) {
+            best = i;
+        }
+    }
+    if (best == ladder.size()) {
+        // we're already at the lowest quality
+        return false;
+    }
+
+    const Lever lever = ladder[best];
+    isApplied[best] = true;
+    applied.push_back(uint8_t(best));
+    degradations[size_t(lever)]++;
+    apply(lever);
+
+    // if the last step up didn't hold, wait longer before trying again
+    const bool bounced = lastChangeWasUp &&
+            framesSinceChange <= uint32_t(options.settleFrameCount + options.upFrameCount);
+    upFrameCount = bounced ?
+            std::min(upFrameCount * 2u, uint32_t(options.maxUpFrameCount)) :
+            uint32_t(options.upFrameCount);
+    changed(false);
+    return true;
+}
+
+bool QualityGovernor::State::stepUp() noexcept {
+    if (applied.empty()) {
+        return false;
+    }
+    const size_t rung = applied.back();
+    const Lever lever = ladder[rung];
+    applied.pop_back();
+    isApplied[rung] = false;
+    degradations[size_t(lever)]--;
+    apply(lever);
+    changed(true);
+    return true;
+}
+
+void QualityGovernor::State::changed(bool up) noexcept {
+    overBudgetCount = 0;
+    underBudgetCount = 0;
+    settleCount = options.settleFrameCount;
+    framesSinceChange = 0;
+    lastChangeWasUp = up;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+QualityGovernor::QualityGovernor(Engine& engine, View* view, Options const& options,
+        Lever const* ladder, size_t ladderSize)
+        : mState(new State(engine, view, options)) {
+    ASSERT_PRECONDITION(view, "QualityGovernor needs a View");
+    ASSERT_PRECONDITION(ladderSize <= MAX_LADDER_SIZE,
+            "QualityGovernor ladder can't have more than %u rungs", unsigned(MAX_LADDER_SIZE));
+    ASSERT_PRECONDITION(options.upThreshold <= options.downThreshold,
+            "QualityGovernor upThreshold must not be greater than downThreshold");
+    State& state = *mState;
+    if (ladder) {
+        state.ladder.assign(ladder, ladder + ladderSize);
+    } else {
+        state.ladder.assign(std::begin(DEFAULT_LADDER), std::end(DEFAULT_LADDER));
+    }
+    state.isApplied.resize(state.ladder.size(), false);
+    state.applied.reserve(state.ladder.size());
+    state.capture();
+}
+
+QualityGovernor::QualityGovernor(Engine& engine, View* view)
+        : QualityGovernor(engine, view, Options{}) {
+}
+
+QualityGovernor::~QualityGovernor() noexcept {
+    delete mState;
+}
+
+void QualityGovernor::setShadowCasters(Entity const* lights, size_t count) {
+    State& state = *mState;
+    restore();
+    state.lights.assign(lights, lights + count);
+    state.capture();
+}
+
+void QualityGovernor::reset() {
+    restore();
+    mState->capture();
+}
+
+void QualityGovernor::restore() {
+    State& state = *mState;
+    if (state.applied.empty()) {
+        // already at full quality
+        return;
+    }
+    state.applied.clear();
+    std::fill(state.isApplied.begin(), state.isApplied.end(), false);
+    state.degradations.fill(0);
+    state.applyAll();
+    state.upFrameCount = state.options.upFrameCount;
+    state.changed(false);
+}
+
+bool QualityGovernor::update(Renderer::FrameTimings const& timings) {
+    State& state = *mState;
+    Options const& options = state.options;
+
+    state.framesSinceChange++;
+    if (state.settleCount) {
+        state.settleCount--;
+        return false;
+    }
+
+    const uint64_t frameTimeNanos = std::max(timings.cpuFrameTimeNanos,
+            timings.gpuTimingsValid ? timings.gpuFrameTimeNanos : 0);
+    const float frameTime = float(frameTimeNanos) * 1e-6f;
+    const float target = options.targetFrameTimeMilli;
+
+    if (frameTime > target * options.downThreshold) {
+        state.overBudgetCount++;
+        state.underBudgetCount = 0;
+    } else if (frameTime < target * options.upThreshold) {
+        state.underBudgetCount++;
+        state.overBudgetCount = 0;
+    } else {
+        // within the hysteresis band, we're where we want to be
+        state.overBudgetCount = 0;
+        state.underBudgetCount = 0;
+    }
+
+    if (state.overBudgetCount >= options.downFrameCount) {
+        state.overBudgetCount = 0;
+        return state.stepDown(timings);
+    }
+    if (state.underBudgetCount >= state.upFrameCount) {
+        state.underBudgetCount = 0;
+        return state.stepUp();
+    }
+    return false;
+}
+
+bool QualityGovernor::update(Renderer const* renderer) {
+    State& state = *mState;
+    auto& history = state.history;
+    history.resize(Renderer::FRAME_TIMINGS_HISTORY_SIZE);
+    const size_t count = renderer->getFrameTimings(history.data(), history.size());
+    if (!count) {
+        return false;
+    }
+
+    // the most recent frame with GPU timings, or the most recent frame if there is none
+    size_t index = 0;
+    while (index < count && !history[index].gpuTimingsValid) {
+        index++;
+    }
+    if (index == count) {
+        index = 0;
+    }
+
+    Renderer::FrameTimings const& timings = history[index];
+    if (state.hasLastFrameId && int32_t(timings.frameId - state.lastFrameId) <= 0) {
+        return false;
+    }
+    state.hasLastFrameId = true;
+    state.lastFrameId = timings.frameId;
+    return update(timings);
+}
+
+size_t QualityGovernor::getLevel() const noexcept {
+    return mState->applied.size();
+}
+
+size_t QualityGovernor::getDegradation(Lever lever) const noexcept {
+    return mState->degradations[size_t(lever)];
+}
+
+} // namespace filament
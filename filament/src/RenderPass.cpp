@@ -67,10 +67,11 @@ void RenderPass::resize(size_t count) noexcept {
 }
 
 void RenderPass::setGeometry(FScene::RenderableSoa const& soa, Range<uint32_t> vr,
-        backend::Handle<backend::HwBufferObject> uboHandle) noexcept {
+        PerRenderableUniforms const& renderableUniforms) noexcept {
     mRenderableSoa = &soa;
     mVisibleRenderables = vr;
-    mUboHandle = uboHandle;
+    mUboHandle = renderableUniforms.getUboHandle();
+    mUboRows = renderableUniforms.getRows();
 }
 
 void RenderPass::overridePolygonOffset(backend::PolygonOffset* polygonOffset) noexcept {
@@ -384,6 +385,7 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
             FMorphTargetBuffer const* const morphTargetBuffer = primitive.getMorphTargetBuffer();
             if constexpr (isColorPass) {
                 cmdColor.primitive.primitiveHandle = primitive.getHwHandle();
+                cmdColor.primitive.triangleCount = primitive.getTriangleCount();
                 cmdColor.primitive.materialVariant = materialVariant;
                 RenderPass::setupColorCommand(cmdColor, mi, inverseFrontFaces);
 
@@ -477,6 +479,7 @@ void RenderPass::generateCommandsImpl(uint32_t extraFlags,
 
                 // unconditionally write the command
                 cmdDepth.primitive.primitiveHandle = primitive.getHwHandle();
+                cmdDepth.primitive.triangleCount = primitive.getTriangleCount();
                 cmdDepth.primitive.mi = mi;
                 cmdDepth.primitive.rasterState.culling = mi->getCullingMode();
 
@@ -543,6 +546,7 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
         SYSTRACE_VALUE32("commandCount", last - first);
 
         auto const* const UTILS_RESTRICT soaSkinning = soa.data<FScene::SKINNING_BUFFER>();
+        auto const* const UTILS_RESTRICT uboRows = mUboRows;
 
         PolygonOffset dummyPolyOffset;
         PipelineState pipeline{ .polygonOffset = mPolygonOffset };
@@ -554,6 +558,11 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
         FMaterial const* UTILS_RESTRICT ma = nullptr;
         auto const& customCommands = mCustomCommands;
 
+        // statistics
+        uint32_t drawCount = 0;
+        uint32_t triangleCount = 0;
+        uint32_t stateChangeCount = 0;
+
         first--;
         while (++first != last) {
             /*
@@ -576,10 +585,13 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
                 pipeline.scissor = mi->getScissor();
                 *pPipelinePolygonOffset = mi->getPolygonOffset();
                 mi->use(driver);
+                stateChangeCount++;
             }
 
-            pipeline.program = ma->getProgram(info.materialVariant);
-            size_t offset = info.index * sizeof(PerRenderableUib);
+            backend::Handle<backend::HwProgram> const program = ma->getProgram(info.materialVariant);
+            stateChangeCount += (program != pipeline.program) ? 1u : 0u;
+            pipeline.program = program;
+            size_t offset = uboRows[info.index] * sizeof(PerRenderableUib);
             driver.bindUniformBufferRange(BindingPoints::PER_RENDERABLE,
                     uboHandle, offset, sizeof(PerRenderableUib));
 
@@ -611,7 +623,14 @@ void RenderPass::Executor::recordDriverCommands(FEngine& engine,
             }
 
             driver.draw(pipeline, info.primitiveHandle);
+            drawCount++;
+            triangleCount += info.triangleCount;
         }
+
+        FrameStatistics& statistics = engine.getFrameStatistics();
+        statistics.drawCount += drawCount;
+        statistics.triangleCount += triangleCount;
+        statistics.stateChangeCount += stateChangeCount;
     }
 }
 
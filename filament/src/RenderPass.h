@@ -42,6 +42,7 @@
 namespace filament {
 
 class FMaterialInstance;
+class PerRenderableUniforms;
 
 class RenderPass {
 public:
@@ -216,9 +217,10 @@ public:
         backend::Handle<backend::HwBufferObject> morphWeightBuffer;     // 4 bytes
         backend::Handle<backend::HwSamplerGroup> morphTargetBuffer;     // 4 bytes
         backend::RasterState rasterState;                               // 4 bytes
+        uint32_t triangleCount = 0;                                     // 4 bytes
         uint16_t index = 0;                                             // 2 bytes
         Variant materialVariant;                                        // 1 byte
-        uint8_t reserved[13 - sizeof(void*)] = {};                      // 5 bytes (9)
+        uint8_t reserved[9 - sizeof(void*)] = {};                       // 1 byte (5)
     };
     static_assert(sizeof(PrimitiveInfo) == 32);
 
@@ -269,9 +271,9 @@ public:
     // if non-null, overrides the material's polygon offset
     void overridePolygonOffset(backend::PolygonOffset* polygonOffset) noexcept;
 
-    // specifies the geometry to generate commands for
+    // specifies the geometry to generate commands for, and the per-renderable UBO of the view
     void setGeometry(FScene::RenderableSoa const& soa, utils::Range<uint32_t> vr,
-            backend::Handle<backend::HwBufferObject> uboHandle) noexcept;
+            PerRenderableUniforms const& renderableUniforms) noexcept;
 
     // specifies camera information (e.g. used for sorting commands)
     void setCamera(const CameraInfo& camera) noexcept { mCamera = camera; }
@@ -321,12 +323,14 @@ public:
         FScene::RenderableSoa const& mRenderableSoa;
         const CustomCommandVector mCustomCommands;
         const backend::Handle<backend::HwBufferObject> mUboHandle;
+        uint32_t const* const mUboRows;
         const backend::PolygonOffset mPolygonOffset;
         const bool mPolygonOffsetOverride;
 
         Executor(RenderPass const* pass, Command const* b, Command const* e) noexcept
                 : mEngine(pass->mEngine), mBegin(b), mEnd(e), mRenderableSoa(*pass->mRenderableSoa),
                   mCustomCommands(pass->mCustomCommands), mUboHandle(pass->mUboHandle),
+                  mUboRows(pass->mUboRows),
                   mPolygonOffset(pass->mPolygonOffset),
                   mPolygonOffsetOverride(pass->mPolygonOffsetOverride) {
             assert_invariant(b >= pass->begin());
@@ -409,6 +413,9 @@ private:
     // the UBO containing the data for the renderables
     backend::Handle<backend::HwBufferObject> mUboHandle;
 
+    // row of each renderable of the SOA in the UBO above
+    uint32_t const* mUboRows = nullptr;
+
     // info about the camera
     CameraInfo mCamera;
 
@@ -50,6 +50,7 @@ void FRenderPrimitive::init(backend::DriverApi& driver,
 
         mPrimitiveType = entry.type;
         mEnabledAttributes = enabledAttributes;
+        setTriangleCount(entry.type, entry.count);
     }
 }
 
@@ -73,6 +74,7 @@ void FRenderPrimitive::set(FEngine& engine, RenderableManager::PrimitiveType typ
 
     mPrimitiveType = type;
     mEnabledAttributes = enabledAttributes;
+    setTriangleCount(type, count);
 }
 
 void FRenderPrimitive::set(FEngine& engine, RenderableManager::PrimitiveType type, size_t offset,
@@ -81,10 +83,26 @@ void FRenderPrimitive::set(FEngine& engine, RenderableManager::PrimitiveType typ
     driver.setRenderPrimitiveRange(mHandle, type,
             (uint32_t)offset, (uint32_t)minIndex, (uint32_t)maxIndex, (uint32_t)count);
     mPrimitiveType = type;
+    setTriangleCount(type, count);
 }
 
 void FRenderPrimitive::set(FMorphTargetBuffer* morphTargetBuffer) noexcept {
     mMorphTargetBuffer = morphTargetBuffer;
 }
 
+void FRenderPrimitive::setTriangleCount(backend::PrimitiveType type, size_t count) noexcept {
+    // this is only used for statistics
+    switch (type) {
+        case backend::PrimitiveType::TRIANGLES:
+            mTriangleCount = uint32_t(count / 3);
+            break;
+        case backend::PrimitiveType::TRIANGLE_STRIP:
+            mTriangleCount = count > 2 ? uint32_t(count - 2) : 0u;
+            break;
+        default:
+            mTriangleCount = 0;
+            break;
+    }
+}
+
 } // namespace filament
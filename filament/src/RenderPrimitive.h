@@ -56,6 +56,7 @@ public:
     backend::PrimitiveType getPrimitiveType() const noexcept { return mPrimitiveType; }
     AttributeBitset getEnabledAttributes() const noexcept { return mEnabledAttributes; }
     uint16_t getBlendOrder() const noexcept { return mBlendOrder; }
+    uint32_t getTriangleCount() const noexcept { return mTriangleCount; }
     FMorphTargetBuffer* getMorphTargetBuffer() const noexcept { return mMorphTargetBuffer; }
 
     void setMaterialInstance(FMaterialInstance const* mi) noexcept { mMaterialInstance = mi; }
@@ -64,11 +65,14 @@ public:
     }
 
 private:
+    void setTriangleCount(backend::PrimitiveType type, size_t count) noexcept;
+
     FMaterialInstance const* mMaterialInstance = nullptr;
     backend::Handle<backend::HwRenderPrimitive> mHandle;
     backend::PrimitiveType mPrimitiveType = backend::PrimitiveType::NONE;
     AttributeBitset mEnabledAttributes;
     uint16_t mBlendOrder = 0;
+    uint32_t mTriangleCount = 0;
     FMorphTargetBuffer* mMorphTargetBuffer = nullptr;
 };
 
@@ -25,6 +25,7 @@
 #include "details/Scene.h"
 #include "details/SwapChain.h"
 #include "details/Texture.h"
+#include "details/TextureStreamer.h"
 #include "details/View.h"
 
 #include <filament/Scene.h>
@@ -37,11 +38,17 @@
 #include "fg2/FrameGraphResources.h"
 
 #include <utils/compiler.h>
+#include <utils/FixedCapacityVector.h>
 #include <utils/Panic.h>
 #include <utils/Systrace.h>
 #include <utils/vector.h>
 #include <utils/debug.h>
 
+#include <algorithm>
+#include <chrono>
+
+#include <string.h>
+
 // this helps visualize what dynamic-scaling is doing
 #define DEBUG_DYNAMIC_SCALING false
 
@@ -106,7 +113,7 @@ FRenderer::~FRenderer() noexcept {
     // to free what we can (it would probably mean something when wrong).
 #ifndef NDEBUG
     size_t wm = getCommandsHighWatermark();
-    size_t wmpct = wm / (CONFIG_PER_FRAME_COMMANDS_SIZE / 100);
+    size_t wmpct = wm / (mEngine.getPerFrameCommandsSize() / 100);
     slog.d << "Renderer: Commands High watermark "
     << wm / 1024 << " KiB (" << wmpct << "%), "
     << wm / sizeof(Command) << " commands, " << sizeof(Command) << " bytes/command"
@@ -114,6 +121,11 @@ FRenderer::~FRenderer() noexcept {
 #endif
 }
 
+void FRenderer::recordHighWatermark(size_t watermark) noexcept {
+    mCommandsHighWatermark = std::max(mCommandsHighWatermark, watermark);
+    mEngine.recordPerFrameCommandsHighWatermark(watermark);
+}
+
 void FRenderer::terminate(FEngine& engine) {
     // Here we would cleanly free resources we've allocated or we own, in particular we would
     // shut down threads if we created any.
@@ -131,6 +143,7 @@ void FRenderer::terminate(FEngine& engine) {
         engine.execute();
     }
     mFrameInfoManager.terminate(driver);
+    mFrameTimingsRecorder.terminate(driver);
     mFrameSkipper.terminate(driver);
 }
 
@@ -176,6 +189,7 @@ void FRenderer::renderStandaloneView(FView const* view) {
         FEngine::DriverApi& driver = engine.getDriverApi();
         driver.beginFrame(steady_clock::now().time_since_epoch().count(), mFrameId);
 
+        mCpuStageTimings.reset();
         renderInternal(view);
 
         driver.endFrame(mFrameId);
@@ -197,6 +211,128 @@ void FRenderer::render(FView const* view) {
     }
 }
 
+void FRenderer::renderViews(FView const* const* views, size_t count) {
+    SYSTRACE_CALL();
+
+    assert_invariant(mSwapChain);
+
+    if (mBeginFrameInternal) {
+        mBeginFrameInternal();
+        mBeginFrameInternal = {};
+    }
+
+    if (count > 1) {
+        cullViews(views, count);
+    }
+
+    // the driver commands are generated in order, one view at a time
+    for (size_t i = 0; i < count; i++) {
+        FView const* const view = views[i];
+        if (UTILS_LIKELY(view && view->getScene())) {
+            renderInternal(view);
+        }
+    }
+
+    // views skipped by renderJob() didn't consume their culling results
+    for (size_t i = 0; i < count; i++) {
+        if (views[i]) {
+            const_cast<FView*>(views[i])->setPrecomputedVisibility(nullptr, 0, false);
+        }
+    }
+}
+
+void FRenderer::cullViews(FView const* const* views, size_t count) {
+    SYSTRACE_CALL();
+
+    FEngine& engine = mEngine;
+    JobSystem& js = engine.getJobSystem();
+    const auto start = CpuStageTimings::clock::now();
+
+    struct PreparedScene {
+        FScene* scene;
+        mat4 worldOrigin;
+        bool prepared;
+    };
+    struct CullingTask {
+        FView* view;
+        FScene const* scene;
+        Frustum frustum;
+        size_t offset;
+        bool scenePrepared;
+    };
+
+    size_t cullingCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        FView const* const view = views[i];
+        cullingCount += (view && view->getScene() && view->isFrustumCullingEnabled()) ? 1 : 0;
+    }
+    if (cullingCount < 2) {
+        return;
+    }
+
+    // Renderable culling only depends on the scene's world-space AABBs, which stay the same for
+    // all the views of a scene. Each scene is prepared here for the first view that uses it, so
+    // that view doesn't prepare it again. The following views prepare it again, because views
+    // reorder the scene's data; that gathers the renderables in the same order as long as the
+    // scene's generation doesn't change, so the culling results computed here still apply.
+    auto scenes = FixedCapacityVector<PreparedScene>::with_capacity(count);
+    auto tasks = FixedCapacityVector<CullingTask>::with_capacity(count);
+    size_t visibilityCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        FView* const view = const_cast<FView*>(views[i]);
+        if (!view || !view->getScene()) {
+            continue;
+        }
+        FScene* const scene = view->getScene();
+        auto pos = std::find_if(scenes.begin(), scenes.end(),
+                [scene](PreparedScene const& prepared) { return prepared.scene == scene; });
+        const bool first = pos == scenes.end();
+        if (!view->isFrustumCullingEnabled()) {
+            if (first) {
+                // this view prepares the scene itself, before any other view uses it
+                scenes.push_back({ scene, {}, false });
+            }
+            continue;
+        }
+        mat4 const worldOrigin = view->getWorldOriginScene(engine);
+        if (first) {
+            CpuStageTimings::Scope scope(mCpuStageTimings, CpuStageTimings::Stage::SCENE_PREPARE);
+            scene->prepare(worldOrigin, view->hasVSM());
+            scenes.push_back({ scene, worldOrigin, true });
+        } else if (!pos->prepared || memcmp(&pos->worldOrigin, &worldOrigin, sizeof(mat4)) != 0) {
+            // the AABBs are not in this view's world space, it'll be culled by prepare()
+            continue;
+        }
+        tasks.push_back({ view, scene, view->computeCullingFrustum(worldOrigin),
+                          visibilityCount, first });
+        // Culler::intersects() processes multiples of 8 renderables
+        visibilityCount += (scene->getRenderableData().size() + 0x7u) & ~size_t(0x7u);
+    }
+
+    // culling sets bits, so the results must start cleared
+    mViewsVisibility.assign(visibilityCount, 0);
+    Culler::result_type* const visibility = mViewsVisibility.data();
+
+    auto* parent = js.createJob();
+    for (CullingTask const& task : tasks) {
+        js.run(js.createJob(parent, [&task, visibility](JobSystem&, JobSystem::Job*) {
+            FScene::RenderableSoa const& renderableData = task.scene->getRenderableData();
+            Culler::intersects(visibility + task.offset, task.frustum,
+                    renderableData.data<FScene::WORLD_AABB_CENTER>(),
+                    renderableData.data<FScene::WORLD_AABB_EXTENT>(),
+                    renderableData.size(), VISIBLE_RENDERABLE_BIT);
+        }));
+    }
+    js.runAndWait(parent);
+
+    for (CullingTask const& task : tasks) {
+        task.view->setPrecomputedVisibility(visibility + task.offset,
+                task.scene->getGeneration(), task.scenePrepared);
+    }
+
+    mCpuStageTimings.add(CpuStageTimings::Stage::CULLING, CpuStageTimings::clock::now() - start);
+}
+
 void FRenderer::renderInternal(FView const* view) {
     // per-renderpass data
     ArenaScope rootArena(mPerRenderPassArena);
@@ -261,15 +397,21 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
         return;
     }
 
-    view.prepare(engine, driver, arena, svp, getShaderUserTime());
+    view.prepare(engine, driver, arena, svp, getShaderUserTime(), mCpuStageTimings);
 
     view.prepareUpscaler(scale);
 
     // start froxelization immediately, it has no dependencies
     JobSystem::Job* jobFroxelize = nullptr;
+    // written by the froxelization job, only read after it's been waited on
+    CpuStageTimings::duration froxelizeDuration{};
     if (view.hasDynamicLighting()) {
         jobFroxelize = js.runAndRetain(js.createJob(nullptr,
-                [&engine, &view](JobSystem&, JobSystem::Job*) { view.froxelize(engine); }));
+                [&engine, &view, &froxelizeDuration](JobSystem&, JobSystem::Job*) {
+                    auto start = CpuStageTimings::clock::now();
+                    view.froxelize(engine);
+                    froxelizeDuration = CpuStageTimings::clock::now() - start;
+                }));
     }
 
     /*
@@ -280,8 +422,9 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     // Allocate some space for our commands in the per-frame Arena, and use that space as
     // an Arena for commands. All this space is released when we exit this method.
-    void* const arenaBegin = arena.allocate(FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE, CACHELINE_SIZE);
-    void* const arenaEnd = pointermath::add(arenaBegin, FEngine::CONFIG_PER_FRAME_COMMANDS_SIZE);
+    const size_t perFrameCommandsSize = engine.getPerFrameCommandsSize();
+    void* const arenaBegin = arena.allocate(perFrameCommandsSize, CACHELINE_SIZE);
+    void* const arenaEnd = pointermath::add(arenaBegin, perFrameCommandsSize);
     RenderPass::Arena commandArena("Command Arena", { arenaBegin, arenaEnd });
 
     RenderPass pass(engine, commandArena);
@@ -422,8 +565,21 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     view.updatePrimitivesMorphTargetBuffer(engine, cameraInfo,
             scene.getRenderableData(), view.getVisibleRenderables());
 
+    // streamed textures are prioritized by the screen footprint of the renderables using them,
+    // this too must be run after updatePrimitivesLod.
+    FTextureStreamer& textureStreamer = engine.getTextureStreamer();
+    if (UTILS_UNLIKELY(!textureStreamer.empty())) {
+        FScene::RenderableSoa const& renderableData = scene.getRenderableData();
+        textureStreamer.prepareView(
+                renderableData.data<FScene::WORLD_AABB_CENTER>(),
+                renderableData.data<FScene::WORLD_AABB_EXTENT>(),
+                renderableData.data<FScene::PRIMITIVES>(),
+                view.getVisibleRenderables(), cameraInfo, view.getViewport());
+    }
+
     pass.setCamera(cameraInfo);
-    pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(), scene.getRenderableUBO());
+    pass.setGeometry(scene.getRenderableData(), view.getVisibleRenderables(),
+            view.getPerRenderableUniforms());
 
     // view set-ups that need to happen before rendering
     fg.addTrivialSideEffectPass("Prepare View Uniforms", [svp, &view] (DriverApi& driver) {
@@ -507,8 +663,14 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
     // This one doesn't need to be a FrameGraph pass because it always happens by construction
     // (i.e. it won't be culled, unless everything is culled), so no need to complexify things.
     pass.setRenderFlags(colorRenderFlags);
-    pass.appendCommands(RenderPass::COLOR);
-    pass.sortCommands();
+    {
+        CpuStageTimings::Scope scope(mCpuStageTimings, CpuStageTimings::Stage::COMMAND_GENERATION);
+        pass.appendCommands(RenderPass::COLOR);
+    }
+    {
+        CpuStageTimings::Scope scope(mCpuStageTimings, CpuStageTimings::Stage::COMMAND_SORT);
+        pass.sortCommands();
+    }
 
     FrameGraphTexture::Descriptor desc = {
             .width = config.svp.width,
@@ -518,7 +680,7 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     // a non-drawing pass to prepare everything that need to be before the color passes execute
     fg.addTrivialSideEffectPass("Prepare Color Passes",
-            [=, &js, &view, &ppm](DriverApi& driver) {
+            [=, &js, &view, &ppm, &froxelizeDuration](DriverApi& driver) {
                 // prepare color grading as subpass material
                 if (colorGradingConfig.asSubpass) {
                     ppm.colorGradingPrepareSubpass(driver,
@@ -534,6 +696,8 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
                 if (jobFroxelize) {
                     auto *sync = jobFroxelize;
                     js.waitAndRelease(sync);
+                    mCpuStageTimings.add(CpuStageTimings::Stage::FROXELIZATION,
+                            froxelizeDuration);
                     view.commitFroxels(driver);
                 }
             }
@@ -699,16 +863,23 @@ void FRenderer::renderJob(ArenaScope& arena, FView& view) {
 
     fg.present(fgViewRenderTarget);
 
-    fg.compile();
+    {
+        CpuStageTimings::Scope scope(mCpuStageTimings, CpuStageTimings::Stage::FRAME_GRAPH_COMPILE);
+        fg.compile();
+    }
 
     //fg.export_graphviz(slog.d, view.getName());
 
-    fg.execute(driver);
+    {
+        CpuStageTimings::Scope scope(mCpuStageTimings, CpuStageTimings::Stage::FRAME_GRAPH_EXECUTE);
+        fg.execute(driver,
+                mFrameTimingsRecorder.isEnabled() ? &mFrameTimingsRecorder : nullptr);
+    }
 
     // save the current history entry and destroy the oldest entry
     view.commitFrameHistory(engine);
 
-    //recordHighWatermark(pass.getCommandsHighWatermark());
+    recordHighWatermark(commandArena.getListener().getHighWatermark());
 }
 
 FrameGraphId<FrameGraphTexture> FRenderer::refractionPass(FrameGraph& fg,
@@ -1111,6 +1282,8 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
 
     mBeginFrameInternal = {};
 
+    mCpuStageTimings.reset();
+
     mSwapChain = swapChain;
     swapChain->makeCurrent(driver);
 
@@ -1120,6 +1293,14 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
     // gives the backend a chance to execute periodic tasks
     driver.tick();
 
+    steady_clock::duration gpuWait{};
+    if (mLatencyOptions.mode != LatencyMode::DEFAULT) {
+        // instead of skipping frames, wait for the GPU to catch up
+        waitForGpu(engine);
+        gpuWait = steady_clock::now() - now;
+    }
+    pollCompletedFrames(driver);
+
     /*
     * From this point, we can't do any more work in beginFrame() because the user could choose
     * to ignore the return value and render the frame anyways -- which is perfectly fine.
@@ -1134,8 +1315,21 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
         // This need to occur after the backend beginFrame() because some backends need to start
         // a command buffer before creating a fence.
 
+        std::chrono::nanoseconds gpuFrameTime{};
+        bool gpuFrameTimeComplete = false;
+        if (mFrameTimingsRecorder.beginFrame(driver, mFrameId,
+                &gpuFrameTime, &gpuFrameTimeComplete)) {
+            // with per-pass GPU timings, the frame isn't timed by FrameInfoManager
+            if (gpuFrameTimeComplete) {
+                mFrameInfoManager.setGpuFrameTime(gpuFrameTime);
+            } else {
+                mFrameInfoManager.invalidateGpuFrameTime();
+            }
+        }
+
         mFrameInfoManager.beginFrame(driver, {
-                .historySize = mFrameRateOptions.history
+                .historySize = mFrameRateOptions.history,
+                .timerQuery = !mFrameTimingsRecorder.hasGpuPassTimings()
         }, mFrameId);
 
         if (false && vsyncSteadyClockTimeNano) { // work in progress
@@ -1170,6 +1364,11 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
             driver.setPresentationTime(presentationTime.time_since_epoch().count());
         }
 
+        // Streamed textures are updated once per frame, with the footprints of all the views
+        // rendered since the last frame. This isn't done by engine.prepare(), which
+        // renderStandaloneView() calls too.
+        engine.getTextureStreamer().update(driver);
+
         // ask the engine to do what it needs to (e.g. updates light buffer, materials...)
         engine.prepare();
     };
@@ -1178,6 +1377,8 @@ bool FRenderer::beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeN
         // if beginFrame() returns true, we are expecting a call to endFrame(),
         // so do the beginFrame work right now, instead of requiring a call to render()
         beginFrameInternal();
+        // input for this frame is typically sampled right after we return
+        mFrameTimingsRecorder.setLatencyMarkers(gpuWait, steady_clock::now());
         return true;
     }
 
@@ -1209,7 +1410,8 @@ void FRenderer::endFrame() {
     }
 
     mFrameInfoManager.endFrame(driver);
-    mFrameSkipper.endFrame(driver);
+    mFrameSkipper.endFrame(driver, mFrameId, mLatencyOptions.mode != LatencyMode::DEFAULT);
+    mFrameTimingsRecorder.endFrame(mCpuStageTimings, engine.getFrameStatistics().snapshot());
 
     if (mSwapChain) {
         mSwapChain->commit(driver);
@@ -1242,6 +1444,55 @@ void FRenderer::endFrame() {
     js.waitAndRelease(job);
 }
 
+void FRenderer::setLatencyOptions(LatencyOptions const& options) noexcept {
+    mLatencyOptions = options;
+    switch (options.mode) {
+        case LatencyMode::DEFAULT:
+            mFrameSkipper.setLatency(1);
+            break;
+        case LatencyMode::LOW_LATENCY:
+            mFrameSkipper.setLatency(0);
+            break;
+        case LatencyMode::THROUGHPUT:
+            // the frame being rendered is in flight too
+            mFrameSkipper.setLatency(std::clamp(size_t(options.maxFramesInFlight),
+                    size_t(1), FrameSkipper::MAX_FRAME_LATENCY) - 1);
+            break;
+    }
+}
+
+void FRenderer::waitForGpu(FEngine& engine) {
+    SYSTRACE_CALL();
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    if (mFrameSkipper.isReady(driver)) {
+        return;
+    }
+    // The backend creates the frame's fence asynchronously, make sure that happened before
+    // blocking on it.
+    FFence::waitAndDestroy(engine.createFence(FFence::Type::SOFT), FFence::Mode::FLUSH);
+    if (!mFrameSkipper.wait(driver)) {
+        // The frame was ended without a fence, i.e. in the DEFAULT mode, or the backend can't
+        // wait on fences. Wait for the GPU to be idle instead; some backends only update the
+        // status of their syncs when they tick.
+        driver.finish();
+        driver.tick();
+        FFence::waitAndDestroy(engine.createFence(FFence::Type::SOFT), FFence::Mode::FLUSH);
+    }
+}
+
+void FRenderer::pollCompletedFrames(backend::DriverApi& driver) {
+    const auto now = std::chrono::steady_clock::now();
+    mFrameSkipper.poll(driver, [this, now](uint32_t frameId) {
+        mFrameTimingsRecorder.frameCompleted(frameId, now);
+    });
+}
+
+void FRenderer::setFrameTimingOptions(FrameTimingOptions const& options) noexcept {
+    FEngine& engine = getEngine();
+    mFrameTimingsRecorder.setOptions(engine.getDriverApi(), options,
+            engine.getFrameStatistics().snapshot());
+}
+
 void FRenderer::readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
         PixelBufferDescriptor&& buffer) {
 #ifndef NDEBUG
@@ -1372,6 +1623,14 @@ void Renderer::render(View const* view) {
     upcast(this)->render(upcast(view));
 }
 
+void Renderer::renderViews(View const* const* views, size_t count) {
+    auto fviews = FixedCapacityVector<FView const*>::with_capacity(count);
+    for (size_t i = 0; i < count; i++) {
+        fviews.push_back(upcast(views[i]));
+    }
+    upcast(this)->renderViews(fviews.data(), count);
+}
+
 bool Renderer::beginFrame(SwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano) {
     return upcast(this)->beginFrame(upcast(swapChain), vsyncSteadyClockTimeNano);
 }
@@ -1417,6 +1676,22 @@ void Renderer::setClearOptions(const ClearOptions& options) {
     upcast(this)->setClearOptions(options);
 }
 
+void Renderer::setLatencyOptions(LatencyOptions const& options) noexcept {
+    upcast(this)->setLatencyOptions(options);
+}
+
+Renderer::LatencyOptions const& Renderer::getLatencyOptions() const noexcept {
+    return upcast(this)->getLatencyOptions();
+}
+
+void Renderer::setFrameTimingOptions(FrameTimingOptions const& options) noexcept {
+    upcast(this)->setFrameTimingOptions(options);
+}
+
+size_t Renderer::getFrameTimings(FrameTimings* out, size_t count) const noexcept {
+    return upcast(this)->getFrameTimings(out, count);
+}
+
 void Renderer::renderStandaloneView(View const* view) {
     upcast(this)->renderStandaloneView(upcast(view));
 }
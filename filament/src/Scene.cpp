@@ -16,6 +16,8 @@
 
 #include "details/Scene.h"
 
+#include "PerRenderableUniforms.h"
+
 #include "components/LightManager.h"
 #include "components/RenderableManager.h"
 
@@ -33,6 +35,8 @@
 
 #include <algorithm>
 
+#include <string.h>
+
 using namespace filament::math;
 using namespace utils;
 
@@ -53,6 +57,13 @@ void FScene::prepare(const mat4& worldOriginTransform, bool shadowReceiversAreCa
 
     SYSTRACE_CALL();
 
+    if (memcmp(&mPreparedWorldOrigin, &worldOriginTransform, sizeof(mat4)) != 0 ||
+            mPreparedShadowReceiversAreCasters != shadowReceiversAreCasters) {
+        mPreparedWorldOrigin = worldOriginTransform;
+        mPreparedShadowReceiversAreCasters = shadowReceiversAreCasters;
+        mGeneration++;
+    }
+
     FEngine& engine = mEngine;
     EntityManager& em = engine.getEntityManager();
     FRenderableManager& rcm = engine.getRenderableManager();
@@ -196,85 +207,13 @@ void FScene::prepare(const mat4& worldOriginTransform, bool shadowReceiversAreCa
     }
 }
 
-void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Handle<backend::HwBufferObject> renderableUbh) noexcept {
+void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables,
+        PerRenderableUniforms& renderableUniforms) noexcept {
     FEngine::DriverApi& driver = mEngine.getDriverApi();
-    FRenderableManager& rcm = mEngine.getRenderableManager();
-
-    const size_t size = visibleRenderables.size() * sizeof(PerRenderableUib);
-
-    // allocate space into the command stream directly
-    void* const buffer = driver.allocatePod<PerRenderableUib>(visibleRenderables.size());
-
-    bool hasContactShadows = false;
-    auto& sceneData = mRenderableData;
-    for (uint32_t i : visibleRenderables) {
-        mat4f const& model = sceneData.elementAt<WORLD_TRANSFORM>(i);
-        FRenderableManager::Visibility visibility = sceneData.elementAt<VISIBILITY_STATE>(i);
-        auto ri = sceneData.elementAt<RENDERABLE_INSTANCE>(i);
-
-        const size_t offset = i * sizeof(PerRenderableUib);
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelMatrix), model);
-
-        // Using mat3f::getTransformForNormals handles non-uniform scaling, but DOESN'T guarantee that
-        // the transformed normals will have unit-length, therefore they need to be normalized
-        // in the shader (that's already the case anyways, since normalization is needed after
-        // interpolation).
-        //
-        // We pre-scale normals by the inverse of the largest scale factor to avoid
-        // large post-transform magnitudes in the shader, especially in the fragment shader, where
-        // we use medium precision.
-        //
-        // Note: if the model matrix is known to be a rigid-transform, we could just use it directly.
-
-        mat3f m = mat3f::getTransformForNormals(model.upperLeft());
-        m *= mat3f(1.0f / std::sqrt(max(float3{length2(m[0]), length2(m[1]), length2(m[2])})));
-
-        // The shading normal must be flipped for mirror transformations.
-        // Basically we're shading the other side of the polygon and therefore need to negate the
-        // normal, similar to what we already do to support double-sided lighting.
-        if (visibility.reversedWindingOrder) {
-            m = -m;
-        }
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, worldFromModelNormalMatrix), m);
-
-        // Note that we cast bool to uint32_t. Booleans are byte-sized in C++, but we need to
-        // initialize all 32 bits in the UBO field.
-
-        hasContactShadows = hasContactShadows || visibility.screenSpaceContactShadows;
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, flags),
-                PerRenderableUib::packFlags(
-                        visibility.skinning,
-                        visibility.morphing,
-                        visibility.screenSpaceContactShadows));
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, morphTargetCount),
-                sceneData.elementAt<MORPHING_BUFFER>(i).count);
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, channels),
-                (uint32_t)sceneData.elementAt<CHANNELS>(i));
-
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, objectId),
-                rcm.getEntity(ri).getId()); // we could also store the entity in sceneData
-
-        // TODO: We need to find a better way to provide the scale information per object
-        UniformBuffer::setUniform(buffer,
-                offset + offsetof(PerRenderableUib, userData),
-                sceneData.elementAt<USER_DATA>(i));
-    }
 
-    // TODO: handle static objects separately
-    mHasContactShadows = hasContactShadows;
-    mRenderableViewUbh = renderableUbh;
-    driver.updateBufferObject(renderableUbh, { buffer, size }, 0);
+    // only the rows of the renderables that changed since the last frame are updated
+    mHasContactShadows = renderableUniforms.update(mEngine, mEngine.getJobSystem(),
+            mRenderableData, visibleRenderables);
 
     if (mSkybox) {
         mSkybox->commit(driver);
@@ -282,8 +221,7 @@ void FScene::updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Hand
 }
 
 void FScene::terminate(FEngine& engine) {
-    // DO NOT destroy this UBO, it's owned by the View
-    mRenderableViewUbh.clear();
+    // the per-renderable UBO is owned by the View, see PerRenderableUniforms
 }
 
 void FScene::prepareDynamicLights(const CameraInfo& camera, ArenaScope& rootArena,
@@ -330,6 +268,7 @@ void FScene::prepareDynamicLights(const CameraInfo& camera, ArenaScope& rootAren
         lp[gpuIndex].channels             = LightsUib::packChannels(lcm.getLightChannels(li), shadowInfo[i].castsShadows);
     }
 
+    mEngine.getFrameStatistics().uploadedBytes += positionalLightCount * sizeof(LightsUib);
     driver.updateBufferObject(lightUbh, { lp, positionalLightCount * sizeof(LightsUib) }, 0);
 }
 
@@ -367,14 +306,17 @@ inline void FScene::computeLightRanges(
 
 void FScene::addEntity(Entity entity) {
     mEntities.insert(entity);
+    mGeneration++;
 }
 
 void FScene::addEntities(const Entity* entities, size_t count) {
     mEntities.insert(entities, entities + count);
+    mGeneration++;
 }
 
 void FScene::remove(Entity entity) {
     mEntities.erase(entity);
+    mGeneration++;
 }
 
 void FScene::removeEntities(const Entity* entities, size_t count) {
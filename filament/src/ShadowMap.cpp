@@ -16,6 +16,7 @@
 
 #include "ShadowMap.h"
 
+#include "PerRenderableUniforms.h"
 #include "RenderPass.h"
 
 #include "components/LightManager.h"
@@ -71,10 +72,10 @@ ShadowMap::~ShadowMap() {
 
 void ShadowMap::render(FScene const& scene, utils::Range<uint32_t> range,
         FScene::VisibleMaskType visibilityMask, filament::CameraInfo const& cameraInfo,
-        RenderPass* const pass) noexcept {
+        PerRenderableUniforms const& renderableUniforms, RenderPass* const pass) noexcept {
     pass->setCamera(cameraInfo);
     pass->setVisibilityMask(visibilityMask);
-    pass->setGeometry(scene.getRenderableData(), range, scene.getRenderableUBO());
+    pass->setGeometry(scene.getRenderableData(), range, renderableUniforms);
     pass->overridePolygonOffset(&mShadowMapInfo.polygonOffset);
     pass->appendCommands(RenderPass::SHADOW);
     pass->sortCommands();
@@ -565,12 +566,12 @@ mat4 ShadowMap::getTextureCoordsMapping() const noexcept {
             0.0f, 0.0f, 0.0f, 1.0f
     });
 
-    // apply the 1-texel border viewport transform
-    const float o = 1.0f / mShadowMapInfo.atlasDimension;
+    // apply the 1-texel border viewport transform, and move to the shadow map's tile
+    const float2 o = (float2(mShadowMapInfo.textureOffset) + 1.0f) / mShadowMapInfo.atlasDimension;
     const float s = 1.0f - 2.0f * (1.0f / mShadowMapInfo.textureDimension);
     const mat4f Mb(mat4f::row_major_init{
-             s,    0.0f, 0.0f, o,
-             0.0f, s,    0.0f, o,
+             s,    0.0f, 0.0f, o.x,
+             0.0f, s,    0.0f, o.y,
              0.0f, 0.0f, 1.0f, 0.0f,
              0.0f, 0.0f, 0.0f, 1.0f
     });
@@ -586,6 +587,19 @@ mat4 ShadowMap::getTextureCoordsMapping() const noexcept {
     return mat4(Mf * Mb * Mv * Mt);
 }
 
+float4 ShadowMap::getTileRect() const noexcept {
+    // the shadow map includes its 1-texel border, which is cleared
+    const float a = mShadowMapInfo.atlasDimension;
+    const float d = mShadowMapInfo.textureDimension;
+    const float2 o = float2(mShadowMapInfo.textureOffset);
+    const float2 min = (o + 0.5f) / a;
+    const float2 max = (o + d - 0.5f) / a;
+    if (mTextureSpaceFlipped) {
+        return { min.x, 1.0f - max.y, max.x, 1.0f - min.y };
+    }
+    return { min, max };
+}
+
 mat4f ShadowMap::computeVsmLightSpaceMatrix(const mat4f& lightSpacePcf,
         const mat4f& Mv, float znear, float zfar) noexcept {
     // The lightSpacePcf matrix transforms coordinates from world space into (u, v, z) coordinates,
@@ -1050,6 +1064,7 @@ void ShadowMap::visitScene(const FScene& scene, uint32_t visibleLayers,
 void ShadowMap::initSceneInfo(FScene const& scene, filament::CameraInfo const& camera,
         ShadowMap::SceneInfo& sceneInfo) {
     sceneInfo.vsNearFar = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::max() };
+    sceneInfo.vsVisibleNearFar = sceneInfo.vsNearFar;
 
     // We assume the light is at the origin to compute the SceneInfo. This is consumed later by
     // computeShadowCameraDirectional() which takes this into account.
@@ -1058,6 +1073,7 @@ void ShadowMap::initSceneInfo(FScene const& scene, filament::CameraInfo const& c
     // Compute scene bounds in world space, as well as the light-space and view-space near/far planes
     sceneInfo.wsShadowCastersVolume = {};
     sceneInfo.wsShadowReceiversVolume = {};
+    sceneInfo.wsVisibleShadowReceiversVolume = {};
     visitScene(scene, sceneInfo.visibleLayers,
             [&](Aabb caster, Culler::result_type) {
                 sceneInfo.wsShadowCastersVolume.min =
@@ -1065,7 +1081,7 @@ void ShadowMap::initSceneInfo(FScene const& scene, filament::CameraInfo const& c
                 sceneInfo.wsShadowCastersVolume.max =
                         max(sceneInfo.wsShadowCastersVolume.max, caster.max);
             },
-            [&](Aabb receiver, Culler::result_type) {
+            [&](Aabb receiver, Culler::result_type mask) {
                 sceneInfo.wsShadowReceiversVolume.min =
                         min(sceneInfo.wsShadowReceiversVolume.min, receiver.min);
                 sceneInfo.wsShadowReceiversVolume.max =
@@ -1073,6 +1089,15 @@ void ShadowMap::initSceneInfo(FScene const& scene, filament::CameraInfo const& c
                 float2 nf = ShadowMap::computeNearFar(V, receiver);
                 sceneInfo.vsNearFar.x = std::max(sceneInfo.vsNearFar.x, nf.x);
                 sceneInfo.vsNearFar.y = std::min(sceneInfo.vsNearFar.y, nf.y);
+                // camera culling has already happened, see FView::prepare()
+                if (mask & VISIBLE_RENDERABLE) {
+                    sceneInfo.wsVisibleShadowReceiversVolume.min =
+                            min(sceneInfo.wsVisibleShadowReceiversVolume.min, receiver.min);
+                    sceneInfo.wsVisibleShadowReceiversVolume.max =
+                            max(sceneInfo.wsVisibleShadowReceiversVolume.max, receiver.max);
+                    sceneInfo.vsVisibleNearFar.x = std::max(sceneInfo.vsVisibleNearFar.x, nf.x);
+                    sceneInfo.vsVisibleNearFar.y = std::min(sceneInfo.vsVisibleNearFar.y, nf.y);
+                }
             }
     );
 }
@@ -26,11 +26,13 @@
 #include "private/backend/SamplerGroup.h"
 
 #include <math/mat4.h>
+#include <math/vec2.h>
 #include <math/vec4.h>
 
 namespace filament {
 
 class FView;
+class PerRenderableUniforms;
 class RenderPass;
 
 class ShadowMap {
@@ -51,6 +53,9 @@ public:
         // e.g., for at atlas size of 1024 split into 4 quadrants, textureDimension would be 512
         uint16_t textureDimension = 0;
 
+        // the position of the shadow map texture within its layer of the atlas, in texels
+        math::ushort2 textureOffset{};
+
         // the dimension of the actual shadow map, taking into account the 1 texel border
         // e.g., for a texture dimension of 512, shadowDimension would be 510
         uint16_t shadowDimension = 0;
@@ -86,6 +91,11 @@ public:
         // World-space shadow-receivers volume
         Aabb wsShadowReceiversVolume;
 
+        // Same as vsNearFar and wsShadowReceiversVolume, but only for the receivers visible
+        // from the viewing camera
+        math::float2 vsVisibleNearFar{};
+        Aabb wsVisibleShadowReceiversVolume;
+
         uint8_t visibleLayers;
     };
 
@@ -106,7 +116,7 @@ public:
 
     void render(FScene const& scene, utils::Range<uint32_t> range,
             FScene::VisibleMaskType visibilityMask, filament::CameraInfo const& cameraInfo,
-            RenderPass* pass) noexcept;
+            PerRenderableUniforms const& renderableUniforms, RenderPass* pass) noexcept;
 
     // Do we have visible shadows. Valid after calling update().
     bool hasVisibleShadows() const noexcept { return mHasVisibleShadows; }
@@ -119,6 +129,10 @@ public:
     float getTexelSizAtOneMeterWs() const noexcept { return mTexelSizeAtOneMeterWs; }
     math::float4 getLightFromWorldZ() const noexcept { return mLightFromWorldZ; }
 
+    // The shadow map's rectangle in the atlas, in texture coordinates (xy: min, zw: max), inset by
+    // half a texel. The shaders clamp their taps to it.
+    math::float4 getTileRect() const noexcept;
+
     // Returns the light's projection. Valid after calling update().
     FCamera const& getCamera() const noexcept { return *mCamera; }
 
@@ -19,6 +19,8 @@
 #include "RenderPass.h"
 #include "ShadowMap.h"
 
+#include "components/LightManager.h"
+
 #include "details/Texture.h"
 #include "details/View.h"
 
@@ -29,11 +31,26 @@
 #include <utils/debug.h>
 #include <utils/FixedCapacityVector.h>
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace filament {
 
 using namespace backend;
 using namespace math;
 
+// Spotlight shadow maps aren't made smaller than this when the light covers little of the screen
+static constexpr uint32_t MIN_SPOT_SHADOW_MAP_DIMENSION = 64u;
+
+// Level of the smallest atlas tile a shadow map of the given dimension fits in
+static uint8_t getTileLevel(uint32_t maxDimension, uint32_t dimension) noexcept {
+    uint8_t level = 0;
+    while (level < AtlasAllocator::MAX_LEVEL && (maxDimension >> (level + 1u)) >= dimension) {
+        level++;
+    }
+    return level;
+}
+
 ShadowMapManager::ShadowMapManager(FEngine& engine) { // NOLINT(cppcoreguidelines-pro-type-member-init)
     // initialize our ShadowMap array in-place
     for (auto& entry : mShadowMapCache) {
@@ -53,12 +70,31 @@ ShadowMapManager::~ShadowMapManager() {
     }
 }
 
+void ShadowMapManager::terminate(DriverApi& driver) noexcept {
+    destroyCachedAtlas(driver);
+}
+
+void ShadowMapManager::destroyCachedAtlas(DriverApi& driver) noexcept {
+    for (size_t l = 0; l < mCachedAtlas.layers; l++) {
+        driver.destroyRenderTarget(mCachedAtlas.renderTargets[l]);
+    }
+    if (mCachedAtlas.texture) {
+        driver.destroyTexture(mCachedAtlas.texture);
+    }
+    mCachedAtlas = {};
+    mCachedCascadeTiles = {};
+    mCachedSpotTiles.clear();
+    mSpotLevelBias = 0;
+}
+
 ShadowMapManager::ShadowTechnique ShadowMapManager::update(
         FEngine& engine, FView& view,
         TypedUniformBuffer<ShadowUib>& shadowUb, FScene::RenderableSoa& renderableData,
         FScene::LightSoa& lightData) noexcept {
     ShadowTechnique shadowTechnique = {};
 
+    prioritizeSpotShadowMaps(view, lightData);
+
     calculateTextureRequirements(engine, view, lightData);
 
     ShadowMap::SceneInfo sceneInfo(view.getVisibleLayers());
@@ -93,10 +129,9 @@ void ShadowMapManager::setShadowCascades(size_t lightIndex,
 
 void ShadowMapManager::addSpotShadowMap(size_t lightIndex,
         LightManager::ShadowOptions const* options) noexcept {
-    const size_t c = mSpotShadowMaps.size();
-    assert_invariant(c < CONFIG_MAX_SHADOW_CASTING_SPOTS);
-    auto* shadowMap = getSpotShadowMap(c);
-    mSpotShadowMaps.emplace_back(shadowMap, lightIndex, options);
+    assert_invariant(mSpotShadowMaps.size() < mSpotShadowMaps.capacity());
+    // the ShadowMap is assigned in prioritizeSpotShadowMaps()
+    mSpotShadowMaps.emplace_back(nullptr, lightIndex, options);
 }
 
 void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverApi& driver,
@@ -141,6 +176,10 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
     if (!spotShadowCastersRange.empty()) {
         for (size_t i = 0, c = mSpotShadowMaps.size(); i < c; i++) {
             const auto& map = mSpotShadowMaps[i];
+            // the spotlights that are not rendered this frame come last
+            if (!map.isRendered()) {
+                break;
+            }
             if (map.hasVisibleShadows()) {
                 passList.push_back({
                     &map, spotShadowCastersRange, VISIBLE_SPOT_SHADOW_RENDERABLE_N(i) });
@@ -148,7 +187,29 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
         }
     }
 
-    assert_invariant(passList.size() <= textureRequirements.layers);
+    // with PCF, several shadow maps can share a layer
+    assert_invariant(passList.size() <= mCascadeShadowMaps.size() + mSpotShadowMaps.size());
+
+    // When the atlas is kept from one frame to the next, the shadow maps are rendered in a
+    // temporary atlas that only has the layers rendered this frame, then copied to the atlas.
+    // Otherwise, they're rendered directly in their layer.
+    uint8_t renderedLayers[MAX_SHADOW_LAYERS];      // layer of the atlas -> rendered layer
+    uint8_t renderedLayerCount = textureRequirements.layers;
+    if (mCachedAtlas.texture) {
+        std::fill(std::begin(renderedLayers), std::end(renderedLayers), uint8_t(0xFF));
+        renderedLayerCount = 0;
+        for (auto const& entry : passList) {
+            uint8_t& renderedLayer = renderedLayers[entry.shadowMapEntry->getLayer()];
+            if (renderedLayer == 0xFF) {
+                renderedLayer = renderedLayerCount++;
+            }
+        }
+        renderedLayerCount = std::max(renderedLayerCount, uint8_t(1));
+    } else {
+        for (size_t l = 0; l < MAX_SHADOW_LAYERS; l++) {
+            renderedLayers[l] = uint8_t(l);
+        }
+    }
 
     // -------------------------------------------------------------------------------------------
 
@@ -160,7 +221,7 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
             [&](FrameGraph::Builder& builder, auto& data) {
                 data.shadows = builder.createTexture("Shadowmap", {
                         .width = textureRequirements.size, .height = textureRequirements.size,
-                        .depth = textureRequirements.layers,
+                        .depth = renderedLayerCount,
                         .levels = textureRequirements.levels,
                         .type = SamplerType::SAMPLER_2D_ARRAY,
                         .format = view.hasVSM() ? vsmTextureFormat : mTextureFormat
@@ -185,8 +246,12 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
 
     auto& ppm = engine.getPostProcessManager();
 
+    // With PCF, several shadow maps can share a layer of the atlas. The first shadow pass of a
+    // layer clears it, the following ones draw over it.
+    FrameGraphId<FrameGraphTexture> layerAttachments[MAX_SHADOW_LAYERS];
+
     for (auto const& entry : passList) {
-        const auto layer = entry.shadowMapEntry->getLayer();
+        const auto layer = renderedLayers[entry.shadowMapEntry->getLayer()];
         const auto* options = entry.shadowMapEntry->getShadowOptions();
 
         auto& shadowPass = fg.addPass<ShadowPassData>("Shadow Pass",
@@ -195,8 +260,9 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
 
                     FrameGraphRenderPass::Descriptor renderTargetDesc{};
 
-                    auto attachment = builder.createSubresource(prepareShadowPass->shadows,
-                            "Shadowmap Layer", { .layer = layer });
+                    auto attachment = layerAttachments[layer] ? layerAttachments[layer] :
+                            builder.createSubresource(prepareShadowPass->shadows,
+                                    "Shadowmap Layer", { .layer = layer });
 
                     if (view.hasVSM()) {
                         // Each shadow pass has its own sample count, but textures are created with
@@ -247,10 +313,13 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
                         }
                     } else {
                         // the shadowmap layer
+                        const bool firstInLayer = !layerAttachments[layer];
                         attachment = builder.write(attachment,
                                 FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
                         renderTargetDesc.attachments.depth = attachment;
-                        renderTargetDesc.clearFlags = TargetBufferFlags::DEPTH;
+                        renderTargetDesc.clearFlags = firstInLayer ?
+                                TargetBufferFlags::DEPTH : TargetBufferFlags::NONE;
+                        layerAttachments[layer] = attachment;
                     }
 
                     // finally, create the shadowmap render target -- one per layer.
@@ -269,7 +338,8 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
 
                     // generate and sort the commands for rendering the shadow map
                     RenderPass entryPass(pass);
-                    shadowMap.render(*scene, entry.range, entry.visibilityMask, cameraInfo, &entryPass);
+                    shadowMap.render(*scene, entry.range, entry.visibilityMask, cameraInfo,
+                            view.getPerRenderableUniforms(), &entryPass);
 
                     const auto& executor = entryPass.getExecutor();
                     const bool blur = view.hasVSM() && options->vsm.blurWidth > 0.0f;
@@ -286,8 +356,9 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
                     // shadowing.fs). Unfortunately, the APIs don't seem let us clear depth
                     // attachments to anything greater than 1.0, so we'd need a way to do this other
                     // than clearing.
-                    const uint32_t dim = options->mapSize;
-                    filament::Viewport viewport{ 1, 1, dim - 2, dim - 2 };
+                    const uint32_t dim = entry.shadowMapEntry->getDimension();
+                    const ushort2 offset = entry.shadowMapEntry->getOffset();
+                    filament::Viewport viewport{ offset.x + 1, offset.y + 1, dim - 2, dim - 2 };
                     view.prepareViewport(viewport);
 
                     // set uniforms needed to render this ShadowMap
@@ -317,7 +388,7 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
                 ppm.gaussianBlurPass(fg,
                         shadowPass->tempBlurSrc, 0,
                         shadows, 0, layer,
-                        false, kernelWidth, ratio);
+                        false, kernelWidth, ratio, "VSM Gaussian Blur Passes");
             }
 
             // If the shadow texture has more than one level, mipmapping was requested, either directly
@@ -333,6 +404,74 @@ void ShadowMapManager::render(FrameGraph& fg, FEngine& engine, backend::DriverAp
         }
     }
 
+    // When the atlas is kept from one frame to the next, the shadow maps rendered in the
+    // temporary atlas are copied to their tile. Rendering directly in the atlas would lose the
+    // shadow maps that are not rendered this frame, because layers are cleared as a whole.
+    if (mCachedAtlas.texture) {
+        struct CachedTileCopy {
+            uint8_t srcLayer;
+            Handle<HwRenderTarget> dst;
+            uint16_t dimension;
+            ushort2 offset;
+        };
+        auto copies = utils::FixedCapacityVector<CachedTileCopy>::with_capacity(passList.size());
+        for (auto const& entry : passList) {
+            // the whole tile, including the shadow map's border
+            const uint8_t layer = entry.shadowMapEntry->getLayer();
+            copies.push_back({ renderedLayers[layer], mCachedAtlas.renderTargets[layer],
+                    uint16_t(textureRequirements.size >>
+                            entry.shadowMapEntry->getCachedTile()->allocation.level),
+                    entry.shadowMapEntry->getOffset() });
+        }
+
+        auto atlas = fg.import("Shadowmap Cache", {
+                .width = mCachedAtlas.size, .height = mCachedAtlas.size,
+                .depth = mCachedAtlas.layers,
+                .type = SamplerType::SAMPLER_2D_ARRAY,
+                .format = mTextureFormat
+        }, FrameGraphTexture::Usage::DEPTH_ATTACHMENT | FrameGraphTexture::Usage::SAMPLEABLE,
+                FrameGraphTexture{ .handle = mCachedAtlas.texture });
+
+        if (!copies.empty()) {
+            struct ShadowCacheUpdateData {
+                FrameGraphId<FrameGraphTexture> tiles;
+                FrameGraphId<FrameGraphTexture> atlas;
+            };
+
+            auto& cacheUpdatePass = fg.addPass<ShadowCacheUpdateData>("Shadow Cache Update",
+                    [&](FrameGraph::Builder& builder, auto& data) {
+                        data.tiles = builder.read(shadows,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                        data.atlas = builder.write(atlas,
+                                FrameGraphTexture::Usage::DEPTH_ATTACHMENT);
+                    },
+                    [copies = std::move(copies), size = textureRequirements.size,
+                            layerCount = renderedLayerCount](
+                            FrameGraphResources const& resources,
+                            auto const& data, DriverApi& driver) {
+                        // the render targets of the atlas are kept with it, the ones of the
+                        // temporary atlas only live for this pass
+                        auto tiles = resources.getTexture(data.tiles);
+                        Handle<HwRenderTarget> sources[MAX_SHADOW_LAYERS];
+                        for (uint8_t l = 0; l < layerCount; l++) {
+                            sources[l] = driver.createRenderTarget(TargetBufferFlags::DEPTH,
+                                    size, size, 1, {}, { tiles, 0, l }, {});
+                        }
+                        for (auto const& copy : copies) {
+                            const backend::Viewport rect{ copy.offset.x, copy.offset.y,
+                                    copy.dimension, copy.dimension };
+                            driver.blit(TargetBufferFlags::DEPTH, copy.dst, rect,
+                                    sources[copy.srcLayer], rect, SamplerMagFilter::NEAREST);
+                        }
+                        for (uint8_t l = 0; l < layerCount; l++) {
+                            driver.destroyRenderTarget(sources[l]);
+                        }
+                    });
+            atlas = cacheUpdatePass->atlas;
+        }
+        shadows = atlas;
+    }
+
     fg.getBlackboard().put("shadows", shadows);
 }
 
@@ -347,7 +486,7 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
     FLightManager::ShadowOptions const& options = lcm.getShadowOptions(directionalLight);
     FLightManager::ShadowParams const& params = lcm.getShadowParams(directionalLight);
 
-    const ShadowMap::ShadowMapInfo shadowMapInfo{
+    ShadowMap::ShadowMapInfo shadowMapInfo{
             .atlasDimension   = mTextureAtlasRequirements.size,
             .textureDimension = uint16_t(options.mapSize),
             .shadowDimension  = uint16_t(options.mapSize - 2u),
@@ -358,12 +497,20 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
             }
     };
 
+    // Fit the cascades to the receivers visible from the camera, see fitCascadesToVisibleReceivers.
+    // If no receivers are visible, there are no visible shadows either, and the volume is empty.
+    const bool fitToVisibleReceivers = options.fitCascadesToVisibleReceivers;
+    if (fitToVisibleReceivers) {
+        sceneInfo.wsShadowReceiversVolume = sceneInfo.wsVisibleShadowReceiversVolume;
+    }
+
     if (!mCascadeShadowMaps.empty()) {
         // Even if we have more than one cascade, we cull directional shadow casters against the
         // entire camera frustum, as if we only had a single cascade.
         ShadowMapEntry& entry = mCascadeShadowMaps[0];
         ShadowMap& shadowMap = entry.getShadowMap();
 
+        shadowMapInfo.textureOffset = entry.getOffset();
         shadowMap.updateDirectional(lightData, 0, viewingCameraInfo, shadowMapInfo, *scene, sceneInfo);
 
         Frustum const& frustum = shadowMap.getCamera().getCullingFrustum();
@@ -385,7 +532,12 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
     // Adjust the near and far planes to tightly bound the scene.
     float vsNear = -viewingCameraInfo.zn;
     float vsFar = -viewingCameraInfo.zf;
-    if (engine.debug.shadowmap.tightly_bound_scene) {
+    if (fitToVisibleReceivers) {
+        if (!sceneInfo.wsVisibleShadowReceiversVolume.isEmpty()) {
+            vsNear = std::min(vsNear, sceneInfo.vsVisibleNearFar.x);
+            vsFar = std::max(vsFar, sceneInfo.vsVisibleNearFar.y);
+        }
+    } else if (engine.debug.shadowmap.tightly_bound_scene) {
         vsNear = std::min(vsNear, sceneInfo.vsNearFar.x);
         vsFar = std::max(vsFar, sceneInfo.vsNearFar.y);
     }
@@ -438,12 +590,14 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateCascadeShadowMaps(FEng
 
         sceneInfo.csNearFar = { csSplitPosition[i], csSplitPosition[i + 1] };
 
+        shadowMapInfo.textureOffset = entry.getOffset();
         shadowMap.updateDirectional(lightData, 0,
                 viewingCameraInfo, shadowMapInfo,
                 *scene, sceneInfo);
 
         if (shadowMap.hasVisibleShadows()) {
             mShadowMappingUniforms.lightFromWorldMatrix[i] = shadowMap.getLightSpaceMatrix();
+            mShadowMappingUniforms.cascadeTileRects[i] = shadowMap.getTileRect();
             shadowTechnique |= ShadowTechnique::SHADOW_MAP;
             cascadeHasVisibleShadows |= 0x1u << i;
         }
@@ -489,18 +643,32 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
     FScene::ShadowInfo* const shadowInfo = lightData.data<FScene::SHADOW_INFO>();
     for (size_t i = 0, c = mSpotShadowMaps.size(); i < c; i++) {
         auto& entry = mSpotShadowMaps[i];
+        const size_t lightIndex = entry.getLightIndex();
+
+        if (!entry.isRendered()) {
+            // sample the shadow map as it was rendered in an earlier frame
+            CachedTile const& tile = *entry.getCachedTile();
+            if (tile.hasVisibleShadows) {
+                shadowInfo[lightIndex].castsShadows = true;
+                shadowInfo[lightIndex].index = i;
+                shadowInfo[lightIndex].layer = entry.getLayer();
+                shadowUb.edit().shadows[i] = tile.shadowData;
+                shadowTechnique |= ShadowTechnique::SHADOW_MAP;
+            }
+            continue;
+        }
 
         // compute the frustum for this light
         ShadowMap& shadowMap = entry.getShadowMap();
-        const size_t lightIndex = entry.getLightIndex();
         const FLightManager::Instance li = lightData.elementAt<FScene::LIGHT_INSTANCE>(lightIndex);
         FLightManager::ShadowParams params = lcm.getShadowParams(li);
 
         FLightManager::ShadowOptions const* const options = entry.getShadowOptions();
         const ShadowMap::ShadowMapInfo shadowMapInfo{
                 .atlasDimension = mTextureAtlasRequirements.size,
-                .textureDimension = uint16_t(options->mapSize),
-                .shadowDimension = uint16_t(options->mapSize - 2u),
+                .textureDimension = entry.getDimension(),
+                .textureOffset = entry.getOffset(),
+                .shadowDimension = uint16_t(entry.getDimension() - 2u),
                 .spotIndex = uint16_t(i),
                 .vsm = view.hasVSM(),
                 .polygonOffset = { // handle reversed Z
@@ -551,9 +719,23 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
             s.shadows[i].nearOverFarMinusNear = n / (f - n);
             s.shadows[i].bulbRadiusLs =
                     mSoftShadowOptions.penumbraScale * options->shadowBulbRadius / wsTexelSizeAtOneMeter;
+            s.shadows[i].tileRect = shadowMap.getTileRect();
 
             shadowTechnique |= ShadowTechnique::SHADOW_MAP;
         }
+
+        // remember what's needed to sample the shadow map in the following frames
+        if (CachedTile* const tile = entry.getCachedTile()) {
+            tile->renderedFrame = mFrameId;
+            tile->stale = false;
+            tile->hasVisibleShadows = shadowMap.hasVisibleShadows();
+            tile->positionRadius = lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex);
+            tile->direction = direction;
+            tile->outerConeAngle = outerConeAngle;
+            if (tile->hasVisibleShadows) {
+                tile->shadowData = shadowUb.edit().shadows[i];
+            }
+        }
     }
 
     // screen-space contact shadows for point/spotlights
@@ -571,27 +753,94 @@ ShadowMapManager::ShadowTechnique ShadowMapManager::updateSpotShadowMaps(FEngine
     return shadowTechnique;
 }
 
+void ShadowMapManager::prioritizeSpotShadowMaps(FView const& view,
+        FScene::LightSoa const& lightData) noexcept {
+    const CameraInfo& camera = view.getCameraInfo();
+    for (auto& entry : mSpotShadowMaps) {
+        const float4 positionRadius =
+                lightData.elementAt<FScene::POSITION_RADIUS>(entry.getLightIndex());
+        entry.setCoverage(computeScreenCoverage(camera, positionRadius.xyz, positionRadius.w));
+    }
+
+    // Only the spotlights covering the most of the screen get a shadow map, we break ties with
+    // the light index so the choice doesn't depend on the sort.
+    std::sort(mSpotShadowMaps.begin(), mSpotShadowMaps.end(),
+            [](ShadowMapEntry const& lhs, ShadowMapEntry const& rhs) {
+                return lhs.getCoverage() != rhs.getCoverage() ?
+                       lhs.getCoverage() > rhs.getCoverage() :
+                       lhs.getLightIndex() < rhs.getLightIndex();
+            });
+
+    // With VSM, all the shadow maps are rendered every frame. Otherwise, the ones that can't be
+    // rendered this frame keep the one rendered in an earlier frame, see updateCachedAtlas().
+    const size_t maxSpotShadowMaps = view.hasVSM() ?
+            CONFIG_MAX_SHADOW_CASTING_SPOTS : CONFIG_MAX_SHADOWED_SPOTS;
+    if (mSpotShadowMaps.size() > maxSpotShadowMaps) {
+        mSpotShadowMaps.resize(maxSpotShadowMaps);
+    }
+    if (mSpotShadowMaps.size() <= CONFIG_MAX_SHADOW_CASTING_SPOTS) {
+        for (size_t i = 0, c = mSpotShadowMaps.size(); i < c; i++) {
+            mSpotShadowMaps[i].setShadowMap(getSpotShadowMap(i));
+        }
+    }
+}
+
+float ShadowMapManager::computeScreenCoverage(CameraInfo const& camera,
+        float3 const& center, float radius) noexcept {
+    const float distance = length(center - camera.getPosition());
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    // with a perspective projection, use the tangent of the sphere's angular radius
+    const mat4f& p = camera.projection;
+    const float r = p[2][3] != 0.0f ?
+            radius / std::sqrt(distance * distance - radius * radius) : radius;
+    return std::min(1.0f, r * p[1][1]);
+}
+
 void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view,
         FScene::LightSoa& lightData) noexcept {
 
-    // Lay out the shadow maps. For now, we take the largest requested dimension and allocate a
-    // texture of that size. Each cascade / shadow map gets its own layer in the array texture.
-    // The directional shadow cascades start on layer 0, followed by spotlights.
-    uint8_t layer = 0;
+    // Lay out the shadow maps. The atlas is an array texture whose layers are the size of the
+    // largest shadow map. Directional shadow cascades use the requested size, spotlights get a
+    // size proportional to how much of the screen they cover, up to the requested size.
     uint32_t maxDimension = 0;
+    uint32_t maxMapSize = 0;
     for (auto& entry : mCascadeShadowMaps) {
         // Shadow map size should be the same for all cascades.
         auto const& options = entry.getShadowOptions();
+        entry.setDimension(uint16_t(options->mapSize));
         maxDimension = std::max(maxDimension, options->mapSize);
-        entry.setLayer(layer++);
+        maxMapSize = std::max(maxMapSize, options->mapSize);
     }
     for (auto& entry : mSpotShadowMaps) {
         auto const& options = entry.getShadowOptions();
-        maxDimension = std::max(maxDimension, options->mapSize);
-        entry.setLayer(layer++);
+        maxMapSize = std::max(maxMapSize, options->mapSize);
+        // full size when the light covers half the screen or more
+        uint32_t dimension = uint32_t(float(options->mapSize) *
+                std::min(1.0f, 2.0f * entry.getCoverage()));
+        dimension = std::max(dimension,
+                std::min(options->mapSize, MIN_SPOT_SHADOW_MAP_DIMENSION));
+        entry.setDimension(uint16_t(dimension));
+        maxDimension = std::max(maxDimension, dimension);
     }
 
-    const uint8_t layersNeeded = layer;
+    // When there are more spotlight shadow maps than can be rendered in a frame, the atlas is
+    // kept from one frame to the next. Its layers are the size of the largest requested shadow
+    // map rather than of the largest one this frame, which changes as the camera moves and would
+    // lose all the tiles.
+    uint8_t layersNeeded;
+    if (!view.hasVSM() && mSpotShadowMaps.size() > CONFIG_MAX_SHADOW_CASTING_SPOTS) {
+        maxDimension = maxMapSize;
+        updateCachedAtlas(engine, lightData, maxDimension);
+        layersNeeded = mCachedAtlas.layers;
+    } else {
+        if (mCachedAtlas.texture) {
+            destroyCachedAtlas(engine.getDriverApi());
+        }
+        packAtlas(maxDimension, view.hasVSM());
+        layersNeeded = uint8_t(mAtlasAllocator.getLayerCount());
+    }
 
     // Generate mipmaps for VSM when anisotropy is enabled or when requested
     auto const& vsmShadowOptions = view.getVsmShadowOptions();
@@ -615,6 +864,232 @@ void ShadowMapManager::calculateTextureRequirements(FEngine& engine, FView& view
     };
 }
 
+void ShadowMapManager::packAtlas(uint32_t maxDimension, bool vsm) noexcept {
+    constexpr size_t MAX_SHADOW_MAPS =
+            CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOW_CASTING_SPOTS;
+    ShadowMapEntry* entries[MAX_SHADOW_MAPS];
+    size_t entryCount = 0;
+    for (auto& entry : mCascadeShadowMaps) {
+        entries[entryCount++] = &entry;
+    }
+    for (auto& entry : mSpotShadowMaps) {
+        entries[entryCount++] = &entry;
+    }
+
+    // With PCF, smaller shadow maps share layers, each gets the smallest tile it fits in.
+    // With VSM, each shadow map keeps its own layer, because blurring and mipmapping work on
+    // whole layers.
+    // Allocating the largest tiles first packs them without holes.
+    std::stable_sort(entries, entries + entryCount,
+            [](ShadowMapEntry const* lhs, ShadowMapEntry const* rhs) {
+                return lhs->getDimension() > rhs->getDimension();
+            });
+
+    mAtlasAllocator.clear();
+    for (size_t i = 0; i < entryCount; i++) {
+        ShadowMapEntry& entry = *entries[i];
+        uint8_t level = 0;
+        if (!vsm) {
+            level = getTileLevel(maxDimension, entry.getDimension());
+            // use the whole tile, as long as it's not larger than requested
+            const uint32_t tileDimension = maxDimension >> level;
+            entry.setDimension(uint16_t(std::min(tileDimension,
+                    entry.getShadowOptions()->mapSize)));
+        }
+
+        AtlasAllocator::Allocation tile;
+        UTILS_UNUSED_IN_RELEASE bool const success = mAtlasAllocator.allocate(level, &tile);
+        // there is a layer per shadow map, so this never fails
+        assert_invariant(success);
+        const uint16_t tileDimension = uint16_t(maxDimension >> level);
+        entry.setTile(tile.layer, tile.position * tileDimension);
+    }
+}
+
+void ShadowMapManager::updateCachedAtlas(FEngine& engine, FScene::LightSoa const& lightData,
+        uint32_t maxDimension) noexcept {
+    FLightManager const& lcm = engine.getLightManager();
+    const uint32_t frameId = ++mFrameId;
+
+    auto getEntity = [&](ShadowMapEntry const& entry) {
+        return lcm.getEntity(lightData.elementAt<FScene::LIGHT_INSTANCE>(entry.getLightIndex()));
+    };
+
+    // The layers are the size of the largest requested shadow map, the tiles are lost when it
+    // changes.
+    if (mCachedAtlas.size != maxDimension) {
+        mAtlasAllocator.clear();
+        mCachedCascadeTiles = {};
+        mCachedSpotTiles.clear();
+        mSpotLevelBias = 0;
+    }
+
+    // Free the tiles of the shadow maps that are gone. Pointers to the tiles are only taken once
+    // no more tiles are added or removed.
+    for (size_t c = mCascadeShadowMaps.size(); c < CONFIG_MAX_SHADOW_CASCADES; c++) {
+        CachedTile& tile = mCachedCascadeTiles[c];
+        if (tile.allocated) {
+            mAtlasAllocator.free(tile.allocation);
+        }
+        tile = {};
+    }
+    for (auto const& entry : mSpotShadowMaps) {
+        mCachedSpotTiles[getEntity(entry)].usedFrame = frameId;
+    }
+    for (auto it = mCachedSpotTiles.begin(); it != mCachedSpotTiles.end();) {
+        if (it->second.usedFrame != frameId) {
+            if (it->second.allocated) {
+                mAtlasAllocator.free(it->second.allocation);
+            }
+            it = mCachedSpotTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    ShadowMapEntry* entries[CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOWED_SPOTS];
+    size_t entryCount = 0;
+    for (size_t c = 0, n = mCascadeShadowMaps.size(); c < n; c++) {
+        mCascadeShadowMaps[c].setCachedTile(&mCachedCascadeTiles[c]);
+        entries[entryCount++] = &mCascadeShadowMaps[c];
+    }
+    for (auto& entry : mSpotShadowMaps) {
+        entry.setCachedTile(&mCachedSpotTiles.find(getEntity(entry)).value());
+        entries[entryCount++] = &entry;
+    }
+
+    auto getLevel = [this, maxDimension](ShadowMapEntry const* entry) {
+        const uint8_t level = getTileLevel(maxDimension, entry->getDimension());
+        const bool isSpot = entry >= mSpotShadowMaps.begin() && entry < mSpotShadowMaps.end();
+        return uint8_t(std::min(size_t(level + (isSpot ? mSpotLevelBias : 0u)),
+                AtlasAllocator::MAX_LEVEL));
+    };
+
+    // A tile is kept while it's about the right size, so that shadow maps whose size hovers
+    // around a power of two are not moved every frame. A shadow map that moves must be rendered
+    // again.
+    for (size_t i = 0; i < entryCount; i++) {
+        CachedTile& tile = *entries[i]->getCachedTile();
+        if (tile.allocated && std::abs(int(tile.allocation.level) - int(getLevel(entries[i]))) > 1) {
+            mAtlasAllocator.free(tile.allocation);
+            tile.allocated = false;
+            tile.renderedFrame = 0;
+        }
+    }
+
+    // Allocating the largest tiles first packs them with fewer holes.
+    std::stable_sort(entries, entries + entryCount,
+            [](ShadowMapEntry const* lhs, ShadowMapEntry const* rhs) {
+                return lhs->getDimension() > rhs->getDimension();
+            });
+
+    bool full = false;
+    for (size_t i = 0; i < entryCount && !full; i++) {
+        CachedTile& tile = *entries[i]->getCachedTile();
+        if (!tile.allocated) {
+            tile.allocated = mAtlasAllocator.allocate(getLevel(entries[i]), &tile.allocation);
+            tile.renderedFrame = 0;
+            full = !tile.allocated;
+        }
+    }
+
+    // When the atlas is full, the tiles are all allocated again, with smaller spotlight shadow
+    // maps if needed. With the smallest tiles, all the spotlights fit in the layers the
+    // cascades leave.
+    static_assert(CONFIG_MAX_SHADOWED_SPOTS <= CONFIG_MAX_SHADOW_CASTING_SPOTS
+            << (2u * AtlasAllocator::MAX_LEVEL));
+    if (full) {
+        for (mSpotLevelBias = 0; mSpotLevelBias <= AtlasAllocator::MAX_LEVEL; mSpotLevelBias++) {
+            mAtlasAllocator.clear();
+            full = false;
+            for (size_t i = 0; i < entryCount && !full; i++) {
+                CachedTile& tile = *entries[i]->getCachedTile();
+                tile.allocated = mAtlasAllocator.allocate(getLevel(entries[i]), &tile.allocation);
+                tile.renderedFrame = 0;
+                full = !tile.allocated;
+            }
+            if (!full) {
+                break;
+            }
+        }
+        assert_invariant(!full);
+    }
+
+    // the shadow maps are lost when the texture is created again
+    const uint8_t layers = uint8_t(mAtlasAllocator.getLayerCount());
+    if (!mCachedAtlas.texture || mCachedAtlas.size != maxDimension ||
+        mCachedAtlas.layers < layers) {
+        DriverApi& driver = engine.getDriverApi();
+        for (size_t l = 0; l < mCachedAtlas.layers; l++) {
+            driver.destroyRenderTarget(mCachedAtlas.renderTargets[l]);
+        }
+        if (mCachedAtlas.texture) {
+            driver.destroyTexture(mCachedAtlas.texture);
+        }
+        mCachedAtlas.texture = driver.createTexture(SamplerType::SAMPLER_2D_ARRAY, 1,
+                mTextureFormat, 1, maxDimension, maxDimension, layers,
+                TextureUsage::DEPTH_ATTACHMENT | TextureUsage::SAMPLEABLE);
+        for (uint8_t l = 0; l < layers; l++) {
+            mCachedAtlas.renderTargets[l] = driver.createRenderTarget(TargetBufferFlags::DEPTH,
+                    maxDimension, maxDimension, 1, {}, { mCachedAtlas.texture, 0, l }, {});
+        }
+        mCachedAtlas.size = uint16_t(maxDimension);
+        mCachedAtlas.layers = layers;
+        for (size_t i = 0; i < entryCount; i++) {
+            entries[i]->getCachedTile()->renderedFrame = 0;
+        }
+    }
+
+    // the shadow map of a light that changed since it was rendered is wrong, but usable
+    for (auto& entry : mSpotShadowMaps) {
+        CachedTile& tile = *entry.getCachedTile();
+        const size_t lightIndex = entry.getLightIndex();
+        tile.stale = tile.renderedFrame &&
+                (tile.positionRadius != lightData.elementAt<FScene::POSITION_RADIUS>(lightIndex) ||
+                 tile.direction != lightData.elementAt<FScene::DIRECTION>(lightIndex) ||
+                 tile.outerConeAngle != lcm.getSpotLightOuterCone(
+                         lightData.elementAt<FScene::LIGHT_INSTANCE>(lightIndex)));
+    }
+
+    // Pick the spotlights rendered this frame: the ones whose shadow map was never rendered in
+    // its tile, then the ones that changed since, then the ones rendered the longest ago. The
+    // order of coverage is kept otherwise.
+    auto getRank = [](ShadowMapEntry const& entry) -> uint64_t {
+        CachedTile const& tile = *entry.getCachedTile();
+        return !tile.renderedFrame ? 0u : tile.stale ? 1u : 2u + tile.renderedFrame;
+    };
+    std::stable_sort(mSpotShadowMaps.begin(), mSpotShadowMaps.end(),
+            [&getRank](ShadowMapEntry const& lhs, ShadowMapEntry const& rhs) {
+                return getRank(lhs) < getRank(rhs);
+            });
+
+    // The spotlights that are not rendered and have no shadow map yet get none this frame.
+    const size_t renderedCount = CONFIG_MAX_SHADOW_CASTING_SPOTS;
+    auto const firstCached = std::find_if(
+            mSpotShadowMaps.begin() + renderedCount, mSpotShadowMaps.end(),
+            [](ShadowMapEntry const& entry) { return entry.getCachedTile()->renderedFrame; });
+    mSpotShadowMaps.erase(mSpotShadowMaps.begin() + renderedCount, firstCached);
+
+    for (size_t i = 0, c = mSpotShadowMaps.size(); i < c; i++) {
+        mSpotShadowMaps[i].setShadowMap(i < renderedCount ? getSpotShadowMap(i) : nullptr);
+    }
+
+    auto setTile = [maxDimension](ShadowMapEntry& entry) {
+        AtlasAllocator::Allocation const& tile = entry.getCachedTile()->allocation;
+        // use the whole tile, as long as it's not larger than requested
+        const uint16_t tileDimension = uint16_t(maxDimension >> tile.level);
+        entry.setDimension(uint16_t(std::min(uint32_t(tileDimension),
+                entry.getShadowOptions()->mapSize)));
+        entry.setTile(tile.layer, tile.position * tileDimension);
+    };
+    for (auto& entry : mCascadeShadowMaps) {
+        setTile(entry);
+    }
+    for (auto& entry : mSpotShadowMaps) {
+        setTile(entry);
+    }
+}
+
 ShadowMapManager::CascadeSplits::CascadeSplits(Params const& params) noexcept
         : mSplitCount(params.cascadeCount + 1) {
     for (size_t s = 0; s < mSplitCount; s++) {
@@ -19,6 +19,7 @@
 
 #include <filament/Viewport.h>
 
+#include "AtlasAllocator.h"
 #include "ShadowMap.h"
 #include "TypedUniformBuffer.h"
 
@@ -26,6 +27,7 @@
 #include "details/Scene.h"
 
 #include <private/filament/EngineEnums.h>
+#include <private/filament/UibStructs.h>
 
 #include <private/backend/DriverApi.h>
 #include <private/backend/DriverApiForward.h>
@@ -34,9 +36,13 @@
 #include <backend/DriverEnums.h>
 #include <backend/Handle.h>
 
+#include <utils/Entity.h>
 #include <utils/FixedCapacityVector.h>
 
 #include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <tsl/robin_map.h>
 
 #include <array>
 #include <memory>
@@ -51,6 +57,7 @@ class RenderPass;
 
 struct ShadowMappingUniforms {
     std::array<math::mat4f, CONFIG_MAX_SHADOW_CASCADES> lightFromWorldMatrix;
+    std::array<math::float4, CONFIG_MAX_SHADOW_CASCADES> cascadeTileRects;
     math::float4 cascadeSplits;
     float shadowBulbRadiusLs;
     float shadowBias;
@@ -74,10 +81,18 @@ public:
     explicit ShadowMapManager(FEngine& engine);
     ~ShadowMapManager();
 
+    // Destroys the atlas kept from one frame to the next, if any.
+    void terminate(backend::DriverApi& driver) noexcept;
+
     // Reset shadow map layout.
     void reset() noexcept;
 
     void setShadowCascades(size_t lightIndex, LightManager::ShadowOptions const* options) noexcept;
+
+    // Adds a shadow-casting spotlight. Any number of spotlights can be added, the
+    // CONFIG_MAX_SHADOWED_SPOTS covering the most of the screen get a shadow map. At most
+    // CONFIG_MAX_SHADOW_CASTING_SPOTS of them are rendered each frame, the others keep the one
+    // rendered in an earlier frame. With VSM, only CONFIG_MAX_SHADOW_CASTING_SPOTS get one.
     void addSpotShadowMap(size_t lightIndex, LightManager::ShadowOptions const* options) noexcept;
 
     // Updates all of the shadow maps and performs culling.
@@ -122,8 +137,40 @@ private:
             FView& view, FScene::RenderableSoa& renderableData, FScene::LightSoa& lightData,
             ShadowMap::SceneInfo& sceneInfo, TypedUniformBuffer<ShadowUib>& shadowUb) noexcept;
 
+    void prioritizeSpotShadowMaps(FView const& view, FScene::LightSoa const& lightData) noexcept;
+
     void calculateTextureRequirements(FEngine& engine, FView& view, FScene::LightSoa& lightData) noexcept;
 
+    // Lays out the atlas anew, every shadow map is rendered this frame.
+    void packAtlas(uint32_t maxDimension, bool vsm) noexcept;
+
+    // Updates the atlas kept from the previous frame, and picks the spot shadow maps rendered
+    // this frame.
+    void updateCachedAtlas(FEngine& engine, FScene::LightSoa const& lightData,
+            uint32_t maxDimension) noexcept;
+
+    void destroyCachedAtlas(backend::DriverApi& driver) noexcept;
+
+    // Fraction of the viewport's height covered by a sphere, 1 if the camera is inside it
+    static float computeScreenCoverage(CameraInfo const& camera,
+            math::float3 const& center, float radius) noexcept;
+
+    // A shadow map's place in the atlas kept from one frame to the next, and what's needed to
+    // sample it in the frames where it's not rendered.
+    struct CachedTile {
+        AtlasAllocator::Allocation allocation{};
+        bool allocated = false;
+        bool hasVisibleShadows = false;
+        uint32_t renderedFrame = 0;     // last frame the shadow map was rendered in this tile
+        uint32_t usedFrame = 0;         // last frame the light had a shadow map
+        bool stale = false;             // the light changed since the shadow map was rendered
+        // the light's parameters when the shadow map was rendered
+        math::float4 positionRadius{};
+        math::float3 direction{};
+        float outerConeAngle = 0.0f;
+        ShadowUib::ShadowData shadowData{};
+    };
+
     class ShadowMapEntry {
     public:
         ShadowMapEntry() = default;
@@ -134,8 +181,29 @@ private:
 
         explicit operator bool() const { return mShadowMap != nullptr; }
 
-        void setLayer(uint8_t layer) noexcept { mLayer = layer; }
+        // null for the spot shadow maps that are not rendered this frame
+        void setShadowMap(ShadowMap* shadowMap) noexcept { mShadowMap = shadowMap; }
+        bool isRendered() const noexcept { return mShadowMap != nullptr; }
+
+        // the entry's tile in the atlas kept from one frame to the next, if it's used
+        void setCachedTile(CachedTile* tile) noexcept { mCachedTile = tile; }
+        CachedTile* getCachedTile() const noexcept { return mCachedTile; }
+
+        // fraction of the screen covered by the light, which decides its shadow map's size
+        void setCoverage(float coverage) noexcept { mCoverage = coverage; }
+        float getCoverage() const noexcept { return mCoverage; }
+
+        // dimension of the shadow map in the atlas, in texels, including the 1-texel border
+        void setDimension(uint16_t dimension) noexcept { mDimension = dimension; }
+        uint16_t getDimension() const noexcept { return mDimension; }
+
+        // position of the shadow map in the atlas
+        void setTile(uint8_t layer, math::ushort2 offset) noexcept {
+            mLayer = layer;
+            mOffset = offset;
+        }
         uint8_t getLayer() const noexcept { return mLayer; }
+        math::ushort2 getOffset() const noexcept { return mOffset; }
 
         LightManager::ShadowOptions const* getShadowOptions() const noexcept { return mOptions; }
         ShadowMap& getShadowMap() const { return *mShadowMap; }
@@ -145,8 +213,12 @@ private:
 
     private:
         ShadowMap* mShadowMap = nullptr;
+        CachedTile* mCachedTile = nullptr;
         LightManager::ShadowOptions const* mOptions = nullptr;
         uint32_t mLightIndex = 0;
+        float mCoverage = 0.0f;
+        uint16_t mDimension = 0;
+        math::ushort2 mOffset{};
         uint8_t mLayer = 0;
     };
 
@@ -195,6 +267,25 @@ private:
         uint8_t levels = 0;
     } mTextureAtlasRequirements;
 
+    // packs the shadow maps into the layers of the atlas
+    AtlasAllocator mAtlasAllocator{ CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOW_CASTING_SPOTS };
+
+    // When there are more shadowed spotlights than can be rendered in a frame, the atlas is kept
+    // from one frame to the next, along with the place of each shadow map in it.
+    struct CachedAtlas {
+        backend::Handle<backend::HwTexture> texture;
+        // one per layer, the shadow maps rendered in a frame are copied into them
+        std::array<backend::Handle<backend::HwRenderTarget>,
+                CONFIG_MAX_SHADOW_CASCADES + CONFIG_MAX_SHADOW_CASTING_SPOTS> renderTargets;
+        uint16_t size = 0;
+        uint8_t layers = 0;
+    } mCachedAtlas;
+    std::array<CachedTile, CONFIG_MAX_SHADOW_CASCADES> mCachedCascadeTiles;
+    tsl::robin_map<utils::Entity, CachedTile> mCachedSpotTiles;
+    uint32_t mFrameId = 0;
+    // spotlight shadow maps are made this many times smaller when they don't all fit in the atlas
+    uint8_t mSpotLevelBias = 0;
+
     SoftShadowOptions mSoftShadowOptions;
 
     CascadeSplits::Params mCascadeSplitParams;
@@ -211,9 +302,11 @@ private:
             utils::FixedCapacityVector<ShadowMapEntry>::with_capacity(
                     CONFIG_MAX_SHADOW_CASCADES) };
 
+    // All the shadow-casting spotlights until prioritizeSpotShadowMaps() keeps the most important.
+    // The ones rendered this frame come first, at the index of their ShadowMap.
     utils::FixedCapacityVector<ShadowMapEntry> mSpotShadowMaps{
             utils::FixedCapacityVector<ShadowMapEntry>::with_capacity(
-                    CONFIG_MAX_SHADOW_CASTING_SPOTS) };
+                    CONFIG_MAX_LIGHT_COUNT) };
 
     // inline storage for all our ShadowMap objects, we can't easily use a std::array<> directly.
     // because ShadowMap doesn't have a default ctor, and we avoid out-of-line allocations.
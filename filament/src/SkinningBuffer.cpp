@@ -126,6 +126,7 @@ void FSkinningBuffer::setBones(FEngine& engine, Handle<backend::HwBufferObject>
         transform[3] = float4{ transforms[i].translation, 1.0f };
         out[i] = makeBone(transform);
     }
+    engine.getFrameStatistics().uploadedBytes += boneCount * sizeof(PerRenderableUibBone);
     driverApi.updateBufferObject(handle, {
                     out, boneCount * sizeof(PerRenderableUibBone) },
             offset * sizeof(PerRenderableUibBone));
@@ -160,6 +161,7 @@ void FSkinningBuffer::setBones(FEngine& engine, Handle<backend::HwBufferObject>
         // the transform is stored in row-major, last row is not stored.
         out[i] = makeBone(transforms[i]);
     }
+    engine.getFrameStatistics().uploadedBytes += boneCount * sizeof(PerRenderableUibBone);
     driverApi.updateBufferObject(handle, {
                     out, boneCount * sizeof(PerRenderableUibBone) },
             offset * sizeof(PerRenderableUibBone));
@@ -162,9 +162,30 @@ FTexture::FTexture(FEngine& engine, const Builder& builder) {
     }
 }
 
+FTexture::FTexture(FEngine& engine, const Builder& builder,
+        uint32_t streamingId, uint8_t baseLevel) {
+    mWidth  = static_cast<uint32_t>(builder->mWidth);
+    mHeight = static_cast<uint32_t>(builder->mHeight);
+    mFormat = builder->mFormat;
+    mUsage = builder->mUsage;
+    mTarget = builder->mTarget;
+    mLevelCount = std::min(builder->mLevels, FTexture::maxLevelCount(mWidth, mHeight));
+    mStreamingId = streamingId;
+
+    assert_invariant(mTarget == Sampler::SAMPLER_2D);
+    assert_invariant(baseLevel < mLevelCount);
+
+    FEngine::DriverApi& driver = engine.getDriverApi();
+    mHandle = driver.createTexture(mTarget, mLevelCount - baseLevel, mFormat, mSampleCount,
+            getWidth(baseLevel), getHeight(baseLevel), mDepth, mUsage);
+}
+
 // frees driver resources, object becomes invalid
 void FTexture::terminate(FEngine& engine) {
     FEngine::DriverApi& driver = engine.getDriverApi();
+    if (mStreamingId) {
+        engine.getTextureStreamer().destroy(driver, mStreamingId);
+    }
     driver.destroyTexture(mHandle);
 }
 
@@ -207,6 +228,11 @@ void FTexture::setImage(FEngine& engine,
         return;
     }
 
+    if (!ASSERT_POSTCONDITION_NON_FATAL(!mStreamingId,
+            "setImage() called on a streamed texture.")) {
+        return;
+    }
+
     if (!ASSERT_POSTCONDITION_NON_FATAL(level < mLevelCount,
             "level=%u is >= to levelCount=%u.", unsigned(level), unsigned(mLevelCount))) {
         return;
@@ -238,6 +264,7 @@ void FTexture::setImage(FEngine& engine,
         return;
     }
 
+    engine.getFrameStatistics().uploadedBytes += buffer.size;
     engine.getDriverApi().update2DImage(mHandle,
             uint8_t(level), xoffset, yoffset, width, height, std::move(buffer));
 }
@@ -309,6 +336,7 @@ void FTexture::setImage(FEngine& engine,
         return;
     }
 
+    engine.getFrameStatistics().uploadedBytes += buffer.size;
     engine.getDriverApi().update3DImage(mHandle,
             uint8_t(level), xoffset, yoffset, zoffset, width, height, depth, std::move(buffer));
 }
@@ -353,6 +381,7 @@ void FTexture::setImage(FEngine& engine, size_t level,
         return;
     }
 
+    engine.getFrameStatistics().uploadedBytes += buffer.size;
     engine.getDriverApi().updateCubeImage(mHandle, uint8_t(level),
             std::move(buffer), faceOffsets);
 }
@@ -0,0 +1,538 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "details/TextureStreamer.h"
+
+#include "RenderPrimitive.h"
+
+#include "details/Camera.h"
+#include "details/Engine.h"
+#include "details/MaterialInstance.h"
+#include "details/Texture.h"
+
+#include "private/backend/BackendUtils.h"
+
+#include <utils/JobSystem.h>
+#include <utils/Log.h>
+#include <utils/Panic.h>
+#include <utils/Systrace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <queue>
+
+using namespace utils;
+
+namespace filament {
+
+using namespace backend;
+using namespace math;
+
+FTextureStreamer::FTextureStreamer(FEngine& engine) noexcept
+        : mEngine(engine) {
+}
+
+FTextureStreamer::~FTextureStreamer() noexcept {
+    assert_invariant(!mLoader.joinable());
+}
+
+void FTextureStreamer::terminate(FEngine& engine) {
+    DriverApi& driver = engine.getDriverApi();
+
+    std::deque<Request> requests;
+    if (mLoader.joinable()) {
+        {
+            std::lock_guard<Mutex> lock(mLock);
+            std::swap(requests, mRequests);
+            mExitRequested = true;
+        }
+        mCondition.notify_one();
+        mLoader.join();
+    }
+
+    // the sources of textures destroyed recently may still be waiting to be released
+    for (Request const& request : requests) {
+        if (!request.id) {
+            delete request.source;
+        }
+    }
+
+    // this frees the levels that were loaded but not uploaded
+    mResults.clear();
+
+    for (auto pos = mEntries.begin(); pos != mEntries.end(); ++pos) {
+        Entry& entry = pos.value();
+        cancelLoading(driver, entry, pos->first);
+        delete entry.source;
+    }
+    mEntries.clear();
+
+    for (Handle<HwTexture> handle : mRetired) {
+        driver.destroyTexture(handle);
+    }
+    mRetired.clear();
+    mResidentSize = 0;
+}
+
+FTexture* FTextureStreamer::createTexture(Source* source) {
+    ASSERT_PRECONDITION(source, "TextureStreamer::createTexture() needs a Source");
+
+    Source::Info const info = source->getInfo();
+    if (!ASSERT_PRECONDITION_NON_FATAL(info.width && info.height && info.levels,
+            "Invalid Source: %u x %u, %u levels",
+            unsigned(info.width), unsigned(info.height), unsigned(info.levels))) {
+        delete source;
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.source = source;
+    entry.width = info.width;
+    entry.height = info.height;
+    entry.format = info.format;
+    entry.levelCount = std::min(info.levels, FTexture::maxLevelCount(info.width, info.height));
+
+    // the levels that are small enough are always resident
+    const uint32_t size = std::max(info.width, info.height);
+    uint8_t tailLevel = 0;
+    while (tailLevel + 1 < entry.levelCount && (size >> tailLevel) > mConfig.residentSize) {
+        tailLevel++;
+    }
+    entry.tailLevel = tailLevel;
+    entry.minLevel = tailLevel;
+    entry.residentLevel = tailLevel;
+    entry.lastSeen = mFrameId;
+
+    const uint32_t id = ++mNextId;
+    FTexture* const texture = mEngine.createStreamedTexture(Texture::Builder()
+                    .width(info.width)
+                    .height(info.height)
+                    .levels(entry.levelCount)
+                    .sampler(Texture::Sampler::SAMPLER_2D)
+                    .format(info.format),
+            id, tailLevel);
+
+    DriverApi& driver = mEngine.getDriverApi();
+    for (size_t level = tailLevel; level < entry.levelCount; level++) {
+        Texture::PixelBufferDescriptor buffer;
+        if (!source->load(level, &buffer) ||
+                !upload(driver, entry, texture->getHwHandle(), tailLevel, uint8_t(level),
+                        std::move(buffer))) {
+            slog.e << "TextureStreamer: couldn't load level " << level << io::endl;
+            mEngine.destroy(texture);
+            delete source;
+            return nullptr;
+        }
+    }
+
+    entry.texture = texture;
+    mResidentSize += computeSize(entry.format, entry.width, entry.height,
+            entry.residentLevel, entry.levelCount);
+    mEntries.insert({ id, entry });
+
+    if (UTILS_UNLIKELY(!mLoader.joinable())) {
+        mLoader = std::thread(&FTextureStreamer::loop, this);
+    }
+    return texture;
+}
+
+size_t FTextureStreamer::getResidentLevel(FTexture const* texture) const noexcept {
+    auto pos = mEntries.find(texture->getStreamingId());
+    return pos != mEntries.end() ? pos->second.residentLevel : 0;
+}
+
+Handle<HwTexture> FTextureStreamer::getHandle(uint32_t streamingId) const noexcept {
+    auto pos = mEntries.find(streamingId);
+    return pos != mEntries.end() ? pos->second.texture->getHwHandle() : Handle<HwTexture>{};
+}
+
+void FTextureStreamer::destroy(DriverApi& driver, uint32_t streamingId) noexcept {
+    auto pos = mEntries.find(streamingId);
+    if (pos == mEntries.end()) {
+        return;
+    }
+    Entry& entry = pos.value();
+    cancelLoading(driver, entry, streamingId);
+    mResidentSize -= computeSize(entry.format, entry.width, entry.height,
+            entry.residentLevel, entry.levelCount);
+
+    // the source may be in use by the loader, so it's destroyed there
+    {
+        std::lock_guard<Mutex> lock(mLock);
+        mRequests.push_back({ 0, 0, 0, entry.source });
+    }
+    mCondition.notify_one();
+    mEntries.erase(pos);
+}
+
+void FTextureStreamer::prepareView(float3 const* UTILS_RESTRICT centers,
+        float3 const* UTILS_RESTRICT extents,
+        Slice<FRenderPrimitive> const* UTILS_RESTRICT primitives,
+        Range<uint32_t> visible,
+        CameraInfo const& camera, filament::Viewport const& viewport) noexcept {
+    SYSTRACE_CALL();
+
+    // size in pixels of a bounding sphere of radius 1 at a distance of 1, the distance doesn't
+    // matter with an orthographic projection
+    const bool perspective = camera.projection[2][3] != 0.0f;
+    const float pixelScale = camera.projection[1][1] * float(viewport.height);
+    const float3 eye = camera.getPosition();
+
+    for (uint32_t i : visible) {
+        const float radius = length(extents[i]);
+        float footprint = pixelScale * radius;
+        if (perspective) {
+            footprint /= std::max(length(centers[i] - eye) - radius, camera.zn);
+        }
+        for (FRenderPrimitive const& primitive : primitives[i]) {
+            FMaterialInstance const* const mi = primitive.getMaterialInstance();
+            if (!mi) {
+                continue;
+            }
+            for (auto const& sampler : mi->getStreamedSamplers()) {
+                auto pos = mEntries.find(sampler.streamingId);
+                if (pos != mEntries.end()) {
+                    Entry& entry = pos.value();
+                    entry.footprint = std::max(entry.footprint, footprint);
+                }
+            }
+        }
+    }
+}
+
+void FTextureStreamer::update(DriverApi& driver) {
+    if (mEntries.empty() && mRetired.empty()) {
+        return;
+    }
+
+    SYSTRACE_CALL();
+
+    // material instances stopped using these last frame
+    for (Handle<HwTexture> handle : mRetired) {
+        driver.destroyTexture(handle);
+    }
+    mRetired.clear();
+
+    mFrameId++;
+
+    /*
+     * Upload the levels loaded since the last frame, and swap in the textures that are complete
+     */
+
+    {
+        std::lock_guard<Mutex> lock(mLock);
+        std::swap(mResults, mLoaded);
+    }
+    for (Result& result : mLoaded) {
+        auto pos = mEntries.find(result.id);
+        if (pos == mEntries.end()) {
+            continue;
+        }
+        Entry& entry = pos.value();
+        if (!entry.pending || result.generation != entry.generation) {
+            // loading was cancelled
+            continue;
+        }
+        if (!result.success || !upload(driver, entry, entry.pending, entry.pendingLevel,
+                result.level, std::move(result.buffer))) {
+            // stay at the levels we have, and don't try this one again
+            slog.w << "TextureStreamer: couldn't load level " << unsigned(result.level)
+                   << io::endl;
+            entry.minLevel = std::max(entry.minLevel, uint8_t(result.level + 1u));
+            cancelLoading(driver, entry, result.id);
+            continue;
+        }
+        if (--entry.pendingRemaining == 0) {
+            mRetired.push_back(entry.texture->mHandle);
+            mResidentSize -= computeSize(entry.format, entry.width, entry.height,
+                    entry.residentLevel, entry.levelCount);
+            mResidentSize += computeSize(entry.format, entry.width, entry.height,
+                    entry.pendingLevel, entry.levelCount);
+            entry.texture->mHandle = entry.pending;
+            entry.residentLevel = entry.pendingLevel;
+            entry.pending.clear();
+            mPendingCount--;
+            mHandlesChanged = true;
+        }
+    }
+    mLoaded.clear();
+
+    /*
+     * Pick the level each texture should have, within the budget
+     */
+
+    mCandidates.clear();
+    mIds.clear();
+    for (auto pos = mEntries.begin(); pos != mEntries.end(); ++pos) {
+        Entry& entry = pos.value();
+        if (entry.footprint > 0.0f) {
+            entry.lastSeen = mFrameId;
+        }
+        const uint8_t wanted = std::max(entry.minLevel,
+                computeLevel(std::max(entry.width, entry.height), entry.footprint,
+                        mConfig.lodBias, entry.tailLevel));
+        // levels that are resident, or being loaded, are kept as long as the budget allows
+        const uint8_t current = entry.pending ? entry.pendingLevel : entry.residentLevel;
+        mCandidates.push_back({
+                entry.width, entry.height, entry.format, entry.levelCount, entry.tailLevel,
+                std::min(wanted, current), entry.footprint, mFrameId - entry.lastSeen });
+        mIds.push_back(pos->first);
+        entry.footprint = 0.0f;
+    }
+
+    fitToBudget(mCandidates.data(), mCandidates.size(), mConfig.budget);
+
+    /*
+     * Start loading the textures that need to change, the evictions first because they free
+     * memory, then the textures with the fewest texels per pixel.
+     */
+
+    mOrder.clear();
+    for (uint32_t i = 0, c = uint32_t(mCandidates.size()); i < c; i++) {
+        Entry const& entry = mEntries[mIds[i]];
+        if (!entry.pending && mCandidates[i].level != entry.residentLevel) {
+            mOrder.push_back(i);
+        }
+    }
+
+    const size_t available = mConfig.maxPendingTextures > mPendingCount ?
+            mConfig.maxPendingTextures - mPendingCount : 0;
+    if (mOrder.empty() || !available) {
+        return;
+    }
+
+    auto texelsPerPixel = [this](uint32_t i) {
+        Candidate const& candidate = mCandidates[i];
+        const uint8_t resident = mEntries[mIds[i]].residentLevel;
+        return float(std::max(candidate.width, candidate.height) >> resident) /
+                candidate.footprint;
+    };
+    auto isEviction = [this](uint32_t i) {
+        return mCandidates[i].level > mEntries[mIds[i]].residentLevel;
+    };
+    const size_t count = std::min(available, mOrder.size());
+    std::partial_sort(mOrder.begin(), mOrder.begin() + count, mOrder.end(),
+            [&](uint32_t lhs, uint32_t rhs) {
+                if (isEviction(lhs) != isEviction(rhs)) {
+                    return isEviction(lhs);
+                }
+                return texelsPerPixel(lhs) < texelsPerPixel(rhs);
+            });
+
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t index = mOrder[i];
+        const uint32_t id = mIds[index];
+        startLoading(driver, mEntries[id], id, mCandidates[index].level);
+    }
+}
+
+void FTextureStreamer::startLoading(DriverApi& driver, Entry& entry, uint32_t id, uint8_t level) {
+    assert_invariant(!entry.pending);
+    assert_invariant(level < entry.levelCount);
+
+    entry.generation++;
+    entry.pending = driver.createTexture(SamplerType::SAMPLER_2D,
+            entry.levelCount - level, entry.format, 1,
+            FTexture::valueForLevel(level, entry.width),
+            FTexture::valueForLevel(level, entry.height),
+            1, entry.texture->getUsage());
+    entry.pendingLevel = level;
+    entry.pendingRemaining = entry.levelCount - level;
+    mPendingCount++;
+
+    // All the levels are loaded again, even those that are already resident, because the
+    // backends can't copy mip levels between textures, compressed or not. This makes an eviction
+    // cost as much I/O as loading the levels that remain.
+    // The least detailed levels first, these are the quickest to load.
+    {
+        std::lock_guard<Mutex> lock(mLock);
+        for (size_t l = entry.levelCount; l-- > level;) {
+            mRequests.push_back({ id, entry.generation, uint8_t(l), entry.source });
+        }
+    }
+    mCondition.notify_one();
+}
+
+void FTextureStreamer::cancelLoading(DriverApi& driver, Entry& entry, uint32_t id) noexcept {
+    if (!entry.pending) {
+        return;
+    }
+    {
+        std::lock_guard<Mutex> lock(mLock);
+        mRequests.erase(std::remove_if(mRequests.begin(), mRequests.end(),
+                [id](Request const& request) { return request.id == id; }), mRequests.end());
+    }
+    driver.destroyTexture(entry.pending);
+    entry.pending.clear();
+    entry.generation++;
+    mPendingCount--;
+}
+
+bool FTextureStreamer::upload(DriverApi& driver, Entry const& entry,
+        Handle<HwTexture> handle, uint8_t baseLevel, uint8_t level,
+        Texture::PixelBufferDescriptor&& buffer) const {
+    if (!buffer.buffer) {
+        return false;
+    }
+    if (buffer.type != PixelDataType::COMPRESSED &&
+            !FTexture::validatePixelFormatAndType(entry.format, buffer.format, buffer.type)) {
+        return false;
+    }
+    mEngine.getFrameStatistics().uploadedBytes += buffer.size;
+    driver.update2DImage(handle, uint8_t(level - baseLevel), 0, 0,
+            uint32_t(FTexture::valueForLevel(level, entry.width)),
+            uint32_t(FTexture::valueForLevel(level, entry.height)),
+            std::move(buffer));
+    return true;
+}
+
+void FTextureStreamer::loop() {
+    JobSystem::setThreadName("TextureStreamer");
+    while (true) {
+        Request request;
+        {
+            std::unique_lock<Mutex> lock(mLock);
+            mCondition.wait(lock, [this]() { return mExitRequested || !mRequests.empty(); });
+            if (mExitRequested) {
+                return;
+            }
+            request = mRequests.front();
+            mRequests.pop_front();
+        }
+
+        if (!request.id) {
+            delete request.source;
+            continue;
+        }
+
+        Texture::PixelBufferDescriptor buffer;
+        const bool success = request.source->load(request.level, &buffer);
+
+        std::lock_guard<Mutex> lock(mLock);
+        mResults.push_back({
+                request.id, request.generation, request.level, success, std::move(buffer) });
+    }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+size_t FTextureStreamer::computeSize(TextureFormat format, uint32_t width, uint32_t height,
+        uint8_t baseLevel, uint8_t levelCount) noexcept {
+    const size_t bytes = getFormatSize(format);
+    const size_t blockWidth = std::max(getBlockWidth(format), size_t(1));
+    const size_t blockHeight = std::max(getBlockHeight(format), size_t(1));
+    size_t size = 0;
+    for (uint8_t level = baseLevel; level < levelCount; level++) {
+        const size_t w = FTexture::valueForLevel(level, width);
+        const size_t h = FTexture::valueForLevel(level, height);
+        size += ((w + blockWidth - 1) / blockWidth) * ((h + blockHeight - 1) / blockHeight) * bytes;
+    }
+    return size;
+}
+
+uint8_t FTextureStreamer::computeLevel(uint32_t size, float footprint, float lodBias,
+        uint8_t tailLevel) noexcept {
+    if (!(footprint > 0.0f)) {
+        return tailLevel;
+    }
+    // the level whose size is closest to, but not smaller than, the footprint
+    const float level = std::log2(float(size) / footprint) + lodBias;
+    if (!(level > 0.0f)) {
+        return 0;
+    }
+    return uint8_t(std::min(std::floor(level), float(tailLevel)));
+}
+
+size_t FTextureStreamer::fitToBudget(Candidate* candidates, size_t count, size_t budget) noexcept {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        Candidate const& c = candidates[i];
+        total += computeSize(c.format, c.width, c.height, c.level, c.levelCount);
+    }
+    if (total <= budget) {
+        return total;
+    }
+
+    auto texels = [candidates](uint32_t i) {
+        Candidate const& c = candidates[i];
+        return float(std::max(c.width, c.height) >> c.level);
+    };
+
+    // returns true if lhs should lose a level after rhs
+    auto compare = [candidates, texels](uint32_t lhs, uint32_t rhs) {
+        Candidate const& l = candidates[lhs];
+        Candidate const& r = candidates[rhs];
+        const bool lhsVisible = l.footprint > 0.0f;
+        const bool rhsVisible = r.footprint > 0.0f;
+        if (lhsVisible != rhsVisible) {
+            return lhsVisible;
+        }
+        if (!lhsVisible) {
+            return l.age != r.age ? l.age < r.age : texels(lhs) < texels(rhs);
+        }
+        return texels(lhs) / l.footprint < texels(rhs) / r.footprint;
+    };
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(compare)> queue(compare);
+    for (uint32_t i = 0; i < count; i++) {
+        if (candidates[i].level < candidates[i].tailLevel) {
+            queue.push(i);
+        }
+    }
+
+    while (total > budget && !queue.empty()) {
+        const uint32_t i = queue.top();
+        queue.pop();
+        Candidate& c = candidates[i];
+        total -= computeSize(c.format, c.width, c.height, c.level, c.level + 1);
+        c.level++;
+        if (c.level < c.tailLevel) {
+            queue.push(i);
+        }
+    }
+    return total;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Trampoline calling into private implementation
+// ------------------------------------------------------------------------------------------------
+
+void TextureStreamer::setConfig(Config const& config) noexcept {
+    upcast(this)->setConfig(config);
+}
+
+TextureStreamer::Config const& TextureStreamer::getConfig() const noexcept {
+    return upcast(this)->getConfig();
+}
+
+Texture* TextureStreamer::createTexture(Source* source) {
+    return upcast(this)->createTexture(source);
+}
+
+size_t TextureStreamer::getResidentLevel(Texture const* texture) const noexcept {
+    return upcast(this)->getResidentLevel(upcast(texture));
+}
+
+size_t TextureStreamer::getResidentSize() const noexcept {
+    return upcast(this)->getResidentSize();
+}
+
+size_t TextureStreamer::getPendingCount() const noexcept {
+    return upcast(this)->getPendingCount();
+}
+
+} // namespace filament
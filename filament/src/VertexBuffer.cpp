@@ -225,6 +225,7 @@ void FVertexBuffer::setBufferAt(FEngine& engine, uint8_t bufferIndex,
     ASSERT_PRECONDITION(!mBufferObjectsEnabled, "Please use setBufferObjectAt()");
     if (bufferIndex < mBufferCount) {
         assert_invariant(mBufferObjects[bufferIndex]);
+        engine.getFrameStatistics().uploadedBytes += buffer.size;
         engine.getDriverApi().updateBufferObject(mBufferObjects[bufferIndex],
                std::move(buffer), byteOffset);
     } else {
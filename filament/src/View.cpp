@@ -113,11 +113,12 @@ void FView::terminate(FEngine& engine) {
     }
 
     DriverApi& driver = engine.getDriverApi();
+    mShadowMapManager.terminate(driver);
     driver.destroyBufferObject(mLightUbh);
     driver.destroyBufferObject(mShadowUbh);
-    driver.destroyBufferObject(mRenderableUbh);
     drainFrameHistory(engine);
     mPerViewUniforms.terminate(driver);
+    mPerRenderableUniforms.terminate(driver);
     mFroxelizer.terminate(driver);
 }
 
@@ -307,10 +308,8 @@ void FView::prepareShadowing(FEngine& engine, DriverApi& driver,
     }
 
     // Find all shadow-casting spotlights.
-    size_t shadowCastingSpotCount = 0;
-
-    // We allow a max of CONFIG_MAX_SHADOW_CASTING_SPOTS spot light shadows. Any additional
-    // shadow-casting spotlights are ignored.
+    // The ShadowMapManager keeps the CONFIG_MAX_SHADOWED_SPOTS that cover the most of the screen
+    // (CONFIG_MAX_SHADOW_CASTING_SPOTS with VSM), the others don't cast shadows this frame.
     for (size_t l = FScene::DIRECTIONAL_LIGHTS_COUNT; l < lightData.size(); l++) {
 
         // when we get here all the lights should be visible
@@ -332,10 +331,6 @@ void FView::prepareShadowing(FEngine& engine, DriverApi& driver,
 
         const auto& shadowOptions = lcm.getShadowOptions(li);
         mShadowMapManager.addSpotShadowMap(l, &shadowOptions);
-        ++shadowCastingSpotCount;
-        if (shadowCastingSpotCount > CONFIG_MAX_SHADOW_CASTING_SPOTS - 1) {
-            break; // we ran out of spotlight shadow casting
-        }
     }
 
     auto shadowTechnique = mShadowMapManager.update(engine, *this,
@@ -407,7 +402,8 @@ void FView::prepareLighting(FEngine& engine, FEngine::DriverApi& driver, ArenaSc
 }
 
 void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
-        filament::Viewport const& viewport, float4 const& userTime) noexcept {
+        filament::Viewport const& viewport, float4 const& userTime,
+        CpuStageTimings& timings) noexcept {
     JobSystem& js = engine.getJobSystem();
 
     /*
@@ -417,52 +413,38 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
 
     FScene* const scene = getScene();
 
-    /*
-     * We apply a "world origin" to "everything" in order to implement the IBL rotation.
-     * The "world origin" could also be useful for other things, like keeping the origin
-     * close to the camera position to improve fp precision in the shader for large scenes.
-     */
-    mat4 worldOriginScene;
-    FIndirectLight const* const ibl = scene->getIndirectLight();
-    if (ibl) {
-        // the IBL transformation must be a rigid transform
-        mat3f rotation{ scene->getIndirectLight()->getRotation() };
-        // for a rigid-body transform, the inverse is the transpose
-        worldOriginScene = mat4{ transpose(rotation) };
-    }
+    mat4 const worldOriginScene = getWorldOriginScene(engine);
 
     /*
      * Calculate all camera parameters needed to render this View for this frame.
      */
     FCamera const* const camera = mViewingCamera ? mViewingCamera : mCullingCamera;
 
-    if (engine.debug.view.camera_at_origin) {
-        // this moves the camera to the origin, effectively doing all shader computations in
-        // view-space, which improves floating point precision in the shader by staying around
-        // zero, where fp precision is highest. This also ensures that when the camera is placed
-        // very far from the origin, objects are still rendered and lit properly.
-        worldOriginScene[3].xyz -= camera->getPosition();
-    }
-
     // Note: for debugging (i.e. visualize what the camera / objects are doing, using
     // the viewing camera), we can set worldOriginScene to identity when mViewingCamera
     // is set
     mViewingCameraInfo = CameraInfo(*camera, worldOriginScene);
 
-    mCullingFrustum = Frustum(mat4f{
-                    mCullingCamera->getCullingProjectionMatrix() *
-                    inverse(worldOriginScene * mCullingCamera->getModelMatrix()) });
+    mCullingFrustum = computeCullingFrustum(worldOriginScene);
 
     /*
      * Gather all information needed to render this scene. Apply the world origin to all
      * objects in the scene.
      */
-    scene->prepare(worldOriginScene, hasVSM());
+    {
+        CpuStageTimings::Scope scope(timings, CpuStageTimings::Stage::SCENE_PREPARE);
+        // FRenderer::renderViews() prepares the scene for the first view that uses it
+        if (!mScenePrepared) {
+            scene->prepare(worldOriginScene, hasVSM());
+        }
+    }
 
     /*
      * Light culling: runs in parallel with Renderable culling (below)
      */
 
+    auto cullingStart = CpuStageTimings::clock::now();
+
     JobSystem::Job* prepareVisibleLightsJob = nullptr;
     if (scene->getLightData().size() > FScene::DIRECTIONAL_LIGHTS_COUNT) {
         prepareVisibleLightsJob = js.runAndRetain(js.createJob(nullptr,
@@ -485,7 +467,15 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
          * (this will set the VISIBLE_RENDERABLE bit)
          */
 
-        prepareVisibleRenderables(js, mCullingFrustum, renderableData);
+        if (mPrecomputedVisibility &&
+                mPrecomputedSceneGeneration == scene->getGeneration()) {
+            // culling was done ahead of time, concurrently with other views
+            std::copy_n(mPrecomputedVisibility, renderableData.size(), cullingMask.begin());
+        } else {
+            prepareVisibleRenderables(js, mCullingFrustum, renderableData);
+        }
+        mPrecomputedVisibility = nullptr;
+        mScenePrepared = false;
 
 
         /*
@@ -543,21 +533,13 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
         mSpotLightShadowCasters = Range{ 0, iSpotLightCastersEnd };
         merged = Range{ 0, iSpotLightCastersEnd };
 
+        timings.add(CpuStageTimings::Stage::CULLING, CpuStageTimings::clock::now() - cullingStart);
+
         // update those UBOs
-        const size_t size = merged.size() * sizeof(PerRenderableUib);
-        if (size) {
-            if (mRenderableUBOSize < size) {
-                // allocate 1/3 extra, with a minimum of 16 objects
-                const size_t count = std::max(size_t(16u), (4u * merged.size() + 2u) / 3u);
-                mRenderableUBOSize = uint32_t(count * sizeof(PerRenderableUib));
-                driver.destroyBufferObject(mRenderableUbh);
-                mRenderableUbh = driver.createBufferObject(mRenderableUBOSize,
-                        BufferObjectBinding::UNIFORM, BufferUsage::STREAM);
-            } else {
-                // TODO: should we shrink the underlying UBO at some point?
-            }
-            assert_invariant(mRenderableUbh);
-            scene->updateUBOs(merged, mRenderableUbh);
+        CpuStageTimings::Scope uboScope(timings, CpuStageTimings::Stage::UBO_UPDATE);
+        if (!merged.empty()) {
+            scene->updateUBOs(merged, mPerRenderableUniforms);
+            assert_invariant(mPerRenderableUniforms.getUboHandle());
         }
     }
 
@@ -581,6 +563,47 @@ void FView::prepare(FEngine& engine, DriverApi& driver, ArenaScope& arena,
     bindPerViewUniformsAndSamplers(driver);
 }
 
+mat4 FView::getWorldOriginScene(FEngine const& engine) const noexcept {
+    FScene const* const scene = getScene();
+
+    /*
+     * We apply a "world origin" to "everything" in order to implement the IBL rotation.
+     * The "world origin" could also be useful for other things, like keeping the origin
+     * close to the camera position to improve fp precision in the shader for large scenes.
+     */
+    mat4 worldOriginScene;
+    FIndirectLight const* const ibl = scene->getIndirectLight();
+    if (ibl) {
+        // the IBL transformation must be a rigid transform
+        mat3f rotation{ scene->getIndirectLight()->getRotation() };
+        // for a rigid-body transform, the inverse is the transpose
+        worldOriginScene = mat4{ transpose(rotation) };
+    }
+
+    if (engine.debug.view.camera_at_origin) {
+        // this moves the camera to the origin, effectively doing all shader computations in
+        // view-space, which improves floating point precision in the shader by staying around
+        // zero, where fp precision is highest. This also ensures that when the camera is placed
+        // very far from the origin, objects are still rendered and lit properly.
+        FCamera const* const camera = mViewingCamera ? mViewingCamera : mCullingCamera;
+        worldOriginScene[3].xyz -= camera->getPosition();
+    }
+    return worldOriginScene;
+}
+
+Frustum FView::computeCullingFrustum(mat4 const& worldOriginScene) const noexcept {
+    return Frustum(mat4f{
+            mCullingCamera->getCullingProjectionMatrix() *
+            inverse(worldOriginScene * mCullingCamera->getModelMatrix()) });
+}
+
+void FView::setPrecomputedVisibility(Culler::result_type const* visibility,
+        uint32_t sceneGeneration, bool scenePrepared) noexcept {
+    mPrecomputedVisibility = visibility;
+    mPrecomputedSceneGeneration = sceneGeneration;
+    mScenePrepared = scenePrepared;
+}
+
 void FView::computeVisibilityMasks(
         uint8_t visibleLayers,
         uint8_t const* UTILS_RESTRICT layers,
@@ -1093,6 +1116,14 @@ void View::setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept
     upcast(this)->setDynamicLightingOptions(zLightNear, zLightFar);
 }
 
+void View::setFroxelDensity(float density) noexcept {
+    upcast(this)->setFroxelDensity(density);
+}
+
+float View::getFroxelDensity() const noexcept {
+    return upcast(this)->getFroxelDensity();
+}
+
 void View::setShadowType(View::ShadowType shadow) noexcept {
     upcast(this)->setShadowType(shadow);
 }
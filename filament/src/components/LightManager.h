@@ -60,6 +60,10 @@ public:
         return mManager.getInstance(e);
     }
 
+    utils::Entity getEntity(Instance i) const noexcept {
+        return mManager.getEntity(i);
+    }
+
     void create(const FLightManager::Builder& builder, utils::Entity entity);
 
     void destroy(utils::Entity e) noexcept;
@@ -46,6 +46,7 @@ struct RenderableManager::BuilderDetails {
     using Entry = RenderableManager::Builder::Entry;
     std::vector<Entry> mEntries;
     Box mAABB;
+    Box mQuantizedPositions;
     uint8_t mLayerMask = 0x1;
     uint8_t mPriority = 0x4;
     uint8_t mChannels = 1;
@@ -122,6 +123,11 @@ RenderableManager::Builder& RenderableManager::Builder::boundingBox(const Box& a
     return *this;
 }
 
+RenderableManager::Builder& RenderableManager::Builder::quantizedPositions(const Box& bounds) noexcept {
+    mImpl->mQuantizedPositions = bounds;
+    return *this;
+}
+
 RenderableManager::Builder& RenderableManager::Builder::layerMask(uint8_t select, uint8_t values) noexcept {
     mImpl->mLayerMask = (mImpl->mLayerMask & ~select) | (values & select);
     return *this;
@@ -258,6 +264,15 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
                    << required << "), declared=" << declared << io::endl;
         }
 
+        // positions are dequantized by the model matrix, which other vertex domains don't use
+        if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->mQuantizedPositions.isEmpty() ||
+                material->getVertexDomain() == VertexDomain::OBJECT,
+                "[entity=%u, primitive @ %u] quantized positions require a material in the "
+                "object vertex domain", entity.getId(), i)) {
+            entry.vertices = nullptr;
+            return Error;
+        }
+
         // we have at least one valid primitive
         isEmpty = false;
     }
@@ -271,6 +286,12 @@ RenderableManager::Builder::Result RenderableManager::Builder::build(Engine& eng
         return Error;
     }
 
+    if (!ASSERT_POSTCONDITION_NON_FATAL(mImpl->mQuantizedPositions.isEmpty() ||
+            (!mImpl->mSkinningBoneCount && !mImpl->mMorphingEnabled),
+            "[entity=%u] quantized positions can't be skinned or morphed", entity.getId())) {
+        return Error;
+    }
+
     // we get here only if there was no POSTCONDITION errors.
     upcast(engine).createRenderable(*this, entity);
     return Success;
@@ -319,6 +340,8 @@ void FRenderableManager::create(
         setCulling(ci, builder->mCulling);
         setSkinning(ci, false);
         setMorphing(ci, builder->mMorphingEnabled);
+        // build() checked the materials, and that the renderable isn't skinned or morphed
+        setQuantizedPositions(ci, builder->mQuantizedPositions);
         mManager[ci].channels = builder->mChannels;
 
         const uint32_t boneCount = builder->mSkinningBoneCount;
@@ -398,10 +421,19 @@ void FRenderableManager::destroy(utils::Entity e) noexcept {
     Instance ci = getInstance(e);
     if (ci) {
         destroyComponent(ci);
-        mManager.removeComponent(e);
+        Instance const last = mManager.removeComponent(e);
+        mEngine.onRenderableRemoved(ci, last);
     }
 }
 
+void FRenderableManager::gc(utils::EntityManager& em) noexcept {
+    mManager.gc(em, 4, [this](Entity e) {
+        Instance const ci = getInstance(e);
+        Instance const last = mManager.removeComponent(e);
+        mEngine.onRenderableRemoved(ci, last);
+    });
+}
+
 // this destroys all components in this manager
 void FRenderableManager::terminate() noexcept {
     auto& manager = mManager;
@@ -454,6 +486,13 @@ void FRenderableManager::setMaterialInstanceAt(Instance instance, uint8_t level,
     if (instance) {
         Slice<FRenderPrimitive>& primitives = getRenderPrimitives(instance, level);
         if (primitiveIndex < primitives.size()) {
+            if (UTILS_UNLIKELY(getVisibility(instance).quantizedPositions &&
+                    mi->getMaterial()->getVertexDomain() != VertexDomain::OBJECT)) {
+                slog.w << "[instance=" << instance.asValue() << ", primitive @ " << primitiveIndex
+                       << "] quantized positions require a material in the object vertex domain"
+                       << io::endl;
+                return;
+            }
             primitives[primitiveIndex].setMaterialInstance(upcast(mi));
             AttributeBitset required = mi->getMaterial()->getRequiredAttributes();
             AttributeBitset declared = primitives[primitiveIndex].getEnabledAttributes();
@@ -466,6 +505,36 @@ void FRenderableManager::setMaterialInstanceAt(Instance instance, uint8_t level,
     }
 }
 
+void FRenderableManager::setQuantizedPositions(Instance instance, const Box& bounds) noexcept {
+    if (instance) {
+        if (!bounds.isEmpty()) {
+            const Visibility visibility = getVisibility(instance);
+            if (UTILS_UNLIKELY(visibility.skinning || visibility.morphing)) {
+                slog.w << "[instance=" << instance.asValue()
+                       << "] quantized positions can't be skinned or morphed" << io::endl;
+                return;
+            }
+            // positions are dequantized by the model matrix, which other vertex domains don't use
+            for (size_t l = 0, lc = getLevelCount(instance); l < lc; l++) {
+                auto const& primitives = getRenderPrimitives(instance, uint8_t(l));
+                for (size_t i = 0, c = primitives.size(); i < c; i++) {
+                    FMaterialInstance const* const mi = primitives[i].getMaterialInstance();
+                    if (UTILS_UNLIKELY(mi &&
+                            mi->getMaterial()->getVertexDomain() != VertexDomain::OBJECT)) {
+                        slog.w << "[instance=" << instance.asValue() << ", primitive @ " << i
+                               << "] quantized positions require a material in the object "
+                                  "vertex domain" << io::endl;
+                        return;
+                    }
+                }
+            }
+        }
+        mManager[instance].quantization = bounds;
+        Visibility& visibility = mManager[instance].visibility;
+        visibility.quantizedPositions = !bounds.isEmpty();
+    }
+}
+
 MaterialInstance* FRenderableManager::getMaterialInstanceAt(
         Instance instance, uint8_t level, size_t primitiveIndex) const noexcept {
     if (instance) {
@@ -563,7 +632,7 @@ void FRenderableManager::setSkinningBuffer(FRenderableManager::Instance ci,
             "Enable skinning buffer mode to use this API");
 
     ASSERT_PRECONDITION(
-            count + offset < skinningBuffer->getBoneCount(),
+            count + offset <= skinningBuffer->getBoneCount(),
             "SkinningBuffer overflow (size=%u, count=%u, offset=%u)",
             skinningBuffer->getBoneCount(), count, offset);
 
@@ -578,7 +647,8 @@ void FRenderableManager::setSkinningBuffer(FRenderableManager::Instance ci,
     // should always contain enough date for this to work.
 
     count = FSkinningBuffer::getPhysicalBoneCount(count);
-    assert_invariant(count + offset < skinningBuffer->getBoneCount());
+    assert_invariant(count + offset <=
+            FSkinningBuffer::getPhysicalBoneCount(skinningBuffer->getBoneCount()));
 
     bones.handle = skinningBuffer->getHwHandle();
     bones.count = uint16_t(count);
@@ -593,6 +663,7 @@ static void updateMorphWeights(FEngine& engine, backend::Handle<backend::HwBuffe
     memset(out, 0, size);
     std::transform(weights, weights + count, out->weights,
             [](float value) { return float4(value); });
+    engine.getFrameStatistics().uploadedBytes += size;
     driver.updateBufferObject(handle, { out, size }, 0);
 }
 
@@ -685,6 +756,10 @@ void RenderableManager::setScreenSpaceContactShadows(Instance instance, bool ena
     upcast(this)->setScreenSpaceContactShadows(instance, enable);
 }
 
+void RenderableManager::setQuantizedPositions(Instance instance, const Box& bounds) noexcept {
+    upcast(this)->setQuantizedPositions(instance, bounds);
+}
+
 bool RenderableManager::isShadowCaster(Instance instance) const noexcept {
     return upcast(this)->isShadowCaster(instance);
 }
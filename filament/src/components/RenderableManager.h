@@ -60,6 +60,7 @@ public:
         bool morphing                   : 1;
         bool screenSpaceContactShadows  : 1;
         bool reversedWindingOrder       : 1;
+        bool quantizedPositions         : 1;
     };
 
     static_assert(sizeof(Visibility) == sizeof(uint16_t), "Visibility should be 16 bits");
@@ -86,9 +87,7 @@ public:
 
     void destroy(utils::Entity e) noexcept;
 
-    void gc(utils::EntityManager& em) noexcept {
-        mManager.gc(em);
-    }
+    void gc(utils::EntityManager& em) noexcept;
 
     inline void setAxisAlignedBoundingBox(Instance instance, const Box& aabb) noexcept;
 
@@ -102,6 +101,9 @@ public:
     inline void setLayerMask(Instance instance, uint8_t layerMask) noexcept;
     inline void setReceiveShadows(Instance instance, bool enable) noexcept;
     inline void setScreenSpaceContactShadows(Instance instance, bool enable) noexcept;
+    // Logs a warning and leaves the renderable unchanged if the renderable is skinned or morphed,
+    // or if one of its materials isn't in the object vertex domain.
+    void setQuantizedPositions(Instance instance, const Box& bounds) noexcept;
     inline void setCulling(Instance instance, bool enable) noexcept;
     inline void setSkinning(Instance instance, bool enable) noexcept;
     inline void setMorphing(Instance instance, bool enable) noexcept;
@@ -123,6 +125,7 @@ public:
 
 
     inline Box const& getAABB(Instance instance) const noexcept;
+    inline Box const& getQuantizedPositions(Instance instance) const noexcept;
     inline Box const& getAxisAlignedBoundingBox(Instance instance) const noexcept { return getAABB(instance); }
     inline Visibility getVisibility(Instance instance) const noexcept;
     inline uint8_t getLayerMask(Instance instance) const noexcept;
@@ -190,6 +193,7 @@ private:
         VISIBILITY,         // user data
         PRIMITIVES,         // user data
         BONES,              // filament data, UBO storing a pointer to the bones information
+        QUANTIZATION,       // user data
     };
 
     using Base = utils::SingleInstanceComponentManager<
@@ -199,7 +203,8 @@ private:
             uint8_t,                         // CHANNELS
             Visibility,                      // VISIBILITY
             utils::Slice<FRenderPrimitive>,  // PRIMITIVES
-            Bones                            // BONES
+            Bones,                           // BONES
+            Box                              // QUANTIZATION
     >;
 
     struct Sim : public Base {
@@ -221,6 +226,7 @@ private:
                 Field<VISIBILITY>   visibility;
                 Field<PRIMITIVES>   primitives;
                 Field<BONES>        bones;
+                Field<QUANTIZATION> quantization;
             };
         };
 
@@ -347,6 +353,10 @@ Box const& FRenderableManager::getAABB(Instance instance) const noexcept {
     return mManager[instance].aabb;
 }
 
+Box const& FRenderableManager::getQuantizedPositions(Instance instance) const noexcept {
+    return mManager[instance].quantization;
+}
+
 FRenderableManager::SkinningBindingInfo
 FRenderableManager::getSkinningBufferInfo(Instance instance) const noexcept {
     Bones const& bones = mManager[instance].bones;
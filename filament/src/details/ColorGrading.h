@@ -19,6 +19,8 @@
 
 #include "upcast.h"
 
+#include "ColorGradingLutCache.h"
+
 #include <backend/DriverEnums.h>
 #include <backend/Handle.h>
 
@@ -26,6 +28,8 @@
 
 #include <math/mathfwd.h>
 
+#include <utils/JobSystem.h>
+
 namespace filament {
 
 class FEngine;
@@ -45,7 +49,18 @@ public:
 
     uint32_t getDimension() const noexcept { return mDimension; }
 
+    // Generates the LUT of the given configuration, reusing the stage outputs retained by the
+    // cache. Returns a buffer allocated with malloc() and its size in bytes.
+    static void* generateLut(utils::JobSystem& js, ColorGradingLutCache& cache,
+            const Builder& builder, size_t* size) noexcept;
+
 private:
+    static ColorGradingLutCache::Key makeLutKey(const Builder& builder) noexcept;
+
+    static void* generateLut(utils::JobSystem& js, ColorGradingLutCache& cache,
+            const Builder& builder, ColorGradingLutCache::Key const& key, size_t* size) noexcept;
+
+    ColorGradingLutCache::Key mLutKey;
     backend::TextureHandle mLutHandle;
     uint32_t mDimension;
 };
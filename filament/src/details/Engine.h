@@ -20,6 +20,8 @@
 #include "upcast.h"
 
 #include "Allocators.h"
+#include "ColorGradingLutCache.h"
+#include "FrameStatistics.h"
 #include "PostProcessManager.h"
 #include "ResourceList.h"
 
@@ -38,6 +40,7 @@
 #include "details/SkinningBuffer.h"
 #include "details/MorphTargetBuffer.h"
 #include "details/Skybox.h"
+#include "details/TextureStreamer.h"
 
 #include "private/backend/CommandBufferQueue.h"
 #include "private/backend/CommandStream.h"
@@ -74,6 +77,7 @@ using MaterialKey = uint32_t;
 #include <utils/JobSystem.h>
 #include <utils/CountDownLatch.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <random>
@@ -125,6 +129,7 @@ public:
     static constexpr size_t CONFIG_FROXEL_SLICE_COUNT      = 16;
     static constexpr bool   CONFIG_IBL_USE_IRRADIANCE_MAP  = false;
 
+    // defaults of the corresponding Engine::Config fields
     static constexpr size_t CONFIG_PER_RENDER_PASS_ARENA_SIZE   = filament::CONFIG_PER_RENDER_PASS_ARENA_SIZE;
     static constexpr size_t CONFIG_PER_FRAME_COMMANDS_SIZE      = filament::CONFIG_PER_FRAME_COMMANDS_SIZE;
     static constexpr size_t CONFIG_MIN_COMMAND_BUFFERS_SIZE     = filament::CONFIG_MIN_COMMAND_BUFFERS_SIZE;
@@ -132,12 +137,14 @@ public:
 
 public:
     static FEngine* create(Backend backend = Backend::DEFAULT,
-            Platform* platform = nullptr, void* sharedGLContext = nullptr);
+            Platform* platform = nullptr, void* sharedGLContext = nullptr,
+            const Config* config = nullptr);
 
 #if UTILS_HAS_THREADING
     static void createAsync(CreateCallback callback, void* user,
             Backend backend = Backend::DEFAULT,
-            Platform* platform = nullptr, void* sharedGLContext = nullptr);
+            Platform* platform = nullptr, void* sharedGLContext = nullptr,
+            const Config* config = nullptr);
 
     static FEngine* getEngine(void* token);
 #endif
@@ -155,6 +162,19 @@ public:
     // we'll simply have to use separate Areas (for instance).
     LinearAllocatorArena& getPerRenderPassAllocator() noexcept { return mPerRenderPassAllocator; }
 
+    Config const& getConfig() const noexcept { return mConfig; }
+
+    // size of the high-level draw commands buffer, allocated from the per render pass arena
+    size_t getPerFrameCommandsSize() const noexcept {
+        return size_t(mConfig.perFrameCommandsSizeMB) * 1024 * 1024;
+    }
+
+    void recordPerFrameCommandsHighWatermark(size_t watermark) noexcept {
+        mPerFrameCommandsHighWatermark = std::max(mPerFrameCommandsHighWatermark, watermark);
+    }
+
+    MemoryStatistics getMemoryStatistics() const noexcept;
+
     // Material IDs...
     uint32_t getMaterialId() const noexcept { return mMaterialId++; }
 
@@ -184,6 +204,14 @@ public:
         return mPostProcessManager;
     }
 
+    ColorGradingLutCache& getColorGradingLutCache() noexcept {
+        return mColorGradingLutCache;
+    }
+
+    FrameStatistics& getFrameStatistics() noexcept {
+        return mFrameStatistics;
+    }
+
     FRenderableManager& getRenderableManager() noexcept {
         return mRenderableManager;
     }
@@ -200,6 +228,10 @@ public:
         return mTransformManager;
     }
 
+    FTextureStreamer& getTextureStreamer() noexcept {
+        return mTextureStreamer;
+    }
+
     utils::EntityManager& getEntityManager() noexcept {
         return mEntityManager;
     }
@@ -239,6 +271,8 @@ public:
     FIndirectLight* createIndirectLight(const IndirectLight::Builder& builder) noexcept;
     FMaterial* createMaterial(const Material::Builder& builder) noexcept;
     FTexture* createTexture(const Texture::Builder& builder) noexcept;
+    FTexture* createStreamedTexture(const Texture::Builder& builder,
+            uint32_t streamingId, uint8_t baseLevel) noexcept;
     FSkybox* createSkybox(const Skybox::Builder& builder) noexcept;
     FColorGrading* createColorGrading(const ColorGrading::Builder& builder) noexcept;
     FStream* createStream(const Stream::Builder& builder) noexcept;
@@ -310,6 +344,11 @@ public:
     void prepare();
     void gc();
 
+    // Called by FRenderableManager when a renderable instance is removed, `last` is the instance
+    // moved in its place. This lets the views release their per-renderable state.
+    void onRenderableRemoved(FRenderableManager::Instance instance,
+            FRenderableManager::Instance last) noexcept;
+
     filaflat::ShaderBuilder& getVertexShaderBuilder() const noexcept {
         return mVertexShaderBuilder;
     }
@@ -342,7 +381,7 @@ public:
     backend::Handle<backend::HwSamplerGroup> getDummyMorphingSamplerGroup() const { return mDummyMorphingSamplerGroup; }
 
 private:
-    FEngine(Backend backend, Platform* platform, void* sharedGLContext);
+    FEngine(Backend backend, Platform* platform, void* sharedGLContext, Config const& config);
     void init();
     void shutdown();
 
@@ -361,18 +400,22 @@ private:
     Platform* mPlatform = nullptr;
     bool mOwnPlatform = false;
     void* mSharedGLContext = nullptr;
+    const Config mConfig;
     bool mTerminated = false;
     backend::Handle<backend::HwRenderPrimitive> mFullScreenTriangleRph;
     FVertexBuffer* mFullScreenTriangleVb = nullptr;
     FIndexBuffer* mFullScreenTriangleIb = nullptr;
 
     PostProcessManager mPostProcessManager;
+    ColorGradingLutCache mColorGradingLutCache;
+    FrameStatistics mFrameStatistics;
 
     utils::EntityManager& mEntityManager;
     FRenderableManager mRenderableManager;
     FTransformManager mTransformManager;
     FLightManager mLightManager;
     FCameraManager mCameraManager;
+    FTextureStreamer mTextureStreamer;
     ResourceAllocator* mResourceAllocator = nullptr;
 
     ResourceList<FBufferObject> mBufferObjects{ "BufferObject" };
@@ -408,9 +451,15 @@ private:
     LinearAllocatorArena mPerRenderPassAllocator;
     HeapAllocatorArena mHeapAllocator;
 
+    size_t mPerFrameCommandsHighWatermark = 0;
+
     utils::JobSystem mJobSystem;
     static uint32_t getJobSystemThreadPoolSize() noexcept;
 
+    // replaces the fields left to 0 by their defaults and checks the sizes are consistent,
+    // this panics if they aren't
+    static Config validateConfig(const Config* config);
+
     std::default_random_engine mRandomEngine;
 
     Epoch mEngineEpoch;
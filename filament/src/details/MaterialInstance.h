@@ -31,9 +31,12 @@
 
 #include <filament/MaterialInstance.h>
 
+#include <vector>
+
 namespace filament {
 
 class FMaterial;
+class FTextureStreamer;
 
 class FMaterialInstance : public MaterialInstance {
 public:
@@ -69,6 +72,19 @@ public:
     UniformBuffer const& getUniformBuffer() const noexcept { return mUniforms; }
     backend::SamplerGroup const& getSamplerGroup() const noexcept { return mSamplers; }
 
+    // samplers set to a streamed texture, whose handle changes as its mip levels are streamed
+    struct StreamedSampler {
+        uint32_t streamingId;
+        uint32_t index;
+    };
+
+    std::vector<StreamedSampler> const& getStreamedSamplers() const noexcept {
+        return mStreamedSamplers;
+    }
+
+    // updates the samplers whose streamed texture changed handle
+    void updateStreamedSamplers(FTextureStreamer const& streamer) noexcept;
+
     void setScissor(int32_t left, int32_t bottom, uint32_t width, uint32_t height) noexcept {
         mScissorRect = { left, bottom,
                 std::min(width, (uint32_t)std::numeric_limits<int32_t>::max()),
@@ -158,6 +174,7 @@ private:
 
     UniformBuffer mUniforms;
     backend::SamplerGroup mSamplers;
+    std::vector<StreamedSampler> mStreamedSamplers;
     backend::PolygonOffset mPolygonOffset;
     backend::CullingMode mCulling;
     bool mColorWrite;
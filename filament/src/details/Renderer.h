@@ -20,8 +20,11 @@
 #include "upcast.h"
 
 #include "Allocators.h"
+#include "CpuStageTimings.h"
+#include "Culler.h"
 #include "FrameInfo.h"
 #include "FrameSkipper.h"
+#include "FrameTimingsRecorder.h"
 #include "PostProcessManager.h"
 #include "RenderPass.h"
 
@@ -47,6 +50,8 @@
 
 #include <tsl/robin_set.h>
 
+#include <vector>
+
 namespace filament {
 
 namespace backend {
@@ -79,10 +84,15 @@ public:
     // do all the work here!
     void renderJob(ArenaScope& arena, FView& view);
 
+    // CPU time spent in each stage of the current (or last) frame, summed over all views
+    CpuStageTimings const& getCpuStageTimings() const noexcept { return mCpuStageTimings; }
+
     bool beginFrame(FSwapChain* swapChain, uint64_t vsyncSteadyClockTimeNano);
 
     void render(FView const* view);
 
+    void renderViews(FView const* const* views, size_t count);
+
     void readPixels(uint32_t xoffset, uint32_t yoffset, uint32_t width, uint32_t height,
             backend::PixelBufferDescriptor&& buffer);
 
@@ -128,6 +138,16 @@ public:
         mClearOptions = options;
     }
 
+    void setLatencyOptions(LatencyOptions const& options) noexcept;
+
+    LatencyOptions const& getLatencyOptions() const noexcept { return mLatencyOptions; }
+
+    void setFrameTimingOptions(FrameTimingOptions const& options) noexcept;
+
+    size_t getFrameTimings(FrameTimings* out, size_t count) const noexcept {
+        return mFrameTimingsRecorder.getFrameTimings(out, count);
+    }
+
 private:
     friend class Renderer;
     using Command = RenderPass::Command;
@@ -142,6 +162,15 @@ private:
 
     void renderInternal(FView const* view);
 
+    // blocks until mFrameSkipper lets the next frame start
+    void waitForGpu(FEngine& engine);
+
+    // reports the frames the GPU finished to the frame timings
+    void pollCompletedFrames(backend::DriverApi& driver);
+
+    // culls the renderables of several views concurrently, ahead of their prepare()
+    void cullViews(FView const* const* views, size_t count);
+
     struct ColorPassConfig {
         Viewport vp;
         Viewport svp;
@@ -166,12 +195,11 @@ private:
             PostProcessManager::ColorGradingConfig colorGradingConfig,
             RenderPass const& pass, FView const& view) const noexcept;
 
-    void recordHighWatermark(size_t watermark) noexcept {
-        mCommandsHighWatermark = std::max(mCommandsHighWatermark, watermark);
-    }
+    // watermark in bytes, also reported to the engine for Engine::getMemoryStatistics()
+    void recordHighWatermark(size_t watermark) noexcept;
 
     size_t getCommandsHighWatermark() const noexcept {
-        return mCommandsHighWatermark * sizeof(RenderPass::Command);
+        return mCommandsHighWatermark;
     }
 
     backend::TextureFormat getHdrFormat(const View& view, bool translucent) const noexcept;
@@ -198,11 +226,17 @@ private:
     // keep a reference to our engine
     FEngine& mEngine;
     FrameSkipper mFrameSkipper;
+    LatencyOptions mLatencyOptions;
     backend::Handle<backend::HwRenderTarget> mRenderTarget;
     FSwapChain* mSwapChain = nullptr;
     size_t mCommandsHighWatermark = 0;
     uint32_t mFrameId = 0;
     FrameInfoManager mFrameInfoManager;
+    CpuStageTimings mCpuStageTimings;
+
+    // renderable culling results of all the views given to renderViews()
+    std::vector<Culler::result_type> mViewsVisibility;
+    FrameTimingsRecorder mFrameTimingsRecorder;
     backend::TextureFormat mHdrTranslucent{};
     backend::TextureFormat mHdrQualityMedium{};
     backend::TextureFormat mHdrQualityHigh{};
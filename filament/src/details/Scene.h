@@ -47,6 +47,7 @@ class FEngine;
 class FIndirectLight;
 class FRenderer;
 class FSkybox;
+class PerRenderableUniforms;
 
 
 class FScene : public Scene {
@@ -90,9 +91,6 @@ public:
             backend::Handle<backend::HwBufferObject> lightUbh) noexcept;
 
 
-    filament::backend::Handle<backend::HwBufferObject> getRenderableUBO() const noexcept {
-        return mRenderableViewUbh;
-    }
 
     /*
      * Storage for per-frame renderable data
@@ -189,7 +187,14 @@ public:
     LightSoa const& getLightData() const noexcept { return mLightData; }
     LightSoa& getLightData() noexcept { return mLightData; }
 
-    void updateUBOs(utils::Range<uint32_t> visibleRenderables, backend::Handle<backend::HwBufferObject> renderableUbh) noexcept;
+    // Identifies the renderables gathered by prepare(), i.e. their order and world AABBs. It
+    // changes when entities are added or removed, or when prepare() is called with different
+    // parameters. Changes to the components themselves are not tracked, so it's only meaningful
+    // while no client code runs, e.g. within FRenderer::renderViews().
+    uint32_t getGeneration() const noexcept { return mGeneration; }
+
+    void updateUBOs(utils::Range<uint32_t> visibleRenderables,
+            PerRenderableUniforms& renderableUniforms) noexcept;
 
     bool hasContactShadows() const noexcept;
 
@@ -208,6 +213,10 @@ private:
      */
     tsl::robin_set<utils::Entity> mEntities;
 
+    // see getGeneration()
+    uint32_t mGeneration = 0;
+    math::mat4 mPreparedWorldOrigin;
+    bool mPreparedShadowReceiversAreCasters = false;
 
     /*
      * The data below is valid only during a view pass. i.e. if a scene is used in multiple
@@ -217,7 +226,6 @@ private:
      */
     RenderableSoa mRenderableData;
     LightSoa mLightData;
-    backend::Handle<backend::HwBufferObject> mRenderableViewUbh; // This is actually owned by the view.
     bool mHasContactShadows = false;
 };
 
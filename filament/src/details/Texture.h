@@ -34,6 +34,9 @@ class FTexture : public Texture {
 public:
     FTexture(FEngine& engine, const Builder& builder);
 
+    // creates a streamed texture, whose handle only holds the levels [baseLevel, levelCount)
+    FTexture(FEngine& engine, const Builder& builder, uint32_t streamingId, uint8_t baseLevel);
+
     // frees driver resources, object becomes invalid
     void terminate(FEngine& engine);
 
@@ -79,6 +82,9 @@ public:
 
     FStream const* getStream() const noexcept { return mStream; }
 
+    // non-zero for textures created by the TextureStreamer
+    uint32_t getStreamingId() const noexcept { return mStreamingId; }
+
     /*
      * Utilities
      */
@@ -116,8 +122,10 @@ public:
 
 private:
     friend class Texture;
+    friend class FTextureStreamer;
     FStream* mStream = nullptr;
     backend::Handle<backend::HwTexture> mHandle;
+    uint32_t mStreamingId = 0;
     uint32_t mWidth = 1;
     uint32_t mHeight = 1;
     uint32_t mDepth = 1;
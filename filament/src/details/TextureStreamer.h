@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
+#define TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
+
+#include "upcast.h"
+
+#include "private/backend/DriverApiForward.h"
+
+#include <filament/TextureStreamer.h>
+#include <filament/Viewport.h>
+
+#include <backend/DriverEnums.h>
+#include <backend/Handle.h>
+#include <backend/PixelBufferDescriptor.h>
+
+#include <math/vec3.h>
+
+#include <utils/compiler.h>
+#include <utils/Condition.h>
+#include <utils/Mutex.h>
+#include <utils/Range.h>
+#include <utils/Slice.h>
+
+#include <tsl/robin_map.h>
+
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace filament {
+
+struct CameraInfo;
+class FEngine;
+class FRenderPrimitive;
+class FTexture;
+
+class FTextureStreamer : public TextureStreamer {
+public:
+    explicit FTextureStreamer(FEngine& engine) noexcept;
+    ~FTextureStreamer() noexcept;
+
+    // stops the loading thread and frees all streaming resources, the textures stay valid
+    void terminate(FEngine& engine);
+
+    /*
+     * User Public API
+     */
+
+    void setConfig(Config const& config) noexcept { mConfig = config; }
+    Config const& getConfig() const noexcept { return mConfig; }
+
+    FTexture* createTexture(Source* source);
+
+    size_t getResidentLevel(FTexture const* texture) const noexcept;
+
+    size_t getResidentSize() const noexcept { return mResidentSize; }
+
+    size_t getPendingCount() const noexcept { return mPendingCount; }
+
+public:
+    /*
+     * Filaments-scope Public API
+     */
+
+    bool empty() const noexcept { return mEntries.empty(); }
+
+    // Accumulates the screen footprint of the streamed textures used by the visible renderables
+    // of a view. Called once per view, after the primitives' level of detail is picked.
+    void prepareView(math::float3 const* UTILS_RESTRICT centers,
+            math::float3 const* UTILS_RESTRICT extents,
+            utils::Slice<FRenderPrimitive> const* UTILS_RESTRICT primitives,
+            utils::Range<uint32_t> visible,
+            CameraInfo const& camera, Viewport const& viewport) noexcept;
+
+    // Called once per frame by FRenderer::beginFrame(), before FEngine::prepare(). Uploads the
+    // levels loaded since the last frame, and picks the resident levels for the coming frames
+    // from the footprints accumulated since the last call.
+    void update(backend::DriverApi& driver);
+
+    // Returns true if the handle of any texture changed since the last call, in which case the
+    // material instances must follow the new handles.
+    bool takeHandleChanges() noexcept {
+        const bool changed = mHandlesChanged;
+        mHandlesChanged = false;
+        return changed;
+    }
+
+    // Returns the current handle of a streamed texture, or a null handle if it was destroyed
+    backend::Handle<backend::HwTexture> getHandle(uint32_t streamingId) const noexcept;
+
+    // Called when a streamed texture is destroyed
+    void destroy(backend::DriverApi& driver, uint32_t streamingId) noexcept;
+
+    /*
+     * Residency policy, these don't depend on the engine
+     */
+
+    struct Candidate {
+        uint32_t width;             // width of level 0
+        uint32_t height;            // height of level 0
+        backend::TextureFormat format;
+        uint8_t levelCount;
+        uint8_t tailLevel;          // first always resident level
+        uint8_t level;              // most detailed level wanted, updated by fitToBudget()
+        float footprint;            // size on screen in pixels, 0 if not visible
+        uint32_t age;               // frames since the texture was last visible
+    };
+
+    // GPU memory used by the levels [baseLevel, levelCount) of a texture
+    static size_t computeSize(backend::TextureFormat format, uint32_t width, uint32_t height,
+            uint8_t baseLevel, uint8_t levelCount) noexcept;
+
+    // Most detailed level needed for a texture of the given size covering `footprint` pixels
+    static uint8_t computeLevel(uint32_t size, float footprint, float lodBias,
+            uint8_t tailLevel) noexcept;
+
+    // Drops levels of the candidates until they fit in the budget: levels of the textures not
+    // seen for the longest time go first, then those of the most oversampled textures.
+    // Returns the GPU memory used by the candidates' levels.
+    static size_t fitToBudget(Candidate* candidates, size_t count, size_t budget) noexcept;
+
+private:
+    struct Entry {
+        FTexture* texture = nullptr;
+        Source* source = nullptr;
+        uint32_t width = 1;
+        uint32_t height = 1;
+        backend::TextureFormat format = backend::TextureFormat::RGBA8;
+        uint8_t levelCount = 1;
+        uint8_t tailLevel = 0;
+        uint8_t minLevel = 0;           // most detailed level the source could load
+        uint8_t residentLevel = 0;      // base level of the texture's handle
+        float footprint = 0.0f;         // accumulated over the views of the current frame
+        uint32_t lastSeen = 0;
+
+        // levels being loaded into a new handle, which replaces the current one when complete
+        backend::Handle<backend::HwTexture> pending;
+        uint8_t pendingLevel = 0;
+        uint8_t pendingRemaining = 0;
+        uint32_t generation = 0;
+    };
+
+    struct Request {
+        uint32_t id;
+        uint32_t generation;
+        uint8_t level;
+        Source* source;                 // destroyed by the loader when id is 0
+    };
+
+    struct Result {
+        uint32_t id;
+        uint32_t generation;
+        uint8_t level;
+        bool success;
+        Texture::PixelBufferDescriptor buffer;
+    };
+
+    void loop();
+    void startLoading(backend::DriverApi& driver, Entry& entry, uint32_t id, uint8_t level);
+    void cancelLoading(backend::DriverApi& driver, Entry& entry, uint32_t id) noexcept;
+    bool upload(backend::DriverApi& driver, Entry const& entry,
+            backend::Handle<backend::HwTexture> handle, uint8_t baseLevel, uint8_t level,
+            Texture::PixelBufferDescriptor&& buffer) const;
+
+    FEngine& mEngine;
+    Config mConfig;
+    tsl::robin_map<uint32_t, Entry> mEntries;
+    std::vector<backend::Handle<backend::HwTexture>> mRetired;
+    std::vector<Result> mLoaded;
+    std::vector<Candidate> mCandidates;
+    std::vector<uint32_t> mIds;
+    std::vector<uint32_t> mOrder;
+    uint32_t mNextId = 0;
+    uint32_t mFrameId = 0;
+    size_t mResidentSize = 0;
+    size_t mPendingCount = 0;
+    bool mHandlesChanged = false;
+
+    // loading thread
+    utils::Mutex mLock;
+    utils::Condition mCondition;
+    std::deque<Request> mRequests;
+    std::vector<Result> mResults;
+    std::thread mLoader;
+    bool mExitRequested = false;
+};
+
+FILAMENT_UPCAST(TextureStreamer)
+
+} // namespace filament
+
+#endif // TNT_FILAMENT_DETAILS_TEXTURESTREAMER_H
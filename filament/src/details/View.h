@@ -24,9 +24,11 @@
 #include "upcast.h"
 
 #include "Allocators.h"
+#include "CpuStageTimings.h"
 #include "FrameHistory.h"
 #include "FrameInfo.h"
 #include "Froxelizer.h"
+#include "PerRenderableUniforms.h"
 #include "PerViewUniforms.h"
 #include "PIDController.h"
 #include "ShadowMap.h"
@@ -119,7 +121,22 @@ public:
     void terminate(FEngine& engine);
 
     void prepare(FEngine& engine, backend::DriverApi& driver, ArenaScope& arena,
-            Viewport const& viewport, math::float4 const& userTime) noexcept;
+            Viewport const& viewport, math::float4 const& userTime,
+            CpuStageTimings& timings) noexcept;
+
+    // Returns the transform applied to the scene by prepare() this frame.
+    math::mat4 getWorldOriginScene(FEngine const& engine) const noexcept;
+
+    // Returns this frame's culling frustum, for a scene prepared with worldOriginScene.
+    Frustum computeCullingFrustum(math::mat4 const& worldOriginScene) const noexcept;
+
+    // Provides the renderable culling result for the next prepare(), computed ahead of time by
+    // FRenderer::renderViews(). It's indexed like the scene's renderable data right after
+    // FScene::prepare(), and only used if the scene's generation still is sceneGeneration.
+    // scenePrepared means that the scene was prepared for this view and not used since, so
+    // prepare() doesn't need to prepare it again. The storage must outlive prepare().
+    void setPrecomputedVisibility(Culler::result_type const* visibility,
+            uint32_t sceneGeneration, bool scenePrepared) noexcept;
 
     void setScene(FScene* scene) { mScene = scene; }
     FScene const* getScene() const noexcept { return mScene; }
@@ -316,6 +333,14 @@ public:
 
     void setDynamicLightingOptions(float zLightNear, float zLightFar) noexcept;
 
+    void setFroxelDensity(float density) noexcept {
+        mFroxelizer.setDensity(math::clamp(density, 1.0f / 16.0f, 1.0f));
+    }
+
+    float getFroxelDensity() const noexcept {
+        return mFroxelizer.getDensity();
+    }
+
     void setPostProcessingEnabled(bool enabled) noexcept {
         mHasPostProcessPass = enabled;
     }
@@ -440,6 +465,20 @@ public:
         return mVisibleRenderables;
     }
 
+    PerRenderableUniforms const& getPerRenderableUniforms() const noexcept {
+        return mPerRenderableUniforms;
+    }
+
+    PerRenderableUniforms& getPerRenderableUniforms() noexcept {
+        return mPerRenderableUniforms;
+    }
+
+    // called when a renderable instance is removed, `last` is the instance moved in its place
+    void onRenderableRemoved(FRenderableManager::Instance instance,
+            FRenderableManager::Instance last) noexcept {
+        mPerRenderableUniforms.onInstanceRemoved(instance, last);
+    }
+
     Range const& getVisibleDirectionalShadowCasters() const noexcept {
         return mVisibleDirectionalShadowCasters;
     }
@@ -470,6 +509,8 @@ public:
 
     auto& getShadowUniforms() const { return mShadowUb; }
 
+    ShadowMapManager const& getShadowMapManager() const noexcept { return mShadowMapManager; }
+
     // Returns the frame history FIFO. This is typically used by the FrameGraph to access
     // previous frame data.
     FrameHistory& getFrameHistory() noexcept { return mFrameHistory; }
@@ -557,7 +598,6 @@ private:
     // these are accessed in the render loop, keep together
     backend::Handle<backend::HwBufferObject> mLightUbh;
     backend::Handle<backend::HwBufferObject> mShadowUbh;
-    backend::Handle<backend::HwBufferObject> mRenderableUbh;
 
     FScene* mScene = nullptr;
     FCamera* mCullingCamera = nullptr;
@@ -566,6 +606,10 @@ private:
     CameraInfo mViewingCameraInfo;
     Frustum mCullingFrustum{};
 
+    Culler::result_type const* mPrecomputedVisibility = nullptr;
+    uint32_t mPrecomputedSceneGeneration = 0;
+    bool mScenePrepared = false;
+
     mutable Froxelizer mFroxelizer;
 
     Viewport mViewport;
@@ -603,6 +647,7 @@ private:
     RenderQuality mRenderQuality;
 
     mutable PerViewUniforms mPerViewUniforms;
+    PerRenderableUniforms mPerRenderableUniforms;
     mutable TypedUniformBuffer<ShadowUib> mShadowUb;
 
     mutable FrameHistory mFrameHistory{};
@@ -615,7 +660,6 @@ private:
     Range mVisibleRenderables;
     Range mVisibleDirectionalShadowCasters;
     Range mSpotLightShadowCasters;
-    uint32_t mRenderableUBOSize = 0;
     mutable bool mHasDirectionalLight = false;
     mutable bool mHasDynamicLighting = false;
     mutable bool mHasShadowing = false;
@@ -177,7 +177,7 @@ FrameGraph& FrameGraph::compile() noexcept {
     return *this;
 }
 
-void FrameGraph::execute(backend::DriverApi& driver) noexcept {
+void FrameGraph::execute(backend::DriverApi& driver, PassObserver* observer) noexcept {
 
     SYSTRACE_CALL();
 
@@ -197,6 +197,10 @@ void FrameGraph::execute(backend::DriverApi& driver) noexcept {
 
         driver.pushGroupMarker(node->getName());
 
+        if (UTILS_UNLIKELY(observer)) {
+            observer->beginPass(driver, node->getName());
+        }
+
         // devirtualize resourcesList
         for (VirtualResource* resource : node->devirtualize) {
             assert_invariant(resource->first == node);
@@ -213,6 +217,10 @@ void FrameGraph::execute(backend::DriverApi& driver) noexcept {
             resource->destroy(resourceAllocator);
         }
 
+        if (UTILS_UNLIKELY(observer)) {
+            observer->endPass(driver);
+        }
+
         driver.popGroupMarker();
     }
     // this is a good place to kick the GPU, since we've just done a bunch of work
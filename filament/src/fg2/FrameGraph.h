@@ -271,12 +271,24 @@ public:
      */
     FrameGraph& compile() noexcept;
 
+    /**
+     * An observer notified before and after the execution of each pass, e.g. for profiling.
+     */
+    class PassObserver {
+    public:
+        virtual void beginPass(backend::DriverApi& driver, const char* name) noexcept = 0;
+        virtual void endPass(backend::DriverApi& driver) noexcept = 0;
+    protected:
+        ~PassObserver() = default;
+    };
+
     /**
      * Execute all referenced passes
      *
      * @param driver a reference to the backend to execute the commands
+     * @param observer an optional observer notified around the execution of each pass
      */
-    void execute(backend::DriverApi& driver) noexcept;
+    void execute(backend::DriverApi& driver, PassObserver* observer = nullptr) noexcept;
 
     /**
      * Forwards a resource to another one which gets replaced.
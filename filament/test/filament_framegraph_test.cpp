@@ -28,6 +28,9 @@
 
 #include "details/Texture.h"
 
+#include <string>
+#include <vector>
+
 using namespace filament;
 using namespace backend;
 
@@ -889,3 +892,45 @@ TEST_F(FrameGraphTest, SubResourcesWriteRead) {
 
     fg.execute(driverApi);
 }
+
+TEST_F(FrameGraphTest, PassObserver) {
+    class Observer : public FrameGraph::PassObserver {
+    public:
+        std::vector<std::string> names;
+        int depth = 0;
+        void beginPass(backend::DriverApi&, const char* name) noexcept override {
+            EXPECT_EQ(depth, 0);
+            depth++;
+            names.emplace_back(name);
+        }
+        void endPass(backend::DriverApi&) noexcept override {
+            EXPECT_EQ(depth, 1);
+            depth--;
+        }
+    } observer;
+
+    struct PassData {
+        FrameGraphId<FrameGraphTexture> output;
+    };
+    auto& pass0 = fg.addPass<PassData>("Pass0", [&](FrameGraph::Builder& builder, auto& data) {
+                data.output = builder.create<FrameGraphTexture>("Buffer0", {.width=16, .height=32});
+                data.output = builder.write(data.output, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+            },
+            [=](FrameGraphResources const&, auto const&, backend::DriverApi&) {});
+
+    // this pass is culled, the observer must not see it
+    fg.addPass<PassData>("Culled", [&](FrameGraph::Builder& builder, auto& data) {
+                data.output = builder.create<FrameGraphTexture>("Buffer1", {.width=16, .height=32});
+                data.output = builder.write(data.output, FrameGraphTexture::Usage::COLOR_ATTACHMENT);
+            },
+            [=](FrameGraphResources const&, auto const&, backend::DriverApi&) {});
+
+    fg.present(pass0->output);
+    fg.compile();
+    fg.execute(driverApi, &observer);
+
+    EXPECT_EQ(observer.depth, 0);
+    ASSERT_EQ(observer.names.size(), 2);
+    EXPECT_EQ(observer.names[0], "Pass0");
+    EXPECT_EQ(observer.names[1], "Present");
+}
@@ -31,6 +31,7 @@
 #include <filament/Frustum.h>
 #include <filament/Material.h>
 #include <filament/Engine.h>
+#include <filament/Renderer.h>
 
 #include <private/filament/UniformInterfaceBlock.h>
 #include <private/filament/UibStructs.h>
@@ -623,6 +624,70 @@ TEST(FilamentTest, ColorConversion) {
 }
 
 
+TEST(FilamentTest, EngineConfig) {
+    using namespace filament;
+
+    Engine::Config config;
+    config.perRenderPassArenaSizeMB = 5;
+    config.perFrameCommandsSizeMB = 3;
+    config.jobSystemThreadCount = 2;
+    Engine* engine = Engine::create(Engine::Backend::NOOP, nullptr, nullptr, &config);
+
+    // fields left to 0 are replaced by the defaults
+    Engine::Config const& actual = engine->getConfig();
+    EXPECT_EQ(5, actual.perRenderPassArenaSizeMB);
+    EXPECT_EQ(3, actual.perFrameCommandsSizeMB);
+    EXPECT_EQ(2, actual.jobSystemThreadCount);
+    EXPECT_EQ(FEngine::CONFIG_MIN_COMMAND_BUFFERS_SIZE, actual.minCommandBufferSizeMB * 1024 * 1024);
+    EXPECT_EQ(3 * actual.minCommandBufferSizeMB, actual.commandBufferSizeMB);
+    EXPECT_EQ(2, engine->getJobSystem().getThreadCount());
+
+    Engine::MemoryStatistics stats = engine->getMemoryStatistics();
+    EXPECT_EQ(5 * 1024 * 1024, stats.perRenderPassArenaSize);
+    EXPECT_EQ(3 * 1024 * 1024, stats.perFrameCommandsSize);
+    EXPECT_LE(stats.perRenderPassArenaHighWatermark, stats.perRenderPassArenaSize);
+    EXPECT_LE(stats.commandBufferHighWatermark, stats.commandBufferSize);
+
+    Engine::destroy(&engine);
+}
+
+TEST(FilamentTest, RendererLatencyModes) {
+    using namespace filament;
+
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    SwapChain* swapChain = engine->createSwapChain(64, 64);
+    Renderer* renderer = engine->createRenderer();
+    renderer->setFrameTimingOptions({ .enabled = true });
+
+    // THROUGHPUT clamps the number of frames in flight
+    renderer->setLatencyOptions({ Renderer::LatencyMode::THROUGHPUT, 8 });
+    EXPECT_EQ(Renderer::LatencyMode::THROUGHPUT, renderer->getLatencyOptions().mode);
+
+    for (auto mode : { Renderer::LatencyMode::LOW_LATENCY, Renderer::LatencyMode::THROUGHPUT,
+                       Renderer::LatencyMode::DEFAULT }) {
+        renderer->setLatencyOptions({ mode, 2 });
+        for (size_t i = 0; i < 6; i++) {
+            // the NOOP backend finishes frames immediately, so frames are never skipped
+            ASSERT_TRUE(renderer->beginFrame(swapChain));
+            renderer->endFrame();
+        }
+
+        // a frame's completion is seen by the next beginFrame()
+        Renderer::FrameTimings timings[Renderer::FRAME_TIMINGS_HISTORY_SIZE];
+        size_t const count = renderer->getFrameTimings(timings, 4);
+        ASSERT_EQ(4, count);
+        EXPECT_FALSE(timings[0].latencyValid);
+        for (size_t i = 1; i < count; i++) {
+            EXPECT_TRUE(timings[i].latencyValid);
+            EXPECT_EQ(timings[i - 1].frameId, timings[i].frameId + 1);
+        }
+    }
+
+    engine->destroy(renderer);
+    engine->destroy(swapChain);
+    Engine::destroy(&engine);
+}
+
 TEST(FilamentTest, FroxelData) {
     using namespace filament;
 
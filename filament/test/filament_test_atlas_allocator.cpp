@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "AtlasAllocator.h"
+
+using namespace filament;
+using namespace filament::math;
+
+TEST(AtlasAllocatorTest, WholeLayers) {
+    AtlasAllocator allocator(2);
+    AtlasAllocator::Allocation a;
+
+    EXPECT_TRUE(allocator.allocate(0, &a));
+    EXPECT_EQ(a.layer, 0);
+    EXPECT_EQ(a.position, ushort2(0, 0));
+
+    EXPECT_TRUE(allocator.allocate(0, &a));
+    EXPECT_EQ(a.layer, 1);
+    EXPECT_EQ(allocator.getLayerCount(), 2);
+
+    // all the layers are full
+    EXPECT_FALSE(allocator.allocate(0, &a));
+    EXPECT_FALSE(allocator.allocate(AtlasAllocator::MAX_LEVEL, &a));
+
+    allocator.clear();
+    EXPECT_EQ(allocator.getLayerCount(), 0);
+    EXPECT_TRUE(allocator.allocate(0, &a));
+    EXPECT_EQ(a.layer, 0);
+}
+
+TEST(AtlasAllocatorTest, Quadrants) {
+    AtlasAllocator allocator(1);
+    AtlasAllocator::Allocation a;
+
+    const ushort2 expected[] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+    for (ushort2 position : expected) {
+        EXPECT_TRUE(allocator.allocate(1, &a));
+        EXPECT_EQ(a.layer, 0);
+        EXPECT_EQ(a.level, 1);
+        EXPECT_EQ(a.position, position);
+    }
+    EXPECT_FALSE(allocator.allocate(1, &a));
+    EXPECT_FALSE(allocator.allocate(2, &a));
+}
+
+TEST(AtlasAllocatorTest, MixedSizes) {
+    AtlasAllocator allocator(2);
+    AtlasAllocator::Allocation a;
+
+    // a quadrant, then the 4 sixteenths of the next quadrant
+    EXPECT_TRUE(allocator.allocate(1, &a));
+    EXPECT_EQ(a.position, ushort2(0, 0));
+    const ushort2 expected[] = { { 2, 0 }, { 3, 0 }, { 2, 1 }, { 3, 1 } };
+    for (ushort2 position : expected) {
+        EXPECT_TRUE(allocator.allocate(2, &a));
+        EXPECT_EQ(a.layer, 0);
+        EXPECT_EQ(a.position, position);
+    }
+
+    // the two remaining quadrants
+    EXPECT_TRUE(allocator.allocate(1, &a));
+    EXPECT_EQ(a.position, ushort2(0, 1));
+    EXPECT_TRUE(allocator.allocate(1, &a));
+    EXPECT_EQ(a.position, ushort2(1, 1));
+    EXPECT_EQ(allocator.getLayerCount(), 1);
+
+    // the first layer is full, a whole layer goes in the second one
+    EXPECT_TRUE(allocator.allocate(0, &a));
+    EXPECT_EQ(a.layer, 1);
+    EXPECT_FALSE(allocator.allocate(AtlasAllocator::MAX_LEVEL, &a));
+}
+
+TEST(AtlasAllocatorTest, SmallTilesFillHoles) {
+    AtlasAllocator allocator(1);
+    AtlasAllocator::Allocation a;
+
+    // 3 quadrants, then a small tile goes in the 4th one
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_TRUE(allocator.allocate(1, &a));
+    }
+    EXPECT_TRUE(allocator.allocate(AtlasAllocator::MAX_LEVEL, &a));
+    const uint16_t n = 1u << (AtlasAllocator::MAX_LEVEL - 1);
+    EXPECT_EQ(a.position, ushort2(n, n));
+
+    // the 4th quadrant is partially used
+    EXPECT_FALSE(allocator.allocate(1, &a));
+    EXPECT_TRUE(allocator.allocate(2, &a));
+    EXPECT_EQ(a.position, ushort2(3, 2));
+}
+
+TEST(AtlasAllocatorTest, FreeTiles) {
+    AtlasAllocator allocator(2);
+    AtlasAllocator::Allocation quadrants[4];
+    for (auto& quadrant : quadrants) {
+        EXPECT_TRUE(allocator.allocate(1, &quadrant));
+    }
+    AtlasAllocator::Allocation a;
+    EXPECT_TRUE(allocator.allocate(0, &a));
+    EXPECT_EQ(a.layer, 1);
+    EXPECT_EQ(allocator.getLayerCount(), 2);
+
+    // a freed tile is allocated again, in full or in smaller tiles
+    allocator.free(quadrants[2]);
+    EXPECT_TRUE(allocator.allocate(1, &a));
+    EXPECT_EQ(a.layer, 0);
+    EXPECT_EQ(a.position, ushort2(0, 1));
+    allocator.free(a);
+    const ushort2 expected[] = { { 0, 2 }, { 1, 2 }, { 0, 3 }, { 1, 3 } };
+    AtlasAllocator::Allocation sixteenths[4];
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(allocator.allocate(2, &sixteenths[i]));
+        EXPECT_EQ(sixteenths[i].layer, 0);
+        EXPECT_EQ(sixteenths[i].position, expected[i]);
+    }
+    EXPECT_FALSE(allocator.allocate(2, &a));
+
+    // once its tiles are all freed, the quadrant can be allocated whole
+    for (auto const& sixteenth : sixteenths) {
+        EXPECT_FALSE(allocator.allocate(1, &a));
+        allocator.free(sixteenth);
+    }
+    EXPECT_TRUE(allocator.allocate(1, &a));
+    EXPECT_EQ(a.position, ushort2(0, 1));
+}
+
+TEST(AtlasAllocatorTest, FreeLayers) {
+    AtlasAllocator allocator(3);
+    AtlasAllocator::Allocation layers[3];
+    for (auto& layer : layers) {
+        EXPECT_TRUE(allocator.allocate(0, &layer));
+    }
+    EXPECT_EQ(allocator.getLayerCount(), 3);
+
+    // the layer count only drops when the last layers are empty
+    allocator.free(layers[1]);
+    EXPECT_EQ(allocator.getLayerCount(), 3);
+    allocator.free(layers[2]);
+    EXPECT_EQ(allocator.getLayerCount(), 1);
+
+    AtlasAllocator::Allocation a;
+    EXPECT_TRUE(allocator.allocate(AtlasAllocator::MAX_LEVEL, &a));
+    EXPECT_EQ(a.layer, 1);
+    EXPECT_EQ(allocator.getLayerCount(), 2);
+    allocator.free(a);
+    EXPECT_EQ(allocator.getLayerCount(), 1);
+    allocator.free(layers[0]);
+    EXPECT_EQ(allocator.getLayerCount(), 0);
+}
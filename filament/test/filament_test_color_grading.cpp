@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/ColorGrading.h>
+#include <filament/ToneMapper.h>
+
+#include <utils/JobSystem.h>
+
+#include "ColorGradingLutCache.h"
+#include "details/ColorGrading.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament;
+using namespace filament::math;
+
+class ColorGradingLutCacheTest : public testing::Test {
+protected:
+    void SetUp() override {
+        js.adopt();
+    }
+
+    void TearDown() override {
+        js.emancipate();
+    }
+
+    static void* generate(utils::JobSystem& js, ColorGradingLutCache& cache,
+            ColorGrading::Builder const& builder, size_t* size) {
+        return FColorGrading::generateLut(js, cache, builder, size);
+    }
+
+    utils::JobSystem js;
+};
+
+TEST_F(ColorGradingLutCacheTest, CachedStagesMatchFreshLut) {
+    ACESToneMapper aces;
+    FilmicToneMapper filmic;
+
+    ColorGrading::Builder first;
+    first.dimensions(16)
+            .toneMapper(&aces)
+            .saturation(1.2f)
+            .contrast(1.1f)
+            .whiteBalance(0.1f, -0.05f);
+
+    // Same input and grading, only the tone mapper differs: the second LUT is built from the
+    // graded stage output retained by the cache.
+    ColorGrading::Builder second;
+    second.dimensions(16)
+            .toneMapper(&filmic)
+            .saturation(1.2f)
+            .contrast(1.1f)
+            .whiteBalance(0.1f, -0.05f);
+
+    ColorGradingLutCache cache;
+    size_t firstSize = 0;
+    void* firstLut = generate(js, cache, first, &firstSize);
+
+    size_t cachedSize = 0;
+    void* cachedLut = generate(js, cache, second, &cachedSize);
+
+    ColorGradingLutCache freshCache;
+    size_t freshSize = 0;
+    void* freshLut = generate(js, freshCache, second, &freshSize);
+
+    ASSERT_EQ(cachedSize, freshSize);
+    EXPECT_EQ(0, memcmp(cachedLut, freshLut, freshSize));
+
+    // A different tone mapper must not be mistaken for the first configuration.
+    ASSERT_EQ(firstSize, freshSize);
+    EXPECT_NE(0, memcmp(firstLut, freshLut, freshSize));
+
+    free(firstLut);
+    free(cachedLut);
+    free(freshLut);
+}
+
+TEST_F(ColorGradingLutCacheTest, SwitchingBackToneMapperMatchesFreshLut) {
+    ACESToneMapper aces;
+    FilmicToneMapper filmic;
+
+    ColorGradingLutCache cache;
+    size_t size = 0;
+
+    ColorGrading::Builder a;
+    a.dimensions(16).toneMapper(&aces);
+    free(generate(js, cache, a, &size));
+
+    // Going back to the first configuration after another one must produce the same LUT.
+    ColorGrading::Builder b;
+    b.dimensions(16).toneMapper(&filmic);
+    free(generate(js, cache, b, &size));
+
+    void* again = generate(js, cache, a, &size);
+    ColorGradingLutCache freshCache;
+    void* fresh = generate(js, freshCache, a, &size);
+    EXPECT_EQ(0, memcmp(again, fresh, size));
+    free(again);
+    free(fresh);
+}
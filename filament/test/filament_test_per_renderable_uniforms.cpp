@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "PerRenderableUniforms.h"
+
+#include "details/Engine.h"
+#include "details/View.h"
+
+#include "generated/resources/materials.h"
+
+#include <filament/Box.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+
+#include <set>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+class PerRenderableUniformsTest : public testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+    }
+
+    void TearDown() override {
+        Engine::destroy(&engine);
+    }
+
+    Entity createRenderable() {
+        Entity e = EntityManager::get().create();
+        RenderableManager::Builder(1)
+                .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                .build(*engine, e);
+        return e;
+    }
+
+    // Fills the columns of the SoA used by PerRenderableUniforms, like FScene::prepare() does.
+    void fill(FScene::RenderableSoa& soa, std::vector<Entity> const& entities) {
+        FRenderableManager& rcm = upcast(engine)->getRenderableManager();
+        soa.clear();
+        soa.resize(entities.size());
+        uint32_t i = 0;
+        for (Entity e : entities) {
+            soa.elementAt<FScene::RENDERABLE_INSTANCE>(i) = rcm.getInstance(e);
+            soa.elementAt<FScene::WORLD_TRANSFORM>(i) = mat4f::translation(float3{ float(i) });
+            soa.elementAt<FScene::VISIBILITY_STATE>(i) = rcm.getVisibility(rcm.getInstance(e));
+            soa.elementAt<FScene::MORPHING_BUFFER>(i) = {};
+            soa.elementAt<FScene::CHANNELS>(i) = 1;
+            soa.elementAt<FScene::USER_DATA>(i) = 1.0f;
+            i++;
+        }
+    }
+
+    void update(PerRenderableUniforms& uniforms, FScene::RenderableSoa const& soa) {
+        FEngine& fengine = *upcast(engine);
+        uniforms.update(fengine, fengine.getJobSystem(), soa, { 0, uint32_t(soa.size()) });
+    }
+
+    Engine* engine = nullptr;
+};
+
+TEST_F(PerRenderableUniformsTest, RowsAreFreedWhenRenderablesAreDestroyed) {
+    View* view = engine->createView();
+    PerRenderableUniforms& uniforms = upcast(view)->getPerRenderableUniforms();
+
+    Entity a = createRenderable();
+    Entity b = createRenderable();
+    Entity c = createRenderable();
+
+    FScene::RenderableSoa soa;
+    fill(soa, { a, b, c });
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 3);
+
+    const uint32_t rowA = uniforms.getRows()[0];
+    const uint32_t rowB = uniforms.getRows()[1];
+    const uint32_t rowC = uniforms.getRows()[2];
+    EXPECT_EQ(std::set<uint32_t>({ rowA, rowB, rowC }).size(), 3);
+
+    // c is moved in the instance of a, it must keep its row
+    engine->getRenderableManager().destroy(a);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 2);
+
+    fill(soa, { b, c });
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 2);
+    EXPECT_EQ(uniforms.getRows()[0], rowB);
+    EXPECT_EQ(uniforms.getRows()[1], rowC);
+
+    // a new renderable reuses the freed row instead of growing the buffer
+    Entity d = createRenderable();
+    fill(soa, { b, c, d });
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 3);
+    EXPECT_EQ(uniforms.getRows()[2], rowA);
+
+    engine->getRenderableManager().destroy(b);
+    engine->getRenderableManager().destroy(c);
+    engine->getRenderableManager().destroy(d);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 0);
+
+    engine->destroy(view);
+    EntityManager::get().destroy(a);
+    EntityManager::get().destroy(b);
+    EntityManager::get().destroy(c);
+    EntityManager::get().destroy(d);
+}
+
+TEST_F(PerRenderableUniformsTest, BufferShrinksWhenRenderablesAreDestroyed) {
+    View* view = engine->createView();
+    PerRenderableUniforms& uniforms = upcast(view)->getPerRenderableUniforms();
+
+    std::vector<Entity> entities(64);
+    for (Entity& e : entities) {
+        e = createRenderable();
+    }
+
+    FScene::RenderableSoa soa;
+    fill(soa, entities);
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getUboCapacity(), 86);
+
+    // the last renderables are destroyed, their rows are at the end of the buffer
+    for (uint32_t i = 1; i < entities.size(); i++) {
+        engine->getRenderableManager().destroy(entities[i]);
+    }
+    fill(soa, { entities[0] });
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getUsedRowCount(), 1);
+    EXPECT_EQ(uniforms.getUboCapacity(), 16);
+    EXPECT_EQ(uniforms.getRows()[0], 0);
+
+    engine->getRenderableManager().destroy(entities[0]);
+    engine->destroy(view);
+    for (Entity e : entities) {
+        EntityManager::get().destroy(e);
+    }
+}
+
+TEST_F(PerRenderableUniformsTest, RowsArePerView) {
+    View* view0 = engine->createView();
+    View* view1 = engine->createView();
+    PerRenderableUniforms& uniforms0 = upcast(view0)->getPerRenderableUniforms();
+    PerRenderableUniforms& uniforms1 = upcast(view1)->getPerRenderableUniforms();
+
+    Entity a = createRenderable();
+    Entity b = createRenderable();
+
+    // the same scene seen by two views, each with its own visible set
+    FScene::RenderableSoa soa;
+    fill(soa, { a, b });
+    update(uniforms0, soa);
+    const uint32_t rowB0 = uniforms0.getRows()[1];
+
+    FScene::RenderableSoa soa1;
+    fill(soa1, { b });
+    update(uniforms1, soa1);
+
+    // updating the second view doesn't change the rows of the first one
+    EXPECT_EQ(uniforms0.getRows()[1], rowB0);
+    EXPECT_EQ(uniforms0.getUsedRowCount(), 2);
+    EXPECT_EQ(uniforms1.getUsedRowCount(), 1);
+    EXPECT_EQ(uniforms1.getRows()[0], 0);
+
+    engine->getRenderableManager().destroy(a);
+    engine->getRenderableManager().destroy(b);
+    EXPECT_EQ(uniforms0.getUsedRowCount(), 0);
+    EXPECT_EQ(uniforms1.getUsedRowCount(), 0);
+
+    engine->destroy(view0);
+    engine->destroy(view1);
+    EntityManager::get().destroy(a);
+    EntityManager::get().destroy(b);
+}
+
+TEST_F(PerRenderableUniformsTest, QuantizedPositionsAreFoldedInTheModelMatrix) {
+    View* view = engine->createView();
+    PerRenderableUniforms& uniforms = upcast(view)->getPerRenderableUniforms();
+    RenderableManager& rcm = engine->getRenderableManager();
+
+    // the z axis is flat, its scale is 1
+    const Box bounds{ float3{ 1, 2, 3 }, float3{ 2, 4, 0 }};
+    Entity e = EntityManager::get().create();
+    RenderableManager::Builder(1)
+            .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+            .quantizedPositions(bounds)
+            .build(*engine, e);
+
+    // fill() gives the renderable a world transform, which the dequantization is applied after
+    FScene::RenderableSoa soa;
+    fill(soa, { e });
+    update(uniforms, soa);
+    mat4f const& world = soa.elementAt<FScene::WORLD_TRANSFORM>(0);
+    PerRenderableUib const& row = uniforms.getRowData(uniforms.getRows()[0]);
+    EXPECT_EQ(row.worldFromModelMatrix,
+            world * mat4f::translation(bounds.center) * mat4f::scaling(float3{ 2, 4, 1 }));
+
+    // a quantized position maps to the model space position it encodes
+    const float4 p = row.worldFromModelMatrix * float4{ 0.5f, -1.0f, 0.0f, 1.0f };
+    EXPECT_EQ(p, world * float4(2, -2, 3, 1));
+
+    // the row is updated when positions aren't quantized anymore
+    rcm.setQuantizedPositions(rcm.getInstance(e), {});
+    fill(soa, { e });
+    update(uniforms, soa);
+    EXPECT_EQ(uniforms.getRowData(uniforms.getRows()[0]).worldFromModelMatrix, world);
+
+    rcm.destroy(e);
+    engine->destroy(view);
+    EntityManager::get().destroy(e);
+}
+
+TEST_F(PerRenderableUniformsTest, QuantizedPositionsNeedObjectVertexDomain) {
+    RenderableManager& rcm = engine->getRenderableManager();
+    FRenderableManager const& frcm = upcast(engine)->getRenderableManager();
+
+    static const float3 positions[3] = {{ -1, -1, 0 }, { 1, -1, 0 }, { 0, 1, 0 }};
+    static const uint16_t indices[3] = { 0, 1, 2 };
+    VertexBuffer* vb = VertexBuffer::Builder()
+            .vertexCount(3)
+            .bufferCount(1)
+            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+            .build(*engine);
+    vb->setBufferAt(*engine, 0, { positions, sizeof(positions) });
+    IndexBuffer* ib = IndexBuffer::Builder()
+            .indexCount(3)
+            .bufferType(IndexBuffer::IndexType::USHORT)
+            .build(*engine);
+    ib->setBuffer(*engine, { indices, sizeof(indices) });
+
+    // the skybox material is in the device vertex domain
+    Material* device = Material::Builder()
+            .package(MATERIALS_SKYBOX_DATA, MATERIALS_SKYBOX_SIZE)
+            .build(*engine);
+    ASSERT_NE(device, nullptr);
+    ASSERT_EQ(device->getVertexDomain(), VertexDomain::DEVICE);
+    MaterialInstance const* object = engine->getDefaultMaterial()->getDefaultInstance();
+    ASSERT_EQ(object->getMaterial()->getVertexDomain(), VertexDomain::OBJECT);
+
+    const Box bounds{ float3{ 0 }, float3{ 1 }};
+    auto build = [&](MaterialInstance const* mi, Entity e) {
+        bool success;
+        try {
+            success = RenderableManager::Builder(1)
+                    .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                    .quantizedPositions(bounds)
+                    .material(0, mi)
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES, vb, ib)
+                    .build(*engine, e) == RenderableManager::Builder::Success;
+        } catch (utils::Panic const&) {
+            // build() throws instead of returning an error when exceptions are enabled
+            success = false;
+        }
+        return success;
+    };
+
+    Entity a = EntityManager::get().create();
+    EXPECT_FALSE(build(device->getDefaultInstance(), a));
+    EXPECT_FALSE(rcm.hasComponent(a));
+
+    Entity b = EntityManager::get().create();
+    EXPECT_TRUE(build(object, b));
+    auto const bi = rcm.getInstance(b);
+    EXPECT_TRUE(frcm.getVisibility(bi).quantizedPositions);
+
+    // the material of a renderable with quantized positions stays in the object domain
+    rcm.setMaterialInstanceAt(bi, 0, device->getDefaultInstance());
+    EXPECT_EQ(rcm.getMaterialInstanceAt(bi, 0), object);
+
+    // and positions can't be quantized with a material in another domain
+    rcm.setQuantizedPositions(bi, {});
+    EXPECT_FALSE(frcm.getVisibility(bi).quantizedPositions);
+    rcm.setMaterialInstanceAt(bi, 0, device->getDefaultInstance());
+    rcm.setQuantizedPositions(bi, bounds);
+    EXPECT_FALSE(frcm.getVisibility(bi).quantizedPositions);
+
+    rcm.destroy(b);
+    engine->destroy(device);
+    engine->destroy(ib);
+    engine->destroy(vb);
+    EntityManager::get().destroy(a);
+    EntityManager::get().destroy(b);
+}
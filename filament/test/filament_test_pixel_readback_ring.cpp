@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/PixelReadbackRing.h>
+#include <filament/Renderer.h>
+#include <filament/SwapChain.h>
+
+#include <memory>
+#include <vector>
+
+using namespace filament;
+
+class PixelReadbackRingTest : public testing::Test {
+protected:
+    static constexpr uint32_t WIDTH = 16;
+    static constexpr uint32_t HEIGHT = 8;
+
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        mSwapChain = mEngine->createSwapChain(WIDTH, HEIGHT);
+        mRenderer = mEngine->createRenderer();
+    }
+
+    void TearDown() override {
+        mEngine->destroy(mRenderer);
+        mEngine->destroy(mSwapChain);
+        Engine::destroy(&mEngine);
+    }
+
+    // Captures a frame, returns the result of capture().
+    bool captureFrame(PixelReadbackRing& ring) {
+        // the NOOP backend finishes frames immediately, so frames are never skipped
+        EXPECT_TRUE(mRenderer->beginFrame(mSwapChain));
+        const bool captured = ring.capture(mRenderer);
+        mRenderer->endFrame();
+        return captured;
+    }
+
+    Engine* mEngine = nullptr;
+    SwapChain* mSwapChain = nullptr;
+    Renderer* mRenderer = nullptr;
+};
+
+TEST_F(PixelReadbackRingTest, CaptureAcquireRelease) {
+    PixelReadbackRing ring(WIDTH, HEIGHT, 3);
+    EXPECT_EQ(ring.getDepth(), 3);
+    EXPECT_EQ(ring.getBufferSize(), WIDTH * HEIGHT * 4);
+
+    PixelReadbackRing::Frame frame;
+    EXPECT_FALSE(ring.acquire(&frame));
+
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_FALSE(ring.isFull());
+        ASSERT_TRUE(captureFrame(ring));
+        EXPECT_EQ(ring.getPendingCount(), i + 1);
+    }
+
+    // nothing is captured while all the buffers are in use
+    EXPECT_TRUE(ring.isFull());
+    EXPECT_FALSE(captureFrame(ring));
+    EXPECT_EQ(ring.getPendingCount(), 3);
+
+    // images are acquired in capture order, each in its own buffer
+    ring.flush(*mEngine);
+    std::vector<void*> buffers;
+    for (uint64_t sequence = 0; sequence < 3; sequence++) {
+        ASSERT_TRUE(ring.acquire(&frame));
+        EXPECT_EQ(frame.sequence, sequence);
+        EXPECT_EQ(frame.size, ring.getBufferSize());
+        EXPECT_NE(frame.buffer, nullptr);
+        for (void* buffer : buffers) {
+            EXPECT_NE(frame.buffer, buffer);
+        }
+        buffers.push_back(frame.buffer);
+
+        // a released image frees its buffer
+        ring.release();
+        EXPECT_FALSE(ring.isFull());
+        EXPECT_EQ(ring.getPendingCount(), 2 - sequence);
+    }
+    EXPECT_FALSE(ring.acquire(&frame));
+
+    // buffers are reused in the same order, and sequence numbers keep increasing
+    for (uint64_t sequence = 3; sequence < 8; sequence++) {
+        ASSERT_TRUE(captureFrame(ring));
+        ring.flush(*mEngine);
+        ASSERT_TRUE(ring.acquire(&frame));
+        EXPECT_EQ(frame.sequence, sequence);
+        EXPECT_EQ(frame.buffer, buffers[sequence % 3]);
+        ring.release();
+    }
+    EXPECT_EQ(ring.getPendingCount(), 0);
+}
+
+TEST_F(PixelReadbackRingTest, AcquiredImageBlocksCapture) {
+    PixelReadbackRing ring(WIDTH, HEIGHT, 2);
+    ASSERT_TRUE(captureFrame(ring));
+    ring.flush(*mEngine);
+
+    // an acquired image still holds its buffer
+    PixelReadbackRing::Frame frame;
+    ASSERT_TRUE(ring.acquire(&frame));
+    ASSERT_TRUE(captureFrame(ring));
+    EXPECT_TRUE(ring.isFull());
+    EXPECT_FALSE(captureFrame(ring));
+
+    ring.release();
+    EXPECT_FALSE(ring.isFull());
+    ring.waitForOldest(*mEngine);
+    ASSERT_TRUE(ring.acquire(&frame));
+    EXPECT_EQ(frame.sequence, 1);
+    ring.release();
+}
+
+TEST_F(PixelReadbackRingTest, ClientBuffers) {
+    constexpr uint8_t DEPTH = 2;
+    const size_t size = PixelReadbackRing::getBufferSize(WIDTH, HEIGHT,
+            backend::PixelDataFormat::RGB, backend::PixelDataType::FLOAT);
+    EXPECT_EQ(size, WIDTH * HEIGHT * 3 * sizeof(float));
+
+    std::vector<uint8_t> storage(size * DEPTH);
+    void* const buffers[DEPTH] = { storage.data(), storage.data() + size };
+    PixelReadbackRing ring(WIDTH, HEIGHT, DEPTH,
+            backend::PixelDataFormat::RGB, backend::PixelDataType::FLOAT, buffers);
+    EXPECT_EQ(ring.getBufferSize(), size);
+
+    // images are written in the client's buffers, in turn
+    for (uint64_t sequence = 0; sequence < 4; sequence++) {
+        ASSERT_TRUE(captureFrame(ring));
+        ring.flush(*mEngine);
+        PixelReadbackRing::Frame frame;
+        ASSERT_TRUE(ring.acquire(&frame));
+        EXPECT_EQ(frame.sequence, sequence);
+        EXPECT_EQ(frame.buffer, buffers[sequence % DEPTH]);
+        EXPECT_EQ(frame.size, size);
+        ring.release();
+    }
+}
+
+TEST_F(PixelReadbackRingTest, DestroyWithReadsInFlight) {
+    // the ring goes away while its read-backs are in flight, their completion must not touch it
+    auto ring = std::make_unique<PixelReadbackRing>(WIDTH, HEIGHT, 3);
+    ASSERT_TRUE(captureFrame(*ring));
+    ASSERT_TRUE(captureFrame(*ring));
+    ring.reset();
+    mEngine->flushAndWait();
+
+    // same with an acquired image and one in flight
+    ring = std::make_unique<PixelReadbackRing>(WIDTH, HEIGHT, 2);
+    ASSERT_TRUE(captureFrame(*ring));
+    ring->flush(*mEngine);
+    PixelReadbackRing::Frame frame;
+    ASSERT_TRUE(ring->acquire(&frame));
+    ASSERT_TRUE(captureFrame(*ring));
+    ring.reset();
+    mEngine->flushAndWait();
+
+    // client buffers only need to outlive the read-backs
+    std::vector<uint8_t> storage(PixelReadbackRing::getBufferSize(WIDTH, HEIGHT));
+    void* const buffers[1] = { storage.data() };
+    ring = std::make_unique<PixelReadbackRing>(WIDTH, HEIGHT, 1,
+            backend::PixelDataFormat::RGBA, backend::PixelDataType::UBYTE, buffers);
+    ASSERT_TRUE(captureFrame(*ring));
+    ring.reset();
+    mEngine->flushAndWait();
+}
@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <filament/Engine.h>
+#include <filament/LightManager.h>
+#include <filament/QualityGovernor.h>
+#include <filament/Renderer.h>
+#include <filament/View.h>
+
+#include <utils/EntityManager.h>
+
+using namespace filament;
+using namespace utils;
+
+using Lever = QualityGovernor::Lever;
+
+class QualityGovernorTest : public ::testing::Test {
+protected:
+    static constexpr float TARGET = 16.0f;
+
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        view = engine->createView();
+
+        AmbientOcclusionOptions ao;
+        ao.enabled = true;
+        ao.quality = QualityLevel::HIGH;
+        view->setAmbientOcclusionOptions(ao);
+
+        BloomOptions bloom;
+        bloom.enabled = true;
+        bloom.levels = 6;
+        view->setBloomOptions(bloom);
+
+        sun = EntityManager::get().create();
+        LightManager::Builder(LightManager::Type::SUN)
+                .castShadows(true)
+                .shadowOptions({ .mapSize = 2048, .shadowCascades = 4 })
+                .build(*engine, sun);
+
+        options.targetFrameTimeMilli = TARGET;
+        options.downFrameCount = 4;
+        options.upFrameCount = 30;
+        options.settleFrameCount = 8;
+    }
+
+    void TearDown() override {
+        engine->destroy(sun);
+        EntityManager::get().destroy(sun);
+        engine->destroy(view);
+        Engine::destroy(&engine);
+    }
+
+    // feeds `count` frames of the given duration, returns the number of changes
+    static size_t feed(QualityGovernor& governor, float ms, size_t count,
+            Renderer::FrameTimings timings = {}) {
+        timings.cpuFrameTimeNanos = uint64_t(ms * 1e6f);
+        size_t changes = 0;
+        for (size_t i = 0; i < count; i++) {
+            changes += governor.update(timings) ? 1 : 0;
+        }
+        return changes;
+    }
+
+    uint32_t getShadowMapSize() const {
+        LightManager& lm = engine->getLightManager();
+        return lm.getShadowOptions(lm.getInstance(sun)).mapSize;
+    }
+
+    Engine* engine = nullptr;
+    View* view = nullptr;
+    Entity sun;
+    QualityGovernor::Options options;
+};
+
+TEST_F(QualityGovernorTest, StepsDownAfterConsecutiveFramesOverBudget) {
+    const Lever ladder[] = { Lever::AMBIENT_OCCLUSION, Lever::BLOOM };
+    QualityGovernor governor(*engine, view, options, ladder, 2);
+
+    EXPECT_EQ(feed(governor, 20.0f, 3), 0);
+    // a frame within budget restarts the count
+    EXPECT_EQ(feed(governor, 15.0f, 1), 0);
+    EXPECT_EQ(feed(governor, 20.0f, 3), 0);
+    EXPECT_EQ(governor.getLevel(), 0);
+
+    EXPECT_EQ(feed(governor, 20.0f, 1), 1);
+    EXPECT_EQ(governor.getLevel(), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::AMBIENT_OCCLUSION), 1);
+    EXPECT_EQ(view->getAmbientOcclusionOptions().quality, QualityLevel::MEDIUM);
+    EXPECT_EQ(view->getBloomOptions().levels, 6);
+
+    // the frames following a change are ignored, then the next rung is taken
+    EXPECT_EQ(feed(governor, 20.0f, 8 + 3), 0);
+    EXPECT_EQ(feed(governor, 20.0f, 1), 1);
+    EXPECT_EQ(view->getBloomOptions().levels, 5);
+}
+
+TEST_F(QualityGovernorTest, HysteresisBand) {
+    const Lever ladder[] = { Lever::AMBIENT_OCCLUSION, Lever::BLOOM };
+    QualityGovernor governor(*engine, view, options, ladder, 2);
+
+    EXPECT_EQ(feed(governor, 20.0f, 4), 1);
+    // between upThreshold * target and target, nothing ever changes
+    EXPECT_EQ(feed(governor, 14.0f, 1000), 0);
+    EXPECT_EQ(governor.getLevel(), 1);
+
+    // alternating over and under budget doesn't accumulate either way
+    for (size_t i = 0; i < 100; i++) {
+        EXPECT_FALSE(governor.update([] {
+            Renderer::FrameTimings timings;
+            timings.cpuFrameTimeNanos = 20'000'000;
+            return timings;
+        }()));
+        EXPECT_EQ(feed(governor, 8.0f, 1), 0);
+    }
+    EXPECT_EQ(governor.getLevel(), 1);
+}
+
+TEST_F(QualityGovernorTest, StepsUpAfterConsecutiveFramesUnderBudget) {
+    const Lever ladder[] = { Lever::AMBIENT_OCCLUSION, Lever::BLOOM };
+    QualityGovernor governor(*engine, view, options, ladder, 2);
+
+    EXPECT_EQ(feed(governor, 20.0f, 4), 1);
+    EXPECT_EQ(feed(governor, 20.0f, 8 + 4), 1);
+    EXPECT_EQ(governor.getLevel(), 2);
+
+    // settle, then upFrameCount frames under budget for each step
+    EXPECT_EQ(feed(governor, 8.0f, 8 + 29), 0);
+    EXPECT_EQ(feed(governor, 8.0f, 1), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::BLOOM), 0);
+    EXPECT_EQ(view->getBloomOptions().levels, 6);
+    EXPECT_EQ(feed(governor, 8.0f, 8 + 30), 1);
+    EXPECT_EQ(governor.getLevel(), 0);
+    EXPECT_EQ(view->getAmbientOcclusionOptions().quality, QualityLevel::HIGH);
+
+    // nothing left to undo
+    EXPECT_EQ(feed(governor, 8.0f, 1000), 0);
+}
+
+TEST_F(QualityGovernorTest, BacksOffWhenStepUpDoesNotHold) {
+    const Lever ladder[] = { Lever::AMBIENT_OCCLUSION, Lever::BLOOM };
+    QualityGovernor governor(*engine, view, options, ladder, 2);
+
+    EXPECT_EQ(feed(governor, 20.0f, 4), 1);
+    EXPECT_EQ(feed(governor, 8.0f, 8 + 30), 1);
+    EXPECT_EQ(governor.getLevel(), 0);
+
+    // the step up didn't hold
+    EXPECT_EQ(feed(governor, 20.0f, 8 + 4), 1);
+    EXPECT_EQ(governor.getLevel(), 1);
+
+    // it now takes twice as many frames to step up again
+    EXPECT_EQ(feed(governor, 8.0f, 8 + 59), 0);
+    EXPECT_EQ(feed(governor, 8.0f, 1), 1);
+
+    // and four times after bouncing again
+    EXPECT_EQ(feed(governor, 20.0f, 8 + 4), 1);
+    EXPECT_EQ(feed(governor, 8.0f, 8 + 119), 0);
+    EXPECT_EQ(feed(governor, 8.0f, 1), 1);
+}
+
+TEST_F(QualityGovernorTest, DegradesTheCostliestPasses) {
+    LightManager& lm = engine->getLightManager();
+    QualityGovernor governor(*engine, view, options);
+    governor.setShadowCasters(&sun, 1);
+
+    Renderer::FrameTimings timings;
+    timings.gpuTimingsValid = true;
+    timings.gpuFrameTimeNanos = 20'000'000;
+    timings.passCount = 3;
+    timings.passes[0] = { "Shadow Pass", 100'000, 12'000'000 };
+    timings.passes[1] = { "Color Pass", 100'000, 6'000'000 };
+    timings.passes[2] = { "SSAO Pass", 100'000, 2'000'000 };
+
+    // shadows dominate, they're degraded even though they come later in the default ladder
+    EXPECT_EQ(feed(governor, 1.0f, 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::SHADOW_MAP_SIZE), 1);
+    EXPECT_EQ(getShadowMapSize(), 1024);
+    EXPECT_EQ(lm.getShadowOptions(lm.getInstance(sun)).shadowCascades, 4);
+
+    // halving the shadow maps is expected to save more than dropping one of four cascades
+    EXPECT_EQ(feed(governor, 1.0f, 8 + 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::SHADOW_MAP_SIZE), 2);
+    EXPECT_EQ(getShadowMapSize(), 512);
+    EXPECT_EQ(lm.getShadowOptions(lm.getInstance(sun)).shadowCascades, 4);
+
+    // levers without a matching pass are never picked over those that have one
+    EXPECT_EQ(governor.getDegradation(Lever::BLOOM), 0);
+    EXPECT_EQ(governor.getDegradation(Lever::FROXEL_DENSITY), 0);
+}
+
+TEST_F(QualityGovernorTest, VsmBlurIsCostedByItsOwnPass) {
+    LightManager& lm = engine->getLightManager();
+    LightManager::ShadowOptions shadowOptions = lm.getShadowOptions(lm.getInstance(sun));
+    shadowOptions.vsm.blurWidth = 16.0f;
+    lm.setShadowOptions(lm.getInstance(sun), shadowOptions);
+
+    QualityGovernor governor(*engine, view, options);
+    governor.setShadowCasters(&sun, 1);
+
+    // other Gaussian blurs, like bloom's flare, don't get cheaper with a narrower VSM blur
+    Renderer::FrameTimings timings;
+    timings.gpuTimingsValid = true;
+    timings.gpuFrameTimeNanos = 20'000'000;
+    timings.passCount = 3;
+    timings.passes[0] = { "Gaussian Blur Passes", 100'000, 12'000'000 };
+    timings.passes[1] = { "Bloom Downsample", 100'000, 2'000'000 };
+    timings.passes[2] = { "VSM Gaussian Blur Passes", 100'000, 500'000 };
+
+    EXPECT_EQ(feed(governor, 1.0f, 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::BLOOM), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::VSM_BLUR), 0);
+
+    timings.passes[2].gpuTimeNanos = 3'000'000;
+    EXPECT_EQ(feed(governor, 1.0f, 8 + 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::VSM_BLUR), 1);
+    EXPECT_EQ(lm.getShadowOptions(lm.getInstance(sun)).vsm.blurWidth, 8.0f);
+}
+
+TEST_F(QualityGovernorTest, SkipsLeversThatCantDegrade) {
+    // MSAA is off and there is no shadow caster
+    const Lever ladder[] = { Lever::MSAA, Lever::SHADOW_MAP_SIZE, Lever::VSM_BLUR, Lever::BLOOM,
+            Lever::BLOOM, Lever::BLOOM, Lever::BLOOM };
+    QualityGovernor governor(*engine, view, options, ladder, 7);
+
+    EXPECT_EQ(feed(governor, 20.0f, 4), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::BLOOM), 1);
+    EXPECT_FALSE(view->getMultiSampleAntiAliasingOptions().enabled);
+    EXPECT_EQ(getShadowMapSize(), 2048);
+
+    // bloom can go from 6 down to 3 levels, not further
+    EXPECT_EQ(feed(governor, 20.0f, 1000), 2);
+    EXPECT_EQ(governor.getLevel(), 3);
+    EXPECT_EQ(view->getBloomOptions().levels, 3);
+}
+
+TEST_F(QualityGovernorTest, RestoresFullQuality) {
+    QualityGovernor governor(*engine, view, options);
+    governor.setShadowCasters(&sun, 1);
+    view->setFroxelDensity(1.0f);
+
+    EXPECT_GT(feed(governor, 50.0f, 1000), 10);
+    EXPECT_FALSE(view->getAmbientOcclusionOptions().enabled);
+    EXPECT_EQ(view->getBloomOptions().levels, 4);
+    EXPECT_EQ(getShadowMapSize(), 256);
+    EXPECT_EQ(view->getFroxelDensity(), 0.25f);
+
+    governor.restore();
+    EXPECT_EQ(governor.getLevel(), 0);
+    EXPECT_TRUE(view->getAmbientOcclusionOptions().enabled);
+    EXPECT_EQ(view->getAmbientOcclusionOptions().quality, QualityLevel::HIGH);
+    EXPECT_EQ(view->getBloomOptions().levels, 6);
+    EXPECT_EQ(getShadowMapSize(), 2048);
+    EXPECT_EQ(view->getFroxelDensity(), 1.0f);
+}
+
+TEST_F(QualityGovernorTest, WeighsLeversByTheirExpectedSaving) {
+    MultiSampleAntiAliasingOptions msaa;
+    msaa.enabled = true;
+    msaa.sampleCount = 4;
+    view->setMultiSampleAntiAliasingOptions(msaa);
+
+    QualityGovernor governor(*engine, view, options);
+    governor.setShadowCasters(&sun, 1);
+
+    // MSAA only makes part of the color pass cheaper
+    Renderer::FrameTimings timings;
+    timings.gpuTimingsValid = true;
+    timings.gpuFrameTimeNanos = 20'000'000;
+    timings.passCount = 2;
+    timings.passes[0] = { "Color Pass", 100'000, 12'000'000 };
+    timings.passes[1] = { "Shadow Pass", 100'000, 8'000'000 };
+    EXPECT_EQ(feed(governor, 1.0f, 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::SHADOW_MAP_SIZE), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::MSAA), 0);
+}
+
+TEST_F(QualityGovernorTest, OnlyCountsTheBoundingSide) {
+    QualityGovernor governor(*engine, view, options);
+    governor.setShadowCasters(&sun, 1);
+
+    // when GPU bound, making froxelization cheaper on the CPU doesn't help
+    Renderer::FrameTimings timings;
+    timings.gpuTimingsValid = true;
+    timings.gpuFrameTimeNanos = 20'000'000;
+    timings.passCount = 1;
+    timings.passes[0] = { "Shadow Pass", 100'000, 2'000'000 };
+    timings.stageCpuTimeNanos[size_t(Renderer::FrameStage::FROXELIZATION)] = 10'000'000;
+    EXPECT_EQ(feed(governor, 1.0f, 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::SHADOW_MAP_SIZE), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::FROXEL_DENSITY), 0);
+
+    // when CPU bound, it does
+    EXPECT_EQ(feed(governor, 30.0f, 8 + 4, timings), 1);
+    EXPECT_EQ(governor.getDegradation(Lever::FROXEL_DENSITY), 1);
+}
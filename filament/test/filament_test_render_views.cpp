@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "FrameStatistics.h"
+
+#include "details/Engine.h"
+#include "details/Scene.h"
+#include "details/View.h"
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/SwapChain.h>
+#include <filament/TransformManager.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/scalar.h>
+
+#include <cmath>
+#include <set>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+class RenderViewsTest : public testing::Test {
+protected:
+    static constexpr size_t RENDERABLE_COUNT = 16;
+
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        mSwapChain = mEngine->createSwapChain(64, 64);
+        mRenderer = mEngine->createRenderer();
+
+        static const float3 positions[3] = {{ -1, -1, 0 }, { 1, -1, 0 }, { 0, 1, 0 }};
+        static const uint16_t indices[3] = { 0, 1, 2 };
+        mVertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                .build(*mEngine);
+        mVertexBuffer->setBufferAt(*mEngine, 0, { positions, sizeof(positions) });
+        mIndexBuffer = IndexBuffer::Builder()
+                .indexCount(3)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(*mEngine);
+        mIndexBuffer->setBuffer(*mEngine, { indices, sizeof(indices) });
+
+        mScenes[0] = mEngine->createScene();
+        mScenes[1] = mEngine->createScene();
+
+        // renderables on a ring around the origin, every other one in the second scene too
+        TransformManager& tcm = mEngine->getTransformManager();
+        for (size_t i = 0; i < RENDERABLE_COUNT; i++) {
+            const float angle = float(i) * 2.0f * float(F_PI) / RENDERABLE_COUNT;
+            Entity e = EntityManager::get().create();
+            RenderableManager::Builder(1)
+                    .boundingBox({{ -1, -1, -1 }, { 1, 1, 1 }})
+                    .material(0, mEngine->getDefaultMaterial()->getDefaultInstance())
+                    .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                            mVertexBuffer, mIndexBuffer)
+                    .build(*mEngine, e);
+            tcm.create(e, {}, mat4f::translation(
+                    float3{ std::cos(angle), 0.0f, std::sin(angle) } * 10.0f));
+            mScenes[0]->addEntity(e);
+            if (i % 2 == 0) {
+                mScenes[1]->addEntity(e);
+            }
+            mRenderables.push_back(e);
+        }
+    }
+
+    void TearDown() override {
+        for (View* view : mViews) {
+            mEngine->destroy(view);
+        }
+        for (Entity e : mCameras) {
+            mEngine->destroyCameraComponent(e);
+            EntityManager::get().destroy(e);
+        }
+        for (Entity e : mRenderables) {
+            mEngine->destroy(e);
+            EntityManager::get().destroy(e);
+        }
+        mEngine->destroy(mScenes[0]);
+        mEngine->destroy(mScenes[1]);
+        mEngine->destroy(mIndexBuffer);
+        mEngine->destroy(mVertexBuffer);
+        mEngine->destroy(mRenderer);
+        mEngine->destroy(mSwapChain);
+        Engine::destroy(&mEngine);
+    }
+
+    // Adds a view of the scene, looking at the ring from its center in the given direction.
+    View* createView(Scene* scene, float angle) {
+        Entity e = EntityManager::get().create();
+        Camera* camera = mEngine->createCamera(e);
+        camera->setProjection(60.0, 1.0, 0.1, 100.0);
+        camera->lookAt({ 0, 0, 0 }, { std::cos(angle), 0.0f, std::sin(angle) });
+        View* view = mEngine->createView();
+        view->setViewport({ 0, 0, 64, 64 });
+        view->setScene(scene);
+        view->setCamera(camera);
+        view->setPostProcessingEnabled(false);
+        mCameras.push_back(e);
+        mViews.push_back(view);
+        return view;
+    }
+
+    // Renderables found visible by the last view that prepared the view's scene.
+    std::set<Entity> getVisibleEntities(View* view) {
+        FView* const v = upcast(view);
+        FScene::RenderableSoa const& renderableData = v->getScene()->getRenderableData();
+        FRenderableManager const& rcm = upcast(mEngine)->getRenderableManager();
+        std::set<Entity> visible;
+        for (uint32_t i : v->getVisibleRenderables()) {
+            visible.insert(rcm.getEntity(
+                    renderableData.elementAt<FScene::RENDERABLE_INSTANCE>(i)));
+        }
+        return visible;
+    }
+
+    struct Result {
+        std::set<Entity> visible;
+        FrameStatistics::Snapshot statistics;
+    };
+
+    // Renders the views in a frame, returns what the last one saw and the frame's statistics.
+    template<typename F>
+    Result renderFrame(std::vector<View*> const& views, F render) {
+        FrameStatistics const& statistics = upcast(mEngine)->getFrameStatistics();
+        const FrameStatistics::Snapshot start = statistics.snapshot();
+        EXPECT_TRUE(mRenderer->beginFrame(mSwapChain));
+        render(views);
+        mRenderer->endFrame();
+        mEngine->flushAndWait();
+        return { getVisibleEntities(views.back()), statistics.snapshot() - start };
+    }
+
+    Engine* mEngine = nullptr;
+    SwapChain* mSwapChain = nullptr;
+    Renderer* mRenderer = nullptr;
+    VertexBuffer* mVertexBuffer = nullptr;
+    IndexBuffer* mIndexBuffer = nullptr;
+    Scene* mScenes[2] = {};
+    std::vector<Entity> mRenderables;
+    std::vector<Entity> mCameras;
+    std::vector<View*> mViews;
+};
+
+TEST_F(RenderViewsTest, SameAsRender) {
+    // The second scene's first view comes after views of the first scene, and the first scene
+    // is used again afterwards, so all the ways renderViews() prepares the scenes are covered.
+    createView(mScenes[0], 0.0f);
+    createView(mScenes[0], float(F_PI) * 0.5f);
+    createView(mScenes[1], float(F_PI));
+    createView(mScenes[0], float(F_PI) * 1.5f);
+    createView(mScenes[1], 0.0f);
+
+    std::set<std::set<Entity>> visibleSets;
+    for (size_t count = 1; count <= mViews.size(); count++) {
+        std::vector<View*> const views(mViews.begin(), mViews.begin() + count);
+
+        Result const expected = renderFrame(views, [this](std::vector<View*> const& views) {
+            for (View* view : views) {
+                mRenderer->render(view);
+            }
+        });
+
+        Result const batched = renderFrame(views, [this](std::vector<View*> const& views) {
+            mRenderer->renderViews(views.data(), views.size());
+        });
+
+        EXPECT_EQ(batched.visible, expected.visible) << "view " << count - 1;
+        EXPECT_EQ(batched.statistics.drawCount, expected.statistics.drawCount);
+        EXPECT_EQ(batched.statistics.triangleCount, expected.statistics.triangleCount);
+        EXPECT_EQ(batched.statistics.stateChangeCount, expected.statistics.stateChangeCount);
+        EXPECT_FALSE(expected.visible.empty());
+        visibleSets.insert(expected.visible);
+    }
+
+    // the views don't all see the same renderables
+    EXPECT_GT(visibleSets.size(), 1);
+}
+
+TEST_F(RenderViewsTest, SceneChangesBetweenFrames) {
+    createView(mScenes[0], 0.0f);
+    createView(mScenes[0], float(F_PI) * 0.5f);
+
+    auto renderViews = [this](std::vector<View*> const& views) {
+        mRenderer->renderViews(views.data(), views.size());
+    };
+    auto render = [this](std::vector<View*> const& views) {
+        for (View* view : views) {
+            mRenderer->render(view);
+        }
+    };
+
+    Result const before = renderFrame(mViews, renderViews);
+    EXPECT_EQ(before.visible, renderFrame(mViews, render).visible);
+
+    // culling results of the previous frame don't leak into this one
+    for (Entity e : before.visible) {
+        mScenes[0]->remove(e);
+    }
+    Result const after = renderFrame(mViews, renderViews);
+    EXPECT_TRUE(after.visible.empty());
+    EXPECT_EQ(after.visible, renderFrame(mViews, render).visible);
+}
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "details/Engine.h"
+#include "details/Scene.h"
+#include "details/View.h"
+
+#include <filament/Camera.h>
+#include <filament/Engine.h>
+#include <filament/IndexBuffer.h>
+#include <filament/LightManager.h>
+#include <filament/Material.h>
+#include <filament/RenderableManager.h>
+#include <filament/Renderer.h>
+#include <filament/Scene.h>
+#include <filament/SwapChain.h>
+#include <filament/VertexBuffer.h>
+#include <filament/View.h>
+
+#include <private/filament/EngineEnums.h>
+
+#include <utils/EntityManager.h>
+
+#include <math/mat4.h>
+#include <math/scalar.h>
+#include <math/vec4.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace filament;
+using namespace filament::math;
+using namespace utils;
+
+class ShadowAtlasTest : public testing::Test {
+protected:
+    // more shadow-casting spotlights than can be rendered in a frame
+    static constexpr size_t LIGHT_COUNT = CONFIG_MAX_SHADOW_CASTING_SPOTS + 6;
+
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        mSwapChain = mEngine->createSwapChain(64, 64);
+        mRenderer = mEngine->createRenderer();
+        mScene = mEngine->createScene();
+
+        // a ground that casts and receives shadows
+        static const float3 positions[3] = {{ -20, 0, -20 }, { 20, 0, -20 }, { 0, 0, 20 }};
+        static const uint16_t indices[3] = { 0, 1, 2 };
+        mVertexBuffer = VertexBuffer::Builder()
+                .vertexCount(3)
+                .bufferCount(1)
+                .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::FLOAT3)
+                .build(*mEngine);
+        mVertexBuffer->setBufferAt(*mEngine, 0, { positions, sizeof(positions) });
+        mIndexBuffer = IndexBuffer::Builder()
+                .indexCount(3)
+                .bufferType(IndexBuffer::IndexType::USHORT)
+                .build(*mEngine);
+        mIndexBuffer->setBuffer(*mEngine, { indices, sizeof(indices) });
+        mGround = EntityManager::get().create();
+        RenderableManager::Builder(1)
+                .boundingBox({{ -20, -0.1f, -20 }, { 20, 0.1f, 20 }})
+                .material(0, mEngine->getDefaultMaterial()->getDefaultInstance())
+                .geometry(0, RenderableManager::PrimitiveType::TRIANGLES,
+                        mVertexBuffer, mIndexBuffer)
+                .castShadows(true)
+                .receiveShadows(true)
+                .build(*mEngine, mGround);
+        mScene->addEntity(mGround);
+
+        // spotlights on a ring above the ground, pointing down
+        for (size_t i = 0; i < LIGHT_COUNT; i++) {
+            const float angle = float(i) * 2.0f * float(F_PI) / LIGHT_COUNT;
+            Entity e = EntityManager::get().create();
+            LightManager::Builder(LightManager::Type::SPOT)
+                    .position({ std::cos(angle) * 5.0f, 3.0f, std::sin(angle) * 5.0f })
+                    .direction({ 0, -1, 0 })
+                    .falloff(10.0f)
+                    .spotLightCone(0.5f, 0.7f)
+                    .castShadows(true)
+                    .build(*mEngine, e);
+            mScene->addEntity(e);
+            mLights.push_back(e);
+        }
+
+        mCameraEntity = EntityManager::get().create();
+        Camera* camera = mEngine->createCamera(mCameraEntity);
+        camera->setProjection(60.0, 1.0, 0.1, 100.0);
+        camera->lookAt({ 0, 20, 1 }, { 0, 0, 0 });
+        mView = mEngine->createView();
+        mView->setViewport({ 0, 0, 64, 64 });
+        mView->setScene(mScene);
+        mView->setCamera(camera);
+        mView->setPostProcessingEnabled(false);
+    }
+
+    void TearDown() override {
+        mEngine->destroy(mView);
+        mEngine->destroyCameraComponent(mCameraEntity);
+        EntityManager::get().destroy(mCameraEntity);
+        for (Entity e : mLights) {
+            mEngine->destroy(e);
+            EntityManager::get().destroy(e);
+        }
+        mEngine->destroy(mGround);
+        EntityManager::get().destroy(mGround);
+        mEngine->destroy(mScene);
+        mEngine->destroy(mIndexBuffer);
+        mEngine->destroy(mVertexBuffer);
+        mEngine->destroy(mRenderer);
+        mEngine->destroy(mSwapChain);
+        Engine::destroy(&mEngine);
+    }
+
+    struct SpotShadow {
+        uint8_t index;
+        uint8_t layer;
+        float4 tileRect;
+    };
+
+    // Renders a frame, returns the shadow map of each light that has one.
+    std::map<Entity, SpotShadow> renderFrame() {
+        EXPECT_TRUE(mRenderer->beginFrame(mSwapChain));
+        mRenderer->render(mView);
+        mRenderer->endFrame();
+        mEngine->flushAndWait();
+
+        FView* const view = upcast(mView);
+        FScene::LightSoa const& lightData = view->getScene()->getLightData();
+        FLightManager const& lcm = upcast(mEngine)->getLightManager();
+        ShadowUib const& shadowUniforms = view->getShadowUniforms().itemAt(0);
+        std::map<Entity, SpotShadow> shadows;
+        for (size_t l = FScene::DIRECTIONAL_LIGHTS_COUNT; l < lightData.size(); l++) {
+            FScene::ShadowInfo const& shadowInfo = lightData.elementAt<FScene::SHADOW_INFO>(l);
+            if (shadowInfo.castsShadows) {
+                const Entity e = lcm.getEntity(lightData.elementAt<FScene::LIGHT_INSTANCE>(l));
+                shadows[e] = { shadowInfo.index, shadowInfo.layer,
+                               shadowUniforms.shadows[shadowInfo.index].tileRect };
+            }
+        }
+        return shadows;
+    }
+
+    static bool overlap(float4 const& a, float4 const& b) {
+        return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+    }
+
+    Engine* mEngine = nullptr;
+    SwapChain* mSwapChain = nullptr;
+    Renderer* mRenderer = nullptr;
+    Scene* mScene = nullptr;
+    View* mView = nullptr;
+    VertexBuffer* mVertexBuffer = nullptr;
+    IndexBuffer* mIndexBuffer = nullptr;
+    Entity mGround;
+    Entity mCameraEntity;
+    std::vector<Entity> mLights;
+};
+
+TEST_F(ShadowAtlasTest, MoreSpotlightsThanRenderedPerFrame) {
+    // The spotlights rendered in a frame use the first indices in the shadow uniforms, the
+    // others sample the shadow map rendered in an earlier frame.
+    std::map<Entity, SpotShadow> previous;
+    std::set<Entity> rendered;
+    for (size_t frame = 0; frame < 4; frame++) {
+        std::map<Entity, SpotShadow> const shadows = renderFrame();
+
+        // the first frame can only render some of the shadow maps, after that all the lights
+        // have one
+        EXPECT_EQ(shadows.size(), frame == 0 ? CONFIG_MAX_SHADOW_CASTING_SPOTS : LIGHT_COUNT)
+                << "frame " << frame;
+
+        std::set<uint8_t> indices;
+        size_t renderedCount = 0;
+        for (auto const& [e, shadow] : shadows) {
+            EXPECT_TRUE(indices.insert(shadow.index).second);
+            EXPECT_LT(shadow.index, CONFIG_MAX_SHADOWED_SPOTS);
+            if (shadow.index < CONFIG_MAX_SHADOW_CASTING_SPOTS) {
+                renderedCount++;
+                rendered.insert(e);
+            } else {
+                // a shadow map that's not rendered stays where it was
+                auto const it = previous.find(e);
+                ASSERT_NE(it, previous.end());
+                EXPECT_EQ(shadow.layer, it->second.layer);
+                EXPECT_EQ(shadow.tileRect, it->second.tileRect);
+            }
+
+            // the tile is in the atlas, and shadow maps don't overlap
+            EXPECT_LT(shadow.tileRect.x, shadow.tileRect.z);
+            EXPECT_LT(shadow.tileRect.y, shadow.tileRect.w);
+            EXPECT_GE(shadow.tileRect.x, 0.0f);
+            EXPECT_GE(shadow.tileRect.y, 0.0f);
+            EXPECT_LE(shadow.tileRect.z, 1.0f);
+            EXPECT_LE(shadow.tileRect.w, 1.0f);
+            for (auto const& [other, otherShadow] : shadows) {
+                if (other != e && otherShadow.layer == shadow.layer) {
+                    EXPECT_FALSE(overlap(shadow.tileRect, otherShadow.tileRect));
+                }
+            }
+        }
+        EXPECT_EQ(renderedCount, CONFIG_MAX_SHADOW_CASTING_SPOTS);
+        previous = shadows;
+    }
+
+    // every shadow map is rendered in turn
+    EXPECT_EQ(rendered.size(), LIGHT_COUNT);
+}
+
+TEST_F(ShadowAtlasTest, MovedSpotlightIsRenderedFirst) {
+    for (size_t frame = 0; frame < 3; frame++) {
+        renderFrame();
+    }
+
+    // the shadow map of a light that moved is rendered in the next frame
+    LightManager& lcm = mEngine->getLightManager();
+    const Entity moved = mLights[3];
+    lcm.setPosition(lcm.getInstance(moved), { 0, 4, 0 });
+    std::map<Entity, SpotShadow> const shadows = renderFrame();
+    ASSERT_EQ(shadows.count(moved), 1);
+    EXPECT_LT(shadows.at(moved).index, CONFIG_MAX_SHADOW_CASTING_SPOTS);
+}
+
+TEST_F(ShadowAtlasTest, CameraMotionKeepsShadowMaps) {
+    for (size_t frame = 0; frame < 3; frame++) {
+        renderFrame();
+    }
+
+    // Without a directional light, the size of the spotlights' shadow maps changes with the
+    // camera, but the shadow maps that are not rendered stay in the atlas.
+    Camera* camera = mEngine->getCameraComponent(mCameraEntity);
+    for (size_t frame = 0; frame < 4; frame++) {
+        camera->lookAt({ 0, 12.0f + 3.0f * float(frame), 1 }, { 0, 0, 0 });
+        std::map<Entity, SpotShadow> const shadows = renderFrame();
+        EXPECT_EQ(shadows.size(), LIGHT_COUNT) << "frame " << frame;
+    }
+}
+
+TEST_F(ShadowAtlasTest, FewerSpotlightsRenderEveryFrame) {
+    // when they can all be rendered in a frame, they are
+    for (size_t i = CONFIG_MAX_SHADOW_CASTING_SPOTS; i < LIGHT_COUNT; i++) {
+        mScene->remove(mLights[i]);
+    }
+    for (size_t frame = 0; frame < 2; frame++) {
+        std::map<Entity, SpotShadow> const shadows = renderFrame();
+        EXPECT_EQ(shadows.size(), CONFIG_MAX_SHADOW_CASTING_SPOTS);
+        for (auto const& [e, shadow] : shadows) {
+            EXPECT_LT(shadow.index, CONFIG_MAX_SHADOW_CASTING_SPOTS);
+        }
+    }
+}
+
+TEST_F(ShadowAtlasTest, VsmRendersAtMostAFrameOfSpotlights) {
+    mView->setShadowType(View::ShadowType::VSM);
+    for (size_t frame = 0; frame < 2; frame++) {
+        std::map<Entity, SpotShadow> const shadows = renderFrame();
+        EXPECT_EQ(shadows.size(), CONFIG_MAX_SHADOW_CASTING_SPOTS);
+    }
+}
+
+TEST_F(ShadowAtlasTest, CascadesFitToVisibleReceivers) {
+    // only a directional light with 4 cascades
+    for (Entity e : mLights) {
+        mScene->remove(e);
+    }
+    LightManager::ShadowOptions shadowOptions;
+    shadowOptions.shadowCascades = 4;
+    Entity sun = EntityManager::get().create();
+    LightManager::Builder(LightManager::Type::DIRECTIONAL)
+            .direction({ 0, -1, 0 })
+            .castShadows(true)
+            .shadowOptions(shadowOptions)
+            .build(*mEngine, sun);
+    mScene->addEntity(sun);
+
+    // view-space depth range of the ground's bounding box
+    const mat4f view = mat4f(mEngine->getCameraComponent(mCameraEntity)->getViewMatrix());
+    float near = std::numeric_limits<float>::lowest();
+    float far = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < 8; i++) {
+        const float3 corner{ i & 1u ? 20.0f : -20.0f, i & 2u ? 0.1f : -0.1f,
+                             i & 4u ? 20.0f : -20.0f };
+        const float z = (view * float4(corner, 1.0f)).z;
+        near = std::max(near, z);
+        far = std::min(far, z);
+    }
+
+    auto getSplits = [this]() {
+        return upcast(mView)->getShadowMapManager().getShadowMappingUniforms().cascadeSplits;
+    };
+
+    // by default, the cascades cover the camera's depth range
+    renderFrame();
+    const float4 splits = getSplits();
+    EXPECT_NEAR(splits.x, -25.075f, 1e-3f);
+    EXPECT_NEAR(splits.y, -50.05f, 1e-3f);
+    EXPECT_NEAR(splits.z, -75.025f, 1e-3f);
+    EXPECT_NEAR(splits.w, -100.0f, 1e-3f);
+
+    // fitted, they only cover the visible receiver
+    LightManager& lcm = mEngine->getLightManager();
+    shadowOptions.fitCascadesToVisibleReceivers = true;
+    lcm.setShadowOptions(lcm.getInstance(sun), shadowOptions);
+    renderFrame();
+    const float4 fitted = getSplits();
+    EXPECT_NEAR(fitted.w, far, 1e-3f);
+    EXPECT_NEAR(fitted.x, near + (far - near) * 0.25f, 1e-3f);
+    EXPECT_NEAR(fitted.y, near + (far - near) * 0.50f, 1e-3f);
+    EXPECT_NEAR(fitted.z, near + (far - near) * 0.75f, 1e-3f);
+
+    // and back to the camera's depth range when the option is off
+    shadowOptions.fitCascadesToVisibleReceivers = false;
+    lcm.setShadowOptions(lcm.getInstance(sun), shadowOptions);
+    renderFrame();
+    EXPECT_EQ(getSplits(), splits);
+
+    mEngine->destroy(sun);
+    EntityManager::get().destroy(sun);
+}
@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "RenderPrimitive.h"
+
+#include "details/Camera.h"
+#include "details/Engine.h"
+#include "details/Material.h"
+#include "details/MaterialInstance.h"
+#include "details/Texture.h"
+#include "details/TextureStreamer.h"
+
+#include "generated/resources/materials.h"
+
+#include <filament/Engine.h>
+#include <filament/Material.h>
+#include <filament/MaterialInstance.h>
+#include <filament/Texture.h>
+#include <filament/TextureSampler.h>
+#include <filament/TextureStreamer.h>
+
+#include <chrono>
+#include <thread>
+
+#include <stdlib.h>
+
+using namespace filament;
+using namespace filament::math;
+
+using Candidate = FTextureStreamer::Candidate;
+using TextureFormat = Texture::InternalFormat;
+
+namespace {
+
+class FakeSource : public TextureStreamer::Source {
+public:
+    FakeSource(uint32_t size, uint8_t levels, bool* destroyed, bool fail = false)
+            : mSize(size), mLevels(levels), mDestroyed(destroyed), mFail(fail) {
+    }
+
+    ~FakeSource() noexcept override {
+        *mDestroyed = true;
+    }
+
+    Info getInfo() const noexcept override {
+        return { mSize, mSize, mLevels, TextureFormat::RGBA8 };
+    }
+
+    bool load(size_t level, Texture::PixelBufferDescriptor* buffer) noexcept override {
+        if (mFail) {
+            return false;
+        }
+        const size_t size = std::max(mSize >> level, 1u);
+        const size_t bytes = size * size * 4;
+        *buffer = Texture::PixelBufferDescriptor(calloc(bytes, 1), bytes,
+                Texture::Format::RGBA, Texture::Type::UBYTE,
+                [](void* buffer, size_t, void*) { free(buffer); });
+        return true;
+    }
+
+private:
+    uint32_t mSize;
+    uint8_t mLevels;
+    bool* mDestroyed;
+    bool mFail;
+};
+
+Candidate candidate(uint32_t size, uint8_t tailLevel, uint8_t level, float footprint,
+        uint32_t age = 0) {
+    return { size, size, TextureFormat::RGBA8, uint8_t(tailLevel + 3), tailLevel, level,
+             footprint, age };
+}
+
+} // anonymous namespace
+
+TEST(TextureStreamerTest, ComputeSize) {
+    EXPECT_EQ(FTextureStreamer::computeSize(TextureFormat::RGBA8, 4, 4, 0, 3), (16 + 4 + 1) * 4);
+    EXPECT_EQ(FTextureStreamer::computeSize(TextureFormat::RGBA8, 4, 4, 1, 3), (4 + 1) * 4);
+    EXPECT_EQ(FTextureStreamer::computeSize(TextureFormat::R8, 8, 2, 0, 4), 16 + 4 + 2 + 1);
+    // compressed levels are rounded up to whole blocks
+    EXPECT_EQ(FTextureStreamer::computeSize(TextureFormat::ETC2_RGB8, 8, 8, 0, 4), 4 * 8 + 3 * 8);
+}
+
+TEST(TextureStreamerTest, ComputeLevel) {
+    // not visible, only the tail is needed
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 0.0f, 0.0f, 4), 4);
+    // the level whose size is closest to, but not smaller than, the footprint
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 1024.0f, 0.0f, 4), 0);
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 2048.0f, 0.0f, 4), 0);
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 300.0f, 0.0f, 4), 1);
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 256.0f, 0.0f, 4), 2);
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 2.0f, 0.0f, 4), 4);
+    // the bias shifts the level, negative is sharper
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 256.0f, -1.0f, 4), 1);
+    EXPECT_EQ(FTextureStreamer::computeLevel(1024, 256.0f, 1.0f, 4), 3);
+}
+
+TEST(TextureStreamerTest, FitToBudgetKeepsWhatFits) {
+    Candidate candidates[] = { candidate(256, 2, 0, 256.0f), candidate(256, 2, 0, 16.0f) };
+    const size_t size = FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 0, 5);
+    EXPECT_EQ(FTextureStreamer::fitToBudget(candidates, 2, 2 * size), 2 * size);
+    EXPECT_EQ(candidates[0].level, 0);
+    EXPECT_EQ(candidates[1].level, 0);
+}
+
+TEST(TextureStreamerTest, FitToBudgetEvictsInvisibleFirst) {
+    Candidate candidates[] = {
+            candidate(256, 2, 0, 64.0f),
+            candidate(256, 2, 0, 0.0f, 10),     // not seen for 10 frames
+            candidate(256, 2, 0, 0.0f, 2),      // not seen for 2 frames
+    };
+    const size_t size = FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 0, 5);
+    const size_t tail = FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 2, 5);
+
+    // room for one texture at full resolution, the invisible ones are dropped to their tail
+    EXPECT_EQ(FTextureStreamer::fitToBudget(candidates, 3, size + 2 * tail), size + 2 * tail);
+    EXPECT_EQ(candidates[0].level, 0);
+    EXPECT_EQ(candidates[1].level, 2);
+    EXPECT_EQ(candidates[2].level, 2);
+}
+
+TEST(TextureStreamerTest, FitToBudgetEvictsOversampledFirst) {
+    Candidate candidates[] = {
+            candidate(256, 2, 0, 256.0f),       // 1 texel per pixel
+            candidate(256, 2, 0, 32.0f),        // 8 texels per pixel
+    };
+    const size_t size = FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 0, 5);
+    const size_t level1 = FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 1, 5);
+
+    FTextureStreamer::fitToBudget(candidates, 2, size + level1);
+    EXPECT_EQ(candidates[0].level, 0);
+    EXPECT_EQ(candidates[1].level, 1);
+
+    // the tail is never evicted, even when over budget
+    EXPECT_EQ(FTextureStreamer::fitToBudget(candidates, 2, 0),
+            2 * FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 2, 5));
+    EXPECT_EQ(candidates[0].level, 2);
+    EXPECT_EQ(candidates[1].level, 2);
+}
+
+TEST(TextureStreamerTest, CreateAndDestroy) {
+    Engine* engine = Engine::create(Engine::Backend::NOOP);
+    TextureStreamer& streamer = engine->getTextureStreamer();
+    streamer.setConfig({ .residentSize = 64 });
+
+    bool destroyed = false;
+    Texture* texture = streamer.createTexture(new FakeSource(256, 9, &destroyed));
+    ASSERT_NE(texture, nullptr);
+    EXPECT_EQ(texture->getWidth(), 256);
+    EXPECT_EQ(texture->getLevels(), 9);
+
+    // 256 and 128 are streamed, 64 and below are always resident
+    EXPECT_EQ(streamer.getResidentLevel(texture), 2);
+    EXPECT_EQ(streamer.getResidentSize(),
+            FTextureStreamer::computeSize(TextureFormat::RGBA8, 256, 256, 2, 9));
+    EXPECT_EQ(streamer.getPendingCount(), 0);
+
+    engine->destroy(texture);
+    EXPECT_EQ(streamer.getResidentSize(), 0);
+
+    // a source whose resident levels can't be loaded doesn't make a texture
+    bool failedDestroyed = false;
+    EXPECT_EQ(streamer.createTexture(new FakeSource(256, 9, &failedDestroyed, true)), nullptr);
+    EXPECT_TRUE(failedDestroyed);
+
+    // the sources are released by the loading thread, which is done on shutdown at the latest
+    Engine::destroy(&engine);
+    EXPECT_TRUE(destroyed);
+}
+
+class TextureStreamerFrameTest : public testing::Test {
+protected:
+    static constexpr uint32_t SIZE = 256;
+    static constexpr uint8_t LEVELS = 9;
+
+    void SetUp() override {
+        mEngine = Engine::create(Engine::Backend::NOOP);
+        mStreamer = &upcast(mEngine)->getTextureStreamer();
+        mStreamer->setConfig({ .residentSize = 64 });
+
+        mTexture = mStreamer->createTexture(new FakeSource(SIZE, LEVELS, &mSourceDestroyed));
+        ASSERT_NE(mTexture, nullptr);
+
+        // any material with a 2D sampler will do
+        mMaterial = Material::Builder()
+                .package(MATERIALS_BLITLOW_DATA, MATERIALS_BLITLOW_SIZE)
+                .build(*mEngine);
+        mMaterialInstance = mMaterial->createInstance();
+        mMaterialInstance->setParameter("color", mTexture, TextureSampler{});
+    }
+
+    void TearDown() override {
+        mEngine->destroy(mMaterialInstance);
+        mEngine->destroy(mMaterial);
+        mEngine->destroy(mTexture);
+        Engine::destroy(&mEngine);
+        EXPECT_TRUE(mSourceDestroyed);
+    }
+
+    // Runs a frame in which the material instance covers `footprint` pixels, the way
+    // Renderer::beginFrame() and render() drive the streamer.
+    void frame(float footprint) {
+        FEngine& engine = *upcast(mEngine);
+        mStreamer->update(engine.getDriverApi());
+        engine.prepare();
+
+        if (footprint > 0.0f) {
+            // with this orthographic camera, a unit sphere covers the viewport's height
+            CameraInfo camera;
+            FRenderPrimitive primitive;
+            primitive.setMaterialInstance(upcast(mMaterialInstance));
+            const float3 center{ 0.0f };
+            const float3 extent{ 1.0f, 0.0f, 0.0f };
+            const utils::Slice<FRenderPrimitive> primitives(&primitive, 1);
+            mStreamer->prepareView(&center, &extent, &primitives, { 0, 1 }, camera,
+                    { 0, 0, uint32_t(footprint), uint32_t(footprint) });
+        }
+        mEngine->flushAndWait();
+    }
+
+    // Runs frames until the texture's resident level is `level`, returns false if it never is.
+    bool streamTo(size_t level, float footprint) {
+        for (size_t i = 0; i < 1000; i++) {
+            frame(footprint);
+            if (mStreamer->getResidentLevel(upcast(mTexture)) == level &&
+                    !mStreamer->getPendingCount()) {
+                return true;
+            }
+            // the levels are loaded by the streamer's thread
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    // handle the material instance samples the texture with
+    backend::Handle<backend::HwTexture> getSampledHandle() const {
+        FMaterialInstance const* const mi = upcast(mMaterialInstance);
+        EXPECT_EQ(mi->getStreamedSamplers().size(), 1);
+        return mi->getSamplerGroup().getSamplers()[mi->getStreamedSamplers()[0].index].t;
+    }
+
+    size_t getSize(uint8_t baseLevel) const {
+        return FTextureStreamer::computeSize(TextureFormat::RGBA8, SIZE, SIZE, baseLevel, LEVELS);
+    }
+
+    Engine* mEngine = nullptr;
+    FTextureStreamer* mStreamer = nullptr;
+    Texture* mTexture = nullptr;
+    Material* mMaterial = nullptr;
+    MaterialInstance* mMaterialInstance = nullptr;
+    bool mSourceDestroyed = false;
+};
+
+TEST_F(TextureStreamerFrameTest, PromotesVisibleTextures) {
+    const backend::Handle<backend::HwTexture> tail = upcast(mTexture)->getHwHandle();
+    EXPECT_EQ(getSampledHandle(), tail);
+
+    // not visible, the texture stays at its tail
+    for (size_t i = 0; i < 10; i++) {
+        frame(0.0f);
+    }
+    EXPECT_EQ(mStreamer->getResidentLevel(upcast(mTexture)), 2);
+    EXPECT_EQ(mStreamer->getPendingCount(), 0);
+
+    // covering 128 pixels needs level 1, loaded into a new handle that the texture and the
+    // material instance switch to once it's complete
+    ASSERT_TRUE(streamTo(1, 128.0f));
+    const backend::Handle<backend::HwTexture> level1 = upcast(mTexture)->getHwHandle();
+    EXPECT_NE(level1, tail);
+    EXPECT_EQ(getSampledHandle(), level1);
+    EXPECT_EQ(mStreamer->getResidentSize(), getSize(1));
+
+    // and 256 pixels needs level 0
+    ASSERT_TRUE(streamTo(0, 256.0f));
+    EXPECT_NE(upcast(mTexture)->getHwHandle(), level1);
+    EXPECT_EQ(getSampledHandle(), upcast(mTexture)->getHwHandle());
+    EXPECT_EQ(mStreamer->getResidentSize(), getSize(0));
+}
+
+TEST_F(TextureStreamerFrameTest, DemotesToFitTheBudget) {
+    ASSERT_TRUE(streamTo(0, 256.0f));
+    const backend::Handle<backend::HwTexture> level0 = upcast(mTexture)->getHwHandle();
+
+    // levels that are no longer needed are kept while they fit in the budget
+    for (size_t i = 0; i < 10; i++) {
+        frame(0.0f);
+    }
+    EXPECT_EQ(mStreamer->getResidentLevel(upcast(mTexture)), 0);
+
+    // a smaller budget evicts level 0, even though the texture is still visible
+    TextureStreamer::Config config = mStreamer->getConfig();
+    config.budget = getSize(1);
+    mStreamer->setConfig(config);
+    ASSERT_TRUE(streamTo(1, 256.0f));
+    EXPECT_NE(upcast(mTexture)->getHwHandle(), level0);
+    EXPECT_EQ(getSampledHandle(), upcast(mTexture)->getHwHandle());
+    EXPECT_EQ(mStreamer->getResidentSize(), getSize(1));
+
+    // the tail is never evicted
+    config.budget = 0;
+    mStreamer->setConfig(config);
+    ASSERT_TRUE(streamTo(2, 0.0f));
+    EXPECT_EQ(getSampledHandle(), upcast(mTexture)->getHwHandle());
+    EXPECT_EQ(mStreamer->getResidentSize(), getSize(2));
+}
+
+TEST_F(TextureStreamerFrameTest, InvalidSource) {
+    bool destroyed = false;
+    EXPECT_EQ(mStreamer->createTexture(new FakeSource(0, LEVELS, &destroyed)), nullptr);
+    EXPECT_TRUE(destroyed);
+}
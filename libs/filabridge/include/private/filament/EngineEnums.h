@@ -55,11 +55,17 @@ static_assert(BindingPoints::PER_MATERIAL_INSTANCE == BindingPoints::COUNT - 1,
 constexpr size_t CONFIG_MAX_LIGHT_COUNT = 256;
 constexpr size_t CONFIG_MAX_LIGHT_INDEX = CONFIG_MAX_LIGHT_COUNT - 1;
 
-// The maximum number of spot lights in a scene that can cast shadows.
+// The maximum number of spot shadow maps rendered in a given frame.
 // There is currently a limit to 14 spot shadow due to how we store the culling result
 // (see View.h).
 constexpr size_t CONFIG_MAX_SHADOW_CASTING_SPOTS = 14;
 
+// The maximum number of spot lights that have shadows in a given frame, any number of spot
+// lights can be shadow casters, but only those covering the most of the screen get a shadow map.
+// Shadow maps that aren't rendered in a frame are kept from an earlier frame.
+// This value is limited by UBO size, ES3.0 only guarantees 16 KiB (see ShadowUib).
+constexpr size_t CONFIG_MAX_SHADOWED_SPOTS = 128;
+
 // The maximum number of shadow cascades that can be used for directional lights.
 constexpr size_t CONFIG_MAX_SHADOW_CASCADES = 4;
 
@@ -144,8 +144,11 @@ struct PerViewUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
     float ssrDistance;                  // ssr world raycast distance, 0 when ssr is off
     float ssrStride;                    // ssr texel stride, >= 1.0
 
+    // the cascades' rectangles in the shadow atlas, in texture coordinates (xy: min, zw: max)
+    std::array<math::float4, CONFIG_MAX_SHADOW_CASCADES> cascadeTileRects;
+
     // bring PerViewUib to 2 KiB
-    math::float4 padding3[49];
+    math::float4 padding3[45];
 };
 
 // 2 KiB == 128 float4s
@@ -202,11 +205,14 @@ struct ShadowUib { // NOLINT(cppcoreguidelines-pro-type-member-init)
         float normalBias;
         math::float4 lightFromWorldZ;
 
+        // the shadow map's rectangle in the atlas, in texture coordinates (xy: min, zw: max)
+        math::float4 tileRect;
+
         float texelSizeAtOneMeter;
         float bulbRadiusLs;
         float nearOverFarMinusNear;
     };
-    ShadowData shadows[CONFIG_MAX_SHADOW_CASTING_SPOTS];
+    ShadowData shadows[CONFIG_MAX_SHADOWED_SPOTS];
 };
 static_assert(sizeof(ShadowUib) <= 16384, "ShadowUib exceed max UBO size");
 
@@ -541,6 +541,11 @@ public:
      */
     Package build(utils::JobSystem& jobSystem) noexcept;
 
+    /**
+     * Build the material, compiling all the shaders on the calling thread.
+     */
+    Package build() noexcept;
+
 public:
     // The methods and types below are for internal use
     /// @cond never
@@ -657,8 +662,10 @@ private:
     void writeCommonChunks(ChunkContainer& container, MaterialInfo& info) const noexcept;
     void writeSurfaceChunks(ChunkContainer& container) const noexcept;
 
+    Package buildPackage(utils::JobSystem* jobSystem) noexcept;
+
     bool generateShaders(
-            utils::JobSystem& jobSystem,
+            utils::JobSystem* jobSystem,
             const std::vector<filamat::Variant>& variants, ChunkContainer& container,
             const MaterialInfo& info) const noexcept;
 
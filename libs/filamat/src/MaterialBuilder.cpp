@@ -621,7 +621,7 @@ static void showErrorMessage(const char* materialName, filament::Variant variant
             << shaderCode;
 }
 
-bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Variant>& variants,
+bool MaterialBuilder::generateShaders(JobSystem* jobSystem, const std::vector<Variant>& variants,
         ChunkContainer& container, const MaterialInfo& info) const noexcept {
     // Create a postprocessor to optimize / compile to Spir-V if necessary.
 #ifndef FILAMAT_LITE
@@ -650,13 +650,12 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
     container.addSimpleChild<bool>(ChunkType::MaterialHasCustomDepthShader, needsStandardDepthProgram());
 
     std::atomic_bool cancelJobs(false);
-    bool firstJob = true;
 
-    for (const auto& params : mCodeGenPermutations) {
-        if (cancelJobs.load()) {
-            return false;
-        }
+    // All the variants of all the codegen permutations are independent, so they're all children
+    // of a single parent job and can run concurrently. Without a JobSystem they run in turn.
+    JobSystem::Job* parent = jobSystem ? jobSystem->createJob() : nullptr;
 
+    for (const CodeGenParams params : mCodeGenPermutations) {
         const ShaderModel shaderModel = ShaderModel(params.shaderModel);
         const TargetApi targetApi = params.targetApi;
         const TargetLanguage targetLanguage = params.targetLanguage;
@@ -669,11 +668,10 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
         const bool targetApiNeedsMsl = targetApi == TargetApi::METAL;
         const bool targetApiNeedsGlsl = targetApi == TargetApi::OPENGL;
 
-        // Set when a job fails
-        JobSystem::Job* parent = jobSystem.createJob();
-
         for (const auto& v : variants) {
-            JobSystem::Job* job = jobs::createJob(jobSystem, parent, [&]() {
+            auto compileVariant = [&, params, shaderModel,
+                    targetApi, targetLanguage, targetApiNeedsSpirv, targetApiNeedsMsl,
+                    targetApiNeedsGlsl]() {
                 if (cancelJobs.load()) {
                     return;
                 }
@@ -784,20 +782,21 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
                     metalEntries.push_back(metalEntry);
                 }
 #endif
-            });
-
-            // NOTE: We run the first job separately to work the lack of thread safety
-            //       guarantees in glslang. This library performs unguarded global
-            //       operations on first use.
-            if (firstJob) {
-                jobSystem.runAndWait(job);
-                firstJob = false;
-            } else {
-                jobSystem.run(job);
+            };
+
+            if (!jobSystem) {
+                compileVariant();
+                continue;
             }
+
+            // NOTE: glslang performs unguarded global operations on first use, these are taken
+            //       care of by GLSLTools::init(), so all jobs can be started right away.
+            jobSystem->run(jobs::createJob(*jobSystem, parent, compileVariant));
         }
+    }
 
-        jobSystem.runAndWait(parent);
+    if (jobSystem) {
+        jobSystem->runAndWait(parent);
     }
 
     if (cancelJobs.load()) {
@@ -844,7 +843,8 @@ bool MaterialBuilder::generateShaders(JobSystem& jobSystem, const std::vector<Va
 #ifndef FILAMAT_LITE
     if (!spirvEntries.empty()) {
         const bool stripInfo = !mGenerateDebugInfo;
-        container.addChild<filamat::DictionarySpirvChunk>(std::move(spirvDictionary), stripInfo);
+        container.addChild<filamat::DictionarySpirvChunk>(std::move(spirvDictionary), stripInfo,
+                jobSystem);
         container.addChild<MaterialSpirvChunk>(std::move(spirvEntries));
     }
 
@@ -912,6 +912,14 @@ MaterialBuilder& MaterialBuilder::useLegacyMorphing() noexcept {
 }
 
 Package MaterialBuilder::build(JobSystem& jobSystem) noexcept {
+    return buildPackage(&jobSystem);
+}
+
+Package MaterialBuilder::build() noexcept {
+    return buildPackage(nullptr);
+}
+
+Package MaterialBuilder::buildPackage(JobSystem* jobSystem) noexcept {
     if (materialBuilderClients == 0) {
         utils::slog.e << "Error: MaterialBuilder::init() must be called before build()."
             << utils::io::endl;
@@ -125,8 +125,11 @@ UniformInterfaceBlock const& UibGenerator::getPerViewUib() noexcept  {
             .add("ssrDistance",             1, UniformInterfaceBlock::Type::FLOAT)
             .add("ssrStride",               1, UniformInterfaceBlock::Type::FLOAT)
 
+            // shadow atlas
+            .add("cascadeTileRects",        4, UniformInterfaceBlock::Type::FLOAT4, Precision::HIGH)
+
             // bring PerViewUib to 2 KiB
-            .add("padding3", 49, UniformInterfaceBlock::Type::FLOAT4)
+            .add("padding3", 45, UniformInterfaceBlock::Type::FLOAT4)
             .build();
     return uib;
 }
@@ -156,7 +159,7 @@ UniformInterfaceBlock const& UibGenerator::getLightsUib() noexcept {
 UniformInterfaceBlock const& UibGenerator::getShadowUib() noexcept {
     static UniformInterfaceBlock uib = UniformInterfaceBlock::Builder()
             .name(ShadowUib::_name)
-            .add("shadows", CONFIG_MAX_SHADOW_CASTING_SPOTS, "ShadowData", sizeof(ShadowUib::ShadowData))
+            .add("shadows", CONFIG_MAX_SHADOWED_SPOTS, "ShadowData", sizeof(ShadowUib::ShadowData))
             .build();
     return uib;
 }
@@ -16,32 +16,55 @@
 
 #include "DictionarySpirvChunk.h"
 
+#include <utils/Log.h>
+
 #include <smolv.h>
 
 namespace filamat {
 
-DictionarySpirvChunk::DictionarySpirvChunk(BlobDictionary&& dictionary, bool stripDebugInfo) :
-        Chunk(ChunkType::DictionarySpirv), mDictionary(dictionary), mStripDebugInfo(stripDebugInfo) {
-}
-
-void DictionarySpirvChunk::flatten(Flattener& f) {
-
-    // For now, 1 is the only acceptable compression scheme.
-    f.writeUint32(1);
+DictionarySpirvChunk::DictionarySpirvChunk(BlobDictionary&& dictionary, bool stripDebugInfo,
+        utils::JobSystem* jobSystem) : Chunk(ChunkType::DictionarySpirv) {
 
     uint32_t flags = 0;
-    if (mStripDebugInfo) {
+    if (stripDebugInfo) {
         flags |= smolv::kEncodeFlagStripDebugInfo;
     }
 
-    f.writeUint32(mDictionary.getBlobCount());
-    for (size_t i = 0 ; i < mDictionary.getBlobCount() ; i++) {
-        const std::string& spirv = mDictionary.getBlob(i);
-        smolv::ByteArray compressed;
+    const size_t count = dictionary.getBlobCount();
+    mCompressedBlobs.resize(count);
+
+    auto compress = [&dictionary, flags](size_t i, std::vector<uint8_t>& compressed) {
+        const std::string& spirv = dictionary.getBlob(i);
         if (!smolv::Encode(spirv.data(), spirv.size(), compressed, flags)) {
             utils::slog.e << "Error with SPIRV compression" << utils::io::endl;
         }
+    };
+
+    if (!jobSystem) {
+        for (size_t i = 0 ; i < count ; i++) {
+            compress(i, mCompressedBlobs[i]);
+        }
+        return;
+    }
+
+    utils::JobSystem::Job* parent = jobSystem->createJob();
+    for (size_t i = 0 ; i < count ; i++) {
+        utils::JobSystem::Job* job = utils::jobs::createJob(*jobSystem, parent,
+                [&compress, &compressed = mCompressedBlobs[i], i]() {
+            compress(i, compressed);
+        });
+        jobSystem->run(job);
+    }
+    jobSystem->runAndWait(parent);
+}
+
+void DictionarySpirvChunk::flatten(Flattener& f) {
+
+    // For now, 1 is the only acceptable compression scheme.
+    f.writeUint32(1);
 
+    f.writeUint32(mCompressedBlobs.size());
+    for (const auto& compressed : mCompressedBlobs) {
         f.writeBlob((const char*) compressed.data(), compressed.size());
     }
 }
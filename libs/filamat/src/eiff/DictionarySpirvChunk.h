@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <vector>
 
+#include <utils/JobSystem.h>
+
 #include "Chunk.h"
 #include "Flattener.h"
 #include "BlobDictionary.h"
@@ -28,14 +30,16 @@ namespace filamat {
 
 class DictionarySpirvChunk final : public Chunk {
 public:
-    explicit DictionarySpirvChunk(BlobDictionary&& dictionary, bool stripDebugInfo);
+    // The blobs are compressed up-front, concurrently if a JobSystem is given.
+    DictionarySpirvChunk(BlobDictionary&& dictionary, bool stripDebugInfo,
+            utils::JobSystem* jobSystem);
     ~DictionarySpirvChunk() = default;
 
 private:
     void flatten(Flattener& f) override;
 
-    BlobDictionary mDictionary;
-    bool mStripDebugInfo;
+    // smol-v encoded blobs, flatten() can be called several times (e.g. for the dry run)
+    std::vector<std::vector<uint8_t>> mCompressedBlobs;
 };
 
 } // namespace filamat
@@ -167,6 +167,15 @@ bool GLSLTools::analyzeVertexShader(const std::string& shaderCode, ShaderModel m
 void GLSLTools::init() {
     // Each call to InitializeProcess must be matched with a call to FinalizeProcess.
     InitializeProcess();
+
+    // glslang performs unguarded global operations the first time a shader is parsed. Parse a
+    // trivial shader here so that shaders can later be compiled concurrently from any thread.
+    const char* shaderCString = "void main() { }";
+    TShader tShader(EShLanguage::EShLangFragment);
+    tShader.setStrings(&shaderCString, 1);
+    GLSLangCleaner cleaner;
+    tShader.parse(&DefaultTBuiltInResource,
+            glslangVersionFromShaderModel(ShaderModel::GL_ES_30), false, EShMsgDefault);
 }
 
 void GLSLTools::shutdown() {
@@ -36,6 +36,8 @@ enum Flags : uint32_t {
     INTERLEAVED         = 1 << 0,
     TEXCOORD_SNORM16    = 1 << 1,
     COMPRESSION         = 1 << 2,
+    // positions are normalized shorts relative to Header::aabb, instead of half floats
+    POSITION_SNORM16    = 1 << 3,
 };
 
 // Each of these fields specifies a number of bytes within the compressed data. This is ignored
@@ -271,9 +271,14 @@ MeshReader::Mesh MeshReader::loadMeshFromBuffer(filament::Engine* engine,
     VertexBuffer::AttributeType uvtype = (header->flags & TEXCOORD_SNORM16) ?
             VertexBuffer::AttributeType::SHORT2 : VertexBuffer::AttributeType::HALF2;
 
+    // quantized positions have the same size as half floats
+    VertexBuffer::AttributeType positiontype = (header->flags & POSITION_SNORM16) ?
+            VertexBuffer::AttributeType::SHORT4 : VertexBuffer::AttributeType::HALF4;
+
     vbb
-            .attribute(VertexAttribute::POSITION, 0, VertexBuffer::AttributeType::HALF4,
+            .attribute(VertexAttribute::POSITION, 0, positiontype,
                         header->offsetPosition, uint8_t(header->stridePosition))
+            .normalized(VertexAttribute::POSITION, header->flags & POSITION_SNORM16)
             .attribute(VertexAttribute::TANGENTS, 0, VertexBuffer::AttributeType::SHORT4,
                         header->offsetTangents, uint8_t(header->strideTangents))
             .attribute(VertexAttribute::COLOR, 0, VertexBuffer::AttributeType::UBYTE4,
@@ -353,6 +358,9 @@ MeshReader::Mesh MeshReader::loadMeshFromBuffer(filament::Engine* engine,
 
     RenderableManager::Builder builder(header->parts);
     builder.boundingBox(header->aabb);
+    if (header->flags & POSITION_SNORM16) {
+        builder.quantizedPositions(header->aabb);
+    }
 
     const auto defaultmi = materials.getMaterialInstance(utils::CString(DEFAULT_MATERIAL));
     for (size_t i = 0; i < header->parts; i++) {
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/SurfaceOrientation.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec2.h>
+#include <math/vec3.h>
+#include <math/vec4.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include <math.h>
+
+using namespace filament::geometry;
+using namespace filament::math;
+using namespace utils;
+
+// A wavy grid of GRID x GRID vertices, i.e. a bit more than a million triangles, similar to a
+// photogrammetry scan.
+static constexpr uint32_t GRID = 725;
+
+struct Mesh {
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> uvs;
+    std::vector<uint3> triangles;
+};
+
+static Mesh createMesh() {
+    Mesh mesh;
+    for (uint32_t y = 0; y < GRID; y++) {
+        for (uint32_t x = 0; x < GRID; x++) {
+            const float u = float(x) / (GRID - 1);
+            const float v = float(y) / (GRID - 1);
+            const float h = 0.05f * sinf(u * 40.0f) * cosf(v * 30.0f);
+            mesh.positions.push_back({ u, v, h });
+            mesh.normals.push_back(normalize(float3{ -2.0f * cosf(u * 40.0f) * cosf(v * 30.0f),
+                    1.5f * sinf(u * 40.0f) * sinf(v * 30.0f), 1.0f }));
+            mesh.uvs.push_back({ u, v });
+        }
+    }
+    for (uint32_t y = 0; y < GRID - 1; y++) {
+        for (uint32_t x = 0; x < GRID - 1; x++) {
+            const uint32_t i = y * GRID + x;
+            mesh.triangles.push_back({ i, i + 1, i + GRID });
+            mesh.triangles.push_back({ i + 1, i + GRID + 1, i + GRID });
+        }
+    }
+    return mesh;
+}
+
+// Builds the tangent frames of the mesh and packs them as done for a TANGENTS vertex attribute.
+// The argument selects the method: 0 for normals only, 1 for normals and uvs.
+static void buildQuats(benchmark::State& state, JobSystem* js) {
+    const Mesh mesh = createMesh();
+    const bool withUvs = state.range(0) != 0;
+    std::vector<short4> quats(mesh.positions.size());
+    for (auto _ : state) {
+        SurfaceOrientation::Builder builder;
+        builder.vertexCount(mesh.positions.size())
+                .normals(mesh.normals.data())
+                .jobSystem(js);
+        if (withUvs) {
+            builder.uvs(mesh.uvs.data())
+                    .positions(mesh.positions.data())
+                    .triangleCount(mesh.triangles.size())
+                    .triangles(mesh.triangles.data());
+        }
+        std::unique_ptr<SurfaceOrientation> orientation(builder.build());
+        orientation->getQuats(quats.data(), quats.size());
+        benchmark::DoNotOptimize(quats.data());
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) *
+            int64_t(withUvs ? mesh.triangles.size() : mesh.positions.size()));
+}
+
+static void BM_SurfaceOrientation(benchmark::State& state) {
+    buildQuats(state, nullptr);
+}
+
+static void BM_SurfaceOrientationJobSystem(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+    buildQuats(state, &js);
+    js.emancipate();
+}
+
+BENCHMARK(BM_SurfaceOrientation)->ArgName("uvs")->Arg(0)->Arg(1)
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SurfaceOrientationJobSystem)->ArgName("uvs")->Arg(0)->Arg(1)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -23,6 +23,10 @@
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace filament {
 
 /**
@@ -84,6 +88,13 @@ public:
         Builder& triangles(const filament::math::uint3*) noexcept;
         Builder& triangles(const filament::math::ushort3*) noexcept;
 
+        /**
+         * Splits the work of build() into jobs when the mesh is large enough. The calling thread
+         * must belong to the JobSystem, e.g. it can be a job itself or the Engine's main thread.
+         * By default, build() runs entirely on the calling thread.
+         */
+        Builder& jobSystem(utils::JobSystem* jobSystem) noexcept;
+
         /**
          * Generates quats or returns null if the submitted data is an incomplete combination.
          */
@@ -19,6 +19,8 @@
 
 #include <utils/compiler.h>
 
+#include <math/vec3.h>
+
 #include <stddef.h>
 #include <stdint.h>
 
@@ -54,6 +56,9 @@ enum class ComponentType {
  * transcode(outputPtr, inputPtr, count);
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  *
+ * The reverse conversion, from floats into compact formats, is done with encode() and
+ * encodePositions().
+ *
  * The interpretation of signed normalized data is consistent with Vulkan and OpenGL ES 3.0+.
  * Note that this slightly differs from earlier versions of OpenGL ES.  For example, a signed byte
  * value of -127 maps exactly to -1.0f under ES3 and VK rules, but not ES2.
@@ -94,6 +99,44 @@ public:
     size_t operator()(float* UTILS_RESTRICT target, void const* UTILS_RESTRICT source,
             size_t count) const noexcept;
 
+    /**
+     * Converts tightly packed 32-bit floating point values into the format described by the
+     * config, i.e. the reverse of operator(). In this direction inputStrideBytes is the stride of
+     * the target, which allows writing into interleaved vertex data.
+     *
+     * Normalized values are clamped to [-1, 1] for signed types and [0, 1] for unsigned types,
+     * other values are clamped to the range of the type. Both are rounded to the nearest
+     * representable value.
+     *
+     * If target is non-null, writes "count" items into target and returns the number of bytes
+     * they span. If target is null, returns the number of bytes required.
+     *
+     * @param target Client owned area to write into, or null for a size query
+     * @param source Tightly packed floats to read from (does not get retained)
+     * @param count The number of items to write (i.e. number of float2 values, not floats)
+     * @return Number of bytes required to contain "count" items after conversion
+     */
+    size_t encode(void* UTILS_RESTRICT target, float const* UTILS_RESTRICT source,
+            size_t count) const noexcept;
+
+    /**
+     * Quantizes positions into normalized SHORT4 values relative to a box, which is 8 bytes
+     * instead of 12 per position with a uniform precision over the box. The positions map back
+     * to `center + position.xyz * halfExtent`, see
+     * filament::RenderableManager::Builder::quantizedPositions(). The w component is set to 1.
+     *
+     * @param target Client owned area of 4 * count shorts, or null for a size query
+     * @param source float3 positions to read from (does not get retained)
+     * @param count The number of positions to write
+     * @param sourceStrideBytes Stride of the source, 0 if the positions are tightly packed
+     * @param center Center of the box, typically of the bounding box of the positions
+     * @param halfExtent Half-extent of the box, positions outside of the box are clamped
+     * @return Number of bytes required to contain "count" quantized positions
+     */
+    static size_t encodePositions(int16_t* UTILS_RESTRICT target,
+            void const* UTILS_RESTRICT source, size_t count, uint32_t sourceStrideBytes,
+            math::float3 center, math::float3 halfExtent) noexcept;
+
 private:
     const Config mConfig;
 };
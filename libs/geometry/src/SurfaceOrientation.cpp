@@ -16,12 +16,14 @@
 
 #include <geometry/SurfaceOrientation.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/debug.h>
 
 #include <math/mat3.h>
 #include <math/norm.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace filament {
@@ -29,8 +31,16 @@ namespace geometry {
 
 using namespace filament::math;
 using std::vector;
+using utils::JobSystem;
 using Builder = SurfaceOrientation::Builder;
 
+// Smallest amount of work worth a job, below that build() runs on the calling thread.
+static constexpr size_t MIN_VERTICES_PER_JOB = 16 * 1024;
+static constexpr size_t MIN_TRIANGLES_PER_JOB = 16 * 1024;
+
+// Triangles are accumulated into one partial sum buffer per job, each costing 24 bytes per vertex.
+static constexpr size_t MAX_PARTIAL_SUMS = 8;
+
 struct OrientationBuilderImpl {
     size_t vertexCount = 0;
     const float3* normals = nullptr;
@@ -44,6 +54,7 @@ struct OrientationBuilderImpl {
     size_t uvStride = 0;
     size_t positionStride = 0;
     size_t triangleCount = 0;
+    JobSystem* js = nullptr;
     SurfaceOrientation* buildWithNormalsOnly();
     SurfaceOrientation* buildWithSuppliedTangents();
     SurfaceOrientation* buildWithUvs();
@@ -111,6 +122,11 @@ Builder& Builder::triangles(const ushort3* triangles) noexcept {
     return *this;
 }
 
+Builder& Builder::jobSystem(JobSystem* jobSystem) noexcept {
+    mImpl->js = jobSystem;
+    return *this;
+}
+
 SurfaceOrientation* Builder::build() {
     if (!ASSERT_PRECONDITION_NON_FATAL(mImpl->vertexCount > 0, "Vertex count must be non-zero.")) {
         return nullptr;
@@ -152,19 +168,33 @@ static float3 randomPerp(const float3& n) {
     return perp / sqrlen;
 }
 
+// Calls func(start, count) over [0, count), split into jobs if a JobSystem is available.
+template<typename FUNC>
+static void parallelFor(JobSystem* js, size_t count, FUNC func) {
+    if (!js || count < MIN_VERTICES_PER_JOB * 2) {
+        func(0, count);
+        return;
+    }
+    auto* job = utils::jobs::parallel_for(*js, nullptr, 0, uint32_t(count),
+            [&func](uint32_t start, uint32_t count) { func(start, count); },
+            utils::jobs::CountSplitter<MIN_VERTICES_PER_JOB, 8>());
+    js->runAndWait(job);
+}
+
 SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
     vector<quatf> quats(vertexCount);
 
-    const float3* normal = this->normals;
+    const uint8_t* normalData = (const uint8_t*) this->normals;
     size_t nstride = this->normalStride ? this->normalStride : sizeof(float3);
 
-    for (size_t qindex = 0; qindex < vertexCount; ++qindex) {
-        float3 n = *normal;
-        float3 b = randomPerp(n);
-        float3 t = cross(n, b);
-        quats[qindex] = mat3f::packTangentFrame({t, b, n});
-        normal = (const float3*) (((const uint8_t*) normal) + nstride);
-    }
+    parallelFor(js, vertexCount, [&](size_t start, size_t count) {
+        for (size_t qindex = start, end = start + count; qindex < end; ++qindex) {
+            float3 n = *(const float3*) (normalData + qindex * nstride);
+            float3 b = randomPerp(n);
+            float3 t = cross(n, b);
+            quats[qindex] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
 
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
@@ -172,29 +202,28 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithNormalsOnly() {
 SurfaceOrientation* OrientationBuilderImpl::buildWithSuppliedTangents() {
     vector<quatf> quats(vertexCount);
 
-    const float3* normal = this->normals;
+    const uint8_t* normalData = (const uint8_t*) this->normals;
     size_t nstride = this->normalStride ? this->normalStride : sizeof(float3);
 
-    const float3* tanvec = (const float3*) this->tangents;
-    const float* tandir = &this->tangents->w;
+    const uint8_t* tangentData = (const uint8_t*) this->tangents;
     size_t tstride = this->tangentStride ? this->tangentStride : sizeof(float4);
 
-    for (size_t qindex = 0; qindex < vertexCount; ++qindex) {
-        float3 n = *normal;
-        float3 t = *tanvec;
-        float3 b = *tandir > 0 ? cross(t, n) : cross(n, t);
-
-        // Some assets do not provide perfectly orthogonal tangents and normals, so we adjust the
-        // tangent to enforce orthonormality. We would rather honor the exact normal vector than
-        // the exact tangent vector since the latter is only used for bump mapping and anisotropic
-        // lighting.
-        t = *tandir > 0 ? cross(n, b) : cross(b, n);
-
-        quats[qindex] = mat3f::packTangentFrame({t, b, n});
-        normal = (const float3*) (((const uint8_t*) normal) + nstride);
-        tanvec = (const float3*) (((const uint8_t*) tanvec) + tstride);
-        tandir = (const float*) (((const uint8_t*) tandir) + tstride);
-    }
+    parallelFor(js, vertexCount, [&](size_t start, size_t count) {
+        for (size_t qindex = start, end = start + count; qindex < end; ++qindex) {
+            float3 n = *(const float3*) (normalData + qindex * nstride);
+            float4 tangent = *(const float4*) (tangentData + qindex * tstride);
+            float3 t = tangent.xyz;
+            float3 b = tangent.w > 0 ? cross(t, n) : cross(n, t);
+
+            // Some assets do not provide perfectly orthogonal tangents and normals, so we adjust
+            // the tangent to enforce orthonormality. We would rather honor the exact normal vector
+            // than the exact tangent vector since the latter is only used for bump mapping and
+            // anisotropic lighting.
+            t = tangent.w > 0 ? cross(n, b) : cross(b, n);
+
+            quats[qindex] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
 
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
@@ -221,67 +250,91 @@ SurfaceOrientation* OrientationBuilderImpl::buildWithUvs() {
     if (!ASSERT_PRECONDITION_NON_FATAL(this->positionStride == 0, "Non-zero positions stride not yet supported.")) {
         return nullptr;
     }
-    vector<float3> tan1(vertexCount);
-    vector<float3> tan2(vertexCount);
-    memset(tan1.data(), 0, sizeof(float3) * vertexCount);
-    memset(tan2.data(), 0, sizeof(float3) * vertexCount);
-    for (size_t a = 0; a < triangleCount; ++a) {
-        uint3 tri = triangles16 ? uint3(triangles16[a]) : triangles32[a];
-        assert_invariant(tri.x < vertexCount && tri.y < vertexCount && tri.z < vertexCount);
-        const float3& v1 = positions[tri.x];
-        const float3& v2 = positions[tri.y];
-        const float3& v3 = positions[tri.z];
-        const float2& w1 = uvs[tri.x];
-        const float2& w2 = uvs[tri.y];
-        const float2& w3 = uvs[tri.z];
-        float x1 = v2.x - v1.x;
-        float x2 = v3.x - v1.x;
-        float y1 = v2.y - v1.y;
-        float y2 = v3.y - v1.y;
-        float z1 = v2.z - v1.z;
-        float z2 = v3.z - v1.z;
-        float s1 = w2.x - w1.x;
-        float s2 = w3.x - w1.x;
-        float t1 = w2.y - w1.y;
-        float t2 = w3.y - w1.y;
-        float d = s1 * t2 - s2 * t1;
-        float3 sdir, tdir;
-        // In general we can't guarantee smooth tangents when the UV's are non-smooth, but let's at
-        // least avoid divide-by-zero and fall back to normals-only method.
-        if (d == 0.0) {
-            const float3& n1 = normals[tri.x];
-            sdir = randomPerp(n1);
-            tdir = cross(n1, sdir);
-        } else {
-            sdir = {t2 * x1 - t1 * x2, t2 * y1 - t1 * y2, t2 * z1 - t1 * z2};
-            tdir = {s1 * x2 - s2 * x1, s1 * y2 - s2 * y1, s1 * z2 - s2 * z1};
-            float r = 1.0f / d;
-            sdir *= r;
-            tdir *= r;
+
+    // Large meshes are split into ranges of triangles, each accumulated into its own partial sums
+    // by a job. The partial sums are then reduced per vertex, in the same pass that computes the
+    // final tangent frames.
+    size_t partialCount = 1;
+    if (js && triangleCount >= MIN_TRIANGLES_PER_JOB * 2) {
+        partialCount = std::min({ js->getThreadCount() + 1, MAX_PARTIAL_SUMS,
+                triangleCount / MIN_TRIANGLES_PER_JOB });
+    }
+
+    struct TangentSums {
+        float3 sdir;
+        float3 tdir;
+    };
+    vector<TangentSums> sums(vertexCount * partialCount);
+
+    auto accumulate = [this](TangentSums* out, size_t first, size_t last) {
+        for (size_t a = first; a < last; ++a) {
+            const uint3 tri = triangles16 ? uint3(triangles16[a]) : triangles32[a];
+            assert_invariant(tri.x < vertexCount && tri.y < vertexCount && tri.z < vertexCount);
+            const float3 v1 = positions[tri.x];
+            const float3 e1 = positions[tri.y] - v1;
+            const float3 e2 = positions[tri.z] - v1;
+            const float2 w1 = uvs[tri.x];
+            const float2 f1 = uvs[tri.y] - w1;
+            const float2 f2 = uvs[tri.z] - w1;
+            const float d = f1.x * f2.y - f2.x * f1.y;
+            float3 sdir, tdir;
+            // In general we can't guarantee smooth tangents when the UV's are non-smooth, but let's
+            // at least avoid divide-by-zero and fall back to normals-only method.
+            if (UTILS_UNLIKELY(d == 0.0f)) {
+                const float3& n1 = normals[tri.x];
+                sdir = randomPerp(n1);
+                tdir = cross(n1, sdir);
+            } else {
+                const float r = 1.0f / d;
+                sdir = (f2.y * e1 - f1.y * e2) * r;
+                tdir = (f1.x * e2 - f2.x * e1) * r;
+            }
+            out[tri.x].sdir += sdir;
+            out[tri.y].sdir += sdir;
+            out[tri.z].sdir += sdir;
+            out[tri.x].tdir += tdir;
+            out[tri.y].tdir += tdir;
+            out[tri.z].tdir += tdir;
+        }
+    };
+
+    if (partialCount == 1) {
+        accumulate(sums.data(), 0, triangleCount);
+    } else {
+        JobSystem::Job* parent = js->createJob();
+        for (size_t p = 0; p < partialCount; ++p) {
+            TangentSums* partial = sums.data() + p * vertexCount;
+            const size_t first = triangleCount * p / partialCount;
+            const size_t last = triangleCount * (p + 1) / partialCount;
+            js->run(utils::jobs::createJob(*js, parent, [&accumulate, partial, first, last] {
+                accumulate(partial, first, last);
+            }));
         }
-        tan1[tri.x] += sdir;
-        tan1[tri.y] += sdir;
-        tan1[tri.z] += sdir;
-        tan2[tri.x] += tdir;
-        tan2[tri.y] += tdir;
-        tan2[tri.z] += tdir;
+        js->runAndWait(parent);
     }
 
     vector<quatf> quats(vertexCount);
-    for (size_t a = 0; a < vertexCount; a++) {
-        const float3& n = normals[a];
-        const float3& t1 = tan1[a];
-        const float3& t2 = tan2[a];
+    parallelFor(js, vertexCount, [&](size_t start, size_t count) {
+        for (size_t a = start, end = start + count; a < end; a++) {
+            float3 t1 = sums[a].sdir;
+            float3 t2 = sums[a].tdir;
+            for (size_t p = 1; p < partialCount; ++p) {
+                t1 += sums[a + p * vertexCount].sdir;
+                t2 += sums[a + p * vertexCount].tdir;
+            }
 
-        // Gram-Schmidt orthogonalize
-        float3 t = normalize(t1 - n * dot(n, t1));
+            const float3& n = normals[a];
 
-        // Calculate handedness
-        float w = (dot(cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
+            // Gram-Schmidt orthogonalize
+            float3 t = normalize(t1 - n * dot(n, t1));
 
-        float3 b = w < 0 ? cross(t, n) : cross(n, t);
-        quats[a] = mat3f::packTangentFrame({t, b, n});
-    }
+            // Calculate handedness
+            float w = (dot(cross(n, t1), t2) < 0.0f) ? -1.0f : 1.0f;
+
+            float3 b = w < 0 ? cross(t, n) : cross(n, t);
+            quats[a] = mat3f::packTangentFrame({t, b, n});
+        }
+    });
     return new SurfaceOrientation(new OrientationImpl( { std::move(quats) } ));
 }
 
@@ -18,7 +18,12 @@
 
 #include <math/half.h>
 
+#include <algorithm>
+
+#include <math.h>
+
 using filament::math::half;
+using filament::math::float3;
 
 namespace filament {
 namespace geometry {
@@ -85,6 +90,22 @@ void convertClamped(float* UTILS_RESTRICT target, void const* UTILS_RESTRICT sou
     }
 }
 
+// The reverse of "convert", which takes packed floats and produces an arbitrary type. Values are
+// rounded, then clamped to [MIN_VALUE, MAX_VALUE], which is either the range of the type or the
+// range of its normalized values (e.g. -128 is not a valid normalized BYTE).
+template<typename TARGET_TYPE, int NORMALIZATION_FACTOR, int MIN_VALUE, int MAX_VALUE>
+void convertFromFloats(void* UTILS_RESTRICT target, float const* UTILS_RESTRICT source,
+        size_t count, int componentCount, int dstStride) noexcept {
+    uint8_t* dstBytes = (uint8_t*) target;
+    for (size_t i = 0; i < count; ++i, source += componentCount, dstBytes += dstStride) {
+        TARGET_TYPE* dst = (TARGET_TYPE*) dstBytes;
+        for (int n = 0; n < componentCount; ++n) {
+            const float value = roundf(source[n] * float(NORMALIZATION_FACTOR));
+            dst[n] = TARGET_TYPE(std::min(std::max(value, float(MIN_VALUE)), float(MAX_VALUE)));
+        }
+    }
+}
+
 size_t Transcoder::operator()(float* UTILS_RESTRICT target, void const* UTILS_RESTRICT source,
         size_t count) const noexcept {
     const size_t required = count * mConfig.componentCount * sizeof(float);
@@ -192,5 +213,99 @@ size_t Transcoder::operator()(float* UTILS_RESTRICT target, void const* UTILS_RE
     return 0;
 }
 
+size_t Transcoder::encode(void* UTILS_RESTRICT target, float const* UTILS_RESTRICT source,
+        size_t count) const noexcept {
+    const uint32_t comp = mConfig.componentCount;
+    const bool normalized = mConfig.normalized;
+    switch (mConfig.componentType) {
+        case ComponentType::BYTE: {
+            const uint32_t stride = mConfig.inputStrideBytes ? mConfig.inputStrideBytes : comp;
+            if (target) {
+                if (normalized) {
+                    convertFromFloats<int8_t, 127, -127, 127>(target, source, count, comp, stride);
+                } else {
+                    convertFromFloats<int8_t, 1, -128, 127>(target, source, count, comp, stride);
+                }
+            }
+            return count * stride;
+        }
+        case ComponentType::UBYTE: {
+            const uint32_t stride = mConfig.inputStrideBytes ? mConfig.inputStrideBytes : comp;
+            if (target) {
+                if (normalized) {
+                    convertFromFloats<uint8_t, 255, 0, 255>(target, source, count, comp, stride);
+                } else {
+                    convertFromFloats<uint8_t, 1, 0, 255>(target, source, count, comp, stride);
+                }
+            }
+            return count * stride;
+        }
+        case ComponentType::SHORT: {
+            const uint32_t stride = mConfig.inputStrideBytes ? mConfig.inputStrideBytes : (2 * comp);
+            if (target) {
+                if (normalized) {
+                    convertFromFloats<int16_t, 32767, -32767, 32767>(
+                            target, source, count, comp, stride);
+                } else {
+                    convertFromFloats<int16_t, 1, -32768, 32767>(
+                            target, source, count, comp, stride);
+                }
+            }
+            return count * stride;
+        }
+        case ComponentType::USHORT: {
+            const uint32_t stride = mConfig.inputStrideBytes ? mConfig.inputStrideBytes : (2 * comp);
+            if (target) {
+                if (normalized) {
+                    convertFromFloats<uint16_t, 65535, 0, 65535>(
+                            target, source, count, comp, stride);
+                } else {
+                    convertFromFloats<uint16_t, 1, 0, 65535>(target, source, count, comp, stride);
+                }
+            }
+            return count * stride;
+        }
+        case ComponentType::HALF: {
+            const uint32_t stride = mConfig.inputStrideBytes ? mConfig.inputStrideBytes : (2 * comp);
+            if (target) {
+                uint8_t* dstBytes = (uint8_t*) target;
+                for (size_t i = 0; i < count; ++i, source += comp, dstBytes += stride) {
+                    half* dst = (half*) dstBytes;
+                    for (int n = 0; n < comp; ++n) {
+                        dst[n] = half(source[n]);
+                    }
+                }
+            }
+            return count * stride;
+        }
+    }
+    return 0;
+}
+
+size_t Transcoder::encodePositions(int16_t* UTILS_RESTRICT target,
+        void const* UTILS_RESTRICT source, size_t count, uint32_t sourceStrideBytes,
+        float3 center, float3 halfExtent) noexcept {
+    const size_t required = count * 4 * sizeof(int16_t);
+    if (target == nullptr) {
+        return required;
+    }
+    // a flat box quantizes its flat axes to 0
+    const float3 scale{
+            halfExtent.x > 0.0f ? 32767.0f / halfExtent.x : 0.0f,
+            halfExtent.y > 0.0f ? 32767.0f / halfExtent.y : 0.0f,
+            halfExtent.z > 0.0f ? 32767.0f / halfExtent.z : 0.0f };
+    const uint32_t stride = sourceStrideBytes ? sourceStrideBytes : sizeof(float3);
+    uint8_t const* srcBytes = (uint8_t const*) source;
+    for (size_t i = 0; i < count; ++i, target += 4, srcBytes += stride) {
+        float const* src = (float const*) srcBytes;
+        for (int n = 0; n < 3; ++n) {
+            const float value = roundf((src[n] - center[n]) * scale[n]);
+            target[n] = int16_t(std::min(std::max(value, -32767.0f), 32767.0f));
+        }
+        target[3] = 32767;
+    }
+    return required;
+}
+
 } // namespace geometry
 } // namespace filament
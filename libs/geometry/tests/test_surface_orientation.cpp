@@ -0,0 +1,94 @@
+/*
+ * Copyright 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <geometry/SurfaceOrientation.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <math.h>
+
+using namespace filament::geometry;
+using namespace filament::math;
+using utils::JobSystem;
+
+class SurfaceOrientationTest : public testing::Test {};
+
+// Large enough for the work to be split into jobs.
+static constexpr uint32_t GRID = 256;
+
+static std::vector<quatf> build(JobSystem* js, bool withUvs) {
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> uvs;
+    std::vector<uint3> triangles;
+    for (uint32_t y = 0; y < GRID; y++) {
+        for (uint32_t x = 0; x < GRID; x++) {
+            const float u = float(x) / (GRID - 1);
+            const float v = float(y) / (GRID - 1);
+            positions.push_back({ u, v, 0.1f * sinf(u * 10.0f) });
+            normals.push_back(normalize(float3{ -cosf(u * 10.0f), 0, 1 }));
+            // every other row has a constant v, which exercises the degenerate uv fallback
+            uvs.push_back({ u, (y & 2) ? v : 0.0f });
+        }
+    }
+    for (uint32_t y = 0; y < GRID - 1; y++) {
+        for (uint32_t x = 0; x < GRID - 1; x++) {
+            const uint32_t i = y * GRID + x;
+            triangles.push_back({ i, i + 1, i + GRID });
+            triangles.push_back({ i + 1, i + GRID + 1, i + GRID });
+        }
+    }
+
+    SurfaceOrientation::Builder builder;
+    builder.vertexCount(positions.size()).normals(normals.data()).jobSystem(js);
+    if (withUvs) {
+        builder.uvs(uvs.data())
+                .positions(positions.data())
+                .triangleCount(triangles.size())
+                .triangles(triangles.data());
+    }
+    std::unique_ptr<SurfaceOrientation> orientation(builder.build());
+    std::vector<quatf> quats(orientation->getVertexCount());
+    orientation->getQuats(quats.data(), quats.size());
+    return quats;
+}
+
+static void expectSameQuats(std::vector<quatf> const& a, std::vector<quatf> const& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        // the partial sums are added in a different order, so allow for rounding
+        EXPECT_NEAR(a[i].x, b[i].x, 1e-4f) << "vertex " << i;
+        EXPECT_NEAR(a[i].y, b[i].y, 1e-4f) << "vertex " << i;
+        EXPECT_NEAR(a[i].z, b[i].z, 1e-4f) << "vertex " << i;
+        EXPECT_NEAR(a[i].w, b[i].w, 1e-4f) << "vertex " << i;
+    }
+}
+
+TEST_F(SurfaceOrientationTest, JobSystemMatchesSerial) {
+    JobSystem js;
+    js.adopt();
+    expectSameQuats(build(nullptr, false), build(&js, false));
+    expectSameQuats(build(nullptr, true), build(&js, true));
+    js.emancipate();
+}
@@ -124,6 +124,106 @@ TEST_F(TranscoderTest, NonNormalized) {
     ASSERT_EQ(result[1], 1.0f);
 }
 
+TEST_F(TranscoderTest, Encode) {
+    const float uvs[] = { 0.0f, 1.0f, 0.25f, 2.0f, -0.5f, 0.5f };
+    uint16_t encoded[6];
+    float decoded[6];
+
+    // UNSIGNED NORMALIZED SHORTS, out of range values are clamped
+
+    Transcoder unorm16({
+        .componentType = ComponentType::USHORT,
+        .normalized = true,
+        .componentCount = 2u
+    });
+
+    ASSERT_EQ(unorm16.encode(nullptr, uvs, 3), sizeof(encoded));
+    ASSERT_EQ(unorm16.encode(encoded, uvs, 3), sizeof(encoded));
+    ASSERT_EQ(encoded[0], 0);
+    ASSERT_EQ(encoded[1], 65535);
+    ASSERT_EQ(encoded[2], 16384);
+    ASSERT_EQ(encoded[3], 65535);
+    ASSERT_EQ(encoded[4], 0);
+
+    unorm16(decoded, encoded, 3);
+    ASSERT_NEAR(decoded[2], 0.25f, 1.0f / 65535.0f);
+    ASSERT_NEAR(decoded[5], 0.5f, 1.0f / 65535.0f);
+
+    // SIGNED NORMALIZED BYTES, written into interleaved data
+
+    Vertex vertices[count] = {};
+    const float normals[] = { -1.0f, 0.5f, 1.0f, -2.0f, 0.0f, 0.999f };
+    Transcoder snorm8({
+        .componentType = ComponentType::BYTE,
+        .normalized = true,
+        .componentCount = 3u,
+        .inputStrideBytes = sizeof(Vertex)
+    });
+
+    snorm8.encode(&vertices[0].b0, normals, count);
+    ASSERT_EQ(int8_t(vertices[0].b0), -127);
+    ASSERT_EQ(int8_t(vertices[0].b1), 64);
+    ASSERT_EQ(int8_t(vertices[0].b2), 127);
+    ASSERT_EQ(int8_t(vertices[1].b0), -127);
+    ASSERT_EQ(int8_t(vertices[1].b1), 0);
+    ASSERT_EQ(int8_t(vertices[1].b2), 127);
+    ASSERT_EQ(vertices[0].b3, 0);
+
+    // HALF
+
+    Transcoder half2({
+        .componentType = ComponentType::HALF,
+        .normalized = false,
+        .componentCount = 2u
+    });
+
+    half halfs[6];
+    half2.encode(halfs, uvs, 3);
+    ASSERT_EQ(float(halfs[3]), 2.0f);
+    ASSERT_EQ(float(halfs[4]), -0.5f);
+}
+
+TEST_F(TranscoderTest, EncodePositions) {
+    const float positions[] = {
+        -1.0f, 10.0f, 5.0f,
+         3.0f, 12.0f, 5.0f,
+         1.0f, 11.0f, 5.0f,
+    };
+    const filament::math::float3 center{ 1.0f, 11.0f, 5.0f };
+    const filament::math::float3 halfExtent{ 2.0f, 1.0f, 0.0f };
+
+    int16_t quantized[3 * 4];
+    ASSERT_EQ(Transcoder::encodePositions(nullptr, positions, 3, 0, center, halfExtent),
+            sizeof(quantized));
+    Transcoder::encodePositions(quantized, positions, 3, 0, center, halfExtent);
+
+    // the corners of the box map to -1 and 1, the flat axis to 0, w is 1
+    const int16_t expected[] = {
+        -32767, -32767, 0, 32767,
+         32767,  32767, 0, 32767,
+             0,      0, 0, 32767,
+    };
+    for (size_t i = 0; i < 12; i++) {
+        ASSERT_EQ(quantized[i], expected[i]);
+    }
+
+    // the positions can be decoded as normalized shorts, then mapped back to the box
+    float decoded[3 * 4];
+    Transcoder snorm16({
+        .componentType = ComponentType::SHORT,
+        .normalized = true,
+        .componentCount = 4u
+    });
+    snorm16(decoded, quantized, 3);
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t n = 0; n < 3; n++) {
+            const float position = center[n] + decoded[i * 4 + n] * halfExtent[n];
+            ASSERT_NEAR(position, positions[i * 3 + n], 1e-4f);
+        }
+        ASSERT_EQ(decoded[i * 4 + 3], 1.0f);
+    }
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
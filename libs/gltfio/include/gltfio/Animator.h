@@ -42,16 +42,66 @@ public:
      * Applies rotation, translation, and scale to entities that have been targeted by the given
      * animation definition. Uses filament::TransformManager.
      *
+     * Targets are evaluated in parallel using the Engine's JobSystem, and their transforms are
+     * set within a local transform transaction, which is committed before returning.
+     * This must be called from the thread that owns the Engine.
+     *
      * @param animationIndex Zero-based index for the \c animation of interest.
      * @param time Elapsed time of interest in seconds.
      */
     void applyAnimation(size_t animationIndex, float time) const;
 
+    /**
+     * One of the animations blended by applyAnimations().
+     */
+    struct AnimationLayer {
+        size_t animationIndex;  //!< Zero-based index for the \c animation of interest.
+        float time;             //!< Elapsed time of interest in seconds.
+        float weight;           //!< Weight of the animation in the blend, layers <= 0 are skipped.
+    };
+
+    /**
+     * Blends several animations and applies the result, in a single pass.
+     *
+     * For each node, each animated component (translation, rotation, scale and morph weights) is
+     * the weighted average of the layers that animate it. Rotations are blended with a normalized
+     * weighted sum. Components that no layer animates are left unchanged.
+     *
+     * applyAnimation(index, time) is equivalent to a single layer of weight 1.
+     *
+     * @param layers Animations to blend.
+     * @param count Number of layers.
+     */
+    void applyAnimations(const AnimationLayer* layers, size_t count) const;
+
+    /**
+     * Maximum error allowed for each type of channel, used by compressAnimations().
+     */
+    struct KeyframeTolerance {
+        float translation = 1e-4f;  //!< In model units.
+        float rotation = 1e-3f;     //!< In radians.
+        float scale = 1e-4f;
+        float weights = 1e-3f;      //!< Morph target weights.
+    };
+
+    /**
+     * Reduces the memory used by the animations, by removing the keyframes that can be
+     * reconstructed by interpolating the remaining keyframes within the given tolerance.
+     *
+     * Linear and step samplers are compressed, cubic spline samplers are left unchanged.
+     * The duration of the animations is preserved.
+     */
+    void compressAnimations(const KeyframeTolerance& tolerance);
+
     /**
      * Computes root-to-node transforms for all bone nodes, then passes
-     * the results into filament::RenderableManager::setBones.
+     * the results into the filament::SkinningBuffer of each skin.
      * Uses filament::TransformManager and filament::RenderableManager.
      *
+     * Bones are computed in parallel using the Engine's JobSystem. The renderables of a skin
+     * that have the same world transform share their bones, which are only uploaded when
+     * they change.
+     *
      * NOTE: this operation is independent of \c animation.
      */
     void updateBoneMatrices();
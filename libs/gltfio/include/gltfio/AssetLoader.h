@@ -60,6 +60,13 @@ struct AssetConfiguration {
 
     //! Optional default node name for anonymous nodes
     char* defaultNodeName = nullptr;
+
+    //! Stores float vertex attributes in compact formats: positions as normalized shorts relative
+    //! to the bounding box of their mesh (see RenderableManager::Builder::quantizedPositions) and
+    //! texture coordinates within [0, 1] as normalized unsigned shorts. This reduces the vertex
+    //! memory and bandwidth, at the cost of some precision. Skinned, morphed, sparse or Draco
+    //! compressed data, and texture coordinates without min/max, are left as they are.
+    bool quantizeVertices = false;
 };
 
 /**
@@ -197,6 +204,43 @@ public:
      */
     FilamentInstance* createInstance(FilamentAsset* primary);
 
+    /**
+     * Starts an incremental creation of an asset from a glTF 2.0 file (JSON or GLB).
+     *
+     * This is an alternative to createAssetFromJson and createAssetFromBinary for large scenes,
+     * which would otherwise block the calling thread until all of their entities, renderables and
+     * material instances are created. Only the root entity is created here, the nodes of the
+     * scene are created by periodic calls to #asyncUpdateCreate.
+     *
+     * The root entity can be used immediately, e.g. to position the asset, and the entities of the
+     * asset can be added to a scene as they are created. However ResourceLoader must not be used
+     * until #asyncGetCreateProgress returns 1, and FilamentAsset::releaseSourceData does nothing
+     * until then.
+     *
+     * Only one asset can be created at a time. Destroying the asset cancels its creation.
+     *
+     * @param bytes the contents of a glTF 2.0 file (JSON or GLB)
+     * @param numBytes the number of bytes in "bytes"
+     * @return the asset, or null on failure
+     */
+    FilamentAsset* asyncBeginCreate(const uint8_t* bytes, uint32_t numBytes);
+
+    /**
+     * Creates more nodes of the asset started with #asyncBeginCreate, until the given time
+     * budget is spent or all the nodes have been created. At least one node is created per call.
+     *
+     * @param budgetMs time budget of this call, in milliseconds
+     * @return false if a node could not be created, in which case the creation stops and the
+     *         client should destroy the asset
+     */
+    bool asyncUpdateCreate(float budgetMs);
+
+    /**
+     * Gets the status of an incremental asset creation as a percentage in [0,1], based on the
+     * number of nodes created so far. This is 1 when no asset is being created.
+     */
+    float asyncGetCreateProgress() const noexcept;
+
     /**
      * Allows clients to enable diagnostic shading on newly-loaded assets.
      */
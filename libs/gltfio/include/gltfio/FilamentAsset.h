@@ -230,6 +230,8 @@ public:
      * This should only be called after ResourceLoader::loadResources().
      * If using Animator, this should be called after getAnimator().
      * If this is an instanced asset, this prevents creation of new instances.
+     * If this asset is being created by AssetLoader::asyncUpdateCreate, this does nothing until
+     * all of its nodes have been created.
      */
     void releaseSourceData() noexcept;
 
@@ -23,9 +23,12 @@
 #include "upcast.h"
 
 #include <filament/MaterialEnums.h>
+#include <filament/Engine.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TransformManager.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Log.h>
 
 #include <math/mat4.h>
@@ -34,10 +37,16 @@
 #include <math/vec3.h>
 #include <math/vec4.h>
 
-#include <map>
+#include <tsl/robin_map.h>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <string>
 #include <vector>
 
+#include <string.h>
+
 using namespace filament;
 using namespace filament::math;
 using namespace std;
@@ -45,12 +54,13 @@ using namespace utils;
 
 namespace gltfio {
 
-using TimeValues = map<float, size_t>;
 using SourceValues = vector<float>;
-using BoneVector = vector<filament::math::mat4f>;
+
+// Targets of an animation (or skinned renderables) processed per job.
+static constexpr uint32_t JOBS_PARALLEL_FOR_COUNT = 64;
 
 struct Sampler {
-    TimeValues times;
+    vector<float> times;  // sorted keyframe times
     SourceValues values;
     enum { LINEAR, STEP, CUBIC } interpolation;
 };
@@ -59,6 +69,19 @@ struct Channel {
     const Sampler* sourceData;
     Entity targetEntity;
     enum { TRANSLATION, ROTATION, SCALE, WEIGHTS } transformType;
+    uint32_t cursor = 0;  // keyframe found by the last evaluation, usually valid for the next one
+};
+
+// All the channels of an animation that target the same node. They're sampled together, and
+// accumulated into the node's BlendTarget.
+struct Target {
+    static constexpr uint32_t NONE = ~0u;
+    Entity entity;
+    uint32_t blendIndex;            // index of the node in AnimatorImpl::blendTargets
+    uint32_t translation = NONE;    // index of the channel of each type, or NONE
+    uint32_t rotation = NONE;
+    uint32_t scale = NONE;
+    uint32_t weights = NONE;
 };
 
 struct Animation {
@@ -66,29 +89,79 @@ struct Animation {
     std::string name;
     vector<Sampler> samplers;
     vector<Channel> channels;
+    vector<Target> targets;
+};
+
+// A node animated by at least one of the animations, and the weighted sum of the values sampled
+// for it during an evaluation. A component's weight is zero if no layer animated it.
+struct BlendTarget {
+    Entity entity;
+    uint32_t weightsOffset = 0;     // offset of the morph weights in AnimatorImpl::morphWeights
+    uint32_t weightsCount = 0;
+    float3 translation;
+    quatf rotation;
+    float3 scale;
+    float translationWeight = 0;
+    float rotationWeight = 0;
+    float scaleWeight = 0;
+    float morphWeight = 0;
+    mat4f transform;                // result of the evaluation
+    bool hasTransform() const noexcept {
+        return translationWeight > 0 || rotationWeight > 0 || scaleWeight > 0;
+    }
+};
+
+// The bones of the targets of a skin that have the same world transform, they're stored in the
+// slot of the first of these targets.
+struct SkinPalette {
+    Skin* skin;
+    uint32_t slot;
+    mat4f worldTransform;
+    bool dirty;         // whether the bones changed since they were last uploaded
+};
+
+// A skinned renderable, and the slot of its bones.
+struct SkinTarget {
+    Skin* skin;
+    RenderableManager::Instance renderable;
+    uint32_t target;    // index in Skin::targets
+    uint32_t slot;
 };
 
 struct AnimatorImpl {
     vector<Animation> animations;
-    BoneVector boneMatrices;
+    vector<BlendTarget> blendTargets;
+    tsl::robin_map<Entity, uint32_t, std::hash<Entity>> blendTargetOfEntity;
+    vector<float> morphWeights;
+    vector<SkinPalette> skinPalettes;
+    vector<SkinTarget> skinTargets;
     FFilamentAsset* asset = nullptr;
     FFilamentInstance* instance = nullptr;
+    Engine* engine;
     RenderableManager* renderableManager;
     TransformManager* transformManager;
-    vector<float> weights;
+    JobSystem* jobSystem;
     MorphHelper* morpher;
     void addChannels(const NodeMap& nodeMap, const cgltf_animation& srcAnim, Animation& dst);
-    void applyAnimation(const Channel& channel, float t, size_t prevIndex, size_t nextIndex);
+    void applyAnimations(const Animator::AnimationLayer* layers, size_t count);
+    void accumulateTarget(Animation& anim, const Target& target, float time, float weight);
+    void resolveTarget(BlendTarget& blend);
+    void compressSamplers(Animation& anim, const Animator::KeyframeTolerance& tolerance);
+    void addSkinPalettes(SkinVector& skins);
+    void computePalettes(uint32_t first, uint32_t count);
+    template<typename F>
+    void parallelFor(uint32_t count, F const& work);
 };
 
 static void createSampler(const cgltf_animation_sampler& src, Sampler& dst) {
-    // Copy the time values into a red-black tree.
+    // Copy the time values into a flat array, glTF requires them to be strictly increasing.
     const cgltf_accessor* timelineAccessor = src.input;
     const uint8_t* timelineBlob = (const uint8_t*) timelineAccessor->buffer_view->buffer->data;
     const float* timelineFloats = (const float*) (timelineBlob + timelineAccessor->offset +
             timelineAccessor->buffer_view->offset);
-    for (size_t i = 0, len = timelineAccessor->count; i < len; ++i) {
-        dst.times[timelineFloats[i]] = i;
+    dst.times.assign(timelineFloats, timelineFloats + timelineAccessor->count);
+    if (UTILS_UNLIKELY(!std::is_sorted(dst.times.begin(), dst.times.end()))) {
+        GLTFIO_WARN("Animation keyframe times are not sorted.");
     }
 
     // Convert source data to float.
@@ -174,8 +247,10 @@ Animator::Animator(FFilamentAsset* asset, FFilamentInstance* instance) {
     mImpl = new AnimatorImpl();
     mImpl->asset = asset;
     mImpl->instance = instance;
+    mImpl->engine = asset->mEngine;
     mImpl->renderableManager = &asset->mEngine->getRenderableManager();
     mImpl->transformManager = &asset->mEngine->getTransformManager();
+    mImpl->jobSystem = &asset->mEngine->getJobSystem();
 
     const cgltf_data* srcAsset = asset->mSourceAsset->hierarchy;
     const cgltf_animation* srcAnims = srcAsset->animations;
@@ -205,7 +280,7 @@ Animator::Animator(FFilamentAsset* asset, FFilamentInstance* instance) {
             Sampler& dstSampler = dstAnim.samplers[j];
             createSampler(srcSampler, dstSampler);
             if (dstSampler.times.size() > 1) {
-                float maxtime = (--dstSampler.times.end())->first;
+                float maxtime = dstSampler.times.back();
                 dstAnim.duration = std::max(dstAnim.duration, maxtime);
             }
         }
@@ -244,91 +319,58 @@ size_t Animator::getAnimationCount() const {
 }
 
 void Animator::applyAnimation(size_t animationIndex, float time) const {
-    const Animation& anim = mImpl->animations[animationIndex];
-    TransformManager* transformManager = mImpl->transformManager;
-    RenderableManager* renderableManager = mImpl->renderableManager;
-    time = fmod(time, anim.duration);
-    for (const auto& channel : anim.channels) {
-        const Sampler* sampler = channel.sourceData;
-        if (sampler->times.size() < 2) {
-            continue;
-        }
-
-        const TimeValues& times = sampler->times;
-
-        // Find the first keyframe after the given time, or the keyframe that matches it exactly.
-        TimeValues::const_iterator iter = times.lower_bound(time);
-
-        // Compute the interpolant (between 0 and 1) and determine the keyframe pair.
-        float t = 0.0f;
-        size_t nextIndex;
-        size_t prevIndex;
-        if (iter == times.end()) {
-            nextIndex = times.size() - 1;
-            prevIndex = nextIndex;
-        } else if (iter == times.begin()) {
-            nextIndex = 0;
-            prevIndex = 0;
-        } else {
-            TimeValues::const_iterator prev = iter; --prev;
-            nextIndex = iter->second;
-            prevIndex = prev->second;
-            const float nextTime = iter->first;
-            const float prevTime = prev->first;
-            float deltaTime = nextTime - prevTime;
-            assert(deltaTime >= 0);
-            if (deltaTime > 0) {
-                t = (time - prevTime) / deltaTime;
-            }
-        }
+    const AnimationLayer layer = { animationIndex, time, 1.0f };
+    mImpl->applyAnimations(&layer, 1);
+}
 
-        if (sampler->interpolation == Sampler::STEP) {
-            t = 0.0f;
-        }
+void Animator::applyAnimations(const AnimationLayer* layers, size_t count) const {
+    mImpl->applyAnimations(layers, count);
+}
 
-        mImpl->applyAnimation(channel, t, prevIndex, nextIndex);
+void Animator::compressAnimations(const KeyframeTolerance& tolerance) {
+    for (Animation& anim : mImpl->animations) {
+        mImpl->compressSamplers(anim, tolerance);
     }
 }
 
 void Animator::updateBoneMatrices() {
-    auto renderableManager = mImpl->renderableManager;
-    auto transformManager = mImpl->transformManager;
-
-    auto update = [=](const SkinVector& skins, BoneVector& boneVector) {
-        for (const auto& skin : skins) {
-            size_t njoints = skin.joints.size();
-            boneVector.resize(njoints);
-            for (const auto& entity : skin.targets) {
-                auto renderable = renderableManager->getInstance(entity);
-                if (!renderable) {
-                    continue;
-                }
-                mat4f inverseGlobalTransform;
-                auto xformable = transformManager->getInstance(entity);
-                if (xformable) {
-                    inverseGlobalTransform = inverse(transformManager->getWorldTransform(xformable));
-                }
-                for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
-                    const auto& joint = skin.joints[boneIndex];
-                    TransformManager::Instance jointInstance = transformManager->getInstance(joint);
-                    mat4f globalJointTransform = transformManager->getWorldTransform(jointInstance);
-                    boneVector[boneIndex] =
-                            inverseGlobalTransform *
-                            globalJointTransform *
-                            skin.inverseBindMatrices[boneIndex];
-                }
-                renderableManager->setBones(renderable, boneVector.data(), boneVector.size());
-            }
-        }
-    };
-
+    // Gather the palettes to compute and which one each target uses, this is serial but cheap.
+    mImpl->skinPalettes.clear();
+    mImpl->skinTargets.clear();
     if (mImpl->instance) {
-        update(mImpl->instance->skins, mImpl->boneMatrices);
+        mImpl->addSkinPalettes(mImpl->instance->skins);
     } else if (!mImpl->asset->isInstanced()) {
-        update(mImpl->asset->mSkins, mImpl->boneMatrices);
+        mImpl->addSkinPalettes(mImpl->asset->mSkins);
     } else {
         for (FFilamentInstance* instance : mImpl->asset->mInstances) {
-            update(instance->skins, mImpl->boneMatrices);
+            mImpl->addSkinPalettes(instance->skins);
+        }
+    }
+
+    // The bones only depend on world transforms, so they can be computed in parallel.
+    mImpl->parallelFor(mImpl->skinPalettes.size(),
+            [impl = mImpl](uint32_t startIndex, uint32_t indexCount) {
+                impl->computePalettes(startIndex, indexCount);
+            });
+
+    // Only upload the palettes that changed.
+    Engine& engine = *mImpl->engine;
+    for (const SkinPalette& palette : mImpl->skinPalettes) {
+        if (palette.dirty) {
+            const Skin& skin = *palette.skin;
+            const size_t njoints = skin.joints.size();
+            skin.skinningBuffer->setBones(engine, skin.palettes.data() + palette.slot * njoints,
+                    njoints, palette.slot * SKINNING_SLOT_SIZE);
+        }
+    }
+
+    RenderableManager* renderableManager = mImpl->renderableManager;
+    for (const SkinTarget& skinned : mImpl->skinTargets) {
+        Skin& skin = *skinned.skin;
+        if (skin.boundSlots[skinned.target] != skinned.slot) {
+            skin.boundSlots[skinned.target] = skinned.slot;
+            renderableManager->setSkinningBuffer(skinned.renderable, skin.skinningBuffer,
+                    skin.joints.size(), skinned.slot * SKINNING_SLOT_SIZE);
         }
     }
 }
@@ -347,6 +389,10 @@ void AnimatorImpl::addChannels(const NodeMap& nodeMap, const cgltf_animation& sr
     cgltf_animation_channel* srcChannels = srcAnim.channels;
     cgltf_animation_sampler* srcSamplers = srcAnim.samplers;
     const Sampler* samplers = dst.samplers.data();
+
+    // channels of this call are grouped per target, nodes are never shared by two node maps
+    tsl::robin_map<Entity, uint32_t, std::hash<Entity>> targetOfEntity;
+
     for (cgltf_size j = 0, nchans = srcAnim.channels_count; j < nchans; ++j) {
         const cgltf_animation_channel& srcChannel = srcChannels[j];
         auto iter = nodeMap.find(srcChannel.target_node);
@@ -369,106 +415,456 @@ void AnimatorImpl::addChannels(const NodeMap& nodeMap, const cgltf_animation& sr
         dstChannel.sourceData = samplers + (srcChannel.sampler - srcSamplers);
         dstChannel.targetEntity = targetEntity;
         setTransformType(srcChannel, dstChannel);
+
+        // a channel with less than two keyframes doesn't animate anything
+        const Sampler* sampler = dstChannel.sourceData;
+        if (sampler->times.size() < 2) {
+            continue;
+        }
+
+        const uint32_t channelIndex = dst.channels.size();
         dst.channels.push_back(dstChannel);
+
+        auto [pos, inserted] = targetOfEntity.try_emplace(targetEntity, dst.targets.size());
+        if (inserted) {
+            // the node is shared by all the animations that target it
+            auto [blend, newBlend] = blendTargetOfEntity.try_emplace(targetEntity,
+                    blendTargets.size());
+            if (newBlend) {
+                blendTargets.push_back({ .entity = targetEntity });
+            }
+            dst.targets.push_back({ .entity = targetEntity, .blendIndex = blend->second });
+        }
+        Target& target = dst.targets[pos->second];
+        switch (dstChannel.transformType) {
+            case Channel::TRANSLATION: target.translation = channelIndex; break;
+            case Channel::ROTATION:    target.rotation = channelIndex;    break;
+            case Channel::SCALE:       target.scale = channelIndex;       break;
+            case Channel::WEIGHTS: {
+                BlendTarget& blend = blendTargets[target.blendIndex];
+                if (!blend.weightsCount) {
+                    const size_t valuesPerKeyframe =
+                            sampler->values.size() / sampler->times.size();
+                    blend.weightsOffset = morphWeights.size();
+                    blend.weightsCount = sampler->interpolation == Sampler::CUBIC ?
+                            valuesPerKeyframe / 3 : valuesPerKeyframe;
+                    morphWeights.resize(morphWeights.size() + blend.weightsCount);
+                }
+                target.weights = channelIndex;
+                break;
+            }
+        }
+    }
+}
+
+template<typename F>
+void AnimatorImpl::parallelFor(uint32_t count, F const& work) {
+    if (count <= JOBS_PARALLEL_FOR_COUNT) {
+        work(0, count);
+    } else {
+        auto* job = jobs::parallel_for(*jobSystem, nullptr, 0, count,
+                std::cref(work), jobs::CountSplitter<JOBS_PARALLEL_FOR_COUNT, 4>());
+        jobSystem->runAndWait(job);
+    }
+}
+
+void AnimatorImpl::applyAnimations(const Animator::AnimationLayer* layers, size_t count) {
+    for (BlendTarget& blend : blendTargets) {
+        blend.translation = {};
+        blend.rotation = {};
+        blend.scale = {};
+        blend.translationWeight = 0;
+        blend.rotationWeight = 0;
+        blend.scaleWeight = 0;
+        blend.morphWeight = 0;
+    }
+    std::fill(morphWeights.begin(), morphWeights.end(), 0.0f);
+
+    // Accumulate the layers one after the other, the targets of a layer are all distinct nodes
+    // so they can be sampled in parallel.
+    for (size_t i = 0; i < count; i++) {
+        const Animator::AnimationLayer& layer = layers[i];
+        if (layer.weight <= 0) {
+            continue;
+        }
+        Animation& anim = animations[layer.animationIndex];
+        const float time = fmod(layer.time, anim.duration);
+        const float weight = layer.weight;
+        parallelFor(anim.targets.size(),
+                [this, &anim, time, weight](uint32_t startIndex, uint32_t indexCount) {
+                    for (uint32_t i = startIndex, e = startIndex + indexCount; i < e; i++) {
+                        accumulateTarget(anim, anim.targets[i], time, weight);
+                    }
+                });
+    }
+
+    parallelFor(blendTargets.size(), [this](uint32_t startIndex, uint32_t indexCount) {
+        for (uint32_t i = startIndex, e = startIndex + indexCount; i < e; i++) {
+            resolveTarget(blendTargets[i]);
+        }
+    });
+
+    // The world transforms are only updated once, when the transaction is committed.
+    transformManager->openLocalTransformTransaction();
+    for (const BlendTarget& blend : blendTargets) {
+        if (blend.hasTransform()) {
+            TransformManager::Instance node = transformManager->getInstance(blend.entity);
+            transformManager->setTransform(node, blend.transform);
+        }
+    }
+    transformManager->commitLocalTransformTransaction();
+
+    for (const BlendTarget& blend : blendTargets) {
+        if (blend.morphWeight > 0) {
+            auto ci = renderableManager->getInstance(blend.entity);
+            renderableManager->setMorphWeights(ci,
+                    morphWeights.data() + blend.weightsOffset, blend.weightsCount);
+        }
+    }
+}
+
+// Finds the keyframe pair surrounding the given time, and the interpolant (between 0 and 1)
+// between them. The search starts from the keyframe found by the previous evaluation of the
+// channel, which is usually the right one or close to it.
+static void findKeyframes(Channel& channel, float time,
+        size_t* prevIndex, size_t* nextIndex, float* t) {
+    const Sampler* sampler = channel.sourceData;
+    const float* const times = sampler->times.data();
+    const size_t size = sampler->times.size();
+
+    // Find the first keyframe after the given time, or the keyframe that matches it exactly.
+    size_t next = std::min(size_t(channel.cursor), size);
+    if (next > 0 && times[next - 1] >= time) {
+        // time went backward, typically because the animation looped
+        next = std::lower_bound(times, times + next, time) - times;
+    } else {
+        // time went forward, this is usually the same or the next keyframe
+        const size_t last = std::min(next + 4, size);
+        while (next < last && times[next] < time) {
+            next++;
+        }
+        if (next == last && next < size) {
+            next = std::lower_bound(times + next, times + size, time) - times;
+        }
+    }
+    channel.cursor = uint32_t(next);
+
+    *t = 0.0f;
+    if (next == size) {
+        *nextIndex = size - 1;
+        *prevIndex = size - 1;
+    } else if (next == 0) {
+        *nextIndex = 0;
+        *prevIndex = 0;
+    } else {
+        *nextIndex = next;
+        *prevIndex = next - 1;
+        const float nextTime = times[next];
+        const float prevTime = times[next - 1];
+        float deltaTime = nextTime - prevTime;
+        assert(deltaTime >= 0);
+        if (deltaTime > 0) {
+            *t = (time - prevTime) / deltaTime;
+        }
+    }
+
+    if (sampler->interpolation == Sampler::STEP) {
+        *t = 0.0f;
     }
 }
 
-void AnimatorImpl::applyAnimation(const Channel& channel, float t, size_t prevIndex,
-        size_t nextIndex) {
+template<typename T>
+static T sampleValue(Channel& channel, float time) {
+    size_t prevIndex, nextIndex;
+    float t;
+    findKeyframes(channel, time, &prevIndex, &nextIndex, &t);
     const Sampler* sampler = channel.sourceData;
-    const TimeValues& times = sampler->times;
-    TransformManager::Instance node = transformManager->getInstance(channel.targetEntity);
+    const T* srcValues = (const T*) sampler->values.data();
+    if (sampler->interpolation == Sampler::CUBIC) {
+        T vert0 = srcValues[prevIndex * 3 + 1];
+        T tang0 = srcValues[prevIndex * 3 + 2];
+        T tang1 = srcValues[nextIndex * 3];
+        T vert1 = srcValues[nextIndex * 3 + 1];
+        return cubicSpline(vert0, tang0, vert1, tang1, t);
+    }
+    return ((1 - t) * srcValues[prevIndex]) + (t * srcValues[nextIndex]);
+}
 
-    // Perform the interpolation. This is a simple but inefficient implementation; Filament
-    // stores transforms as mat4's but glTF animation is based on TRS (translation rotation
-    // scale).
-    mat4f xform = transformManager->getTransform(node);
-    float3 scale;
-    quatf rotation;
-    float3 translation;
-    decomposeMatrix(xform, &translation, &rotation, &scale);
-
-    switch (channel.transformType) {
-
-        case Channel::SCALE: {
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                scale = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                scale = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
-            }
-            break;
+template<>
+quatf sampleValue<quatf>(Channel& channel, float time) {
+    size_t prevIndex, nextIndex;
+    float t;
+    findKeyframes(channel, time, &prevIndex, &nextIndex, &t);
+    const Sampler* sampler = channel.sourceData;
+    const quatf* srcQuat = (const quatf*) sampler->values.data();
+    if (sampler->interpolation == Sampler::CUBIC) {
+        quatf vert0 = srcQuat[prevIndex * 3 + 1];
+        quatf tang0 = srcQuat[prevIndex * 3 + 2];
+        quatf tang1 = srcQuat[nextIndex * 3];
+        quatf vert1 = srcQuat[nextIndex * 3 + 1];
+        return normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
+    }
+    return slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
+}
+
+void AnimatorImpl::accumulateTarget(Animation& anim, const Target& target, float time,
+        float weight) {
+    BlendTarget& blend = blendTargets[target.blendIndex];
+
+    if (target.translation != Target::NONE) {
+        blend.translation += weight * sampleValue<float3>(anim.channels[target.translation], time);
+        blend.translationWeight += weight;
+    }
+    if (target.rotation != Target::NONE) {
+        // keep all the rotations in the same hemisphere, so they don't cancel each other
+        quatf rotation = sampleValue<quatf>(anim.channels[target.rotation], time);
+        if (dot(blend.rotation, rotation) < 0) {
+            rotation = -rotation;
         }
+        blend.rotation += weight * rotation;
+        blend.rotationWeight += weight;
+    }
+    if (target.scale != Target::NONE) {
+        blend.scale += weight * sampleValue<float3>(anim.channels[target.scale], time);
+        blend.scaleWeight += weight;
+    }
+
+    if (target.weights != Target::NONE) {
+        Channel& channel = anim.channels[target.weights];
+        size_t prevIndex, nextIndex;
+        float t;
+        findKeyframes(channel, time, &prevIndex, &nextIndex, &t);
 
-        case Channel::TRANSLATION: {
-            const float3* srcVec3 = (const float3*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                float3 vert0 = srcVec3[prevIndex * 3 + 1];
-                float3 tang0 = srcVec3[prevIndex * 3 + 2];
-                float3 tang1 = srcVec3[nextIndex * 3];
-                float3 vert1 = srcVec3[nextIndex * 3 + 1];
-                translation = cubicSpline(vert0, tang0, vert1, tang1, t);
-            } else {
-                translation = ((1 - t) * srcVec3[prevIndex]) + (t * srcVec3[nextIndex]);
+        const Sampler* sampler = channel.sourceData;
+        const float* const samplerValues = sampler->values.data();
+        assert(sampler->values.size() % sampler->times.size() == 0);
+        const size_t valuesPerKeyframe = sampler->values.size() / sampler->times.size();
+        float* const UTILS_RESTRICT weights = morphWeights.data() + blend.weightsOffset;
+        const size_t numMorphTargets = blend.weightsCount;
+
+        if (sampler->interpolation == Sampler::CUBIC) {
+            assert(valuesPerKeyframe == numMorphTargets * 3);
+            const float* const inTangents = samplerValues;
+            const float* const splineVerts = samplerValues + numMorphTargets;
+            const float* const outTangents = samplerValues + numMorphTargets * 2;
+            for (size_t comp = 0; comp < numMorphTargets; ++comp) {
+                float vert0 = splineVerts[comp + prevIndex * valuesPerKeyframe];
+                float tang0 = outTangents[comp + prevIndex * valuesPerKeyframe];
+                float tang1 = inTangents[comp + nextIndex * valuesPerKeyframe];
+                float vert1 = splineVerts[comp + nextIndex * valuesPerKeyframe];
+                weights[comp] += weight * cubicSpline(vert0, tang0, vert1, tang1, t);
             }
-            break;
+        } else {
+            assert(valuesPerKeyframe == numMorphTargets);
+            const float* const UTILS_RESTRICT previous = samplerValues + prevIndex * valuesPerKeyframe;
+            const float* const UTILS_RESTRICT current = samplerValues + nextIndex * valuesPerKeyframe;
+            const float w0 = weight * (1 - t);
+            const float w1 = weight * t;
+            for (size_t comp = 0; comp < numMorphTargets; ++comp) {
+                weights[comp] += w0 * previous[comp] + w1 * current[comp];
+            }
+        }
+        blend.morphWeight += weight;
+    }
+}
+
+void AnimatorImpl::resolveTarget(BlendTarget& blend) {
+    if (blend.hasTransform()) {
+        // glTF animation is based on TRS (translation rotation scale), but Filament stores
+        // transforms as mat4's. The current transform only needs to be decomposed if some of the
+        // components are not animated.
+        float3 translation;
+        quatf rotation;
+        float3 scale;
+        if (!blend.translationWeight || !blend.rotationWeight || !blend.scaleWeight) {
+            TransformManager::Instance node = transformManager->getInstance(blend.entity);
+            decomposeMatrix(transformManager->getTransform(node),
+                    &translation, &rotation, &scale);
+        }
+        if (blend.translationWeight > 0) {
+            translation = blend.translation / blend.translationWeight;
+        }
+        if (blend.rotationWeight > 0) {
+            rotation = normalize(blend.rotation);
+        }
+        if (blend.scaleWeight > 0) {
+            scale = blend.scale / blend.scaleWeight;
+        }
+        blend.transform = composeMatrix(translation, rotation, scale);
+    }
+
+    if (blend.morphWeight > 0 && blend.morphWeight != 1.0f) {
+        float* const UTILS_RESTRICT weights = morphWeights.data() + blend.weightsOffset;
+        const float scale = 1.0f / blend.morphWeight;
+        for (size_t comp = 0; comp < blend.weightsCount; ++comp) {
+            weights[comp] *= scale;
+        }
+    }
+}
+
+// Removes the keyframes of a sampler that interpolating their neighbours reproduces within the
+// given tolerance. Keyframes are removed greedily: each kept keyframe is followed by the farthest
+// keyframe such that all the keyframes in between can be dropped.
+static void reduceKeyframes(Sampler& sampler, bool isRotation, float tolerance) {
+    const size_t size = sampler.times.size();
+    // cubic spline keyframes carry their tangents, we leave them alone
+    if (size < 3 || sampler.interpolation == Sampler::CUBIC) {
+        return;
+    }
+    const size_t valuesPerKeyframe = sampler.values.size() / size;
+    const float* const times = sampler.times.data();
+    const float* const values = sampler.values.data();
+
+    // Error of keyframe k, when reconstructed from keyframes a and b. Rotation errors are angles.
+    auto error = [&](size_t a, size_t b, size_t k) -> float {
+        const float deltaTime = times[b] - times[a];
+        const float t = (sampler.interpolation == Sampler::STEP || deltaTime <= 0) ? 0.0f :
+                (times[k] - times[a]) / deltaTime;
+        if (isRotation) {
+            const quatf* const quats = (const quatf*) values;
+            const quatf q = slerp(quats[a], quats[b], t);
+            const float d = std::min(length(q - quats[k]), length(q + quats[k]));
+            return 4.0f * std::asin(std::min(1.0f, d * 0.5f));
+        }
+        float e = 0;
+        for (size_t c = 0; c < valuesPerKeyframe; c++) {
+            const float v = (1 - t) * values[a * valuesPerKeyframe + c] +
+                    t * values[b * valuesPerKeyframe + c];
+            e = std::max(e, std::abs(v - values[k * valuesPerKeyframe + c]));
         }
+        return e;
+    };
 
-        case Channel::ROTATION: {
-            const quatf* srcQuat = (const quatf*) sampler->values.data();
-            if (sampler->interpolation == Sampler::CUBIC) {
-                quatf vert0 = srcQuat[prevIndex * 3 + 1];
-                quatf tang0 = srcQuat[prevIndex * 3 + 2];
-                quatf tang1 = srcQuat[nextIndex * 3];
-                quatf vert1 = srcQuat[nextIndex * 3 + 1];
-                rotation = normalize(cubicSpline(vert0, tang0, vert1, tang1, t));
-            } else {
-                rotation = slerp(srcQuat[prevIndex], srcQuat[nextIndex], t);
+    vector<uint32_t> kept;
+    kept.push_back(0);
+    size_t a = 0;
+    for (size_t b = a + 2; b < size; b++) {
+        for (size_t k = a + 1; k < b; k++) {
+            if (error(a, b, k) > tolerance) {
+                a = b - 1;
+                kept.push_back(a);
+                break;
             }
-            break;
         }
+    }
+    kept.push_back(size - 1);
 
-        case Channel::WEIGHTS: {
-            const float* const samplerValues = sampler->values.data();
-            assert(sampler->values.size() % times.size() == 0);
-            const int valuesPerKeyframe = sampler->values.size() / times.size();
-
-            if (sampler->interpolation == Sampler::CUBIC) {
-                assert(valuesPerKeyframe % 3 == 0);
-                const int numMorphTargets = valuesPerKeyframe / 3;
-                const float* const inTangents = samplerValues;
-                const float* const splineVerts = samplerValues + numMorphTargets;
-                const float* const outTangents = samplerValues + numMorphTargets * 2;
-
-                weights.resize(numMorphTargets);
-                for (int comp = 0; comp < numMorphTargets; ++comp) {
-                    float vert0 = splineVerts[comp + prevIndex * valuesPerKeyframe];
-                    float tang0 = outTangents[comp + prevIndex * valuesPerKeyframe];
-                    float tang1 = inTangents[comp + nextIndex * valuesPerKeyframe];
-                    float vert1 = splineVerts[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = cubicSpline(vert0, tang0, vert1, tang1, t);
-                }
-            } else {
-                weights.resize(valuesPerKeyframe);
-                for (int comp = 0; comp < valuesPerKeyframe; ++comp) {
-                    float previous = samplerValues[comp + prevIndex * valuesPerKeyframe];
-                    float current = samplerValues[comp + nextIndex * valuesPerKeyframe];
-                    weights[comp] = (1 - t) * previous + t * current;
-                }
+    if (kept.size() == size) {
+        return;
+    }
+
+    vector<float> newTimes(kept.size());
+    vector<float> newValues(kept.size() * valuesPerKeyframe);
+    for (size_t i = 0; i < kept.size(); i++) {
+        newTimes[i] = times[kept[i]];
+        std::copy_n(values + kept[i] * valuesPerKeyframe, valuesPerKeyframe,
+                newValues.data() + i * valuesPerKeyframe);
+    }
+    sampler.times = std::move(newTimes);
+    sampler.values = std::move(newValues);
+}
+
+void AnimatorImpl::compressSamplers(Animation& anim,
+        const Animator::KeyframeTolerance& tolerance) {
+    // The tolerance of a sampler depends on what it animates, samplers are very rarely shared by
+    // channels of different types, so we use the first one.
+    vector<int> samplerType(anim.samplers.size(), -1);
+    for (const Channel& channel : anim.channels) {
+        int& type = samplerType[channel.sourceData - anim.samplers.data()];
+        if (type < 0) {
+            type = channel.transformType;
+        }
+    }
+    for (size_t i = 0; i < anim.samplers.size(); i++) {
+        switch (samplerType[i]) {
+            case Channel::TRANSLATION:
+                reduceKeyframes(anim.samplers[i], false, tolerance.translation);
+                break;
+            case Channel::ROTATION:
+                reduceKeyframes(anim.samplers[i], true, tolerance.rotation);
+                break;
+            case Channel::SCALE:
+                reduceKeyframes(anim.samplers[i], false, tolerance.scale);
+                break;
+            case Channel::WEIGHTS:
+                reduceKeyframes(anim.samplers[i], false, tolerance.weights);
+                break;
+        }
+    }
+
+    // the keyframe indices changed
+    for (Channel& channel : anim.channels) {
+        channel.cursor = 0;
+    }
+}
+
+void AnimatorImpl::addSkinPalettes(SkinVector& skins) {
+    for (Skin& skin : skins) {
+        if (!skin.skinningBuffer) {
+            continue;
+        }
+        const size_t njoints = skin.joints.size();
+        const size_t slotCount = skin.targets.size();
+        if (UTILS_UNLIKELY(skin.palettes.size() != slotCount * njoints)) {
+            // the SkinningBuffer is initialized to identity, and each target uses its own slot
+            skin.palettes.assign(slotCount * njoints, mat4f());
+            skin.boundSlots.resize(slotCount);
+            std::iota(skin.boundSlots.begin(), skin.boundSlots.end(), 0u);
+        }
+
+        const size_t firstPalette = skinPalettes.size();
+        for (uint32_t target = 0; target < slotCount; target++) {
+            const Entity entity = skin.targets[target];
+            auto renderable = renderableManager->getInstance(entity);
+            if (!renderable) {
+                continue;
+            }
+            mat4f worldTransform;
+            auto xformable = transformManager->getInstance(entity);
+            if (xformable) {
+                worldTransform = transformManager->getWorldTransform(xformable);
             }
 
-            auto ci = renderableManager->getInstance(channel.targetEntity);
-            renderableManager->setMorphWeights(ci, weights.data(), weights.size());
-            return;
+            // Targets with the same world transform have the same bones, this is typically the
+            // case of all the meshes of a character. A skin only has a handful of targets.
+            size_t palette = firstPalette;
+            while (palette < skinPalettes.size() && memcmp(&skinPalettes[palette].worldTransform,
+                    &worldTransform, sizeof(mat4f))) {
+                palette++;
+            }
+            if (palette == skinPalettes.size()) {
+                skinPalettes.push_back({ &skin, target, worldTransform, false });
+            }
+            skinTargets.push_back({ &skin, renderable, target, skinPalettes[palette].slot });
         }
     }
+}
 
-    xform = composeMatrix(translation, rotation, scale);
-    transformManager->setTransform(node, xform);
+void AnimatorImpl::computePalettes(uint32_t first, uint32_t count) {
+    for (uint32_t i = first, e = first + count; i < e; i++) {
+        SkinPalette& palette = skinPalettes[i];
+        const Skin& skin = *palette.skin;
+        const size_t njoints = skin.joints.size();
+        mat4f* const UTILS_RESTRICT bones = palette.skin->palettes.data() + palette.slot * njoints;
+
+        const mat4f inverseGlobalTransform = inverse(palette.worldTransform);
+        bool dirty = false;
+        for (size_t boneIndex = 0; boneIndex < njoints; ++boneIndex) {
+            const auto& joint = skin.joints[boneIndex];
+            TransformManager::Instance jointInstance = transformManager->getInstance(joint);
+            mat4f globalJointTransform = transformManager->getWorldTransform(jointInstance);
+            const mat4f bone =
+                    inverseGlobalTransform *
+                    globalJointTransform *
+                    skin.inverseBindMatrices[boneIndex];
+            // an unchanged pose doesn't need to be uploaded again
+            if (memcmp(&bones[boneIndex], &bone, sizeof(mat4f))) {
+                bones[boneIndex] = bone;
+                dirty = true;
+            }
+        }
+        palette.dirty = dirty;
+    }
 }
 
 } // namespace gltfio
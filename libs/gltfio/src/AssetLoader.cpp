@@ -31,6 +31,7 @@
 #include <filament/MorphTargetBuffer.h>
 #include <filament/RenderableManager.h>
 #include <filament/Scene.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/TextureSampler.h>
 #include <filament/TransformManager.h>
 #include <filament/VertexBuffer.h>
@@ -48,6 +49,10 @@
 
 #include <tsl/robin_map.h>
 
+#include <chrono>
+#include <utility>
+#include <vector>
+
 #define CGLTF_IMPLEMENTATION
 #include <cgltf.h>
 
@@ -79,6 +84,60 @@ uint32_t computeBindingOffset(const cgltf_accessor* accessor) {
     return uint32_t(accessor->offset + accessor->buffer_view->offset);
 }
 
+// Quantized positions are relative to the bounding box of the whole mesh, because a renderable has
+// a single box for all of its primitives. Returns false if the positions of the mesh must be kept
+// as floats, i.e. when they're morphed, skinned, or not plain float3 data with min / max.
+static bool getQuantizationBounds(const cgltf_mesh* mesh, Box* bounds) {
+    Aabb aabb;
+    for (cgltf_size index = 0; index < mesh->primitives_count; ++index) {
+        const cgltf_primitive& prim = mesh->primitives[index];
+        if (prim.targets_count > 0 || prim.has_draco_mesh_compression) {
+            return false;
+        }
+        const cgltf_accessor* positions = nullptr;
+        for (cgltf_size aindex = 0; aindex < prim.attributes_count; aindex++) {
+            const cgltf_attribute& attribute = prim.attributes[aindex];
+            if (attribute.type == cgltf_attribute_type_joints ||
+                    attribute.type == cgltf_attribute_type_weights) {
+                return false;
+            }
+            if (attribute.type == cgltf_attribute_type_position) {
+                positions = attribute.data;
+            }
+        }
+        if (!positions || positions->type != cgltf_type_vec3 ||
+                positions->component_type != cgltf_component_type_r_32f ||
+                positions->is_sparse || !positions->buffer_view ||
+                !positions->has_min || !positions->has_max) {
+            return false;
+        }
+        const float* minp = &positions->min[0];
+        const float* maxp = &positions->max[0];
+        aabb.min = min(aabb.min, float3(minp[0], minp[1], minp[2]));
+        aabb.max = max(aabb.max, float3(maxp[0], maxp[1], maxp[2]));
+    }
+    *bounds = Box().set(aabb.min, aabb.max);
+    return !bounds->isEmpty();
+}
+
+// Texture coordinates within [0, 1] don't lose any precision that matters as normalized ushort2.
+static bool canQuantizeTexCoords(const cgltf_accessor* accessor) {
+    return accessor->type == cgltf_type_vec2 &&
+            accessor->component_type == cgltf_component_type_r_32f &&
+            !accessor->is_sparse && accessor->buffer_view &&
+            accessor->has_min && accessor->has_max &&
+            accessor->min[0] >= 0.0f && accessor->min[1] >= 0.0f &&
+            accessor->max[0] <= 1.0f && accessor->max[1] <= 1.0f;
+}
+
+static size_t getNodeCount(const cgltf_node* node) {
+    size_t count = 1;
+    for (cgltf_size i = 0, len = node->children_count; i < len; ++i) {
+        count += getNodeCount(node->children[i]);
+    }
+    return count;
+}
+
 static const char* getNodeName(const cgltf_node* node, const char* defaultNodeName) {
     if (node->name) return node->name;
     if (node->mesh && node->mesh->name) return node->mesh->name;
@@ -95,7 +154,8 @@ struct FAssetLoader : public AssetLoader {
             mTransformManager(config.engine->getTransformManager()),
             mMaterials(config.materials),
             mEngine(config.engine),
-            mDefaultNodeName(config.defaultNodeName) {}
+            mDefaultNodeName(config.defaultNodeName),
+            mQuantizeVertices(config.quantizeVertices) {}
 
     FFilamentAsset* createAssetFromJson(const uint8_t* bytes, uint32_t nbytes);
     FFilamentAsset* createAssetFromBinary(const uint8_t* bytes, uint32_t nbytes);
@@ -103,12 +163,22 @@ struct FAssetLoader : public AssetLoader {
         FilamentInstance** instances, size_t numInstances);
     FilamentInstance* createInstance(FFilamentAsset* primary);
 
+    FFilamentAsset* asyncBeginCreate(const uint8_t* bytes, uint32_t numBytes);
+    bool asyncUpdateCreate(float budgetMs);
+    float asyncGetCreateProgress() const noexcept;
+
     static void destroy(FAssetLoader** loader) noexcept {
+        if (*loader) {
+            (*loader)->endAsyncCreate();
+        }
         delete *loader;
         *loader = nullptr;
     }
 
     void destroyAsset(const FFilamentAsset* asset) {
+        if (asset == mAsyncCreate.asset) {
+            endAsyncCreate();
+        }
         delete asset;
     }
 
@@ -125,12 +195,18 @@ struct FAssetLoader : public AssetLoader {
     }
 
     void createAsset(const cgltf_data* srcAsset, size_t numInstances);
+    const cgltf_scene* createRootAsset(const cgltf_data* srcAsset);
     FFilamentInstance* createInstance(FFilamentAsset* primary, const cgltf_scene* scene);
     void createEntity(const cgltf_node* node, Entity parent, bool enableLight,
             FFilamentInstance* instance);
-    void createRenderable(const cgltf_node* node, Entity entity, const char* name);
+    Entity createNode(const cgltf_node* node, Entity parent, bool enableLight,
+            FFilamentInstance* instance);
+    void createRenderable(const cgltf_node* node, Entity entity, const char* name,
+            FFilamentInstance* instance);
+    void setupSkinning(RenderableManager::Builder& builder, const cgltf_node* node,
+            FFilamentInstance* instance);
     bool createPrimitive(const cgltf_primitive* inPrim, Primitive* outPrim, const UvMap& uvmap,
-            const char* name, MaterialInstance* mi);
+            const Box& positionBounds, const char* name, MaterialInstance* mi);
     void createLight(const cgltf_light* light, Entity entity);
     void createCamera(const cgltf_camera* camera, Entity entity);
     MaterialInstance* createMaterialInstance(const cgltf_material* inputMat, UvMap* uvmap,
@@ -138,6 +214,7 @@ struct FAssetLoader : public AssetLoader {
     void addTextureBinding(MaterialInstance* materialInstance, const char* parameterName,
             const cgltf_texture* srcTexture, bool srgb);
     bool primitiveHasVertexColor(const cgltf_primitive* inPrim) const;
+    void endAsyncCreate() noexcept;
 
     static LightManager::Type getLightType(const cgltf_light_type type);
 
@@ -151,11 +228,23 @@ struct FAssetLoader : public AssetLoader {
     // Transient state used only for the asset currently being loaded:
     FFilamentAsset* mResult;
     const char* mDefaultNodeName;
+    const bool mQuantizeVertices;
     bool mError = false;
     bool mDiagnosticsEnabled = false;
 
     // Weak reference to the largest dummy buffer so far in the current loading phase.
     BufferObject* mDummyBufferObject;
+
+    // State of the asset being created with asyncBeginCreate, whose nodes are created a few at a
+    // time by asyncUpdateCreate. The nodes are popped from a stack to keep the same depth-first
+    // order as createEntity.
+    struct AsyncCreate {
+        FFilamentAsset* asset = nullptr;
+        BufferObject* dummyBufferObject = nullptr;
+        std::vector<std::pair<const cgltf_node*, Entity>> pending;
+        size_t createdNodeCount = 0;
+        size_t nodeCount = 0;
+    } mAsyncCreate;
 };
 
 FILAMENT_UPCAST(AssetLoader)
@@ -256,12 +345,45 @@ FilamentInstance* FAssetLoader::createInstance(FFilamentAsset* primary) {
 
 void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances) {
     SYSTRACE_CALL();
+    const cgltf_scene* scene = createRootAsset(srcAsset);
+    if (!scene) {
+        return;
+    }
+
+    if (numInstances == 0) {
+        // For each scene root, recursively create all entities.
+        for (cgltf_size i = 0, len = scene->nodes_count; i < len; ++i) {
+            cgltf_node** nodes = scene->nodes;
+            createEntity(nodes[i], mResult->mRoot, true, nullptr);
+        }
+    } else {
+        // Create a separate entity hierarchy for each instance. Note that MeshCache (vertex
+        // buffers and index buffers) and MatInstanceCache (materials and textures) help avoid
+        // needless duplication of resources.
+        for (size_t index = 0; index < numInstances; ++index) {
+            if (createInstance(mResult, scene) == nullptr) {
+                mError = true;
+                break;
+            }
+        }
+    }
+
+    if (mError) {
+        destroyAsset(mResult);
+        mResult = nullptr;
+        mError = false;
+    }
+}
+
+// Creates the asset and its root entity, but none of the nodes. Returns the scene whose nodes should
+// be created, or null if there is nothing to create (in which case mResult might be null too).
+const cgltf_scene* FAssetLoader::createRootAsset(const cgltf_data* srcAsset) {
     #if !GLTFIO_DRACO_SUPPORTED
     for (cgltf_size i = 0; i < srcAsset->extensions_required_count; i++) {
         if (!strcmp(srcAsset->extensions_required[i], "KHR_draco_mesh_compression")) {
             slog.e << "KHR_draco_mesh_compression is not supported." << io::endl;
             mResult = nullptr;
-            return;
+            return nullptr;
         }
     }
     #endif
@@ -273,7 +395,7 @@ void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances)
     // It is not an error for a glTF file to have zero scenes.
     const cgltf_scene* scene = srcAsset->scene ? srcAsset->scene : srcAsset->scenes;
     if (!scene) {
-        return;
+        return nullptr;
     }
 
     // Create a single root node with an identity transform as a convenience to the client.
@@ -287,24 +409,6 @@ void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances)
         mResult->mAssetExtras = CString(srcAsset->json + asset.extras.start_offset, extras_size);
     }
 
-    if (numInstances == 0) {
-        // For each scene root, recursively create all entities.
-        for (cgltf_size i = 0, len = scene->nodes_count; i < len; ++i) {
-            cgltf_node** nodes = scene->nodes;
-            createEntity(nodes[i], mResult->mRoot, true, nullptr);
-        }
-    } else {
-        // Create a separate entity hierarchy for each instance. Note that MeshCache (vertex
-        // buffers and index buffers) and MatInstanceCache (materials and textures) help avoid
-        // needless duplication of resources.
-        for (size_t index = 0; index < numInstances; ++index) {
-            if (createInstance(mResult, scene) == nullptr) {
-                mError = true;
-                break;
-            }
-        }
-    }
-
     // Find every unique resource URI and store a pointer to any of the cgltf-owned cstrings
     // that match the URI. These strings get freed during releaseSourceData().
     tsl::robin_map<std::string, const char*> resourceUris;
@@ -324,11 +428,98 @@ void FAssetLoader::createAsset(const cgltf_data* srcAsset, size_t numInstances)
         mResult->mResourceUris.push_back(pair.second);
     }
 
-    if (mError) {
-        destroyAsset(mResult);
-        mResult = nullptr;
+    return scene;
+}
+
+FFilamentAsset* FAssetLoader::asyncBeginCreate(const uint8_t* bytes, uint32_t byteCount) {
+    if (mAsyncCreate.asset) {
+        slog.e << "Another asset is already being created." << io::endl;
+        return nullptr;
+    }
+
+    // The source blob is copied for the same reasons as in createInstancedAsset, and because the
+    // JSON is still needed by asyncUpdateCreate after this returns.
+    utils::FixedCapacityVector<uint8_t> glbdata(byteCount);
+    std::copy_n(bytes, byteCount, glbdata.data());
+
+    cgltf_options options {};
+    cgltf_data* sourceAsset;
+    cgltf_result result = cgltf_parse(&options, glbdata.data(), byteCount, &sourceAsset);
+    if (result != cgltf_result_success) {
+        slog.e << "Unable to parse glTF file." << io::endl;
+        return nullptr;
+    }
+
+    const cgltf_scene* scene = createRootAsset(sourceAsset);
+    if (!mResult) {
+        return nullptr;
+    }
+    glbdata.swap(mResult->mSourceAsset->glbData);
+    if (!scene) {
+        return mResult;
+    }
+
+    mAsyncCreate.asset = mResult;
+    mAsyncCreate.dummyBufferObject = mDummyBufferObject;
+    mResult->mAsyncCreatePending = true;
+    for (cgltf_size i = scene->nodes_count; i > 0; --i) {
+        mAsyncCreate.pending.emplace_back(scene->nodes[i - 1], mResult->mRoot);
+        mAsyncCreate.nodeCount += getNodeCount(scene->nodes[i - 1]);
+    }
+    return mResult;
+}
+
+bool FAssetLoader::asyncUpdateCreate(float budgetMs) {
+    if (!mAsyncCreate.asset) {
+        return true;
+    }
+    SYSTRACE_CALL();
+
+    using clock = std::chrono::steady_clock;
+    const clock::time_point deadline = clock::now() +
+            std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<float, std::milli>(budgetMs));
+
+    // At least one node is created per call, so that the asset always makes progress.
+    mResult = mAsyncCreate.asset;
+    mDummyBufferObject = mAsyncCreate.dummyBufferObject;
+    auto& pending = mAsyncCreate.pending;
+    while (!pending.empty() && !mError) {
+        const auto [node, parent] = pending.back();
+        pending.pop_back();
+        const Entity entity = createNode(node, parent, true, nullptr);
+        for (cgltf_size i = node->children_count; i > 0; --i) {
+            pending.emplace_back(node->children[i - 1], entity);
+        }
+        mAsyncCreate.createdNodeCount++;
+        if (clock::now() >= deadline) {
+            break;
+        }
+    }
+    mAsyncCreate.dummyBufferObject = mDummyBufferObject;
+
+    // The asset belongs to the client, so it isn't destroyed on error: it just stops growing.
+    const bool success = !mError;
+    if (pending.empty() || mError) {
+        endAsyncCreate();
         mError = false;
     }
+    return success;
+}
+
+void FAssetLoader::endAsyncCreate() noexcept {
+    // the source data of the asset isn't needed by the loader anymore
+    if (mAsyncCreate.asset) {
+        mAsyncCreate.asset->mAsyncCreatePending = false;
+    }
+    mAsyncCreate = {};
+}
+
+float FAssetLoader::asyncGetCreateProgress() const noexcept {
+    if (!mAsyncCreate.asset || mAsyncCreate.nodeCount == 0) {
+        return 1.0f;
+    }
+    return float(mAsyncCreate.createdNodeCount) / float(mAsyncCreate.nodeCount);
 }
 
 FFilamentInstance* FAssetLoader::createInstance(FFilamentAsset* primary, const cgltf_scene* scene) {
@@ -354,6 +545,15 @@ FFilamentInstance* FAssetLoader::createInstance(FFilamentAsset* primary, const c
 
 void FAssetLoader::createEntity(const cgltf_node* node, Entity parent, bool enableLight,
         FFilamentInstance* instance) {
+    const Entity entity = createNode(node, parent, enableLight, instance);
+    for (cgltf_size i = 0, len = node->children_count; i < len; ++i) {
+        createEntity(node->children[i], entity, enableLight, instance);
+    }
+}
+
+// Creates the entity of a single node and its components, but not the entities of its children.
+Entity FAssetLoader::createNode(const cgltf_node* node, Entity parent, bool enableLight,
+        FFilamentInstance* instance) {
     Entity entity = mEntityManager.create();
 
     // Always create a transform component to reflect the original hierarchy.
@@ -402,7 +602,7 @@ void FAssetLoader::createEntity(const cgltf_node* node, Entity parent, bool enab
 
     // If the node has a mesh, then create a renderable component.
     if (node->mesh) {
-        createRenderable(node, entity, name);
+        createRenderable(node, entity, name, instance);
     }
 
     if (node->light && enableLight) {
@@ -413,12 +613,11 @@ void FAssetLoader::createEntity(const cgltf_node* node, Entity parent, bool enab
         createCamera(node->camera, entity);
     }
 
-    for (cgltf_size i = 0, len = node->children_count; i < len; ++i) {
-        createEntity(node->children[i], entity, enableLight, instance);
-    }
+    return entity;
 }
 
-void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const char* name) {
+void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const char* name,
+        FFilamentInstance* instance) {
     const cgltf_mesh* mesh = node->mesh;
 
     // Compute the transform relative to the root.
@@ -442,6 +641,13 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
 
     cgltf_size numMorphTargets = 0;
 
+    // An empty box means that the positions aren't quantized. This only depends on the mesh, so
+    // it's the same whether the primitives are created here or were cached.
+    Box positionBounds;
+    if (mQuantizeVertices && !getQuantizationBounds(mesh, &positionBounds)) {
+        positionBounds = {};
+    }
+
     // For each prim, create a Filament VertexBuffer, IndexBuffer, and MaterialInstance.
     for (cgltf_size index = 0; index < nprims; ++index, ++outputPrim, ++inputPrim) {
         RenderableManager::PrimitiveType primType;
@@ -470,7 +676,8 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
         builder.material(index, mi);
 
         // Create a Filament VertexBuffer and IndexBuffer for this prim if we haven't already.
-        if (!outputPrim->vertices && !createPrimitive(inputPrim, outputPrim, uvmap, name, mi)) {
+        if (!outputPrim->vertices &&
+                !createPrimitive(inputPrim, outputPrim, uvmap, positionBounds, name, mi)) {
             mError = true;
             continue;
         }
@@ -497,7 +704,11 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
     mResult->mBoundingBox.max = max(mResult->mBoundingBox.max, transformed.max);
 
     if (node->skin) {
-       builder.skinning(node->skin->joints_count);
+        setupSkinning(builder, node, instance);
+    }
+
+    if (!positionBounds.isEmpty()) {
+        builder.quantizedPositions(positionBounds);
     }
 
     // Per the spec, glTF models must have valid mix / max annotations for position attributes.
@@ -534,7 +745,7 @@ void FAssetLoader::createRenderable(const cgltf_node* node, Entity entity, const
 }
 
 bool FAssetLoader::createPrimitive(const cgltf_primitive* inPrim, Primitive* outPrim,
-        const UvMap& uvmap, const char* name, MaterialInstance* mi) {
+        const UvMap& uvmap, const Box& positionBounds, const char* name, MaterialInstance* mi) {
     outPrim->uvmap = uvmap;
 
     // Create a little lambda that appends to the asset's vertex buffer slots.
@@ -671,6 +882,26 @@ bool FAssetLoader::createPrimitive(const cgltf_primitive* inPrim, Primitive* out
         }
         const int stride = (fatype == actualType) ? accessor->stride : 0;
 
+        // Quantized data is encoded into a tightly packed buffer when it gets uploaded.
+        if (atype == cgltf_attribute_type_position && !positionBounds.isEmpty()) {
+            vbb.attribute(semantic, slot, VertexBuffer::AttributeType::SHORT4);
+            vbb.normalized(semantic);
+            BufferSlot entry = {accessor, atype, slot++};
+            entry.encoding = BufferSlot::Encoding::POSITION_SNORM16;
+            entry.positionBounds = positionBounds;
+            addBufferSlot(entry);
+            continue;
+        }
+        if (atype == cgltf_attribute_type_texcoord && mQuantizeVertices &&
+                canQuantizeTexCoords(accessor)) {
+            vbb.attribute(semantic, slot, VertexBuffer::AttributeType::USHORT2);
+            vbb.normalized(semantic);
+            BufferSlot entry = {accessor, atype, slot++};
+            entry.encoding = BufferSlot::Encoding::TEXCOORD_UNORM16;
+            addBufferSlot(entry);
+            continue;
+        }
+
         // The cgltf library provides a stride value for all accessors, even though they do not
         // exist in the glTF file. It is computed from the type and the stride of the buffer view.
         // As a convenience, cgltf also replaces zero (default) stride with the actual stride.
@@ -804,6 +1035,40 @@ bool FAssetLoader::createPrimitive(const cgltf_primitive* inPrim, Primitive* out
     return true;
 }
 
+void FAssetLoader::setupSkinning(RenderableManager::Builder& builder, const cgltf_node* node,
+        FFilamentInstance* instance) {
+    FFilamentAsset* owner = instance ? instance->owner : mResult;
+    const cgltf_data* srcAsset = owner->mSourceAsset->hierarchy;
+    const cgltf_skin* srcSkin = node->skin;
+
+    // The skins are imported by ResourceLoader, but their bones are allocated here because
+    // renderables can't switch to a SkinningBuffer after they're built.
+    SkinVector& skins = instance ? instance->skins : owner->mSkins;
+    skins.resize(srcAsset->skins_count);
+    Skin& skin = skins[srcSkin - srcAsset->skins];
+
+    // Targets are numbered in node order, like importSkins() does.
+    size_t slot = 0;
+    size_t slotCount = 0;
+    for (cgltf_size i = 0, len = srcAsset->nodes_count; i < len; ++i) {
+        if (srcAsset->nodes[i].skin == srcSkin) {
+            slot += (&srcAsset->nodes[i] < node) ? 1 : 0;
+            slotCount++;
+        }
+    }
+
+    if (!skin.skinningBuffer) {
+        skin.skinningBuffer = SkinningBuffer::Builder()
+                .boneCount(slotCount * SKINNING_SLOT_SIZE)
+                .initialize(true)
+                .build(*mEngine);
+        owner->mSkinningBuffers.push_back(skin.skinningBuffer);
+    }
+
+    builder.enableSkinningBuffers(true);
+    builder.skinning(skin.skinningBuffer, srcSkin->joints_count, slot * SKINNING_SLOT_SIZE);
+}
+
 void FAssetLoader::createLight(const cgltf_light* light, Entity entity) {
     LightManager::Type type = getLightType(light->type);
     LightManager::Builder builder(type);
@@ -1274,6 +1539,18 @@ FilamentInstance* AssetLoader::createInstance(FilamentAsset* asset) {
     return upcast(this)->createInstance(upcast(asset));
 }
 
+FilamentAsset* AssetLoader::asyncBeginCreate(const uint8_t* bytes, uint32_t numBytes) {
+    return upcast(this)->asyncBeginCreate(bytes, numBytes);
+}
+
+bool AssetLoader::asyncUpdateCreate(float budgetMs) {
+    return upcast(this)->asyncUpdateCreate(budgetMs);
+}
+
+float AssetLoader::asyncGetCreateProgress() const noexcept {
+    return upcast(this)->asyncGetCreateProgress();
+}
+
 void AssetLoader::enableDiagnostics(bool enable) {
     upcast(this)->mDiagnosticsEnabled = enable;
 }
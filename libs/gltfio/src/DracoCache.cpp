@@ -20,16 +20,14 @@
 #include <draco/compression/decode.h>
 #endif
 
-#include <utils/Log.h>
-
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 using std::unique_ptr;
 using std::vector;
 
-using namespace utils;
-
 namespace gltfio {
 
 DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
@@ -37,13 +35,31 @@ DracoMesh* DracoCache::findOrCreateMesh(const cgltf_buffer_view* key) {
     if (iter != mCache.end()) {
         return iter->second.get();
     }
-    assert(key->buffer && key->buffer->data);
-    const uint8_t* compressedData = key->offset + (uint8_t*) key->buffer->data;
-    DracoMesh* mesh = DracoMesh::decode(compressedData, key->size);
+    DracoMesh* mesh = decodeMesh(key);
     mCache.emplace(key, mesh);
     return mesh;
 }
 
+bool DracoCache::findMesh(const cgltf_buffer_view* key, DracoMesh** outMesh) const {
+    auto iter = mCache.find(key);
+    if (iter == mCache.end()) {
+        return false;
+    }
+    *outMesh = iter->second.get();
+    return true;
+}
+
+void DracoCache::addMesh(const cgltf_buffer_view* key, DracoMesh* mesh) {
+    assert(mCache.find(key) == mCache.end());
+    mCache[key].reset(mesh);
+}
+
+DracoMesh* DracoCache::decodeMesh(const cgltf_buffer_view* key) {
+    assert(key->buffer && key->buffer->data);
+    const uint8_t* compressedData = key->offset + (uint8_t*) key->buffer->data;
+    return DracoMesh::decode(compressedData, key->size);
+}
+
 DracoMesh::DracoMesh(struct DracoMeshDetails* details) : mDetails(details) {}
 
 #if GLTFIO_DRACO_SUPPORTED
@@ -52,6 +68,8 @@ struct DracoMeshDetails {
     unique_ptr<draco::Mesh> mesh;
     vector<unique_ptr<cgltf_buffer_view>> views;
     vector<unique_ptr<cgltf_buffer>> buffers;
+    // protects views and buffers, accessors can be decoded concurrently
+    std::mutex lock;
 };
 
 DracoMesh::~DracoMesh() {
@@ -117,7 +135,7 @@ DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) {
     return new DracoMesh(new DracoMeshDetails { std::move(meshStatus).value() });
 }
 
-bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
+bool DracoMesh::getFaceIndices(cgltf_accessor* target, std::string* error) const {
     // Return early if we've already decompressed this data.
     if (target->buffer_view) {
         return true;
@@ -129,16 +147,19 @@ bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
     // It would be tricky to be robust against a mismatch; see the class comment for DracoMesh.
     uint32_t count = mesh->num_faces() * 3;
     if (target->count != count) {
-        slog.e << "The glTF accessor wants " << target->count << " indices, "
-               << "but the decoded Draco mesh has " <<  count << " indices." << io::endl;
+        *error = "The glTF accessor wants " + std::to_string(target->count) + " indices, "
+                "but the decoded Draco mesh has " + std::to_string(count) + " indices.";
         return false;
     }
 
     cgltf_buffer_view* view = new cgltf_buffer_view;
     cgltf_buffer* buffer = view->buffer = new cgltf_buffer;
 
-    mDetails->views.emplace_back(view);
-    mDetails->buffers.emplace_back(buffer);
+    {
+        std::lock_guard<std::mutex> guard(mDetails->lock);
+        mDetails->views.emplace_back(view);
+        mDetails->buffers.emplace_back(buffer);
+    }
 
     target->offset = 0;
     target->buffer_view = view;
@@ -148,13 +169,14 @@ bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
         case cgltf_component_type_r_32u: convertFaces<uint32_t>(target, mesh); break;
         case cgltf_component_type_r_8u: convertFaces<uint8_t>(target, mesh); break;
         default:
-            slog.e << "Unexpected component type for Draco indices." << io::endl;
+            *error = "Unexpected component type for Draco indices.";
             return false;
     }
     return true;
 }
 
-bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target) const {
+bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target,
+        std::string* error) const {
     // Return early if we've already decompressed this data.
     if (target->buffer_view) {
         return true;
@@ -164,7 +186,7 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
     draco::Mesh* mesh = mDetails->mesh.get();
     const draco::PointAttribute* attr = mesh->GetAttributeByUniqueId(attributeId);
     if (!attr) {
-        slog.e << "Unknown Draco point attribute." << io::endl;
+        *error = "Unknown Draco point attribute.";
         return false;
     }
 
@@ -174,8 +196,8 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
     // DracoMesh.
     uint32_t count = mesh->num_points();
     if (target->count != count) {
-        slog.e << "The glTF accessor wants " << target->count << " vertices, "
-               << "but the decoded Draco mesh has " <<  count << " vertices." << io::endl;
+        *error = "The glTF accessor wants " + std::to_string(target->count) + " vertices, "
+                "but the decoded Draco mesh has " + std::to_string(count) + " vertices.";
 
         // It is tempting to degrade gracefully by processing only the lesser of the two
         // counts, but doing so would lead to invalid indices in the index buffer.
@@ -185,8 +207,11 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
     cgltf_buffer_view* view = new cgltf_buffer_view;
     cgltf_buffer* buffer = view->buffer = new cgltf_buffer;
 
-    mDetails->views.emplace_back(view);
-    mDetails->buffers.emplace_back(buffer);
+    {
+        std::lock_guard<std::mutex> guard(mDetails->lock);
+        mDetails->views.emplace_back(view);
+        mDetails->buffers.emplace_back(buffer);
+    }
 
     target->offset = 0;
     target->buffer_view = view;
@@ -199,7 +224,7 @@ bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target
 	    case cgltf_component_type_r_32u: convertAttribs<uint32_t>(target, attr, count); break;
 	    case cgltf_component_type_r_32f: convertAttribs<float>(target, attr, count); break;
         default:
-            slog.e << "Unexpected component type for Draco vertices." << io::endl;
+            *error = "Unexpected component type for Draco vertices.";
             break;
     }
 
@@ -212,11 +237,12 @@ DracoMesh::~DracoMesh() {}
 struct DracoMeshDetails {};
 DracoMesh* DracoMesh::decode(const uint8_t* data, size_t dataSize) { return nullptr; }
 
-bool DracoMesh::getFaceIndices(cgltf_accessor* target) const {
+bool DracoMesh::getFaceIndices(cgltf_accessor* target, std::string* error) const {
     return false;
 }
 
-bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target) const {
+bool DracoMesh::getVertexAttributes(uint32_t attributeId, cgltf_accessor* target,
+        std::string* error) const {
     return false;
 }
 
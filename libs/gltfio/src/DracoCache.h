@@ -22,6 +22,7 @@
 #include <tsl/robin_map.h>
 
 #include <memory>
+#include <string>
 
 #ifndef GLTFIO_DRACO_SUPPORTED
 #define GLTFIO_DRACO_SUPPORTED 0
@@ -35,9 +36,24 @@ class DracoMesh;
 //
 // The cache key is the buffer view that holds the compressed data. This allows the loader to
 // avoid duplicated work when a single Draco mesh is referenced from multiple primitives.
+//
+// The cache itself is not thread safe. To decode several meshes concurrently, call decodeMesh()
+// from jobs and then addMesh() from the thread that owns the cache.
 class DracoCache {
 public:
     DracoMesh* findOrCreateMesh(const cgltf_buffer_view* key);
+
+    // Returns true if the given buffer view has already been decoded, successfully or not. In
+    // that case the decoded mesh, or null if decoding failed, is returned in outMesh.
+    bool findMesh(const cgltf_buffer_view* key, DracoMesh** outMesh) const;
+
+    // Takes ownership of a mesh returned by decodeMesh(). A null mesh records that decoding
+    // failed, so that it isn't attempted again.
+    void addMesh(const cgltf_buffer_view* key, DracoMesh* mesh);
+
+    // Decodes the given buffer view without touching the cache. Safe to call from any thread.
+    static DracoMesh* decodeMesh(const cgltf_buffer_view* key);
+
 private:
     tsl::robin_map<const cgltf_buffer_view*, std::unique_ptr<DracoMesh>> mCache;
 };
@@ -50,6 +66,10 @@ private:
 // loaded. This tells the decoder that it should create a buffer_view and a buffer. The buffer
 // view, the buffer, and the buffer's data are all automatically freed when DracoMesh is destroyed.
 //
+// The accessor methods can be called from any thread, for different accessors. They don't log
+// problems themselves but describe them in the given error string, which is left untouched if
+// there are none.
+//
 // Note that in the gltfio architecture, the AssetLoader has the job of constructing VertexBuffer
 // objects while the ResourceLoader has the job of populating them asychronously. This means that
 // our Draco decoder relies on the accessor fields being 100% correct. If we had to be robust
@@ -58,8 +78,9 @@ private:
 class DracoMesh {
 public:
     static DracoMesh* decode(const uint8_t* compressedData, size_t compressedSize);
-    bool getFaceIndices(cgltf_accessor* destination) const;
-    bool getVertexAttributes(uint32_t attributeId, cgltf_accessor* destination) const;
+    bool getFaceIndices(cgltf_accessor* destination, std::string* error) const;
+    bool getVertexAttributes(uint32_t attributeId, cgltf_accessor* destination,
+            std::string* error) const;
     ~DracoMesh();
 private:
     DracoMesh(struct DracoMeshDetails* details);
@@ -19,10 +19,12 @@
 
 #include <gltfio/FilamentAsset.h>
 
+#include <filament/Box.h>
 #include <filament/Engine.h>
 #include <filament/IndexBuffer.h>
 #include <filament/MaterialInstance.h>
 #include <filament/RenderableManager.h>
+#include <filament/SkinningBuffer.h>
 #include <filament/Texture.h>
 #include <filament/TextureSampler.h>
 #include <filament/TransformManager.h>
@@ -74,6 +76,16 @@ struct BufferSlot {
     int bufferIndex; // for vertex buffers only
     filament::VertexBuffer* vertexBuffer;
     filament::IndexBuffer* indexBuffer;
+
+    // Float vertex data can be encoded when it gets uploaded, see quantizeVertices in
+    // AssetConfiguration.
+    enum class Encoding : uint8_t {
+        NONE,
+        POSITION_SNORM16,   // float3 into normalized short4, relative to positionBounds
+        TEXCOORD_UNORM16,   // float2 into normalized ushort2
+    };
+    Encoding encoding = Encoding::NONE;
+    filament::Box positionBounds = {};
 };
 
 // Encapsulates a connection between Texture and MaterialInstance.
@@ -239,6 +251,7 @@ struct FFilamentAsset : public FilamentAsset {
     std::vector<filament::VertexBuffer*> mVertexBuffers;
     std::vector<filament::BufferObject*> mBufferObjects;
     std::vector<filament::IndexBuffer*> mIndexBuffers;
+    std::vector<filament::SkinningBuffer*> mSkinningBuffers;
     std::vector<filament::Texture*> mTextures;
     filament::Aabb mBoundingBox;
     utils::Entity mRoot;
@@ -248,6 +261,8 @@ struct FFilamentAsset : public FilamentAsset {
     MorphHelper* mMorpher = nullptr;
     Wireframe* mWireframe = nullptr;
     bool mResourcesLoaded = false;
+    // nodes remain to be created by AssetLoader::asyncUpdateCreate
+    bool mAsyncCreatePending = false;
     DependencyGraph mDependencyGraph;
     tsl::htrie_map<char, std::vector<utils::Entity>> mNameToEntity;
     tsl::robin_map<utils::Entity, utils::CString> mNodeExtras;
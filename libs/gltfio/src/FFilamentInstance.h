@@ -32,16 +32,29 @@
 
 struct cgltf_node;
 
+namespace filament {
+    class SkinningBuffer;
+}
+
 namespace gltfio {
 
 struct FFilamentAsset;
 class Animator;
 
+// Bones are always bound in blocks of this size, see RenderableManager::setSkinningBuffer().
+static constexpr size_t SKINNING_SLOT_SIZE = 256;
+
 struct Skin {
     std::string name;
     std::vector<filament::math::mat4f> inverseBindMatrices;
     std::vector<utils::Entity> joints;
     std::vector<utils::Entity> targets;
+
+    // Bones of the targets, shared by all of them. Each target has its own slot of
+    // SKINNING_SLOT_SIZE bones, but targets with the same pose use the slot of the first one.
+    filament::SkinningBuffer* skinningBuffer = nullptr;
+    std::vector<filament::math::mat4f> palettes;    // content of the slots, as last uploaded
+    std::vector<uint32_t> boundSlots;               // slot used by each target
 };
 
 using SkinVector = std::vector<Skin>;
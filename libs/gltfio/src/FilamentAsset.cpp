@@ -69,6 +69,9 @@ FFilamentAsset::~FFilamentAsset() {
     for (auto ib : mIndexBuffers) {
         mEngine->destroy(ib);
     }
+    for (auto sb : mSkinningBuffers) {
+        mEngine->destroy(sb);
+    }
     for (auto tx : mTextures) {
         mEngine->destroy(tx);
     }
@@ -120,6 +123,13 @@ Entity FFilamentAsset::getWireframe() noexcept {
 }
 
 void FFilamentAsset::releaseSourceData() noexcept {
+    // The loader still reads the hierarchy, and the material and mesh caches, to create the
+    // remaining nodes.
+    if (mAsyncCreatePending) {
+        slog.e << "Cannot release source data while the asset is being created." << io::endl;
+        return;
+    }
+
     // To ensure that all possible memory is freed, we reassign to new containers rather than
     // calling clear(). With many container types (such as robin_map), clearing is a fast
     // operation that merely frees the storage for the items.
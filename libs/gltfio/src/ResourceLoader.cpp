@@ -115,7 +115,14 @@ struct ResourceLoader::Impl {
     JobSystem::Job* mDecoderRootJob = nullptr;
     FFilamentAsset* mCurrentAsset = nullptr;
 
-    void computeTangents(FFilamentAsset* asset);
+    using TangentsParams = std::vector<TangentsJob::Params>;
+
+    void createTangentJobs(FFilamentAsset* asset, TangentsParams* jobParams);
+    void decodeDracoMeshes(FFilamentAsset* asset, TangentsParams& tangents,
+            JobSystem::Job* tangentsRoot);
+    void runTangentJobs(TangentsParams& tangents, JobSystem::Job* tangentsRoot);
+    void uploadTangents(FFilamentAsset* asset, TangentsParams& tangents,
+            JobSystem::Job* tangentsRoot);
     bool createTextures(bool async);
     void cancelTextureDecoding();
     void addTextureCacheEntry(const TextureSlot& tb);
@@ -225,69 +232,34 @@ static void convertToFloats(float* dest, const cgltf_accessor* accessor) {
     transcode(dest, source, accessor->count);
 }
 
-static void decodeDracoMeshes(FFilamentAsset* asset) {
-    DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
-
-    // For a given primitive and attribute, find the corresponding accessor.
-    auto findAccessor = [](const cgltf_primitive* prim, cgltf_attribute_type type, cgltf_int idx) {
-        for (cgltf_size i = 0; i < prim->attributes_count; i++) {
-            const cgltf_attribute& attr = prim->attributes[i];
-            if (attr.type == type && attr.index == idx) {
-                return attr.data;
-            }
-        }
-        return (cgltf_accessor*) nullptr;
-    };
-
-    // Go through every primitive and check if it has a Draco mesh.
-    for (auto& pair : asset->mPrimitives) {
-        const cgltf_primitive* prim = pair.first;
-        if (!prim->has_draco_mesh_compression) {
-            continue;
-        }
-
-        const cgltf_draco_mesh_compression& draco = prim->draco_mesh_compression;
-
-        // If an error occurs, we can simply set the primitive's associated VertexBuffer to null.
-        // This does not cause a leak because it is a weak reference.
-        auto& vertexBuffer = pair.second;
-
-        // Check if we have already decoded this mesh.
-        DracoMesh* mesh = dracoCache->findOrCreateMesh(draco.buffer_view);
-        if (!mesh) {
-            slog.e << "Cannot decompress mesh, Draco decoding error." << io::endl;
-            vertexBuffer = nullptr;
-            continue;
-        }
-
-        // Copy over the decompressed data, converting the data type if necessary.
-        if (prim->indices && !mesh->getFaceIndices(prim->indices)) {
-            vertexBuffer = nullptr;
-            continue;
-        }
-
-        // Go through each attribute in the decompressed mesh.
-        for (cgltf_size i = 0; i < draco.attributes_count; i++) {
-
-            // In cgltf, each Draco attribute's data pointer is an attribute id, not an accessor.
-            const uint32_t id = draco.attributes[i].data - asset->mSourceAsset->hierarchy->accessors;
-
-            // Find the destination accessor; this contains the desired component type, etc.
-            const cgltf_attribute_type type = draco.attributes[i].type;
-            const cgltf_int index = draco.attributes[i].index;
-            cgltf_accessor* accessor = findAccessor(prim, type, index);
-            if (!accessor) {
-                slog.w << "Cannot find matching accessor for Draco id " << id << io::endl;
-                continue;
-            }
-
-            // Copy over the decompressed data, converting the data type if necessary.
-            if (!mesh->getVertexAttributes(id, accessor)) {
-                vertexBuffer = nullptr;
-                break;
-            }
-        }
+// Encodes float vertex data into the compact format chosen by AssetLoader, see BufferSlot.
+// Returns a malloc'd, tightly packed buffer.
+static void* encodeVertices(const BufferSlot& slot, size_t* size) {
+    const cgltf_accessor* accessor = slot.accessor;
+    if (slot.encoding == BufferSlot::Encoding::POSITION_SNORM16) {
+        auto bufferData = (const uint8_t*) accessor->buffer_view->buffer->data;
+        const uint8_t* source = computeBindingOffset(accessor) + bufferData;
+        const Box& bounds = slot.positionBounds;
+        *size = Transcoder::encodePositions(nullptr, source, accessor->count,
+                uint32_t(accessor->stride), bounds.center, bounds.halfExtent);
+        int16_t* data = (int16_t*) malloc(*size);
+        Transcoder::encodePositions(data, source, accessor->count,
+                uint32_t(accessor->stride), bounds.center, bounds.halfExtent);
+        return data;
     }
+    assert_invariant(slot.encoding == BufferSlot::Encoding::TEXCOORD_UNORM16);
+    Transcoder encode({
+        .componentType = ComponentType::USHORT,
+        .normalized = true,
+        .componentCount = 2
+    });
+    // the texture coordinates may be interleaved, but encode() needs packed floats
+    std::vector<float> floats(accessor->count * 2);
+    cgltf_accessor_unpack_floats(accessor, floats.data(), floats.size());
+    *size = encode.encode(nullptr, floats.data(), accessor->count);
+    void* data = malloc(*size);
+    encode.encode(data, floats.data(), accessor->count);
+    return data;
 }
 
 // Parses a data URI and returns a blob that gets malloc'd in cgltf, which the caller must free.
@@ -443,9 +415,17 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     }
     #endif
 
+    // Surface orientation quaternions are computed in jobs that run while the rest of the asset is
+    // being processed. They are all children of tangentsRoot, which is only waited on when the
+    // results are uploaded.
+    Impl::TangentsParams tangents;
+    pImpl->createTangentJobs(asset, &tangents);
+    JobSystem::Job* tangentsRoot = pImpl->mEngine->getJobSystem().createJob();
+
     // Decompress Draco meshes early on, which allows us to exploit subsequent processing such as
-    // tangent generation.
-    decodeDracoMeshes(asset);
+    // bounding box computation. Each mesh goes straight into tangent generation once decoded.
+    pImpl->decodeDracoMeshes(asset, tangents, tangentsRoot);
+    pImpl->runTangentJobs(tangents, tangentsRoot);
 
     // Normalize skinning weights, then "import" each skin into the asset by building a mapping of
     // skins to their affected entities.
@@ -485,6 +465,15 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
         const uint8_t* data = computeBindingOffset(accessor) + bufferData;
         const uint32_t size = computeBindingSize(accessor);
         if (slot.vertexBuffer) {
+            if (slot.encoding != BufferSlot::Encoding::NONE) {
+                size_t encodedSize;
+                void* encodedData = encodeVertices(slot, &encodedSize);
+                BufferObject* bo = BufferObject::Builder().size(encodedSize).build(engine);
+                asset->mBufferObjects.push_back(bo);
+                bo->setBuffer(engine, BufferDescriptor(encodedData, encodedSize, FREE_CALLBACK));
+                slot.vertexBuffer->setBufferObjectAt(engine, slot.bufferIndex, bo);
+                continue;
+            }
             if (requiresConversion(accessor->type, accessor->component_type)) {
                 const size_t dim = cgltf_num_components(accessor->type);
                 const size_t floatsSize = accessor->count * sizeof(float) * dim;
@@ -519,9 +508,9 @@ bool ResourceLoader::loadResources(FFilamentAsset* asset, bool async) {
     // Apply sparse data modifications to base arrays, then upload the result.
     applySparseData(asset);
 
-    // Compute surface orientation quaternions if necessary. This is similar to sparse data in that
+    // Upload surface orientation quaternions if necessary. This is similar to sparse data in that
     // we need to generate the contents of a GPU buffer by processing one or more CPU buffer(s).
-    pImpl->computeTangents(asset);
+    pImpl->uploadTangents(asset, tangents, tangentsRoot);
 
     // Non-textured renderables are now considered ready, so notify the dependency graph.
     asset->mDependencyGraph.finalize();
@@ -865,9 +854,7 @@ bool ResourceLoader::Impl::createTextures(bool async) {
     return true;
 }
 
-void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
-    SYSTRACE_CALL();
-
+void ResourceLoader::Impl::createTangentJobs(FFilamentAsset* asset, TangentsParams* jobParams) {
     const cgltf_accessor* kGenerateTangents = &asset->mGenerateTangents;
     const cgltf_accessor* kGenerateNormals = &asset->mGenerateNormals;
 
@@ -880,9 +867,10 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
         baseTangents[slot.vertexBuffer] = slot.bufferIndex;
     }
 
-    // Create a job description for each triangle-based primitive.
+    // Create a job description for each triangle-based primitive. Large primitives are further
+    // split into jobs by SurfaceOrientation.
     using Params = TangentsJob::Params;
-    std::vector<Params> jobParams;
+    JobSystem* js = &mEngine->getJobSystem();
     for (auto pair : asset->mPrimitives) {
         if (UTILS_UNLIKELY(pair.first->type != cgltf_primitive_type_triangles)) {
             continue;
@@ -890,21 +878,181 @@ void ResourceLoader::Impl::computeTangents(FFilamentAsset* asset) {
         VertexBuffer* vb = pair.second;
         auto iter = baseTangents.find(vb);
         if (iter != baseTangents.end()) {
-            jobParams.emplace_back(Params {{ pair.first }, {vb, iter->second }});
+            jobParams->emplace_back(Params {
+                    { pair.first, TangentsJob::kMorphTargetUnused, js }, { vb, iter->second }});
         }
     }
+}
 
-    // Kick off jobs for computing tangent frames.
+void ResourceLoader::Impl::decodeDracoMeshes(FFilamentAsset* asset, TangentsParams& tangents,
+        JobSystem::Job* tangentsRoot) {
+    SYSTRACE_CALL();
+
+    using Params = TangentsJob::Params;
+    DracoCache* dracoCache = &asset->mSourceAsset->dracoCache;
+    const cgltf_accessor* accessors = asset->mSourceAsset->hierarchy->accessors;
     JobSystem* js = &mEngine->getJobSystem();
+
+    // Primitives that share a Draco buffer view also share the decoded mesh and its accessors, so
+    // they are all processed by the job that decodes it. Jobs don't log, their problems are
+    // reported from this thread once they're all done.
+    struct DracoPrimitive {
+        const cgltf_primitive* prim;
+        VertexBuffer** vertexBuffer;
+        Params* tangents;
+        std::string error;
+        std::vector<std::string> warnings;
+    };
+    struct DracoJob {
+        const cgltf_buffer_view* bufferView;
+        bool cached;
+        DracoMesh* mesh;
+        std::vector<DracoPrimitive> primitives;
+    };
+
+    tsl::robin_map<const cgltf_primitive*, Params*> primitiveTangents;
+    for (Params& params : tangents) {
+        primitiveTangents[params.in.prim] = &params;
+    }
+
+    // Go through every primitive and check if it has a Draco mesh.
+    tsl::robin_map<const cgltf_buffer_view*, size_t> jobIndices;
+    std::vector<DracoJob> dracoJobs;
+    for (auto& pair : asset->mPrimitives) {
+        const cgltf_primitive* prim = pair.first;
+        if (!prim->has_draco_mesh_compression) {
+            continue;
+        }
+        const cgltf_buffer_view* bufferView = prim->draco_mesh_compression.buffer_view;
+        auto iter = jobIndices.find(bufferView);
+        if (iter == jobIndices.end()) {
+            iter = jobIndices.emplace(bufferView, dracoJobs.size()).first;
+            // Check if we have already decoded this mesh, or failed to.
+            DracoMesh* mesh = nullptr;
+            const bool cached = dracoCache->findMesh(bufferView, &mesh);
+            dracoJobs.push_back({ bufferView, cached, mesh });
+        }
+        auto tangentsIter = primitiveTangents.find(prim);
+        dracoJobs[iter->second].primitives.push_back({ prim, &pair.second,
+                tangentsIter != primitiveTangents.end() ? tangentsIter->second : nullptr });
+    }
+
+    if (dracoJobs.empty()) {
+        return;
+    }
+
+    // For a given primitive and attribute, find the corresponding accessor.
+    auto findAccessor = [](const cgltf_primitive* prim, cgltf_attribute_type type, cgltf_int idx) {
+        for (cgltf_size i = 0; i < prim->attributes_count; i++) {
+            const cgltf_attribute& attr = prim->attributes[i];
+            if (attr.type == type && attr.index == idx) {
+                return attr.data;
+            }
+        }
+        return (cgltf_accessor*) nullptr;
+    };
+
+    // Copies the decompressed data of a primitive, converting the data type if necessary.
+    auto extractPrimitive = [findAccessor, accessors](DracoMesh* mesh, DracoPrimitive& primitive) {
+        const cgltf_primitive* prim = primitive.prim;
+        if (prim->indices && !mesh->getFaceIndices(prim->indices, &primitive.error)) {
+            return false;
+        }
+
+        // Go through each attribute in the decompressed mesh.
+        const cgltf_draco_mesh_compression& draco = prim->draco_mesh_compression;
+        for (cgltf_size i = 0; i < draco.attributes_count; i++) {
+
+            // In cgltf, each Draco attribute's data pointer is an attribute id, not an accessor.
+            const uint32_t id = draco.attributes[i].data - accessors;
+
+            // Find the destination accessor; this contains the desired component type, etc.
+            const cgltf_attribute_type type = draco.attributes[i].type;
+            const cgltf_int index = draco.attributes[i].index;
+            cgltf_accessor* accessor = findAccessor(prim, type, index);
+            if (!accessor) {
+                primitive.warnings.push_back(
+                        "Cannot find matching accessor for Draco id " + std::to_string(id));
+                continue;
+            }
+
+            // Copy over the decompressed data, converting the data type if necessary.
+            if (!mesh->getVertexAttributes(id, accessor, &primitive.error)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Decode each mesh in its own job, then immediately kick off tangent generation for its
+    // primitives. If an error occurs, we can simply set the primitive's associated VertexBuffer
+    // to null. This does not cause a leak because it is a weak reference.
     JobSystem::Job* parent = js->createJob();
-    for (Params& params : jobParams) {
-        Params* pptr = &params;
-        js->run(jobs::createJob(*js, parent, [pptr] { TangentsJob::run(pptr); }));
+    for (DracoJob& job : dracoJobs) {
+        DracoJob* jptr = &job;
+        js->run(jobs::createJob(*js, parent, [js, jptr, tangentsRoot, extractPrimitive] {
+            if (!jptr->cached) {
+                jptr->mesh = DracoCache::decodeMesh(jptr->bufferView);
+            }
+            for (DracoPrimitive& primitive : jptr->primitives) {
+                if (!jptr->mesh) {
+                    primitive.error = "Cannot decompress mesh, Draco decoding error.";
+                    *primitive.vertexBuffer = nullptr;
+                    continue;
+                }
+                if (!extractPrimitive(jptr->mesh, primitive)) {
+                    *primitive.vertexBuffer = nullptr;
+                    continue;
+                }
+                if (Params* pptr = primitive.tangents) {
+                    js->run(jobs::createJob(*js, tangentsRoot, [pptr] { TangentsJob::run(pptr); }));
+                }
+            }
+        }));
     }
     js->runAndWait(parent);
 
-    // Finally, upload quaternions to the GPU from the main thread.
-    for (Params& params : jobParams) {
+    // Hand the newly decoded meshes, and the failures, over to the cache, then report problems.
+    for (DracoJob& job : dracoJobs) {
+        if (!job.cached) {
+            dracoCache->addMesh(job.bufferView, job.mesh);
+        }
+        for (DracoPrimitive const& primitive : job.primitives) {
+            for (std::string const& warning : primitive.warnings) {
+                slog.w << warning.c_str() << io::endl;
+            }
+            if (!primitive.error.empty()) {
+                slog.e << primitive.error.c_str() << io::endl;
+            }
+        }
+    }
+}
+
+void ResourceLoader::Impl::runTangentJobs(TangentsParams& tangents, JobSystem::Job* tangentsRoot) {
+    // Kick off jobs for computing tangent frames. Those of Draco primitives have been started by
+    // the decoding jobs.
+    JobSystem* js = &mEngine->getJobSystem();
+    for (TangentsJob::Params& params : tangents) {
+        if (!params.in.prim->has_draco_mesh_compression) {
+            TangentsJob::Params* pptr = &params;
+            js->run(jobs::createJob(*js, tangentsRoot, [pptr] { TangentsJob::run(pptr); }));
+        }
+    }
+}
+
+void ResourceLoader::Impl::uploadTangents(FFilamentAsset* asset, TangentsParams& tangents,
+        JobSystem::Job* tangentsRoot) {
+    SYSTRACE_CALL();
+
+    JobSystem* js = &mEngine->getJobSystem();
+    js->runAndWait(tangentsRoot);
+
+    // Finally, upload quaternions to the GPU from the main thread. Primitives that failed to
+    // decode have no results.
+    for (TangentsJob::Params& params : tangents) {
+        if (!params.out.results) {
+            continue;
+        }
         BufferObject* bo = BufferObject::Builder()
                 .size(params.out.vertexCount * sizeof(short4)).build(*mEngine);
         asset->mBufferObjects.push_back(bo);
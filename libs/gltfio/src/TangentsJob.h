@@ -19,6 +19,7 @@
 #include <math/vec4.h>
 
 namespace filament { class VertexBuffer; }
+namespace utils { class JobSystem; }
 
 namespace gltfio {
 
@@ -31,10 +32,12 @@ struct TangentsJob {
     static constexpr int kMorphTargetUnused = -1;
 
     // The inputs to the procedure. The prim is owned by the client, which should ensure that it
-    // stays alive for the duration of the procedure.
+    // stays alive for the duration of the procedure. If a job system is provided, large primitives
+    // are split into jobs; the procedure must then run on one of its threads, e.g. in a job.
     struct InputParams {
         const cgltf_primitive* prim;
         const int morphTargetIndex = kMorphTargetUnused;
+        utils::JobSystem* const jobSystem = nullptr;
     };
 
     // The context of the procedure. These fields are not used by the procedure but are provided as
@@ -0,0 +1,672 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <gltfio/Animator.h>
+#include <gltfio/AssetLoader.h>
+#include <gltfio/FilamentAsset.h>
+#include <gltfio/MaterialProvider.h>
+#include <gltfio/ResourceLoader.h>
+
+#include <filament/Box.h>
+#include <filament/Engine.h>
+#include <filament/RenderableManager.h>
+#include <filament/TransformManager.h>
+
+#include <geometry/Transcoder.h>
+
+#include <utils/EntityManager.h>
+#include <utils/NameComponentManager.h>
+
+#include <math/mat4.h>
+#include <math/quat.h>
+#include <math/vec2.h>
+#include <math/vec3.h>
+
+#include "../src/FFilamentAsset.h"
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+using namespace filament;
+using namespace filament::math;
+using namespace gltfio;
+using namespace utils;
+
+namespace {
+
+/*
+ * Builds a glTF asset in memory. Accessors are appended to a single binary buffer, named
+ * "test.bin", which must be given to the ResourceLoader with addResourceData().
+ */
+class GltfBuilder {
+public:
+    // Adds an accessor of floats and returns its index. type is SCALAR, VEC2, VEC3, VEC4 or MAT4.
+    int addAccessor(std::vector<float> const& values, const char* type) {
+        const size_t components = getComponentCount(type);
+        // animation inputs and positions must have min and max, we always give them
+        std::vector<float> lo(values.begin(), values.begin() + components);
+        std::vector<float> hi = lo;
+        for (size_t i = 0; i < values.size(); i++) {
+            lo[i % components] = std::min(lo[i % components], values[i]);
+            hi[i % components] = std::max(hi[i % components], values[i]);
+        }
+        return addAccessor(values.data(), values.size() * sizeof(float), 5126,
+                values.size() / components, type,
+                ",\"min\":" + toJson(lo) + ",\"max\":" + toJson(hi));
+    }
+
+    // Adds an accessor of unsigned bytes and returns its index, used for joint indices.
+    int addAccessor(std::vector<uint8_t> const& values, const char* type) {
+        return addAccessor(values.data(), values.size(), 5121,
+                values.size() / getComponentCount(type), type, "");
+    }
+
+    // Returns the JSON of the asset, body holds the remaining top-level properties.
+    std::string getJson(std::string const& body) const {
+        return "{\"asset\":{\"version\":\"2.0\"},"
+                "\"buffers\":[{\"uri\":\"test.bin\",\"byteLength\":" +
+                std::to_string(mBin.size()) + "}],"
+                "\"bufferViews\":[" + mBufferViews + "],"
+                "\"accessors\":[" + mAccessors + "]," + body + "}";
+    }
+
+    ResourceLoader::BufferDescriptor getBuffer() const {
+        void* data = malloc(mBin.size());
+        memcpy(data, mBin.data(), mBin.size());
+        return ResourceLoader::BufferDescriptor(data, mBin.size(),
+                [](void* buffer, size_t, void*) { free(buffer); });
+    }
+
+private:
+    int addAccessor(const void* data, size_t size, int componentType, size_t count,
+            const char* type, std::string const& properties) {
+        // keeps the data of every accessor aligned
+        const size_t offset = (mBin.size() + 3) & ~size_t(3);
+        mBin.resize(offset + size);
+        memcpy(mBin.data() + offset, data, size);
+
+        const int index = mAccessorCount++;
+        append(mBufferViews, "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) +
+                ",\"byteLength\":" + std::to_string(size) + "}");
+        append(mAccessors, "{\"bufferView\":" + std::to_string(index) +
+                ",\"componentType\":" + std::to_string(componentType) +
+                ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"" +
+                properties + "}");
+        return index;
+    }
+
+    static size_t getComponentCount(const char* type) {
+        return !strcmp(type, "SCALAR") ? 1 : !strcmp(type, "VEC2") ? 2 :
+                !strcmp(type, "VEC3") ? 3 : !strcmp(type, "VEC4") ? 4 : 16;
+    }
+
+    static std::string toJson(std::vector<float> const& values) {
+        std::string json;
+        for (float v : values) {
+            append(json, std::to_string(v));
+        }
+        return "[" + json + "]";
+    }
+
+    static void append(std::string& list, std::string const& item) {
+        list += (list.empty() ? "" : ",") + item;
+    }
+
+    std::vector<uint8_t> mBin;
+    std::string mBufferViews;
+    std::string mAccessors;
+    int mAccessorCount = 0;
+};
+
+std::string toJson(float3 v) {
+    return "[" + std::to_string(v.x) + "," + std::to_string(v.y) + "," +
+            std::to_string(v.z) + "]";
+}
+
+std::vector<float> toValues(std::vector<quatf> const& quats) {
+    std::vector<float> values;
+    for (quatf q : quats) {
+        values.insert(values.end(), { q.x, q.y, q.z, q.w });
+    }
+    return values;
+}
+
+std::vector<float> toValues(std::vector<float3> const& vectors) {
+    std::vector<float> values;
+    for (float3 v : vectors) {
+        values.insert(values.end(), { v.x, v.y, v.z });
+    }
+    return values;
+}
+
+mat4f compose(float3 translation, quatf rotation, float3 scale) {
+    return mat4f::translation(translation) * mat4f(rotation) * mat4f::scaling(scale);
+}
+
+void expectNear(mat4f const& actual, mat4f const& expected, float tolerance = 1e-5f) {
+    for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+            EXPECT_NEAR(actual[c][r], expected[c][r], tolerance) << "at [" << c << "][" << r << "]";
+        }
+    }
+}
+
+} // anonymous namespace
+
+class GltfioTest : public testing::Test {
+protected:
+    void SetUp() override {
+        engine = Engine::create(Engine::Backend::NOOP);
+        names = new NameComponentManager(EntityManager::get());
+        materials = createUbershaderLoader(engine);
+        loader = AssetLoader::create({ engine, materials, names });
+    }
+
+    void TearDown() override {
+        for (FilamentAsset* asset : assets) {
+            loader->destroyAsset(asset);
+        }
+        AssetLoader::destroy(&loader);
+        materials->destroyMaterials();
+        delete materials;
+        delete names;
+        Engine::destroy(&engine);
+    }
+
+    FilamentAsset* load(GltfBuilder const& builder, std::string const& body) {
+        const std::string json = builder.getJson(body);
+        FilamentAsset* asset = loader->createAssetFromJson((const uint8_t*) json.data(),
+                uint32_t(json.size()));
+        if (!asset) {
+            return nullptr;
+        }
+        assets.push_back(asset);
+        ResourceLoader resourceLoader({ engine, nullptr, false, false, false });
+        resourceLoader.addResourceData("test.bin", builder.getBuffer());
+        resourceLoader.loadResources(asset);
+        return asset;
+    }
+
+    mat4f getTransform(FilamentAsset* asset, const char* name) {
+        TransformManager& tm = engine->getTransformManager();
+        return tm.getTransform(tm.getInstance(asset->getFirstEntityByName(name)));
+    }
+
+    Engine* engine = nullptr;
+    NameComponentManager* names = nullptr;
+    MaterialProvider* materials = nullptr;
+    AssetLoader* loader = nullptr;
+    std::vector<FilamentAsset*> assets;
+};
+
+// The translation, rotation and scale of a node are sampled together and composed into a single
+// matrix. A node with only some animated components keeps the others from its current transform.
+TEST_F(GltfioTest, AnimationComposesTargetTransforms) {
+    const std::vector<float> times = { 0.0f, 1.0f, 2.0f };
+    const std::vector<float3> translations = {{ 0, 0, 0 }, { 2, 4, 6 }, { -2, 0, 2 }};
+    const std::vector<quatf> rotations = {
+            quatf::fromAxisAngle(float3{ 0, 1, 0 }, 0.0f),
+            quatf::fromAxisAngle(float3{ 0, 1, 0 }, 1.0f),
+            quatf::fromAxisAngle(float3{ 1, 0, 0 }, 0.5f) };
+    const std::vector<float3> scales = {{ 1, 1, 1 }, { 2, 3, 4 }, { 1, 2, 1 }};
+
+    // Enough nodes share the translation sampler to evaluate the targets in parallel.
+    constexpr int SHARED_COUNT = 100;
+
+    GltfBuilder builder;
+    const int input = builder.addAccessor(times, "SCALAR");
+    const int translation = builder.addAccessor(toValues(translations), "VEC3");
+    const int rotation = builder.addAccessor(toValues(rotations), "VEC4");
+    const int scale = builder.addAccessor(toValues(scales), "VEC3");
+
+    const float3 restTranslation{ 1, 2, 3 };
+    const float3 restScale{ 2, 2, 2 };
+
+    std::string nodes = "{\"name\":\"trs\"},{\"name\":\"rotation\",\"translation\":" +
+            toJson(restTranslation) + ",\"scale\":" + toJson(restScale) + "}";
+    std::string sceneNodes = "0,1";
+    std::string channels =
+            "{\"sampler\":0,\"target\":{\"node\":0,\"path\":\"translation\"}},"
+            "{\"sampler\":1,\"target\":{\"node\":0,\"path\":\"rotation\"}},"
+            "{\"sampler\":2,\"target\":{\"node\":0,\"path\":\"scale\"}},"
+            "{\"sampler\":1,\"target\":{\"node\":1,\"path\":\"rotation\"}}";
+    for (int i = 0; i < SHARED_COUNT; i++) {
+        const int node = 2 + i;
+        nodes += ",{\"name\":\"shared" + std::to_string(i) + "\"}";
+        sceneNodes += "," + std::to_string(node);
+        channels += ",{\"sampler\":0,\"target\":{\"node\":" + std::to_string(node) +
+                ",\"path\":\"translation\"}}";
+    }
+
+    auto sampler = [input](int output) {
+        return "{\"input\":" + std::to_string(input) + ",\"output\":" +
+                std::to_string(output) + ",\"interpolation\":\"LINEAR\"}";
+    };
+
+    FilamentAsset* asset = load(builder,
+            "\"nodes\":[" + nodes + "],"
+            "\"scenes\":[{\"nodes\":[" + sceneNodes + "]}],\"scene\":0,"
+            "\"animations\":[{\"samplers\":[" + sampler(translation) + "," +
+            sampler(rotation) + "," + sampler(scale) + "],"
+            "\"channels\":[" + channels + "]}]");
+    ASSERT_NE(asset, nullptr);
+
+    Animator* animator = asset->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 1);
+    EXPECT_FLOAT_EQ(animator->getAnimationDuration(0), 2.0f);
+
+    auto check = [&](float time, size_t k, float t) {
+        animator->applyAnimation(0, time);
+        const float3 expectedTranslation = (1 - t) * translations[k] + t * translations[k + 1];
+        const quatf expectedRotation = slerp(rotations[k], rotations[k + 1], t);
+        const float3 expectedScale = (1 - t) * scales[k] + t * scales[k + 1];
+
+        expectNear(getTransform(asset, "trs"),
+                compose(expectedTranslation, expectedRotation, expectedScale));
+        expectNear(getTransform(asset, "rotation"),
+                compose(restTranslation, expectedRotation, restScale));
+        for (int i = 0; i < SHARED_COUNT; i++) {
+            const std::string name = "shared" + std::to_string(i);
+            expectNear(getTransform(asset, name.c_str()),
+                    mat4f::translation(expectedTranslation));
+        }
+    };
+
+    check(0.5f, 0, 0.5f);
+    check(1.75f, 1, 0.75f);
+    // going back in time, like when an animation loops
+    check(0.25f, 0, 0.25f);
+}
+
+// Layers are blended component by component, with the weights of the layers that animate them.
+TEST_F(GltfioTest, AnimationBlendsLayers) {
+    const std::vector<float> times = { 0.0f, 1.0f };
+    const std::vector<float3> translationsA = {{ 0, 0, 0 }, { 4, 0, 0 }};
+    const std::vector<float3> translationsB = {{ 0, 8, 0 }, { 0, 0, 0 }};
+    const std::vector<quatf> rotationsA = {
+            quatf::fromAxisAngle(float3{ 0, 0, 1 }, 0.0f),
+            quatf::fromAxisAngle(float3{ 0, 0, 1 }, 1.0f) };
+
+    GltfBuilder builder;
+    const int input = builder.addAccessor(times, "SCALAR");
+    const int translationA = builder.addAccessor(toValues(translationsA), "VEC3");
+    const int translationB = builder.addAccessor(toValues(translationsB), "VEC3");
+    const int rotationA = builder.addAccessor(toValues(rotationsA), "VEC4");
+
+    auto sampler = [input](int output) {
+        return "{\"input\":" + std::to_string(input) + ",\"output\":" +
+                std::to_string(output) + ",\"interpolation\":\"LINEAR\"}";
+    };
+
+    // Animation A moves and rotates the node, animation B only moves it.
+    FilamentAsset* asset = load(builder,
+            "\"nodes\":[{\"name\":\"node\"}],"
+            "\"scenes\":[{\"nodes\":[0]}],\"scene\":0,"
+            "\"animations\":["
+            "{\"samplers\":[" + sampler(translationA) + "," + sampler(rotationA) + "],"
+            "\"channels\":[{\"sampler\":0,\"target\":{\"node\":0,\"path\":\"translation\"}},"
+            "{\"sampler\":1,\"target\":{\"node\":0,\"path\":\"rotation\"}}]},"
+            "{\"samplers\":[" + sampler(translationB) + "],"
+            "\"channels\":[{\"sampler\":0,\"target\":{\"node\":0,\"path\":\"translation\"}}]}]");
+    ASSERT_NE(asset, nullptr);
+
+    Animator* animator = asset->getAnimator();
+    ASSERT_EQ(animator->getAnimationCount(), 2);
+
+    const Animator::AnimationLayer layers[] = {
+            { 0, 0.5f, 1.0f },
+            { 1, 0.25f, 3.0f },
+            { 1, 1.0f, 0.0f },  // skipped
+    };
+    animator->applyAnimations(layers, 3);
+
+    // the rotation is only animated by the first layer, which has full control over it
+    const float3 expectedTranslation = (1.0f * float3{ 2, 0, 0 } + 3.0f * float3{ 0, 6, 0 }) / 4.0f;
+    const quatf expectedRotation = slerp(rotationsA[0], rotationsA[1], 0.5f);
+    expectNear(getTransform(asset, "node"), compose(expectedTranslation, expectedRotation, 1.0f));
+
+    // a single layer of weight 1 is the same as applyAnimation()
+    animator->applyAnimation(1, 0.25f);
+    const mat4f single = getTransform(asset, "node");
+    const Animator::AnimationLayer layer = { 1, 0.25f, 1.0f };
+    animator->applyAnimations(&layer, 1);
+    expectNear(getTransform(asset, "node"), single, 0.0f);
+}
+
+// Compressed animations stay within the tolerance of the original ones, at any time.
+TEST_F(GltfioTest, AnimationCompressionWithinTolerance) {
+    constexpr size_t KEYFRAME_COUNT = 240;
+    constexpr float DURATION = 4.0f;
+
+    std::vector<float> times;
+    std::vector<float3> translations;
+    std::vector<quatf> rotations;
+    std::vector<float3> scales;
+    for (size_t i = 0; i < KEYFRAME_COUNT; i++) {
+        const float t = DURATION * float(i) / float(KEYFRAME_COUNT - 1);
+        times.push_back(t);
+        // a mix of smooth curves, straight lines and plateaus that compression can exploit
+        translations.push_back({ std::sin(t * 3.0f), t * 0.5f, t < 2.0f ? 1.0f : std::cos(t) });
+        rotations.push_back(quatf::fromAxisAngle(normalize(float3{ 1, 2, 3 }), t * 1.5f) *
+                quatf::fromAxisAngle(float3{ 1, 0, 0 }, 0.3f * std::sin(t * 5.0f)));
+        scales.push_back(float3{ 1.0f + 0.25f * std::sin(t * 2.0f), 1.0f, 1.0f + 0.1f * t });
+    }
+
+    GltfBuilder builder;
+    const int input = builder.addAccessor(times, "SCALAR");
+    const int translation = builder.addAccessor(toValues(translations), "VEC3");
+    const int rotation = builder.addAccessor(toValues(rotations), "VEC4");
+    const int scale = builder.addAccessor(toValues(scales), "VEC3");
+
+    auto sampler = [input](int output) {
+        return "{\"input\":" + std::to_string(input) + ",\"output\":" +
+                std::to_string(output) + ",\"interpolation\":\"LINEAR\"}";
+    };
+
+    // Each component animates its own node, so that their errors can be measured separately.
+    FilamentAsset* asset = load(builder,
+            "\"nodes\":[{\"name\":\"translation\"},{\"name\":\"rotation\"},{\"name\":\"scale\"}],"
+            "\"scenes\":[{\"nodes\":[0,1,2]}],\"scene\":0,"
+            "\"animations\":[{\"samplers\":[" + sampler(translation) + "," +
+            sampler(rotation) + "," + sampler(scale) + "],"
+            "\"channels\":[{\"sampler\":0,\"target\":{\"node\":0,\"path\":\"translation\"}},"
+            "{\"sampler\":1,\"target\":{\"node\":1,\"path\":\"rotation\"}},"
+            "{\"sampler\":2,\"target\":{\"node\":2,\"path\":\"scale\"}}]}]");
+    ASSERT_NE(asset, nullptr);
+
+    Animator* animator = asset->getAnimator();
+
+    // sample in between keyframes too
+    constexpr size_t SAMPLE_COUNT = KEYFRAME_COUNT * 4;
+    auto evaluate = [&]() {
+        std::vector<mat4f> transforms;
+        for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+            animator->applyAnimation(0, DURATION * float(i) / float(SAMPLE_COUNT - 1));
+            transforms.push_back(getTransform(asset, "translation"));
+            transforms.push_back(getTransform(asset, "rotation"));
+            transforms.push_back(getTransform(asset, "scale"));
+        }
+        return transforms;
+    };
+
+    const std::vector<mat4f> original = evaluate();
+    const Animator::KeyframeTolerance tolerance;
+    animator->compressAnimations(tolerance);
+    EXPECT_FLOAT_EQ(animator->getAnimationDuration(0), DURATION);
+    const std::vector<mat4f> compressed = evaluate();
+
+    // allows for the float precision of the evaluation
+    constexpr float EPSILON = 1e-5f;
+    for (size_t i = 0; i < SAMPLE_COUNT; i++) {
+        const mat4f* before = original.data() + i * 3;
+        const mat4f* after = compressed.data() + i * 3;
+
+        const float translationError = max(abs(after[0][3].xyz - before[0][3].xyz));
+        EXPECT_LE(translationError, tolerance.translation + EPSILON) << "at sample " << i;
+
+        const quatf q0 = mat3f(before[1].upperLeft()).toQuaternion();
+        const quatf q1 = mat3f(after[1].upperLeft()).toQuaternion();
+        const float d = std::min(length(q1 - q0), length(q1 + q0));
+        const float angle = 4.0f * std::asin(std::min(1.0f, d * 0.5f));
+        EXPECT_LE(angle, tolerance.rotation + EPSILON) << "at sample " << i;
+
+        const float3 s0 = { before[2][0].x, before[2][1].y, before[2][2].z };
+        const float3 s1 = { after[2][0].x, after[2][1].y, after[2][2].z };
+        EXPECT_LE(max(abs(s1 - s0)), tolerance.scale + EPSILON) << "at sample " << i;
+    }
+}
+
+// The renderables of a skin that have the same world transform share a single palette of bones.
+TEST_F(GltfioTest, SkinPaletteIsShared) {
+    GltfBuilder builder;
+    const int position = builder.addAccessor(std::vector<float>{
+            0, 0, 0, 1, 0, 0, 0, 1, 0 }, "VEC3");
+    const int joints = builder.addAccessor(std::vector<uint8_t>{
+            0, 1, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0 }, "VEC4");
+    const int weights = builder.addAccessor(std::vector<float>{
+            0.5f, 0.5f, 0, 0, 0.25f, 0.75f, 0, 0, 1, 0, 0, 0 }, "VEC4");
+    std::vector<float> inverseBindMatrices;
+    for (const mat4f& m : { mat4f::translation(float3{ 0, -1, 0 }),
+            mat4f::translation(float3{ 0, -2, 0 }) }) {
+        inverseBindMatrices.insert(inverseBindMatrices.end(), &m[0][0], &m[0][0] + 16);
+    }
+    const int bindings = builder.addAccessor(inverseBindMatrices, "MAT4");
+
+    // Two skinned meshes at the same place, and a chain of two joints.
+    FilamentAsset* asset = load(builder,
+            "\"nodes\":[{\"name\":\"body\",\"mesh\":0,\"skin\":0},"
+            "{\"name\":\"clothes\",\"mesh\":0,\"skin\":0},"
+            "{\"name\":\"hip\",\"translation\":[0,1,0],\"children\":[3]},"
+            "{\"name\":\"knee\",\"translation\":[0,1,0],\"rotation\":[0,0,0.5,0.8660254]}],"
+            "\"scenes\":[{\"nodes\":[0,1,2]}],\"scene\":0,"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{"
+            "\"POSITION\":" + std::to_string(position) + ","
+            "\"JOINTS_0\":" + std::to_string(joints) + ","
+            "\"WEIGHTS_0\":" + std::to_string(weights) + "}}]}],"
+            "\"skins\":[{\"joints\":[2,3],"
+            "\"inverseBindMatrices\":" + std::to_string(bindings) + "}]");
+    ASSERT_NE(asset, nullptr);
+
+    FFilamentAsset* fasset = upcast(asset);
+    ASSERT_EQ(fasset->mSkins.size(), 1);
+    Skin const& skin = fasset->mSkins[0];
+    ASSERT_EQ(skin.targets.size(), 2);
+    ASSERT_EQ(skin.joints.size(), 2);
+    ASSERT_NE(skin.skinningBuffer, nullptr);
+
+    TransformManager& tm = engine->getTransformManager();
+    auto expectPalette = [&](uint32_t slot, Entity target) {
+        const mat4f inverseTarget = inverse(tm.getWorldTransform(tm.getInstance(target)));
+        for (size_t i = 0; i < skin.joints.size(); i++) {
+            const mat4f joint = tm.getWorldTransform(tm.getInstance(skin.joints[i]));
+            expectNear(skin.palettes[slot * skin.joints.size() + i],
+                    inverseTarget * joint * skin.inverseBindMatrices[i]);
+        }
+    };
+
+    Animator* animator = asset->getAnimator();
+    const Entity body = asset->getFirstEntityByName("body");
+    const Entity clothes = asset->getFirstEntityByName("clothes");
+
+    // both targets use the palette of the first one, the second slot isn't computed
+    animator->updateBoneMatrices();
+    EXPECT_EQ(skin.boundSlots, std::vector<uint32_t>({ 0, 0 }));
+    expectPalette(0, body);
+    expectNear(skin.palettes[skin.joints.size()], mat4f());
+
+    // a target that moves away gets a palette of its own
+    tm.setTransform(tm.getInstance(clothes), mat4f::translation(float3{ 3, 0, 0 }));
+    animator->updateBoneMatrices();
+    EXPECT_EQ(skin.boundSlots, std::vector<uint32_t>({ 0, 1 }));
+    expectPalette(0, body);
+    expectPalette(1, clothes);
+
+    // and shares it again when it's back
+    tm.setTransform(tm.getInstance(clothes), mat4f());
+    animator->updateBoneMatrices();
+    EXPECT_EQ(skin.boundSlots, std::vector<uint32_t>({ 0, 0 }));
+    expectPalette(0, body);
+}
+
+// With quantizeVertices, positions are encoded relative to the bounds of their mesh, which the
+// renderable dequantizes, and texture coordinates within [0, 1] are normalized.
+TEST_F(GltfioTest, QuantizedVerticesMapBackToPositions) {
+    AssetLoader::destroy(&loader);
+    AssetConfiguration config = { engine, materials, names };
+    config.quantizeVertices = true;
+    loader = AssetLoader::create(config);
+
+    // a flat triangle, its z axis has no extent
+    const std::vector<float3> positions = {{ -1, 0, 2 }, { 3, 1, 2 }, { 0, 5, 2 }};
+    GltfBuilder builder;
+    const int position = builder.addAccessor(toValues(positions), "VEC3");
+    const int uvs = builder.addAccessor(std::vector<float>{ 0, 0, 1, 0, 0.5f, 1 }, "VEC2");
+    const int wrappedUvs = builder.addAccessor(std::vector<float>{ 0, 0, 2, 0, 1, 2 }, "VEC2");
+    const int joints = builder.addAccessor(std::vector<uint8_t>{
+            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, "VEC4");
+    const int weights = builder.addAccessor(std::vector<float>{
+            1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0 }, "VEC4");
+
+    auto mesh = [position](std::string const& attributes) {
+        return "{\"primitives\":[{\"attributes\":{\"POSITION\":" + std::to_string(position) +
+                "," + attributes + "}}]}";
+    };
+
+    FilamentAsset* asset = load(builder,
+            "\"nodes\":[{\"name\":\"quantized\",\"mesh\":0},"
+            "{\"name\":\"wrapped\",\"mesh\":1},"
+            "{\"name\":\"skinned\",\"mesh\":2,\"skin\":0},{\"name\":\"joint\"}],"
+            "\"scenes\":[{\"nodes\":[0,1,2,3]}],\"scene\":0,"
+            "\"meshes\":[" +
+            mesh("\"TEXCOORD_0\":" + std::to_string(uvs)) + "," +
+            mesh("\"TEXCOORD_0\":" + std::to_string(wrappedUvs)) + "," +
+            mesh("\"JOINTS_0\":" + std::to_string(joints) + ","
+                 "\"WEIGHTS_0\":" + std::to_string(weights)) + "],"
+            "\"skins\":[{\"joints\":[3]}]");
+    ASSERT_NE(asset, nullptr);
+
+    FFilamentAsset* fasset = upcast(asset);
+    cgltf_data const* hierarchy = fasset->mSourceAsset->hierarchy;
+    const Box bounds = Box().set(float3{ -1, 0, 2 }, float3{ 3, 5, 2 });
+
+    // the encoding of each vertex accessor
+    std::vector<BufferSlot::Encoding> encodings(hierarchy->accessors_count,
+            BufferSlot::Encoding::NONE);
+    size_t positionCount = 0;
+    size_t quantizedCount = 0;
+    for (BufferSlot const& slot : fasset->mBufferSlots) {
+        if (!slot.vertexBuffer) {
+            continue;
+        }
+        encodings[slot.accessor - hierarchy->accessors] = slot.encoding;
+        if (slot.attribute == cgltf_attribute_type_position) {
+            positionCount++;
+            if (slot.encoding == BufferSlot::Encoding::POSITION_SNORM16) {
+                quantizedCount++;
+                EXPECT_EQ(slot.positionBounds.center, bounds.center);
+                EXPECT_EQ(slot.positionBounds.halfExtent, bounds.halfExtent);
+            }
+        }
+    }
+    // the skinned mesh shares its positions with the others, but keeps them as floats
+    EXPECT_EQ(positionCount, 3);
+    EXPECT_EQ(quantizedCount, 2);
+    EXPECT_EQ(encodings[uvs], BufferSlot::Encoding::TEXCOORD_UNORM16);
+    EXPECT_EQ(encodings[wrappedUvs], BufferSlot::Encoding::NONE);
+
+    // the encoded positions map back to the original ones, within the precision of a short
+    int16_t encoded[3 * 4];
+    geometry::Transcoder::encodePositions(encoded, positions.data(), positions.size(), 0,
+            bounds.center, bounds.halfExtent);
+    for (size_t i = 0; i < positions.size(); i++) {
+        const float3 q = float3(encoded[i * 4], encoded[i * 4 + 1], encoded[i * 4 + 2]) / 32767.0f;
+        const float3 p = bounds.center + q * bounds.halfExtent;
+        const float3 error = abs(p - positions[i]);
+        EXPECT_LE(max(error), max(bounds.halfExtent) / 32767.0f) << "position " << i;
+        EXPECT_EQ(encoded[i * 4 + 3], 32767);
+    }
+
+    // culling still uses the bounds of the original positions
+    RenderableManager& rcm = engine->getRenderableManager();
+    for (const char* name : { "quantized", "wrapped", "skinned" }) {
+        const Box box = rcm.getAxisAlignedBoundingBox(
+                rcm.getInstance(asset->getFirstEntityByName(name)));
+        EXPECT_EQ(box.center, bounds.center) << name;
+        EXPECT_EQ(box.halfExtent, bounds.halfExtent) << name;
+    }
+}
+
+// Creating an asset incrementally gives the same entities, in the same hierarchy, as creating it
+// at once. Its source data stays until all of them are created.
+TEST_F(GltfioTest, AsyncCreateSameAsBinary) {
+    GltfBuilder builder;
+    const int position = builder.addAccessor(std::vector<float>{
+            0, 0, 0, 1, 0, 0, 0, 1, 0 }, "VEC3");
+    const std::string json = builder.getJson(
+            "\"nodes\":[{\"name\":\"body\",\"children\":[1,2]},"
+            "{\"name\":\"arm\",\"mesh\":0,\"translation\":[1,0,0]},"
+            "{\"name\":\"leg\",\"children\":[4],\"translation\":[0,-1,0]},"
+            "{\"name\":\"hat\",\"mesh\":0},"
+            "{\"name\":\"foot\",\"mesh\":0,\"scale\":[2,2,2]}],"
+            "\"scenes\":[{\"nodes\":[0,3]}],\"scene\":0,"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":" +
+            std::to_string(position) + "}}]}]");
+    constexpr size_t NODE_COUNT = 5;
+
+    FilamentAsset* expected = loader->createAssetFromBinary((const uint8_t*) json.data(),
+            uint32_t(json.size()));
+    ASSERT_NE(expected, nullptr);
+    assets.push_back(expected);
+
+    FilamentAsset* asset = loader->asyncBeginCreate((const uint8_t*) json.data(),
+            uint32_t(json.size()));
+    ASSERT_NE(asset, nullptr);
+    assets.push_back(asset);
+    EXPECT_EQ(asset->getEntityCount(), 0);
+    EXPECT_FLOAT_EQ(loader->asyncGetCreateProgress(), 0.0f);
+
+    // without a time budget, each call creates a single node
+    for (size_t i = 1; i <= NODE_COUNT; i++) {
+        // the loader still needs the source data
+        asset->releaseSourceData();
+        EXPECT_NE(asset->getSourceAsset(), nullptr);
+
+        EXPECT_TRUE(loader->asyncUpdateCreate(0.0f));
+        EXPECT_EQ(asset->getEntityCount(), i);
+        EXPECT_FLOAT_EQ(loader->asyncGetCreateProgress(), float(i) / NODE_COUNT);
+    }
+    EXPECT_TRUE(loader->asyncUpdateCreate(0.0f));
+    EXPECT_EQ(asset->getEntityCount(), NODE_COUNT);
+
+    // Describes the hierarchy under an entity: its name, whether it's renderable, its local
+    // transform and its children, in order.
+    TransformManager& tm = engine->getTransformManager();
+    RenderableManager& rm = engine->getRenderableManager();
+    std::function<std::string(FilamentAsset*, Entity)> describe =
+            [&](FilamentAsset* owner, Entity e) {
+        const auto ti = tm.getInstance(e);
+        const mat4f m = tm.getTransform(ti);
+        const char* name = owner->getName(e);
+        std::string description = std::string(name ? name : "") +
+                (rm.hasComponent(e) ? " renderable " : " ") + toJson(m[3].xyz) +
+                toJson(float3{ m[0][0], m[1][1], m[2][2] }) + "{";
+        std::vector<Entity> children(tm.getChildCount(ti));
+        tm.getChildren(ti, children.data(), children.size());
+        for (Entity child : children) {
+            description += describe(owner, child) + ",";
+        }
+        return description + "}";
+    };
+    EXPECT_EQ(describe(asset, asset->getRoot()), describe(expected, expected->getRoot()));
+
+    // the entities are created in the same order
+    ASSERT_EQ(asset->getEntityCount(), expected->getEntityCount());
+    for (size_t i = 0; i < NODE_COUNT; i++) {
+        EXPECT_STREQ(asset->getName(asset->getEntities()[i]),
+                expected->getName(expected->getEntities()[i]));
+    }
+
+    // the source data can be released once all the nodes are created
+    asset->releaseSourceData();
+    EXPECT_EQ(asset->getSourceAsset(), nullptr);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+
+#include <utils/JobSystem.h>
+
+#include <math/scalar.h>
+#include <math/vec3.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <math.h>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+// Number of samples per texel, between the engine's default (8) and cmgen's (1024)
+static constexpr size_t SAMPLE_COUNT = 64;
+
+// Creates a seamless environment with all its mip levels, with enough high frequencies that
+// sampling it is representative of an HDRI.
+static void createEnvironment(JobSystem& js, size_t size,
+        std::vector<Image>& images, std::vector<Cubemap>& levels) {
+    Image image;
+    Cubemap cm = CubemapUtils::create(image, size);
+    for (size_t f = 0; f < 6; f++) {
+        Image& face = cm.getImageForFace((Cubemap::Face)f);
+        for (size_t y = 0; y < size; y++) {
+            for (size_t x = 0; x < size; x++) {
+                const float u = float(x) / size;
+                const float v = float(y) / size;
+                const float sun = (f == 2 && u > 0.4f && u < 0.45f && v > 0.6f && v < 0.65f);
+                Cubemap::writeAt(face.getPixelRef(x, y), Cubemap::Texel{
+                        0.5f + 0.5f * sinf(u * 50.0f) * cosf(v * 70.0f) + 100.0f * sun,
+                        0.5f + 0.5f * cosf(u * 30.0f + f),
+                        v });
+            }
+        }
+    }
+    cm.makeSeamless();
+    images.push_back(std::move(image));
+    levels.push_back(std::move(cm));
+
+    for (size_t dim = size / 2; dim >= 1; dim /= 2) {
+        Image mip;
+        Cubemap dst = CubemapUtils::create(mip, dim);
+        CubemapUtils::downsampleCubemapLevelBoxFilter(js, dst, levels.back());
+        dst.makeSeamless();
+        images.push_back(std::move(mip));
+        levels.push_back(std::move(dst));
+    }
+}
+
+// Prefilters all the roughness levels of an environment of the given base size, the same way
+// Texture::generatePrefilterMipmap() does. The argument is the base size.
+static void BM_RoughnessFilter(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+
+    const size_t size = size_t(state.range(0));
+    std::vector<Image> images;
+    std::vector<Cubemap> levels;
+    createEnvironment(js, size, images, levels);
+
+    const size_t numLevels = levels.size();
+    int64_t texels = 0;
+    for (auto _ : state) {
+        for (size_t level = 0; level < numLevels; level++) {
+            const size_t dim = size >> level;
+            const float lod = saturate(float(level) / float(numLevels - 1));
+            Image image;
+            Cubemap dst = CubemapUtils::create(image, dim);
+            CubemapIBL::roughnessFilter(js, dst, levels, lod * lod, SAMPLE_COUNT,
+                    float3{ 1, 1, 1 }, true);
+            benchmark::DoNotOptimize(image.getData());
+            texels += int64_t(6 * dim * dim);
+        }
+    }
+    state.SetItemsProcessed(texels);
+
+    js.emancipate();
+}
+
+BENCHMARK(BM_RoughnessFilter)->ArgName("size")->Arg(256)->Arg(512)->Arg(1024)
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -23,12 +23,14 @@
 
 #include "CubemapUtilsImpl.h"
 
+#include <utils/Hash.h>
 #include <utils/JobSystem.h>
 
 #include <math/mat3.h>
 #include <math/scalar.h>
 
-#include <random>
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 using namespace filament::math;
@@ -181,6 +183,37 @@ static float UTILS_UNUSED VisibilityAshikhmin(float NoV, float NoL, float /*a*/)
     return 1 / (4 * (NoL + NoV - NoL * NoV));
 }
 
+/*
+ * roughnessFilter() filters TEXELS_PER_BATCH destination texels of a scanline together. For each
+ * sample of the kernel, the directions and cubemap addresses of the whole batch are computed in
+ * lockstep without branches, which compilers turn into SIMD code; only the bilinear fetches are
+ * done one texel at a time, by Cubemap::filterAt(). Neighboring texels fetch neighboring source
+ * texels, so these mostly hit the cache.
+ */
+static constexpr size_t TEXELS_PER_BATCH = 8;
+
+// what trilinear filtering needs to know about a level of the source cubemap
+struct LevelInfo {
+    Image const* faces[6];
+    float dim;
+    float upperBound;
+};
+
+// same as Cubemap::filterAt(direction), s and t are in [0, 1]
+static inline float3 filterAt(const LevelInfo& level, uint32_t face, float s, float t) {
+    return Cubemap::filterAt(*level.faces[face],
+            std::min(s * level.dim, level.upperBound), std::min(t * level.dim, level.upperBound));
+}
+
+// Rotates the samples of each texel by a random angle, which trades banding for noise. The angle
+// is a hash of the texel's coordinates, so that texels can be filtered in any order and by any
+// thread.
+static float randomAngle(Cubemap::Face f, size_t x, size_t y) {
+    const uint32_t key[3] = { uint32_t(x), uint32_t(y), uint32_t(f) };
+    const uint32_t h = utils::hash::murmur3(key, 3, 0);
+    return float(h) * float(2.0 * F_PI / 4294967296.0) - (float) F_PI;
+}
+
 /*
  *
  * Importance sampling GGX - Trowbridge-Reitz
@@ -330,9 +363,9 @@ void CubemapIBL::roughnessFilter(
                         Cubemap::writeAt(data, cm.sampleAt(N));
                     }
         };
-        // at least 256 pixel cubemap before we use multithreading -- the overhead of launching
+        // at least 64 pixel cubemap before we use multithreading -- the overhead of launching
         // jobs is too large compared to the work above.
-        if (dst.getDimensions() <= 256) {
+        if (dst.getDimensions() <= 64) {
             CubemapUtils::processSingleThreaded<CubemapUtils::EmptyState>(
                     dst, js, std::ref(scanline));
         } else {
@@ -416,51 +449,98 @@ void CubemapIBL::roughnessFilter(
     });
 
 
-    struct State {
-        // maybe blue-noise instead would look even better
-        std::default_random_engine gen;
-        std::uniform_real_distribution<float> distribution{ -F_PI, F_PI };
-    };
+    // hoist everything trilinear filtering needs to know about each level out of the loops
+    std::vector<LevelInfo> levelInfos(levels.size());
+    for (size_t l = 0; l < levels.size(); l++) {
+        const Cubemap& cm = levels[l];
+        LevelInfo& info = levelInfos[l];
+        for (size_t f = 0; f < 6; f++) {
+            info.faces[f] = &cm.getImageForFace((Cubemap::Face)f);
+        }
+        info.dim = float(cm.getDimensions());
+        info.upperBound = std::nextafter(info.dim, 0.0f);
+    }
 
-    auto scanline = [&](State& state, size_t y,
+    auto scanline = [&](CubemapUtils::EmptyState&, size_t y,
             Cubemap::Face f, Cubemap::Texel* data, size_t dim) {
         if (UTILS_UNLIKELY(updater)) {
             size_t p = progress.fetch_add(1, std::memory_order_relaxed) + 1;
             updater(0, (float) p / ((float) dim * 6.0f), userdata);
         }
-        mat3 R;
         const size_t numSamples = cache.size();
-        for (size_t x = 0; x < dim; ++x, ++data) {
-            const float2 p(Cubemap::center(x, y));
-            const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
-
-            // center the cone around the normal (handle case of normal close to up)
-            const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
-            R[0] = normalize(cross(up, N));
-            R[1] = cross(N, R[0]);
-            R[2] = N;
-
-            R *= mat3f::rotation(state.distribution(state.gen), float3{0,0,1});
+        for (size_t x0 = 0; x0 < dim; x0 += TEXELS_PER_BATCH) {
+            // tangent frames of the batch, r[k] holds the component k%3 of column k/3
+            float r[9][TEXELS_PER_BATCH];
+            for (size_t i = 0; i < TEXELS_PER_BATCH; i++) {
+                // the last batch of a scanline is padded by repeating its last texel
+                const size_t x = std::min(x0 + i, dim - 1);
+                const float2 p(Cubemap::center(x, y));
+                const float3 N(dst.getDirectionFor(f, p.x, p.y) * mirror);
+
+                // center the cone around the normal (handle case of normal close to up)
+                const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                mat3 R;
+                R[0] = normalize(cross(up, N));
+                R[1] = cross(N, R[0]);
+                R[2] = N;
+
+                R *= mat3f::rotation(randomAngle(f, x, y), float3{ 0, 0, 1 });
+
+                for (size_t k = 0; k < 9; k++) {
+                    r[k][i] = R[k / 3][k % 3];
+                }
+            }
 
-            float3 Li = 0;
+            float3 Li[TEXELS_PER_BATCH] = {};
             for (size_t sample = 0; sample < numSamples; sample++) {
                 const CacheEntry& e = cache[sample];
-                const float3 L(R * e.L);
-                const Cubemap& cmBase = levels[e.l0];
-                const Cubemap& next = levels[e.l1];
-                const float3 c0 = Cubemap::trilinearFilterAt(cmBase, next, e.lerp, L);
-                Li += c0 * e.brdf_NoL;
+
+                // this is Cubemap::getAddressFor() without branches, for the whole batch
+                uint32_t face[TEXELS_PER_BATCH];
+                float s[TEXELS_PER_BATCH];
+                float t[TEXELS_PER_BATCH];
+                for (size_t i = 0; i < TEXELS_PER_BATCH; i++) {
+                    const float Lx = r[0][i] * e.L.x + r[3][i] * e.L.y + r[6][i] * e.L.z;
+                    const float Ly = r[1][i] * e.L.x + r[4][i] * e.L.y + r[7][i] * e.L.z;
+                    const float Lz = r[2][i] * e.L.x + r[5][i] * e.L.y + r[8][i] * e.L.z;
+                    const float ax = std::abs(Lx);
+                    const float ay = std::abs(Ly);
+                    const float az = std::abs(Lz);
+                    const bool isX = ax >= ay && ax >= az;
+                    const bool isY = !isX && ay >= az;
+                    const bool isZ = !isX && !isY;
+                    const float ma = 1.0f / (isX ? ax : (isY ? ay : az));
+                    const bool negative = (isX ? Lx : (isY ? Ly : Lz)) < 0;
+                    const float sc = isY ? Lx : ((isX ? -Lz : Lx) * (negative ? -1.0f : 1.0f));
+                    const float tc = isY ? (negative ? -Lz : Lz) : -Ly;
+                    face[i] = (isY ? 2u : (isZ ? 4u : 0u)) + (negative ? 1u : 0u);
+                    s[i] = (sc * ma + 1.0f) * 0.5f;
+                    t[i] = (tc * ma + 1.0f) * 0.5f;
+                }
+
+                const LevelInfo& level0 = levelInfos[e.l0];
+                const LevelInfo& level1 = levelInfos[e.l1];
+                for (size_t i = 0; i < TEXELS_PER_BATCH; i++) {
+                    const float3 c0 = filterAt(level0, face[i], s[i], t[i]);
+                    const float3 c1 = filterAt(level1, face[i], s[i], t[i]);
+                    Li[i] += (c0 + e.lerp * (c1 - c0)) * e.brdf_NoL;
+                }
+            }
+
+            const size_t count = std::min(TEXELS_PER_BATCH, dim - x0);
+            for (size_t i = 0; i < count; i++) {
+                Cubemap::writeAt(data + x0 + i, Cubemap::Texel(Li[i]));
             }
-            Cubemap::writeAt(data, Cubemap::Texel(Li));
         }
     };
 
     // don't use the jobsystem unless we have enough work per scanline -- or the overhead of
     // launching jobs will prevail.
     if (dst.getDimensions() * maxNumSamples <= 256) {
-        CubemapUtils::processSingleThreaded<State>(dst, js, std::ref(scanline));
+        CubemapUtils::processSingleThreaded<CubemapUtils::EmptyState>(
+                dst, js, std::ref(scanline));
     } else {
-        CubemapUtils::process<State>(dst, js, std::ref(scanline));
+        CubemapUtils::process<CubemapUtils::EmptyState>(dst, js, std::ref(scanline));
     }
 }
 
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <ibl/Cubemap.h>
+#include <ibl/CubemapIBL.h>
+#include <ibl/CubemapUtils.h>
+#include <ibl/Image.h>
+#include <ibl/utilities.h>
+
+#include <utils/Hash.h>
+#include <utils/JobSystem.h>
+
+#include <math/mat3.h>
+#include <math/scalar.h>
+#include <math/vec3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace filament::ibl;
+using namespace filament::math;
+using namespace utils;
+
+class RoughnessFilterTest : public testing::Test {
+protected:
+    static constexpr size_t SIZE = 32;
+
+    void SetUp() override {
+        mJobSystem.adopt();
+
+        // A seamless environment with all its mip levels, and enough high frequencies that every
+        // level contributes something different. It has no hard edges: the filters compute the
+        // sample directions with different rounding, and a direction on an edge between two
+        // texels may go to either one.
+        Image image;
+        Cubemap cm = CubemapUtils::create(image, SIZE);
+        for (size_t f = 0; f < 6; f++) {
+            Image& face = cm.getImageForFace((Cubemap::Face)f);
+            for (size_t y = 0; y < SIZE; y++) {
+                for (size_t x = 0; x < SIZE; x++) {
+                    const float u = float(x) / SIZE;
+                    const float v = float(y) / SIZE;
+                    Cubemap::writeAt(face.getPixelRef(x, y), Cubemap::Texel{
+                            0.5f + 0.5f * std::sin(u * 20.0f) * std::cos(v * 30.0f),
+                            0.5f + 0.5f * std::cos(u * 10.0f + float(f)),
+                            v });
+                }
+            }
+        }
+        cm.makeSeamless();
+        mImages.push_back(std::move(image));
+        mLevels.push_back(std::move(cm));
+
+        for (size_t dim = SIZE / 2; dim >= 1; dim /= 2) {
+            Image mip;
+            Cubemap dst = CubemapUtils::create(mip, dim);
+            CubemapUtils::downsampleCubemapLevelBoxFilter(mJobSystem, dst, mLevels.back());
+            dst.makeSeamless();
+            mImages.push_back(std::move(mip));
+            mLevels.push_back(std::move(dst));
+        }
+    }
+
+    void TearDown() override {
+        mJobSystem.emancipate();
+    }
+
+    JobSystem mJobSystem;
+    std::vector<Image> mImages;
+    std::vector<Cubemap> mLevels;
+};
+
+// The roughness filter as it was before texels were filtered in batches: one texel at a time,
+// with Cubemap::trilinearFilterAt(). The random rotation of each texel is the one roughnessFilter()
+// uses, so that the outputs can be compared.
+static void referenceRoughnessFilter(Cubemap& dst, const std::vector<Cubemap>& levels,
+        float linearRoughness, size_t maxNumSamples, float3 mirror, bool prefilter) {
+    struct CacheEntry {
+        float3 L;
+        float brdf_NoL;
+        float lerp;
+        uint8_t l0;
+        uint8_t l1;
+    };
+
+    const float numSamples = maxNumSamples;
+    const float inumSamples = 1.0f / numSamples;
+    const size_t maxLevel = levels.size() - 1;
+    const size_t dim0 = levels[0].getDimensions();
+    const float omegaP = (4.0f * (float) F_PI) / float(6 * dim0 * dim0);
+
+    std::vector<CacheEntry> cache;
+    float weight = 0;
+    for (size_t sampleIndex = 0; sampleIndex < maxNumSamples; sampleIndex++) {
+        const float2 u = hammersley(uint32_t(sampleIndex), inumSamples);
+
+        // importance sampling GGX, N == V
+        const float a = linearRoughness;
+        const float phi = 2.0f * (float) F_PI * u.x;
+        const float cosTheta2 = (1 - u.y) / (1 + (a + 1) * ((a - 1) * u.y));
+        const float cosTheta = std::sqrt(cosTheta2);
+        const float sinTheta = std::sqrt(1 - cosTheta2);
+        const float3 H{ sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta };
+
+        const float NoH = H.z;
+        const float NoH2 = H.z * H.z;
+        const float NoL = 2 * NoH2 - 1;
+        const float3 L(2 * NoH * H.x, 2 * NoH * H.y, NoL);
+        if (NoL > 0) {
+            const float d = (a - 1) * ((a + 1) * NoH2) + 1;
+            const float pdf = (a * a) / ((float) F_PI * d * d) / 4;
+            constexpr float K = 4;
+            const float omegaS = 1 / (numSamples * pdf);
+            const float l = float(log4(omegaS) - log4(omegaP) + log4(K));
+            const float mipLevel = prefilter ? clamp(l, 0.0f, float(maxLevel)) : 0.0f;
+            weight += NoL;
+            const uint8_t l0 = uint8_t(mipLevel);
+            const uint8_t l1 = uint8_t(std::min(maxLevel, size_t(l0 + 1)));
+            cache.push_back({ L, NoL, mipLevel - (float) l0, l0, l1 });
+        }
+    }
+    for (auto& entry : cache) {
+        entry.brdf_NoL *= 1.0f / weight;
+    }
+    std::sort(cache.begin(), cache.end(), [](CacheEntry const& lhs, CacheEntry const& rhs) {
+        return lhs.brdf_NoL < rhs.brdf_NoL;
+    });
+
+    const size_t dim = dst.getDimensions();
+    for (size_t f = 0; f < 6; f++) {
+        Image& image = dst.getImageForFace((Cubemap::Face)f);
+        for (size_t y = 0; y < dim; y++) {
+            for (size_t x = 0; x < dim; x++) {
+                const float2 p(Cubemap::center(x, y));
+                const float3 N(dst.getDirectionFor((Cubemap::Face)f, p.x, p.y) * mirror);
+                const float3 up = std::abs(N.z) < 0.999 ? float3(0, 0, 1) : float3(1, 0, 0);
+                mat3 R;
+                R[0] = normalize(cross(up, N));
+                R[1] = cross(N, R[0]);
+                R[2] = N;
+
+                const uint32_t key[3] = { uint32_t(x), uint32_t(y), uint32_t(f) };
+                const uint32_t h = utils::hash::murmur3(key, 3, 0);
+                const float angle = float(h) * float(2.0 * F_PI / 4294967296.0) - (float) F_PI;
+                R *= mat3f::rotation(angle, float3{ 0, 0, 1 });
+
+                float3 Li = 0;
+                for (const CacheEntry& e : cache) {
+                    const float3 L(R * e.L);
+                    Li += Cubemap::trilinearFilterAt(levels[e.l0], levels[e.l1], e.lerp, L)
+                            * e.brdf_NoL;
+                }
+                Cubemap::writeAt(image.getPixelRef(x, y), Cubemap::Texel(Li));
+            }
+        }
+    }
+}
+
+TEST_F(RoughnessFilterTest, SameAsPerTexel) {
+    size_t texelCount = 0;
+    size_t mismatchCount = 0;
+
+    // sizes smaller than and multiple of the batch size, with and without the job system
+    for (size_t dim : { 32, 16, 4, 1 }) {
+        for (size_t samples : { 8, 64 }) {
+            const float linearRoughness = 0.1f + 0.8f * float(32 - dim) / 31.0f;
+
+            Image image;
+            Cubemap dst = CubemapUtils::create(image, dim);
+            CubemapIBL::roughnessFilter(mJobSystem, dst, mLevels, linearRoughness, samples,
+                    float3{ -1, 1, 1 }, true);
+
+            Image referenceImage;
+            Cubemap reference = CubemapUtils::create(referenceImage, dim);
+            referenceRoughnessFilter(reference, mLevels, linearRoughness, samples,
+                    float3{ -1, 1, 1 }, true);
+
+            for (size_t f = 0; f < 6; f++) {
+                const Image& face = dst.getImageForFace((Cubemap::Face)f);
+                const Image& referenceFace = reference.getImageForFace((Cubemap::Face)f);
+                for (size_t y = 0; y < dim; y++) {
+                    for (size_t x = 0; x < dim; x++) {
+                        const float3 c = Cubemap::sampleAt(face.getPixelRef(x, y));
+                        const float3 r = Cubemap::sampleAt(referenceFace.getPixelRef(x, y));
+                        // only the order of floating point operations differs...
+                        const float3 error = abs(c - r) / max(float3(1.0f), abs(r));
+                        texelCount++;
+                        if (any(greaterThan(error, float3(1e-4f)))) {
+                            // ...but it can move a sample that lands on an edge of the cube to
+                            // the other face, and Cubemap::filterAt() isn't continuous across
+                            // the top and left edges of a face.
+                            mismatchCount++;
+                            EXPECT_LT(length(c - r), 0.1f * length(r))
+                                    << "size " << dim << ", " << samples << " samples, face "
+                                    << f << ", texel " << x << ", " << y;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    EXPECT_LE(mismatchCount, texelCount / 1000);
+}
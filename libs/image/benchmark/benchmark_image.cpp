@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageSampler.h>
+#include <image/LinearImage.h>
+
+#include <utils/JobSystem.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+using namespace image;
+using namespace utils;
+
+static constexpr uint32_t SIZE = 4096;
+static constexpr uint32_t CHANNELS = 4;
+
+static LinearImage createSourceImage() {
+    LinearImage image(SIZE, SIZE, CHANNELS);
+    float* data = image.getPixelRef();
+    for (size_t i = 0, n = size_t(SIZE) * SIZE * CHANNELS; i < n; i++) {
+        data[i] = float(i % 251) / 250.0f;
+    }
+    return image;
+}
+
+// Generates the full mip chain of a 4K RGBA image, the argument is the filter.
+static void BM_MipChain(benchmark::State& state) {
+    const LinearImage source = createSourceImage();
+    const Filter filter = Filter(state.range(0));
+    std::vector<LinearImage> mips(getMipmapCount(source));
+    for (auto _ : state) {
+        generateMipmaps(source, filter, mips.data(), mips.size());
+        benchmark::DoNotOptimize(mips.data());
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * SIZE * SIZE * CHANNELS * sizeof(float));
+}
+
+static void BM_MipChainJobSystem(benchmark::State& state) {
+    JobSystem js;
+    js.adopt();
+    {
+        const LinearImage source = createSourceImage();
+        const Filter filter = Filter(state.range(0));
+        std::vector<LinearImage> mips(getMipmapCount(source));
+        for (auto _ : state) {
+            generateMipmaps(js, source, filter, mips.data(), mips.size());
+            benchmark::DoNotOptimize(mips.data());
+        }
+        state.SetBytesProcessed(
+                int64_t(state.iterations()) * SIZE * SIZE * CHANNELS * sizeof(float));
+    }
+    js.emancipate();
+}
+
+#define FILTERS ->Arg(int(Filter::BOX))->Arg(int(Filter::TRIANGLE))->Arg(int(Filter::LANCZOS)) \
+        ->Unit(benchmark::kMillisecond)
+
+BENCHMARK(BM_MipChain) FILTERS;
+BENCHMARK(BM_MipChainJobSystem) FILTERS->UseRealTime();
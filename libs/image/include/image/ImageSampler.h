@@ -17,10 +17,15 @@
 #ifndef IMAGE_IMAGESAMPLER_H
 #define IMAGE_IMAGESAMPLER_H
 
+#include <image/ImageStream.h>
 #include <image/LinearImage.h>
 
 #include <utils/compiler.h>
 
+namespace utils {
+class JobSystem;
+} // namespace utils
+
 namespace image {
 
 /**
@@ -44,7 +49,8 @@ enum class Filter {
     GAUSSIAN_NORMALS, // Same as GAUSSIAN_SCALARS, but interpolates unitized vectors.
     MITCHELL,         // Cubic resampling per Mitchell-Netravali, default for magnification.
     LANCZOS,          // Popular sinc-based filter, default for minification.
-    MINIMUM           // Takes a min val rather than avg, perhaps useful for depth maps and SDF's.
+    MINIMUM,          // Takes a min val rather than avg, perhaps useful for depth maps and SDF's.
+    TRIANGLE          // Tent filter, i.e. linear interpolation when magnifying.
 };
 
 /**
@@ -114,6 +120,39 @@ UTILS_PUBLIC
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         Filter filter = Filter::DEFAULT);
 
+/**
+ * Same as the above, but splits the work in jobs. Rows are filtered in parallel, the result is
+ * the same as the serial version. The calling thread must have been adopted by the JobSystem.
+ */
+UTILS_PUBLIC
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source,
+        uint32_t width, uint32_t height, const ImageSampler& sampler);
+
+UTILS_PUBLIC
+LinearImage resampleImage(utils::JobSystem& js, const LinearImage& source,
+        uint32_t width, uint32_t height, Filter filter = Filter::DEFAULT);
+
+/**
+ * Configuration of the streaming resampleImage and generateMipmaps functions.
+ */
+struct StreamingOptions {
+    PixelStorage storage = PixelStorage::FLOAT32; // Storage of the rows kept in flight.
+    uint32_t stripHeight = 32;                    // Number of rows read or written at once.
+    utils::JobSystem* jobSystem = nullptr;        // Optional, the calling thread must be adopted.
+};
+
+/**
+ * Resizes an image that is read from a RowReader and written to a RowWriter, whose dimensions
+ * define the target size. Rows are processed in strips, only the horizontally filtered source
+ * rows needed by the vertical filter are kept, so that memory usage doesn't depend on the height
+ * of the images. With FLOAT32 storage the result is the same as the LinearImage version.
+ *
+ * Returns false if reading or writing failed. The target is finished on success.
+ */
+UTILS_PUBLIC
+bool resampleImage(RowReader& source, RowWriter& target, const ImageSampler& sampler,
+        const StreamingOptions& options = {});
+
 /**
  * Computes a single sample for the given texture coordinate and writes the resulting color
  * components into the given output holder.
@@ -145,6 +184,22 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
 UTILS_PUBLIC
 void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uint32_t mipCount);
 
+/**
+ * Same as the above, but each miplevel is generated with a parallel resampleImage.
+ */
+UTILS_PUBLIC
+void generateMipmaps(utils::JobSystem& js, const LinearImage& source, Filter,
+        LinearImage* result, uint32_t mipCount);
+
+/**
+ * Streaming version of generateMipmaps, the source is read once and all the miplevels are
+ * generated at the same time. result[n] must have the size of miplevel n + 1. Returns false if
+ * reading or writing failed. The writers are finished on success.
+ */
+UTILS_PUBLIC
+bool generateMipmaps(RowReader& source, Filter, RowWriter* const* result, uint32_t mipCount,
+        const StreamingOptions& options = {});
+
 /**
  * Returns the number of miplevels it would take to downsample the given image down to 1x1. This
  * number does not include the original image (i.e. mip 0).
@@ -152,6 +207,9 @@ void generateMipmaps(const LinearImage& source, Filter, LinearImage* result, uin
 UTILS_PUBLIC
 uint32_t getMipmapCount(const LinearImage& source);
 
+UTILS_PUBLIC
+uint32_t getMipmapCount(uint32_t width, uint32_t height);
+
 /**
  * Given the string name of a filter, converts it to uppercase and returns the corresponding
  * enum value. If no corresponding enumerant exists, returns DEFAULT.
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_IMAGESTREAM_H
+#define IMAGE_IMAGESTREAM_H
+
+#include <image/LinearImage.h>
+
+#include <utils/compiler.h>
+
+#include <cstdint>
+
+namespace image {
+
+/**
+ * Storage used for the rows that streaming algorithms keep in flight.
+ */
+enum class PixelStorage : uint8_t {
+    FLOAT32,    // Exact.
+    FLOAT16,    // Half the memory, values are rounded to half precision.
+};
+
+/**
+ * RowReader is a source of pixels that is read from top to bottom, a strip of rows at a time.
+ *
+ * Streaming algorithms consume RowReaders rather than LinearImages, so that they never need to
+ * hold the whole image in memory. Rows use the same layout as LinearImage, i.e. interleaved floats
+ * with a stride of width * channels.
+ */
+class UTILS_PUBLIC RowReader {
+public:
+    virtual ~RowReader();
+
+    RowReader(const RowReader&) = delete;
+    RowReader& operator=(const RowReader&) = delete;
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    uint32_t getChannels() const { return mChannels; }
+
+    /**
+     * Returns the index of the next row to be read.
+     */
+    uint32_t getRowIndex() const { return mRowIndex; }
+
+    /**
+     * Reads the next rowCount rows into the given buffer. Returns false if an error occurred or
+     * if there are less than rowCount rows left, once false is returned, subsequent reads fail.
+     */
+    bool read(float* rows, uint32_t rowCount);
+
+protected:
+    RowReader() = default;
+    RowReader(uint32_t width, uint32_t height, uint32_t channels);
+
+    virtual bool readRows(float* rows, uint32_t rowCount) = 0;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    uint32_t mChannels = 0;
+
+private:
+    uint32_t mRowIndex = 0;
+    bool mFailed = false;
+};
+
+/**
+ * RowWriter is a destination for pixels that is written from top to bottom, a strip of rows at a
+ * time. The producer calls finish() once all the rows have been written.
+ */
+class UTILS_PUBLIC RowWriter {
+public:
+    virtual ~RowWriter();
+
+    RowWriter(const RowWriter&) = delete;
+    RowWriter& operator=(const RowWriter&) = delete;
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+    uint32_t getChannels() const { return mChannels; }
+
+    /**
+     * Returns the index of the next row to be written.
+     */
+    uint32_t getRowIndex() const { return mRowIndex; }
+
+    /**
+     * Writes the next rowCount rows. Returns false if an error occurred or if this would write
+     * past the last row, once false is returned, subsequent writes fail.
+     */
+    bool write(float const* rows, uint32_t rowCount);
+
+    /**
+     * Completes the image, returns false if not all rows were written or if an error occurred.
+     */
+    bool finish();
+
+protected:
+    RowWriter(uint32_t width, uint32_t height, uint32_t channels);
+
+    virtual bool writeRows(float const* rows, uint32_t rowCount) = 0;
+    virtual bool onFinish() { return true; }
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mChannels;
+
+private:
+    uint32_t mRowIndex = 0;
+    bool mFailed = false;
+};
+
+/**
+ * Reads the rows of an existing LinearImage, whose pixels are shared.
+ */
+class UTILS_PUBLIC LinearImageReader : public RowReader {
+public:
+    explicit LinearImageReader(const LinearImage& image);
+
+protected:
+    bool readRows(float* rows, uint32_t rowCount) override;
+
+private:
+    LinearImage mImage;
+};
+
+/**
+ * Collects the rows into a LinearImage, for clients that need the whole image after all.
+ */
+class UTILS_PUBLIC LinearImageWriter : public RowWriter {
+public:
+    LinearImageWriter(uint32_t width, uint32_t height, uint32_t channels);
+
+    /**
+     * Returns the image, its content is complete once finish() succeeded.
+     */
+    LinearImage const& getImage() const { return mImage; }
+
+protected:
+    bool writeRows(float const* rows, uint32_t rowCount) override;
+
+private:
+    LinearImage mImage;
+};
+
+} // namespace image
+
+#endif /* IMAGE_IMAGESTREAM_H */
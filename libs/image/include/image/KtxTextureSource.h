@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_KTXTEXTURESOURCE_H
+#define IMAGE_KTXTEXTURESOURCE_H
+
+#include <filament/TextureStreamer.h>
+
+#include <image/KtxBundle.h>
+#include <image/KtxUtility.h>
+
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace image {
+namespace ktx {
+
+/**
+ * Streams the mip levels of a 2D KTX file, see filament::TextureStreamer.
+ *
+ * Unlike KtxBundle, the file isn't loaded in memory: only its header is read when the source is
+ * created, and each mip level is read from the file when the streamer needs it. Cubemaps, arrays
+ * and 3D textures aren't supported, their texture fails to be created.
+ *
+ * Like KtxUtility, this is header-only because libimage doesn't depend on libfilament.
+ */
+class KtxTextureSource : public filament::TextureStreamer::Source {
+public:
+    /**
+     * @param path Path of the KTX file, it stays open for the lifetime of the source
+     * @param srgb Forces the KTX-specified format into an SRGB format if possible
+     */
+    explicit KtxTextureSource(const char* path, bool srgb = false) noexcept {
+        mFile = fopen(path, "rb");
+        if (!mFile) {
+            return;
+        }
+
+        // this mirrors the serialization header of KtxBundle
+        struct Header {
+            uint8_t magic[12];
+            KtxInfo info;
+            uint32_t numberOfArrayElements;
+            uint32_t numberOfFaces;
+            uint32_t numberOfMipmapLevels;
+            uint32_t bytesOfKeyValueData;
+        } header;
+        static_assert(sizeof(Header) == 16 * 4, "Unexpected header size.");
+
+        static const uint8_t MAGIC[] = {
+                0xab, 0x4b, 0x54, 0x58, 0x20, 0x31, 0x31, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+
+        if (fread(&header, sizeof(header), 1, mFile) != 1 ||
+                memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                header.numberOfArrayElements > 1 || header.numberOfFaces > 1 ||
+                header.info.pixelDepth > 1 || !header.info.pixelWidth) {
+            return;
+        }
+
+        mKtxInfo = header.info;
+        mInfo.width = header.info.pixelWidth;
+        mInfo.height = header.info.pixelHeight ? header.info.pixelHeight : 1;
+        mInfo.format = toTextureFormat(header.info);
+        if (srgb) {
+            mInfo.format = toSrgbTextureFormat(mInfo.format);
+        }
+
+        // skip the key/value data and find where each level starts, only the size of each level
+        // is read here
+        const uint32_t levels = header.numberOfMipmapLevels ? header.numberOfMipmapLevels : 1;
+        long offset = long(sizeof(Header) + header.bytesOfKeyValueData);
+        for (uint32_t level = 0; level < levels; level++) {
+            uint32_t imageSize;
+            if (fseek(mFile, offset, SEEK_SET) != 0 ||
+                    fread(&imageSize, sizeof(imageSize), 1, mFile) != 1) {
+                break;
+            }
+            mLevels.push_back({ offset + long(sizeof(imageSize)), imageSize });
+            offset += long(sizeof(imageSize) + ((imageSize + 3u) & ~3u));
+        }
+        mInfo.levels = uint8_t(mLevels.size());
+    }
+
+    ~KtxTextureSource() noexcept override {
+        if (mFile) {
+            fclose(mFile);
+        }
+    }
+
+    KtxTextureSource(KtxTextureSource const&) = delete;
+    KtxTextureSource& operator=(KtxTextureSource const&) = delete;
+
+    Info getInfo() const noexcept override {
+        return mInfo;
+    }
+
+    bool load(size_t level, PixelBufferDescriptor* buffer) noexcept override {
+        if (level >= mLevels.size()) {
+            return false;
+        }
+        const Level& desc = mLevels[level];
+        void* data = malloc(desc.size);
+        if (!data) {
+            return false;
+        }
+        if (fseek(mFile, desc.offset, SEEK_SET) != 0 || fread(data, desc.size, 1, mFile) != 1) {
+            free(data);
+            return false;
+        }
+
+        auto freeLevel = [](void* buffer, size_t, void*) { free(buffer); };
+        if (isCompressed(mKtxInfo)) {
+            *buffer = PixelBufferDescriptor(data, desc.size,
+                    toCompressedPixelDataType(mKtxInfo), desc.size, freeLevel);
+        } else {
+            // KTX pads the rows of uncompressed levels to a multiple of 4 bytes
+            *buffer = PixelBufferDescriptor(data, desc.size,
+                    toPixelDataFormat(mKtxInfo), toPixelDataType(mKtxInfo), 4, 0, 0, 0,
+                    freeLevel);
+        }
+        return true;
+    }
+
+private:
+    struct Level {
+        long offset;
+        uint32_t size;
+    };
+
+    FILE* mFile = nullptr;
+    KtxInfo mKtxInfo = {};
+    Info mInfo;
+    std::vector<Level> mLevels;
+};
+
+} // namespace ktx
+} // namespace image
+
+#endif // IMAGE_KTXTEXTURESOURCE_H
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMAGE_IMAGEJOBS_H
+#define IMAGE_IMAGEJOBS_H
+
+#include <utils/JobSystem.h>
+
+#include <functional>
+
+#include <stdint.h>
+
+namespace image {
+namespace details {
+
+// rows processed per job
+static constexpr uint32_t JOBS_PARALLEL_FOR_COUNT = 16;
+
+// Calls work(firstRow, rowCount) over [0, rowCount), split in jobs when a JobSystem is given.
+// The calling thread must have been adopted by the JobSystem.
+template<typename F>
+void forEachRowRange(utils::JobSystem* js, uint32_t rowCount, F const& work) {
+    if (!js || rowCount <= JOBS_PARALLEL_FOR_COUNT) {
+        work(0u, rowCount);
+        return;
+    }
+    auto* job = utils::jobs::parallel_for(*js, nullptr, 0u, rowCount, std::cref(work),
+            utils::jobs::CountSplitter<JOBS_PARALLEL_FOR_COUNT, 8>());
+    js->runAndWait(job);
+}
+
+} // namespace details
+} // namespace image
+
+#endif // IMAGE_IMAGEJOBS_H
@@ -16,8 +16,11 @@
 
 #include <image/ImageOps.h>
 
+#include "ImageJobs.h"
+
 #include <math/vec3.h>
 #include <math/vec4.h>
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 
 #include <algorithm>
@@ -25,6 +28,7 @@
 #include <ratio>
 
 using namespace filament::math;
+using utils::JobSystem;
 
 namespace image {
 
@@ -311,22 +315,25 @@ static void edt(const float* f, float* d, float* z, float* v, float* i, size_t n
     }
 }
 
-static LinearImage computeHorizontalEdt(const LinearImage& src, LinearImage cx) {
+static LinearImage computeHorizontalEdt(JobSystem* js, const LinearImage& src, LinearImage cx) {
     const uint32_t width = src.getWidth();
     const uint32_t height = src.getHeight();
     LinearImage tmp0(width + 1, height + 1, 1);
     LinearImage tmp1(width + 1, height + 1, 1);
     LinearImage dst(width, height, 1);
 
-    // TODO: use utils::job::parallel_for.
-    for (uint32_t row = 0; row < height; ++row) {
-        const float* f = src.getPixelRef(0, row);
-        float* d = dst.getPixelRef(0, row);
-        float* z = tmp0.getPixelRef(0, row);
-        float* v = tmp1.getPixelRef(0, row);
-        float* i = cx.getPixelRef(0, row);
-        edt(f, d, z, v, i, width);
-    }
+    // Rows are independent.
+    auto work = [&](uint32_t start, uint32_t count) {
+        for (uint32_t row = start, end = start + count; row < end; ++row) {
+            const float* f = src.getPixelRef(0, row);
+            float* d = dst.getPixelRef(0, row);
+            float* z = tmp0.getPixelRef(0, row);
+            float* v = tmp1.getPixelRef(0, row);
+            float* i = cx.getPixelRef(0, row);
+            edt(f, d, z, v, i, width);
+        }
+    };
+    details::forEachRowRange(js, height, work);
 
     return dst;
 }
@@ -334,7 +341,8 @@ static LinearImage computeHorizontalEdt(const LinearImage& src, LinearImage cx)
 // Implements the paper 'Distance Transforms of Sampled Functions' by Felzenszwalb and Huttenlocher
 // but generalized to compute a coordinate field rather than a distance field. Coordinate fields are
 // more broadly useful and transforming them into distance fields is extremely cheap.
-LinearImage computeCoordField(const LinearImage& src, PresenceCallback presence, void* user) {
+static LinearImage computeCoordField(JobSystem* js, const LinearImage& src,
+        PresenceCallback presence, void* user) {
     const uint32_t width = src.getWidth();
     const uint32_t height = src.getHeight();
     LinearImage f0(width, height, 1);
@@ -348,9 +356,9 @@ LinearImage computeCoordField(const LinearImage& src, PresenceCallback presence,
     LinearImage cx(width, height, 1);
     LinearImage cy(height, width, 1);
 
-    f0 = computeHorizontalEdt(f0, cx);
+    f0 = computeHorizontalEdt(js, f0, cx);
     f0 = transpose(f0);
-    f0 = computeHorizontalEdt(f0, cy);
+    f0 = computeHorizontalEdt(js, f0, cy);
     f0 = transpose(f0);
 
     // NOTE: this could be extended to compute a volumetric distance field by transposing
@@ -370,6 +378,15 @@ LinearImage computeCoordField(const LinearImage& src, PresenceCallback presence,
     return coords;
 }
 
+LinearImage computeCoordField(const LinearImage& src, PresenceCallback presence, void* user) {
+    return computeCoordField(nullptr, src, presence, user);
+}
+
+LinearImage computeCoordField(JobSystem& js, const LinearImage& src, PresenceCallback presence,
+        void* user) {
+    return computeCoordField(&js, src, presence, user);
+}
+
 LinearImage edtFromCoordField(const LinearImage& coordField, bool sqrt) {
     const uint32_t width = coordField.getWidth();
     const uint32_t height = coordField.getHeight();
@@ -17,18 +17,28 @@
 #include <image/ImageSampler.h>
 #include <image/ImageOps.h>
 
+#include "ImageJobs.h"
+
+#include <math/half.h>
 #include <math/scalar.h>
 #include <math/vec3.h>
 #include <math/vec4.h>
 
 #include <utils/Panic.h>
 #include <utils/CString.h>
+#include <utils/JobSystem.h>
+#include <utils/compiler.h>
+#include <utils/debug.h>
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
 #include <memory>
 #include <vector>
 #include <unordered_map>
 
 using namespace image;
+using utils::JobSystem;
 
 namespace {
 
@@ -47,6 +57,11 @@ const FilterFunction Box {
 
 const FilterFunction Nearest { Box.fn, 0.0f };
 
+const FilterFunction Triangle {
+    .fn = [](float t) { return t >= 1.0f ? 0.0f : 1.0f - t; },
+    .boundingRadius = 1
+};
+
 const FilterFunction Gaussian {
     .fn = [](float t) {
         if (t >= 2.0) return 0.0f;
@@ -144,8 +159,26 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
         float sum = 0;
 
         // Iterate through source samples that lie within the bounded region.
-        const auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
-        const auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+        auto isource_lower = int32_t((xtarget - filterBounds) * nsource);
+        auto isource_upper = int32_t(std::ceil((xtarget + filterBounds) * nsource));
+
+        // The above bounds are very loose, when minifying they cover the whole row for every
+        // target sample. Narrow them down to the source samples that can have a non-zero weight,
+        // i.e. the ones within the filter's support, or that would not be rejected. The result
+        // is the same, we only skip the evaluations of the filter that yield zero.
+        if (filter.boundingRadius > 0) {
+            const float support = filter.boundingRadius / domainScale;
+            const float scale = (right - left) * float(nsource);
+            const float origin = left * float(nsource) - 0.5f;
+            isource_lower = std::max(isource_lower,
+                    int32_t(std::floor(origin + (xtarget - support) * scale)) - 1);
+            isource_upper = std::min(isource_upper,
+                    int32_t(std::ceil(origin + (xtarget + support) * scale)) + 1);
+        }
+        if (filter.rejectExternalSamples) {
+            isource_lower = std::max(isource_lower, 0);
+            isource_upper = std::min(isource_upper, int32_t(nsource) - 1);
+        }
         for (int32_t isource = isource_lower; isource <= isource_upper; ++isource) {
             const float xsource = (((isource + 0.5f) / nsource) - left) / (right - left);
             const bool outside_image = isource < 0 || isource >= int32_t(nsource);
@@ -172,22 +205,37 @@ void generateMadProgram(uint32_t ntarget, uint32_t nsource, float left, float ri
     }
 }
 
-// Transforms a MAD program intended for single-channel data into a program intended for
-// multi-channel data.
-void expandMadProgram(uint32_t nchannels, MadProgram* program) {
-    if (nchannels == 1) {
-        return;
-    }
-    MadProgram result;
-    result.reserve(program->size() * nchannels);
-    for (auto mad : *program) {
-        mad.sourceIndex *= nchannels;
-        mad.targetIndex *= nchannels;
-        for (uint32_t j = 0; j < nchannels; ++j, ++mad.sourceIndex, ++mad.targetIndex) {
-            result.push_back(mad);
+// The weights of a 1D filter, as a sparse matrix. The source samples of target sample t are
+// contiguous, they start at first[t] and their weights are weights[offsets[t]..offsets[t + 1]).
+// This lets the filter loops read both the source samples and the weights sequentially.
+struct Kernel {
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> offsets;
+    std::vector<float> weights;
+};
+
+// Converts a MAD program into a kernel. Source samples skipped by the program (because their
+// weight is zero) get a zero weight. External samples must have been rejected.
+void createKernel(uint32_t ntarget, MadProgram const& program, Kernel* kernel) {
+    kernel->first.assign(ntarget, 0);
+    kernel->offsets.assign(ntarget + 1, 0);
+    kernel->weights.clear();
+    auto mad = program.begin();
+    for (uint32_t itarget = 0; itarget < ntarget; ++itarget) {
+        const size_t offset = kernel->weights.size();
+        kernel->offsets[itarget] = uint32_t(offset);
+        if (mad == program.end() || mad->targetIndex != itarget) {
+            continue;
+        }
+        const int32_t first = mad->sourceIndex;
+        assert_invariant(first >= 0);
+        kernel->first[itarget] = uint32_t(first);
+        for (; mad != program.end() && mad->targetIndex == itarget; ++mad) {
+            kernel->weights.resize(offset + (mad->sourceIndex - first), 0.0f);
+            kernel->weights.push_back(mad->weight);
         }
     }
-    program->swap(result);
+    kernel->offsets[ntarget] = uint32_t(kernel->weights.size());
 }
 
 FilterFunction createFilterFunction(Filter ftype) {
@@ -196,6 +244,7 @@ FilterFunction createFilterFunction(Filter ftype) {
         case Filter::MINIMUM:
         case Filter::BOX:              fn = Box; break;
         case Filter::NEAREST:          fn = Nearest; break;
+        case Filter::TRIANGLE:         fn = Triangle; break;
         case Filter::HERMITE:          fn = Hermite; break;
         case Filter::MITCHELL:         fn = Mitchell; break;
         case Filter::LANCZOS:          fn = Lanczos; break;
@@ -207,75 +256,441 @@ FilterFunction createFilterFunction(Filter ftype) {
     return fn;
 }
 
-template <class VecT>
-void normalizeImpl(LinearImage& image) {
-    const uint32_t width = image.getWidth(), height = image.getHeight();
-    auto vecs = (VecT*) image.getPixelRef();
-    for (uint32_t n = 0; n < width * height; ++n) {
-        vecs[n] = normalize(vecs[n]);
+// Resolves the DEFAULT filter and generates the kernel of a pass.
+Filter createKernel(uint32_t ntarget, uint32_t nsource, Filter filter, float left, float right,
+        float filterRadiusMultiplier, Kernel* kernel) {
+    const bool mag = ntarget > nsource;
+    if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
+    MadProgram program;
+    generateMadProgram(ntarget, nsource, left, right, createFilterFunction(filter),
+            filterRadiusMultiplier, &program);
+    createKernel(ntarget, program, kernel);
+    return filter;
+}
+
+// Filters rows horizontally. NCHAN is the number of channels, or 0 when it's only known at
+// runtime, this lets the compiler unroll and vectorize the innermost loop for common images.
+template<uint32_t NCHAN>
+void filterRows(Kernel const& kernel, float const* UTILS_RESTRICT source,
+        float* UTILS_RESTRICT target, uint32_t swidth, uint32_t twidth, uint32_t nchan,
+        uint32_t rowCount) {
+    if (NCHAN) nchan = NCHAN;
+    uint32_t const* const first = kernel.first.data();
+    uint32_t const* const offsets = kernel.offsets.data();
+    float const* const weights = kernel.weights.data();
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        for (uint32_t x = 0; x < twidth; ++x) {
+            float const* UTILS_RESTRICT src = source + first[x] * nchan;
+            float* UTILS_RESTRICT dst = target + x * nchan;
+            for (uint32_t i = offsets[x], e = offsets[x + 1]; i < e; ++i, src += nchan) {
+                const float weight = weights[i];
+                for (uint32_t c = 0; c < nchan; ++c) {
+                    dst[c] += src[c] * weight;
+                }
+            }
+        }
+        source += swidth * nchan;
+        target += twidth * nchan;
     }
 }
 
-void normalize(LinearImage& image) {
-    ASSERT_PRECONDITION(image.getChannels() == 3 || image.getChannels() == 4,
-                        "Must be a 3 or 4 channel image");
-    if (image.getChannels() == 3) {
-      normalizeImpl< filament::math::float3>(image);
+// The MIN filter is special because it starts with non-zero values and ignores filter weights.
+void minimumRows(Kernel const& kernel, float const* UTILS_RESTRICT source,
+        float* UTILS_RESTRICT target, uint32_t swidth, uint32_t twidth, uint32_t nchan,
+        uint32_t rowCount) {
+    std::fill_n(target, twidth * nchan * rowCount, std::numeric_limits<float>::max());
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        for (uint32_t x = 0; x < twidth; ++x) {
+            float const* src = source + kernel.first[x] * nchan;
+            float* dst = target + x * nchan;
+            for (uint32_t i = kernel.offsets[x], e = kernel.offsets[x + 1]; i < e;
+                    ++i, src += nchan) {
+                if (kernel.weights[i] != 0) {
+                    for (uint32_t c = 0; c < nchan; ++c) {
+                        dst[c] = std::min(dst[c], src[c]);
+                    }
+                }
+            }
+        }
+        source += swidth * nchan;
+        target += twidth * nchan;
+    }
+}
+
+// Filters rows [start, start + count) of the target vertically. Each target row is a weighted
+// sum of contiguous source rows, so the innermost loop is a plain multiply-add over whole rows.
+void filterColumns(Kernel const& kernel, Filter filter, float const* UTILS_RESTRICT source,
+        float* UTILS_RESTRICT target, uint32_t rowSize, uint32_t start, uint32_t count) {
+    const bool minimum = filter == Filter::MINIMUM;
+    for (uint32_t y = start, end = start + count; y < end; ++y) {
+        float* UTILS_RESTRICT dst = target + size_t(y) * rowSize;
+        float const* UTILS_RESTRICT src = source + size_t(kernel.first[y]) * rowSize;
+        if (minimum) {
+            std::fill_n(dst, rowSize, std::numeric_limits<float>::max());
+        }
+        for (uint32_t i = kernel.offsets[y], e = kernel.offsets[y + 1]; i < e;
+                ++i, src += rowSize) {
+            const float weight = kernel.weights[i];
+            if (minimum) {
+                if (weight != 0) {
+                    for (uint32_t j = 0; j < rowSize; ++j) {
+                        dst[j] = std::min(dst[j], src[j]);
+                    }
+                }
+                continue;
+            }
+            for (uint32_t j = 0; j < rowSize; ++j) {
+                dst[j] += src[j] * weight;
+            }
+        }
+    }
+}
+
+void normalizeRows(float* data, uint32_t nchan, uint32_t count) {
+    using namespace filament::math;
+    if (nchan == 3) {
+        float3* vecs = (float3*) data;
+        for (uint32_t n = 0; n < count; ++n) vecs[n] = normalize(vecs[n]);
     } else {
-      normalizeImpl< filament::math::float4>(image);
+        float4* vecs = (float4*) data;
+        for (uint32_t n = 0; n < count; ++n) vecs[n] = normalize(vecs[n]);
     }
 }
 
-LinearImage resampleImage1D(const LinearImage& source, MadProgram* program,
-        uint32_t twidth, Filter filter, float left, float right, float filterRadiusMultiplier) {
+// Fast path for the common case of a 2:1 box downsample of the whole image, where each target
+// pixel is the average of a 2x2 block. Both passes are done at once.
+LinearImage downsampleBox2x2(JobSystem* js, const LinearImage& source) {
+    const uint32_t twidth = source.getWidth() / 2;
+    const uint32_t theight = source.getHeight() / 2;
+    const uint32_t nchan = source.getChannels();
+    const uint32_t srowSize = source.getWidth() * nchan;
+    const uint32_t trowSize = twidth * nchan;
+    LinearImage result(twidth, theight, nchan);
+    float const* const src = source.getPixelRef();
+    float* const dst = result.getPixelRef();
+    auto work = [=](uint32_t start, uint32_t count) {
+        for (uint32_t y = start, end = start + count; y < end; ++y) {
+            float const* UTILS_RESTRICT s0 = src + size_t(2 * y) * srowSize;
+            float const* UTILS_RESTRICT s1 = s0 + srowSize;
+            float* UTILS_RESTRICT d = dst + size_t(y) * trowSize;
+            for (uint32_t x = 0; x < twidth; ++x, s0 += 2 * nchan, s1 += 2 * nchan, d += nchan) {
+                for (uint32_t c = 0; c < nchan; ++c) {
+                    d[c] = ((s0[c] + s0[c + nchan]) + (s1[c] + s1[c + nchan])) * 0.25f;
+                }
+            }
+        }
+    };
+    details::forEachRowRange(js, theight, work);
+    return result;
+}
+
+LinearImage resampleImageImpl(JobSystem* js, const LinearImage& source,
+        uint32_t width, uint32_t height, const ImageSampler& sampler) {
+    ASSERT_PRECONDITION(
+        sampler.east.mode == Boundary::EXCLUDE &&
+        sampler.north.mode == Boundary::EXCLUDE &&
+        sampler.west.mode == Boundary::EXCLUDE &&
+        sampler.south.mode == Boundary::EXCLUDE, "Not yet implemented.");
+    const float radius = sampler.filterRadiusMultiplier;
+    const Region region = sampler.sourceRegion;
     const uint32_t swidth = source.getWidth();
     const uint32_t sheight = source.getHeight();
     const uint32_t nchan = source.getChannels();
-    const bool mag = twidth > swidth;
-    if (filter == Filter::DEFAULT) filter = mag ? Filter::MITCHELL : Filter::LANCZOS;
-    const FilterFunction hfn = createFilterFunction(filter);
-
-    // Generate a flat list of multiply-add (MAD) instructions.
-    program->clear();
-    generateMadProgram(twidth, swidth, left, right, hfn, filterRadiusMultiplier, program);
-    expandMadProgram(nchan, program);
-
-    // Allocate the target image.
-    LinearImage result(twidth, sheight, nchan);
-    float const* sourceRow = source.getPixelRef();
-    float* targetRow = result.getPixelRef();
-
-    // The MIN filter is special because it starts with non-zero values and ignores filter weights.
-    if (filter == Filter::MINIMUM) {
-        for (uint32_t n = 0; n < twidth * sheight * nchan; ++n) {
-            targetRow[n] = std::numeric_limits<float>::max();
-        }
-        for (uint32_t row = 0; row < sheight; ++row) {
-            for (auto mad : *program) {
-                const float a = sourceRow[mad.sourceIndex];
-                const float b = targetRow[mad.targetIndex];
-                targetRow[mad.targetIndex] = std::min(a, b);
+
+    if (sampler.horizontalFilter == Filter::BOX && sampler.verticalFilter == Filter::BOX &&
+            radius == 1 && region.left == 0 && region.top == 0 &&
+            region.right == 1 && region.bottom == 1 &&
+            swidth == 2 * width && sheight == 2 * height) {
+        return downsampleBox2x2(js, source);
+    }
+
+    Kernel hkernel, vkernel;
+    const Filter hfilter = createKernel(width, swidth, sampler.horizontalFilter,
+            region.left, region.right, radius, &hkernel);
+    const Filter vfilter = createKernel(height, sheight, sampler.verticalFilter,
+            region.top, region.bottom, radius, &vkernel);
+
+    if (hfilter == Filter::GAUSSIAN_NORMALS || vfilter == Filter::GAUSSIAN_NORMALS) {
+        ASSERT_PRECONDITION(nchan == 3 || nchan == 4, "Must be a 3 or 4 channel image");
+    }
+
+    // Resize the image horizontally, then vertically. Both passes are split in ranges of rows.
+    LinearImage tmp(width, sheight, nchan);
+    float const* const src = source.getPixelRef();
+    float* const dst = tmp.getPixelRef();
+    auto horizontal = [&](uint32_t start, uint32_t count) {
+        float const* s = src + size_t(start) * swidth * nchan;
+        float* d = dst + size_t(start) * width * nchan;
+        if (hfilter == Filter::MINIMUM) {
+            minimumRows(hkernel, s, d, swidth, width, nchan, count);
+        } else {
+            switch (nchan) {
+                case 1:  filterRows<1>(hkernel, s, d, swidth, width, nchan, count); break;
+                case 2:  filterRows<2>(hkernel, s, d, swidth, width, nchan, count); break;
+                case 3:  filterRows<3>(hkernel, s, d, swidth, width, nchan, count); break;
+                case 4:  filterRows<4>(hkernel, s, d, swidth, width, nchan, count); break;
+                default: filterRows<0>(hkernel, s, d, swidth, width, nchan, count); break;
             }
-            targetRow += twidth * nchan;
-            sourceRow += swidth * nchan;
         }
-        return result;
+        if (hfilter == Filter::GAUSSIAN_NORMALS) {
+            normalizeRows(d, nchan, width * count);
+        }
+    };
+    details::forEachRowRange(js, sheight, horizontal);
+
+    LinearImage result(width, height, nchan);
+    float const* const tsrc = tmp.getPixelRef();
+    float* const tdst = result.getPixelRef();
+    const uint32_t rowSize = width * nchan;
+    auto vertical = [&](uint32_t start, uint32_t count) {
+        filterColumns(vkernel, vfilter, tsrc, tdst, rowSize, start, count);
+        if (vfilter == Filter::GAUSSIAN_NORMALS) {
+            normalizeRows(tdst + size_t(start) * rowSize, nchan, width * count);
+        }
+    };
+    details::forEachRowRange(js, height, vertical);
+
+    return result;
+}
+
+void generateMipmapsImpl(JobSystem* js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    mips = std::min(mips, getMipmapCount(source));
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n < mips; ++n) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        result[n] = resampleImageImpl(js, source, width, height, ImageSampler {
+            .horizontalFilter = filter,
+            .verticalFilter = filter
+        });
     }
+}
+
+// Resamples an image whose rows are pushed from top to bottom, and writes the target rows as soon
+// as all their source rows have been seen. Horizontally filtered source rows are kept in a ring
+// that is just large enough for the vertical filter, plus one strip of incoming rows.
+class StreamingResampler {
+public:
+    StreamingResampler(uint32_t swidth, uint32_t sheight, uint32_t nchan, RowWriter& target,
+            const ImageSampler& sampler, const StreamingOptions& options);
+
+    StreamingResampler(StreamingResampler const&) = delete;
+    StreamingResampler& operator=(StreamingResampler const&) = delete;
+
+    // Consumes the next rowCount source rows, rowCount must not exceed the strip height.
+    bool push(float const* rows, uint32_t rowCount);
+
+    // Called once all source rows have been pushed.
+    bool finish() { return mTarget.finish(); }
+
+private:
+    template<typename T>
+    void storeRows(float const* rows, uint32_t firstRow, uint32_t rowCount);
+
+    template<typename T>
+    void filterTargetRows(float* dst, uint32_t firstRow, uint32_t rowCount) const;
+
+    bool writeReadyRows();
+
+    RowWriter& mTarget;
+    JobSystem* const mJobSystem;
+    const PixelStorage mStorage;
+    const uint32_t mStripHeight;
+    const uint32_t mSourceWidth;
+    const uint32_t mChannels;
+    const uint32_t mRowSize;            // floats per target row
+    Kernel mHKernel;
+    Kernel mVKernel;
+    Filter mHFilter;
+    Filter mVFilter;
+    std::vector<int64_t> mLastRows;     // last source row needed by each target row
+    uint32_t mRingRowCount = 0;
+    std::vector<float> mRing32;
+    std::vector<filament::math::half> mRing16;
+    std::vector<float> mOutput;         // one strip of target rows
+    uint32_t mSourceRow = 0;            // next source row to be pushed
+    uint32_t mTargetRow = 0;            // next target row to be written
+};
+
+StreamingResampler::StreamingResampler(uint32_t swidth, uint32_t sheight, uint32_t nchan,
+        RowWriter& target, const ImageSampler& sampler, const StreamingOptions& options)
+        : mTarget(target),
+          mJobSystem(options.jobSystem),
+          mStorage(options.storage),
+          mStripHeight(std::max(options.stripHeight, 1u)),
+          mSourceWidth(swidth),
+          mChannels(nchan),
+          mRowSize(target.getWidth() * nchan) {
+    ASSERT_PRECONDITION(
+        sampler.east.mode == Boundary::EXCLUDE &&
+        sampler.north.mode == Boundary::EXCLUDE &&
+        sampler.west.mode == Boundary::EXCLUDE &&
+        sampler.south.mode == Boundary::EXCLUDE, "Not yet implemented.");
+    ASSERT_PRECONDITION(target.getChannels() == nchan, "Channel counts must match.");
 
-    // Resize the image horizontally by executing the MAD instructions over each row.
-    for (uint32_t row = 0; row < sheight; ++row) {
-        for (auto mad : *program) {
-            targetRow[mad.targetIndex] += sourceRow[mad.sourceIndex] * mad.weight;
+    const uint32_t width = target.getWidth();
+    const uint32_t height = target.getHeight();
+    const float radius = sampler.filterRadiusMultiplier;
+    const Region region = sampler.sourceRegion;
+    mHFilter = createKernel(width, swidth, sampler.horizontalFilter,
+            region.left, region.right, radius, &mHKernel);
+    mVFilter = createKernel(height, sheight, sampler.verticalFilter,
+            region.top, region.bottom, radius, &mVKernel);
+
+    if (mHFilter == Filter::GAUSSIAN_NORMALS || mVFilter == Filter::GAUSSIAN_NORMALS) {
+        ASSERT_PRECONDITION(nchan == 3 || nchan == 4, "Must be a 3 or 4 channel image");
+    }
+
+    // A target row is written as soon as its last source row has been pushed, at that point the
+    // ring must still hold its first source row. Target rows without any source row are written
+    // right away.
+    mLastRows.resize(height);
+    int64_t lastRow = -1;
+    uint32_t span = 1;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t tapCount = mVKernel.offsets[y + 1] - mVKernel.offsets[y];
+        if (!tapCount) {
+            mLastRows[y] = -1;
+            continue;
         }
-        targetRow += twidth * nchan;
-        sourceRow += swidth * nchan;
+        mLastRows[y] = int64_t(mVKernel.first[y]) + tapCount - 1;
+        lastRow = std::max(lastRow, mLastRows[y]);
+        span = std::max(span, uint32_t(lastRow - mVKernel.first[y] + 1));
     }
+    mRingRowCount = span + mStripHeight;
 
-    // Perform post processing for the current pass.
-    if (filter == Filter::GAUSSIAN_NORMALS) {
-        normalize(result);
+    const size_t ringSize = size_t(mRingRowCount) * mRowSize;
+    if (mStorage == PixelStorage::FLOAT16) {
+        mRing16.resize(ringSize);
+    } else {
+        mRing32.resize(ringSize);
     }
-    return result;
+    mOutput.resize(size_t(mStripHeight) * mRowSize);
+}
+
+template<typename T>
+void StreamingResampler::storeRows(float const* rows, uint32_t firstRow, uint32_t rowCount) {
+    const uint32_t width = mTarget.getWidth();
+    const uint32_t nchan = mChannels;
+    T* const ring = std::is_same<T, float>::value ? (T*) mRing32.data() : (T*) mRing16.data();
+    auto work = [&](uint32_t start, uint32_t count) {
+        std::vector<float> row(mRowSize);
+        for (uint32_t i = start, end = start + count; i < end; ++i) {
+            float const* src = rows + size_t(i) * mSourceWidth * nchan;
+            float* dst = row.data();
+            if (mHFilter == Filter::MINIMUM) {
+                minimumRows(mHKernel, src, dst, mSourceWidth, width, nchan, 1);
+            } else {
+                std::fill(row.begin(), row.end(), 0.0f);
+                switch (nchan) {
+                    case 1:  filterRows<1>(mHKernel, src, dst, mSourceWidth, width, nchan, 1); break;
+                    case 2:  filterRows<2>(mHKernel, src, dst, mSourceWidth, width, nchan, 1); break;
+                    case 3:  filterRows<3>(mHKernel, src, dst, mSourceWidth, width, nchan, 1); break;
+                    case 4:  filterRows<4>(mHKernel, src, dst, mSourceWidth, width, nchan, 1); break;
+                    default: filterRows<0>(mHKernel, src, dst, mSourceWidth, width, nchan, 1); break;
+                }
+            }
+            if (mHFilter == Filter::GAUSSIAN_NORMALS) {
+                normalizeRows(dst, nchan, width);
+            }
+            T* slot = ring + size_t((firstRow + i) % mRingRowCount) * mRowSize;
+            std::copy(row.begin(), row.end(), slot);
+        }
+    };
+    details::forEachRowRange(mJobSystem, rowCount, work);
+}
+
+template<typename T>
+void StreamingResampler::filterTargetRows(float* dst, uint32_t firstRow, uint32_t rowCount) const {
+    T const* const ring = std::is_same<T, float>::value ?
+            (T const*) mRing32.data() : (T const*) mRing16.data();
+    const uint32_t rowSize = mRowSize;
+    const bool minimum = mVFilter == Filter::MINIMUM;
+    auto work = [&](uint32_t start, uint32_t count) {
+        for (uint32_t i = start, end = start + count; i < end; ++i) {
+            const uint32_t y = firstRow + i;
+            float* UTILS_RESTRICT out = dst + size_t(i) * rowSize;
+            std::fill_n(out, rowSize, minimum ? std::numeric_limits<float>::max() : 0.0f);
+            uint32_t row = mVKernel.first[y];
+            for (uint32_t k = mVKernel.offsets[y], e = mVKernel.offsets[y + 1]; k < e; ++k, ++row) {
+                T const* UTILS_RESTRICT src = ring + size_t(row % mRingRowCount) * rowSize;
+                const float weight = mVKernel.weights[k];
+                if (minimum) {
+                    if (weight != 0) {
+                        for (uint32_t j = 0; j < rowSize; ++j) {
+                            out[j] = std::min(out[j], float(src[j]));
+                        }
+                    }
+                    continue;
+                }
+                for (uint32_t j = 0; j < rowSize; ++j) {
+                    out[j] += float(src[j]) * weight;
+                }
+            }
+            if (mVFilter == Filter::GAUSSIAN_NORMALS) {
+                normalizeRows(out, mChannels, mTarget.getWidth());
+            }
+        }
+    };
+    details::forEachRowRange(mJobSystem, rowCount, work);
+}
+
+bool StreamingResampler::writeReadyRows() {
+    const uint32_t height = mTarget.getHeight();
+    while (mTargetRow < height && mLastRows[mTargetRow] < int64_t(mSourceRow)) {
+        uint32_t count = 1;
+        while (count < mStripHeight && mTargetRow + count < height &&
+                mLastRows[mTargetRow + count] < int64_t(mSourceRow)) {
+            ++count;
+        }
+        if (mStorage == PixelStorage::FLOAT16) {
+            filterTargetRows<filament::math::half>(mOutput.data(), mTargetRow, count);
+        } else {
+            filterTargetRows<float>(mOutput.data(), mTargetRow, count);
+        }
+        if (!mTarget.write(mOutput.data(), count)) {
+            return false;
+        }
+        mTargetRow += count;
+    }
+    return true;
+}
+
+bool StreamingResampler::push(float const* rows, uint32_t rowCount) {
+    assert_invariant(rowCount <= mStripHeight);
+    if (mStorage == PixelStorage::FLOAT16) {
+        storeRows<filament::math::half>(rows, mSourceRow, rowCount);
+    } else {
+        storeRows<float>(rows, mSourceRow, rowCount);
+    }
+    mSourceRow += rowCount;
+    return writeReadyRows();
+}
+
+bool resampleImageImpl(RowReader& source, StreamingResampler* const* resamplers,
+        uint32_t resamplerCount, uint32_t stripHeight) {
+    stripHeight = std::max(stripHeight, 1u);
+    const uint32_t height = source.getHeight();
+    std::vector<float> strip(size_t(stripHeight) * source.getWidth() * source.getChannels());
+    for (uint32_t row = 0; row < height; row += stripHeight) {
+        const uint32_t count = std::min(stripHeight, height - row);
+        if (!source.read(strip.data(), count)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < resamplerCount; ++i) {
+            if (!resamplers[i]->push(strip.data(), count)) {
+                return false;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < resamplerCount; ++i) {
+        if (!resamplers[i]->finish()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 } // anonymous namespace
@@ -288,23 +703,12 @@ SingleSample::~SingleSample() {
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
         const ImageSampler& sampler) {
-    ASSERT_PRECONDITION(
-        sampler.east.mode == Boundary::EXCLUDE &&
-        sampler.north.mode == Boundary::EXCLUDE &&
-        sampler.west.mode == Boundary::EXCLUDE &&
-        sampler.south.mode == Boundary::EXCLUDE, "Not yet implemented.");
-    const auto hfilter = sampler.horizontalFilter;
-    const auto vfilter = sampler.verticalFilter;
-    const float radius = sampler.filterRadiusMultiplier;
-    const float left = sampler.sourceRegion.left;
-    const float top = sampler.sourceRegion.top;
-    const float right = sampler.sourceRegion.right;
-    const float bottom = sampler.sourceRegion.bottom;
-    MadProgram program;
-    LinearImage result;
-    result = transpose(resampleImage1D(source, &program, width, hfilter, left, right, radius));
-    result = transpose(resampleImage1D(result, &program, height, vfilter, top, bottom, radius));
-    return result;
+    return resampleImageImpl(nullptr, source, width, height, sampler);
+}
+
+LinearImage resampleImage(JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, const ImageSampler& sampler) {
+    return resampleImageImpl(&js, source, width, height, sampler);
 }
 
 LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t height,
@@ -315,6 +719,14 @@ LinearImage resampleImage(const LinearImage& source, uint32_t width, uint32_t he
     });
 }
 
+LinearImage resampleImage(JobSystem& js, const LinearImage& source, uint32_t width,
+        uint32_t height, Filter filter) {
+    return resampleImage(js, source, width, height, ImageSampler {
+        .horizontalFilter = filter,
+        .verticalFilter = filter
+    });
+}
+
 void computeSingleSample(const LinearImage& source, float x, float y, SingleSample* result,
         Filter filter) {
     const float radius = 1.0f;
@@ -322,35 +734,72 @@ void computeSingleSample(const LinearImage& source, float x, float y, SingleSamp
     const float top = y - radius / source.getHeight();
     const float right = x + radius / source.getWidth();
     const float bottom = y + radius / source.getHeight();
-    MadProgram program;
-    LinearImage row = transpose(resampleImage1D(source, &program, 1, filter, left, right, radius));
-    row = resampleImage1D(row, &program, 1, filter, top, bottom, radius);
+    LinearImage sample = resampleImage(source, 1, 1, ImageSampler {
+        .horizontalFilter = filter,
+        .verticalFilter = filter,
+        .sourceRegion = { left, top, right, bottom },
+        .filterRadiusMultiplier = radius
+    });
     if (!result->data) {
         result->data = new float[source.getChannels()];
     }
     float* dst = result->data;
-    float const* src = row.getPixelRef();
+    float const* src = sample.getPixelRef();
     for (uint32_t c = 0; c < source.getChannels(); ++c) {
         dst[c] = src[c];
     }
 }
 
+bool resampleImage(RowReader& source, RowWriter& target, const ImageSampler& sampler,
+        const StreamingOptions& options) {
+    StreamingResampler resampler(source.getWidth(), source.getHeight(), source.getChannels(),
+            target, sampler, options);
+    StreamingResampler* const resamplers[] = { &resampler };
+    return resampleImageImpl(source, resamplers, 1, options.stripHeight);
+}
+
 // Unlike traditional mipmap generation, our implementation generates all levels from the original
 // image, under the premise that this produces a higher quality result.
 void generateMipmaps(const LinearImage& source, Filter filter, LinearImage* result, uint32_t mips) {
-    mips = std::min(mips, getMipmapCount(source));
-    uint32_t width = source.getWidth();
-    uint32_t height = source.getHeight();
+    generateMipmapsImpl(nullptr, source, filter, result, mips);
+}
+
+void generateMipmaps(JobSystem& js, const LinearImage& source, Filter filter,
+        LinearImage* result, uint32_t mips) {
+    generateMipmapsImpl(&js, source, filter, result, mips);
+}
+
+bool generateMipmaps(RowReader& source, Filter filter, RowWriter* const* result, uint32_t mips,
+        const StreamingOptions& options) {
+    const uint32_t swidth = source.getWidth();
+    const uint32_t sheight = source.getHeight();
+    const uint32_t nchan = source.getChannels();
+    mips = std::min(mips, getMipmapCount(swidth, sheight));
+    const ImageSampler sampler {
+        .horizontalFilter = filter,
+        .verticalFilter = filter
+    };
+    std::vector<std::unique_ptr<StreamingResampler>> resamplers(mips);
+    std::vector<StreamingResampler*> pointers(mips);
+    uint32_t width = swidth;
+    uint32_t height = sheight;
     for (uint32_t n = 0; n < mips; ++n) {
         width = std::max(width >> 1u, 1u);
         height = std::max(height >> 1u, 1u);
-        result[n] = resampleImage(source, width, height, filter);
+        ASSERT_PRECONDITION(result[n]->getWidth() == width && result[n]->getHeight() == height,
+                "Miplevel %u must be %ux%u.", n + 1, width, height);
+        resamplers[n] = std::make_unique<StreamingResampler>(swidth, sheight, nchan, *result[n],
+                sampler, options);
+        pointers[n] = resamplers[n].get();
     }
+    return resampleImageImpl(source, pointers.data(), mips, options.stripHeight);
 }
 
 uint32_t getMipmapCount(const LinearImage& source) {
-    uint32_t width = source.getWidth();
-    uint32_t height = source.getHeight();
+    return getMipmapCount(source.getWidth(), source.getHeight());
+}
+
+uint32_t getMipmapCount(uint32_t width, uint32_t height) {
     uint32_t count = 0;
     while (width > 1 || height > 1) {
         ++count;
@@ -366,6 +815,7 @@ Filter filterFromString(const char* rawname) {
     static const unordered_map<StaticString, Filter> map = {
         { "BOX", Filter::BOX},
         { "NEAREST", Filter::NEAREST},
+        { "TRIANGLE", Filter::TRIANGLE},
         { "HERMITE", Filter::HERMITE},
         { "GAUSSIAN", Filter::GAUSSIAN_SCALARS},
         { "NORMALS", Filter::GAUSSIAN_NORMALS},
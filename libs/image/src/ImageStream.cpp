@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <image/ImageStream.h>
+
+#include <string.h>
+
+namespace image {
+
+RowReader::~RowReader() = default;
+
+RowReader::RowReader(uint32_t width, uint32_t height, uint32_t channels)
+        : mWidth(width), mHeight(height), mChannels(channels) {
+}
+
+bool RowReader::read(float* rows, uint32_t rowCount) {
+    if (mFailed || rowCount > mHeight - mRowIndex) {
+        mFailed = true;
+        return false;
+    }
+    mFailed = !readRows(rows, rowCount);
+    mRowIndex += rowCount;
+    return !mFailed;
+}
+
+RowWriter::~RowWriter() = default;
+
+RowWriter::RowWriter(uint32_t width, uint32_t height, uint32_t channels)
+        : mWidth(width), mHeight(height), mChannels(channels) {
+}
+
+bool RowWriter::write(float const* rows, uint32_t rowCount) {
+    if (mFailed || rowCount > mHeight - mRowIndex) {
+        mFailed = true;
+        return false;
+    }
+    mFailed = !writeRows(rows, rowCount);
+    mRowIndex += rowCount;
+    return !mFailed;
+}
+
+bool RowWriter::finish() {
+    if (mFailed || mRowIndex != mHeight) {
+        mFailed = true;
+        return false;
+    }
+    mFailed = !onFinish();
+    return !mFailed;
+}
+
+LinearImageReader::LinearImageReader(const LinearImage& image)
+        : RowReader(image.getWidth(), image.getHeight(), image.getChannels()), mImage(image) {
+}
+
+bool LinearImageReader::readRows(float* rows, uint32_t rowCount) {
+    float const* src = mImage.getPixelRef(0, getRowIndex());
+    memcpy(rows, src, sizeof(float) * mWidth * mChannels * rowCount);
+    return true;
+}
+
+LinearImageWriter::LinearImageWriter(uint32_t width, uint32_t height, uint32_t channels)
+        : RowWriter(width, height, channels), mImage(width, height, channels) {
+}
+
+bool LinearImageWriter::writeRows(float const* rows, uint32_t rowCount) {
+    float* dst = mImage.getPixelRef(0, getRowIndex());
+    memcpy(dst, rows, sizeof(float) * mWidth * mChannels * rowCount);
+    return true;
+}
+
+} // namespace image
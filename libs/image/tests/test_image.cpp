@@ -20,12 +20,14 @@
 #include <image/ImageSampler.h>
 #include <image/LinearImage.h>
 
+#include <imageio/BlockCompression.h>
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageDiffer.h>
 #include <imageio/ImageEncoder.h>
 
 #include <gtest/gtest.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Panic.h>
 #include <utils/Path.h>
 
@@ -33,11 +35,15 @@
 #include <math/vec4.h>
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
 #include <vector>
 
+#include <string.h>
+
 using std::istringstream;
+using std::ostringstream;
 using std::string;
 using std::swap;
 using std::vector;
@@ -362,6 +368,161 @@ TEST_F(ImageTest, Mipmaps) { // NOLINT
     }
 }
 
+TEST_F(ImageTest, ParallelResampling) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    // Large enough to be split in several jobs.
+    LinearImage src = createColorFromAscii("12 34");
+    src = resampleImage(src, 300, 200, Filter::MITCHELL);
+
+    for (Filter filter : { Filter::BOX, Filter::TRIANGLE, Filter::LANCZOS, Filter::MINIMUM }) {
+        const uint32_t count = getMipmapCount(src);
+        vector<LinearImage> serial(count);
+        vector<LinearImage> parallel(count);
+        generateMipmaps(src, filter, serial.data(), count);
+        generateMipmaps(js, src, filter, parallel.data(), count);
+        for (uint32_t index = 0; index < count; ++index) {
+            ASSERT_EQ(compare(serial[index], parallel[index]), 0);
+        }
+        ASSERT_EQ(compare(resampleImage(src, 450, 250, filter),
+                resampleImage(js, src, 450, 250, filter)), 0);
+    }
+
+    // The 2x2 box fast path averages each block.
+    LinearImage box = resampleImage(js, src, 150, 100, Filter::BOX);
+    float const* a = src.getPixelRef(0, 0);
+    float const* b = src.getPixelRef(1, 0);
+    float const* c = src.getPixelRef(0, 1);
+    float const* d = src.getPixelRef(1, 1);
+    ASSERT_NEAR(box.getPixelRef(0, 0)[0], (a[0] + b[0] + c[0] + d[0]) / 4.0f, 1e-6f);
+
+    js.emancipate();
+}
+
+TEST_F(ImageTest, StreamingResampling) { // NOLINT
+    utils::JobSystem js;
+    js.adopt();
+
+    LinearImage src = createColorFromAscii("12 34");
+    src = resampleImage(src, 300, 200, Filter::MITCHELL);
+
+    for (Filter filter : { Filter::BOX, Filter::LANCZOS, Filter::GAUSSIAN_SCALARS }) {
+        for (uint32_t stripHeight : { 1u, 5u, 32u }) {
+            StreamingOptions options;
+            options.stripHeight = stripHeight;
+            options.jobSystem = &js;
+
+            // Single-precision storage matches the LinearImage version exactly.
+            LinearImageReader reader(src);
+            LinearImageWriter writer(450, 130, src.getChannels());
+            ImageSampler sampler;
+            sampler.horizontalFilter = sampler.verticalFilter = filter;
+            ASSERT_TRUE(resampleImage(reader, writer, sampler, options));
+            ASSERT_EQ(compare(resampleImage(src, 450, 130, filter), writer.getImage()), 0);
+
+            const uint32_t count = getMipmapCount(src);
+            vector<LinearImage> expected(count);
+            generateMipmaps(src, filter, expected.data(), count);
+
+            options.storage = PixelStorage::FLOAT16;
+            vector<std::unique_ptr<LinearImageWriter>> writers;
+            vector<RowWriter*> result;
+            for (LinearImage const& mip : expected) {
+                writers.push_back(std::make_unique<LinearImageWriter>(
+                        mip.getWidth(), mip.getHeight(), mip.getChannels()));
+                result.push_back(writers.back().get());
+            }
+            LinearImageReader mipReader(src);
+            ASSERT_TRUE(generateMipmaps(mipReader, filter, result.data(), count, options));
+            for (uint32_t index = 0; index < count; ++index) {
+                ASSERT_EQ(compare(expected[index], writers[index]->getImage(), 5e-3f), 0);
+            }
+        }
+    }
+
+    // Writing too many rows fails.
+    LinearImageReader reader(src);
+    LinearImageWriter writer(10, 10, src.getChannels());
+    vector<float> rows(src.getWidth() * src.getChannels() * 11);
+    ASSERT_TRUE(reader.read(rows.data(), 11));
+    ASSERT_FALSE(writer.write(rows.data(), 11));
+    ASSERT_FALSE(writer.finish());
+
+    js.emancipate();
+}
+
+TEST_F(ImageTest, StreamingPng) { // NOLINT
+    LinearImage src = resampleImage(createColorFromAscii("12 34"), 61, 37, Filter::MITCHELL);
+    const uint32_t width = src.getWidth();
+    const uint32_t height = src.getHeight();
+    const uint32_t channels = src.getChannels();
+
+    // Encode in strips of uneven heights.
+    ostringstream output;
+    std::unique_ptr<RowWriter> writer = ImageEncoder::createWriter(output,
+            ImageEncoder::Format::PNG_LINEAR, width, height, channels, "", "streamed.png");
+    ASSERT_TRUE(writer);
+    for (uint32_t row = 0; row < height;) {
+        const uint32_t count = std::min(height - row, 1 + row % 7);
+        ASSERT_TRUE(writer->write(src.getPixelRef(0, row), count));
+        row += count;
+    }
+    ASSERT_TRUE(writer->finish());
+
+    // The file holds the source image, quantized to 8 bits.
+    istringstream input(output.str());
+    LinearImage decoded = ImageDecoder::decode(input, "streamed.png",
+            ImageDecoder::ColorSpace::LINEAR);
+    ASSERT_EQ(decoded.getWidth(), width);
+    ASSERT_EQ(decoded.getHeight(), height);
+    ASSERT_EQ(decoded.getChannels(), channels);
+    ASSERT_EQ(compare(src, decoded, 0.5f / 255.0f + 1e-6f), 0);
+
+    // Decoding in strips gives the same pixels as decoding the whole file.
+    istringstream rowInput(output.str());
+    std::unique_ptr<RowReader> reader = ImageDecoder::createReader(rowInput, "streamed.png",
+            ImageDecoder::ColorSpace::LINEAR);
+    ASSERT_TRUE(reader);
+    ASSERT_EQ(reader->getWidth(), width);
+    ASSERT_EQ(reader->getHeight(), height);
+    ASSERT_EQ(reader->getChannels(), channels);
+    LinearImage rows(width, height, channels);
+    for (uint32_t row = 0; row < height;) {
+        const uint32_t count = std::min(height - row, 1 + row % 5);
+        ASSERT_TRUE(reader->read(rows.getPixelRef(0, row), count));
+        row += count;
+    }
+    ASSERT_EQ(compare(decoded, rows), 0);
+
+    // Reading past the last row fails.
+    ASSERT_FALSE(reader->read(rows.getPixelRef(), 1));
+}
+
+TEST_F(ImageTest, StreamingCompression) { // NOLINT
+    // Tall enough for several strips, the last of which is shorter and has a partial block row.
+    LinearImage src = resampleImage(createColorFromAscii("12 34"), 30, 150, Filter::MITCHELL);
+
+    CompressionConfig config;
+    ASSERT_TRUE(parseOptionString("s3tc_rgb_dxt1", &config));
+    CompressedTexture expected = compressTexture(config, src);
+    ASSERT_TRUE(expected.data);
+
+    // Blocks are compressed independently and stored in raster order, so compressing strip by
+    // strip produces the same texture.
+    StreamingCompressor compressor(config, src.getWidth(), src.getHeight(), src.getChannels());
+    for (uint32_t row = 0, height = src.getHeight(); row < height;) {
+        const uint32_t count = std::min(height - row, 3 + row % 11);
+        ASSERT_TRUE(compressor.write(src.getPixelRef(0, row), count));
+        row += count;
+    }
+    ASSERT_TRUE(compressor.finish());
+    CompressedTexture streamed = compressor.getCompressedTexture();
+    ASSERT_EQ(streamed.format, expected.format);
+    ASSERT_EQ(streamed.size, expected.size);
+    ASSERT_EQ(memcmp(streamed.data.get(), expected.data.get(), expected.size), 0);
+}
+
 TEST_F(ImageTest, Ktx) { // NOLINT
     uint8_t foo[] = {1, 2, 3};
     uint8_t* data;
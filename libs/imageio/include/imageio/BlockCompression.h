@@ -19,10 +19,12 @@
 #ifndef IMAGEIO_BLOCKCOMPRESSION_H_
 #define IMAGEIO_BLOCKCOMPRESSION_H_
 
+#include <image/ImageStream.h>
 #include <image/LinearImage.h>
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <math/vec2.h>
 
@@ -189,6 +191,29 @@ bool parseOptionString(const std::string& options, CompressionConfig* config);
 UTILS_PUBLIC
 CompressedTexture compressTexture(const CompressionConfig& config, const LinearImage& image);
 
+// Compresses an image as its rows are written, one strip of blocks at a time, so that only the
+// strip being compressed needs to be kept as floats. Blocks are laid out in raster order, so the
+// strips compress to consecutive ranges of the final texture.
+class UTILS_PUBLIC StreamingCompressor : public RowWriter {
+public:
+    StreamingCompressor(const CompressionConfig& config,
+            uint32_t width, uint32_t height, uint32_t channels);
+
+    // Returns the compressed texture once finish() succeeded, this can only be called once.
+    CompressedTexture getCompressedTexture();
+
+private:
+    bool writeRows(float const* rows, uint32_t rowCount) override;
+    bool onFinish() override;
+    bool compressStrip();
+
+    CompressionConfig mConfig;
+    LinearImage mStrip;
+    uint32_t mStripRows = 0;
+    CompressedFormat mFormat = CompressedFormat::INVALID;
+    std::vector<uint8_t> mData;
+};
+
 } // namespace image
 
 #endif /* IMAGEIO_BLOCKCOMPRESSION_H_ */
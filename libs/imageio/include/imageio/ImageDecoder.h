@@ -18,8 +18,10 @@
 #define IMAGE_IMAGEDECODER_H_
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 
+#include <image/ImageStream.h>
 #include <image/LinearImage.h>
 
 #include <utils/compiler.h>
@@ -37,6 +39,12 @@ public:
     static LinearImage decode(std::istream& stream, const std::string& sourceName,
             ColorSpace sourceSpace = ColorSpace::SRGB);
 
+    // Returns a reader that decodes the image a strip of rows at a time, or null if an error
+    // occured. Only non-interlaced PNG images are decoded incrementally, images in other formats
+    // are decoded entirely when the reader is created.
+    static std::unique_ptr<RowReader> createReader(std::istream& stream,
+            const std::string& sourceName, ColorSpace sourceSpace = ColorSpace::SRGB);
+
     class Decoder {
     public:
         virtual LinearImage decode() = 0;
@@ -62,6 +70,8 @@ private:
         PSD,
         EXR
     };
+
+    static Format chooseFormat(std::istream& stream);
 };
 
 } // namespace image
@@ -18,8 +18,10 @@
 #define IMAGE_IMAGEENCODER_H_
 
 #include <iosfwd>
+#include <memory>
 #include <string>
 
+#include <image/ImageStream.h>
 #include <image/LinearImage.h>
 
 #include <utils/compiler.h>
@@ -49,6 +51,13 @@ public:
     static bool encode(std::ostream& stream, Format format, const LinearImage& image,
             const std::string& compression, const std::string& destName);
 
+    // Returns a writer that consumes linear floating-point data a strip of rows at a time, or null
+    // if unable to encode. PNG based formats are encoded incrementally, the other formats are
+    // encoded once all the rows have been written.
+    static std::unique_ptr<RowWriter> createWriter(std::ostream& stream, Format format,
+            uint32_t width, uint32_t height, uint32_t channels,
+            const std::string& compression, const std::string& destName);
+
     static Format chooseFormat(const std::string& name, bool forceLinear = false);
     static std::string chooseExtension(Format format);
 
@@ -22,6 +22,8 @@
 #include <cmath>
 #include <thread>
 
+#include <string.h>
+
 #include <astcenc.h>
 #include <Etc.h>
 
@@ -546,6 +548,71 @@ CompressedTexture compressTexture(const CompressionConfig& config, const LinearI
     return {};
 }
 
+// Each strip is compressed separately, this is the number of block rows it contains.
+static constexpr uint32_t STREAMING_BLOCK_ROWS_PER_STRIP = 16;
+
+StreamingCompressor::StreamingCompressor(const CompressionConfig& config,
+        uint32_t width, uint32_t height, uint32_t channels)
+        : RowWriter(width, height, channels), mConfig(config) {
+    const uint32_t blockHeight = config.type == CompressionConfig::ASTC ?
+            std::max(1u, uint32_t(config.astc.blocksize.y)) : 4u;
+    const uint32_t stripHeight = std::min(height, blockHeight * STREAMING_BLOCK_ROWS_PER_STRIP);
+    if (stripHeight) {
+        mStrip = LinearImage(width, stripHeight, channels);
+    }
+}
+
+bool StreamingCompressor::writeRows(float const* rows, uint32_t rowCount) {
+    const uint32_t stripHeight = mStrip.getHeight();
+    const size_t rowSize = mWidth * mChannels;
+    while (rowCount) {
+        const uint32_t count = std::min(rowCount, stripHeight - mStripRows);
+        memcpy(mStrip.getPixelRef(0, mStripRows), rows, sizeof(float) * rowSize * count);
+        mStripRows += count;
+        rows += rowSize * count;
+        rowCount -= count;
+        if (mStripRows == stripHeight && !compressStrip()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool StreamingCompressor::onFinish() {
+    if (mStripRows) {
+        // the last strip can be shorter, it is the only one that might need padding
+        LinearImage last(mWidth, mStripRows, mChannels);
+        memcpy(last.getPixelRef(), mStrip.getPixelRef(),
+                sizeof(float) * mWidth * mChannels * mStripRows);
+        mStrip = last;
+        return compressStrip();
+    }
+    return true;
+}
+
+bool StreamingCompressor::compressStrip() {
+    CompressedTexture strip = compressTexture(mConfig, mStrip);
+    if (!strip.data || strip.format == CompressedFormat::INVALID) {
+        return false;
+    }
+    mFormat = strip.format;
+    mData.insert(mData.end(), strip.data.get(), strip.data.get() + strip.size);
+    mStripRows = 0;
+    return true;
+}
+
+CompressedTexture StreamingCompressor::getCompressedTexture() {
+    const uint32_t size = uint32_t(mData.size());
+    uint8_t* buffer = new uint8_t[size];
+    memcpy(buffer, mData.data(), size);
+    mData = {};
+    return {
+        .format = mFormat,
+        .size = size,
+        .data = decltype(CompressedTexture::data)(buffer)
+    };
+}
+
 static LinearImage extendToFourChannels(LinearImage original) {
     LinearImage source = original;
     const uint32_t width = source.getWidth();
@@ -51,6 +51,8 @@ namespace image {
 
 class PNGDecoder : public ImageDecoder::Decoder {
 public:
+    friend class PNGRowReader;
+
     static PNGDecoder* create(std::istream& stream);
     static bool checkSignature(char const* buf);
 
@@ -66,6 +68,12 @@ private:
     // ImageDecoder::Decoder interface
     LinearImage decode() override;
 
+    // Reads the header and sets up the conversion of the rows to 16-bits RGB or RGBA.
+    void readInfo();
+
+    // Converts rows read after readInfo() to linear floats.
+    LinearImage toLinearImage(uint8_t const* data, uint32_t rowCount) const;
+
     static void cb_error(png_structp, png_const_charp);
     static void cb_stream(png_structp png, png_bytep buffer, png_size_t size);
 
@@ -76,6 +84,26 @@ private:
     png_infop mInfo = nullptr;
     std::istream& mStream;
     std::streampos mStreamStartPos;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    size_t mRowBytes = 0;
+    int mColorType = 0;
+};
+
+// Decodes a non-interlaced PNG a strip of rows at a time.
+class PNGRowReader : public RowReader {
+public:
+    static std::unique_ptr<RowReader> create(std::istream& stream,
+            ImageDecoder::ColorSpace sourceSpace);
+
+private:
+    explicit PNGRowReader(std::unique_ptr<ImageDecoder::Decoder> decoder);
+
+    bool readRows(float* rows, uint32_t rowCount) override;
+
+    std::unique_ptr<ImageDecoder::Decoder> mDecoder;
+    std::vector<uint8_t> mRowData;
 };
 
 // -----------------------------------------------------------------------------------------------
@@ -125,9 +153,7 @@ private:
 
 // -----------------------------------------------------------------------------------------------
 
-LinearImage ImageDecoder::decode(std::istream& stream, const std::string& sourceName,
-        ColorSpace sourceSpace) {
-
+ImageDecoder::Format ImageDecoder::chooseFormat(std::istream& stream) {
     Format format = Format::NONE;
 
     std::streampos pos = stream.tellg();
@@ -145,6 +171,13 @@ LinearImage ImageDecoder::decode(std::istream& stream, const std::string& source
     }
 
     stream.seekg(pos);
+    return format;
+}
+
+LinearImage ImageDecoder::decode(std::istream& stream, const std::string& sourceName,
+        ColorSpace sourceSpace) {
+
+    Format format = chooseFormat(stream);
 
     std::unique_ptr<Decoder> decoder;
     switch (format) {
@@ -171,6 +204,18 @@ LinearImage ImageDecoder::decode(std::istream& stream, const std::string& source
     return decoder->decode();
 }
 
+std::unique_ptr<RowReader> ImageDecoder::createReader(std::istream& stream,
+        const std::string& sourceName, ColorSpace sourceSpace) {
+    if (chooseFormat(stream) == Format::PNG) {
+        return PNGRowReader::create(stream, sourceSpace);
+    }
+    LinearImage image = decode(stream, sourceName, sourceSpace);
+    if (!image.isValid()) {
+        return nullptr;
+    }
+    return std::make_unique<LinearImageReader>(image);
+}
+
 // -----------------------------------------------------------------------------------------------
 
 static inline float read32(std::istream& istream) {
@@ -212,80 +257,88 @@ PNGDecoder::~PNGDecoder() {
     png_destroy_read_struct(&mPNG, &mInfo, nullptr);
 }
 
-LinearImage PNGDecoder::decode() {
-    std::unique_ptr<uint8_t[]> imageData;
-    try {
-        mInfo = png_create_info_struct(mPNG);
-        png_read_info(mPNG, mInfo);
+void PNGDecoder::readInfo() {
+    mInfo = png_create_info_struct(mPNG);
+    png_read_info(mPNG, mInfo);
 
-        int colorType = png_get_color_type(mPNG, mInfo);
-        int bitDepth = png_get_bit_depth(mPNG, mInfo);
+    int colorType = png_get_color_type(mPNG, mInfo);
+    int bitDepth = png_get_bit_depth(mPNG, mInfo);
 
-        if (colorType == PNG_COLOR_TYPE_PALETTE) {
-            png_set_palette_to_rgb(mPNG);
-        }
-        if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) {
-            if (bitDepth < 8) {
-                png_set_expand_gray_1_2_4_to_8(mPNG);
-            }
-            png_set_gray_to_rgb(mPNG);
+    if (colorType == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(mPNG);
+    }
+    if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        if (bitDepth < 8) {
+            png_set_expand_gray_1_2_4_to_8(mPNG);
         }
-        if (png_get_valid(mPNG, mInfo, PNG_INFO_tRNS)) {
-            png_set_tRNS_to_alpha(mPNG);
+        png_set_gray_to_rgb(mPNG);
+    }
+    if (png_get_valid(mPNG, mInfo, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(mPNG);
+    }
+    if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
+        double gamma = 1.0;
+        png_get_gAMA(mPNG, mInfo, &gamma);
+        if (gamma != 1.0) {
+            png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_DEFAULT_sRGB);
         }
+    } else {
+        png_set_gamma_fixed(mPNG, PNG_FP_1, PNG_FP_1);
+        png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_GAMMA_LINEAR);
+    }
+    if (bitDepth < 16) {
+        png_set_expand_16(mPNG);
+    }
+
+    png_read_update_info(mPNG, mInfo);
+
+    // Read updated color type since we may have asked for a conversion before
+    mColorType = png_get_color_type(mPNG, mInfo);
+
+    mWidth  = png_get_image_width(mPNG, mInfo);
+    mHeight = png_get_image_height(mPNG, mInfo);
+    mRowBytes = png_get_rowbytes(mPNG, mInfo);
+}
+
+LinearImage PNGDecoder::toLinearImage(uint8_t const* data, uint32_t rowCount) const {
+    if (mColorType == PNG_COLOR_TYPE_RGBA) {
         if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-            double gamma = 1.0;
-            png_get_gAMA(mPNG, mInfo, &gamma);
-            if (gamma != 1.0) {
-                png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_DEFAULT_sRGB);
-            }
+            return toLinearWithAlpha<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    sRGBToLinear<filament::math::float4>);
         } else {
-            png_set_gamma_fixed(mPNG, PNG_FP_1, PNG_FP_1);
-            png_set_alpha_mode(mPNG, PNG_ALPHA_PNG, PNG_GAMMA_LINEAR);
+            return toLinearWithAlpha<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    [](const filament::math::float4& color) ->  filament::math::float4 { return color; });
         }
-        if (bitDepth < 16) {
-            png_set_expand_16(mPNG);
+    } else {
+        // Convert to linear float (PNG 16 stores data in network order (big endian).
+        if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
+            return toLinear<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    sRGBToLinear< filament::math::float3>);
+        } else {
+            return toLinear<uint16_t>(mWidth, rowCount, mRowBytes, data,
+                    [](uint16_t v) -> uint16_t { return ntohs(v); },
+                    [](const filament::math::float3& color) ->  filament::math::float3 { return color; });
         }
+    }
+}
 
-        png_read_update_info(mPNG, mInfo);
-
-        // Read updated color type since we may have asked for a conversion before
-        colorType = png_get_color_type(mPNG, mInfo);
-
-        uint32_t width  = png_get_image_width(mPNG, mInfo);
-        uint32_t height = png_get_image_height(mPNG, mInfo);
-        size_t rowBytes = png_get_rowbytes(mPNG, mInfo);
+LinearImage PNGDecoder::decode() {
+    std::unique_ptr<uint8_t[]> imageData;
+    try {
+        readInfo();
 
-        imageData = std::make_unique<uint8_t[]>(height * rowBytes);
-        std::unique_ptr<png_bytep[]> rowPointers(new png_bytep[height]);
-        for (size_t y = 0 ; y < height ; y++) {
-            rowPointers[y] = &imageData[y * rowBytes];
+        imageData = std::make_unique<uint8_t[]>(mHeight * mRowBytes);
+        std::unique_ptr<png_bytep[]> rowPointers(new png_bytep[mHeight]);
+        for (size_t y = 0 ; y < mHeight ; y++) {
+            rowPointers[y] = &imageData[y * mRowBytes];
         }
         png_read_image(mPNG, rowPointers.get());
         png_read_end(mPNG, mInfo);
 
-        if (colorType == PNG_COLOR_TYPE_RGBA) {
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear<filament::math::float4>);
-            } else {
-                return toLinearWithAlpha<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        [](const filament::math::float4& color) ->  filament::math::float4 { return color; });
-            }
-        } else {
-            // Convert to linear float (PNG 16 stores data in network order (big endian).
-            if (getColorSpace() == ImageDecoder::ColorSpace::SRGB) {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        sRGBToLinear< filament::math::float3>);
-            } else {
-                return toLinear<uint16_t>(width, height, rowBytes, imageData,
-                        [](uint16_t v) -> uint16_t { return ntohs(v); },
-                        [](const filament::math::float3& color) ->  filament::math::float3 { return color; });
-            }
-        }
+        return toLinearImage(imageData.get(), mHeight);
     } catch(std::runtime_error& e) {
         // reset the stream, like we found it
         std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
@@ -318,6 +371,64 @@ void PNGDecoder::error() {
 
 // -----------------------------------------------------------------------------------------------
 
+std::unique_ptr<RowReader> PNGRowReader::create(std::istream& stream,
+        ImageDecoder::ColorSpace sourceSpace) {
+    const std::streampos pos = stream.tellg();
+    PNGDecoder* png = PNGDecoder::create(stream);
+    std::unique_ptr<ImageDecoder::Decoder> decoder(png);
+    decoder->setColorSpace(sourceSpace);
+    try {
+        png->readInfo();
+    } catch(std::runtime_error& e) {
+        std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
+        stream.seekg(pos);
+        return nullptr;
+    }
+
+    // Interlaced images can't be decoded one row at a time, decode them entirely instead.
+    if (png_get_interlace_type(png->mPNG, png->mInfo) != PNG_INTERLACE_NONE) {
+        stream.seekg(pos);
+        decoder.reset(PNGDecoder::create(stream));
+        decoder->setColorSpace(sourceSpace);
+        LinearImage image = decoder->decode();
+        if (!image.isValid()) {
+            return nullptr;
+        }
+        return std::make_unique<LinearImageReader>(image);
+    }
+
+    return std::unique_ptr<RowReader>(new PNGRowReader(std::move(decoder)));
+}
+
+PNGRowReader::PNGRowReader(std::unique_ptr<ImageDecoder::Decoder> decoder)
+        : mDecoder(std::move(decoder)) {
+    PNGDecoder const& png = static_cast<PNGDecoder const&>(*mDecoder);
+    mWidth = png.mWidth;
+    mHeight = png.mHeight;
+    mChannels = png.mColorType == PNG_COLOR_TYPE_RGBA ? 4 : 3;
+}
+
+bool PNGRowReader::readRows(float* rows, uint32_t rowCount) {
+    PNGDecoder& decoder = static_cast<PNGDecoder&>(*mDecoder);
+    try {
+        mRowData.resize(rowCount * decoder.mRowBytes);
+        for (uint32_t y = 0; y < rowCount; y++) {
+            png_read_row(decoder.mPNG, &mRowData[y * decoder.mRowBytes], nullptr);
+        }
+        if (getRowIndex() + rowCount == mHeight) {
+            png_read_end(decoder.mPNG, decoder.mInfo);
+        }
+    } catch(std::runtime_error& e) {
+        std::cerr << "Runtime error while decoding PNG: " << e.what() << std::endl;
+        return false;
+    }
+    LinearImage strip = decoder.toLinearImage(mRowData.data(), rowCount);
+    memcpy(rows, strip.getPixelRef(), sizeof(float) * mWidth * mChannels * rowCount);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------
+
 const char PSDDecoder::sig[] = { '8', 'B', 'P', 'S', 0x0, 0x1, 0x0, 0x0, 0x0, 0x0, 0x0, 0x0 };
 
 PSDDecoder* PSDDecoder::create(std::istream& stream) {
@@ -49,6 +49,8 @@ namespace image {
 
 class PNGEncoder : public ImageEncoder::Encoder {
 public:
+    friend class PNGRowWriter;
+
     enum class PixelFormat {
         sRGB,           // 8-bits sRGB
         RGBM,           // 8-bits RGBM
@@ -70,9 +72,17 @@ private:
     // ImageEncoder::Encoder interface
     bool encode(const LinearImage& image) override;
 
-    int chooseColorType(const LinearImage& image) const;
+    bool checkChannels(uint32_t srcChannels) const;
+    int chooseColorType(uint32_t srcChannels) const;
     uint32_t getChannelsCount(int colorType) const;
 
+    // Writes the header (8 bit colour depth)
+    void writeInfo(uint32_t width, uint32_t height, int colorType);
+
+    // Converts the image to 8 bit rows, sets dstChannels to the number of channels per pixel.
+    std::unique_ptr<uint8_t[]> toRows(const LinearImage& image, int colorType,
+            uint32_t* dstChannels) const;
+
     static void cb_error(png_structp png, png_const_charp error);
     static void cb_stream(png_structp png, png_bytep buffer, png_size_t size);
 
@@ -87,6 +97,40 @@ private:
     PixelFormat mFormat;
 };
 
+// Encodes a PNG a strip of rows at a time.
+class PNGRowWriter : public RowWriter {
+public:
+    static std::unique_ptr<RowWriter> create(std::ostream& stream,
+            PNGEncoder::PixelFormat format, uint32_t width, uint32_t height, uint32_t channels);
+
+private:
+    PNGRowWriter(std::unique_ptr<ImageEncoder::Encoder> encoder, int colorType,
+            uint32_t width, uint32_t height, uint32_t channels);
+
+    bool writeRows(float const* rows, uint32_t rowCount) override;
+    bool onFinish() override;
+
+    std::unique_ptr<ImageEncoder::Encoder> mEncoder;
+    int mColorType;
+};
+
+// Collects all the rows and encodes the image once complete, for formats that can't be
+// written incrementally.
+class BufferedRowWriter : public LinearImageWriter {
+public:
+    BufferedRowWriter(std::ostream& stream, ImageEncoder::Format format,
+            uint32_t width, uint32_t height, uint32_t channels,
+            std::string compression, std::string destName);
+
+private:
+    bool onFinish() override;
+
+    std::ostream& mStream;
+    ImageEncoder::Format mFormat;
+    std::string mCompression;
+    std::string mDestName;
+};
+
 // ------------------------------------------------------------------------------------------------
 
 class HDREncoder : public ImageEncoder::Encoder {
@@ -223,6 +267,28 @@ bool ImageEncoder::encode(std::ostream& stream, Format format, const LinearImage
     return encoder->encode(image);
 }
 
+std::unique_ptr<RowWriter> ImageEncoder::createWriter(std::ostream& stream, Format format,
+        uint32_t width, uint32_t height, uint32_t channels,
+        const std::string& compression, const std::string& destName) {
+    switch (format) {
+        case Format::PNG:
+            return PNGRowWriter::create(stream, PNGEncoder::PixelFormat::sRGB,
+                    width, height, channels);
+        case Format::PNG_LINEAR:
+            return PNGRowWriter::create(stream, PNGEncoder::PixelFormat::LINEAR_RGB,
+                    width, height, channels);
+        case Format::RGB_10_11_11_REV:
+            return PNGRowWriter::create(stream, PNGEncoder::PixelFormat::RGB_10_11_11_REV,
+                    width, height, channels);
+        case Format::RGBM:
+            return PNGRowWriter::create(stream, PNGEncoder::PixelFormat::RGBM,
+                    width, height, channels);
+        default:
+            return std::make_unique<BufferedRowWriter>(stream, format, width, height, channels,
+                    compression, destName);
+    }
+}
+
 ImageEncoder::Format ImageEncoder::chooseFormat(const std::string& name, bool forceLinear) {
     std::string ext;
     size_t index = name.rfind('.');
@@ -293,9 +359,8 @@ void PNGEncoder::init() {
     png_set_write_fn(mPNG, this, cb_stream, nullptr);
 }
 
-int PNGEncoder::chooseColorType(const LinearImage& image) const {
-    size_t channels = image.getChannels();
-    switch (channels) {
+int PNGEncoder::chooseColorType(uint32_t srcChannels) const {
+    switch (srcChannels) {
         case 1:
             return PNG_COLOR_TYPE_GRAY;
         case 3:
@@ -329,9 +394,7 @@ uint32_t PNGEncoder::getChannelsCount(int colorType) const {
     }
 }
 
-bool PNGEncoder::encode(const LinearImage& image) {
-    size_t srcChannels = image.getChannels();
-
+bool PNGEncoder::checkChannels(uint32_t srcChannels) const {
     switch (mFormat) {
         case PixelFormat::RGBM:
         case PixelFormat::RGB_10_11_11_REV:
@@ -347,59 +410,75 @@ bool PNGEncoder::encode(const LinearImage& image) {
             }
             break;
     }
+    return true;
+}
 
-    try {
-        mInfo = png_create_info_struct(mPNG);
+void PNGEncoder::writeInfo(uint32_t width, uint32_t height, int colorType) {
+    mInfo = png_create_info_struct(mPNG);
 
-        // Write header (8 bit colour depth)
-        size_t width = image.getWidth();
-        size_t height = image.getHeight();
-        int colorType = chooseColorType(image);
+    png_set_IHDR(mPNG, mInfo, width, height,
+                 8, colorType, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
 
-        png_set_IHDR(mPNG, mInfo, width, height,
-                     8, colorType, PNG_INTERLACE_NONE,
-                     PNG_COMPRESSION_TYPE_BASE, PNG_FILTER_TYPE_BASE);
+    if (mFormat == PixelFormat::LINEAR_RGB || mFormat == PixelFormat::RGB_10_11_11_REV) {
+        png_set_gAMA(mPNG, mInfo, 1.0);
+    } else {
+        png_set_sRGB_gAMA_and_cHRM(mPNG, mInfo, PNG_sRGB_INTENT_PERCEPTUAL);
+    }
 
-        if (mFormat == PixelFormat::LINEAR_RGB || mFormat == PixelFormat::RGB_10_11_11_REV) {
-            png_set_gAMA(mPNG, mInfo, 1.0);
-        } else {
-            png_set_sRGB_gAMA_and_cHRM(mPNG, mInfo, PNG_sRGB_INTENT_PERCEPTUAL);
+    png_write_info(mPNG, mInfo);
+}
+
+std::unique_ptr<uint8_t[]> PNGEncoder::toRows(const LinearImage& image, int colorType,
+        uint32_t* dstChannels) const {
+    std::unique_ptr<uint8_t[]> data;
+    if (image.getChannels() == 1) {
+        *dstChannels = 1;
+        data = fromLinearToGrayscale<uint8_t>(image);
+    } else {
+        *dstChannels = getChannelsCount(colorType);
+        switch (mFormat) {
+            case PixelFormat::RGBM:
+                data = fromLinearToRGBM<uint8_t>(image);
+                break;
+            case PixelFormat::RGB_10_11_11_REV:
+                data = fromLinearToRGB_10_11_11_REV(image);
+                break;
+            case PixelFormat::sRGB:
+                if (*dstChannels == 4) {
+                    data = fromLinearTosRGB<uint8_t, 4>(image);
+                } else {
+                    data = fromLinearTosRGB<uint8_t, 3>(image);
+                }
+                break;
+            case PixelFormat::LINEAR_RGB:
+                if (*dstChannels == 4) {
+                    data = fromLinearToRGB<uint8_t, 4>(image);
+                } else {
+                    data = fromLinearToRGB<uint8_t, 3>(image);
+                }
+                break;
         }
+    }
+    return data;
+}
+
+bool PNGEncoder::encode(const LinearImage& image) {
+    if (!checkChannels(image.getChannels())) {
+        return false;
+    }
+
+    try {
+        size_t width = image.getWidth();
+        size_t height = image.getHeight();
+        int colorType = chooseColorType(image.getChannels());
 
-        png_write_info(mPNG, mInfo);
+        writeInfo(width, height, colorType);
 
         std::unique_ptr<png_bytep[]> row_pointers(new png_bytep[height]);
-        std::unique_ptr<uint8_t[]> data;
 
         uint32_t dstChannels;
-        if (srcChannels == 1) {
-            dstChannels = 1;
-            data = fromLinearToGrayscale<uint8_t>(image);
-        } else {
-            dstChannels = getChannelsCount(colorType);
-            switch (mFormat) {
-                case PixelFormat::RGBM:
-                    data = fromLinearToRGBM<uint8_t>(image);
-                    break;
-                case PixelFormat::RGB_10_11_11_REV:
-                    data = fromLinearToRGB_10_11_11_REV(image);
-                    break;
-                case PixelFormat::sRGB:
-                    if (dstChannels == 4) {
-                        data = fromLinearTosRGB<uint8_t, 4>(image);
-                    } else {
-                        data = fromLinearTosRGB<uint8_t, 3>(image);
-                    }
-                    break;
-                case PixelFormat::LINEAR_RGB:
-                    if (dstChannels == 4) {
-                        data = fromLinearToRGB<uint8_t, 4>(image);
-                    } else {
-                        data = fromLinearToRGB<uint8_t, 3>(image);
-                    }
-                    break;
-            }
-        }
+        std::unique_ptr<uint8_t[]> data = toRows(image, colorType, &dstChannels);
 
         for (size_t y = 0; y < height; y++) {
             row_pointers[y] = reinterpret_cast<png_bytep>
@@ -418,6 +497,78 @@ bool PNGEncoder::encode(const LinearImage& image) {
     return true;
 }
 
+//-------------------------------------------------------------------------------------------------
+
+std::unique_ptr<RowWriter> PNGRowWriter::create(std::ostream& stream,
+        PNGEncoder::PixelFormat format, uint32_t width, uint32_t height, uint32_t channels) {
+    PNGEncoder* png = PNGEncoder::create(stream, format);
+    std::unique_ptr<ImageEncoder::Encoder> encoder(png);
+    if (!png->checkChannels(channels)) {
+        return nullptr;
+    }
+    const int colorType = png->chooseColorType(channels);
+    try {
+        png->writeInfo(width, height, colorType);
+    } catch (std::runtime_error& e) {
+        std::cerr << "Runtime error while encoding PNG: " << e.what() << std::endl;
+        stream.seekp(png->mStreamStartPos);
+        return nullptr;
+    }
+    return std::unique_ptr<RowWriter>(
+            new PNGRowWriter(std::move(encoder), colorType, width, height, channels));
+}
+
+PNGRowWriter::PNGRowWriter(std::unique_ptr<ImageEncoder::Encoder> encoder, int colorType,
+        uint32_t width, uint32_t height, uint32_t channels)
+        : RowWriter(width, height, channels), mEncoder(std::move(encoder)), mColorType(colorType) {
+}
+
+bool PNGRowWriter::writeRows(float const* rows, uint32_t rowCount) {
+    PNGEncoder& png = static_cast<PNGEncoder&>(*mEncoder);
+
+    LinearImage strip(mWidth, rowCount, mChannels);
+    memcpy(strip.getPixelRef(), rows, sizeof(float) * mWidth * mChannels * rowCount);
+
+    uint32_t dstChannels;
+    std::unique_ptr<uint8_t[]> data = png.toRows(strip, mColorType, &dstChannels);
+    try {
+        for (size_t y = 0; y < rowCount; y++) {
+            png_write_row(png.mPNG, &data[y * mWidth * dstChannels * sizeof(uint8_t)]);
+        }
+    } catch (std::runtime_error& e) {
+        std::cerr << "Runtime error while encoding PNG: " << e.what() << std::endl;
+        png.mStream.seekp(png.mStreamStartPos);
+        return false;
+    }
+    return true;
+}
+
+bool PNGRowWriter::onFinish() {
+    PNGEncoder& png = static_cast<PNGEncoder&>(*mEncoder);
+    try {
+        png_write_end(png.mPNG, png.mInfo);
+        png.mStream.flush();
+    } catch (std::runtime_error& e) {
+        std::cerr << "Runtime error while encoding PNG: " << e.what() << std::endl;
+        png.mStream.seekp(png.mStreamStartPos);
+        return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+
+BufferedRowWriter::BufferedRowWriter(std::ostream& stream, ImageEncoder::Format format,
+        uint32_t width, uint32_t height, uint32_t channels,
+        std::string compression, std::string destName)
+        : LinearImageWriter(width, height, channels), mStream(stream), mFormat(format),
+          mCompression(std::move(compression)), mDestName(std::move(destName)) {
+}
+
+bool BufferedRowWriter::onFinish() {
+    return ImageEncoder::encode(mStream, mFormat, getImage(), mCompression, mDestName);
+}
+
 void PNGEncoder::cb_stream(png_structp png, png_bytep buffer, png_size_t size) {
     PNGEncoder* that = static_cast<PNGEncoder*>(png_get_io_ptr(png));
     that->stream(buffer, size);
@@ -498,6 +498,7 @@ struct HighWatermark {
     void onFree(void* p, size_t size) noexcept;
     void onReset() noexcept;
     void onRewind(void const* addr) noexcept;
+    size_t getHighWatermark() const noexcept { return mHighWaterMark; }
 protected:
     const char* mName = nullptr;
     void* mBase = nullptr;
@@ -522,6 +523,7 @@ protected:
 };
 
 struct DebugAndHighWatermark : protected HighWatermark, protected Debug {
+    using HighWatermark::getHighWatermark;
     DebugAndHighWatermark() noexcept = default;
     DebugAndHighWatermark(const char* name, void* base, size_t size) noexcept
             : HighWatermark(name, base, size), Debug(name, base, size) { }
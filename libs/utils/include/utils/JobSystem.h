@@ -76,7 +76,10 @@ public:
                                                                 // 64 | 64
     };
 
-    explicit JobSystem(size_t threadCount = 0, size_t adoptableThreadsCount = 1) noexcept;
+    // threadCount: number of threads in the pool, 0 for a system dependant default.
+    // affinityMask: CPUs the pool threads may run on, 0 pins each thread to the CPU of its index.
+    explicit JobSystem(size_t threadCount = 0, size_t adoptableThreadsCount = 1,
+            uint64_t affinityMask = 0) noexcept;
 
     ~JobSystem();
 
@@ -298,11 +301,17 @@ public:
 
     static void setThreadPriority(Priority priority) noexcept;
     static void setThreadAffinityById(size_t id) noexcept;
+    static void setThreadAffinityByMask(uint64_t mask) noexcept;
 
     size_t getParallelSplitCount() const noexcept {
         return mParallelSplitCount;
     }
 
+    // number of threads in the pool, not counting the adopted threads
+    size_t getThreadCount() const noexcept {
+        return mThreadCount;
+    }
+
 private:
     // this is just to avoid using std::default_random_engine, since we're in a public header.
     class default_random_engine {
@@ -334,6 +343,8 @@ private:
 
     ThreadState& getState() noexcept;
 
+    void setThreadAffinity(ThreadState const& state) const noexcept;
+
     void incRef(Job const* job) noexcept;
     void decRef(Job const* job) noexcept;
 
@@ -395,6 +406,7 @@ private:
     std::atomic<uint16_t> mAdoptedThreads = { 0 };      // this one is almost never written
     Job* const mJobStorageBase;                         // Base for conversion to indices
     uint16_t mThreadCount = 0;                          // total # of threads in the pool
+    uint64_t mAffinityMask = 0;                         // 0 means one CPU per thread
     uint8_t mParallelSplitCount = 0;                    // # of split allowable in parallel_for
     Job* mRootJob = nullptr;
 
@@ -107,9 +107,32 @@ void JobSystem::setThreadAffinityById(size_t id) noexcept {
 #endif
 }
 
-JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreadsCount) noexcept
+void JobSystem::setThreadAffinityByMask(uint64_t mask) noexcept {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t cpu = 0; cpu < 64; cpu++) {
+        if (mask & (uint64_t(1) << cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    sched_setaffinity(gettid(), sizeof(set), &set);
+#endif
+}
+
+void JobSystem::setThreadAffinity(ThreadState const& state) const noexcept {
+    if (mAffinityMask) {
+        setThreadAffinityByMask(mAffinityMask);
+    } else {
+        setThreadAffinityById(state.id);
+    }
+}
+
+JobSystem::JobSystem(const size_t userThreadCount, const size_t adoptableThreadsCount,
+        uint64_t affinityMask) noexcept
     : mJobPool("JobSystem Job pool", MAX_JOB_COUNT * sizeof(Job)),
-      mJobStorageBase(static_cast<Job *>(mJobPool.getAllocator().getCurrent()))
+      mJobStorageBase(static_cast<Job *>(mJobPool.getAllocator().getCurrent())),
+      mAffinityMask(affinityMask)
 {
     SYSTRACE_ENABLE();
 
@@ -343,7 +366,7 @@ void JobSystem::loop(ThreadState* state) noexcept {
 
     // set a CPU affinity on each of our JobSystem thread to prevent them from jumping from core
     // to core. On Android, it looks like the affinity needs to be reset from time to time.
-    setThreadAffinityById(state->id);
+    setThreadAffinity(*state);
 
     // record our work queue
     mThreadMapLock.lock();
@@ -357,7 +380,7 @@ void JobSystem::loop(ThreadState* state) noexcept {
             std::unique_lock<Mutex> lock(mWaiterLock);
             while (!exitRequested() && !hasActiveJobs()) {
                 wait(lock);
-                setThreadAffinityById(state->id);
+                setThreadAffinity(*state);
             }
         }
     } while (!exitRequested());
@@ -30,6 +30,7 @@ struct ShadowData {
     highp vec3 direction;
     float normalBias;
     highp vec4 lightFromWorldZ;
+    highp vec4 tileRect;
     float texelSizeAtOneMeter;
     float bulbRadiusLs;
     float nearOverFarMinusNear;
@@ -17,28 +17,34 @@
 // PCF Shadow Sampling
 //------------------------------------------------------------------------------
 
+// Shadow maps share the layers of the atlas, the filters clamp their taps to the shadow map's
+// rectangle (xy: min, zw: max, already inset by half a texel) so they don't read the neighbours.
+highp vec2 clampToTile(const highp vec2 uv, const highp vec4 tileRect) {
+    return clamp(uv, tileRect.xy, tileRect.zw);
+}
+
 float sampleDepth(const mediump sampler2DArrayShadow map, const uint layer,
-        const highp vec2 uv, float depth) {
+        const highp vec4 tileRect, const highp vec2 uv, float depth) {
     // depth must be clamped to support floating-point depth formats. This is to avoid comparing a
     // value from the depth texture (which is never greater than 1.0) with a greater-than-one
     // comparison value (which is possible with floating-point formats).
-    return texture(map, vec4(uv, layer, saturate(depth)));
+    return texture(map, vec4(clampToTile(uv, tileRect), layer, saturate(depth)));
 }
 
 #if SHADOW_SAMPLING_METHOD == SHADOW_SAMPLING_PCF_HARD
 // use hardware assisted PCF
 float ShadowSample_PCF_Hard(const mediump sampler2DArrayShadow map,
-        const uint layer, const highp vec4 shadowPosition) {
+        const uint layer, const highp vec4 tileRect, const highp vec4 shadowPosition) {
     highp vec3 position = shadowPosition.xyz * (1.0 / shadowPosition.w);
     // note: shadowPosition.z is in the [1, 0] range (reversed Z)
-    return sampleDepth(map, layer, position.xy, position.z);
+    return sampleDepth(map, layer, tileRect, position.xy, position.z);
 }
 #endif
 
 #if SHADOW_SAMPLING_METHOD == SHADOW_SAMPLING_PCF_LOW
 // use hardware assisted PCF + 3x3 gaussian filter
 float ShadowSample_PCF_Low(const mediump sampler2DArrayShadow map,
-        const uint layer, const highp vec4 shadowPosition) {
+        const uint layer, const highp vec4 tileRect, const highp vec4 shadowPosition) {
     highp vec3 position = shadowPosition.xyz * (1.0 / shadowPosition.w);
     // note: shadowPosition.z is in the [1, 0] range (reversed Z)
     highp vec2 size = vec2(textureSize(map, 0));
@@ -65,19 +71,20 @@ float ShadowSample_PCF_Low(const mediump sampler2DArrayShadow map,
     v *= texelSize.y;
 
     float sum = 0.0;
-    sum += uw.x * vw.x * sampleDepth(map, layer, base + vec2(u.x, v.x), depth);
-    sum += uw.y * vw.x * sampleDepth(map, layer, base + vec2(u.y, v.x), depth);
-    sum += uw.x * vw.y * sampleDepth(map, layer, base + vec2(u.x, v.y), depth);
-    sum += uw.y * vw.y * sampleDepth(map, layer, base + vec2(u.y, v.y), depth);
+    sum += uw.x * vw.x * sampleDepth(map, layer, tileRect, base + vec2(u.x, v.x), depth);
+    sum += uw.y * vw.x * sampleDepth(map, layer, tileRect, base + vec2(u.y, v.x), depth);
+    sum += uw.x * vw.y * sampleDepth(map, layer, tileRect, base + vec2(u.x, v.y), depth);
+    sum += uw.y * vw.y * sampleDepth(map, layer, tileRect, base + vec2(u.y, v.y), depth);
     return sum * (1.0 / 16.0);
 }
 #endif
 
 // use manual PCF
 float ShadowSample_PCF(const mediump sampler2DArray map,
-        const uint layer, const highp vec4 shadowPosition) {
+        const uint layer, const highp vec4 tileRect, const highp vec4 shadowPosition) {
     highp vec3 position = shadowPosition.xyz * (1.0 / shadowPosition.w);
     // note: shadowPosition.z is in the [1, 0] range (reversed Z)
+    position.xy = clampToTile(position.xy, tileRect);
     highp vec2 size = vec2(textureSize(map, 0));
     highp vec2 st = position.xy * size - 0.5;
     vec4 d;
@@ -192,14 +199,15 @@ float getPenumbraRatio(const bool DIRECTIONAL, const uint index,
 }
 
 void blockerSearchAndFilter(out float occludedCount, out float z_occSum,
-        const mediump sampler2DArray map, const highp vec2 uv, const float z_rec, const uint layer,
+        const mediump sampler2DArray map, const highp vec4 tileRect,
+        const highp vec2 uv, const float z_rec, const uint layer,
         const highp vec2 filterRadii, const mat2 R, const highp vec2 dz_duv,
         const uint tapCount) {
     occludedCount = 0.0;
     z_occSum = 0.0;
     for (uint i = 0u; i < tapCount; i++) {
         highp vec2 duv = R * (poissonDisk[i] * filterRadii);
-        float z_occ = textureLod(map, vec3(uv + duv, layer), 0.0).r;
+        float z_occ = textureLod(map, vec3(clampToTile(uv + duv, tileRect), layer), 0.0).r;
 
         // note: z_occ and z_rec are not necessarily linear here, comparing them is always okay for
         // the regular PCF, but the "distance" is meaningless unless they are actually linear
@@ -217,21 +225,22 @@ void blockerSearchAndFilter(out float occludedCount, out float z_occSum,
     }
 }
 
-float filterPCSS(const mediump sampler2DArray map, const highp vec2 size,
-        const highp vec2 uv, const float z_rec, const uint layer,
+float filterPCSS(const mediump sampler2DArray map, const highp vec4 tileRect,
+        const highp vec2 size, const highp vec2 uv, const float z_rec, const uint layer,
         const highp vec2 filterRadii, const mat2 R, const highp vec2 dz_duv,
         const uint tapCount) {
 
     float occludedCount = 0.0;
     for (uint i = 0u; i < tapCount; i++) {
         highp vec2 duv = R * (poissonDisk[i] * filterRadii);
+        highp vec2 tap = clampToTile(uv + duv, tileRect);
 
         // sample the shadow map with a 2x2 PCF, this helps a lot in low resolution areas
         vec4 d;
-        highp vec2 st = (uv + duv) * size - 0.5;
+        highp vec2 st = tap * size - 0.5;
         highp vec2 grad = fract(st);
 #if defined(FILAMENT_HAS_FEATURE_TEXTURE_GATHER)
-        d = textureGather(map, vec3(uv + duv, layer), 0); // 01, 11, 10, 00
+        d = textureGather(map, vec3(tap, layer), 0); // 01, 11, 10, 00
 #else
         d[0] = texelFetchOffset(map, ivec3(st, layer), 0, ivec2(0, 1)).r;
         d[1] = texelFetchOffset(map, ivec3(st, layer), 0, ivec2(1, 1)).r;
@@ -254,7 +263,7 @@ float filterPCSS(const mediump sampler2DArray map, const highp vec2 size,
  */
 float ShadowSample_DPCF(const bool DIRECTIONAL,
         const mediump sampler2DArray map, const uint layer, const uint index,
-        const highp vec4 shadowPosition, const highp float zLight) {
+        const highp vec4 tileRect, const highp vec4 shadowPosition, const highp float zLight) {
     highp vec3 position = shadowPosition.xyz * (1.0 / shadowPosition.w);
     highp vec2 texelSize = vec2(1.0) / vec2(textureSize(map, 0));
 
@@ -271,7 +280,7 @@ float ShadowSample_DPCF(const bool DIRECTIONAL,
     float z_occSum = 0.0;
 
     blockerSearchAndFilter(occludedCount, z_occSum,
-            map, position.xy, position.z, layer, texelSize * penumbra, R, dz_duv,
+            map, tileRect, position.xy, position.z, layer, texelSize * penumbra, R, dz_duv,
             DPCF_SHADOW_TAP_COUNT);
 
     // early exit if there is no occluders at all, also avoids a divide-by-zero below.
@@ -299,7 +308,7 @@ float ShadowSample_DPCF(const bool DIRECTIONAL,
 
 float ShadowSample_PCSS(const bool DIRECTIONAL,
         const mediump sampler2DArray map, const uint layer, const uint index,
-        const highp vec4 shadowPosition, const highp float zLight) {
+        const highp vec4 tileRect, const highp vec4 shadowPosition, const highp float zLight) {
     highp vec2 size = vec2(textureSize(map, 0));
     highp vec2 texelSize = vec2(1.0) / size;
     highp vec3 position = shadowPosition.xyz * (1.0 / shadowPosition.w);
@@ -317,7 +326,7 @@ float ShadowSample_PCSS(const bool DIRECTIONAL,
     float z_occSum = 0.0;
 
     blockerSearchAndFilter(occludedCount, z_occSum,
-            map, position.xy, position.z, layer, texelSize * penumbra, R, dz_duv,
+            map, tileRect, position.xy, position.z, layer, texelSize * penumbra, R, dz_duv,
             PCSS_SHADOW_BLOCKER_SEARCH_TAP_COUNT);
 
     // early exit if there is no occluders at all, also avoids a divide-by-zero below.
@@ -327,7 +336,7 @@ float ShadowSample_PCSS(const bool DIRECTIONAL,
 
     float penumbraRatio = getPenumbraRatio(DIRECTIONAL, index, position.z, z_occSum / occludedCount);
 
-    float percentageOccluded = filterPCSS(map, size, position.xy, position.z, layer,
+    float percentageOccluded = filterPCSS(map, tileRect, size, position.xy, position.z, layer,
             texelSize * (penumbra * penumbraRatio),
             R, dz_duv, PCSS_SHADOW_FILTER_TAP_COUNT);
 
@@ -482,22 +491,25 @@ float shadow(const bool DIRECTIONAL,
         const uint layer, const uint index, const uint cascade) {
 
     highp vec4 shadowPosition;
+    highp vec4 tileRect;
 
     // This conditional is resolved at compile time
     if (DIRECTIONAL) {
 #if defined(HAS_DIRECTIONAL_LIGHTING)
         shadowPosition = getCascadeLightSpacePosition(cascade);
+        tileRect = frameUniforms.cascadeTileRects[cascade];
 #endif
     } else {
 #if defined(HAS_DYNAMIC_LIGHTING)
         highp float zLight = dot(shadowUniforms.shadows[index].lightFromWorldZ, vec4(getWorldPosition(), 1.0));
         shadowPosition = getSpotLightSpacePosition(index, zLight);
+        tileRect = shadowUniforms.shadows[index].tileRect;
 #endif
     }
 #if SHADOW_SAMPLING_METHOD == SHADOW_SAMPLING_PCF_HARD
-    return ShadowSample_PCF_Hard(shadowMap, layer, shadowPosition);
+    return ShadowSample_PCF_Hard(shadowMap, layer, tileRect, shadowPosition);
 #elif SHADOW_SAMPLING_METHOD == SHADOW_SAMPLING_PCF_LOW
-    return ShadowSample_PCF_Low(shadowMap, layer, shadowPosition);
+    return ShadowSample_PCF_Low(shadowMap, layer, tileRect, shadowPosition);
 #endif
 }
 
@@ -507,17 +519,20 @@ float shadow(const bool DIRECTIONAL,
         const uint layer, const uint index, const uint cascade) {
 
     highp vec4 shadowPosition;
+    highp vec4 tileRect;
     highp float zLight = 0.0;
 
     // This conditional is resolved at compile time
     if (DIRECTIONAL) {
 #if defined(HAS_DIRECTIONAL_LIGHTING)
         shadowPosition = getCascadeLightSpacePosition(cascade);
+        tileRect = frameUniforms.cascadeTileRects[cascade];
 #endif
     } else {
 #if defined(HAS_DYNAMIC_LIGHTING)
         zLight = dot(shadowUniforms.shadows[index].lightFromWorldZ, vec4(getWorldPosition(), 1.0));
         shadowPosition = getSpotLightSpacePosition(index, zLight);
+        tileRect = shadowUniforms.shadows[index].tileRect;
 #endif
     }
 
@@ -526,18 +541,18 @@ float shadow(const bool DIRECTIONAL,
     }
 
     if (frameUniforms.shadowSamplingType == SHADOW_SAMPLING_RUNTIME_DPCF) {
-        return ShadowSample_DPCF(DIRECTIONAL, shadowMap, layer, index, shadowPosition, zLight);
+        return ShadowSample_DPCF(DIRECTIONAL, shadowMap, layer, index, tileRect, shadowPosition, zLight);
     }
 
     if (frameUniforms.shadowSamplingType == SHADOW_SAMPLING_RUNTIME_PCSS) {
-        return ShadowSample_PCSS(DIRECTIONAL, shadowMap, layer, index, shadowPosition, zLight);
+        return ShadowSample_PCSS(DIRECTIONAL, shadowMap, layer, index, tileRect, shadowPosition, zLight);
     }
 
     if (frameUniforms.shadowSamplingType == SHADOW_SAMPLING_RUNTIME_PCF) {
         // This is here mostly for debugging at this point.
         // Note: In this codepath, the normal bias is not applied because we're in the VSM variant.
         // (see: get{Cascade|Spot}LightSpacePosition)
-        return ShadowSample_PCF(shadowMap, layer, shadowPosition);
+        return ShadowSample_PCF(shadowMap, layer, tileRect, shadowPosition);
     }
 
     // should not happen
@@ -97,11 +97,14 @@ bool MeshWriter::serialize(ostream& out, Mesh& mesh) {
         return false;
     }
 
-    // Compute the overall bounding box.
+    // Compute the overall bounding box, quantized positions are relative to their own bounds.
     Box aabb = mesh.parts.at(0).aabb;
     for (size_t i = 1; i < mesh.parts.size(); i++) {
         aabb.unionSelf(mesh.parts.at(i).aabb);
     }
+    if (mFlags & POSITION_SNORM16) {
+        aabb = mesh.positionBounds;
+    }
 
     // It's safe to optimize the mesh regardless of the compression setting.
     optimize(mesh);
@@ -44,6 +44,8 @@ struct Mesh {
     std::vector<Part> parts;
     std::vector<std::string> materials;
     uint32_t vertexCount = 0;
+    // bounds of the quantized positions, see POSITION_SNORM16
+    Box positionBounds;
     std::vector<uint32_t> indices;
     // interleaved:
     std::vector<Vertex> vertices;
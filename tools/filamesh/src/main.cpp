@@ -47,10 +47,13 @@ using Assimp::Importer;
 bool g_interleaved = false;
 bool g_snormUVs = false;
 bool g_compression = false;
+bool g_quantizePositions = false;
 
 Mesh g_mesh;
 float2 g_minUV = float2(std::numeric_limits<float>::max());
 float2 g_maxUV = float2(std::numeric_limits<float>::lowest());
+float3 g_minPosition = float3(std::numeric_limits<float>::max());
+float3 g_maxPosition = float3(std::numeric_limits<float>::lowest());
 
 template<bool SNORMUVS>
 static ushort2 convertUV(float2 uv) {
@@ -63,17 +66,25 @@ static ushort2 convertUV(float2 uv) {
     }
 }
 
-template<typename VECTOR, typename INDEX>
-static Box computeAABB(VECTOR const* positions, INDEX const* indices,
-        size_t count, size_t stride) noexcept {
-    filament::math::float3 bmin(std::numeric_limits<float>::max());
-    filament::math::float3 bmax(std::numeric_limits<float>::lowest());
+// Positions are quantized relative to the bounds of the whole mesh, which the runtime folds back
+// into the model matrix; w is 1.0 once normalized.
+static half4 convertPosition(float3 position, Box const& bounds) {
+    float3 p = position - bounds.center;
+    for (size_t i = 0; i < 3; i++) {
+        p[i] = bounds.halfExtent[i] > 0.0f ? p[i] / bounds.halfExtent[i] : 0.0f;
+    }
+    return bit_cast<half4>(packSnorm16(float4(p, 1.0f)));
+}
+
+static Box computeAABB(float3 const* positions, aiFace const* faces, size_t count) noexcept {
+    float3 bmin(std::numeric_limits<float>::max());
+    float3 bmax(std::numeric_limits<float>::lowest());
     for (size_t i = 0; i < count; ++i) {
-        VECTOR const* p = reinterpret_cast<VECTOR const *>(
-                (char const*) positions + indices[i] * stride);
-        const filament::math::float3 v(p->x, p->y, p->z);
-        bmin = min(bmin, v);
-        bmax = max(bmax, v);
+        for (size_t k = 0; k < faces[i].mNumIndices; ++k) {
+            const float3 v = positions[faces[i].mIndices[k]];
+            bmin = min(bmin, v);
+            bmax = max(bmax, v);
+        }
     }
     return Box().set(bmin, bmax);
 }
@@ -85,6 +96,13 @@ void preprocessNode(const aiScene* scene, const aiNode* node) {
             std::cerr << "Error: mesh " << i <<  " does not have normals" << std::endl;
             continue;
         }
+        if (mesh->mNumFaces > 0) {
+            const float3* vertices = reinterpret_cast<const float3*>(mesh->mVertices);
+            for (size_t j = 0; j < mesh->mNumVertices; j++) {
+                g_minPosition = min(vertices[j], g_minPosition);
+                g_maxPosition = max(vertices[j], g_maxPosition);
+            }
+        }
         if (!mesh->HasTextureCoords(0)) {
             std::cerr << "Warning: mesh " << i <<  " does not have texture coordinates"
                     << std::endl;
@@ -167,7 +185,9 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Part>& me
                     }
                     color = colors ? colors[j] : float4(1.0f);
                     Vertex vertex {
-                        .position = half4(vertices[j], 1.0_h),
+                        .position = g_quantizePositions ?
+                                convertPosition(vertices[j], g_mesh.positionBounds) :
+                                half4(vertices[j], 1.0_h),
                         .tangents = short4(filament::math::packSnorm16(q.xyzw)),
                         .color = ubyte4(clamp(color, 0.0f, 1.0f) * 255.0f),
                         .uv0 = uv0 ? convertUV<SNORMUVS>(uv0[j].xy) : ushort2(0),
@@ -197,11 +217,9 @@ void processNode(const aiScene* scene, const aiNode* node, std::vector<Part>& me
                     }
                 }
 
-                size_t stride = INTERLEAVED ? sizeof(Vertex) : sizeof(Vertex::position);
-                const decltype(Vertex::position)* positions =
-                        INTERLEAVED ? &g_mesh.vertices.data()->position : g_mesh.positions.data();
-                const Box aabb(computeAABB(positions,
-                        g_mesh.indices.data() + indexBufferOffset, indicesCount, stride));
+                // the bounds are computed from the source positions, they are exact even if the
+                // stored positions are quantized
+                const Box aabb(computeAABB(vertices, faces, numFaces));
 
                 meshes.emplace_back(Part {
                     .offset = indexBufferOffset,
@@ -241,6 +259,8 @@ static void printUsage(const char* name) {
                     "       interleaves mesh attributes\n\n"
                     "   --compress, -c\n"
                     "       enable compression\n\n"
+                    "   --quantize-positions, -q\n"
+                    "       store positions as 16-bit integers relative to the mesh bounds\n\n"
     );
 
     const std::string from("FILAMESH");
@@ -262,12 +282,13 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hilc";
+    static constexpr const char* OPTSTR = "hilcq";
     static const struct option OPTIONS[] = {
             { "help",        no_argument, 0, 'h' },
             { "license",     no_argument, 0, 'l' },
             { "interleaved", no_argument, 0, 'i' },
             { "compress",    no_argument, 0, 'c' },
+            { "quantize-positions", no_argument, 0, 'q' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -292,6 +313,9 @@ static int handleArguments(int argc, char* argv[]) {
             case 'c':
                 g_compression = true;
                 break;
+            case 'q':
+                g_quantizePositions = true;
+                break;
         }
     }
 
@@ -345,6 +369,11 @@ int main(int argc, char* argv[]) {
     preprocessNode(scene, node);
     g_snormUVs = g_minUV.x >= -1.0f && g_minUV.x <= 1.0f && g_maxUV.x >= -1.0f && g_maxUV.x <= 1.0f &&
                  g_minUV.y >= -1.0f && g_minUV.y <= 1.0f && g_maxUV.y >= -1.0f && g_maxUV.y <= 1.0f;
+    if (g_quantizePositions && g_minPosition.x <= g_maxPosition.x) {
+        g_mesh.positionBounds.set(g_minPosition, g_maxPosition);
+    } else {
+        g_quantizePositions = false;
+    }
 
     // Consume assimp data and produce filamesh data.
     if (g_interleaved) {
@@ -399,6 +428,9 @@ int main(int argc, char* argv[]) {
     if (g_compression) {
         flags |= filamesh::COMPRESSION;
     }
+    if (g_quantizePositions) {
+        flags |= filamesh::POSITION_SNORM16;
+    }
     MeshWriter(flags).serialize(out, g_mesh);
 
     out.flush();
@@ -0,0 +1,16 @@
+# Writes a header that defines MATC_BUILD_ID as a hash of the content of the given files.
+#
+#   cmake -DOUTPUT=<header> -DINPUTS=<file>|<file>|... -P BuildId.cmake
+#
+# Relative paths are resolved against the working directory.
+
+string(REPLACE "|" ";" INPUTS "${INPUTS}")
+
+set(HASHES "")
+foreach (INPUT ${INPUTS})
+    file(SHA1 ${INPUT} HASH)
+    string(APPEND HASHES ${HASH})
+endforeach()
+string(SHA1 BUILD_ID "${HASHES}")
+
+file(WRITE ${OUTPUT} "#define MATC_BUILD_ID \"${BUILD_ID}\"\n")
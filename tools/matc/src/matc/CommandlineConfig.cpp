@@ -22,6 +22,7 @@
 
 #include <utils/Path.h>
 
+#include <cstdlib>
 #include <istream>
 #include <sstream>
 #include <string>
@@ -65,6 +66,12 @@ static void usage(char* name) {
             "       Filter out specified comma-separated variants:\n"
             "           directionalLighting, dynamicLighting, shadowReceiver, skinning, vsm, fog\n"
             "       This variant filter is merged with the filter from the material, if any\n\n"
+            "   --jobs=<count>, -j <count>\n"
+            "       Number of threads used to compile shaders, defaults to the number of cores\n\n"
+            "   --cache=<dir>, -c <dir>\n"
+            "       Reuse the material compiled by a previous invocation if the material source,\n"
+            "       its includes and the compilation options did not change. Compiled materials\n"
+            "       are kept in the specified directory\n\n"
             "   --version, -v\n"
             "       Print the material version number\n\n"
             "Internal use and debugging only:\n"
@@ -153,7 +160,7 @@ static void parseDefine(std::string defineString,
 }
 
 bool CommandlineConfig::parse() {
-    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtw";
+    static constexpr const char* OPTSTR = "hlxo:f:dm:a:p:D:OSEr:vV:gtwj:c:";
     static const struct option OPTIONS[] = {
             { "help",                    no_argument, nullptr, 'h' },
             { "license",                 no_argument, nullptr, 'l' },
@@ -173,6 +180,8 @@ bool CommandlineConfig::parse() {
             { "print",                   no_argument, nullptr, 't' },
             { "version",                 no_argument, nullptr, 'v' },
             { "raw",                     no_argument, nullptr, 'w' },
+            { "jobs",              required_argument, nullptr, 'j' },
+            { "cache",             required_argument, nullptr, 'c' },
             { nullptr, 0, nullptr, 0 }  // termination of the option list
     };
 
@@ -271,6 +280,18 @@ bool CommandlineConfig::parse() {
             case 'w':
                 mRawShaderMode = true;
                 break;
+            case 'j': {
+                const int jobCount = std::atoi(arg.c_str());
+                if (jobCount <= 0) {
+                    std::cerr << "The number of jobs must be a positive integer." << std::endl;
+                    return false;
+                }
+                mJobCount = uint32_t(jobCount);
+                break;
+            }
+            case 'c':
+                mCacheDirectory = arg;
+                break;
         }
     }
 
@@ -23,6 +23,7 @@
 #include <filamat/MaterialBuilder.h>
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <ostream>
 
@@ -118,6 +119,16 @@ public:
         return mDefines;
     }
 
+    // Number of threads used to compile shaders, 0 means one per core.
+    uint32_t getJobCount() const noexcept {
+        return mJobCount;
+    }
+
+    // Directory of the incremental compilation cache, empty when disabled.
+    const std::string& getCacheDirectory() const noexcept {
+        return mCacheDirectory;
+    }
+
 protected:
     bool mDebug = false;
     bool mIsValid = true;
@@ -130,6 +141,8 @@ protected:
     TargetApi mTargetApi = (TargetApi) 0;
     std::unordered_map<std::string, std::string> mDefines;
     uint8_t mVariantFilter = 0;
+    uint32_t mJobCount = 0;
+    std::string mCacheDirectory;
 };
 
 }
@@ -21,6 +21,8 @@
 
 #include <utils/Path.h>
 
+#include <vector>
+
 namespace matc {
 
 // Functor callback handler used to resolve includes relative to a root include directory.
@@ -31,10 +33,17 @@ public:
         mIncludeDirectory = dir;
     }
 
+    // When set, the path of every resolved include is appended to the given list. The list must
+    // outlive this DirIncluder and all of its copies.
+    void setDependencyList(std::vector<utils::Path>* dependencies) noexcept {
+        mDependencies = dependencies;
+    }
+
     bool operator()(const utils::CString& includedBy, filamat::IncludeResult& result);
 
 private:
     utils::Path mIncludeDirectory;
+    std::vector<utils::Path>* mDependencies = nullptr;
 
 };
 
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "MaterialCache.h"
+
+#include "matc_build_id.h"
+
+#include <filament/MaterialEnums.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+
+namespace matc {
+
+// 64-bit FNV-1a, collisions are unlikely enough for a build cache.
+static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+static uint64_t hashBytes(const void* data, size_t size, uint64_t seed) noexcept {
+    uint64_t h = seed;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+static uint64_t hashString(const std::string& s, uint64_t seed) noexcept {
+    // include the terminating null so that consecutive strings can't alias
+    return hashBytes(s.c_str(), s.size() + 1, seed);
+}
+
+template<typename T>
+static uint64_t hashValue(T value, uint64_t seed) noexcept {
+    return hashBytes(&value, sizeof(value), seed);
+}
+
+static bool readFile(const utils::Path& path, std::string& contents) noexcept {
+    std::ifstream in(path.getPath(), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    contents.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+MaterialCache::MaterialCache(utils::Path directory) noexcept : mDirectory(std::move(directory)) {
+}
+
+uint64_t MaterialCache::computeKey(const char* source, size_t size,
+        const Config& config) noexcept {
+    uint64_t h = FNV_OFFSET_BASIS;
+    h = hashValue(filament::MATERIAL_VERSION, h);
+    h = hashString(MATC_BUILD_ID, h);
+    h = hashBytes(source, size, h);
+
+    // The path of the material is part of the key, because includes are resolved relative to it.
+    h = hashString(utils::Path(config.getInput()->getName()).getAbsolutePath().getPath(), h);
+
+    h = hashValue(config.getPlatform(), h);
+    h = hashValue(config.getTargetApi(), h);
+    h = hashValue(config.getOptimizationLevel(), h);
+    h = hashValue(config.isDebug(), h);
+    h = hashValue(config.getVariantFilter(), h);
+
+    // defines are stored in an unordered map, sort them to get a stable key.
+    std::vector<std::pair<std::string, std::string>> defines(
+            config.getDefines().begin(), config.getDefines().end());
+    std::sort(defines.begin(), defines.end());
+    for (const auto& define : defines) {
+        h = hashString(define.first, h);
+        h = hashString(define.second, h);
+    }
+    return h;
+}
+
+utils::Path MaterialCache::getEntryPath(uint64_t key, const char* extension) const noexcept {
+    std::stringstream name;
+    name << std::hex << key << extension;
+    return mDirectory.concat(name.str());
+}
+
+filamat::Package MaterialCache::find(uint64_t key) const noexcept {
+    // Each line of the dependency file is the hash of a dependency followed by its path.
+    std::ifstream deps(getEntryPath(key, ".deps").getPath());
+    if (!deps) {
+        return filamat::Package::invalidPackage();
+    }
+
+    uint64_t expected;
+    std::string path;
+    std::string contents;
+    while (deps >> std::hex >> expected && std::getline(deps >> std::ws, path)) {
+        if (!readFile(utils::Path(path), contents) ||
+                hashString(contents, FNV_OFFSET_BASIS) != expected) {
+            return filamat::Package::invalidPackage();
+        }
+    }
+
+    if (!readFile(getEntryPath(key, ".filamat"), contents) || contents.empty()) {
+        return filamat::Package::invalidPackage();
+    }
+    return filamat::Package(contents.data(), contents.size());
+}
+
+bool MaterialCache::store(uint64_t key, const filamat::Package& package,
+        const std::vector<utils::Path>& dependencies) const noexcept {
+    if (!mDirectory.exists() && !mDirectory.mkdirRecursive()) {
+        return false;
+    }
+
+    // The package is written first, so an interrupted store never leaves a valid entry behind.
+    utils::Path depsPath = getEntryPath(key, ".deps");
+    depsPath.unlinkFile();
+
+    std::ofstream blob(getEntryPath(key, ".filamat").getPath(), std::ios::binary);
+    blob.write(reinterpret_cast<const char*>(package.getData()), package.getSize());
+    blob.close();
+    if (blob.fail()) {
+        return false;
+    }
+
+    std::ofstream deps(depsPath.getPath());
+    std::string contents;
+    for (const auto& dependency : dependencies) {
+        if (!readFile(dependency, contents)) {
+            return false;
+        }
+        deps << std::hex << hashString(contents, FNV_OFFSET_BASIS) << " "
+             << dependency.getAbsolutePath().getPath() << "\n";
+    }
+    deps.close();
+    return !deps.fail();
+}
+
+} // namespace matc
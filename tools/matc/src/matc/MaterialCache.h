@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2022 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TNT_MATERIALCACHE_H
+#define TNT_MATERIALCACHE_H
+
+#include "Config.h"
+
+#include <filamat/Package.h>
+
+#include <utils/Path.h>
+
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace matc {
+
+// On-disk cache of compiled materials, used for incremental builds.
+//
+// An entry is keyed by a hash of the build of matc, of the material source and of all the options
+// that affect the generated package. Each entry also records the files included by the material
+// along with a hash of their content, a cached package is only reused if none of its includes have
+// changed.
+class MaterialCache {
+public:
+    explicit MaterialCache(utils::Path directory) noexcept;
+
+    // Computes the cache key of a material source compiled with the given configuration.
+    static uint64_t computeKey(const char* source, size_t size, const Config& config) noexcept;
+
+    // Returns the package cached for the given key, or an invalid package if there is no entry
+    // or if the entry is stale.
+    filamat::Package find(uint64_t key) const noexcept;
+
+    // Stores the package for the given key, along with the list of files it depends on.
+    bool store(uint64_t key, const filamat::Package& package,
+            const std::vector<utils::Path>& dependencies) const noexcept;
+
+private:
+    utils::Path getEntryPath(uint64_t key, const char* extension) const noexcept;
+
+    utils::Path mDirectory;
+};
+
+} // namespace matc
+
+#endif // TNT_MATERIALCACHE_H
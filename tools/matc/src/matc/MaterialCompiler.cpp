@@ -26,6 +26,7 @@
 #include <utils/JobSystem.h>
 
 #include "DirIncluder.h"
+#include "MaterialCache.h"
 #include "MaterialLexeme.h"
 #include "MaterialLexer.h"
 #include "JsonishLexer.h"
@@ -278,6 +279,18 @@ bool MaterialCompiler::run(const Config& config) {
         return success;
     }
 
+    // Skip the compilation entirely if an up-to-date package is found in the cache.
+    const bool useCache = !config.getCacheDirectory().empty() &&
+            config.getReflectionTarget() == Config::Metadata::NONE;
+    const MaterialCache cache(config.getCacheDirectory());
+    const uint64_t cacheKey = useCache ? MaterialCache::computeKey(buffer.get(), size, config) : 0;
+    if (useCache) {
+        Package package = cache.find(cacheKey);
+        if (package.isValid()) {
+            return writePackage(package, config);
+        }
+    }
+
     MaterialBuilder::init();
     MaterialBuilder builder;
     // Before attempting an expensive lex, let's find out if we were sent pure JSON.
@@ -303,6 +316,10 @@ bool MaterialCompiler::run(const Config& config) {
     DirIncluder includer;
     includer.setIncludeDirectory(materialFilePath.getParent());
 
+    // Keep track of all the included files, they're part of the cache entry.
+    std::vector<utils::Path> dependencies;
+    includer.setDependencyList(&dependencies);
+
     builder
         .includeCallback(includer)
         .fileName(materialFilePath.getName().c_str())
@@ -317,19 +334,30 @@ bool MaterialCompiler::run(const Config& config) {
         builder.shaderDefine(define.first.c_str(), define.second.c_str());
     }
 
-    JobSystem js;
-    js.adopt();
-
-    // Write builder.build() to output.
-    Package package = builder.build(js);
+    // One of the threads compiling shaders is the calling thread, a single job compiles serially
+    // and 0 lets the JobSystem pick the number of threads.
+    const uint32_t jobCount = config.getJobCount();
+    Package package;
+    if (jobCount == 1) {
+        package = builder.build();
+    } else {
+        JobSystem js(jobCount > 1 ? jobCount - 1 : 0);
+        js.adopt();
+        package = builder.build(js);
+        js.emancipate();
+    }
 
-    js.emancipate();
     MaterialBuilder::shutdown();
 
     if (!package.isValid()) {
         std::cerr << "Could not compile material " << input->getName() << std::endl;
         return false;
     }
+
+    if (useCache && !cache.store(cacheKey, package, dependencies)) {
+        std::cerr << "Warning: could not update the material cache in "
+                << config.getCacheDirectory() << std::endl;
+    }
     return writePackage(package, config);
 }
 
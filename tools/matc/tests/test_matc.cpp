@@ -18,6 +18,9 @@
 
 #include "MockConfig.h"
 
+#include <fstream>
+
+#include <matc/MaterialCache.h>
 #include <matc/MaterialCompiler.h>
 #include <matc/MaterialLexer.h>
 #include <matc/JsonishLexer.h>
@@ -301,6 +304,38 @@ TEST_F(MaterialLexer, JsonMaterialCompiler) {
   EXPECT_EQ(result, true);
 }
 
+TEST(MaterialCache, StoreAndFind) {
+    const utils::Path dir = utils::Path::getTemporaryDirectory() + "matc_test_cache";
+    const utils::Path include = dir + "include.h";
+    dir.mkdirRecursive();
+    std::ofstream(include.getPath()) << "// version 1";
+
+    // the cache entries are removed even if an assertion fails
+    struct RemoveOnExit {
+        const utils::Path& dir;
+        ~RemoveOnExit() {
+            for (utils::Path file : dir.listContents()) {
+                file.unlinkFile();
+            }
+        }
+    } removeOnExit{ dir };
+
+    const uint8_t data[] = { 1, 2, 3, 4, 5 };
+    filamat::Package package(data, sizeof(data));
+
+    matc::MaterialCache cache(dir);
+    EXPECT_TRUE(cache.store(42, package, { include }));
+
+    filamat::Package cached = cache.find(42);
+    ASSERT_TRUE(cached.isValid());
+    ASSERT_EQ(cached.getSize(), sizeof(data));
+    EXPECT_EQ(memcmp(cached.getData(), data, sizeof(data)), 0);
+
+    // changing an include invalidates the entry
+    std::ofstream(include.getPath()) << "// version 2";
+    EXPECT_FALSE(cache.find(42).isValid());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -27,13 +27,18 @@
 #include <imageio/ImageDecoder.h>
 #include <imageio/ImageEncoder.h>
 
+#include <utils/JobSystem.h>
 #include <utils/Path.h>
 
 #include <getopt/getopt.h>
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <string.h>
 
 using namespace image;
 using namespace std;
@@ -51,6 +56,11 @@ static bool g_ktxContainer = false;
 static bool g_linearized = false;
 static bool g_quietMode = false;
 static uint32_t g_mipLevelCount = 0;
+static bool g_streaming = false;
+static PixelStorage g_storage = PixelStorage::FLOAT32;
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+static CompressionConfig g_compressionConfig {};
+#endif
 
 static const char* USAGE = R"TXT(
 MIPGEN generates mipmaps for an image down to the 1x1 level.
@@ -80,7 +90,7 @@ Options:
        create a single-channel image and do not perform gamma correction
    --format=[exr|hdr|rgbm|psd|png|dds|ktx], -f [exr|hdr|rgbm|psd|png|dds|ktx]
        specify output file format, inferred from output pattern if omitted
-   --kernel=[box|nearest|hermite|gaussian|normals|mitchell|lanczos|min], -k [filter]
+   --kernel=[box|nearest|triangle|hermite|gaussian|normals|mitchell|lanczos|min], -k [filter]
        specify filter kernel type (defaults to lanczos)
        the "normals" filter may automatically change the compression scheme
    --add-alpha
@@ -90,6 +100,12 @@ Options:
    --mip-levels=N, -m N
        specifies the number of mip levels to generate
        if 0 (default), all levels are generated
+   --stream, -S
+       read the source and write the miplevels a strip of rows at a time, which bounds
+       the memory usage for very large images; KTX levels are compressed a strip at a
+       time and only their encoded data is kept; not supported with --page
+   --half
+       with --stream, keep the intermediate rows as half floats to halve their memory usage
    --compression=COMPRESSION, -c COMPRESSION
        format specific compression:
 )TXT"
@@ -116,6 +132,7 @@ Examples:
     MIPGEN -g --kernel=hermite grassland.png mip_%03d.png
     MIPGEN -f ktx --compression=astc_fast_ldr_4x4 grassland.png mips.ktx
     MIPGEN -f ktx --compression=etc_rgb_rgba_40 grassland.png mips.ktx
+    MIPGEN --stream --half terrain_32k.png terrain_mip_%02d.png
 )TXT";
 
 static const char* HTML_PREFIX = R"HTML(<!DOCTYPE html>
@@ -159,7 +176,7 @@ static void license() {
 }
 
 static int handleArguments(int argc, char* argv[]) {
-    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:";
+    static constexpr const char* OPTSTR = "hLlgpf:c:k:saqm:SH";
     static const struct option OPTIONS[] = {
             { "help",                 no_argument, 0, 'h' },
             { "license",              no_argument, 0, 'L' },
@@ -173,6 +190,8 @@ static int handleArguments(int argc, char* argv[]) {
             { "add-alpha",            no_argument, 0, 'a' },
             { "quiet",                no_argument, 0, 'q' },
             { "mip-levels",     required_argument, 0, 'm' },
+            { "stream",               no_argument, 0, 'S' },
+            { "half",                 no_argument, 0, 'H' },
             { 0, 0, 0, 0 }  // termination of the option list
     };
 
@@ -254,12 +273,365 @@ static int handleArguments(int argc, char* argv[]) {
                     // keep default value
                 }
                 break;
+            case 'S':
+                g_streaming = true;
+                break;
+            case 'H':
+                g_storage = PixelStorage::FLOAT16;
+                break;
         }
     }
 
     return optind;
 }
 
+// Applies the channel options to the source image.
+static LinearImage prepareSource(LinearImage sourceImage) {
+    if (g_stripAlpha && sourceImage.getChannels() == 4) {
+        auto r = extractChannel(sourceImage, 0);
+        auto g = extractChannel(sourceImage, 1);
+        auto b = extractChannel(sourceImage, 2);
+        sourceImage = combineChannels({r, g, b});
+    }
+    if (g_addAlpha && sourceImage.getChannels() == 3) {
+        auto r = extractChannel(sourceImage, 0);
+        auto g = extractChannel(sourceImage, 1);
+        auto b = extractChannel(sourceImage, 2);
+        auto a = LinearImage(sourceImage.getWidth(), sourceImage.getHeight(), 1);
+        clearToValue(a, 1.0f);
+        sourceImage = combineChannels({r, g, b, a});
+    }
+    if (g_grayscale) {
+        sourceImage = extractChannel(sourceImage, 0);
+    }
+
+    if (g_filter == Filter::GAUSSIAN_NORMALS) {
+        sourceImage = colorsToVectors(sourceImage);
+    }
+    return sourceImage;
+}
+
+// Returns the number of channels of the images returned by prepareSource().
+static uint32_t getPreparedChannels(uint32_t channels) {
+    if (g_stripAlpha && channels == 4) {
+        channels = 3;
+    }
+    if (g_addAlpha && channels == 3) {
+        channels = 4;
+    }
+    if (g_grayscale) {
+        channels = 1;
+    }
+    return channels;
+}
+
+// Fills the header of a KTX file holding the given image and validates the compression option.
+static bool initKtxInfo(KtxInfo& info, uint32_t width, uint32_t height, uint32_t channels) {
+    info = {
+        .endianness = KtxBundle::ENDIAN_DEFAULT,
+        .glType = KtxBundle::UNSIGNED_BYTE,
+        .glTypeSize = 1,
+        .pixelWidth = width,
+        .pixelHeight = height,
+        .pixelDepth = 0,
+    };
+    if (channels == 1) {
+        info.glFormat = info.glBaseInternalFormat = KtxBundle::RED;
+        info.glInternalFormat = KtxBundle::R8;
+    } else if (channels == 3) {
+        info.glFormat = info.glBaseInternalFormat = KtxBundle::RGB;
+        info.glInternalFormat = KtxBundle::RGB8;
+    } else if (channels == 4) {
+        info.glFormat = info.glBaseInternalFormat = KtxBundle::RGBA;
+        info.glInternalFormat = KtxBundle::RGBA8;
+    }
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+    if (!g_compression.empty()) {
+        bool valid = parseOptionString(g_compression, &g_compressionConfig);
+        if (!valid) {
+            cerr << "Unrecognized compression: " << g_compression << endl;
+            return false;
+        }
+        // The KTX spec says the following for compressed textures: glTypeSize should 1,
+        // glFormat should be 0, and glBaseInternalFormat should be RED, RG, RGB, or RGBA.
+        // The glInternalFormat field is the only field that specifies the actual format.
+        info.glFormat = 0;
+    }
+#else
+    if (!g_compression.empty()) {
+        cerr << "Compression not supported in this build." << endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+// Converts an uncompressed KTX level to 8 bits per component.
+static std::unique_ptr<uint8_t[]> toKtxPixels(const LinearImage& image) {
+    const uint32_t componentCount = image.getChannels();
+    if (g_grayscale && g_linearized) {
+        return fromLinearToGrayscale<uint8_t>(image);
+    } else if (g_grayscale) {
+        return fromLinearTosRGB<uint8_t, 1>(image);
+    } else if (g_linearized) {
+        if (componentCount == 3) {
+            return fromLinearToRGB<uint8_t, 3>(image);
+        }
+        return fromLinearToRGB<uint8_t, 4>(image);
+    }
+    if (componentCount == 3) {
+        return fromLinearTosRGB<uint8_t, 3>(image);
+    }
+    return fromLinearTosRGB<uint8_t, 4>(image);
+}
+
+static void writeKtx(KtxBundle& container, const std::string& path) {
+    vector<uint8_t> fileContents(container.getSerializedLength());
+    container.serialize(fileContents.data(), fileContents.size());
+    Path(path).getParent().mkdirRecursive();
+    ofstream outputStream(path, ios::out | ios::binary);
+    outputStream.write((const char*) fileContents.data(), fileContents.size());
+    outputStream.close();
+}
+
+// Applies prepareSource() to each strip of the decoded image.
+class PreparedReader : public RowReader {
+public:
+    explicit PreparedReader(std::unique_ptr<RowReader> source) : mSource(std::move(source)) {
+        mWidth = mSource->getWidth();
+        mHeight = mSource->getHeight();
+        mChannels = getPreparedChannels(mSource->getChannels());
+    }
+
+    // The rows are also written to the given writer as they're read, e.g. for miplevel 0.
+    void setCopy(RowWriter* copy) { mCopy = copy; }
+
+private:
+    bool readRows(float* rows, uint32_t rowCount) override {
+        LinearImage strip(mWidth, rowCount, mSource->getChannels());
+        if (!mSource->read(strip.getPixelRef(), rowCount)) {
+            return false;
+        }
+        strip = prepareSource(strip);
+        memcpy(rows, strip.getPixelRef(), sizeof(float) * mWidth * mChannels * rowCount);
+        return !mCopy || mCopy->write(rows, rowCount);
+    }
+
+    std::unique_ptr<RowReader> mSource;
+    RowWriter* mCopy = nullptr;
+};
+
+// Collects the pixels of an uncompressed KTX level.
+class KtxLevelWriter : public RowWriter {
+public:
+    KtxLevelWriter(uint32_t width, uint32_t height, uint32_t channels)
+            : RowWriter(width, height, channels) {
+        mData.reserve(size_t(width) * height * channels);
+    }
+
+    std::vector<uint8_t> const& getData() const { return mData; }
+
+private:
+    bool writeRows(float const* rows, uint32_t rowCount) override {
+        LinearImage strip(mWidth, rowCount, mChannels);
+        memcpy(strip.getPixelRef(), rows, sizeof(float) * mWidth * mChannels * rowCount);
+        std::unique_ptr<uint8_t[]> data = toKtxPixels(strip);
+        mData.insert(mData.end(), data.get(), data.get() + mWidth * mChannels * rowCount);
+        return true;
+    }
+
+    std::vector<uint8_t> mData;
+};
+
+// Converts the normals of each strip back to colors before encoding it.
+class NormalsWriter : public RowWriter {
+public:
+    explicit NormalsWriter(std::unique_ptr<RowWriter> target)
+            : RowWriter(target->getWidth(), target->getHeight(), target->getChannels()),
+              mTarget(std::move(target)) {
+    }
+
+private:
+    bool writeRows(float const* rows, uint32_t rowCount) override {
+        LinearImage strip(mWidth, rowCount, mChannels);
+        memcpy(strip.getPixelRef(), rows, sizeof(float) * mWidth * mChannels * rowCount);
+        strip = vectorsToColors(strip);
+        return mTarget->write(strip.getPixelRef(), rowCount);
+    }
+
+    bool onFinish() override {
+        return mTarget->finish();
+    }
+
+    std::unique_ptr<RowWriter> mTarget;
+};
+
+// Generates the miplevels of the source into the writers, in a single pass over the source.
+static bool streamLevels(PreparedReader& source, RowWriter* const* result, uint32_t count) {
+    utils::JobSystem js;
+    js.adopt();
+    StreamingOptions options;
+    options.storage = g_storage;
+    options.jobSystem = &js;
+    bool success = generateMipmaps(source, g_filter, result, count, options);
+    js.emancipate();
+    return success;
+}
+
+// Streams all the levels into a KTX bundle. Only their encoded data is kept in memory, levels are
+// converted or block-compressed a strip at a time.
+static int streamKtx(PreparedReader& source, uint32_t count, const std::string& outputPath) {
+    KtxBundle container(1 + count, 1, false);
+    if (!initKtxInfo(container.info(), source.getWidth(), source.getHeight(),
+            source.getChannels())) {
+        return 1;
+    }
+
+    bool compressed = false;
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+    compressed = g_compressionConfig.type != CompressionConfig::INVALID;
+#endif
+
+    // levels[0] is the source, which is written as it is read.
+    vector<std::unique_ptr<RowWriter>> writers(1 + count);
+    vector<RowWriter*> levels(1 + count);
+    vector<RowWriter*> result(1 + count);
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n <= count; n++) {
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+        if (compressed) {
+            writers[n] = std::make_unique<StreamingCompressor>(g_compressionConfig,
+                    width, height, source.getChannels());
+        }
+#endif
+        if (!compressed) {
+            writers[n] = std::make_unique<KtxLevelWriter>(width, height, source.getChannels());
+        }
+        levels[n] = writers[n].get();
+        if (g_filter == Filter::GAUSSIAN_NORMALS) {
+            writers[n] = std::make_unique<NormalsWriter>(std::move(writers[n]));
+        }
+        result[n] = writers[n].get();
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+    }
+    source.setCopy(result[0]);
+
+    if (!g_quietMode) {
+        puts("Generating miplevels...");
+    }
+
+    // The source has been entirely read once the miplevels are done.
+    if (!streamLevels(source, result.data() + 1, count) || !result[0]->finish()) {
+        cerr << "An error occurred while generating the miplevels." << endl;
+        return 1;
+    }
+
+    if (!g_quietMode) {
+        puts("Writing KTX file to disk...");
+    }
+
+    for (uint32_t n = 0; n <= count; n++) {
+#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
+        if (compressed) {
+            CompressedTexture tex = static_cast<StreamingCompressor*>(levels[n])->
+                    getCompressedTexture();
+            container.setBlob({n}, tex.data.get(), tex.size);
+            container.info().glInternalFormat = (uint32_t) tex.format;
+            continue;
+        }
+#endif
+        std::vector<uint8_t> const& data = static_cast<KtxLevelWriter*>(levels[n])->getData();
+        container.setBlob({n, 0, 0}, data.data(), uint32_t(data.size()));
+    }
+    writeKtx(container, outputPath);
+
+    if (!g_quietMode) {
+        puts("Done.");
+    }
+    return 0;
+}
+
+static int streamMipmaps(const Path& inputPath, const std::string& outputPattern) {
+    if (g_createGallery) {
+        cerr << "Streaming is not supported with --page." << endl;
+        return 1;
+    }
+
+    ifstream inputStream(inputPath.getPath(), ios::binary);
+    std::unique_ptr<RowReader> decoder = ImageDecoder::createReader(inputStream,
+            inputPath.getPath(),
+            g_linearized ? ImageDecoder::ColorSpace::LINEAR : ImageDecoder::ColorSpace::SRGB);
+    if (!decoder) {
+        cerr << "Unable to open image: " << inputPath.getPath() << endl;
+        return 1;
+    }
+    PreparedReader source(std::move(decoder));
+
+    uint32_t count = getMipmapCount(source.getWidth(), source.getHeight());
+    count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
+
+    if (g_ktxContainer) {
+        return streamKtx(source, count, outputPattern);
+    }
+
+    // All the miplevels are written at the same time, so all the files are opened upfront.
+    char path[256];
+    vector<std::unique_ptr<ofstream>> outputStreams(count);
+    vector<std::unique_ptr<RowWriter>> writers(count);
+    vector<RowWriter*> result(count);
+    uint32_t width = source.getWidth();
+    uint32_t height = source.getHeight();
+    for (uint32_t n = 0; n < count; n++) {
+        width = std::max(width >> 1u, 1u);
+        height = std::max(height >> 1u, 1u);
+        int r = snprintf(path, sizeof(path), outputPattern.c_str(), n + 1);
+        if (r < 0 || r >= sizeof(path)) {
+            cerr << "Output pattern is too long." << endl;
+            return 1;
+        }
+        Path(path).getParent().mkdirRecursive();
+        outputStreams[n] = std::make_unique<ofstream>(path, ios::binary | ios::trunc);
+        if (!*outputStreams[n]) {
+            cerr << "The output file cannot be opened: " << path << endl;
+            return 1;
+        }
+        writers[n] = ImageEncoder::createWriter(*outputStreams[n], g_format,
+                width, height, source.getChannels(), g_compression, path);
+        if (!writers[n]) {
+            cerr << "An error occurred while encoding the image." << endl;
+            return 1;
+        }
+        if (g_filter == Filter::GAUSSIAN_NORMALS) {
+            writers[n] = std::make_unique<NormalsWriter>(std::move(writers[n]));
+        }
+        result[n] = writers[n].get();
+    }
+
+    if (!g_quietMode) {
+        puts("Generating miplevels...");
+    }
+
+    if (!streamLevels(source, result.data(), count)) {
+        cerr << "An error occurred while generating the miplevels." << endl;
+        return 1;
+    }
+
+    for (auto& outputStream : outputStreams) {
+        outputStream->close();
+        if (!*outputStream) {
+            cerr << "An error occurred while writing the output files." << endl;
+            return 1;
+        }
+    }
+
+    if (!g_quietMode) {
+        puts("Done.");
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     int optionIndex = handleArguments(argc, argv);
     int numArgs = argc - optionIndex;
@@ -280,6 +652,10 @@ int main(int argc, char* argv[]) {
         puts("Reading image...");
     }
 
+    if (g_streaming) {
+        return streamMipmaps(inputPath, outputPattern);
+    }
+
     ifstream inputStream(inputPath.getPath(), ios::binary);
     LinearImage sourceImage = ImageDecoder::decode(inputStream, inputPath.getPath(),
             g_linearized ? ImageDecoder::ColorSpace::LINEAR : ImageDecoder::ColorSpace::SRGB);
@@ -287,27 +663,7 @@ int main(int argc, char* argv[]) {
         cerr << "Unable to open image: " << inputPath.getPath() << endl;
         return 1;
     }
-    if (g_stripAlpha && sourceImage.getChannels() == 4) {
-        auto r = extractChannel(sourceImage, 0);
-        auto g = extractChannel(sourceImage, 1);
-        auto b = extractChannel(sourceImage, 2);
-        sourceImage = combineChannels({r, g, b});
-    }
-    if (g_addAlpha && sourceImage.getChannels() == 3) {
-        auto r = extractChannel(sourceImage, 0);
-        auto g = extractChannel(sourceImage, 1);
-        auto b = extractChannel(sourceImage, 2);
-        auto a = LinearImage(sourceImage.getWidth(), sourceImage.getHeight(), 1);
-        clearToValue(a, 1.0f);
-        sourceImage = combineChannels({r, g, b, a});
-    }
-    if (g_grayscale) {
-        sourceImage = extractChannel(sourceImage, 0);
-    }
-
-    if (g_filter == Filter::GAUSSIAN_NORMALS) {
-        sourceImage = colorsToVectors(sourceImage);
-    }
+    sourceImage = prepareSource(sourceImage);
 
     if (!g_quietMode) {
         puts("Generating miplevels...");
@@ -316,7 +672,12 @@ int main(int argc, char* argv[]) {
     uint32_t count = getMipmapCount(sourceImage);
     count = g_mipLevelCount == 0 ? count : min(g_mipLevelCount - 1, count);
     vector<LinearImage> miplevels(count);
-    generateMipmaps(sourceImage, g_filter, miplevels.data(), count);
+    {
+        utils::JobSystem js;
+        js.adopt();
+        generateMipmaps(js, sourceImage, g_filter, miplevels.data(), count);
+        js.emancipate();
+    }
 
     if (g_ktxContainer) {
         if (!g_quietMode) {
@@ -327,53 +688,17 @@ int main(int argc, char* argv[]) {
         // which might make sense when generating individual files, but for a KTX
         // bundle, we want to include level 0, so add 1 to the KTX level count.
         KtxBundle container(1 + miplevels.size(), 1, false);
-        auto& info = container.info();
-        info = {
-            .endianness = KtxBundle::ENDIAN_DEFAULT,
-            .glType = KtxBundle::UNSIGNED_BYTE,
-            .glTypeSize = 1,
-            .pixelWidth = sourceImage.getWidth(),
-            .pixelHeight = sourceImage.getHeight(),
-            .pixelDepth = 0,
-        };
-        size_t componentCount = sourceImage.getChannels();
-        if (componentCount == 1) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RED;
-            info.glInternalFormat = KtxBundle::R8;
-        } else if (componentCount == 3) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RGB;
-            info.glInternalFormat = KtxBundle::RGB8;
-        } else if (componentCount == 4) {
-            info.glFormat = info.glBaseInternalFormat = KtxBundle::RGBA;
-            info.glInternalFormat = KtxBundle::RGBA8;
-        }
-#ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
-        CompressionConfig config {};
-        if (!g_compression.empty()) {
-            bool valid = parseOptionString(g_compression, &config);
-            if (!valid) {
-                cerr << "Unrecognized compression: " << g_compression << endl;
-                return 1;
-            }
-            // The KTX spec says the following for compressed textures: glTypeSize should 1,
-            // glFormat should be 0, and glBaseInternalFormat should be RED, RG, RGB, or RGBA.
-            // The glInternalFormat field is the only field that specifies the actual format.
-            info.glFormat = 0;
-        }
-#else
-        if (!g_compression.empty()) {
-            cerr << "Compression not supported in this build." << endl;
+        if (!initKtxInfo(container.info(), sourceImage.getWidth(), sourceImage.getHeight(),
+                sourceImage.getChannels())) {
             return 1;
         }
-#endif
         uint32_t mip = 0;
         auto addLevel = [&](LinearImage image) {
             if (g_filter == Filter::GAUSSIAN_NORMALS) {
                 image = vectorsToColors(image);
             }
-            std::unique_ptr<uint8_t[]> data;
 #ifdef IMAGEIO_SUPPORTS_BLOCK_COMPRESSION
-            if (config.type != CompressionConfig::INVALID) {
+            if (g_compressionConfig.type != CompressionConfig::INVALID) {
                 // Some encoders call exit(1) upon failure, so it's very useful to print some
                 // source image information here for when this is invoked from a build script.
                 // Note that some encoders also have limitations in terms of image size.
@@ -381,42 +706,21 @@ int main(int argc, char* argv[]) {
                     printf("Starting compression for %s (%dx%d)\n", inputPath.getName().c_str(),
                             image.getWidth(), image.getHeight());
                 }
-                CompressedTexture tex = compressTexture(config, image);
+                CompressedTexture tex = compressTexture(g_compressionConfig, image);
                 container.setBlob({mip++}, tex.data.get(), tex.size);
-                info.glInternalFormat = (uint32_t) tex.format;
+                container.info().glInternalFormat = (uint32_t) tex.format;
                 return;
             }
 #endif
-            if (g_grayscale && g_linearized) {
-                data = fromLinearToGrayscale<uint8_t>(image);
-            } else if (g_grayscale) {
-                data = fromLinearTosRGB<uint8_t, 1>(image);
-            } else if (g_linearized) {
-                if (componentCount == 3) {
-                    data = fromLinearToRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearToRGB<uint8_t, 4>(image);
-                }
-            } else {
-                if (componentCount == 3) {
-                    data = fromLinearTosRGB<uint8_t, 3>(image);
-                } else {
-                    data = fromLinearTosRGB<uint8_t, 4>(image);
-                }
-            }
+            std::unique_ptr<uint8_t[]> data = toKtxPixels(image);
             container.setBlob({mip++, 0, 0}, data.get(), image.getWidth() * image.getHeight() *
-                    container.info().glTypeSize * componentCount);
+                    container.info().glTypeSize * image.getChannels());
         };
         addLevel(sourceImage);
         for (auto image : miplevels) {
             addLevel(image);
         }
-        vector<uint8_t> fileContents(container.getSerializedLength());
-        container.serialize(fileContents.data(), fileContents.size());
-        Path(outputPattern).getParent().mkdirRecursive();
-        ofstream outputStream(outputPattern, ios::out | ios::binary);
-        outputStream.write((const char*) fileContents.data(), fileContents.size());
-        outputStream.close();
+        writeKtx(container, outputPattern);
         if (!g_quietMode) {
             puts("Done.");
         }